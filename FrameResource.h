@@ -20,8 +20,9 @@ struct FrameResource
 {
 public:
 	// Constructor to create command allocator and initialize memory
-	// for frame constant buffers
-	FrameResource(ID3D12Device* pDevice, UINT passCount, UINT objCount, UINT materialCount)
+	// for frame constant buffers and terrain staging
+	FrameResource(ID3D12Device* pDevice, UINT passCount, UINT objCount, UINT materialCount,
+		UINT terrainStagingVertices, UINT terrainMapStagingBytes, UINT terrainStreamStagingBytes)
 	{
 		pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
 			IID_PPV_ARGS(CommandListAllocator.GetAddressOf()));
@@ -29,6 +30,18 @@ public:
 		PassCB = std::make_unique<UploadBuffer<PassConstants>>(pDevice, passCount, true);
 		ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(pDevice, objCount, true);
 		MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(pDevice, materialCount, true);
+		TerrainStaging = std::make_unique<UploadBuffer<PackedVertex>>(pDevice, terrainStagingVertices, false);
+
+		// Terrain maps are only baked, and streamed chunks only created,
+		// in their own modes
+		if (terrainMapStagingBytes > 0)
+		{
+			TerrainMapStaging = std::make_unique<UploadBuffer<uint8_t>>(pDevice, terrainMapStagingBytes, false);
+		}
+		if (terrainStreamStagingBytes > 0)
+		{
+			TerrainStreamStaging = std::make_unique<UploadBuffer<uint8_t>>(pDevice, terrainStreamStagingBytes, false);
+		}
 	}
 
 	~FrameResource() { }
@@ -45,6 +58,15 @@ public:
 	std::unique_ptr<UploadBuffer<ObjectConstants>>		ObjectCB = nullptr;
 	std::unique_ptr<UploadBuffer<MaterialConstants>>	MaterialCB = nullptr;
 
+	// Regenerated terrain vertices copied into the vertex buffer this frame
+	std::unique_ptr<UploadBuffer<PackedVertex>>			TerrainStaging = nullptr;
+
+	// Rows of terrain maps updated this frame, rows 256-byte aligned
+	std::unique_ptr<UploadBuffer<uint8_t>>				TerrainMapStaging = nullptr;
+
+	// Streamed chunk meshes copied into their slots this frame
+	std::unique_ptr<UploadBuffer<uint8_t>>				TerrainStreamStaging = nullptr;
+
 	// Fence value to mark commands up to this fence point. This lets us
 	// check if the resource is still in use by the GPU.
 	UINT64 Fence = 0;
@@ -18,6 +18,24 @@
 cbuffer cbPerObject : register(b1)
 {
     float4x4 gWorld;
+    float4 gPosScale;       // Dequantisation of packed positions
+    float4 gPosOffset;
+    float4 gTerrainMapTransform;    // World (z, x) to terrain map texture coordinates
+    float gOcclusionStrength;
+    float gShadowStrength;
+    float2 gTerrainHeightScale;     // Sample to world height, scale and offset
+    float4 gTerrainGrid;            // X of row 0, Z of column 0, Dx, Dz
+};
+
+// Quadtree node drawn with the shared patch, see TerrainLodDraw
+cbuffer cbTerrainPatch : register(b3)
+{
+    uint gPatchFirstRow;
+    uint gPatchFirstCol;
+    uint gPatchSize;                // Grid quads covered by the patch
+    uint gPatchQuads;               // Quads along the side of the patch mesh
+    float gMorphStart;
+    float gMorphEnd;
 };
 
 cbuffer cbMaterial : register(b2)
@@ -59,13 +77,24 @@ cbuffer cbPass : register(b0)
 };
 
 SamplerState gSamLinearWrap : register(s0);
+SamplerState gSamLinearClamp : register(s1);
 
 Texture2D gDiffuseMap : register(t0);
+
+// Maps baked from the heightmap, one texel per sample
+Texture2D gOcclusionMap : register(t0, space1);
+Texture2D gShadowMap : register(t1, space1);
+Texture2D gHeightMap : register(t2, space1);
  
 struct VertexIn
 {
+#ifdef PACKED_VERTEX
+    float3 PosL : POSITION;     // Unorm within the mesh bounds
+    float2 NormalL : NORMAL;    // Octahedral encoding
+#else
     float3 PosL : POSITION;
     float3 NormalL : NORMAL;
+#endif
 	float2 TexC : TEXCOORD;
 };
 
@@ -77,16 +106,111 @@ struct VertexOut
 	float2 TexC : TEXCOORD;
 };
 
+#ifdef PACKED_VERTEX
+// Matches DecodeOctahedral in vertex_packing.cpp
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += (n.xy >= 0.0f) ? -t : t;
+    return normalize(n);
+}
+#endif
+
+#ifdef TERRAIN_LOD
+// World height of heightmap sample (row, col), clamped to the map
+float LoadHeight(int row, int col)
+{
+    uint width, depth;
+    gHeightMap.GetDimensions(width, depth);
+
+    int2 texel = clamp(int2(col, row), 0, int2(width, depth) - 1);
+    float value = round(gHeightMap.Load(int3(texel, 0)).r * 255.0f);
+    return value * gTerrainHeightScale.x + gTerrainHeightScale.y;
+}
+
+// Grid vertex (row, col) lies at heightmap sample (row + 1, col + 1)
+float GridHeight(float2 grid)
+{
+    float2 base = floor(grid);
+    float2 t = grid - base;
+    int row = (int)base.x + 1;
+    int col = (int)base.y + 1;
+
+    return lerp(
+        lerp(LoadHeight(row, col), LoadHeight(row, col + 1), t.y),
+        lerp(LoadHeight(row + 1, col), LoadHeight(row + 1, col + 1), t.y),
+        t.x);
+}
+
+float3 GridToWorld(float2 grid)
+{
+    return float3(gTerrainGrid.x + (grid.x + 1.0f) * gTerrainGrid.z, GridHeight(grid),
+        gTerrainGrid.y - (grid.y + 1.0f) * gTerrainGrid.w);
+}
+
+// Normal of the nearest grid vertex, as ComputeTerrainRow computes it
+float3 GridNormal(float2 grid)
+{
+    int row = (int)round(grid.x) + 1;
+    int col = (int)round(grid.y) + 1;
+
+    float dhRow = LoadHeight(row + 1, col) - LoadHeight(row - 1, col);
+    float dhCol = LoadHeight(row, col + 1) - LoadHeight(row, col - 1);
+
+    float dx = gTerrainGrid.z;
+    float dz = gTerrainGrid.w;
+    return normalize(float3(-2.0f * dz * dhRow, 4.0f * dx * dz, -2.0f * dx * dhCol));
+}
+
+// CDLOD: the patch is placed over its node, and vertices of odd rows and
+// columns slide onto the even ones, which form the parent LOD, between
+// gMorphStart and gMorphEnd
+VertexOut VS(VertexIn vin)
+{
+    VertexOut vout = (VertexOut) 0.0f;
+
+    uint width, depth;
+    gHeightMap.GetDimensions(width, depth);
+    float2 lastVertex = float2(depth, width) - 3.0f;
+
+    // Patch position in [0, 1]^2, x along grid rows and z along columns
+    float2 patch = vin.PosL.xz;
+    float2 origin = float2(gPatchFirstRow, gPatchFirstCol);
+
+    float3 posW = GridToWorld(min(origin + patch * gPatchSize, lastVertex));
+    float morph = saturate((distance(posW, gEyePosW) - gMorphStart) / (gMorphEnd - gMorphStart));
+
+    float2 odd = frac(patch * gPatchQuads * 0.5f) * 2.0f / gPatchQuads;
+    float2 grid = min(origin + (patch - odd * morph) * gPatchSize, lastVertex);
+
+    posW = mul(float4(GridToWorld(grid), 1.0f), gWorld).xyz;
+    vout.PosW = posW;
+    vout.NormalW = mul(GridNormal(grid), (float3x3) gWorld);
+    vout.PosH = mul(float4(posW, 1.0f), gViewProj);
+    vout.TexC = 0.05f * posW.xz;
+
+    return vout;
+}
+#else
 VertexOut VS(VertexIn vin)
 {
     VertexOut vout = (VertexOut) 0.0f;
+
+#ifdef PACKED_VERTEX
+    float3 posL = vin.PosL * gPosScale.xyz + gPosOffset.xyz;
+    float3 normalL = OctDecode(vin.NormalL);
+#else
+    float3 posL = vin.PosL;
+    float3 normalL = vin.NormalL;
+#endif
 	
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(posL, 1.0f), gWorld);
     vout.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3) gWorld);
+    vout.NormalW = mul(normalL, (float3x3) gWorld);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
@@ -95,6 +219,7 @@ VertexOut VS(VertexIn vin)
 
     return vout;
 }
+#endif
 
 float4 PS(VertexOut pin) : SV_Target
 {
@@ -111,12 +236,19 @@ float4 PS(VertexOut pin) : SV_Target
 	clip(diffuseAlbedo.a - 0.1f);
 #endif
 
-	// Indirect lighting.
-    float4 ambient = gAmbientLight * diffuseAlbedo;
+	// Indirect lighting, reduced by the sky hidden behind the terrain.
+    float2 terrainUV = pin.PosW.zx * gTerrainMapTransform.xy + gTerrainMapTransform.zw;
+    float occlusion = gOcclusionMap.Sample(gSamLinearClamp, terrainUV).r;
+    float4 ambient = gAmbientLight * diffuseAlbedo * lerp(1.0f, occlusion, gOcclusionStrength);
 
     const float shininess = 1.0f - gRoughness;
     Material mat = { diffuseAlbedo, gFresnelR0, shininess };
     float3 shadowFactor = 1.0f;
+
+    // Terrain shadow of the sun, the first light
+    float shadow = gShadowMap.Sample(gSamLinearClamp, terrainUV).r;
+    shadowFactor[0] = lerp(1.0f, shadow, gShadowStrength);
+
     float4 directLight = ComputeLighting(gLights, mat, pin.PosW,
         pin.NormalW, toEyeW, shadowFactor);
 
@@ -85,6 +85,9 @@ public:
 	// Getter for ID3D12Resource interface
 	ID3D12Resource* Resource() const { return mUploadBuffer.Get(); }
 
+	// Mapped memory, elements are mElementByteSize apart
+	BYTE* GetMappedData() const { return mMappedData; }
+
 	// Copy given element to the buffer at [elementIndex] slot
 	void CopyData(int elementIndex, const T& data)
 	{
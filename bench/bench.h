@@ -0,0 +1,50 @@
+/*****************************************************************//**
+ * \file   bench.h
+ * \brief  Entry points of the CPU benchmarks, 0 - success, 1 - failure
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+// Terrain mesh generation, vertices per second against thread count
+int BenchTerrainMesh(int argc, char** argv);
+
+// Heightmap row kernel at every SIMD level against the per-vertex loop
+int BenchTerrainKernel(int argc, char** argv);
+
+// RTIN meshes against the error bound, checked against the full grid
+int BenchTerrainRtin(int argc, char** argv);
+
+// Ray casts through the height pyramid against the DDA march
+int BenchTerrainRaycast(int argc, char** argv);
+
+// Procedural heightmaps at every SIMD level and against thread count
+int BenchTerrainNoise(int argc, char** argv);
+
+// Erosion cells per second and iteration against grid size
+int BenchTerrainErosion(int argc, char** argv);
+
+// 3x3 stencils over row-major and tiled heightmaps
+int BenchImageLayout(int argc, char** argv);
+
+// Frustum culling of many boxes at every SIMD level
+int BenchFrustumCull(int argc, char** argv);
+
+// .bmp files read and written in bands against whole images
+int BenchImageStream(int argc, char** argv);
+
+// Mip levels at every SIMD level against a per-pixel loop
+int BenchImageMip(int argc, char** argv);
+
+// Heightmap larger than memory streamed along a camera path, peak resident memory
+int BenchTerrainStream(int argc, char** argv);
+
+// Block-compressed textures encoded and decoded at every SIMD level and on the pool
+int BenchImageBc(int argc, char** argv);
+
+// Color mode conversion at every SIMD level against memcpy bandwidth
+int BenchImageConvert(int argc, char** argv);
+
+// Horizon and ambient occlusion baking against heightmap size
+int BenchTerrainHorizon(int argc, char** argv);
@@ -0,0 +1,120 @@
+/*****************************************************************//**
+ * \file   bench_frustum_cull.cpp
+ * \brief  Frustum culling of many boxes at every SIMD level against
+ *         a loop over Frustum::IntersectsBox
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "frustum.h"
+
+using namespace DirectX;
+
+// Boxes culled when no count is given
+#define BENCH_CULL_BOXES 100000
+
+// Half size of the square world the boxes are spread over
+#define BENCH_CULL_WORLD 1000.0f
+
+// Row-vector view-projection of a camera at eye looking along yaw and
+// pitch, as D3DApplication::UpdatePassCB builds it before transposing
+static XMFLOAT4X4 BenchViewProj(const XMFLOAT3& eye, float yaw, float pitch)
+{
+	// Look, right and up axes of the view
+	const float lx = cosf(pitch) * cosf(yaw), ly = sinf(pitch), lz = cosf(pitch) * sinf(yaw);
+	const float rl = sqrtf(lz * lz + lx * lx);
+	const float rx = lz / rl, ry = 0.0f, rz = -lx / rl;
+	const float ux = ly * rz - lz * ry, uy = lz * rx - lx * rz, uz = lx * ry - ly * rx;
+
+	// Projection of OnResize: vertical field of view pi / 4, 16:9, planes 1 and 1000
+	const float nearZ = 1.0f, farZ = 1000.0f;
+	const float h = 1.0f / tanf(0.125f * 3.14159265f);
+	const float w = h / (16.0f / 9.0f);
+	const float q = farZ / (farZ - nearZ);
+
+	const float tx = -(rx * eye.x + ry * eye.y + rz * eye.z);
+	const float ty = -(ux * eye.x + uy * eye.y + uz * eye.z);
+	const float tz = -(lx * eye.x + ly * eye.y + lz * eye.z);
+
+	return XMFLOAT4X4(
+		rx * w, ux * h, lx * q, lx,
+		ry * w, uy * h, ly * q, ly,
+		rz * w, uz * h, lz * q, lz,
+		tx * w, ty * h, tz * q - nearZ * q, tz);
+}
+
+int BenchFrustumCull(int argc, char** argv)
+{
+	const size_t count = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_CULL_BOXES;
+	if (count == 0)
+	{
+		fprintf(stderr, "Box count must be positive\n");
+		return 1;
+	}
+
+	// Boxes of 1 to 20 units spread over the world, deterministic
+	uint32_t state = 777;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float>(state >> 8) / 16777216.0f;
+	};
+
+	std::vector<BoundingBoxAA> boxes(count);
+	FrustumCuller culler;
+	culler.Resize(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		BoundingBoxAA& box = boxes[i];
+		box.Min = XMFLOAT3((2.0f * next() - 1.0f) * BENCH_CULL_WORLD, -10.0f + 40.0f * next(),
+			(2.0f * next() - 1.0f) * BENCH_CULL_WORLD);
+		box.Max = XMFLOAT3(box.Min.x + 1.0f + 19.0f * next(), box.Min.y + 1.0f + 19.0f * next(),
+			box.Min.z + 1.0f + 19.0f * next());
+		culler.SetBox(i, box);
+	}
+
+	const Frustum frustum = Frustum::FromViewProj(BenchViewProj(XMFLOAT3(0.0f, 20.0f, 0.0f), 0.6f, -0.1f));
+
+	// The test D3DApplication ran per box before the culler
+	std::vector<uint8_t> reference(count);
+	double loop = BenchSeconds([&]() {
+		for (size_t i = 0; i < count; i++) reference[i] = frustum.IntersectsBox(boxes[i]);
+	});
+
+	size_t referenceVisible = 0;
+	for (uint8_t visible : reference) referenceVisible += visible;
+
+	printf("%zu boxes, %.1f%% visible\n", count, 100.0 * referenceVisible / count);
+	printf("method          ns/box  Mboxes/s  speedup  differ from loop\n");
+	printf("IntersectsBox  %7.2f  %8.1f  %7.2f  -\n", loop * 1e9 / count, count / loop * 1e-6, 1.0);
+
+	int result = 0;
+	const char* names[] = { "culler scalar", "culler sse4.1", "culler avx2" };
+	std::vector<uint8_t> scalar(count);
+	std::vector<uint8_t> visible(count);
+
+	// Every level must match the scalar culler, which may differ from the
+	// loop by rounding of boxes touching a plane
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		std::vector<uint8_t>& out = level == SIMD_LEVEL_SCALAR ? scalar : visible;
+		double seconds = BenchSeconds([&]() { culler.Cull(frustum, out.data(), (SIMD_LEVEL)level); });
+
+		if (level != SIMD_LEVEL_SCALAR && out != scalar) result = 1;
+
+		size_t differ = 0;
+		for (size_t i = 0; i < count; i++) differ += out[i] != reference[i];
+
+		printf("%-13s  %7.2f  %8.1f  %7.2f  %zu%s\n", names[level], seconds * 1e9 / count,
+			count / seconds * 1e-6, loop / seconds, differ,
+			level != SIMD_LEVEL_SCALAR && out != scalar ? ", NOT identical to scalar" : "");
+	}
+
+	return result;
+}
@@ -0,0 +1,205 @@
+/*****************************************************************//**
+ * \file   bench_image_bc.cpp
+ * \brief  Compression and decompression of block-compressed textures
+ *         at every SIMD level and on the worker pool
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "image_bc.h"
+#include "image_dds.h"
+
+// Side of the texture when no size is given
+#define BENCH_BC_SIZE 4096
+
+// Side of the encoded texture when no size is given, the high quality
+// search takes seconds per megapixel on one thread
+#define BENCH_BC_ENCODE_SIZE 1024
+
+// Blocks of the format with random bits. BC7 blocks take every mode
+// equally often, the first byte selects it.
+static std::vector<uint8_t> RandomBlocks(uint32_t dxgiFormat, uint32_t size)
+{
+	const size_t bytes = (size_t)dds_level_size(dxgiFormat, size, size);
+	std::vector<uint8_t> blocks(bytes);
+
+	uint32_t state = 12345;
+	for (size_t i = 0; i < bytes; i++)
+	{
+		state = state * 1664525u + 1013904223u;
+		blocks[i] = (uint8_t)(state >> 24);
+	}
+
+	if (dxgiFormat == DDS_DXGI_FORMAT_BC7_UNORM)
+	{
+		for (size_t i = 0; i < bytes; i += 16)
+		{
+			const uint32_t mode = blocks[i + 1] & 7;
+			blocks[i] = (uint8_t)((blocks[i] << (mode + 1) | 1u << mode) & 0xFF);
+		}
+	}
+
+	return blocks;
+}
+
+// BGRA pixels of the synthetic heightmap with decorrelated channels
+static std::vector<uint8_t> HeightmapPixels(uint32_t size)
+{
+	std::unique_ptr<HeightmapImage> heightmap = BenchHeightmap(size, size);
+	std::vector<uint8_t> pixels((size_t)size * size * 4);
+	for (uint32_t row = 0; row < size; row++)
+	{
+		const uint8_t* pRow = heightmap->GetRow(row);
+		for (uint32_t col = 0; col < size; col++)
+		{
+			uint8_t* pPixel = &pixels[((size_t)row * size + col) * 4];
+			pPixel[0] = pRow[col];
+			pPixel[1] = (uint8_t)(pRow[col] ^ 0x5A);
+			pPixel[2] = (uint8_t)(255 - pRow[col]);
+			pPixel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+// Blocks of the BC7 encoder, mode 6 only, from the heightmap pixels
+static std::vector<uint8_t> EncodedBlocks(uint32_t size)
+{
+	std::vector<uint8_t> pixels = HeightmapPixels(size);
+	std::vector<uint8_t> blocks((size_t)dds_level_size(DDS_DXGI_FORMAT_BC7_UNORM, size, size));
+	bc_encode(pixels.data(), size, size, (size_t)size * 4, 4, BC_FORMAT_BC7, BC_QUALITY_FAST, blocks.data(),
+		&WorkerPool::Default());
+	return blocks;
+}
+
+// One format at every SIMD level on one thread, then on the pool.
+// 0 - success, 1 - a level or the pool differs from scalar
+static int BenchFormat(const char* name, uint32_t dxgiFormat, const std::vector<uint8_t>& blocks, uint32_t size)
+{
+	const uint32_t channels = bc_decoded_channels(dxgiFormat);
+	const size_t pitch = (size_t)size * channels;
+	std::vector<uint8_t> scalar(pitch * size), out(scalar.size());
+
+	const char* levels[] = { "scalar", "sse4.1", "avx2" };
+	const double pixelCount = (double)size * size;
+	double scalarSeconds = 0.0;
+	int result = 0;
+
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel() + 1; level++)
+	{
+		// The row past the last level is the best level on the pool
+		const bool pooled = level > GetSimdLevel();
+		const SIMD_LEVEL simd = pooled ? GetSimdLevel() : (SIMD_LEVEL)level;
+		std::vector<uint8_t>& dst = level == SIMD_LEVEL_SCALAR ? scalar : out;
+
+		const double seconds = BenchSeconds([&]() {
+			bc_decode(blocks.data(), dxgiFormat, size, size, dst.data(), pitch,
+				pooled ? &WorkerPool::Default() : nullptr, simd);
+		});
+		if (level == SIMD_LEVEL_SCALAR) scalarSeconds = seconds;
+
+		const bool identical = level == SIMD_LEVEL_SCALAR || dst == scalar;
+		if (!identical) result = 1;
+
+		char path[32];
+		snprintf(path, sizeof(path), "%s%s", levels[simd], pooled ? " pool" : "");
+		printf("%-9s  %5u  %-11s  %8.2f  %9.1f  %7.2f  %s\n", name, size, path, seconds * 1e3,
+			pixelCount / seconds * 1e-6, scalarSeconds / seconds, identical ? "yes" : "NO");
+	}
+
+	return result;
+}
+
+// One format at every quality, at every SIMD level on one thread, then
+// on the pool. Pixels are BGRA, formats with fewer channels read the
+// first ones. 0 - success, 1 - a level or the pool differs from scalar
+static int BenchEncode(const char* name, BC_FORMAT format, uint32_t channels, const std::vector<uint8_t>& bgra,
+	uint32_t size)
+{
+	std::vector<uint8_t> pixels((size_t)size * size * channels);
+	for (size_t i = 0; i < (size_t)size * size; i++)
+	{
+		memcpy(&pixels[i * channels], &bgra[i * 4], channels);
+	}
+
+	const size_t bytes = (size_t)dds_level_size(bc_dxgi_format(format), size, size);
+	std::vector<uint8_t> scalar(bytes), out(bytes);
+
+	const char* qualities[] = { "fast", "normal", "high" };
+	const char* levels[] = { "scalar", "sse4.1", "avx2" };
+	const double pixelCount = (double)size * size;
+	int result = 0;
+
+	for (int quality = BC_QUALITY_FAST; quality <= BC_QUALITY_HIGH; quality++)
+	{
+		double scalarSeconds = 0.0;
+		for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel() + 1; level++)
+		{
+			// The row past the last level is the best level on the pool
+			const bool pooled = level > GetSimdLevel();
+			const SIMD_LEVEL simd = pooled ? GetSimdLevel() : (SIMD_LEVEL)level;
+			std::vector<uint8_t>& dst = level == SIMD_LEVEL_SCALAR ? scalar : out;
+
+			const double seconds = BenchSeconds([&]() {
+				bc_encode(pixels.data(), size, size, (size_t)size * channels, channels, format, (BC_QUALITY)quality,
+					dst.data(), pooled ? &WorkerPool::Default() : nullptr, simd);
+			});
+			if (level == SIMD_LEVEL_SCALAR) scalarSeconds = seconds;
+
+			const bool identical = level == SIMD_LEVEL_SCALAR || dst == scalar;
+			if (!identical) result = 1;
+
+			char path[32];
+			snprintf(path, sizeof(path), "%s%s", levels[simd], pooled ? " pool" : "");
+			printf("%-6s  %-7s  %5u  %-11s  %8.2f  %9.2f  %7.2f  %s\n", name, qualities[quality], size, path,
+				seconds * 1e3, pixelCount / seconds * 1e-6, scalarSeconds / seconds, identical ? "yes" : "NO");
+		}
+	}
+
+	return result;
+}
+
+int BenchImageBc(int argc, char** argv)
+{
+	const uint32_t size = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_BC_SIZE;
+	const uint32_t encodeSize = argc > 1 ? strtoul(argv[1], nullptr, 10) : BENCH_BC_ENCODE_SIZE;
+	if (size == 0 || size % 4 != 0 || encodeSize == 0 || encodeSize % 4 != 0)
+	{
+		fprintf(stderr, "Texture sizes must be positive multiples of 4\n");
+		return 1;
+	}
+
+	printf("decode of a size x size level, Mpixels/s, speedup over scalar, identical to scalar\n");
+	printf("format      size  path               ms  Mpixels/s  speedup  identical\n");
+
+	// No decoder beats writing its output, BGRA pixels of the level
+	std::vector<uint8_t> pixels((size_t)size * size * 4);
+	const double fill = BenchSeconds([&]() { memset(pixels.data(), (int)pixels[0] + 1, pixels.size()); });
+	printf("%-9s  %5u  %-11s  %8.2f  %9.1f  %7s  -\n", "memset", size, "-", fill * 1e3,
+		(double)size * size / fill * 1e-6, "-");
+
+	int result = 0;
+	result |= BenchFormat("bc1", DDS_DXGI_FORMAT_BC1_UNORM, RandomBlocks(DDS_DXGI_FORMAT_BC1_UNORM, size), size);
+	result |= BenchFormat("bc3", DDS_DXGI_FORMAT_BC3_UNORM, RandomBlocks(DDS_DXGI_FORMAT_BC3_UNORM, size), size);
+	result |= BenchFormat("bc4", DDS_DXGI_FORMAT_BC4_UNORM, RandomBlocks(DDS_DXGI_FORMAT_BC4_UNORM, size), size);
+	result |= BenchFormat("bc5", DDS_DXGI_FORMAT_BC5_UNORM, RandomBlocks(DDS_DXGI_FORMAT_BC5_UNORM, size), size);
+	result |= BenchFormat("bc7", DDS_DXGI_FORMAT_BC7_UNORM, RandomBlocks(DDS_DXGI_FORMAT_BC7_UNORM, size), size);
+	result |= BenchFormat("bc7 mode6", DDS_DXGI_FORMAT_BC7_UNORM, EncodedBlocks(size), size);
+
+	printf("\nencode of a size x size level, Mpixels/s, speedup over scalar, identical to scalar\n");
+	printf("format  quality   size  path               ms  Mpixels/s  speedup  identical\n");
+
+	const std::vector<uint8_t> source = HeightmapPixels(encodeSize);
+	result |= BenchEncode("bc1", BC_FORMAT_BC1, 3, source, encodeSize);
+	result |= BenchEncode("bc4", BC_FORMAT_BC4, 1, source, encodeSize);
+	result |= BenchEncode("bc5", BC_FORMAT_BC5, 2, source, encodeSize);
+	result |= BenchEncode("bc7", BC_FORMAT_BC7, 4, source, encodeSize);
+
+	return result;
+}
@@ -0,0 +1,161 @@
+/*****************************************************************//**
+ * \file   bench_image_convert.cpp
+ * \brief  Color mode conversion at every SIMD level against the
+ *         bandwidth of memcpy, and set_color_mode on the worker pool
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "image_kernel.h"
+
+// Side of the image when no size is given, 1 GB of BGRA pixels
+#define BENCH_CONVERT_SIZE 16384
+
+// Image with its conversion exposed
+class bench_image : public image_base
+{
+public:
+	bench_image(uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode, const uint8_t* pPixels)
+	{
+		if (allocate(width, height, mode) != 0) return;
+		for (uint32_t row = 0; row < height; row++)
+		{
+			memcpy(Row(row), pPixels + (size_t)row * width * mode, (size_t)width * mode);
+		}
+	}
+
+	int SetColorMode(IMAGE_COLOR_MODE mode, WorkerPool* pool) { return set_color_mode(mode, pool); }
+
+	bool Empty() const { return m_pRaw == nullptr; }
+	uint8_t* Row(uint32_t row) { return (uint8_t*)m_pRaw + (size_t)row * m_rowByteSize; }
+};
+
+// GB/s of the bytes read and written
+static double Bandwidth(double bytes, double seconds)
+{
+	return bytes / seconds * 1e-9;
+}
+
+// One pair of modes at every SIMD level on one thread, then through
+// set_color_mode on the pool. 0 - success, 1 - a path differs from scalar
+static int BenchPair(IMAGE_COLOR_MODE srcMode, IMAGE_COLOR_MODE dstMode, uint32_t size, double copyBandwidth)
+{
+	const char* modes[] = { "", "gray", "", "bgr", "bgra" };
+	const char* levels[] = { "scalar", "sse4.1", "avx2" };
+	const size_t pixelCount = (size_t)size * size;
+	const double bytes = (double)pixelCount * ((uint32_t)srcMode + (uint32_t)dstMode);
+
+	// Decorrelated channels, so colors do not reduce to their gray levels
+	std::vector<uint8_t> src(pixelCount * srcMode);
+	uint32_t state = 12345;
+	for (size_t i = 0; i < src.size(); i++)
+	{
+		state = state * 1664525u + 1013904223u;
+		src[i] = (uint8_t)(state >> 24);
+	}
+
+	std::vector<uint8_t> scalar(pixelCount * dstMode), out(scalar.size());
+	char name[16];
+	snprintf(name, sizeof(name), "%s>%s", modes[srcMode], modes[dstMode]);
+
+	int result = 0;
+	double scalarSeconds = 0.0;
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		std::vector<uint8_t>& dst = level == SIMD_LEVEL_SCALAR ? scalar : out;
+
+		// Row at a time, as set_color_mode converts them
+		const double seconds = BenchSeconds([&]() {
+			for (uint32_t row = 0; row < size; row++)
+			{
+				const size_t first = (size_t)row * size;
+				convert_pixels(&src[first * srcMode], srcMode, &dst[first * dstMode], dstMode, size,
+					(SIMD_LEVEL)level);
+			}
+		});
+		if (level == SIMD_LEVEL_SCALAR) scalarSeconds = seconds;
+
+		const bool identical = level == SIMD_LEVEL_SCALAR || dst == scalar;
+		if (!identical) result = 1;
+
+		printf("%-9s  %-13s  %8.2f  %5.2f  %6.0f%%  %7.2f  %s\n", name, levels[level], seconds * 1e3,
+			Bandwidth(bytes, seconds), 100.0 * Bandwidth(bytes, seconds) / copyBandwidth, scalarSeconds / seconds,
+			identical ? "yes" : "NO");
+	}
+	out.clear();
+	out.shrink_to_fit();
+
+	// The image is converted back untimed before every run. Each run
+	// allocates the new pixels, so the page faults of first writes are in.
+	bench_image image(size, size, srcMode, src.data());
+	if (image.Empty()) return 1;
+	src.clear();
+	src.shrink_to_fit();
+
+	double seconds = 1e30;
+	for (int i = 0; i < BENCH_REPEATS; i++)
+	{
+		image.SetColorMode(srcMode, &WorkerPool::Default());
+		seconds = (std::min)(seconds, BenchSeconds([&]() { image.SetColorMode(dstMode, &WorkerPool::Default()); }, 1));
+	}
+
+	bool identical = true;
+	for (uint32_t row = 0; row < size && identical; row++)
+	{
+		identical = memcmp(image.Row(row), &scalar[(size_t)row * size * dstMode], (size_t)size * dstMode) == 0;
+	}
+	if (!identical) result = 1;
+
+	printf("%-9s  %-13s  %8.2f  %5.2f  %6.0f%%  %7.2f  %s\n", name, "set_color_mode", seconds * 1e3,
+		Bandwidth(bytes, seconds), 100.0 * Bandwidth(bytes, seconds) / copyBandwidth, scalarSeconds / seconds,
+		identical ? "yes" : "NO");
+
+	return result;
+}
+
+int BenchImageConvert(int argc, char** argv)
+{
+	const uint32_t size = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_CONVERT_SIZE;
+	if (size == 0 || size % 4 != 0)
+	{
+		fprintf(stderr, "Image size must be a positive multiple of 4\n");
+		return 1;
+	}
+
+	// No conversion beats copying, measured on the largest image
+	std::vector<uint8_t> copySrc((size_t)size * size * 4, 1), copyDst(copySrc.size(), 0);
+	const double copy = BenchSeconds([&]() { memcpy(copyDst.data(), copySrc.data(), copySrc.size()); });
+	const double copyBandwidth = Bandwidth(2.0 * copySrc.size(), copy);
+	copySrc.clear();
+	copySrc.shrink_to_fit();
+	copyDst.clear();
+	copyDst.shrink_to_fit();
+
+	printf("%ux%u image, GB/s read and written, share of memcpy bandwidth, speedup over scalar\n", size, size);
+	printf("%-9s  %-13s  %8s  %5s  %7s  %7s  %s\n", "modes", "path", "ms", "GB/s", "memcpy", "speedup", "identical");
+	printf("%-9s  %-13s  %8.2f  %5.2f  %6.0f%%  %7s  -\n", "bgra", "memcpy", copy * 1e3, copyBandwidth, 100.0, "-");
+
+	const IMAGE_COLOR_MODE pairs[][2] =
+	{
+		{ IMAGE_COLOR_MODE_GRAYSCALE, IMAGE_COLOR_MODE_RGB },
+		{ IMAGE_COLOR_MODE_GRAYSCALE, IMAGE_COLOR_MODE_RGBA },
+		{ IMAGE_COLOR_MODE_RGB, IMAGE_COLOR_MODE_GRAYSCALE },
+		{ IMAGE_COLOR_MODE_RGBA, IMAGE_COLOR_MODE_GRAYSCALE },
+		{ IMAGE_COLOR_MODE_RGB, IMAGE_COLOR_MODE_RGBA },
+		{ IMAGE_COLOR_MODE_RGBA, IMAGE_COLOR_MODE_RGB },
+	};
+
+	int result = 0;
+	for (const IMAGE_COLOR_MODE* pair : pairs)
+	{
+		result |= BenchPair(pair[0], pair[1], size, copyBandwidth);
+	}
+	return result;
+}
@@ -0,0 +1,221 @@
+/*****************************************************************//**
+ * \file   bench_image_layout.cpp
+ * \brief  3x3 heightmap stencils over row-major and tiled images
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_horizon.h"
+#include "terrain_kernel.h"
+
+// Tile with a one sample halo on every side
+#define BENCH_HALO_SIZE (IMAGE_TILE_SIZE + 2)
+
+// Output of a stencil pass, one value per sample row after row,
+// border samples stay zero
+struct stencil_output
+{
+	std::vector<float> Height;
+	std::vector<float> NormalX;
+	std::vector<float> NormalY;
+	std::vector<float> NormalZ;
+
+	void Resize(size_t count)
+	{
+		Height.assign(count, 0.0f);
+		NormalX.assign(count, 0.0f);
+		NormalY.assign(count, 0.0f);
+		NormalZ.assign(count, 0.0f);
+	}
+
+	bool operator==(const stencil_output& other) const
+	{
+		return Height == other.Height && NormalX == other.NormalX &&
+			NormalY == other.NormalY && NormalZ == other.NormalZ;
+	}
+};
+
+// Interior samples [first, end) of the tile starting at start, of a side
+// of size samples
+static void TileInterior(uint32_t start, uint32_t size, uint32_t& first, uint32_t& end)
+{
+	first = (std::max)(start, 1u);
+	end = (std::min)(start + IMAGE_TILE_SIZE, size - 1);
+}
+
+// The CreateTerrain stencil over full rows of a row-major image
+static void KernelRows(HeightmapImage& heightmap, stencil_output& out)
+{
+	const uint32_t width = heightmap.GetWidth();
+	const size_t pitch = heightmap.GetRowPitch();
+
+	for (uint32_t row = 1; row + 1 < heightmap.GetHeight(); row++)
+	{
+		const uint8_t* pRow = heightmap.GetRow(row) + 1;
+		const size_t k = static_cast<size_t>(row) * width + 1;
+
+		ComputeTerrainRow(pRow - pitch, pRow, pRow + pitch, width - 2, 1.0f, 1.0f,
+			&out.Height[k], &out.NormalX[k], &out.NormalY[k], &out.NormalZ[k]);
+	}
+}
+
+// The same stencil a tile at a time, over the tile and its halo read as a region
+static void KernelTiles(HeightmapImage& heightmap, stencil_output& out)
+{
+	const uint32_t width = heightmap.GetWidth();
+	const uint32_t height = heightmap.GetHeight();
+	uint8_t halo[BENCH_HALO_SIZE * BENCH_HALO_SIZE];
+
+	for (uint32_t tileRow = 0; tileRow < heightmap.GetTileRows(); tileRow++)
+	{
+		uint32_t firstRow, endRow;
+		TileInterior(tileRow * IMAGE_TILE_SIZE, height, firstRow, endRow);
+
+		for (uint32_t tileCol = 0; tileCol < heightmap.GetTileColumns(); tileCol++)
+		{
+			uint32_t firstCol, endCol;
+			TileInterior(tileCol * IMAGE_TILE_SIZE, width, firstCol, endCol);
+			if (firstRow >= endRow || firstCol >= endCol) continue;
+
+			heightmap.ReadRegion(firstRow - 1, firstCol - 1, endRow - firstRow + 2, endCol - firstCol + 2,
+				halo, BENCH_HALO_SIZE);
+
+			for (uint32_t row = firstRow; row < endRow; row++)
+			{
+				const uint8_t* pRow = &halo[(row - firstRow + 1) * BENCH_HALO_SIZE + 1];
+				const size_t k = static_cast<size_t>(row) * width + firstCol;
+
+				ComputeTerrainRow(pRow - BENCH_HALO_SIZE, pRow, pRow + BENCH_HALO_SIZE, endCol - firstCol,
+					1.0f, 1.0f, &out.Height[k], &out.NormalX[k], &out.NormalY[k], &out.NormalZ[k]);
+			}
+		}
+	}
+}
+
+// Sum of absolute central differences at p, rows pitch bytes apart
+static float Slope(const uint8_t* p, size_t pitch)
+{
+	return static_cast<float>(std::abs(p[1] - p[-1]) + std::abs(p[pitch] - p[-static_cast<ptrdiff_t>(pitch)]));
+}
+
+// Scalar stencil walked column after column, the order of column sweeps
+// such as the transposed horizon lines
+static void ColumnsRowMajor(HeightmapImage& heightmap, std::vector<float>& out)
+{
+	const uint32_t width = heightmap.GetWidth();
+	const uint32_t height = heightmap.GetHeight();
+	const uint8_t* pFirst = heightmap.GetRow(0);
+	const size_t pitch = heightmap.GetRowPitch();
+
+	for (uint32_t col = 1; col + 1 < width; col++)
+	{
+		for (uint32_t row = 1; row + 1 < height; row++)
+		{
+			out[static_cast<size_t>(row) * width + col] = Slope(pFirst + row * pitch + col, pitch);
+		}
+	}
+}
+
+// The same walk over the tiles of a tiled image, tile columns first
+static void ColumnsTiled(HeightmapImage& heightmap, std::vector<float>& out)
+{
+	const uint32_t width = heightmap.GetWidth();
+	const uint32_t height = heightmap.GetHeight();
+	uint8_t halo[BENCH_HALO_SIZE * BENCH_HALO_SIZE];
+
+	for (uint32_t tileCol = 0; tileCol < heightmap.GetTileColumns(); tileCol++)
+	{
+		uint32_t firstCol, endCol;
+		TileInterior(tileCol * IMAGE_TILE_SIZE, width, firstCol, endCol);
+
+		for (uint32_t tileRow = 0; tileRow < heightmap.GetTileRows(); tileRow++)
+		{
+			uint32_t firstRow, endRow;
+			TileInterior(tileRow * IMAGE_TILE_SIZE, height, firstRow, endRow);
+			if (firstRow >= endRow || firstCol >= endCol) continue;
+
+			heightmap.ReadRegion(firstRow - 1, firstCol - 1, endRow - firstRow + 2, endCol - firstCol + 2,
+				halo, BENCH_HALO_SIZE);
+
+			for (uint32_t col = firstCol; col < endCol; col++)
+			{
+				for (uint32_t row = firstRow; row < endRow; row++)
+				{
+					const uint8_t* p = &halo[(row - firstRow + 1) * BENCH_HALO_SIZE + col - firstCol + 1];
+					out[static_cast<size_t>(row) * width + col] = Slope(p, BENCH_HALO_SIZE);
+				}
+			}
+		}
+	}
+}
+
+int BenchImageLayout(int argc, char** argv)
+{
+	std::unique_ptr<HeightmapImage> heightmap = BenchLoadHeightmap(argc, argv);
+	const uint32_t width = heightmap->GetWidth();
+	const uint32_t height = heightmap->GetHeight();
+	if (width < 3 || height < 3)
+	{
+		fprintf(stderr, "Heightmap must be at least 3x3\n");
+		return 1;
+	}
+
+	// A tiled copy, the row-major image stays for the reference passes
+	HeightmapImage tiled(width, height);
+	for (uint32_t row = 0; row < height; row++)
+	{
+		memcpy(tiled.GetWritableRow(row), heightmap->GetRow(row), width);
+	}
+
+	const double samples = static_cast<double>(width) * height;
+	const double toTiled = BenchSeconds([&]() {
+		tiled.SetLayout(IMAGE_LAYOUT_ROW_MAJOR);
+		tiled.SetLayout(IMAGE_LAYOUT_TILED);
+	});
+
+	printf("%ux%u heightmap, %ux%u tiles, one thread\n", width, height, IMAGE_TILE_SIZE, IMAGE_TILE_SIZE);
+	printf("pass                          row-major ns  tiled ns  identical\n");
+	printf("conversion both ways          %12s  %8.2f  -\n", "-", toTiled * 1e9 / samples);
+
+	int result = 0;
+	auto report = [&](const char* name, double rowMajor, double tiledSeconds, bool identical) {
+		if (!identical) result = 1;
+		printf("%-28s  %12.2f  %8.2f  %s\n", name, rowMajor * 1e9 / samples, tiledSeconds * 1e9 / samples,
+			identical ? "yes" : "NO");
+	};
+
+	// Full rows on row-major, tiles with their halo on both layouts
+	stencil_output rows, rowTiles, tiles;
+	rows.Resize(static_cast<size_t>(width) * height);
+	rowTiles.Resize(rows.Height.size());
+	tiles.Resize(rows.Height.size());
+
+	double fullRows = BenchSeconds([&]() { KernelRows(*heightmap, rows); });
+	printf("%-28s  %12.2f  %8s  -\n", "kernel, full rows", fullRows * 1e9 / samples, "-");
+
+	double rowMajorTiles = BenchSeconds([&]() { KernelTiles(*heightmap, rowTiles); });
+	double tiledTiles = BenchSeconds([&]() { KernelTiles(tiled, tiles); });
+	report("kernel, tiles with halo", rowMajorTiles, tiledTiles, rowTiles == rows && tiles == rows);
+
+	// Column order walks
+	std::vector<float> columns(rows.Height.size(), 0.0f);
+	std::vector<float> tiledColumns(rows.Height.size(), 0.0f);
+
+	double rowMajorColumns = BenchSeconds([&]() { ColumnsRowMajor(*heightmap, columns); });
+	double tiledColumnWalk = BenchSeconds([&]() { ColumnsTiled(tiled, tiledColumns); });
+	report("scalar, column order", rowMajorColumns, tiledColumnWalk, columns == tiledColumns);
+
+	// Heights and their transposed copy read by the horizon baker
+	double rowMajorHorizons = BenchSeconds([&]() { TerrainHorizonBaker horizons(*heightmap); });
+	double tiledHorizons = BenchSeconds([&]() { TerrainHorizonBaker horizons(tiled); });
+	printf("%-28s  %12.2f  %8.2f  -\n", "horizon baker heights", rowMajorHorizons * 1e9 / samples,
+		tiledHorizons * 1e9 / samples);
+
+	return result;
+}
@@ -0,0 +1,191 @@
+/*****************************************************************//**
+ * \file   bench_image_mip.cpp
+ * \brief  Mip level filtering at every SIMD level against a per-pixel
+ *         footprint loop
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "image_mip.h"
+
+// Side of the source when no size is given
+#define BENCH_MIP_SIZE 4096
+
+// Source pixels of one output pixel along one axis, as mip_chain weighs
+// them: pairs for even sizes, three by coverage for odd ones
+static uint32_t Footprint(uint32_t src, uint32_t dst, uint32_t i, uint32_t* pIndex, float* pWeight)
+{
+	if (src == 1)
+	{
+		pIndex[0] = 0;
+		pWeight[0] = 1.0f;
+		return 1;
+	}
+
+	if (src % 2 == 0)
+	{
+		pIndex[0] = 2 * i;
+		pIndex[1] = 2 * i + 1;
+		pWeight[0] = pWeight[1] = 0.5f;
+		return 2;
+	}
+
+	pIndex[0] = 2 * i;
+	pIndex[1] = 2 * i + 1;
+	pIndex[2] = 2 * i + 2;
+	pWeight[0] = (float)(dst - i) / src;
+	pWeight[1] = (float)dst / src;
+	pWeight[2] = (float)(i + 1) / src;
+	return 3;
+}
+
+// The straightforward filter: every channel of every output pixel reads
+// its footprint of 8-bit source pixels
+static void NaiveLevel(const mip_level& src, uint8_t* dst, uint32_t width, uint32_t height, size_t dstPitch,
+	uint32_t channels, MIP_FILTER filter)
+{
+	for (uint32_t row = 0; row < height; row++)
+	{
+		uint32_t rowIndex[3];
+		float rowWeight[3];
+		const uint32_t rowTaps = Footprint(src.height, height, row, rowIndex, rowWeight);
+
+		for (uint32_t col = 0; col < width; col++)
+		{
+			uint32_t colIndex[3];
+			float colWeight[3];
+			const uint32_t colTaps = Footprint(src.width, width, col, colIndex, colWeight);
+
+			for (uint32_t c = 0; c < channels; c++)
+			{
+				float value = filter == MIP_FILTER_MIN ? 255.0f : 0.0f;
+				for (uint32_t ky = 0; ky < rowTaps; ky++)
+				{
+					const uint8_t* pRow = src.data + rowIndex[ky] * src.row_pitch;
+					for (uint32_t kx = 0; kx < colTaps; kx++)
+					{
+						const float x = pRow[colIndex[kx] * channels + c];
+						if (filter == MIP_FILTER_MIN) value = (std::min)(value, x);
+						else if (filter == MIP_FILTER_MAX) value = (std::max)(value, x);
+						else value += rowWeight[ky] * colWeight[kx] * x;
+					}
+				}
+				dst[row * dstPitch + col * channels + c] = (uint8_t)std::nearbyint(value);
+			}
+		}
+	}
+}
+
+// Largest difference of a channel between two levels
+static int MaxDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+{
+	int difference = 0;
+	for (size_t i = 0; i < a.size(); i++) difference = (std::max)(difference, std::abs(a[i] - b[i]));
+	return difference;
+}
+
+// One level of a size x size source, the loop against every SIMD level.
+// 0 - success, 1 - a level differs from scalar or from the loop
+static int BenchLevel(uint32_t size, uint32_t channels, MIP_FILTER filter)
+{
+	// Channels of the hills decorrelated, so they do not filter alike
+	std::unique_ptr<HeightmapImage> heightmap = BenchHeightmap(size, size);
+	const size_t srcPitch = (static_cast<size_t>(size) * channels + 3) & ~static_cast<size_t>(3);
+	std::vector<uint8_t> pixels(srcPitch * size);
+	for (uint32_t row = 0; row < size; row++)
+	{
+		const uint8_t* pRow = heightmap->GetRow(row);
+		for (uint32_t col = 0; col < size; col++)
+		{
+			const uint8_t h = pRow[col];
+			const uint8_t derived[4] = { h, (uint8_t)(h ^ 0x5A), (uint8_t)(255 - h), (uint8_t)(row + col) };
+			for (uint32_t c = 0; c < channels; c++) pixels[row * srcPitch + col * channels + c] = derived[c];
+		}
+	}
+
+	mip_level src;
+	src.data = pixels.data();
+	src.width = size;
+	src.height = size;
+	src.row_pitch = srcPitch;
+
+	const uint32_t width = (std::max)(size / 2, 1u);
+	const uint32_t height = (std::max)(size / 2, 1u);
+	const size_t dstPitch = static_cast<size_t>(width) * channels;
+
+	// The loop has no Kaiser filter, its sinc weights are what the taps precompute
+	const bool naive = filter != MIP_FILTER_KAISER;
+	std::vector<uint8_t> reference(dstPitch * height), scalar(reference.size()), out(reference.size());
+
+	double loop = 0.0;
+	if (naive)
+	{
+		loop = BenchSeconds([&]() { NaiveLevel(src, reference.data(), width, height, dstPitch, channels, filter); });
+	}
+
+	const char* filters[] = { "box", "kaiser", "min", "max" };
+	const char* levels[] = { "scalar", "sse4.1", "avx2" };
+	const double pixelCount = static_cast<double>(size) * size;
+	int result = 0;
+
+	if (naive)
+	{
+		printf("%5u  %8u  %-6s  %-6s  %8.2f  %9.1f  %7.2f  -\n", size, channels, filters[filter], "loop",
+			loop * 1e3, pixelCount / loop * 1e-6, 1.0);
+	}
+
+	// Box may round differently from the loop by a level, min and max are exact
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		std::vector<uint8_t>& dst = level == SIMD_LEVEL_SCALAR ? scalar : out;
+		double seconds = BenchSeconds([&]() {
+			generate_mip_level(src, dst.data(), width, height, dstPitch, channels, MIP_FORMAT_UNORM8, filter,
+				nullptr, (SIMD_LEVEL)level);
+		});
+
+		const bool identical = level == SIMD_LEVEL_SCALAR || dst == scalar;
+		const int difference = naive ? MaxDifference(dst, reference) : 0;
+		if (!identical || difference > (filter == MIP_FILTER_BOX ? 1 : 0)) result = 1;
+
+		printf("%5u  %8u  %-6s  %-6s  %8.2f  %9.1f  ", size, channels, filters[filter], levels[level],
+			seconds * 1e3, pixelCount / seconds * 1e-6);
+		if (naive) printf("%7.2f  %d", loop / seconds, difference);
+		else printf("%7s  -", "-");
+		printf("%s\n", identical ? "" : ", NOT identical to scalar");
+	}
+
+	return result;
+}
+
+int BenchImageMip(int argc, char** argv)
+{
+	const uint32_t size = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_MIP_SIZE;
+	if (size < 2)
+	{
+		fprintf(stderr, "Image size must be at least 2\n");
+		return 1;
+	}
+
+	printf("one level on one thread, source Mpixels/s, largest difference from the loop\n");
+	printf(" size  channels  filter  path          ms  Mpixels/s  speedup  difference\n");
+
+	int result = 0;
+	const MIP_FILTER filters[] = { MIP_FILTER_BOX, MIP_FILTER_MAX, MIP_FILTER_KAISER };
+	for (MIP_FILTER filter : filters)
+	{
+		result |= BenchLevel(size, 1, filter);
+	}
+
+	// Four channels, and an odd size with three-pixel footprints
+	result |= BenchLevel(size, 4, MIP_FILTER_BOX);
+	result |= BenchLevel(size - 1, 1, MIP_FILTER_BOX);
+
+	return result;
+}
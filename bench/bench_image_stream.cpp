@@ -0,0 +1,197 @@
+/*****************************************************************//**
+ * \file   bench_image_stream.cpp
+ * \brief  .bmp files read, inverted and written in bands of rows
+ *         against whole images in memory
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "image_stream.h"
+
+// Side of the grayscale image when no size is given, 64 MB of pixels
+#define BENCH_STREAM_SIZE 8192
+
+#define BENCH_STREAM_SOURCE "bench_image_stream.bmp"
+#define BENCH_STREAM_BANDED "bench_image_stream_banded.bmp"
+#define BENCH_STREAM_WHOLE "bench_image_stream_whole.bmp"
+
+// Timed runs per measurement, every run moves the whole file
+#define BENCH_STREAM_REPEATS 3
+
+// Writes the source image in bands, the same hills as BenchHeightmap
+// without its noise. 0 - success, -1 - error
+static int WriteSource(uint32_t size)
+{
+	bmp_band_writer writer;
+	if (writer.open(BENCH_STREAM_SOURCE, size, size, IMAGE_COLOR_MODE_GRAYSCALE, 256) != 0) return -1;
+
+	uint32_t firstRow, rows;
+	while (uint8_t* pBand = writer.band(firstRow, rows))
+	{
+		for (uint32_t r = 0; r < rows; r++)
+		{
+			const uint32_t row = firstRow + r;
+			uint8_t* pRow = pBand + r * writer.row_pitch();
+			for (uint32_t col = 0; col < size; col++)
+			{
+				pRow[col] = static_cast<uint8_t>(((row * 7 + col * 3) & 255) ^ ((row / 5 + col / 3) & 127));
+			}
+		}
+		if (writer.commit_band() != 0) return -1;
+	}
+
+	return writer.close();
+}
+
+// Sum of all pixels read in bands, or -1 when a read failed
+static int64_t SumBanded(uint32_t bandRows)
+{
+	bmp_band_reader reader;
+	if (reader.open(BENCH_STREAM_SOURCE, bandRows) != 0) return -1;
+
+	const uint32_t width = reader.info().width;
+	int64_t sum = 0;
+
+	uint32_t firstRow, rows;
+	while (const uint8_t* pBand = reader.next_band(firstRow, rows))
+	{
+		for (uint32_t r = 0; r < rows; r++)
+		{
+			const uint8_t* pRow = pBand + r * reader.row_pitch();
+			for (uint32_t col = 0; col < width; col++) sum += pRow[col];
+		}
+	}
+
+	return reader.failed() ? -1 : sum;
+}
+
+// Inverted copy of the source, a band read while the one before is
+// inverted and the one before that written. 0 - success, -1 - error
+static int InvertBanded(uint32_t bandRows)
+{
+	bmp_band_reader reader;
+	bmp_band_writer writer;
+	if (reader.open(BENCH_STREAM_SOURCE, bandRows) != 0) return -1;
+
+	const bmp_info& info = reader.info();
+	if (writer.open(BENCH_STREAM_BANDED, info.width, info.height, IMAGE_COLOR_MODE_GRAYSCALE, bandRows) != 0)
+	{
+		return -1;
+	}
+
+	// Bottom-up source, bands of both come in the same order
+	uint32_t firstRow, rows, outRow, outRows;
+	while (const uint8_t* pSrc = reader.next_band(firstRow, rows))
+	{
+		uint8_t* pDst = writer.band(outRow, outRows);
+		if (!pDst || outRow != firstRow || outRows != rows) return -1;
+
+		for (uint32_t r = 0; r < rows; r++)
+		{
+			const uint8_t* pSrcRow = pSrc + r * reader.row_pitch();
+			uint8_t* pDstRow = pDst + r * writer.row_pitch();
+			for (uint32_t col = 0; col < info.width; col++) pDstRow[col] = 255 - pSrcRow[col];
+		}
+		if (writer.commit_band() != 0) return -1;
+	}
+
+	return reader.failed() ? -1 : writer.close();
+}
+
+// The same copy through an image held whole, 0 - success, -1 - error
+static int InvertWhole()
+{
+	HeightmapImage image(BENCH_STREAM_SOURCE);
+	if (image.GetWidth() == 0) return -1;
+
+	for (uint32_t row = 0; row < image.GetHeight(); row++)
+	{
+		uint8_t* pRow = image.GetWritableRow(row);
+		for (uint32_t col = 0; col < image.GetWidth(); col++) pRow[col] = 255 - pRow[col];
+	}
+
+	return image.WriteBmp(BENCH_STREAM_WHOLE);
+}
+
+static bool SameFiles(const char* a, const char* b)
+{
+	FILE* pA = fopen(a, "rb");
+	FILE* pB = fopen(b, "rb");
+
+	bool same = pA && pB;
+	std::vector<uint8_t> chunkA(1 << 20), chunkB(1 << 20);
+	while (same)
+	{
+		const size_t readA = fread(chunkA.data(), 1, chunkA.size(), pA);
+		const size_t readB = fread(chunkB.data(), 1, chunkB.size(), pB);
+		same = readA == readB && memcmp(chunkA.data(), chunkB.data(), readA) == 0;
+		if (readA < chunkA.size()) break;
+	}
+
+	if (pA) fclose(pA);
+	if (pB) fclose(pB);
+	return same;
+}
+
+int BenchImageStream(int argc, char** argv)
+{
+	const uint32_t size = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_STREAM_SIZE;
+	if (size == 0 || size % 4 != 0)
+	{
+		fprintf(stderr, "Image size must be a positive multiple of 4\n");
+		return 1;
+	}
+
+	if (WriteSource(size) != 0) return 1;
+
+	const double megabytes = static_cast<double>(size) * size * 1e-6;
+	int result = 0;
+
+	// Whole image: a copy-on-write mapping summed, then inverted in place and written
+	int64_t wholeSum = 0;
+	const double wholeRead = BenchSeconds([&]() {
+		HeightmapImage image(BENCH_STREAM_SOURCE);
+		wholeSum = 0;
+		for (uint32_t row = 0; row < image.GetHeight(); row++)
+		{
+			const uint8_t* pRow = image.GetRow(row);
+			for (uint32_t col = 0; col < image.GetWidth(); col++) wholeSum += pRow[col];
+		}
+	}, BENCH_STREAM_REPEATS);
+
+	int wholeStatus = 0;
+	const double wholeInvert = BenchSeconds([&]() { wholeStatus |= InvertWhole(); }, BENCH_STREAM_REPEATS);
+	if (wholeStatus != 0) result = 1;
+
+	printf("%ux%u grayscale .bmp, %.1f MB of pixels\n", size, size, megabytes);
+	printf("band rows  buffers MB  read MB/s  invert MB/s  identical\n");
+	printf("%9s  %10.1f  %9.0f  %11.0f  -\n", "whole", megabytes, megabytes / wholeRead,
+		megabytes / wholeInvert);
+
+	// Two buffers of the reader, two more of the writer when inverting
+	const uint32_t bandRows[] = { 16, 64, 256, 1024 };
+	for (uint32_t rows : bandRows)
+	{
+		int64_t sum = 0;
+		const double read = BenchSeconds([&]() { sum = SumBanded(rows); }, BENCH_STREAM_REPEATS);
+
+		int status = 0;
+		const double invert = BenchSeconds([&]() { status |= InvertBanded(rows); }, BENCH_STREAM_REPEATS);
+
+		const bool identical = sum == wholeSum && status == 0 && SameFiles(BENCH_STREAM_BANDED, BENCH_STREAM_WHOLE);
+		if (!identical) result = 1;
+
+		printf("%9u  %10.1f  %9.0f  %11.0f  %s\n", rows, 4.0 * rows * size * 1e-6, megabytes / read,
+			megabytes / invert, identical ? "yes" : "NO");
+	}
+
+	remove(BENCH_STREAM_SOURCE);
+	remove(BENCH_STREAM_BANDED);
+	remove(BENCH_STREAM_WHOLE);
+	return result;
+}
@@ -0,0 +1,68 @@
+/*****************************************************************//**
+ * \file   bench_main.cpp
+ * \brief  Console runner of the CPU benchmarks
+ *
+ * Usage: bench [name [arguments]]. Without a name every benchmark
+ * runs with its default input.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdio>
+#include <cstring>
+
+#include "bench.h"
+
+struct bench_entry
+{
+	const char* Name;
+	const char* Usage;
+	int (*Run)(int argc, char** argv);
+};
+
+static const bench_entry gBenches[] =
+{
+	{ "terrain_mesh", "[heightmap.bmp]", BenchTerrainMesh },
+	{ "terrain_kernel", "[heightmap.bmp]", BenchTerrainKernel },
+	{ "terrain_rtin", "[heightmap.bmp]", BenchTerrainRtin },
+	{ "terrain_raycast", "[heightmap.bmp]", BenchTerrainRaycast },
+	{ "terrain_noise", "[size]", BenchTerrainNoise },
+	{ "terrain_erosion", "[size...]", BenchTerrainErosion },
+	{ "image_layout", "[heightmap.bmp]", BenchImageLayout },
+	{ "frustum_cull", "[count]", BenchFrustumCull },
+	{ "image_stream", "[size]", BenchImageStream },
+	{ "image_mip", "[size]", BenchImageMip },
+	{ "terrain_stream", "[size]", BenchTerrainStream },
+	{ "image_bc", "[size [encode size]]", BenchImageBc },
+	{ "image_convert", "[size]", BenchImageConvert },
+	{ "terrain_horizon", "[size...]", BenchTerrainHorizon },
+};
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		int result = 0;
+		for (const bench_entry& bench : gBenches)
+		{
+			printf("== %s\n", bench.Name);
+			result |= bench.Run(0, nullptr);
+		}
+		return result;
+	}
+
+	for (const bench_entry& bench : gBenches)
+	{
+		if (strcmp(argv[1], bench.Name) == 0)
+		{
+			return bench.Run(argc - 2, argv + 2);
+		}
+	}
+
+	fprintf(stderr, "Unknown benchmark %s, available:\n", argv[1]);
+	for (const bench_entry& bench : gBenches)
+	{
+		fprintf(stderr, "  %s %s\n", bench.Name, bench.Usage);
+	}
+	return 1;
+}
@@ -0,0 +1,71 @@
+/*****************************************************************//**
+ * \file   bench_terrain_erosion.cpp
+ * \brief  Hydraulic and thermal erosion throughput against grid size
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_erosion.h"
+#include "thread_pool.h"
+
+// Iterations of every timed run, erosion keeps its state between runs
+#define BENCH_EROSION_ITERATIONS 4
+
+// Timed runs per measurement, fewer than BENCH_REPEATS as 8k grids are slow
+#define BENCH_EROSION_REPEATS 3
+
+int BenchTerrainErosion(int argc, char** argv)
+{
+	std::vector<uint32_t> sizes;
+	for (int i = 0; i < argc; i++)
+	{
+		sizes.push_back(strtoul(argv[i], nullptr, 10));
+		if (sizes.back() == 0)
+		{
+			fprintf(stderr, "Grid size must be positive\n");
+			return 1;
+		}
+	}
+	if (sizes.empty()) sizes = { 1024, 2048 };
+
+	WorkerPool& pool = WorkerPool::Default();
+	printf("%u iterations per run, %u hardware threads, pool of %u\n", BENCH_EROSION_ITERATIONS,
+		std::thread::hardware_concurrency(), pool.GetThreadCount());
+	printf("   size  pass       threads  ms/iteration  Mcells/s\n");
+
+	for (uint32_t size : sizes)
+	{
+		std::unique_ptr<HeightmapImage> heightmap = BenchHeightmap(size, size);
+		const double cells = static_cast<double>(size) * size;
+
+		const char* passes[] = { "hydraulic", "thermal" };
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (int parallel = 0; parallel < 2; parallel++)
+			{
+				// Fresh state, so both runs start from the same heights
+				TerrainErosion erosion(*heightmap);
+				WorkerPool* pPool = parallel ? &pool : nullptr;
+
+				double seconds = BenchSeconds([&]() {
+					if (pass == 0)
+						erosion.ErodeHydraulic(HydraulicErosionSettings(), BENCH_EROSION_ITERATIONS, pPool);
+					else
+						erosion.ErodeThermal(ThermalErosionSettings(), BENCH_EROSION_ITERATIONS, pPool);
+				}, BENCH_EROSION_REPEATS) / BENCH_EROSION_ITERATIONS;
+
+				printf("%7u  %-9s  %7s  %12.2f  %8.1f\n", size, passes[pass],
+					parallel ? std::to_string(pool.GetThreadCount()).c_str() : "serial",
+					seconds * 1e3, cells / seconds * 1e-6);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,79 @@
+/*****************************************************************//**
+ * \file   bench_terrain_horizon.cpp
+ * \brief  Horizon and ambient occlusion baking against heightmap size
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_horizon.h"
+#include "thread_pool.h"
+
+// Timed runs per measurement, fewer than BENCH_REPEATS as 4k maps take seconds
+#define BENCH_HORIZON_REPEATS 3
+
+int BenchTerrainHorizon(int argc, char** argv)
+{
+	std::vector<uint32_t> sizes;
+	for (int i = 0; i < argc; i++)
+	{
+		sizes.push_back(strtoul(argv[i], nullptr, 10));
+		if (sizes.back() < 4)
+		{
+			fprintf(stderr, "Heightmap size must be at least 4\n");
+			return 1;
+		}
+	}
+	if (sizes.empty()) sizes = { 1024, 2048, 4096 };
+
+	WorkerPool& pool = WorkerPool::Default();
+	const TerrainHorizonSettings settings;
+	printf("%u directions, %u hardware threads, pool of %u\n", settings.Directions,
+		std::thread::hardware_concurrency(), pool.GetThreadCount());
+	printf("   size  threads  heights ms    bake ms  ns/sample/direction  identical\n");
+
+	int result = 0;
+	for (uint32_t size : sizes)
+	{
+		std::unique_ptr<HeightmapImage> heightmap = BenchHeightmap(size, size);
+		const double work = static_cast<double>(size) * size * settings.Directions;
+
+		// Heights and their transposed copy, paid once per heightmap
+		const double heights = BenchSeconds([&]() { TerrainHorizonBaker baker(*heightmap); },
+			BENCH_HORIZON_REPEATS);
+
+		std::vector<uint8_t> serial;
+		for (int parallel = 0; parallel < 2; parallel++)
+		{
+			TerrainHorizonBaker baker(*heightmap);
+			WorkerPool* pPool = parallel ? &pool : nullptr;
+
+			const double seconds = BenchSeconds([&]() { baker.Bake(settings, pPool); }, BENCH_HORIZON_REPEATS);
+
+			const uint8_t* pOcclusion = baker.GetOcclusion();
+			const size_t count = static_cast<size_t>(size) * size;
+			bool identical = true;
+			if (parallel)
+			{
+				identical = memcmp(serial.data(), pOcclusion, count) == 0;
+				if (!identical) result = 1;
+			}
+			else
+			{
+				serial.assign(pOcclusion, pOcclusion + count);
+			}
+
+			printf("%7u  %7s  %10.2f  %9.2f  %19.2f  %s\n", size,
+				parallel ? std::to_string(pool.GetThreadCount()).c_str() : "serial",
+				heights * 1e3, seconds * 1e3, seconds * 1e9 / work, parallel ? (identical ? "yes" : "NO") : "-");
+		}
+	}
+
+	return result;
+}
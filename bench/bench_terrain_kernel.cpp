@@ -0,0 +1,147 @@
+/*****************************************************************//**
+ * \file   bench_terrain_kernel.cpp
+ * \brief  Heightmap row kernel against the per-vertex loop it replaced
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_kernel.h"
+
+using namespace DirectX;
+
+// Output of one pass over the heightmap, interior samples row after row
+struct terrain_rows
+{
+	std::vector<float> Height;
+	std::vector<float> NormalX;
+	std::vector<float> NormalY;
+	std::vector<float> NormalZ;
+
+	void Resize(size_t count)
+	{
+		Height.resize(count);
+		NormalX.resize(count);
+		NormalY.resize(count);
+		NormalZ.resize(count);
+	}
+};
+
+// The loop CreateTerrain ran before the kernel: five GetPixel calls and
+// an XMVector3Normalize per vertex
+static void PerVertexLoop(HeightmapImage& heightmap, float dx, float dz, terrain_rows& out)
+{
+	const int width = heightmap.GetWidth();
+	const int height = heightmap.GetHeight();
+
+	size_t k = 0;
+	for (int row = 1; row < height - 1; row++)
+	{
+		for (int col = 1; col < width - 1; col++, k++)
+		{
+			float dhRow = ((float)heightmap.GetPixel(row + 1, col) - (float)heightmap.GetPixel(row - 1, col)) * TERRAIN_HEIGHT_SCALE;
+			float dhCol = ((float)heightmap.GetPixel(row, col + 1) - (float)heightmap.GetPixel(row, col - 1)) * TERRAIN_HEIGHT_SCALE;
+
+			XMFLOAT3 n(-2 * dz * dhRow, 4 * dx * dz, -2 * dx * dhCol);
+			XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+
+			out.Height[k] = (float)heightmap.GetPixel(row, col) * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+			out.NormalX[k] = n.x;
+			out.NormalY[k] = n.y;
+			out.NormalZ[k] = n.z;
+		}
+	}
+}
+
+static void KernelRows(HeightmapImage& heightmap, float dx, float dz, SIMD_LEVEL level, terrain_rows& out)
+{
+	const uint32_t width = heightmap.GetWidth();
+	const uint32_t height = heightmap.GetHeight();
+	const uint32_t count = width - 2;
+
+	for (uint32_t row = 1; row < height - 1; row++)
+	{
+		const uint8_t* pRow = heightmap.GetRow(row) + 1;
+		size_t k = static_cast<size_t>(row - 1) * count;
+
+		ComputeTerrainRow(pRow - heightmap.GetRowPitch(), pRow, pRow + heightmap.GetRowPitch(),
+			count, dx, dz, &out.Height[k], &out.NormalX[k], &out.NormalY[k], &out.NormalZ[k], level);
+	}
+}
+
+static bool SameRows(const terrain_rows& a, const terrain_rows& b)
+{
+	const size_t bytes = a.Height.size() * sizeof(float);
+	return memcmp(a.Height.data(), b.Height.data(), bytes) == 0 &&
+		memcmp(a.NormalX.data(), b.NormalX.data(), bytes) == 0 &&
+		memcmp(a.NormalY.data(), b.NormalY.data(), bytes) == 0 &&
+		memcmp(a.NormalZ.data(), b.NormalZ.data(), bytes) == 0;
+}
+
+static float MaxNormalDifference(const terrain_rows& a, const terrain_rows& b)
+{
+	float difference = 0.0f;
+	for (size_t k = 0; k < a.Height.size(); k++)
+	{
+		difference = (std::max)(difference, std::fabs(a.NormalX[k] - b.NormalX[k]));
+		difference = (std::max)(difference, std::fabs(a.NormalY[k] - b.NormalY[k]));
+		difference = (std::max)(difference, std::fabs(a.NormalZ[k] - b.NormalZ[k]));
+	}
+	return difference;
+}
+
+int BenchTerrainKernel(int argc, char** argv)
+{
+	std::unique_ptr<HeightmapImage> heightmap = BenchLoadHeightmap(argc, argv);
+
+	const uint32_t width = heightmap->GetWidth();
+	const uint32_t height = heightmap->GetHeight();
+	const float dx = (float)width / (width - 1);
+	const float dz = (float)height / (height - 1);
+	const double samples = static_cast<double>(width - 2) * (height - 2);
+
+	printf("%ux%u heightmap, %.0f interior samples\n", width, height, samples);
+	printf("path              ms  Msamples/s  speedup  bit-identical\n");
+
+	terrain_rows loop;
+	loop.Resize(static_cast<size_t>(samples));
+	double loopSeconds = BenchSeconds([&]() { PerVertexLoop(*heightmap, dx, dz, loop); });
+	printf("per-vertex   %7.2f  %10.1f  %7.2f  -\n", loopSeconds * 1e3, samples / loopSeconds * 1e-6, 1.0);
+
+	int result = 0;
+	terrain_rows scalar;
+	const char* names[] = { "scalar", "sse4.1", "avx2" };
+
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		terrain_rows rows;
+		rows.Resize(static_cast<size_t>(samples));
+
+		double seconds = BenchSeconds([&]() { KernelRows(*heightmap, dx, dz, (SIMD_LEVEL)level, rows); });
+
+		bool identical = true;
+		if (level == SIMD_LEVEL_SCALAR)
+		{
+			scalar = rows;
+		}
+		else
+		{
+			identical = SameRows(rows, scalar);
+			if (!identical) result = 1;
+		}
+
+		printf("kernel %-6s %7.2f  %10.1f  %7.2f  %s\n", names[level], seconds * 1e3,
+			samples / seconds * 1e-6, loopSeconds / seconds, identical ? "yes" : "NO");
+	}
+
+	// Only rounding separates the kernel from XMVector3Normalize
+	printf("largest normal difference to the per-vertex loop: %g\n", MaxNormalDifference(loop, scalar));
+
+	return result;
+}
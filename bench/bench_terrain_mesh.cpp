@@ -0,0 +1,56 @@
+/*****************************************************************//**
+ * \file   bench_terrain_mesh.cpp
+ * \brief  Terrain mesh generation against thread count
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_mesh.h"
+#include "thread_pool.h"
+
+static bool SameMesh(const TerrainMeshData& a, const TerrainMeshData& b)
+{
+	return a.Vertices.size() == b.Vertices.size() && a.Indices.size() == b.Indices.size() &&
+		memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size() * sizeof(Vertex)) == 0 &&
+		memcmp(a.Indices.data(), b.Indices.data(), a.Indices.size() * sizeof(uint16_t)) == 0;
+}
+
+int BenchTerrainMesh(int argc, char** argv)
+{
+	std::unique_ptr<HeightmapImage> heightmap = BenchLoadHeightmap(argc, argv);
+	TerrainLayout layout(heightmap->GetWidth(), heightmap->GetHeight());
+
+	// Serial path is the reference every thread count must match
+	TerrainMeshData reference;
+	double serial = BenchSeconds([&]() { BuildTerrainMesh(*heightmap, layout, reference, nullptr); });
+
+	const double vertices = static_cast<double>(reference.Vertices.size());
+	printf("%ux%u heightmap, %zu vertices, %zu indices, %u hardware threads\n",
+		heightmap->GetWidth(), heightmap->GetHeight(), reference.Vertices.size(),
+		reference.Indices.size(), std::thread::hardware_concurrency());
+	printf("threads      ms   Mverts/s  identical\n");
+	printf(" serial %7.2f %10.1f  -\n", serial * 1e3, vertices / serial * 1e-6);
+
+	int result = 0;
+	const uint32_t threadCounts[] = { 1, 2, 4, 8, 16 };
+	for (uint32_t threads : threadCounts)
+	{
+		WorkerPool pool(threads);
+
+		TerrainMeshData mesh;
+		double seconds = BenchSeconds([&]() { BuildTerrainMesh(*heightmap, layout, mesh, &pool); });
+
+		bool identical = SameMesh(mesh, reference);
+		if (!identical) result = 1;
+
+		printf("%7u %7.2f %10.1f  %s\n", threads, seconds * 1e3, vertices / seconds * 1e-6,
+			identical ? "yes" : "NO");
+	}
+
+	return result;
+}
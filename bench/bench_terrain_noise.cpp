@@ -0,0 +1,99 @@
+/*****************************************************************//**
+ * \file   bench_terrain_noise.cpp
+ * \brief  Procedural heightmap generation at every SIMD level and
+ *         against thread count
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_noise.h"
+#include "thread_pool.h"
+
+// Rows of the kernel measurement, BENCH_HEIGHTMAP_SIZE samples each
+#define BENCH_NOISE_ROWS 256
+
+static bool SameImage(HeightmapImage& a, HeightmapImage& b)
+{
+	for (uint32_t row = 0; row < a.GetHeight(); row++)
+	{
+		if (memcmp(a.GetRow(row), b.GetRow(row), a.GetWidth()) != 0) return false;
+	}
+	return true;
+}
+
+int BenchTerrainNoise(int argc, char** argv)
+{
+	const uint32_t size = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_HEIGHTMAP_SIZE;
+	if (size == 0)
+	{
+		fprintf(stderr, "Heightmap size must be positive\n");
+		return 1;
+	}
+
+	// Defaults of -generate, one simplex fBm layer
+	const TerrainNoiseSettings settings;
+	uint32_t octaves = 0;
+	for (const TerrainNoiseLayer& layer : settings.Layers) octaves += layer.Octaves;
+
+	int result = 0;
+	const char* names[] = { "scalar", "sse4.1", "avx2" };
+
+	// Noise kernel on one thread, every level matches the scalar one
+	const uint32_t width = BENCH_HEIGHTMAP_SIZE;
+	std::vector<float> reference(static_cast<size_t>(width) * BENCH_NOISE_ROWS);
+	std::vector<float> heights(reference.size());
+
+	printf("%u octaves, kernel over %u x %u samples\n", octaves, width, BENCH_NOISE_ROWS);
+	printf("level    ms      ns/sample/octave  bit-identical\n");
+
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		std::vector<float>& out = level == SIMD_LEVEL_SCALAR ? reference : heights;
+		double seconds = BenchSeconds([&]() {
+			for (uint32_t row = 0; row < BENCH_NOISE_ROWS; row++)
+			{
+				EvaluateTerrainNoise(settings, row, 0, width, &out[static_cast<size_t>(row) * width],
+					(SIMD_LEVEL)level);
+			}
+		});
+
+		const bool identical = level == SIMD_LEVEL_SCALAR ||
+			memcmp(heights.data(), reference.data(), heights.size() * sizeof(float)) == 0;
+		if (!identical) result = 1;
+
+		printf("%-6s %7.2f  %16.2f  %s\n", names[level], seconds * 1e3,
+			seconds * 1e9 / (static_cast<double>(out.size()) * octaves),
+			level == SIMD_LEVEL_SCALAR ? "-" : (identical ? "yes" : "NO"));
+	}
+
+	// Whole heightmaps at the best level, every pool matches the serial run
+	HeightmapImage serialImage(size, size);
+	HeightmapImage poolImage(size, size);
+	double serial = BenchSeconds([&]() { GenerateTerrainHeightmap(settings, serialImage, nullptr); });
+
+	const double samples = static_cast<double>(size) * size;
+	printf("%ux%u heightmap, %u hardware threads\n", size, size, std::thread::hardware_concurrency());
+	printf("threads      ms   Msamples/s  identical\n");
+	printf(" serial %8.2f %11.1f  -\n", serial * 1e3, samples / serial * 1e-6);
+
+	const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+	for (uint32_t threads : threadCounts)
+	{
+		WorkerPool pool(threads);
+		double seconds = BenchSeconds([&]() { GenerateTerrainHeightmap(settings, poolImage, &pool); });
+
+		const bool identical = SameImage(poolImage, serialImage);
+		if (!identical) result = 1;
+
+		printf("%7u %8.2f %11.1f  %s\n", threads, seconds * 1e3, samples / seconds * 1e-6,
+			identical ? "yes" : "NO");
+	}
+
+	return result;
+}
@@ -0,0 +1,154 @@
+/*****************************************************************//**
+ * \file   bench_terrain_raycast.cpp
+ * \brief  Ray casts through the min/max height pyramid against the
+ *         DDA march over every quad
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_raycast.h"
+#include "thread_pool.h"
+
+using namespace DirectX;
+
+// Rays of every set
+#define BENCH_RAYCAST_RAYS 20000
+
+// Difference of T the two casts may have from rounding
+#define BENCH_RAYCAST_TOLERANCE 1e-4f
+
+enum BENCH_RAY_SET
+{
+	BENCH_RAY_GRAZING = 0,		// Almost horizontal, line of sight and camera collision
+	BENCH_RAY_PICKING = 1,		// From above the terrain to a point on it
+	BENCH_RAY_VERTICAL = 2		// Straight down, height queries
+};
+
+// Deterministic rays over the grid, heights between minHeight and maxHeight
+static void MakeRays(const TerrainLayout& layout, BENCH_RAY_SET set, float minHeight,
+	float maxHeight, std::vector<TerrainRay>& rays)
+{
+	const float minX = layout.WorldX(1);
+	const float maxX = layout.WorldX(layout.GridRows());
+	const float minZ = layout.WorldZ(layout.GridColumns());
+	const float maxZ = layout.WorldZ(1);
+	const float extent = (std::max)(maxX - minX, maxZ - minZ);
+	const float range = (std::max)(maxHeight - minHeight, 1e-3f);
+
+	uint32_t state = 4242;
+	auto next = [&state]() {
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float>(state >> 8) / 16777216.0f;
+	};
+
+	rays.resize(BENCH_RAYCAST_RAYS);
+	for (TerrainRay& ray : rays)
+	{
+		ray.Origin = XMFLOAT3(minX + next() * (maxX - minX), 0.0f, minZ + next() * (maxZ - minZ));
+
+		if (set == BENCH_RAY_GRAZING)
+		{
+			// Descends through the whole height range over half the terrain
+			const float angle = next() * 6.2831853f;
+			ray.Origin.y = maxHeight + 0.05f * range;
+			ray.Direction = XMFLOAT3(cosf(angle), -range / (0.5f * extent), sinf(angle));
+		}
+		else if (set == BENCH_RAY_PICKING)
+		{
+			ray.Origin.y = maxHeight + 0.1f * extent;
+			const XMFLOAT3 target(minX + next() * (maxX - minX), minHeight,
+				minZ + next() * (maxZ - minZ));
+			ray.Direction = XMFLOAT3(target.x - ray.Origin.x, target.y - ray.Origin.y,
+				target.z - ray.Origin.z);
+		}
+		else
+		{
+			ray.Origin.y = maxHeight + range;
+			ray.Direction = XMFLOAT3(0.0f, -1.0f, 0.0f);
+		}
+	}
+}
+
+// Rays through an edge or a corner hit the quads sharing it at the same
+// T, either of them may be reported
+static bool SameHit(const TerrainRayHit& a, const TerrainRayHit& b)
+{
+	if (a.Hit != b.Hit) return false;
+	if (!a.Hit) return true;
+
+	return (std::max)(a.Row, b.Row) - (std::min)(a.Row, b.Row) <= 1 &&
+		(std::max)(a.Col, b.Col) - (std::min)(a.Col, b.Col) <= 1 &&
+		std::fabs(a.T - b.T) <= BENCH_RAYCAST_TOLERANCE * (std::max)(1.0f, a.T);
+}
+
+int BenchTerrainRaycast(int argc, char** argv)
+{
+	std::unique_ptr<HeightmapImage> heightmap = BenchLoadHeightmap(argc, argv);
+	TerrainLayout layout(heightmap->GetWidth(), heightmap->GetHeight());
+
+	std::vector<float> heights;
+	ExtractTerrainHeights(*heightmap, layout, heights);
+	const float minHeight = *std::min_element(heights.begin(), heights.end());
+	const float maxHeight = *std::max_element(heights.begin(), heights.end());
+
+	WorkerPool& pool = WorkerPool::Default();
+
+	std::unique_ptr<TerrainHeightPyramid> pyramid;
+	double build = BenchSeconds([&]() {
+		pyramid.reset(new TerrainHeightPyramid(heights.data(), layout, &pool));
+	});
+
+	printf("%ux%u heightmap, %u rays per set, %u hardware threads, pool of %u\n",
+		heightmap->GetWidth(), heightmap->GetHeight(), BENCH_RAYCAST_RAYS,
+		std::thread::hardware_concurrency(), pool.GetThreadCount());
+	printf("pyramid of %u levels built in %.2f ms\n", pyramid->GetLevelCount(), build * 1e3);
+	printf("rays      DDA us/ray  pyramid us/ray  speedup  batch us/ray  hits    identical\n");
+
+	const char* names[] = { "grazing", "picking", "vertical" };
+	const BENCH_RAY_SET sets[] = { BENCH_RAY_GRAZING, BENCH_RAY_PICKING, BENCH_RAY_VERTICAL };
+
+	int result = 0;
+	std::vector<TerrainRay> rays;
+	std::vector<TerrainRayHit> ddaHits(BENCH_RAYCAST_RAYS);
+	std::vector<TerrainRayHit> pyramidHits(BENCH_RAYCAST_RAYS);
+	std::vector<TerrainRayHit> batchHits(BENCH_RAYCAST_RAYS);
+
+	for (int s = 0; s < 3; s++)
+	{
+		MakeRays(layout, sets[s], minHeight, maxHeight, rays);
+
+		double dda = BenchSeconds([&]() {
+			for (size_t i = 0; i < rays.size(); i++) pyramid->RaycastDDA(rays[i], ddaHits[i]);
+		});
+		double serial = BenchSeconds([&]() {
+			for (size_t i = 0; i < rays.size(); i++) pyramid->Raycast(rays[i], pyramidHits[i]);
+		});
+		double batch = BenchSeconds([&]() {
+			pyramid->RaycastBatch(rays.data(), rays.size(), batchHits.data(), &pool);
+		});
+
+		size_t hitCount = 0;
+		bool identical = true;
+		for (size_t i = 0; i < rays.size(); i++)
+		{
+			hitCount += ddaHits[i].Hit;
+			identical = identical && SameHit(ddaHits[i], pyramidHits[i]) &&
+				SameHit(pyramidHits[i], batchHits[i]);
+		}
+		if (!identical) result = 1;
+
+		const double perRay = 1e6 / rays.size();
+		printf("%-8s  %10.2f  %14.2f  %7.2f  %12.2f  %5.1f%%  %s\n", names[s],
+			dda * perRay, serial * perRay, dda / serial, batch * perRay,
+			100.0 * hitCount / rays.size(), identical ? "yes" : "NO");
+	}
+
+	return result;
+}
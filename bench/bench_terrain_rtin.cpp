@@ -0,0 +1,51 @@
+/*****************************************************************//**
+ * \file   bench_terrain_rtin.cpp
+ * \brief  RTIN simplification: triangles, measured error and time
+ *         against the error bound
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <vector>
+
+#include "bench.h"
+#include "bench_util.h"
+#include "terrain_rtin.h"
+
+// Rounding of the interpolated heights, far below a height step
+#define BENCH_RTIN_TOLERANCE 1e-4f
+
+int BenchTerrainRtin(int argc, char** argv)
+{
+	std::unique_ptr<HeightmapImage> heightmap = BenchLoadHeightmap(argc, argv);
+	TerrainLayout layout(heightmap->GetWidth(), heightmap->GetHeight());
+
+	// Error pass over the padded grid, done once per heightmap
+	std::unique_ptr<TerrainRtin> rtin;
+	double buildSeconds = BenchSeconds([&]() { rtin.reset(new TerrainRtin(*heightmap, layout)); });
+
+	const double fullTriangles = 2.0 * (layout.GridRows() - 1) * (layout.GridColumns() - 1);
+	printf("%ux%u heightmap, padded to %u, errors computed in %.2f ms\n",
+		heightmap->GetWidth(), heightmap->GetHeight(), rtin->GetSize(), buildSeconds * 1e3);
+	printf("  bound  extract ms  triangles  of full  vertices  measured  within\n");
+
+	int result = 0;
+	const float bounds[] = { 0.0f, 0.01f, 0.02f, 0.05f, 0.1f, 0.25f, 0.5f, 1.0f };
+
+	for (float bound : bounds)
+	{
+		TerrainRtinMesh mesh;
+		double seconds = BenchSeconds([&]() { rtin->Extract(bound, mesh); });
+
+		const float measured = rtin->MeasureError(mesh);
+		const bool within = measured <= bound + BENCH_RTIN_TOLERANCE;
+		if (!within) result = 1;
+
+		const size_t triangles = mesh.Indices.size() / 3;
+		printf("%7.2f  %10.2f  %9zu  %6.1f%%  %8zu  %8.4f  %s\n", bound, seconds * 1e3,
+			triangles, 100.0 * triangles / fullTriangles, mesh.Vertices.size(), measured,
+			within ? "yes" : "NO");
+	}
+
+	return result;
+}
@@ -0,0 +1,177 @@
+/*****************************************************************//**
+ * \file   bench_terrain_stream.cpp
+ * \brief  Streaming of a heightmap larger than memory, resident memory
+ *         while the camera crosses it
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdlib>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "bench.h"
+#include "bench_util.h"
+#include "image_stream.h"
+#include "terrain_stream.h"
+
+// Side of the heightmap when no size is given, 4 GiB of samples
+#define BENCH_STREAM_TERRAIN_SIZE 65536
+
+#define BENCH_STREAM_TERRAIN_FILE "bench_terrain_stream.bmp"
+
+// Frames the camera takes to cross the heightmap along its diagonal
+#define BENCH_STREAM_FRAMES 1024
+
+// Growth of resident memory while streaming that fails the benchmark,
+// the tile cache, chunk meshes and staging take a few MiB
+#define BENCH_STREAM_RESIDENT_LIMIT (64ull << 20)
+
+// Resident bytes of the process now and at its peak
+static void ResidentBytes(uint64_t& current, uint64_t& peak)
+{
+	current = 0;
+	peak = 0;
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = { };
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		current = counters.WorkingSetSize;
+		peak = counters.PeakWorkingSetSize;
+	}
+#else
+	FILE* pFile = fopen("/proc/self/statm", "r");
+	if (pFile)
+	{
+		unsigned long long pages = 0, resident = 0;
+		if (fscanf(pFile, "%llu %llu", &pages, &resident) == 2)
+		{
+			current = resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+		}
+		fclose(pFile);
+	}
+
+	// Kilobytes on Linux
+	rusage usage = { };
+	if (getrusage(RUSAGE_SELF, &usage) == 0) peak = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// Writes the heightmap in bands, hills large enough to span many
+// chunks. 0 - success, -1 - error
+static int WriteHeightmap(uint32_t size)
+{
+	bmp_band_writer writer;
+	if (writer.open(BENCH_STREAM_TERRAIN_FILE, size, size, IMAGE_COLOR_MODE_GRAYSCALE, 256) != 0) return -1;
+
+	uint32_t firstRow, rows;
+	while (uint8_t* pBand = writer.band(firstRow, rows))
+	{
+		for (uint32_t r = 0; r < rows; r++)
+		{
+			const uint32_t row = firstRow + r;
+			uint8_t* pRow = pBand + r * writer.row_pitch();
+			for (uint32_t col = 0; col < size; col++)
+			{
+				pRow[col] = static_cast<uint8_t>(((row / 3 + col / 5) & 255) ^ ((row / 17) & 63));
+			}
+		}
+		if (writer.commit_band() != 0) return -1;
+	}
+
+	return writer.close();
+}
+
+int BenchTerrainStream(int argc, char** argv)
+{
+	const uint32_t size = argc > 0 ? strtoul(argv[0], nullptr, 10) : BENCH_STREAM_TERRAIN_SIZE;
+	if (size < 4 || size % 4 != 0)
+	{
+		fprintf(stderr, "Heightmap size must be a multiple of 4, at least 4\n");
+		return 1;
+	}
+
+	const double fileMiB = static_cast<double>(size) * size / (1 << 20);
+	printf("%ux%u heightmap, %.1f MiB\n", size, size, fileMiB);
+
+	int status = 0;
+	const double writeSeconds = BenchSeconds([&]() { status = WriteHeightmap(size); }, 1);
+	if (status != 0)
+	{
+		remove(BENCH_STREAM_TERRAIN_FILE);
+		return 1;
+	}
+
+	uint64_t before, peak;
+	ResidentBytes(before, peak);
+
+	int result = 0;
+	{
+		HeightmapTileCache cache(TERRAIN_STREAM_TILE_CAPACITY);
+		if (cache.Open(BENCH_STREAM_TERRAIN_FILE) != 0)
+		{
+			remove(BENCH_STREAM_TERRAIN_FILE);
+			return 1;
+		}
+
+		TerrainStreamSlots slots(cache);
+		TerrainStreamGround ground(cache);
+		const TerrainLayout& layout = ground.GetLayout();
+
+		std::vector<uint8_t> staging((size_t)TERRAIN_STREAM_UPLOADS_PER_FRAME * TERRAIN_STREAM_SLOT_BYTES);
+		std::vector<TerrainStreamCopy> copies;
+		uint64_t uploads = 0;
+		uint64_t current = before;
+		uint64_t streamPeak = before;
+		float heightSum = 0.0f;
+
+		// Corner to corner, the background threads finish every frame
+		// so the result does not depend on their speed
+		const double seconds = BenchSeconds([&]() {
+			for (int frame = 0; frame <= BENCH_STREAM_FRAMES; frame++)
+			{
+				const float t = static_cast<float>(frame) / BENCH_STREAM_FRAMES;
+				DirectX::XMFLOAT3 eye;
+				eye.x = layout.WorldX(0) + t * (layout.WorldX(layout.Depth - 1) - layout.WorldX(0));
+				eye.z = layout.WorldZ(0) + t * (layout.WorldZ(layout.Width - 1) - layout.WorldZ(0));
+				eye.y = ground.GetHeight(eye.x, eye.z) + 1.5f;
+				heightSum += eye.y;
+
+				slots.Update(eye);
+				slots.GetStreamer().WaitIdle();
+				slots.Update(eye);
+				uploads += slots.PrepareUpload(staging.data(), TERRAIN_STREAM_UPLOADS_PER_FRAME, copies);
+
+				ResidentBytes(current, peak);
+				streamPeak = (std::max)(streamPeak, current);
+			}
+		}, 1);
+
+		// Process peak includes writing the file
+		ResidentBytes(current, peak);
+
+		const double growthMiB = (static_cast<double>(streamPeak) - before) / (1 << 20);
+		if (streamPeak - before > BENCH_STREAM_RESIDENT_LIMIT) result = 1;
+
+		printf("written in %.1f s, %d frames crossed in %.1f s\n", writeSeconds, BENCH_STREAM_FRAMES,
+			seconds);
+		printf("%llu chunks uploaded, %llu tile loads, mean eye height %.1f\n",
+			(unsigned long long)uploads, (unsigned long long)cache.GetTileLoads(),
+			heightSum / (BENCH_STREAM_FRAMES + 1));
+		printf("resident MiB  before  streaming peak  growth  process peak  file\n");
+		printf("              %6.1f  %14.1f  %6.1f  %12.1f  %.1f%s\n",
+			before / 1048576.0, streamPeak / 1048576.0, growthMiB, peak / 1048576.0, fileMiB,
+			result ? ", growth over the limit" : "");
+	}
+
+	remove(BENCH_STREAM_TERRAIN_FILE);
+	return result;
+}
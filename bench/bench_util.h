@@ -0,0 +1,75 @@
+/*****************************************************************//**
+ * \file   bench_util.h
+ * \brief  Timing and input helpers shared by the benchmarks
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "image_helper.h"
+
+// Timed runs of every measurement, the fastest one is reported
+#define BENCH_REPEATS 5
+
+// Side of the synthetic heightmap used when no file is given
+#define BENCH_HEIGHTMAP_SIZE 2048
+
+// Seconds of the fastest of repeats calls to func
+template<typename TFunc>
+double BenchSeconds(TFunc func, int repeats = BENCH_REPEATS)
+{
+	double best = 1e30;
+
+	for (int i = 0; i < repeats; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		func();
+		auto end = std::chrono::steady_clock::now();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+		if (seconds < best) best = seconds;
+	}
+
+	return best;
+}
+
+// Deterministic rolling hills, so runs on different machines mesh
+// the same heights
+inline std::unique_ptr<HeightmapImage> BenchHeightmap(uint32_t width, uint32_t height)
+{
+	std::unique_ptr<HeightmapImage> heightmap(new HeightmapImage(width, height));
+
+	uint32_t state = 12345;
+	for (uint32_t row = 0; row < height; row++)
+	{
+		uint8_t* pRow = heightmap->GetWritableRow(row);
+		for (uint32_t col = 0; col < width; col++)
+		{
+			// Smooth base with a little noise, like a real terrain
+			state = state * 1664525u + 1013904223u;
+			uint32_t hills = ((row * 7 + col * 3) & 255) ^ ((row / 5 + col / 3) & 127);
+			pRow[col] = static_cast<uint8_t>((hills + (state >> 29)) & 255);
+		}
+	}
+
+	return heightmap;
+}
+
+// Heightmap named by the first argument, a synthetic one without arguments
+inline std::unique_ptr<HeightmapImage> BenchLoadHeightmap(int argc, char** argv)
+{
+	if (argc > 0)
+	{
+		return std::unique_ptr<HeightmapImage>(new HeightmapImage(argv[0]));
+	}
+
+	return BenchHeightmap(BENCH_HEIGHTMAP_SIZE, BENCH_HEIGHTMAP_SIZE);
+}
@@ -171,6 +171,55 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
     return defaultBuffer;
 }
 
+Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
+    ID3D12Device* device,
+    ID3D12GraphicsCommandList* cmdList,
+    UINT64 byteSize,
+    _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer,
+    const std::function<void(uint8_t* pData)>& fill)
+{
+    ComPtr<ID3D12Resource> defaultBuffer = nullptr;
+
+    const D3D12_HEAP_PROPERTIES defaultHeap =
+        HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    const D3D12_HEAP_PROPERTIES uploadHeap =
+        HeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+
+    const D3D12_RESOURCE_DESC bufferDesc = BufferDesc(byteSize);
+
+    ThrowIfFailed(device->CreateCommittedResource(
+        &defaultHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_COMMON,
+        nullptr,
+        IID_PPV_ARGS(defaultBuffer.GetAddressOf())));
+    ThrowIfFailed(device->CreateCommittedResource(
+        &uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
+
+    // The CPU only writes, nothing is read back
+    const D3D12_RANGE readRange = { 0, 0 };
+    uint8_t* pData = nullptr;
+    ThrowIfFailed(uploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pData)));
+    fill(pData);
+    uploadBuffer->Unmap(0, nullptr);
+
+    Transition(defaultBuffer.Get(),
+        cmdList,
+        D3D12_RESOURCE_STATE_COMMON,
+        D3D12_RESOURCE_STATE_COPY_DEST);
+
+    cmdList->CopyBufferRegion(defaultBuffer.Get(), 0, uploadBuffer.Get(), 0, byteSize);
+
+    Transition(defaultBuffer.Get(),
+        cmdList,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        D3D12_RESOURCE_STATE_GENERIC_READ);
+
+    return defaultBuffer;
+}
+
 inline void MemcpySubresource(
     _In_ const D3D12_MEMCPY_DEST* pDest,
     _In_ const D3D12_SUBRESOURCE_DATA* pSrc,
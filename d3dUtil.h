@@ -8,7 +8,9 @@
 #pragma once
 
 #include <d3d12.h>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <wrl.h>
@@ -79,6 +81,16 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
     UINT64 byteSize,
     _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
 
+// Same as above, but fill writes the byteSize bytes straight into the
+// mapped upload buffer, so data spread over several places or converted
+// on the way needs no intermediate copy.
+Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
+    ID3D12Device* device,
+    ID3D12GraphicsCommandList* cmdList,
+    UINT64 byteSize,
+    _Out_ Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer,
+    const std::function<void(uint8_t* pData)>& fill);
+
 // Memory management
 
 inline void MemcpySubresource(
@@ -9,10 +9,14 @@
  */
 class D3DApplication : public D3DBase
 {
+	const TerrainOptions								mOptions;
+
 	std::unique_ptr<StaticResources>					pStaticResources = nullptr;
 	std::unique_ptr<DynamicResources>					pDynamicResources = nullptr;
 
 	Shader												mDefaultShader;
+	Shader												mPackedShader;		// Reads PackedVertex
+	Shader												mTerrainLodShader;	// Places the LOD patch over the heightmap
 
 	// An array of pipeline states
 	static const int									gNumRenderModes = 3;
@@ -20,6 +24,9 @@ class D3DApplication : public D3DBase
 	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mDefaultPSO = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mLinePSO = nullptr;
 	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mBlendPSO = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mPackedPSO = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mPackedBlendPSO = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState>			mTerrainLodPSO = nullptr;
 
 	std::unique_ptr<Camera>								mCamera = nullptr;
 
@@ -28,12 +35,31 @@ class D3DApplication : public D3DBase
 
 	DirectX::XMFLOAT4X4 mProj = MathHelper::Identity4x4();
 
+	// Submeshes of the default geometry inside the view frustum
+	Frustum mViewFrustum;
+	FrustumCuller mCuller;
+	std::vector<uint8_t> mVisible;
+
+	// Quadtree nodes drawn this frame, TERRAIN_RENDER_LOD only
+	std::vector<TerrainLodDraw> mLodDraws;
+
+	// Streamed chunks inside the view frustum, TERRAIN_RENDER_STREAM only
+	std::vector<SubmeshGeometry> mStreamDraws;
+
+	// Direction to the sun, azimuth from +X towards -Z and elevation
+	float mSunAzimuth = 1.5f * DirectX::XM_PI;
+	float mSunElevation = 0.6435f;
+
+public:
+	explicit D3DApplication(const TerrainOptions& options) : mOptions(options) { }
+
 private:
 	void D3DBase::InitializeComponents() override
 	{
 		LoadResources();
 		mCamera = std::make_unique<Camera>(DirectX::XMVectorSet(5.0f, 2.0f, 5.0f, 1.0f),
 			DirectX::XM_PI * 7 / 4, -0.2f, mTimer.get());
+		mCamera->SetGround(pStaticResources->GetGround(), 1.5f);
 
 		// temp
 		D3DHelper::CreateDefaultRootSignature(md3dDevice.Get(), mDefaultShader.mRootSignature.GetAddressOf());
@@ -48,8 +74,15 @@ private:
 	void BuildPSO();							// Configures rendering pipeline
 
 	void DrawRenderItems();						// Draw every render item
+	void DrawTerrainLod();						// Draws the selected LOD nodes
+	void DrawTerrainStream();					// Draws the streamed chunks in view
 
 	void UpdatePassCB();						// Update and store in CB pass constants
+	void UpdateTerrainEdits();					// Applies brushes under the camera
+	void UpdateTerrainStream();					// Streams chunks around the camera
+	void UpdateSun();							// Moves the sun with the arrow keys
+	void UpdateCullingBounds();					// Copies submesh bounds to the culler
+	void CullRenderItems();						// Tests submeshes against the view frustum
 
 	void Update() override;
 	void Draw() override;
@@ -12,6 +12,7 @@
 #include <Windows.h>
 
 #include "MathHelper.h"
+#include "terrain_sampler.h"
 #include "timer.h"
 
 class Camera
@@ -64,8 +65,18 @@ private:
 	float mSpeedZ = 0.0f;
 	float mSpeedX = 0.0f;
 
+	// Ground the camera is kept above, nullptr flies freely
+	const TerrainGround* mpGround = nullptr;
+	float mEyeHeight = 0.0f;
+
 	Timer* mTimer = nullptr;
 public:
+	void SetGround(const TerrainGround* pGround, float eyeHeight)
+	{
+		mpGround = pGround;
+		mEyeHeight = eyeHeight;
+	}
+
 	void OnMouseMove(int mouseX, int mouseY)
 	{
 		float dPhi = DirectX::XMConvertToRadians(
@@ -115,6 +126,20 @@ public:
 				DirectX::XMVectorScale(direction, mSpeedZ * mTimer->DeltaTime()),
 				DirectX::XMVectorScale(left, -mSpeedX * mTimer->DeltaTime())));
 
+		// Keep the eye above the terrain
+		if (mpGround)
+		{
+			DirectX::XMFLOAT4 p;
+			DirectX::XMStoreFloat4(&p, position);
+
+			float minY = mpGround->GetHeight(p.x, p.z) + mEyeHeight;
+			if (p.y < minY)
+			{
+				p.y = minY;
+				position = DirectX::XMLoadFloat4(&p);
+			}
+		}
+
 		// Return speed to equilibrium
 		mSpeedX *= 0.95f;
 		mSpeedZ *= 0.95f;
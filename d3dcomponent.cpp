@@ -217,7 +217,7 @@ namespace D3DHelper
 	void CreateDefaultRootSignature(ID3D12Device* pDevice, ID3D12RootSignature** ppRootSignature)
 	{
 		// Root parameter can be a table, root descriptor or root constants.
-		D3D12_ROOT_PARAMETER slotRootParameters[4] = { };
+		D3D12_ROOT_PARAMETER slotRootParameters[6] = { };
 
 		// Pass CBV will be bound to b0
 		D3D12_ROOT_DESCRIPTOR perPassCBV = { };
@@ -244,6 +244,19 @@ namespace D3DHelper
 		srvTable.pDescriptorRanges = &srvDescriptorRange;
 		srvTable.NumDescriptorRanges = 1;
 
+		// Terrain maps are in register space 1, set once per frame
+		D3D12_ROOT_DESCRIPTOR_TABLE terrainMapTable = { };
+
+		D3D12_DESCRIPTOR_RANGE terrainMapRange = { };
+		terrainMapRange.BaseShaderRegister = 0;
+		terrainMapRange.NumDescriptors = NUM_TERRAIN_MAPS;
+		terrainMapRange.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+		terrainMapRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+		terrainMapRange.RegisterSpace = 1;
+
+		terrainMapTable.pDescriptorRanges = &terrainMapRange;
+		terrainMapTable.NumDescriptorRanges = 1;
+
 		slotRootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		slotRootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 		slotRootParameters[0].Descriptor = perPassCBV;
@@ -260,29 +273,49 @@ namespace D3DHelper
 		slotRootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 		slotRootParameters[3].DescriptorTable = srvTable;
 
+		slotRootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+		slotRootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		slotRootParameters[4].DescriptorTable = terrainMapTable;
+
+		// Node of a terrain LOD draw, set per draw
+		slotRootParameters[5].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+		slotRootParameters[5].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+		slotRootParameters[5].Constants.ShaderRegister = 3;
+		slotRootParameters[5].Constants.RegisterSpace = 0;
+		slotRootParameters[5].Constants.Num32BitValues = sizeof(TerrainPatchConstants) / 4;
+
 		// Create static samplers
 
-		D3D12_STATIC_SAMPLER_DESC samplerDesc = { };
-		samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-		samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-		samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-		samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-		samplerDesc.MinLOD = 0;
-		samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
-		samplerDesc.MipLODBias = 0.0f;
-		samplerDesc.MaxAnisotropy = 1;
-		samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-		samplerDesc.BorderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK;
-		samplerDesc.RegisterSpace = 0;
-		samplerDesc.ShaderRegister = 0;
-		samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		// s0 wraps, s1 clamps maps that cover the terrain once, so the
+		// border texels do not blend with the opposite edge
+		D3D12_STATIC_SAMPLER_DESC samplerDescs[2] = { };
+		for (UINT i = 0; i < _countof(samplerDescs); i++)
+		{
+			const D3D12_TEXTURE_ADDRESS_MODE address = i == 0 ?
+				D3D12_TEXTURE_ADDRESS_MODE_WRAP : D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+
+			D3D12_STATIC_SAMPLER_DESC& samplerDesc = samplerDescs[i];
+			samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+			samplerDesc.AddressU = address;
+			samplerDesc.AddressV = address;
+			samplerDesc.AddressW = address;
+			samplerDesc.MinLOD = 0;
+			samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
+			samplerDesc.MipLODBias = 0.0f;
+			samplerDesc.MaxAnisotropy = 1;
+			samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+			samplerDesc.BorderColor = D3D12_STATIC_BORDER_COLOR_OPAQUE_BLACK;
+			samplerDesc.RegisterSpace = 0;
+			samplerDesc.ShaderRegister = i;
+			samplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+		}
 
 		// Create root signature description
 		D3D12_ROOT_SIGNATURE_DESC rootDesc = { };
 		rootDesc.NumParameters = _countof(slotRootParameters);
 		rootDesc.pParameters = slotRootParameters;
-		rootDesc.NumStaticSamplers = 1;
-		rootDesc.pStaticSamplers = &samplerDesc;
+		rootDesc.NumStaticSamplers = _countof(samplerDescs);
+		rootDesc.pStaticSamplers = samplerDescs;
 		rootDesc.Flags =
 			D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
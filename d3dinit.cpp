@@ -41,7 +41,7 @@ int D3DBase::GetMSAAQualityLevels()
 void D3DApplication::LoadResources()
 {
 	// LOAD RESOURCES
-	pStaticResources = std::make_unique<StaticResources>();
+	pStaticResources = std::make_unique<StaticResources>(mOptions);
 	pStaticResources->LoadGeometry(md3dDevice.Get(), mCommandQueue.Get(),
 		mFence.Get(), mCurrentFence);
 	pStaticResources->LoadTextures(md3dDevice.Get(), mCommandQueue.Get());
@@ -67,18 +67,46 @@ void D3DApplication::LoadResources()
 		objects[i].World = MathHelper::Identity4x4();
 	}
 
+	// Terrain samples its baked maps, a streamed terrain has none
+	const TerrainLayout& layout = pStaticResources->GetGround()->GetLayout();
+	const float mapStrength = pStaticResources->TerrainShadows ? 1.0f : 0.0f;
+	objects[0].TerrainMapTransform = layout.MapTransform();
+	objects[0].OcclusionStrength = mapStrength;
+	objects[0].ShadowStrength = mapStrength;
+
+	// LOD patches are placed over the heightmap by the vertex shader
+	objects[0].TerrainHeightScale = { TERRAIN_HEIGHT_SCALE, TERRAIN_HEIGHT_OFFSET };
+	objects[0].TerrainGrid = { layout.ZeroX, layout.ZeroZ, layout.Dx, layout.Dz };
+
+	// Terrain chunks and the water are drawn from packed vertices
+	const VertexQuantization* quantizations[NUM_OBJECTS] =
+		{ &pStaticResources->TerrainQuantization, &pStaticResources->WaterQuantization };
+
+	for (int i = 0; i < NUM_OBJECTS; i++)
+	{
+		const VertexQuantization& q = *quantizations[i];
+		objects[i].PosScale = { q.Scale.x, q.Scale.y, q.Scale.z, 0.0f };
+		objects[i].PosOffset = { q.Offset.x, q.Offset.y, q.Offset.z, 0.0f };
+	}
+
 	//XMMATRIX terrain = XMMatrixIdentity();
 	//terrain *= XMMatrixTranslation(0.0f, -4.0f, 0.0f);
 	//XMStoreFloat4x4(&objects[0].World, terrain);
 
-	pDynamicResources = std::make_unique<DynamicResources>(md3dDevice.Get(), objects, materials);
+	pDynamicResources = std::make_unique<DynamicResources>(md3dDevice.Get(), objects, materials,
+		pStaticResources->TerrainMapStagingBytes(), pStaticResources->TerrainStreamStagingBytes());
+
+	const GEOMETRY_DESCRIPTOR& geometry = pStaticResources->Geometries[GEOMETRY_PACKED];
+	std::vector<SubmeshGeometry> terrainChunks(geometry.Submeshes.begin(),
+		geometry.Submeshes.begin() + geometry.TerrainSubmeshCount);
 
 	mTerrain = std::make_unique<DefaultDrawable>(
-		pStaticResources->Geometries[0].Submeshes.at(0), 0, 0, pStaticResources->GetTextureSRV(0));
+		terrainChunks, 0, 0, pStaticResources->GetTextureSRV(0));
 
 	mWater = std::make_unique<DefaultDrawable>(
-		pStaticResources->Geometries[0].Submeshes.at(1), 1, 1, pStaticResources->GetTextureSRV(1));
+		geometry.Submeshes.at(geometry.TerrainSubmeshCount), 1, 1, pStaticResources->GetTextureSRV(1));
 
+	UpdateCullingBounds();
 }
 
 // Calculate FPS and update window text
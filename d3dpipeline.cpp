@@ -13,6 +13,7 @@
 #include "d3dinit.h"
 #include "d3dUtil.h"
 #include "d3dapp.h"
+#include "vertex_packing.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -41,6 +42,34 @@ void D3DApplication::BuildShadersAndInputLayout()
 		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24,
 		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
 	};
+
+	// Same pixel shader, vertex shader decodes PackedVertex
+	const D3D_SHADER_MACRO packedDefines[] =
+	{
+		"FOG", "1",
+		"PACKED_VERTEX", "1",
+		NULL, NULL
+	};
+
+	mPackedShader.mRootSignature = mDefaultShader.mRootSignature;
+	mPackedShader.mvsByteCode = CompileShader(L"Shaders\\main.hlsl",
+		packedDefines, "VS", "vs_5_0");
+	mPackedShader.mpsByteCode = mDefaultShader.mpsByteCode;
+	mPackedShader.mInputLayout = GetPackedVertexInputLayout();
+
+	// Same pixel shader, vertex shader reads heights of the LOD patch
+	const D3D_SHADER_MACRO lodDefines[] =
+	{
+		"FOG", "1",
+		"TERRAIN_LOD", "1",
+		NULL, NULL
+	};
+
+	mTerrainLodShader.mRootSignature = mDefaultShader.mRootSignature;
+	mTerrainLodShader.mvsByteCode = CompileShader(L"Shaders\\main.hlsl",
+		lodDefines, "VS", "vs_5_0");
+	mTerrainLodShader.mpsByteCode = mDefaultShader.mpsByteCode;
+	mTerrainLodShader.mInputLayout = mDefaultShader.mInputLayout;
 }
 
 void D3DApplication::BuildPSO()
@@ -78,6 +107,20 @@ void D3DApplication::BuildPSO()
 	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
 		&linePSODesc, IID_PPV_ARGS(mLinePSO.GetAddressOf())));
 
+	// Opaque PSO for meshes in the packed vertex format
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC packedPSODesc = psoDesc;
+	mPackedShader.Set(packedPSODesc);
+
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
+		&packedPSODesc, IID_PPV_ARGS(mPackedPSO.GetAddressOf())));
+
+	// Opaque PSO for the terrain LOD patch
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC terrainLodPSODesc = psoDesc;
+	mTerrainLodShader.Set(terrainLodPSODesc);
+
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
+		&terrainLodPSODesc, IID_PPV_ARGS(mTerrainLodPSO.GetAddressOf())));
+
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC blendingPSO = psoDesc;
 
 	D3D12_RENDER_TARGET_BLEND_DESC blendDesc = { };
@@ -97,4 +140,11 @@ void D3DApplication::BuildPSO()
 
 	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
 		&blendingPSO, IID_PPV_ARGS(mBlendPSO.GetAddressOf())));
+
+	// Blending PSO for the packed water
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC packedBlendingPSO = blendingPSO;
+	mPackedShader.Set(packedBlendingPSO);
+
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
+		&packedBlendingPSO, IID_PPV_ARGS(mPackedBlendPSO.GetAddressOf())));
 }
\ No newline at end of file
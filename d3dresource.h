@@ -10,28 +10,69 @@
 
 #include <d3d12.h>
 #include <wrl.h>
+#include <string>
 #include <vector>
 #include <ResourceUploadBatch.h>
-#include <DDSTextureLoader.h>
 
+#include "image_dds.h"
+#include "memory_util.h"
 #include "structures.h"
 #include "geometry.h"
+#include "terrain_sampler.h"
+#include "terrain_edit.h"
+#include "terrain_lod.h"
+#include "terrain_horizon.h"
+#include "terrain_noise.h"
+#include "terrain_shadow.h"
+#include "terrain_stream.h"
 #include "FrameResource.h"
 
 #define NUM_OBJECTS 2
 #define NUM_MATERIALS 2
 
 #define NUM_TEXTURES 2
-#define NUM_GEOMETRIES 1
+#define NUM_TERRAIN_MAPS 3		// Built from the heightmap, after the textures in the SRV heap
+#define TERRAIN_MAP_OCCLUSION 0
+#define TERRAIN_MAP_SHADOW 1
+#define TERRAIN_MAP_HEIGHT 2		// Heightmap samples, read by the LOD vertex shader
+#define NUM_GEOMETRIES 2
+#define GEOMETRY_PACKED 0			// Terrain chunks and the water, in PackedVertex
+#define GEOMETRY_TERRAIN_LOD 1		// LOD patch, in Vertex, TERRAIN_RENDER_LOD only
 
 #define NUM_FRAME_RESOURCES 3
 
+// How the terrain mesh is built and drawn
+enum TERRAIN_RENDER_MODE
+{
+	TERRAIN_RENDER_CHUNKS = 0,		// Full-resolution chunks, editable
+	TERRAIN_RENDER_LOD = 1,			// Shared patch over the CDLOD quadtree, read-only
+	TERRAIN_RENDER_RTIN = 2,		// Chunks simplified within RtinMaxError, read-only
+	TERRAIN_RENDER_STREAM = 3		// Chunks around the camera streamed from StreamFile, read-only
+};
+
+// Sides of generated heightmaps. Full-resolution chunks of larger maps
+// would not fit into one vertex buffer.
+#define TERRAIN_GENERATE_MIN_SIZE 4
+#define TERRAIN_GENERATE_MAX_SIZE 8192
+
+// Chosen on the command line, see main.cpp
+struct TerrainOptions
+{
+	TERRAIN_RENDER_MODE Mode = TERRAIN_RENDER_CHUNKS;
+	float RtinMaxError = 0.0f;		// World units, TERRAIN_RENDER_RTIN only
+	std::string StreamFile;			// 8-bit BMP, TERRAIN_RENDER_STREAM only
+	UINT GenerateSize = 0;			// Side of a generated heightmap, 0 reads the BMP
+	uint32_t GenerateSeed = 1;		// TerrainNoiseSettings::Seed of the generated heightmap
+};
+
 struct GEOMETRY_DESCRIPTOR
 {
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView;
 	D3D12_INDEX_BUFFER_VIEW IndexBufferView;
 
 	std::vector<SubmeshGeometry> Submeshes;
+
+	UINT TerrainSubmeshCount = 0;		// Terrain chunks come first in Submeshes
 };
 
 class StaticResources
@@ -41,27 +82,401 @@ private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> IndexBuffers[NUM_GEOMETRIES];
 
 	Microsoft::WRL::ComPtr<ID3D12Resource> Textures[NUM_TEXTURES];
+	Microsoft::WRL::ComPtr<ID3D12Resource> TerrainMaps[NUM_TERRAIN_MAPS];
+
+	// Slots of streamed chunks, TERRAIN_RENDER_STREAM only
+	Microsoft::WRL::ComPtr<ID3D12Resource> StreamVertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> StreamIndexBuffer;
+	D3D12_RESOURCE_STATES StreamBufferState = D3D12_RESOURCE_STATE_COMMON;
+	std::vector<TerrainStreamCopy> StreamCopies;
+
+	// Edited vertices before packing, and their copies
+	std::vector<Vertex> EditVertices;
+	std::vector<TerrainVertexCopy> EditCopies;
+
+	// Terrain edited since the last RebakeTerrainMaps, and maps rebaked
+	// but not uploaded yet
+	bool TerrainMapsStale = false;
+	bool UploadOcclusion = false;
+	bool UploadShadows = false;
 
 public:
 	GEOMETRY_DESCRIPTOR Geometries[NUM_GEOMETRIES];
 
+	// Decode packed positions of the terrain chunks and of the water,
+	// uploaded in their ObjectConstants
+	VertexQuantization TerrainQuantization;
+	VertexQuantization WaterQuantization;
+
+	std::unique_ptr<HeightmapImage> TerrainHeights;	// Heightmap the terrain was built from, not streamed
+	std::unique_ptr<TerrainHeightSampler> Ground;	// Height queries over TerrainHeights
+	std::unique_ptr<TerrainEditor> TerrainEdits;	// Brushes and vertex buffer updates
+	std::unique_ptr<TerrainHorizonBaker> TerrainHorizons;	// Ambient occlusion
+	std::unique_ptr<TerrainShadowBaker> TerrainShadows;	// Sun shadow mask
+	std::unique_ptr<TerrainQuadtree> TerrainLod;	// LOD selection, TERRAIN_RENDER_LOD only
+	std::unique_ptr<HeightmapTileCache> TerrainTiles;	// Streamed heightmap, TERRAIN_RENDER_STREAM only
+	std::unique_ptr<TerrainStreamSlots> TerrainStream;	// Chunks around the camera, TERRAIN_RENDER_STREAM only
+	std::unique_ptr<TerrainStreamGround> StreamGround;	// Height queries over TerrainTiles
+	D3D12_VERTEX_BUFFER_VIEW StreamVertexBufferView = { };
+	D3D12_INDEX_BUFFER_VIEW StreamIndexBufferView = { };
+
+	const TerrainOptions Options;
+
 public:
 
+	explicit StaticResources(const TerrainOptions& options) : Options(options) { }
+
 	void LoadGeometry(ID3D12Device* pDevice,
 		ID3D12CommandQueue* pQueue,
 		ID3D12Fence* pFence,
 		UINT64& currentValue)
 	{
+		// A cached terrain mesh is uploaded from the mapping, so it stays
+		// open until the geometry is constructed
+		mapped_file geometryCache;
+
 		StaticGeometryUploader<Vertex> uploader(pDevice);
+		uploader.EnableMeshOptimization(true);
+
+		const GEOMETRY_DESCRIPTOR& packed = Geometries[GEOMETRY_PACKED];
+
+		// A streamed heightmap is only read through the tile cache, it
+		// may be larger than memory and than any texture
+		const bool streamed = Options.Mode == TERRAIN_RENDER_STREAM;
+		const bool generated = Options.GenerateSize > 0 && !streamed;
+
+		if (streamed)
+		{
+			TerrainTiles = std::make_unique<HeightmapTileCache>(TERRAIN_STREAM_TILE_CAPACITY);
+			ThrowIfFailed(TerrainTiles->Open(Options.StreamFile.c_str()) == 0 ? S_OK : E_FAIL);
+		}
+		else if (generated)
+		{
+			TerrainNoiseSettings settings;
+			settings.Seed = Options.GenerateSeed;
+
+			TerrainHeights = std::make_unique<HeightmapImage>(Options.GenerateSize, Options.GenerateSize);
+			GenerateTerrainHeightmap(settings, *TerrainHeights, &WorkerPool::Default());
+		}
+		else
+		{
+			TerrainHeights = std::make_unique<HeightmapImage>(
+				streamed ? Options.StreamFile : std::string("Textures//heightmap.bmp"));
+		}
+
+		// Everything built from the heightmap expects at least one quad
+		const TerrainLayout layout = streamed ?
+			TerrainLayout(TerrainTiles->GetWidth(), TerrainTiles->GetHeight()) :
+			TerrainLayout(TerrainHeights->GetWidth(), TerrainHeights->GetHeight());
+		ThrowIfFailed(layout.HasQuads() ? S_OK : E_FAIL);
+
+		std::vector<std::vector<uint32_t>> terrainRemaps;
+
+		if (Options.Mode == TERRAIN_RENDER_LOD)
+		{
+			// The vertex shader places the patch and reads heights, the
+			// quadtree only needs them for node bounds
+			std::vector<float> heights;
+			ExtractTerrainHeights(*TerrainHeights, layout, heights);
+			TerrainLod = std::make_unique<TerrainQuadtree>(heights.data(), layout);
+
+			// The patch is placed by the vertex shader, which reads Vertex
+			StaticGeometryUploader<Vertex> lodUploader(pDevice);
+			CreateTerrainLodPatch(&lodUploader, TerrainLodSettings().LeafQuads);
+			lodUploader.ConstructGeometry(VertexBuffers[GEOMETRY_TERRAIN_LOD],
+				IndexBuffers[GEOMETRY_TERRAIN_LOD], pQueue, pFence, currentValue);
+			SetGeometry(GEOMETRY_TERRAIN_LOD, lodUploader);
+		}
+		else if (Options.Mode == TERRAIN_RENDER_RTIN)
+		{
+			Geometries[GEOMETRY_PACKED].TerrainSubmeshCount = CreateTerrainRtin(&uploader, *TerrainHeights,
+				Options.RtinMaxError);
+			ThrowIfFailed(packed.TerrainSubmeshCount > 0 ? S_OK : E_FAIL);
+		}
+		else if (streamed)
+		{
+			TerrainStream = std::make_unique<TerrainStreamSlots>(*TerrainTiles);
+			StreamGround = std::make_unique<TerrainStreamGround>(*TerrainTiles);
+			CreateStreamBuffers(pDevice);
+		}
+		else if (generated)
+		{
+			// Nothing to cache, the heightmap is regenerated every launch
+			Geometries[GEOMETRY_PACKED].TerrainSubmeshCount = CreateTerrain(&uploader, *TerrainHeights,
+				&terrainRemaps);
+		}
+		else
+		{
+			// Generated mesh is kept next to the heightmap, later launches
+			// only read it while the heightmap stays the same
+			Geometries[GEOMETRY_PACKED].TerrainSubmeshCount = CreateTerrainCached(&uploader, *TerrainHeights,
+				"Textures//heightmap.geocache", geometryCache, &terrainRemaps);
+		}
+
+		if (!streamed) Ground = std::make_unique<TerrainHeightSampler>(*TerrainHeights);
 
-		CreateTerrain(&uploader, "Textures//heightmap.bmp");
 		CreatePlane(&uploader, 100, 100, 128.0f, 128.0f);
 
-		uploader.ConstructGeometry(VertexBuffers[0], IndexBuffers[0], pQueue, pFence, currentValue);
+		// One quantisation for all chunks, so they share the constants of
+		// the terrain. Edits move heights anywhere between the lowest and
+		// the highest sample, so the range spans them.
+		const UINT chunkCount = packed.TerrainSubmeshCount;
+		TerrainQuantization = uploader.QuantizeSubmeshes(0, chunkCount);
+		if (Options.Mode == TERRAIN_RENDER_CHUNKS)
+		{
+			TerrainQuantization.Offset.y = TerrainLayout::SampleHeight(0.0f);
+			TerrainQuantization.Scale.y = TerrainLayout::SampleHeight(255.0f) - TerrainQuantization.Offset.y;
+		}
+		WaterQuantization = uploader.QuantizeSubmeshes(chunkCount, 1);
+
+		std::vector<VertexQuantization> quantizations(chunkCount, TerrainQuantization);
+		quantizations.push_back(WaterQuantization);
+
+		uploader.ConstructPackedGeometry(VertexBuffers[GEOMETRY_PACKED], IndexBuffers[GEOMETRY_PACKED],
+			quantizations, pQueue, pFence, currentValue);
+		SetGeometry(GEOMETRY_PACKED, uploader);
+
+		// Edits rewrite full-resolution chunk vertices, so other modes
+		// cannot be edited
+		if (Options.Mode == TERRAIN_RENDER_CHUNKS)
+		{
+			TerrainEdits = std::make_unique<TerrainEditor>(*TerrainHeights,
+				packed.Submeshes.data(), std::move(terrainRemaps));
+		}
+	}
+
+	// Height queries of whichever heightmap the terrain is drawn from
+	const TerrainGround* GetGround() const
+	{
+		if (StreamGround) return StreamGround.get();
+		return Ground.get();
+	}
+
+	void SetGeometry(UINT index, const StaticGeometryUploader<Vertex>& uploader)
+	{
+		Geometries[index].Submeshes = uploader.GetSubmeshes();
+		Geometries[index].VertexBufferView = uploader.VertexBufferView();
+		Geometries[index].IndexBufferView = uploader.IndexBufferView();
+	}
+
+	// Edits the terrain at world position (x, z). Vertices are updated
+	// by the next UploadTerrainEdits. Returns true if bounds of terrain
+	// chunks grew. Does nothing unless the terrain is drawn in chunks.
+	bool ApplyTerrainBrush(const TerrainBrush& brush, float x, float z)
+	{
+		if (!TerrainEdits) return false;
+
+		TerrainDirtyRect rect = TerrainEdits->ApplyBrush(brush, x, z);
+		if (rect.Empty()) return false;
+
+		Ground->Refresh(*TerrainHeights, rect);
+		TerrainMapsStale = true;
+		return GrowTerrainBounds(rect);
+	}
+
+	/**
+	 * Rebakes the occlusion and the shadow horizons of the edited terrain,
+	 * both are uploaded whole by the next UpdateTerrainMaps. A horizon
+	 * depends on samples across the whole map, so the bake is not limited
+	 * to the edited rect. It takes as long as at load, call once an edit
+	 * is finished rather than for every brush step.
+	 */
+	void RebakeTerrainMaps()
+	{
+		if (!TerrainMapsStale) return;
+		TerrainMapsStale = false;
+
+		TerrainHorizons = std::make_unique<TerrainHorizonBaker>(*TerrainHeights);
+		TerrainHorizons->Bake(TerrainHorizonSettings(), &WorkerPool::Default());
+
+		TerrainShadows = std::make_unique<TerrainShadowBaker>(*TerrainHeights);
+		UploadOcclusion = true;
+		UploadShadows = true;
+	}
+
+	// Extends bounds of the terrain chunks over the samples to their heights
+	bool GrowTerrainBounds(const TerrainDirtyRect& rect)
+	{
+		const TerrainLayout& layout = Ground->GetLayout();
+
+		uint8_t low = 255;
+		uint8_t high = 0;
+		for (UINT row = rect.FirstRow; row < rect.EndRow; row++)
+		{
+			const uint8_t* pRow = TerrainHeights->GetRow(row);
+			for (UINT col = rect.FirstCol; col < rect.EndCol; col++)
+			{
+				low = (std::min)(low, pRow[col]);
+				high = (std::max)(high, pRow[col]);
+			}
+		}
+
+		const float minHeight = TerrainLayout::SampleHeight((float)low);
+		const float maxHeight = TerrainLayout::SampleHeight((float)high);
+
+		// Z decreases with column
+		const float minX = layout.WorldX(rect.FirstRow);
+		const float maxX = layout.WorldX(rect.EndRow - 1);
+		const float minZ = layout.WorldZ(rect.EndCol - 1);
+		const float maxZ = layout.WorldZ(rect.FirstCol);
+
+		bool grew = false;
+		GEOMETRY_DESCRIPTOR& packed = Geometries[GEOMETRY_PACKED];
+		for (UINT i = 0; i < packed.TerrainSubmeshCount; i++)
+		{
+			SubmeshGeometry& chunk = packed.Submeshes[i];
+			BoundingBoxAA& box = chunk.Bounds;
+
+			if (box.Max.x < minX || box.Min.x > maxX || box.Max.z < minZ || box.Min.z > maxZ) continue;
+			if (box.Min.y <= minHeight && box.Max.y >= maxHeight) continue;
+
+			box.Min.y = (std::min)(box.Min.y, minHeight);
+			box.Max.y = (std::max)(box.Max.y, maxHeight);
+
+			// Sphere around the grown box, from the old centre
+			const DirectX::XMFLOAT3& c = chunk.Sphere.Center;
+			float dx = (std::max)(c.x - box.Min.x, box.Max.x - c.x);
+			float dy = (std::max)(c.y - box.Min.y, box.Max.y - c.y);
+			float dz = (std::max)(c.z - box.Min.z, box.Max.z - c.z);
+			chunk.Sphere.Radius = (std::max)(chunk.Sphere.Radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+
+			grew = true;
+		}
+
+		return grew;
+	}
+
+	// Packs the edited vertices with the terrain quantization and records
+	// their copies, call before drawing. The packed vertex buffer is in
+	// GENERIC_READ state before and after.
+	void UploadTerrainEdits(ID3D12GraphicsCommandList* pCmdList, UploadBuffer<PackedVertex>* pStaging)
+	{
+		if (!TerrainEdits || !TerrainEdits->HasPendingUpload()) return;
+
+		EditVertices.resize(TERRAIN_EDIT_STAGING_VERTICES);
+		UINT staged = TerrainEdits->PrepareUpload(EditVertices.data(), TERRAIN_EDIT_STAGING_VERTICES, EditCopies);
+		if (staged == 0) return;
+
+		PackVertices(EditVertices.data(), staged, TerrainQuantization,
+			reinterpret_cast<PackedVertex*>(pStaging->GetMappedData()));
+
+		ID3D12Resource* pVertexBuffer = VertexBuffers[GEOMETRY_PACKED].Get();
+		Transition(pVertexBuffer, pCmdList, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST);
+
+		for (const TerrainVertexCopy& copy : EditCopies)
+		{
+			pCmdList->CopyBufferRegion(
+				pVertexBuffer, static_cast<UINT64>(copy.BufferVertex) * sizeof(PackedVertex),
+				pStaging->Resource(), static_cast<UINT64>(copy.StagingVertex) * sizeof(PackedVertex),
+				static_cast<UINT64>(copy.VertexCount) * sizeof(PackedVertex));
+		}
+
+		Transition(pVertexBuffer, pCmdList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+	}
+
+	// Bytes of staging streamed chunks take in one frame, 0 unless streaming
+	UINT TerrainStreamStagingBytes() const
+	{
+		return TerrainStream ? TERRAIN_STREAM_UPLOADS_PER_FRAME * TERRAIN_STREAM_SLOT_BYTES : 0;
+	}
+
+	// Buffers with a slot for every streamed chunk, filled by UploadTerrainStream
+	void CreateStreamBuffers(ID3D12Device* pDevice)
+	{
+		const UINT slots = TerrainStream->GetSlotCount();
+		const UINT64 vertexBytes = static_cast<UINT64>(slots) * TERRAIN_STREAM_SLOT_VERTICES * sizeof(Vertex);
+		const UINT64 indexBytes = static_cast<UINT64>(slots) * TERRAIN_STREAM_SLOT_INDICES * sizeof(uint16_t);
+
+		const D3D12_HEAP_PROPERTIES hp = HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+		const D3D12_RESOURCE_DESC vertexDesc = BufferDesc(vertexBytes);
+		const D3D12_RESOURCE_DESC indexDesc = BufferDesc(indexBytes);
+
+		ThrowIfFailed(pDevice->CreateCommittedResource(&hp, D3D12_HEAP_FLAG_NONE, &vertexDesc,
+			D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(StreamVertexBuffer.GetAddressOf())));
+		ThrowIfFailed(pDevice->CreateCommittedResource(&hp, D3D12_HEAP_FLAG_NONE, &indexDesc,
+			D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(StreamIndexBuffer.GetAddressOf())));
+		StreamBufferState = D3D12_RESOURCE_STATE_COMMON;
+
+		StreamVertexBufferView.BufferLocation = StreamVertexBuffer->GetGPUVirtualAddress();
+		StreamVertexBufferView.SizeInBytes = static_cast<UINT>(vertexBytes);
+		StreamVertexBufferView.StrideInBytes = sizeof(Vertex);
+
+		StreamIndexBufferView.BufferLocation = StreamIndexBuffer->GetGPUVirtualAddress();
+		StreamIndexBufferView.SizeInBytes = static_cast<UINT>(indexBytes);
+		StreamIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+	}
+
+	// Records the copies of streamed chunks into their slots, call
+	// before drawing. Slots of evicted chunks are only reused here, the
+	// transition to COPY_DEST waits for earlier frames that read them.
+	void UploadTerrainStream(ID3D12GraphicsCommandList* pCmdList, UploadBuffer<uint8_t>* pStaging)
+	{
+		if (!TerrainStream) return;
+
+		UINT staged = TerrainStream->PrepareUpload(static_cast<uint8_t*>(pStaging->GetMappedData()),
+			TERRAIN_STREAM_UPLOADS_PER_FRAME, StreamCopies);
+		if (staged == 0) return;
+
+		Transition(StreamVertexBuffer.Get(), pCmdList, StreamBufferState, D3D12_RESOURCE_STATE_COPY_DEST);
+		Transition(StreamIndexBuffer.Get(), pCmdList, StreamBufferState, D3D12_RESOURCE_STATE_COPY_DEST);
 
-		Geometries[0].Submeshes = uploader.GetSubmeshes();
-		Geometries[0].VertexBufferView = uploader.VertexBufferView();
-		Geometries[0].IndexBufferView = uploader.IndexBufferView();
+		for (const TerrainStreamCopy& copy : StreamCopies)
+		{
+			const UINT64 vertexBytes = static_cast<UINT64>(copy.VertexCount) * sizeof(Vertex);
+
+			pCmdList->CopyBufferRegion(
+				StreamVertexBuffer.Get(), static_cast<UINT64>(copy.Slot) * TERRAIN_STREAM_SLOT_VERTICES * sizeof(Vertex),
+				pStaging->Resource(), copy.StagingOffset, vertexBytes);
+			pCmdList->CopyBufferRegion(
+				StreamIndexBuffer.Get(), static_cast<UINT64>(copy.Slot) * TERRAIN_STREAM_SLOT_INDICES * sizeof(uint16_t),
+				pStaging->Resource(), copy.StagingOffset + vertexBytes,
+				static_cast<UINT64>(copy.IndexCount) * sizeof(uint16_t));
+		}
+
+		Transition(StreamVertexBuffer.Get(), pCmdList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+		Transition(StreamIndexBuffer.Get(), pCmdList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+		StreamBufferState = D3D12_RESOURCE_STATE_GENERIC_READ;
+	}
+
+	// Bytes of staging the terrain map rows can take in one frame, the
+	// shadow mask first and the occlusion after it. None while streaming,
+	// the maps are not baked.
+	UINT TerrainMapStagingBytes() const
+	{
+		if (!TerrainHeights) return 0;
+		return 2 * TerrainMapStagingOffset();
+	}
+
+	// Moves the sun and records the copies of the terrain map rows that
+	// changed, call before drawing
+	void UpdateTerrainMaps(ID3D12GraphicsCommandList* pCmdList, UploadBuffer<uint8_t>* pStaging,
+		float sunAzimuth, float sunElevation)
+	{
+		if (!TerrainShadows) return;
+
+		const UINT height = TerrainHeights->GetHeight();
+
+		// Rebaked shadows start all lit, rows the sun leaves lit differ from the texture too
+		TerrainDirtyRect rows = TerrainShadows->SetSun(sunAzimuth, sunElevation, &WorkerPool::Default());
+		if (UploadShadows)
+		{
+			rows.FirstRow = 0;
+			rows.EndRow = height;
+			UploadShadows = false;
+		}
+
+		if (!rows.Empty())
+		{
+			CopyTerrainMapRows(pCmdList, pStaging, 0, TerrainMaps[TERRAIN_MAP_SHADOW].Get(),
+				TerrainShadows->GetMask(), rows.FirstRow, rows.EndRow);
+		}
+
+		if (UploadOcclusion)
+		{
+			CopyTerrainMapRows(pCmdList, pStaging, TerrainMapStagingOffset(),
+				TerrainMaps[TERRAIN_MAP_OCCLUSION].Get(), TerrainHorizons->GetOcclusion(), 0, height);
+			UploadOcclusion = false;
+		}
 	}
 
 	void LoadTextures(ID3D12Device* pDevice, ID3D12CommandQueue* pQueue)
@@ -70,8 +485,44 @@ public:
 
 		upload.Begin();
 
-		DirectX::CreateDDSTextureFromFile(pDevice, upload, L"Textures\\grass.dds", Textures[0].GetAddressOf());
-		DirectX::CreateDDSTextureFromFile(pDevice, upload, L"Textures\\water1.dds", Textures[1].GetAddressOf());
+		CreateDdsTexture(pDevice, upload, "Textures/grass.dds", Textures[0].GetAddressOf());
+		CreateDdsTexture(pDevice, upload, "Textures/water1.dds", Textures[1].GetAddressOf());
+
+		if (!TerrainHeights)
+		{
+			// A streamed heightmap is never held whole, so nothing is baked
+			// and no map could fit its size into a texture. Single texels
+			// keep the SRVs valid, the terrain draws them with zero strength.
+			uint8_t neutral[NUM_TERRAIN_MAPS];
+			neutral[TERRAIN_MAP_OCCLUSION] = 255;
+			neutral[TERRAIN_MAP_SHADOW] = 255;
+			neutral[TERRAIN_MAP_HEIGHT] = 0;
+
+			for (int i = 0; i < NUM_TERRAIN_MAPS; i++)
+			{
+				CreateTerrainMap(pDevice, upload, &neutral[i], 1, 1, TerrainMaps[i].GetAddressOf());
+			}
+		}
+		else
+		{
+			// Ambient occlusion of the terrain
+			TerrainHorizons = std::make_unique<TerrainHorizonBaker>(*TerrainHeights);
+			TerrainHorizons->Bake(TerrainHorizonSettings(), &WorkerPool::Default());
+
+			CreateTerrainMap(pDevice, upload, TerrainHorizons->GetOcclusion(), TerrainHorizons->GetWidth(),
+				TerrainHorizons->GetHeight(), TerrainMaps[TERRAIN_MAP_OCCLUSION].GetAddressOf());
+
+			// Sun shadows, all lit until the first UpdateTerrainMaps
+			TerrainShadows = std::make_unique<TerrainShadowBaker>(*TerrainHeights);
+
+			CreateTerrainMap(pDevice, upload, TerrainShadows->GetMask(), TerrainShadows->GetWidth(),
+				TerrainShadows->GetHeight(), TerrainMaps[TERRAIN_MAP_SHADOW].GetAddressOf());
+
+			// Samples the LOD vertex shader reads
+			CreateTerrainMap(pDevice, upload, TerrainHeights->GetRow(0), TerrainHeights->GetWidth(),
+				TerrainHeights->GetHeight(), TerrainMaps[TERRAIN_MAP_HEIGHT].GetAddressOf(),
+				static_cast<UINT>(TerrainHeights->GetRowPitch()));
+		}
 
 		auto finish = upload.End(pQueue);
 
@@ -80,7 +531,7 @@ public:
 		// Build and populate SRVs
 
 		D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = { };
-		srvHeapDesc.NumDescriptors = NUM_TEXTURES;
+		srvHeapDesc.NumDescriptors = NUM_TEXTURES + NUM_TERRAIN_MAPS;
 		srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 		srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 		srvHeapDesc.NodeMask = 0;
@@ -105,6 +556,161 @@ public:
 
 			handle.ptr += cbvSrvDescriptorSize;
 		}
+
+		for (int i = 0; i < NUM_TERRAIN_MAPS; i++)
+		{
+			pDevice->CreateShaderResourceView(TerrainMaps[i].Get(), nullptr, handle);
+
+			handle.ptr += cbvSrvDescriptorSize;
+		}
+	}
+
+	// Creates the texture of a .dds file and queues the upload of all its
+	// subresources, read straight from the mapping of the file
+	static void CreateDdsTexture(ID3D12Device* pDevice, DirectX::ResourceUploadBatch& upload,
+		const char* filename, ID3D12Resource** ppTexture)
+	{
+		dds_file file;
+		ThrowIfFailed(file.open(filename) == 0 ? S_OK : E_FAIL);
+
+		const dds_info& info = file.info();
+
+		D3D12_RESOURCE_DESC texDesc = { };
+		texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		texDesc.Alignment = 0;
+		texDesc.Width = info.width;
+		texDesc.Height = info.height;
+		texDesc.DepthOrArraySize = static_cast<UINT16>(info.array_size);
+		texDesc.MipLevels = static_cast<UINT16>(info.mip_count);
+		texDesc.Format = static_cast<DXGI_FORMAT>(info.dxgi_format);
+		texDesc.SampleDesc.Count = 1;
+		texDesc.SampleDesc.Quality = 0;
+		texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		const D3D12_HEAP_PROPERTIES hp = HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+
+		ThrowIfFailed(pDevice->CreateCommittedResource(
+			&hp,
+			D3D12_HEAP_FLAG_NONE,
+			&texDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(ppTexture)));
+
+		// Subresources of .dds files are in D3D12 order
+		std::vector<D3D12_SUBRESOURCE_DATA> data(file.subresource_count());
+		for (UINT i = 0; i < file.subresource_count(); i++)
+		{
+			const dds_subresource& subresource = file.subresources()[i];
+			data[i].pData = subresource.data;
+			data[i].RowPitch = subresource.row_pitch;
+			data[i].SlicePitch = static_cast<LONG_PTR>(subresource.size);
+		}
+
+		// Batch copies the data to its own upload buffer, so the file
+		// is unmapped on return
+		upload.Upload(*ppTexture, 0, data.data(), file.subresource_count());
+		upload.Transition(*ppTexture, D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	// Creates an 8-bit texture with one texel per heightmap sample and
+	// queues the upload of pData, height rows of width bytes, rowPitch
+	// bytes apart or packed when it is 0
+	static void CreateTerrainMap(ID3D12Device* pDevice, DirectX::ResourceUploadBatch& upload,
+		const uint8_t* pData, UINT width, UINT height, ID3D12Resource** ppTexture,
+		UINT rowPitch = 0)
+	{
+		if (rowPitch == 0) rowPitch = width;
+
+		D3D12_RESOURCE_DESC texDesc = { };
+		texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		texDesc.Alignment = 0;
+		texDesc.Width = width;
+		texDesc.Height = height;
+		texDesc.DepthOrArraySize = 1;
+		texDesc.MipLevels = 1;
+		texDesc.Format = DXGI_FORMAT_R8_UNORM;
+		texDesc.SampleDesc.Count = 1;
+		texDesc.SampleDesc.Quality = 0;
+		texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+		const D3D12_HEAP_PROPERTIES hp = HeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+
+		ThrowIfFailed(pDevice->CreateCommittedResource(
+			&hp,
+			D3D12_HEAP_FLAG_NONE,
+			&texDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(ppTexture)));
+
+		D3D12_SUBRESOURCE_DATA data = { };
+		data.pData = pData;
+		data.RowPitch = rowPitch;
+		data.SlicePitch = static_cast<LONG_PTR>(rowPitch) * height;
+
+		// Batch copies the data to its own upload buffer
+		upload.Upload(*ppTexture, 0, &data, 1);
+		upload.Transition(*ppTexture, D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	// Rows of terrain map copies are aligned as texture copies require
+	UINT TerrainMapRowPitch() const
+	{
+		return (TerrainHeights->GetWidth() + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+			~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+	}
+
+	// Start of the second map in the staging, aligned as texture copies require
+	UINT TerrainMapStagingOffset() const
+	{
+		return (TerrainMapRowPitch() * TerrainHeights->GetHeight() + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) &
+			~(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+	}
+
+	// Stages rows [firstRow, endRow) of a heightmap sized map at stagingOffset
+	// and records their copy into the texture
+	void CopyTerrainMapRows(ID3D12GraphicsCommandList* pCmdList, UploadBuffer<uint8_t>* pStaging,
+		UINT stagingOffset, ID3D12Resource* pTexture, const uint8_t* pMap, UINT firstRow, UINT endRow)
+	{
+		const UINT width = TerrainHeights->GetWidth();
+		const UINT pitch = TerrainMapRowPitch();
+		uint8_t* pDst = static_cast<uint8_t*>(pStaging->GetMappedData()) + stagingOffset;
+
+		for (UINT row = firstRow; row < endRow; row++)
+		{
+			memcpy(pDst + static_cast<size_t>(row - firstRow) * pitch,
+				pMap + static_cast<size_t>(row) * width, width);
+		}
+
+		D3D12_TEXTURE_COPY_LOCATION dst = { };
+		dst.pResource = pTexture;
+		dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst.SubresourceIndex = 0;
+
+		D3D12_TEXTURE_COPY_LOCATION src = { };
+		src.pResource = pStaging->Resource();
+		src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		src.PlacedFootprint.Offset = stagingOffset;
+		src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8_UNORM;
+		src.PlacedFootprint.Footprint.Width = width;
+		src.PlacedFootprint.Footprint.Height = endRow - firstRow;
+		src.PlacedFootprint.Footprint.Depth = 1;
+		src.PlacedFootprint.Footprint.RowPitch = pitch;
+
+		Transition(pTexture, pCmdList,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+			D3D12_RESOURCE_STATE_COPY_DEST);
+
+		pCmdList->CopyTextureRegion(&dst, 0, firstRow, 0, &src, nullptr);
+
+		Transition(pTexture, pCmdList,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 
 	// Returns GPU descriptor handle for current frame's pass CBV
@@ -115,6 +721,12 @@ public:
 		return textureHandle;
 	}
 
+	// Table of the terrain maps, bound once per frame
+	D3D12_GPU_DESCRIPTOR_HANDLE GetTerrainMapSRV() const
+	{
+		return GetTextureSRV(NUM_TEXTURES);
+	}
+
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mSRVHeap = nullptr;
 	SIZE_T cbvSrvDescriptorSize = 0;
 };
@@ -161,13 +773,15 @@ public:
 	FrameResource* pCurrentFrameResource = nullptr;
 
 	DynamicResources(ID3D12Device* pDevice, 
-		ObjectConstants* pTransformInitialData, MaterialConstants* pMaterialInitialData)
+		ObjectConstants* pTransformInitialData, MaterialConstants* pMaterialInitialData,
+		UINT terrainMapStagingBytes, UINT terrainStreamStagingBytes)
 		: CBDataCPU(pTransformInitialData, pMaterialInitialData)
 	{
 		for (int i = 0; i < NUM_FRAME_RESOURCES; i++)
 		{
 			pFrameResources[i] =
-				std::make_unique<FrameResource>(pDevice, 1, NUM_OBJECTS, NUM_MATERIALS);
+				std::make_unique<FrameResource>(pDevice, 1, NUM_OBJECTS, NUM_MATERIALS,
+					TERRAIN_EDIT_STAGING_VERTICES, terrainMapStagingBytes, terrainStreamStagingBytes);
 		}
 		pCurrentFrameResource = pFrameResources[currFrameResourceIndex].get();
 	}
@@ -5,6 +5,7 @@
 #include <DirectXMath.h>
 #include <DirectXColors.h>
 #include <windowsx.h>
+#include <algorithm>
 
 #include "d3dUtil.h"
 #include "window.h"
@@ -26,16 +27,88 @@ void D3DApplication::DrawRenderItems()
 		pDynamicResources->pCurrentFrameResource->PassCB->Resource()->GetGPUVirtualAddress());
 
 	mCommandList->SetDescriptorHeaps(1, pStaticResources->mSRVHeap.GetAddressOf());
+	mCommandList->SetGraphicsRootDescriptorTable(4, pStaticResources->GetTerrainMapSRV());
 
-	GEOMETRY_DESCRIPTOR& defaultGeometry = pStaticResources->Geometries[0];
-	DefaultDrawable::SetVBAndIB(mCommandList.Get(), defaultGeometry.VertexBufferView, defaultGeometry.IndexBufferView);
+	GEOMETRY_DESCRIPTOR& packedGeometry = pStaticResources->Geometries[GEOMETRY_PACKED];
 
-	mTerrain->Draw(mCommandList.Get(), pDynamicResources->pCurrentFrameResource);
+	// Terrain chunks come first, then the water
+	if (mOptions.Mode == TERRAIN_RENDER_LOD)
+	{
+		DrawTerrainLod();
+	}
+	else if (mOptions.Mode == TERRAIN_RENDER_STREAM)
+	{
+		DrawTerrainStream();
+	}
+	else
+	{
+		DefaultDrawable::SetVBAndIB(mCommandList.Get(), packedGeometry.VertexBufferView, packedGeometry.IndexBufferView);
+		mCommandList->SetPipelineState(mPackedPSO.Get());
+		mTerrain->Draw(mCommandList.Get(), pDynamicResources->pCurrentFrameResource, mVisible.data());
+	}
+
+	// The water is packed in every mode
+	DefaultDrawable::SetVBAndIB(mCommandList.Get(), packedGeometry.VertexBufferView, packedGeometry.IndexBufferView);
+	mCommandList->SetPipelineState(mPackedBlendPSO.Get());
+
+	mWater->Draw(mCommandList.Get(), pDynamicResources->pCurrentFrameResource,
+		mVisible.data() + packedGeometry.TerrainSubmeshCount);
+
+}
+
+void D3DApplication::DrawTerrainLod()
+{
+	const GEOMETRY_DESCRIPTOR& geometry = pStaticResources->Geometries[GEOMETRY_TERRAIN_LOD];
+	const SubmeshGeometry& patch = geometry.Submeshes[0];
+	const UINT quarter = patch.IndexCount / 4;
+
+	DefaultDrawable::SetVBAndIB(mCommandList.Get(), geometry.VertexBufferView, geometry.IndexBufferView);
+	mCommandList->SetPipelineState(mTerrainLodPSO.Get());
+	mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	mTerrain->SetRootParameters(mCommandList.Get(), pDynamicResources->pCurrentFrameResource);
+
+	TerrainPatchConstants constants;
+	constants.PatchQuads = pStaticResources->TerrainLod->GetSettings().LeafQuads;
+
+	for (const TerrainLodDraw& draw : mLodDraws)
+	{
+		constants.FirstRow = draw.FirstRow;
+		constants.FirstCol = draw.FirstCol;
+		constants.Size = draw.Size;
+		constants.MorphStart = draw.MorphStart;
+		constants.MorphEnd = draw.MorphEnd;
+
+		mCommandList->SetGraphicsRoot32BitConstants(5, sizeof(constants) / 4, &constants, 0);
+
+		// Quadrants are consecutive quarters of the patch indices
+		if (draw.Quadrant < 0)
+		{
+			mCommandList->DrawIndexedInstanced(patch.IndexCount, 1,
+				patch.StartIndexLocation, patch.BaseVertexLocation, 0);
+		}
+		else
+		{
+			mCommandList->DrawIndexedInstanced(quarter, 1,
+				patch.StartIndexLocation + draw.Quadrant * quarter, patch.BaseVertexLocation, 0);
+		}
+	}
+}
 
-	mCommandList->SetPipelineState(mBlendPSO.Get());
+void D3DApplication::DrawTerrainStream()
+{
+	// Streamed chunks stay in Vertex, they are not quantised
+	DefaultDrawable::SetVBAndIB(mCommandList.Get(), pStaticResources->StreamVertexBufferView,
+		pStaticResources->StreamIndexBufferView);
+	mCommandList->SetPipelineState(mDefaultPSO.Get());
 
-	mWater->Draw(mCommandList.Get(), pDynamicResources->pCurrentFrameResource);
+	mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	mTerrain->SetRootParameters(mCommandList.Get(), pDynamicResources->pCurrentFrameResource);
 
+	for (const SubmeshGeometry& chunk : mStreamDraws)
+	{
+		mCommandList->DrawIndexedInstanced(chunk.IndexCount, 1,
+			chunk.StartIndexLocation, chunk.BaseVertexLocation, 0);
+	}
 }
 
 void D3DApplication::Draw()
@@ -49,6 +122,18 @@ void D3DApplication::Draw()
 	// Use the default PSO
 	ThrowIfFailed(mCommandList->Reset(currCmdAlloc, mDefaultPSO.Get()));
 
+	// Copy terrain edits so they are visible in this frame
+	pStaticResources->UploadTerrainEdits(mCommandList.Get(),
+		pDynamicResources->pCurrentFrameResource->TerrainStaging.get());
+
+	// Terrain shadows of the current sun, and maps rebaked after edits
+	pStaticResources->UpdateTerrainMaps(mCommandList.Get(),
+		pDynamicResources->pCurrentFrameResource->TerrainMapStaging.get(),
+		mSunAzimuth, mSunElevation);
+
+	// Streamed chunks that finished meshing, drawn from the next frame
+	pStaticResources->UploadTerrainStream(mCommandList.Get(),
+		pDynamicResources->pCurrentFrameResource->TerrainStreamStaging.get());
 
 	// To know what to render
 	mCommandList->RSSetViewports(1, &mViewport);
@@ -125,6 +210,11 @@ void D3DApplication::UpdatePassCB()
 	XMStoreFloat4x4(&mPassCB.InvProj, XMMatrixTranspose(invProj));
 	XMStoreFloat4x4(&mPassCB.InvViewProj, XMMatrixTranspose(invViewProj));
 
+	// Planes are extracted from the untransposed matrix
+	XMFLOAT4X4 viewProjRows;
+	XMStoreFloat4x4(&viewProjRows, viewProj);
+	mViewFrustum = Frustum::FromViewProj(viewProjRows);
+
 	XMStoreFloat3(&mPassCB.EyePosW, XMLoadFloat4(&mCamera->mPosition));
 
 	mPassCB.NearZ = 1.0f;
@@ -144,8 +234,11 @@ void D3DApplication::UpdatePassCB()
 	point.Position = { 0.0f, 12.0f, 0.0f };
 	point.Strength = { 1.0f, 1.0f, 1.0f };
 
+	// Light travels away from the sun
+	const float sunHorizontal = cosf(mSunElevation);
 	Light dir = { };
-	dir.Direction = { 0.0f, -0.6f, -0.8f };
+	dir.Direction = { -sunHorizontal * cosf(mSunAzimuth), -sinf(mSunElevation),
+		sunHorizontal * sinf(mSunAzimuth) };
 	dir.Strength = { 1.0f, 1.0f, 1.0f };
 
 	//mPassCB.Lights[1] = point;
@@ -160,8 +253,114 @@ void D3DApplication::Update()
 {
 	pDynamicResources->NextFrameResource(mFence.Get());
 	pDynamicResources->UpdateConstantBuffers();
+	UpdateTerrainEdits();
+	UpdateSun();
 	mCamera->Update();
+	UpdateTerrainStream();
 	UpdatePassCB();
+	CullRenderItems();
+}
+
+void D3DApplication::UpdateCullingBounds()
+{
+	const std::vector<SubmeshGeometry>& submeshes = pStaticResources->Geometries[GEOMETRY_PACKED].Submeshes;
+
+	mCuller.Resize(submeshes.size());
+	for (size_t i = 0; i < submeshes.size(); i++)
+	{
+		mCuller.SetBox(i, submeshes[i].Bounds);
+	}
+
+	mVisible.resize(submeshes.size());
+}
+
+void D3DApplication::CullRenderItems()
+{
+	// Objects are drawn with identity world matrices, so object space
+	// bounds are world bounds
+	mCuller.Cull(mViewFrustum, mVisible.data());
+
+	if (pStaticResources->TerrainLod)
+	{
+		XMFLOAT3 eye;
+		XMStoreFloat3(&eye, XMLoadFloat4(&mCamera->mPosition));
+		pStaticResources->TerrainLod->Select(eye, mViewFrustum, mLodDraws);
+	}
+
+	if (pStaticResources->TerrainStream)
+	{
+		pStaticResources->TerrainStream->GetVisible(mViewFrustum, mStreamDraws);
+	}
+}
+
+void D3DApplication::UpdateTerrainStream()
+{
+	if (!pStaticResources->TerrainStream) return;
+
+	XMFLOAT3 eye;
+	XMStoreFloat3(&eye, XMLoadFloat4(&mCamera->mPosition));
+	pStaticResources->TerrainStream->Update(eye);
+}
+
+void D3DApplication::UpdateTerrainEdits()
+{
+	TerrainBrush brush;
+
+	if (GetAsyncKeyState(0x52)) // R key
+	{
+		brush.Mode = TERRAIN_BRUSH_RAISE;
+	}
+	else if (GetAsyncKeyState(0x46)) // F key
+	{
+		brush.Mode = TERRAIN_BRUSH_LOWER;
+	}
+	else if (GetAsyncKeyState(0x47)) // G key
+	{
+		brush.Mode = TERRAIN_BRUSH_FLATTEN;
+	}
+	else
+	{
+		// The edit is finished, occlusion and shadows catch up with it
+		pStaticResources->RebakeTerrainMaps();
+		return;
+	}
+
+	// Flatten towards the height the camera stands on
+	const DirectX::XMFLOAT4& eye = mCamera->mPosition;
+	brush.TargetHeight = (pStaticResources->GetGround()->GetHeight(eye.x, eye.z) - TERRAIN_HEIGHT_OFFSET) /
+		TERRAIN_HEIGHT_SCALE;
+	brush.Strength = 1.0f;
+
+	if (pStaticResources->ApplyTerrainBrush(brush, eye.x, eye.z))
+	{
+		UpdateCullingBounds();
+	}
+}
+
+void D3DApplication::UpdateSun()
+{
+	// Radians per second
+	const float speed = 0.2f * mTimer->DeltaTime();
+
+	if (GetAsyncKeyState(VK_LEFT))
+	{
+		mSunAzimuth += speed;
+	}
+	if (GetAsyncKeyState(VK_RIGHT))
+	{
+		mSunAzimuth -= speed;
+	}
+	if (GetAsyncKeyState(VK_UP))
+	{
+		mSunElevation += speed;
+	}
+	if (GetAsyncKeyState(VK_DOWN))
+	{
+		mSunElevation -= speed;
+	}
+
+	mSunAzimuth = fmodf(mSunAzimuth + DirectX::XM_2PI, DirectX::XM_2PI);
+	mSunElevation = (std::min)((std::max)(mSunElevation, 0.0f), DirectX::XM_PIDIV2);
 }
 
 void D3DApplication::OnMouseDown(WPARAM btnState, int x, int y)
@@ -30,10 +30,10 @@ class IDrawable
 {
 protected:
 	D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	SubmeshGeometry Submesh;
+	std::vector<SubmeshGeometry> Submeshes;		// Drawn with the same root parameters
 
-	IDrawable(D3D12_PRIMITIVE_TOPOLOGY topology, SubmeshGeometry submesh) : 
-		PrimitiveTopology(topology), Submesh(submesh) { }
+	IDrawable(D3D12_PRIMITIVE_TOPOLOGY topology, const std::vector<SubmeshGeometry>& submeshes) : 
+		PrimitiveTopology(topology), Submeshes(submeshes) { }
 
 public:
 	
@@ -50,16 +50,24 @@ public:
 	 * 
 	 * \param pCmdList Command List
 	 * \param pCurrentFrameResource Current FrameResource
+	 * \param pVisible One flag per submesh, 0 skips it, nullptr draws all
 	 */
 	void Draw(ID3D12GraphicsCommandList* pCmdList,
-		FrameResource* pCurrentFrameResource)
+		FrameResource* pCurrentFrameResource,
+		const uint8_t* pVisible = nullptr)
 	{
 		pCmdList->IASetPrimitiveTopology(PrimitiveTopology);
 
 		SetRootParameters(pCmdList, pCurrentFrameResource);
 
-		pCmdList->DrawIndexedInstanced(Submesh.IndexCount, 1,
-			Submesh.StartIndexLocation, Submesh.BaseVertexLocation, 0);
+		for (size_t i = 0; i < Submeshes.size(); i++)
+		{
+			if (pVisible && !pVisible[i]) continue;
+
+			const SubmeshGeometry& submesh = Submeshes[i];
+			pCmdList->DrawIndexedInstanced(submesh.IndexCount, 1,
+				submesh.StartIndexLocation, submesh.BaseVertexLocation, 0);
+		}
 	}
 
 protected:
@@ -79,7 +87,18 @@ public:
 		D3D12_GPU_DESCRIPTOR_HANDLE textureDescriptorHandle,
 		D3D12_PRIMITIVE_TOPOLOGY primitiveTypology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) : 
 
-		IDrawable(primitiveTypology, submesh),
+		DefaultDrawable(std::vector<SubmeshGeometry>{ submesh }, objectCBIndex,
+			materialCBIndex, textureDescriptorHandle, primitiveTypology)
+	{	
+	}
+
+	// Drawable consisting of several submeshes, e.g. terrain chunks
+	DefaultDrawable(const std::vector<SubmeshGeometry>& submeshes,
+		UINT objectCBIndex, UINT materialCBIndex,
+		D3D12_GPU_DESCRIPTOR_HANDLE textureDescriptorHandle,
+		D3D12_PRIMITIVE_TOPOLOGY primitiveTypology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST) : 
+
+		IDrawable(primitiveTypology, submeshes),
 		ObjectCBIndex(objectCBIndex),
 		MaterialCBIndex(materialCBIndex),
 		TextureHandle(textureDescriptorHandle)
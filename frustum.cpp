@@ -0,0 +1,277 @@
+/*****************************************************************//**
+ * \file   frustum.cpp
+ * \brief  View frustum planes and bounding volume tests
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "frustum.h"
+
+using namespace DirectX;
+
+Frustum Frustum::FromViewProj(const XMFLOAT4X4& m)
+{
+	// Clip coordinates are v * M, so plane k is a combination of
+	// matrix columns (Gribb-Hartmann, D3D depth range [0, 1])
+	Frustum f;
+	for (int i = 0; i < 4; i++)
+	{
+		float c0 = m.m[i][0];
+		float c1 = m.m[i][1];
+		float c2 = m.m[i][2];
+		float c3 = m.m[i][3];
+
+		(&f.Planes[0].x)[i] = c3 + c0;		// Left
+		(&f.Planes[1].x)[i] = c3 - c0;		// Right
+		(&f.Planes[2].x)[i] = c3 + c1;		// Bottom
+		(&f.Planes[3].x)[i] = c3 - c1;		// Top
+		(&f.Planes[4].x)[i] = c2;			// Near
+		(&f.Planes[5].x)[i] = c3 - c2;		// Far
+	}
+
+	// Normalize so that plane equations give distances
+	for (XMFLOAT4& p : f.Planes)
+	{
+		float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+		if (length > 0.0f)
+		{
+			p.x /= length;
+			p.y /= length;
+			p.z /= length;
+			p.w /= length;
+		}
+	}
+
+	return f;
+}
+
+bool Frustum::IntersectsBox(const BoundingBoxAA& box) const
+{
+	for (const XMFLOAT4& p : Planes)
+	{
+		// Corner of the box farthest along the plane normal
+		float x = p.x >= 0.0f ? box.Max.x : box.Min.x;
+		float y = p.y >= 0.0f ? box.Max.y : box.Min.y;
+		float z = p.z >= 0.0f ? box.Max.z : box.Min.z;
+
+		if (p.x * x + p.y * y + p.z * z + p.w < 0.0f) return false;
+	}
+	return true;
+}
+
+float DistanceSquared(const BoundingBoxAA& box, const XMFLOAT3& point)
+{
+	float dx = 0.0f, dy = 0.0f, dz = 0.0f;
+
+	if (point.x < box.Min.x) dx = box.Min.x - point.x;
+	else if (point.x > box.Max.x) dx = point.x - box.Max.x;
+
+	if (point.y < box.Min.y) dy = box.Min.y - point.y;
+	else if (point.y > box.Max.y) dy = point.y - box.Max.y;
+
+	if (point.z < box.Min.z) dz = box.Min.z - point.z;
+	else if (point.z > box.Max.z) dz = point.z - box.Max.z;
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
+void ComputeBounds(const XMFLOAT3* pPositions, size_t count, size_t stride,
+	BoundingBoxAA& box, BoundingSphere& sphere)
+{
+	box = BoundingBoxAA();
+	sphere = BoundingSphere();
+	if (count == 0) return;
+
+	auto position = [&](size_t i) -> const XMFLOAT3&
+	{
+		return *reinterpret_cast<const XMFLOAT3*>(reinterpret_cast<const uint8_t*>(pPositions) + i * stride);
+	};
+
+	box.Min = box.Max = position(0);
+	for (size_t i = 1; i < count; i++)
+	{
+		const XMFLOAT3& p = position(i);
+		box.Min.x = (std::min)(box.Min.x, p.x);
+		box.Min.y = (std::min)(box.Min.y, p.y);
+		box.Min.z = (std::min)(box.Min.z, p.z);
+		box.Max.x = (std::max)(box.Max.x, p.x);
+		box.Max.y = (std::max)(box.Max.y, p.y);
+		box.Max.z = (std::max)(box.Max.z, p.z);
+	}
+
+	sphere.Center = XMFLOAT3(0.5f * (box.Min.x + box.Max.x), 0.5f * (box.Min.y + box.Max.y),
+		0.5f * (box.Min.z + box.Max.z));
+
+	float radiusSq = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const XMFLOAT3& p = position(i);
+		float dx = p.x - sphere.Center.x;
+		float dy = p.y - sphere.Center.y;
+		float dz = p.z - sphere.Center.z;
+		radiusSq = (std::max)(radiusSq, dx * dx + dy * dy + dz * dz);
+	}
+	sphere.Radius = std::sqrt(radiusSq);
+}
+
+void FrustumCuller::Resize(size_t count)
+{
+	mCount = count;
+
+	mCenterX.resize(count, 0.0f);
+	mCenterY.resize(count, 0.0f);
+	mCenterZ.resize(count, 0.0f);
+	mExtentX.resize(count, 0.0f);
+	mExtentY.resize(count, 0.0f);
+	mExtentZ.resize(count, 0.0f);
+}
+
+void FrustumCuller::SetBox(size_t index, const BoundingBoxAA& box)
+{
+	mCenterX[index] = 0.5f * (box.Min.x + box.Max.x);
+	mCenterY[index] = 0.5f * (box.Min.y + box.Max.y);
+	mCenterZ[index] = 0.5f * (box.Min.z + box.Max.z);
+	mExtentX[index] = 0.5f * (box.Max.x - box.Min.x);
+	mExtentY[index] = 0.5f * (box.Max.y - box.Min.y);
+	mExtentZ[index] = 0.5f * (box.Max.z - box.Min.z);
+}
+
+// Plane with the absolute values of its normal, for the projected extent
+struct cull_plane
+{
+	float x, y, z, w;
+	float absX, absY, absZ;
+};
+
+static void cull_scalar(const cull_plane* pPlanes, const float* pCX, const float* pCY, const float* pCZ,
+	const float* pEX, const float* pEY, const float* pEZ, size_t begin, size_t count, uint8_t* pVisible)
+{
+	for (size_t i = begin; i < count; i++)
+	{
+		uint8_t inside = 1;
+		for (int k = 0; k < 6 && inside; k++)
+		{
+			const cull_plane& p = pPlanes[k];
+			float distance = p.x * pCX[i] + p.y * pCY[i] + p.z * pCZ[i] + p.w;
+			float radius = p.absX * pEX[i] + p.absY * pEY[i] + p.absZ * pEZ[i];
+			if (distance + radius < 0.0f) inside = 0;
+		}
+		pVisible[i] = inside;
+	}
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_SSE41 static size_t cull_sse41(const cull_plane* pPlanes, const float* pCX, const float* pCY, const float* pCZ,
+	const float* pEX, const float* pEY, const float* pEZ, size_t count, uint8_t* pVisible)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(pCX + i);
+		const __m128 cy = _mm_loadu_ps(pCY + i);
+		const __m128 cz = _mm_loadu_ps(pCZ + i);
+		const __m128 ex = _mm_loadu_ps(pEX + i);
+		const __m128 ey = _mm_loadu_ps(pEY + i);
+		const __m128 ez = _mm_loadu_ps(pEZ + i);
+
+		// Lanes of boxes behind any plane
+		__m128 outside = _mm_setzero_ps();
+		for (int k = 0; k < 6; k++)
+		{
+			const cull_plane& p = pPlanes[k];
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(p.x), cx), _mm_mul_ps(_mm_set1_ps(p.y), cy)),
+				_mm_mul_ps(_mm_set1_ps(p.z), cz)), _mm_set1_ps(p.w));
+			__m128 radius = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(p.absX), ex), _mm_mul_ps(_mm_set1_ps(p.absY), ey)),
+				_mm_mul_ps(_mm_set1_ps(p.absZ), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			pVisible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+		}
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2 static size_t cull_avx2(const cull_plane* pPlanes, const float* pCX, const float* pCY, const float* pCZ,
+	const float* pEX, const float* pEY, const float* pEZ, size_t count, uint8_t* pVisible)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(pCX + i);
+		const __m256 cy = _mm256_loadu_ps(pCY + i);
+		const __m256 cz = _mm256_loadu_ps(pCZ + i);
+		const __m256 ex = _mm256_loadu_ps(pEX + i);
+		const __m256 ey = _mm256_loadu_ps(pEY + i);
+		const __m256 ez = _mm256_loadu_ps(pEZ + i);
+
+		__m256 outside = _mm256_setzero_ps();
+		for (int k = 0; k < 6; k++)
+		{
+			const cull_plane& p = pPlanes[k];
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(p.x), cx), _mm256_mul_ps(_mm256_set1_ps(p.y), cy)),
+				_mm256_mul_ps(_mm256_set1_ps(p.z), cz)), _mm256_set1_ps(p.w));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(p.absX), ex), _mm256_mul_ps(_mm256_set1_ps(p.absY), ey)),
+				_mm256_mul_ps(_mm256_set1_ps(p.absZ), ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius),
+				_mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		// One byte per box, 1 - visible
+		__m128i lanes = _mm_packs_epi32(
+			_mm256_castsi256_si128(_mm256_castps_si256(outside)),
+			_mm256_extracti128_si256(_mm256_castps_si256(outside), 1));
+		__m128i bytes = _mm_add_epi8(_mm_packs_epi16(lanes, lanes), _mm_set1_epi8(1));
+		_mm_storel_epi64((__m128i*)(pVisible + i), bytes);
+	}
+	return i;
+}
+
+#endif
+
+size_t FrustumCuller::Cull(const Frustum& frustum, uint8_t* pVisible, SIMD_LEVEL level) const
+{
+	cull_plane planes[6];
+	for (int k = 0; k < 6; k++)
+	{
+		const XMFLOAT4& p = frustum.Planes[k];
+		planes[k] = { p.x, p.y, p.z, p.w, std::fabs(p.x), std::fabs(p.y), std::fabs(p.z) };
+	}
+
+	size_t done = 0;
+
+#if SIMD_X86
+	if (level >= SIMD_LEVEL_AVX2)
+	{
+		done = cull_avx2(planes, mCenterX.data(), mCenterY.data(), mCenterZ.data(),
+			mExtentX.data(), mExtentY.data(), mExtentZ.data(), mCount, pVisible);
+	}
+	else if (level >= SIMD_LEVEL_SSE41)
+	{
+		done = cull_sse41(planes, mCenterX.data(), mCenterY.data(), mCenterZ.data(),
+			mExtentX.data(), mExtentY.data(), mExtentZ.data(), mCount, pVisible);
+	}
+#endif
+
+	// Remaining boxes
+	cull_scalar(planes, mCenterX.data(), mCenterY.data(), mCenterZ.data(),
+		mExtentX.data(), mExtentY.data(), mExtentZ.data(), done, mCount, pVisible);
+
+	size_t visible = 0;
+	for (size_t i = 0; i < mCount; i++)
+	{
+		visible += pVisible[i];
+	}
+	return visible;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************//**
+ * \file   frustum.h
+ * \brief  View frustum planes and bounding volume tests
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "simd_util.h"
+
+// Axis-aligned bounding box
+struct BoundingBoxAA
+{
+	DirectX::XMFLOAT3 Min = { };
+	DirectX::XMFLOAT3 Max = { };
+};
+
+struct BoundingSphere
+{
+	DirectX::XMFLOAT3 Center = { };
+	float Radius = 0.0f;
+};
+
+/**
+ * Six planes of a view frustum. Plane (a, b, c, d) keeps points
+ * with a*x + b*y + c*z + d >= 0, normals point inside.
+ */
+struct Frustum
+{
+	DirectX::XMFLOAT4 Planes[6] = { };
+
+	// Extracts planes from a row-vector view-projection matrix,
+	// as built in D3DApplication::UpdatePassCB (before transposing)
+	static Frustum FromViewProj(const DirectX::XMFLOAT4X4& viewProj);
+
+	// True if the box is at least partially inside
+	bool IntersectsBox(const BoundingBoxAA& box) const;
+};
+
+// Squared distance from the point to the closest point of the box
+float DistanceSquared(const BoundingBoxAA& box, const DirectX::XMFLOAT3& point);
+
+// Tight box around count positions stride bytes apart, and the sphere
+// around its centre through the farthest position
+void ComputeBounds(const DirectX::XMFLOAT3* pPositions, size_t count, size_t stride,
+	BoundingBoxAA& box, BoundingSphere& sphere);
+
+/**
+ * Tests many boxes against a frustum. Boxes are kept as centre and half
+ * extent, one array per component, so that a plane is tested against
+ * 4 (SSE4.1) or 8 (AVX2) boxes per instruction. A box is culled if
+ * its centre distance plus the projected extent is behind any plane,
+ * which is Frustum::IntersectsBox up to rounding.
+ */
+class FrustumCuller
+{
+public:
+	// Boxes are set one by one, new ones are empty at the origin
+	void Resize(size_t count);
+	void SetBox(size_t index, const BoundingBoxAA& box);
+
+	// pVisible receives 1 for every box at least partially inside, 0
+	// otherwise. Returns the number of visible boxes.
+	size_t Cull(const Frustum& frustum, uint8_t* pVisible,
+		SIMD_LEVEL level = GetSimdLevel()) const;
+
+	size_t GetCount() const { return mCount; }
+
+private:
+	size_t mCount = 0;
+
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mExtentX;
+	std::vector<float> mExtentY;
+	std::vector<float> mExtentZ;
+};
@@ -7,15 +7,69 @@
  *********************************************************************/
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
 #include <vector>
 
 #include "d3dUtil.h"
+#include "mesh_optimizer.h"
 #include "structures.h"
+#include "vertex_packing.h"
+
+// Maps index type to the matching DXGI format
+template<typename TIndex> struct IndexFormatTraits;
+
+template<> struct IndexFormatTraits<uint16_t>
+{
+    static const DXGI_FORMAT Format = DXGI_FORMAT_R16_UINT;
+};
+
+template<> struct IndexFormatTraits<uint32_t>
+{
+    static const DXGI_FORMAT Format = DXGI_FORMAT_R32_UINT;
+};
+
+template<typename T, typename TIndex> class StaticGeometryUploader;
+class HeightmapImage;
+class mapped_file;
+
+template<typename TIndex>
+void CreateGrid(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, UINT numRows, float cellLength);
+template<typename TIndex>
+UINT CreateTerrain(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, std::string filename);
+// pVertexRemaps, if not null, receives for every chunk the position of
+// each grid vertex in its submesh, see StaticGeometryUploader::AddVertexData
+template<typename TIndex>
+UINT CreateTerrain(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, HeightmapImage& heightmap,
+    std::vector<std::vector<uint32_t>>* pVertexRemaps = nullptr);
+// Same as CreateTerrain, but loads the mesh from cacheFile when it was
+// generated from the same heightmap, otherwise generates and stores it there.
+// A loaded mesh is uploaded straight from cache, which must stay mapped
+// until the geometry is constructed.
+template<typename TIndex>
+UINT CreateTerrainCached(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, HeightmapImage& heightmap,
+    std::string cacheFile, mapped_file& cache, std::vector<std::vector<uint32_t>>* pVertexRemaps = nullptr);
+// Simplified terrain within maxError world units of the full grid, one
+// submesh per chunk that has triangles, see TerrainRtin. 0 on errors.
+template<typename TIndex>
+UINT CreateTerrainRtin(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, HeightmapImage& heightmap, float maxError);
+template<typename TIndex>
+void CreatePlane(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, UINT n, UINT m, float width, float depth);
+// Shared patch of terrain LOD draws, see BuildTerrainLodPatch. Triangles
+// keep their quadrant order, so the submesh is never optimized.
+template<typename TIndex>
+void CreateTerrainLodPatch(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, UINT quads);
 
 // Class defining a mesh which could consist of multiple
 // submeshes that share the same vertex and index buffers.
-// Can specify user-defined vertex structure
-template<typename T>
+// Can specify user-defined vertex structure and index type
+// (uint16_t or uint32_t). Indices are relative to the base
+// vertex of the submesh, so 16-bit indices are enough as long
+// as every submesh has at most 65536 vertices.
+template<typename T, typename TIndex = uint16_t>
 class StaticGeometryUploader
 {
 private:
@@ -27,14 +81,24 @@ private:
     UINT mVertexByteStride = 0; // Identify byte size of each vertex object
     UINT mVertexBufferByteSize = 0; // Byte size of the entire VB
 
-    DXGI_FORMAT mIndexFormat = DXGI_FORMAT_R16_UINT; // Basically IB stride
+    DXGI_FORMAT mIndexFormat = IndexFormatTraits<TIndex>::Format; // Basically IB stride
     UINT mIndexBufferByteSize = 0;   // Size of the IB
 
+    // Submeshes added with AddMappedSubmeshes are read in place and come
+    // first in the buffers, the ones added with AddVertexData follow
+    const T* mpMappedVertices = nullptr;
+    size_t mMappedVertexCount = 0;
+    const TIndex* mpMappedIndices = nullptr;
+    size_t mMappedIndexCount = 0;
+
     std::vector<T> mRawVertexData;
-    std::vector<uint16_t> mRawIndexData;
+    std::vector<TIndex> mRawIndexData;
 
     std::vector<SubmeshGeometry> mSubmeshes;
 
+    // Reorder submeshes for vertex cache and vertex fetch when added
+    bool mOptimizeMeshes = false;
+
     // Pointers to D3D interfaces
     ID3D12Device* mpd3dDevice = nullptr;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mpCmdList = nullptr;
@@ -61,18 +125,73 @@ public:
         UINT64& currentFence)
     {
         // Set the remaining fields for VB and IB descriptors
-        mVertexBufferByteSize = static_cast<UINT>(mRawVertexData.size()) * mVertexByteStride;
-        mIndexBufferByteSize = static_cast<UINT>(mRawIndexData.size()) * sizeof(uint16_t);
+        mVertexBufferByteSize = static_cast<UINT>(GetVertexCount()) * mVertexByteStride;
 
         // Create default buffers
         pVertexBufferResource = CreateDefaultBuffer(
-            mpd3dDevice, mpCmdList.Get(), mRawVertexData.data(),
-            mVertexBufferByteSize, mVertexBufferUploader);
+            mpd3dDevice, mpCmdList.Get(), mVertexBufferByteSize, mVertexBufferUploader,
+            [this](uint8_t* pData)
+            {
+                T* pDst = reinterpret_cast<T*>(pData);
+                if (mMappedVertexCount > 0) memcpy(pDst, mpMappedVertices, mMappedVertexCount * sizeof(T));
+                if (!mRawVertexData.empty())
+                {
+                    memcpy(pDst + mMappedVertexCount, mRawVertexData.data(), mRawVertexData.size() * sizeof(T));
+                }
+            });
+
+        CreateIndexBuffer(pIndexBufferResource);
+
+        ExecuteUpload(pVertexBufferResource, pIndexBufferResource, pQueue, pFence, currentFence);
+    }
+
+private:
+    // Vertices of all submeshes, mapped and added ones
+    size_t GetVertexCount() const
+    {
+        return mMappedVertexCount + mRawVertexData.size();
+    }
+
+    // Vertex at position index of the vertex buffer. A submesh is either
+    // mapped or added, so its vertices follow each other from here.
+    const T* GetVertices(size_t index) const
+    {
+        return index < mMappedVertexCount ? mpMappedVertices + index :
+            mRawVertexData.data() + (index - mMappedVertexCount);
+    }
+
+    // One past the last vertex of submesh i
+    size_t SubmeshVertexEnd(size_t i) const
+    {
+        return i + 1 < mSubmeshes.size() ?
+            static_cast<size_t>(mSubmeshes[i + 1].BaseVertexLocation) : GetVertexCount();
+    }
+
+    // Mapped indices, then the added ones, straight into the upload buffer
+    void CreateIndexBuffer(Microsoft::WRL::ComPtr<ID3D12Resource>& pIndexBufferResource)
+    {
+        mIndexBufferByteSize = static_cast<UINT>(mMappedIndexCount + mRawIndexData.size()) * sizeof(TIndex);
 
         pIndexBufferResource = CreateDefaultBuffer(
-            mpd3dDevice, mpCmdList.Get(), mRawIndexData.data(),
-            mIndexBufferByteSize, mIndexBufferUploader);
+            mpd3dDevice, mpCmdList.Get(), mIndexBufferByteSize, mIndexBufferUploader,
+            [this](uint8_t* pData)
+            {
+                TIndex* pDst = reinterpret_cast<TIndex*>(pData);
+                if (mMappedIndexCount > 0) memcpy(pDst, mpMappedIndices, mMappedIndexCount * sizeof(TIndex));
+                if (!mRawIndexData.empty())
+                {
+                    memcpy(pDst + mMappedIndexCount, mRawIndexData.data(), mRawIndexData.size() * sizeof(TIndex));
+                }
+            });
+    }
 
+    // Submits the recorded copies and waits for them
+    void ExecuteUpload(Microsoft::WRL::ComPtr<ID3D12Resource>& pVertexBufferResource,
+        Microsoft::WRL::ComPtr<ID3D12Resource>& pIndexBufferResource,
+        ID3D12CommandQueue* pQueue,
+        ID3D12Fence* pFence,
+        UINT64& currentFence)
+    {
         ThrowIfFailed(mpCmdList->Close());
         ID3D12CommandList* commandLists[] = { mpCmdList.Get() };
         pQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
@@ -103,28 +222,160 @@ public:
         DisposeUploaders();
     }
 
+public:
+    /**
+     * Same as ConstructGeometry, but the vertex buffer holds PackedVertex.
+     * Vertices of submesh i are quantised with quantizations[i], which
+     * must cover them, see QuantizeSubmeshes. Only valid for Vertex.
+     */
+    void ConstructPackedGeometry(Microsoft::WRL::ComPtr<ID3D12Resource>& pVertexBufferResource,
+        Microsoft::WRL::ComPtr<ID3D12Resource>& pIndexBufferResource,
+        const std::vector<VertexQuantization>& quantizations,
+        ID3D12CommandQueue* pQueue,
+        ID3D12Fence* pFence,
+        UINT64& currentFence)
+    {
+        assert(quantizations.size() == mSubmeshes.size());
+
+        mVertexByteStride = sizeof(PackedVertex);
+        mVertexBufferByteSize = static_cast<UINT>(GetVertexCount()) * mVertexByteStride;
+
+        // Submeshes follow each other in the vertex data and are packed
+        // from where they are, mapped ones straight from the file
+        pVertexBufferResource = CreateDefaultBuffer(
+            mpd3dDevice, mpCmdList.Get(), mVertexBufferByteSize, mVertexBufferUploader,
+            [&](uint8_t* pData)
+            {
+                PackedVertex* pPacked = reinterpret_cast<PackedVertex*>(pData);
+                for (size_t i = 0; i < mSubmeshes.size(); i++)
+                {
+                    const size_t first = static_cast<size_t>(mSubmeshes[i].BaseVertexLocation);
+                    const size_t end = SubmeshVertexEnd(i);
+
+                    if (end > first)
+                    {
+                        PackVertices(GetVertices(first), end - first, quantizations[i], pPacked + first);
+                    }
+                }
+            });
+
+        // The float vertices are not needed past this point
+        std::vector<T>().swap(mRawVertexData);
+        mpMappedVertices = nullptr;
+        mMappedVertexCount = 0;
+
+        CreateIndexBuffer(pIndexBufferResource);
+
+        ExecuteUpload(pVertexBufferResource, pIndexBufferResource, pQueue, pFence, currentFence);
+    }
+
+    // Quantisation spanning the vertices of count submeshes from first
+    VertexQuantization QuantizeSubmeshes(UINT first, UINT count) const
+    {
+        if (count == 0) return VertexQuantization();
+
+        const size_t begin = static_cast<size_t>(mSubmeshes[first].BaseVertexLocation);
+        const size_t end = SubmeshVertexEnd(first + count - 1);
+
+        // Mapped and added vertices are apart in memory
+        assert(end <= mMappedVertexCount || begin >= mMappedVertexCount);
+        return ComputeVertexQuantization(GetVertices(begin), end - begin);
+    }
+
+    // Submeshes added afterwards are reordered for the post-transform
+    // vertex cache. Only valid for triangle lists
+    void EnableMeshOptimization(bool enable)
+    {
+        mOptimizeMeshes = enable;
+    }
+
     const std::vector<SubmeshGeometry> GetSubmeshes()const
     {
         return mSubmeshes;
     }
 
 private:
-    // Takes raw vertex and index data and returns associated submesh in common buffer
-    void AddVertexData(std::vector<T> vertices, std::vector<uint16_t> indices)
+    // Takes raw vertex and index data and returns associated submesh in common buffer.
+    // Source indices may be narrower than TIndex, they are widened on merge.
+    // pVertexRemap, if not null, receives the position of every source
+    // vertex in the submesh, which changes when meshes are optimized.
+    template<typename TSrcIndex>
+    void AddVertexData(const std::vector<T>& vertices, const std::vector<TSrcIndex>& indices,
+        std::vector<uint32_t>* pVertexRemap = nullptr)
     {
+        AddVertexData(vertices.data(), vertices.size(), indices.data(), indices.size(), pVertexRemap);
+    }
+
+    template<typename TSrcIndex>
+    void AddVertexData(const T* pVertices, size_t vertexCount,
+        const TSrcIndex* pIndices, size_t indexCount,
+        std::vector<uint32_t>* pVertexRemap = nullptr)
+    {
+        // Indices are relative to BaseVertexLocation, so only
+        // the submesh itself has to be addressable by TIndex. Checked in
+        // release builds too, wider submeshes would wrap their indices.
+        ThrowIfFailed(vertexCount <= static_cast<size_t>((std::numeric_limits<TIndex>::max)()) + 1 ?
+            S_OK : E_INVALIDARG);
+
+        const size_t rawVertex = mRawVertexData.size();
+        const size_t rawIndex = mRawIndexData.size();
+
         SubmeshGeometry submesh = { };
-        submesh.BaseVertexLocation = static_cast<INT>(mRawVertexData.size());
-        submesh.StartIndexLocation = static_cast<UINT>(mRawIndexData.size());
-        submesh.IndexCount = static_cast<UINT>(indices.size());
+        submesh.BaseVertexLocation = static_cast<INT>(mMappedVertexCount + rawVertex);
+        submesh.StartIndexLocation = static_cast<UINT>(mMappedIndexCount + rawIndex);
+        submesh.IndexCount = static_cast<UINT>(indexCount);
+
+        if (vertexCount > 0)
+        {
+            ComputeBounds(&pVertices[0].Pos, vertexCount, sizeof(T), submesh.Bounds, submesh.Sphere);
+        }
 
         mSubmeshes.push_back(submesh);
 
         // Merge the vectors
         mRawVertexData.insert(std::end(mRawVertexData),
-            std::begin(vertices), std::end(vertices));
+            pVertices, pVertices + vertexCount);
 
         mRawIndexData.insert(std::end(mRawIndexData),
-            std::begin(indices), std::end(indices));
+            pIndices, pIndices + indexCount);
+
+        // Reorder triangles of the new submesh for the post-transform
+        // cache, then its vertices in order of first use
+        if (mOptimizeMeshes && indexCount > 0)
+        {
+            TIndex* pSubmeshIndices = &mRawIndexData[rawIndex];
+
+            std::vector<uint32_t> remap;
+            OptimizeVertexCache(pSubmeshIndices, indexCount, vertexCount);
+            OptimizeVertexFetch(&mRawVertexData[rawVertex], vertexCount,
+                pSubmeshIndices, indexCount, remap);
+
+            if (pVertexRemap) pVertexRemap->swap(remap);
+        }
+        else if (pVertexRemap)
+        {
+            pVertexRemap->resize(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++) (*pVertexRemap)[v] = static_cast<uint32_t>(v);
+        }
+    }
+
+    // Adds submeshes that are ready for upload, e.g. read from a cache,
+    // without copying them. The data is read in place until the geometry
+    // is constructed, so it must stay valid until then. Only before any
+    // other submesh. Offsets of the submeshes are relative to pVertices
+    // and pIndices.
+    void AddMappedSubmeshes(const T* pVertices, size_t vertexCount,
+        const TIndex* pIndices, size_t indexCount,
+        const SubmeshGeometry* pSubmeshes, size_t submeshCount)
+    {
+        assert(mSubmeshes.empty() && mpMappedVertices == nullptr);
+
+        mpMappedVertices = pVertices;
+        mMappedVertexCount = vertexCount;
+        mpMappedIndices = pIndices;
+        mMappedIndexCount = indexCount;
+
+        mSubmeshes.insert(std::end(mSubmeshes), pSubmeshes, pSubmeshes + submeshCount);
     }
 
 public:
@@ -161,14 +412,23 @@ private:
         mIndexBufferUploader = nullptr;
     }
 
-    friend void CreateGrid(StaticGeometryUploader<Vertex>* meshGeometry, UINT numRows, float cellLength);
-    friend void CreateTerrain(StaticGeometryUploader<Vertex>* meshGeometry, std::string filename);
-    friend void CreatePlane(StaticGeometryUploader<Vertex>* meshGeometry, UINT n, UINT m, float width, float depth);
+    template<typename I>
+    friend void CreateGrid(StaticGeometryUploader<Vertex, I>* meshGeometry, UINT numRows, float cellLength);
+    template<typename I>
+    friend UINT CreateTerrain(StaticGeometryUploader<Vertex, I>* meshGeometry, std::string filename);
+    template<typename I>
+    friend UINT CreateTerrain(StaticGeometryUploader<Vertex, I>* meshGeometry, HeightmapImage& heightmap,
+        std::vector<std::vector<uint32_t>>* pVertexRemaps);
+    template<typename I>
+    friend UINT CreateTerrainCached(StaticGeometryUploader<Vertex, I>* meshGeometry, HeightmapImage& heightmap,
+        std::string cacheFile, mapped_file& cache, std::vector<std::vector<uint32_t>>* pVertexRemaps);
+    template<typename I>
+    friend UINT CreateTerrainRtin(StaticGeometryUploader<Vertex, I>* meshGeometry, HeightmapImage& heightmap, float maxError);
+    template<typename I>
+    friend void CreatePlane(StaticGeometryUploader<Vertex, I>* meshGeometry, UINT n, UINT m, float width, float depth);
+    template<typename I>
+    friend void CreateTerrainLodPatch(StaticGeometryUploader<Vertex, I>* meshGeometry, UINT quads);
 
 };
 
-void CreateGrid(StaticGeometryUploader<Vertex>* meshGeometry, UINT numRows, float cellLength);
-void CreateTerrain(StaticGeometryUploader<Vertex>* meshGeometry, std::string filename);
-void CreatePlane(StaticGeometryUploader<Vertex>* meshGeometry, UINT n, UINT m, float width, float depth);
-
 
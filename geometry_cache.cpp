@@ -0,0 +1,237 @@
+/*****************************************************************//**
+ * \file   geometry_cache.cpp
+ * \brief  On-disk cache of generated terrain meshes
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "geometry_cache.h"
+#include "image_helper.h"
+#include "memory_util.h"
+#include "terrain_mesh.h"
+
+// 64-bit FNV-1a constants
+#define CACHE_HASH_BASIS 0xCBF29CE484222325ull
+#define CACHE_HASH_PRIME 0x100000001B3ull
+
+// Heightmap rows hashed per read
+#define CACHE_HASH_BAND_ROWS 64
+
+// FNV-1a over 64-bit words, high bits folded down after every multiply
+// as they would not reach the low bits otherwise
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+
+	for (; size >= 8; size -= 8, p += 8)
+	{
+		uint64_t word;
+		memcpy(&word, p, 8);
+
+		hash = (hash ^ word) * CACHE_HASH_PRIME;
+		hash ^= hash >> 32;
+	}
+
+	for (; size > 0; size--, p++)
+	{
+		hash = (hash ^ *p) * CACHE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+template<typename TValue>
+static uint64_t hash_value(uint64_t hash, TValue value)
+{
+	return hash_bytes(hash, &value, sizeof(value));
+}
+
+static uint64_t align_offset(uint64_t offset)
+{
+	return (offset + GEOMETRY_CACHE_ALIGNMENT - 1) & ~(uint64_t)(GEOMETRY_CACHE_ALIGNMENT - 1);
+}
+
+uint64_t TerrainCacheKey(const HeightmapImage& heightmap, uint32_t vertexStride,
+	uint32_t indexStride, bool optimized)
+{
+	const uint32_t width = heightmap.GetWidth();
+	const uint32_t height = heightmap.GetHeight();
+
+	uint64_t hash = CACHE_HASH_BASIS;
+	hash = hash_value(hash, GEOMETRY_CACHE_VERSION);
+	hash = hash_value(hash, (uint32_t)TERRAIN_CHUNK_QUADS);
+	hash = hash_value(hash, vertexStride);
+	hash = hash_value(hash, indexStride);
+	hash = hash_value(hash, (uint32_t)optimized);
+	hash = hash_value(hash, width);
+	hash = hash_value(hash, height);
+
+	// Samples only, row padding does not change the mesh
+	std::vector<uint8_t> band(static_cast<size_t>(width) * CACHE_HASH_BAND_ROWS);
+	for (uint32_t row = 0; row < height; row += CACHE_HASH_BAND_ROWS)
+	{
+		const uint32_t rows = (std::min)(height - row, (uint32_t)CACHE_HASH_BAND_ROWS);
+		heightmap.ReadRegion(row, 0, rows, width, band.data(), width);
+		hash = hash_bytes(hash, band.data(), static_cast<size_t>(rows) * width);
+	}
+
+	return hash;
+}
+
+// Section of count elements of the given size fits into the file
+static bool section_valid(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize)
+{
+	if (offset % GEOMETRY_CACHE_ALIGNMENT != 0 || offset > fileSize) return false;
+	return count <= (fileSize - offset) / stride;
+}
+
+// Every value of the count at p is below limit
+template<typename TValue>
+static bool values_below(const void* p, uint64_t count, uint64_t limit)
+{
+	const TValue* pValues = static_cast<const TValue*>(p);
+	TValue largest = 0;
+	for (uint64_t i = 0; i < count; i++) largest = (std::max)(largest, pValues[i]);
+	return count == 0 || largest < limit;
+}
+
+// Indices and vertex remaps of every submesh are checked to stay within
+// its vertices, as they are uploaded and used without further checks
+int OpenGeometryCache(mapped_file& file, const char* path, uint64_t key,
+	uint32_t vertexStride, uint32_t indexStride, geometry_cache_view& view)
+{
+	if (file.open(path) != 0) return -1;
+
+	if (file.size() < sizeof(geometry_cache_header)) return -1;
+
+	const geometry_cache_header& header = *reinterpret_cast<const geometry_cache_header*>(file.data());
+	if (header.Magic != GEOMETRY_CACHE_MAGIC || header.Version != GEOMETRY_CACHE_VERSION ||
+		header.Key != key || header.VertexStride != vertexStride || header.IndexStride != indexStride)
+	{
+		return -1;
+	}
+
+	const uint64_t fileSize = file.size();
+	if (header.FileSize != fileSize ||
+		!section_valid(header.SubmeshOffset, header.SubmeshCount, sizeof(geometry_cache_submesh), fileSize) ||
+		!section_valid(header.RemapOffset, header.VertexCount, sizeof(uint32_t), fileSize) ||
+		!section_valid(header.VertexOffset, header.VertexCount, vertexStride, fileSize) ||
+		!section_valid(header.IndexOffset, header.IndexCount, indexStride, fileSize))
+	{
+		fprintf(stderr, "Geometry cache %s is truncated\n", path);
+		return -1;
+	}
+
+	view.pHeader = &header;
+	view.pSubmeshes = reinterpret_cast<const geometry_cache_submesh*>(file.data() + header.SubmeshOffset);
+	view.pRemaps = reinterpret_cast<const uint32_t*>(file.data() + header.RemapOffset);
+	view.pVertices = file.data() + header.VertexOffset;
+	view.pIndices = file.data() + header.IndexOffset;
+
+	// Remaps of the submeshes follow each other and cover all vertices
+	uint64_t remapCount = 0;
+	for (uint32_t i = 0; i < header.SubmeshCount; i++)
+	{
+		const geometry_cache_submesh& submesh = view.pSubmeshes[i];
+		const uint32_t* pRemap = view.pRemaps + remapCount;
+		remapCount += submesh.VertexCount;
+
+		if (submesh.BaseVertex < 0 ||
+			(uint64_t)submesh.BaseVertex + submesh.VertexCount > header.VertexCount ||
+			(uint64_t)submesh.StartIndex + submesh.IndexCount > header.IndexCount ||
+			remapCount > header.VertexCount)
+		{
+			fprintf(stderr, "Geometry cache %s is corrupted\n", path);
+			return -1;
+		}
+
+		const uint8_t* pIndices = view.pIndices + (uint64_t)submesh.StartIndex * indexStride;
+		const bool indicesValid = indexStride == sizeof(uint16_t) ?
+			values_below<uint16_t>(pIndices, submesh.IndexCount, submesh.VertexCount) :
+			values_below<uint32_t>(pIndices, submesh.IndexCount, submesh.VertexCount);
+
+		if (!indicesValid || !values_below<uint32_t>(pRemap, submesh.VertexCount, submesh.VertexCount))
+		{
+			fprintf(stderr, "Geometry cache %s is corrupted\n", path);
+			return -1;
+		}
+	}
+
+	if (remapCount != header.VertexCount)
+	{
+		fprintf(stderr, "Geometry cache %s is corrupted\n", path);
+		return -1;
+	}
+
+	return 0;
+}
+
+// Writes to a temporary file first, so a failed write never
+// leaves a cache that looks valid
+int WriteGeometryCache(const char* path, geometry_cache_header header,
+	const std::vector<geometry_cache_submesh>& submeshes,
+	const std::vector<std::vector<uint32_t>>& remaps,
+	const void* pVertices, const void* pIndices)
+{
+	header.SubmeshCount = static_cast<uint32_t>(submeshes.size());
+	header.SubmeshOffset = align_offset(sizeof(geometry_cache_header));
+	header.RemapOffset = align_offset(header.SubmeshOffset + submeshes.size() * sizeof(geometry_cache_submesh));
+	header.VertexOffset = align_offset(header.RemapOffset + header.VertexCount * sizeof(uint32_t));
+	header.IndexOffset = align_offset(header.VertexOffset + header.VertexCount * header.VertexStride);
+	header.FileSize = header.IndexOffset + header.IndexCount * header.IndexStride;
+
+	const std::string tempPath = std::string(path) + ".tmp";
+	FILE* pFile = fopen(tempPath.c_str(), "wb");
+	if (!pFile)
+	{
+		fprintf(stderr, "Failed to create %s\n", tempPath.c_str());
+		return -1;
+	}
+
+	uint64_t position = 0;
+	bool written = true;
+	auto writeSection = [&](uint64_t offset, const void* pData, uint64_t size)
+	{
+		static const uint8_t padding[GEOMETRY_CACHE_ALIGNMENT] = { };
+		written = written && fwrite(padding, 1, (size_t)(offset - position), pFile) == offset - position;
+		written = written && (size == 0 || fwrite(pData, 1, (size_t)size, pFile) == size);
+		position = offset + size;
+	};
+
+	writeSection(0, &header, sizeof(header));
+	writeSection(header.SubmeshOffset, submeshes.data(), submeshes.size() * sizeof(geometry_cache_submesh));
+
+	writeSection(header.RemapOffset, nullptr, 0);
+	for (const std::vector<uint32_t>& remap : remaps)
+	{
+		writeSection(position, remap.data(), remap.size() * sizeof(uint32_t));
+	}
+
+	writeSection(header.VertexOffset, pVertices, header.VertexCount * header.VertexStride);
+	writeSection(header.IndexOffset, pIndices, header.IndexCount * header.IndexStride);
+
+	written = fclose(pFile) == 0 && written;
+	if (!written)
+	{
+		fprintf(stderr, "Failed to write %s\n", tempPath.c_str());
+		remove(tempPath.c_str());
+		return -1;
+	}
+
+	// rename does not replace existing files on Windows
+	remove(path);
+	if (rename(tempPath.c_str(), path) != 0)
+	{
+		fprintf(stderr, "Failed to rename %s\n", tempPath.c_str());
+		remove(tempPath.c_str());
+		return -1;
+	}
+
+	return 0;
+}
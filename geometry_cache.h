@@ -0,0 +1,94 @@
+/*****************************************************************//**
+ * \file   geometry_cache.h
+ * \brief  On-disk cache of generated terrain meshes
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "structures.h"
+
+class HeightmapImage;
+class mapped_file;
+
+// 'TGEO', first bytes of every cache file
+#define GEOMETRY_CACHE_MAGIC 0x4F454754u
+
+// Increase when the file layout or the generated mesh changes, so
+// caches written by older builds are rebuilt
+#define GEOMETRY_CACHE_VERSION 1u
+
+// Sections start at multiples of this, so mapped data can be read in place
+#define GEOMETRY_CACHE_ALIGNMENT 64u
+
+/**
+ * Cache file layout: the header, then submesh records, vertex remaps,
+ * vertices and indices, each section aligned to GEOMETRY_CACHE_ALIGNMENT.
+ * Vertices and indices are stored as they are uploaded, after mesh
+ * optimization, so a hit is copied from the mapping straight into the
+ * upload buffers.
+ */
+struct geometry_cache_header
+{
+	uint32_t Magic = GEOMETRY_CACHE_MAGIC;
+	uint32_t Version = GEOMETRY_CACHE_VERSION;
+	uint64_t Key = 0;					// Hash of the source and the generator parameters
+
+	uint32_t VertexStride = 0;
+	uint32_t IndexStride = 0;
+	uint32_t SubmeshCount = 0;
+	uint32_t _pad = 0;
+
+	uint64_t VertexCount = 0;
+	uint64_t IndexCount = 0;
+
+	uint64_t SubmeshOffset = 0;			// Byte offsets of the sections
+	uint64_t RemapOffset = 0;
+	uint64_t VertexOffset = 0;
+	uint64_t IndexOffset = 0;
+	uint64_t FileSize = 0;				// Truncated files are rejected
+};
+
+// Submesh relative to the first cached vertex and index
+struct geometry_cache_submesh
+{
+	uint32_t IndexCount = 0;
+	uint32_t StartIndex = 0;
+	int32_t BaseVertex = 0;
+	uint32_t VertexCount = 0;			// Also the length of its vertex remap
+
+	BoundingBoxAA Bounds;
+	BoundingSphere Sphere;
+};
+
+// Hash of the heightmap samples and of everything the terrain mesh
+// generated from them depends on
+uint64_t TerrainCacheKey(const HeightmapImage& heightmap, uint32_t vertexStride,
+	uint32_t indexStride, bool optimized);
+
+// Sections of a mapped cache file
+struct geometry_cache_view
+{
+	const geometry_cache_header* pHeader = nullptr;
+	const geometry_cache_submesh* pSubmeshes = nullptr;
+	const uint32_t* pRemaps = nullptr;
+	const uint8_t* pVertices = nullptr;
+	const uint8_t* pIndices = nullptr;
+};
+
+// Maps the cache at path and checks it was written for key with these
+// strides, and that it is complete and consistent. 0 - hit, -1 - miss
+int OpenGeometryCache(mapped_file& file, const char* path, uint64_t key,
+	uint32_t vertexStride, uint32_t indexStride, geometry_cache_view& view);
+
+// Lays out the sections after the header and writes the file. Counts,
+// strides and the key come from header, remaps of the submeshes are
+// stored one after another. 0 - success, -1 - error
+int WriteGeometryCache(const char* path, geometry_cache_header header,
+	const std::vector<geometry_cache_submesh>& submeshes,
+	const std::vector<std::vector<uint32_t>>& remaps,
+	const void* pVertices, const void* pIndices);
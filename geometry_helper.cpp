@@ -1,15 +1,23 @@
 
+#include <cstdio>
 #include <DirectXMath.h>
 
 #include "geometry.h"
+#include "geometry_cache.h"
 #include "image_helper.h"
+#include "memory_util.h"
+#include "terrain_lod.h"
+#include "terrain_mesh.h"
+#include "terrain_rtin.h"
+#include "thread_pool.h"
 
 using namespace DirectX;
 
-void CreateGrid(StaticGeometryUploader<Vertex>* meshGeometry, UINT numRows, float cellLength)
+template<typename TIndex>
+void CreateGrid(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, UINT numRows, float cellLength)
 {
 	std::vector<Vertex> vertices;
-	std::vector<uint16_t> indices;
+	std::vector<TIndex> indices;
 
 	float offset = 0.5f * (numRows - 1) * cellLength;
 
@@ -26,10 +34,10 @@ void CreateGrid(StaticGeometryUploader<Vertex>* meshGeometry, UINT numRows, floa
 		v2.Pos = XMFLOAT3(x * cellLength - offset, 0, (numRows - 1) * cellLength - offset);
 		//v2.Color = color;
 
-		indices.push_back(static_cast<uint16_t>(vertices.size()));
+		indices.push_back(static_cast<TIndex>(vertices.size()));
 		vertices.push_back(v1);
 
-		indices.push_back(static_cast<uint16_t>(vertices.size()));
+		indices.push_back(static_cast<TIndex>(vertices.size()));
 		vertices.push_back(v2);
 
 		// Vertical columns
@@ -39,92 +47,170 @@ void CreateGrid(StaticGeometryUploader<Vertex>* meshGeometry, UINT numRows, floa
 		v4.Pos = XMFLOAT3((numRows - 1) * cellLength - offset, 0, x * cellLength - offset);
 		//v4.Color = color;
 
-		indices.push_back(static_cast<uint16_t>(vertices.size()));
+		indices.push_back(static_cast<TIndex>(vertices.size()));
 		vertices.push_back(v3);
 
-		indices.push_back(static_cast<uint16_t>(vertices.size()));
+		indices.push_back(static_cast<TIndex>(vertices.size()));
 		vertices.push_back(v4);
 	}
 
 	meshGeometry->AddVertexData(vertices, indices);
 }
 
-void CreateTerrain(StaticGeometryUploader<Vertex>* meshGeometry, std::string filename)
+template<typename TIndex>
+UINT CreateTerrain(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, std::string filename)
 {
-	std::vector<Vertex> vertices;
-	std::vector<uint16_t> indices;
-
 	// Initialize Heightmap
 	HeightmapImage heightmap(filename.c_str());
-	heightmap.write();
 
-	UINT width = heightmap.GetWidth();
-	UINT depth = heightmap.GetHeight();
+	return CreateTerrain(meshGeometry, heightmap);
+}
 
-	float dx = (float)width / static_cast<float>(width - 1);
-	float dz = (float)depth / static_cast<float>(depth - 1);
+template<typename TIndex>
+UINT CreateTerrain(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, HeightmapImage& heightmap,
+	std::vector<std::vector<uint32_t>>* pVertexRemaps)
+{
+	TerrainLayout layout(heightmap.GetWidth(), heightmap.GetHeight());
+	if (!layout.HasQuads())
+	{
+		fprintf(stderr, "Heightmap of %ux%u samples is too small for a terrain\n",
+			heightmap.GetWidth(), heightmap.GetHeight());
+		return 0;
+	}
 
-	float zeroX = -(float)width / 2;
-	float zeroZ = (float)depth / 2;
+	// Generate all chunks in parallel. Every chunk is small enough
+	// to be addressed with 16-bit indices
+	TerrainMeshData mesh;
+	BuildTerrainMesh(heightmap, layout, mesh, &WorkerPool::Default());
 
-	// Generate vertices
-	for (UINT i = 1; i < width - 1; i++)
+	if (pVertexRemaps) pVertexRemaps->resize(mesh.Chunks.size());
+
+	for (size_t i = 0; i < mesh.Chunks.size(); i++)
 	{
-		for (UINT j = 1; j < depth - 1; j++)
-		{
-			float x = zeroX + j * dx;
-			float z = zeroZ - i * dz;
+		const TerrainChunk& chunk = mesh.Chunks[i];
 
-			float height = (float)heightmap.GetPixel(j, i) / 128.0f - 5.5f;
+		meshGeometry->AddVertexData(
+			&mesh.Vertices[chunk.BaseVertex], chunk.VertexCount(),
+			&mesh.Indices[chunk.StartIndex], chunk.IndexCount(),
+			pVertexRemaps ? &(*pVertexRemaps)[i] : nullptr);
+	}
 
-			float dhj = ((float)heightmap.GetPixel(j + 1, i) - (float)heightmap.GetPixel(j - 1, i)) / 128.0f;
-			float dhi = ((float)heightmap.GetPixel(j, i + 1) - (float)heightmap.GetPixel(j, i - 1)) / 128.0f;
+	return static_cast<UINT>(mesh.Chunks.size());
+}
 
-			XMFLOAT3 n(
-				- 2 * dz * dhj,
-				4 * dx * dz,
-				- 2 * dx * dhi);
+template<typename TIndex>
+UINT CreateTerrainCached(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, HeightmapImage& heightmap,
+	std::string cacheFile, mapped_file& cache, std::vector<std::vector<uint32_t>>* pVertexRemaps)
+{
+	const uint64_t key = TerrainCacheKey(heightmap, sizeof(Vertex), sizeof(TIndex),
+		meshGeometry->mOptimizeMeshes);
 
-			// Normalize
-			XMVECTOR v = XMLoadFloat3(&n);
-			v = XMVector3Normalize(v);
-			XMStoreFloat3(&n, v);
+	// Mapped submeshes come first in the buffers
+	if (meshGeometry->mSubmeshes.empty())
+	{
+		geometry_cache_view view;
+		if (OpenGeometryCache(cache, cacheFile.c_str(), key, sizeof(Vertex), sizeof(TIndex), view) == 0)
+		{
+			const geometry_cache_header& header = *view.pHeader;
 
-			//XMFLOAT3 n(0.0f, 1.0f, 0.0f);
+			std::vector<SubmeshGeometry> submeshes(header.SubmeshCount);
+			if (pVertexRemaps) pVertexRemaps->resize(header.SubmeshCount);
 
-			//XMVECTOR posJ = XMVectorSet((float)heightmap.GetPixel(j + 1, i) - (float)heightmap.GetPixel(j - 1, i))
+			const uint32_t* pRemap = view.pRemaps;
+			for (uint32_t i = 0; i < header.SubmeshCount; i++)
+			{
+				const geometry_cache_submesh& record = view.pSubmeshes[i];
 
-			XMFLOAT2 uv(0.05 * x, 0.05 * z);
+				submeshes[i].IndexCount = record.IndexCount;
+				submeshes[i].StartIndexLocation = record.StartIndex;
+				submeshes[i].BaseVertexLocation = record.BaseVertex;
+				submeshes[i].Bounds = record.Bounds;
+				submeshes[i].Sphere = record.Sphere;
 
-			vertices.push_back(Vertex{
-				{ x, height, z }, n , uv });
+				if (pVertexRemaps) (*pVertexRemaps)[i].assign(pRemap, pRemap + record.VertexCount);
+				pRemap += record.VertexCount;
+			}
+
+			meshGeometry->AddMappedSubmeshes(
+				reinterpret_cast<const Vertex*>(view.pVertices), (size_t)header.VertexCount,
+				reinterpret_cast<const TIndex*>(view.pIndices), (size_t)header.IndexCount,
+				submeshes.data(), submeshes.size());
+
+			return header.SubmeshCount;
 		}
+
+		// Closed before the cache is written again
+		cache.close();
 	}
 
-	// Generate indices
-	for (UINT i = 0; i < width - 2; i++)
+	const size_t firstSubmesh = meshGeometry->mSubmeshes.size();
+	const size_t firstVertex = meshGeometry->mRawVertexData.size();
+	const size_t firstIndex = meshGeometry->mRawIndexData.size();
+
+	std::vector<std::vector<uint32_t>> remaps;
+	const UINT submeshCount = CreateTerrain(meshGeometry, heightmap, &remaps);
+
+	std::vector<geometry_cache_submesh> records(submeshCount);
+	for (UINT i = 0; i < submeshCount; i++)
 	{
-		for (UINT j = 0; j < depth - 2; j++)
-		{
-			// Generate indices for quad down and to the right
-			int n = width - 2;
-			indices.push_back(j + i * n);
-			indices.push_back((j + 1) + i * n);
-			indices.push_back(j + (i + 1) * n);
-
-			indices.push_back((j + 1) + i * n);
-			indices.push_back((j + 1) + (i + 1) * n);
-			indices.push_back(j + (i + 1) * n);
-		}
+		const SubmeshGeometry& submesh = meshGeometry->mSubmeshes[firstSubmesh + i];
+
+		records[i].IndexCount = submesh.IndexCount;
+		records[i].StartIndex = static_cast<uint32_t>(submesh.StartIndexLocation - firstIndex);
+		records[i].BaseVertex = static_cast<int32_t>(submesh.BaseVertexLocation - firstVertex);
+		records[i].VertexCount = static_cast<uint32_t>(remaps[i].size());
+		records[i].Bounds = submesh.Bounds;
+		records[i].Sphere = submesh.Sphere;
 	}
 
-	meshGeometry->AddVertexData(vertices, indices);
+	geometry_cache_header header;
+	header.Key = key;
+	header.VertexStride = sizeof(Vertex);
+	header.IndexStride = sizeof(TIndex);
+	header.VertexCount = meshGeometry->mRawVertexData.size() - firstVertex;
+	header.IndexCount = meshGeometry->mRawIndexData.size() - firstIndex;
+
+	WriteGeometryCache(cacheFile.c_str(), header, records, remaps,
+		meshGeometry->mRawVertexData.data() + firstVertex,
+		meshGeometry->mRawIndexData.data() + firstIndex);
+
+	if (pVertexRemaps) pVertexRemaps->swap(remaps);
+
+	return submeshCount;
+}
+
+template<typename TIndex>
+UINT CreateTerrainRtin(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, HeightmapImage& heightmap, float maxError)
+{
+	TerrainLayout layout(heightmap.GetWidth(), heightmap.GetHeight());
+	if (!layout.HasQuads())
+	{
+		fprintf(stderr, "Heightmap of %ux%u samples is too small for a terrain\n",
+			heightmap.GetWidth(), heightmap.GetHeight());
+		return 0;
+	}
+
+	// Simplified mesh, one submesh per terrain chunk that has triangles
+	TerrainRtin rtin(heightmap, layout);
+
+	TerrainRtinMesh mesh;
+	if (rtin.Extract(maxError, mesh) != 0) return 0;
+
+	for (const TerrainRtinSubmesh& submesh : mesh.Submeshes)
+	{
+		meshGeometry->AddVertexData(
+			&mesh.Vertices[submesh.BaseVertex], submesh.VertexCount,
+			&mesh.Indices[submesh.StartIndex], submesh.IndexCount);
+	}
+
+	return static_cast<UINT>(mesh.Submeshes.size());
 }
 
-void CreatePlane(StaticGeometryUploader<Vertex>* meshGeometry, UINT n, UINT m, float width, float depth)
+template<typename TIndex>
+void CreatePlane(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, UINT n, UINT m, float width, float depth)
 {
 	std::vector<Vertex> vertices;
-	std::vector<uint16_t> indices;
+	std::vector<TIndex> indices;
 
 	float dx = width / static_cast<float>(n - 1);
 	float dz = depth / static_cast<float>(m - 1);
@@ -154,16 +240,45 @@ void CreatePlane(StaticGeometryUploader<Vertex>* meshGeometry, UINT n, UINT m, f
 		for (UINT j = 0; j < n - 1; j++)
 		{
 			// Generate indices for quad down and to the right
-			indices.push_back(j + i * n);
-			indices.push_back((j + 1) + i * n);
-			indices.push_back(j + (i + 1) * n);
+			indices.push_back(static_cast<TIndex>(j + i * n));
+			indices.push_back(static_cast<TIndex>((j + 1) + i * n));
+			indices.push_back(static_cast<TIndex>(j + (i + 1) * n));
 
-			indices.push_back((j + 1) + i * n);
-			indices.push_back((j + 1) + (i + 1) * n);
-			indices.push_back(j + (i + 1) * n);
+			indices.push_back(static_cast<TIndex>((j + 1) + i * n));
+			indices.push_back(static_cast<TIndex>((j + 1) + (i + 1) * n));
+			indices.push_back(static_cast<TIndex>(j + (i + 1) * n));
 		}
 	}
 
 	meshGeometry->AddVertexData(vertices, indices);
 }
 
+template<typename TIndex>
+void CreateTerrainLodPatch(StaticGeometryUploader<Vertex, TIndex>* meshGeometry, UINT quads)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint16_t> indices;
+	BuildTerrainLodPatch(quads, vertices, indices);
+
+	// Quadrants are drawn as index ranges, reordering would mix them
+	const bool optimize = meshGeometry->mOptimizeMeshes;
+	meshGeometry->mOptimizeMeshes = false;
+	meshGeometry->AddVertexData(vertices, indices);
+	meshGeometry->mOptimizeMeshes = optimize;
+}
+
+// Instantiate generators for both supported index types
+template void CreateGrid(StaticGeometryUploader<Vertex, uint16_t>*, UINT, float);
+template void CreateGrid(StaticGeometryUploader<Vertex, uint32_t>*, UINT, float);
+template UINT CreateTerrain(StaticGeometryUploader<Vertex, uint16_t>*, std::string);
+template UINT CreateTerrain(StaticGeometryUploader<Vertex, uint32_t>*, std::string);
+template UINT CreateTerrain(StaticGeometryUploader<Vertex, uint16_t>*, HeightmapImage&, std::vector<std::vector<uint32_t>>*);
+template UINT CreateTerrain(StaticGeometryUploader<Vertex, uint32_t>*, HeightmapImage&, std::vector<std::vector<uint32_t>>*);
+template UINT CreateTerrainCached(StaticGeometryUploader<Vertex, uint16_t>*, HeightmapImage&, std::string, mapped_file&, std::vector<std::vector<uint32_t>>*);
+template UINT CreateTerrainCached(StaticGeometryUploader<Vertex, uint32_t>*, HeightmapImage&, std::string, mapped_file&, std::vector<std::vector<uint32_t>>*);
+template UINT CreateTerrainRtin(StaticGeometryUploader<Vertex, uint16_t>*, HeightmapImage&, float);
+template UINT CreateTerrainRtin(StaticGeometryUploader<Vertex, uint32_t>*, HeightmapImage&, float);
+template void CreatePlane(StaticGeometryUploader<Vertex, uint16_t>*, UINT, UINT, float, float);
+template void CreatePlane(StaticGeometryUploader<Vertex, uint32_t>*, UINT, UINT, float, float);
+template void CreateTerrainLodPatch(StaticGeometryUploader<Vertex, uint16_t>*, UINT);
+template void CreateTerrainLodPatch(StaticGeometryUploader<Vertex, uint32_t>*, UINT);
@@ -0,0 +1,907 @@
+/*****************************************************************//**
+ * \file   image_bc.cpp
+ * \brief  Block compression of images to BC formats
+ *
+ * Every encoder picks endpoints, evaluates them by fitting the block to
+ * their palette and keeps the best candidate. Pixels are integers in
+ * floats, so block sums and squared errors are exact in any order and
+ * the vectorised fits match the scalar one bit for bit.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_bc.h"
+#include "image_dds.h"
+
+// Block rows encoded by one work item
+#define BC_BLOCK_ROW_GRAIN 4
+
+// Least squares refinements per quality
+#define BC_REFINE_NORMAL 1
+#define BC_REFINE_HIGH 3
+
+// Passes of the neighbouring endpoint search of BC_QUALITY_HIGH
+#define BC_SEARCH_PASSES 2
+
+// Weights of BC7 4-bit indices in 64ths
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Index i of a palette approximates (a[i] * e0 + b[i] * e1) / denom
+static const int BC1_RAMP_A[4] = { 3, 0, 2, 1 };
+static const int BC1_RAMP_B[4] = { 0, 3, 1, 2 };
+static const int BC4_RAMP8_A[8] = { 7, 0, 6, 5, 4, 3, 2, 1 };
+static const int BC4_RAMP8_B[8] = { 0, 7, 1, 2, 3, 4, 5, 6 };
+static const int BC4_RAMP6_A[8] = { 5, 0, 4, 3, 2, 1, 0, 0 };	// 0 and 255 do not depend on endpoints
+static const int BC4_RAMP6_B[8] = { 0, 5, 1, 2, 3, 4, 0, 0 };
+
+// 16 pixels row by row from the top left, channel-planar R, G, B, A
+struct bc_block
+{
+    float ch[4][16];
+};
+
+// Encoded 16-byte blocks are assembled from the lowest bit up
+struct bc_bits
+{
+    uint8_t* out;
+    uint32_t pos = 0;
+
+    void put(uint32_t value, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++, pos++)
+        {
+            if (value >> i & 1) out[pos >> 3] |= (uint8_t)(1 << (pos & 7));
+        }
+    }
+};
+
+static inline int clamp_int(int value, int lo, int hi)
+{
+    return (std::min)((std::max)(value, lo), hi);
+}
+
+static float fit_scalar(const float* const* planes, uint32_t channels, const float* palette,
+    uint32_t entries, uint8_t* indices)
+{
+    float total = 0.0f;
+    for (uint32_t p = 0; p < 16; p++)
+    {
+        float best = FLT_MAX;
+        uint8_t bestIndex = 0;
+        for (uint32_t e = 0; e < entries; e++)
+        {
+            float dist = 0.0f;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                const float diff = planes[c][p] - palette[e * 4 + c];
+                dist = dist + diff * diff;
+            }
+            if (dist < best)
+            {
+                best = dist;
+                bestIndex = (uint8_t)e;
+            }
+        }
+        indices[p] = bestIndex;
+        total += best;
+    }
+    return total;
+}
+
+// Range of the pixels projected on the axis through the mean
+static void project_scalar(const float* const* planes, uint32_t channels, const float* mean,
+    const float* axis, float& lo, float& hi)
+{
+    lo = FLT_MAX;
+    hi = -FLT_MAX;
+    for (uint32_t p = 0; p < 16; p++)
+    {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            t = t + (planes[c][p] - mean[c]) * axis[c];
+        }
+        lo = t < lo ? t : lo;
+        hi = t > hi ? t : hi;
+    }
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_SSE41 static float fit_sse41(const float* const* planes, uint32_t channels, const float* palette,
+    uint32_t entries, uint8_t* indices)
+{
+    __m128 total = _mm_setzero_ps();
+    for (uint32_t p = 0; p < 16; p += 4)
+    {
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (uint32_t e = 0; e < entries; e++)
+        {
+            __m128 dist = _mm_setzero_ps();
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                const __m128 diff = _mm_sub_ps(_mm_loadu_ps(planes[c] + p), _mm_set1_ps(palette[e * 4 + c]));
+                dist = _mm_add_ps(dist, _mm_mul_ps(diff, diff));
+            }
+            const __m128 closer = _mm_cmplt_ps(dist, best);
+            best = _mm_min_ps(dist, best);
+            bestIndex = _mm_blendv_epi8(bestIndex, _mm_set1_epi32((int)e), _mm_castps_si128(closer));
+        }
+        total = _mm_add_ps(total, best);
+
+        const __m128i words = _mm_packs_epi32(bestIndex, bestIndex);
+        const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        memcpy(indices + p, &bytes, 4);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+SIMD_TARGET_AVX2 static float fit_avx2(const float* const* planes, uint32_t channels, const float* palette,
+    uint32_t entries, uint8_t* indices)
+{
+    __m256 total = _mm256_setzero_ps();
+    for (uint32_t p = 0; p < 16; p += 8)
+    {
+        __m256 best = _mm256_set1_ps(FLT_MAX);
+        __m256i bestIndex = _mm256_setzero_si256();
+        for (uint32_t e = 0; e < entries; e++)
+        {
+            __m256 dist = _mm256_setzero_ps();
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                const __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(planes[c] + p), _mm256_set1_ps(palette[e * 4 + c]));
+                dist = _mm256_add_ps(dist, _mm256_mul_ps(diff, diff));
+            }
+            const __m256 closer = _mm256_cmp_ps(dist, best, _CMP_LT_OQ);
+            best = _mm256_min_ps(dist, best);
+            bestIndex = _mm256_blendv_epi8(bestIndex, _mm256_set1_epi32((int)e), _mm256_castps_si256(closer));
+        }
+        total = _mm256_add_ps(total, best);
+
+        const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(bestIndex), _mm256_extracti128_si256(bestIndex, 1));
+        _mm_storel_epi64((__m128i*)(indices + p), _mm_packus_epi16(words, words));
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, total);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+
+SIMD_TARGET_SSE41 static void project_sse41(const float* const* planes, uint32_t channels, const float* mean,
+    const float* axis, float& lo, float& hi)
+{
+    __m128 low = _mm_set1_ps(FLT_MAX);
+    __m128 high = _mm_set1_ps(-FLT_MAX);
+    for (uint32_t p = 0; p < 16; p += 4)
+    {
+        __m128 t = _mm_setzero_ps();
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            const __m128 centered = _mm_sub_ps(_mm_loadu_ps(planes[c] + p), _mm_set1_ps(mean[c]));
+            t = _mm_add_ps(t, _mm_mul_ps(centered, _mm_set1_ps(axis[c])));
+        }
+        low = _mm_min_ps(t, low);
+        high = _mm_max_ps(t, high);
+    }
+
+    low = _mm_min_ps(low, _mm_shuffle_ps(low, low, _MM_SHUFFLE(1, 0, 3, 2)));
+    low = _mm_min_ps(low, _mm_shuffle_ps(low, low, _MM_SHUFFLE(2, 3, 0, 1)));
+    high = _mm_max_ps(high, _mm_shuffle_ps(high, high, _MM_SHUFFLE(1, 0, 3, 2)));
+    high = _mm_max_ps(high, _mm_shuffle_ps(high, high, _MM_SHUFFLE(2, 3, 0, 1)));
+    lo = _mm_cvtss_f32(low);
+    hi = _mm_cvtss_f32(high);
+}
+
+#endif
+
+/**
+ * Fits every pixel to the nearest palette entry, ties to the lower index.
+ * palette holds entries of 4 floats, channels of them are compared.
+ *
+ * \return summed squared error
+ */
+static float fit_indices(const float* const* planes, uint32_t channels, const float* palette,
+    uint32_t entries, uint8_t* indices, SIMD_LEVEL level)
+{
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_AVX2) return fit_avx2(planes, channels, palette, entries, indices);
+    if (level >= SIMD_LEVEL_SSE41) return fit_sse41(planes, channels, palette, entries, indices);
+#endif
+    return fit_scalar(planes, channels, palette, entries, indices);
+}
+
+// The projection is cheap next to the fits, SSE4.1 serves all SIMD levels
+static void project_range(const float* const* planes, uint32_t channels, const float* mean,
+    const float* axis, float& lo, float& hi, SIMD_LEVEL level)
+{
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        project_sse41(planes, channels, mean, axis, lo, hi);
+        return;
+    }
+#endif
+    project_scalar(planes, channels, mean, axis, lo, hi);
+}
+
+static void bounding_box(const float* const* planes, uint32_t channels, float* lo, float* hi)
+{
+    for (uint32_t c = 0; c < channels; c++)
+    {
+        lo[c] = *std::min_element(planes[c], planes[c] + 16);
+        hi[c] = *std::max_element(planes[c], planes[c] + 16);
+    }
+}
+
+/**
+ * Endpoints along the principal axis of the pixels, found by power
+ * iteration on their covariance. The box of the pixels is used for
+ * BC_QUALITY_FAST and for blocks without a dominant direction.
+ */
+static void initial_endpoints(const float* const* planes, uint32_t channels, BC_QUALITY quality,
+    float* lo, float* hi, SIMD_LEVEL level)
+{
+    bounding_box(planes, channels, lo, hi);
+    if (quality == BC_QUALITY_FAST) return;
+
+    float mean[4] = { };
+    float cov[4][4] = { };
+    for (uint32_t p = 0; p < 16; p++)
+    {
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            mean[c] += planes[c][p];
+            for (uint32_t d = c; d < channels; d++) cov[c][d] += planes[c][p] * planes[d][p];
+        }
+    }
+
+    for (uint32_t c = 0; c < channels; c++) mean[c] /= 16.0f;
+
+    uint32_t widest = 0;
+    for (uint32_t c = 0; c < channels; c++)
+    {
+        for (uint32_t d = c; d < channels; d++)
+        {
+            cov[c][d] = cov[c][d] / 16.0f - mean[c] * mean[d];
+            cov[d][c] = cov[c][d];
+        }
+        if (cov[c][c] > cov[widest][widest]) widest = c;
+    }
+
+    if (cov[widest][widest] < 1.0f) return;
+
+    float axis[4] = { };
+    for (uint32_t c = 0; c < channels; c++) axis[c] = cov[widest][c];
+
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = { };
+        float largest = 0.0f;
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            for (uint32_t d = 0; d < channels; d++) next[c] += cov[c][d] * axis[d];
+            largest = (std::max)(largest, fabsf(next[c]));
+        }
+        if (largest == 0.0f) return;
+        for (uint32_t c = 0; c < channels; c++) axis[c] = next[c] / largest;
+    }
+
+    float length = 0.0f;
+    for (uint32_t c = 0; c < channels; c++) length += axis[c] * axis[c];
+    length = sqrtf(length);
+    for (uint32_t c = 0; c < channels; c++) axis[c] /= length;
+
+    float tLo, tHi;
+    project_range(planes, channels, mean, axis, tLo, tHi, level);
+
+    for (uint32_t c = 0; c < channels; c++)
+    {
+        lo[c] = (std::min)((std::max)(mean[c] + tLo * axis[c], 0.0f), 255.0f);
+        hi[c] = (std::min)((std::max)(mean[c] + tHi * axis[c], 0.0f), 255.0f);
+    }
+}
+
+/**
+ * Endpoints with the least squared error for fixed indices.
+ *
+ * \return false when the indices do not determine both endpoints
+ */
+static bool refine_endpoints(const float* const* planes, uint32_t channels, const uint8_t* indices,
+    const int* ramp_a, const int* ramp_b, int denom, float* e0, float* e1)
+{
+    double aa = 0.0, ab = 0.0, bb = 0.0;
+    double ax[4] = { };
+    double bx[4] = { };
+    for (uint32_t p = 0; p < 16; p++)
+    {
+        const double a = ramp_a[indices[p]];
+        const double b = ramp_b[indices[p]];
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            ax[c] += a * planes[c][p];
+            bx[c] += b * planes[c][p];
+        }
+    }
+
+    const double det = aa * bb - ab * ab;
+    if (det == 0.0) return false;
+
+    for (uint32_t c = 0; c < channels; c++)
+    {
+        e0[c] = (float)(std::min)((std::max)((ax[c] * bb - bx[c] * ab) * denom / det, 0.0), 255.0);
+        e1[c] = (float)(std::min)((std::max)((bx[c] * aa - ax[c] * ab) * denom / det, 0.0), 255.0);
+    }
+    return true;
+}
+
+// BC1
+
+struct bc1_candidate
+{
+    uint16_t c0 = 0;
+    uint16_t c1 = 0;
+    float error = FLT_MAX;
+    uint8_t indices[16] = { };
+};
+
+static uint16_t pack_565(const float* rgb)
+{
+    const int r = clamp_int((int)(rgb[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    const int g = clamp_int((int)(rgb[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    const int b = clamp_int((int)(rgb[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+static void unpack_565(uint16_t color, int* rgb)
+{
+    const int r = color >> 11;
+    const int g = color >> 5 & 0x3F;
+    const int b = color & 0x1F;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+// Palette of the four-color mode, c0 > c1
+static void bc1_palette(uint16_t c0, uint16_t c1, float* palette)
+{
+    int p0[3], p1[3];
+    unpack_565(c0, p0);
+    unpack_565(c1, p1);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[0 + c] = (float)p0[c];
+        palette[4 + c] = (float)p1[c];
+        palette[8 + c] = (float)((2 * p0[c] + p1[c] + 1) / 3);
+        palette[12 + c] = (float)((p0[c] + 2 * p1[c] + 1) / 3);
+    }
+}
+
+static void try_bc1(const float* const* planes, uint16_t c0, uint16_t c1, bc1_candidate& best, SIMD_LEVEL level)
+{
+    // The four-color mode needs c0 > c1, equal endpoints use only index 0
+    if (c0 < c1) std::swap(c0, c1);
+
+    float palette[16];
+    bc1_palette(c0, c1, palette);
+
+    uint8_t indices[16];
+    const float error = fit_indices(planes, 3, palette, c0 == c1 ? 1 : 4, indices, level);
+    if (error < best.error)
+    {
+        best.c0 = c0;
+        best.c1 = c1;
+        best.error = error;
+        memcpy(best.indices, indices, 16);
+    }
+}
+
+static void encode_bc1(const bc_block& block, BC_QUALITY quality, uint8_t* out, SIMD_LEVEL level)
+{
+    const float* planes[3] = { block.ch[0], block.ch[1], block.ch[2] };
+
+    float lo[4], hi[4];
+    initial_endpoints(planes, 3, quality, lo, hi, level);
+
+    if (quality == BC_QUALITY_FAST)
+    {
+        // Inset the box by a sixteenth, its corners are rarely hit
+        for (int c = 0; c < 3; c++)
+        {
+            const float inset = (hi[c] - lo[c]) / 16.0f;
+            lo[c] += inset;
+            hi[c] -= inset;
+        }
+    }
+
+    bc1_candidate best;
+    try_bc1(planes, pack_565(hi), pack_565(lo), best, level);
+
+    const int refinements = quality == BC_QUALITY_HIGH ? BC_REFINE_HIGH :
+        quality == BC_QUALITY_NORMAL ? BC_REFINE_NORMAL : 0;
+    for (int i = 0; i < refinements && best.error > 0.0f; i++)
+    {
+        float e0[4], e1[4];
+        if (!refine_endpoints(planes, 3, best.indices, BC1_RAMP_A, BC1_RAMP_B, 3, e0, e1)) break;
+
+        const float error = best.error;
+        try_bc1(planes, pack_565(e0), pack_565(e1), best, level);
+        if (best.error >= error) break;
+    }
+
+    if (quality == BC_QUALITY_HIGH)
+    {
+        // Steps of one in each 5:6:5 field of each endpoint
+        static const uint16_t steps[3] = { 1 << 11, 1 << 5, 1 };
+        static const uint16_t fields[3] = { 0x1F << 11, 0x3F << 5, 0x1F };
+
+        for (int pass = 0; pass < BC_SEARCH_PASSES && best.error > 0.0f; pass++)
+        {
+            const float error = best.error;
+            for (int endpoint = 0; endpoint < 2; endpoint++)
+            {
+                for (int field = 0; field < 3; field++)
+                {
+                    const uint16_t c0 = best.c0;
+                    const uint16_t c1 = best.c1;
+                    const uint16_t color = endpoint == 0 ? c0 : c1;
+
+                    if ((color & fields[field]) != fields[field])
+                    {
+                        const uint16_t up = (uint16_t)(color + steps[field]);
+                        try_bc1(planes, endpoint == 0 ? up : c0, endpoint == 0 ? c1 : up, best, level);
+                    }
+                    if ((color & fields[field]) != 0)
+                    {
+                        const uint16_t down = (uint16_t)(color - steps[field]);
+                        try_bc1(planes, endpoint == 0 ? down : c0, endpoint == 0 ? c1 : down, best, level);
+                    }
+                }
+            }
+            if (best.error >= error) break;
+        }
+    }
+
+    uint32_t bits = 0;
+    for (int p = 0; p < 16; p++) bits |= (uint32_t)best.indices[p] << (2 * p);
+
+    memcpy(out, &best.c0, 2);
+    memcpy(out + 2, &best.c1, 2);
+    memcpy(out + 4, &bits, 4);
+}
+
+// BC4 and BC5
+
+struct bc4_candidate
+{
+    int e0 = 0;
+    int e1 = 0;
+    float error = FLT_MAX;
+    uint8_t indices[16] = { };
+};
+
+// Eight-value mode for e0 > e1, else six values, 0 and 255
+static void bc4_palette(int e0, int e1, float* palette)
+{
+    palette[0] = (float)e0;
+    palette[4] = (float)e1;
+    if (e0 > e1)
+    {
+        for (int k = 1; k < 7; k++) palette[(k + 1) * 4] = (float)(((7 - k) * e0 + k * e1 + 3) / 7);
+    }
+    else
+    {
+        for (int k = 1; k < 5; k++) palette[(k + 1) * 4] = (float)(((5 - k) * e0 + k * e1 + 2) / 5);
+        palette[6 * 4] = 0.0f;
+        palette[7 * 4] = 255.0f;
+    }
+}
+
+static void try_bc4(const float* plane, int e0, int e1, bc4_candidate& best, SIMD_LEVEL level)
+{
+    e0 = clamp_int(e0, 0, 255);
+    e1 = clamp_int(e1, 0, 255);
+
+    float palette[32];
+    bc4_palette(e0, e1, palette);
+
+    uint8_t indices[16];
+    const float error = fit_indices(&plane, 1, palette, 8, indices, level);
+    if (error < best.error)
+    {
+        best.e0 = e0;
+        best.e1 = e1;
+        best.error = error;
+        memcpy(best.indices, indices, 16);
+    }
+}
+
+static void refine_bc4(const float* plane, int refinements, bc4_candidate& best, SIMD_LEVEL level)
+{
+    for (int i = 0; i < refinements && best.error > 0.0f; i++)
+    {
+        const bool eight = best.e0 > best.e1;
+
+        float e0, e1;
+        if (!refine_endpoints(&plane, 1, best.indices, eight ? BC4_RAMP8_A : BC4_RAMP6_A,
+            eight ? BC4_RAMP8_B : BC4_RAMP6_B, eight ? 7 : 5, &e0, &e1)) break;
+
+        // Keep the mode, the order of the endpoints selects it
+        int q0 = (int)(e0 + 0.5f);
+        int q1 = (int)(e1 + 0.5f);
+        if ((q0 > q1) != eight) std::swap(q0, q1);
+
+        const float error = best.error;
+        try_bc4(plane, q0, q1, best, level);
+        if (best.error >= error) break;
+    }
+}
+
+static void encode_bc4(const float* plane, BC_QUALITY quality, uint8_t* out, SIMD_LEVEL level)
+{
+    const float lo = *std::min_element(plane, plane + 16);
+    const float hi = *std::max_element(plane, plane + 16);
+
+    bc4_candidate best;
+    try_bc4(plane, (int)hi, (int)lo, best, level);
+
+    const int refinements = quality == BC_QUALITY_HIGH ? BC_REFINE_HIGH :
+        quality == BC_QUALITY_NORMAL ? BC_REFINE_NORMAL : 0;
+    refine_bc4(plane, refinements, best, level);
+
+    if (quality == BC_QUALITY_HIGH && best.error > 0.0f)
+    {
+        // Six-value mode spends its ramp on the values between 0 and 255
+        float innerLo = 255.0f, innerHi = 0.0f;
+        for (int p = 0; p < 16; p++)
+        {
+            if (plane[p] > 0.0f && plane[p] < 255.0f)
+            {
+                innerLo = (std::min)(innerLo, plane[p]);
+                innerHi = (std::max)(innerHi, plane[p]);
+            }
+        }
+        if (innerLo <= innerHi)
+        {
+            bc4_candidate six;
+            try_bc4(plane, (int)innerLo, (int)innerHi, six, level);
+            refine_bc4(plane, refinements, six, level);
+            if (six.error < best.error) best = six;
+        }
+
+        for (int pass = 0; pass < BC_SEARCH_PASSES && best.error > 0.0f; pass++)
+        {
+            const float error = best.error;
+            const int e0 = best.e0;
+            const int e1 = best.e1;
+            for (int delta = -1; delta <= 1; delta += 2)
+            {
+                // Steps that keep the mode
+                if ((e0 + delta > e1) == (e0 > e1)) try_bc4(plane, e0 + delta, e1, best, level);
+                if ((e0 > e1 + delta) == (e0 > e1)) try_bc4(plane, e0, e1 + delta, best, level);
+            }
+            if (best.error >= error) break;
+        }
+    }
+
+    out[0] = (uint8_t)best.e0;
+    out[1] = (uint8_t)best.e1;
+
+    uint64_t bits = 0;
+    for (int p = 0; p < 16; p++) bits |= (uint64_t)best.indices[p] << (3 * p);
+    for (int i = 0; i < 6; i++) out[2 + i] = (uint8_t)(bits >> (8 * i));
+}
+
+// BC7 mode 6: one subset, RGBA endpoints of 7 bits and a shared low bit
+
+struct bc7_endpoint
+{
+    int q[4] = { };
+    int p = 0;
+
+    int value(int c) const { return q[c] << 1 | p; }
+};
+
+struct bc7_candidate
+{
+    bc7_endpoint e0;
+    bc7_endpoint e1;
+    float error = FLT_MAX;
+    uint8_t indices[16] = { };
+};
+
+// Nearest 7-bit values for both low bits, the closer one is kept
+static bc7_endpoint quantize_bc7(const float* color)
+{
+    bc7_endpoint best;
+    float bestError = FLT_MAX;
+    for (int p = 0; p < 2; p++)
+    {
+        bc7_endpoint endpoint;
+        endpoint.p = p;
+
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++)
+        {
+            endpoint.q[c] = clamp_int((int)floorf((color[c] - p) / 2.0f + 0.5f), 0, 127);
+            const float diff = (float)endpoint.value(c) - color[c];
+            error += diff * diff;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            best = endpoint;
+        }
+    }
+    return best;
+}
+
+static void try_bc7(const float* const* planes, const bc7_endpoint& e0, const bc7_endpoint& e1,
+    bc7_candidate& best, SIMD_LEVEL level)
+{
+    float palette[64];
+    for (int i = 0; i < 16; i++)
+    {
+        const int w = BC7_WEIGHTS4[i];
+        for (int c = 0; c < 4; c++)
+        {
+            palette[i * 4 + c] = (float)(((64 - w) * e0.value(c) + w * e1.value(c) + 32) >> 6);
+        }
+    }
+
+    uint8_t indices[16];
+    const float error = fit_indices(planes, 4, palette, 16, indices, level);
+    if (error < best.error)
+    {
+        best.e0 = e0;
+        best.e1 = e1;
+        best.error = error;
+        memcpy(best.indices, indices, 16);
+    }
+}
+
+static void encode_bc7(const bc_block& block, BC_QUALITY quality, uint8_t* out, SIMD_LEVEL level)
+{
+    const float* planes[4] = { block.ch[0], block.ch[1], block.ch[2], block.ch[3] };
+
+    float lo[4], hi[4];
+    initial_endpoints(planes, 4, quality, lo, hi, level);
+
+    bc7_candidate best;
+    try_bc7(planes, quantize_bc7(lo), quantize_bc7(hi), best, level);
+
+    int rampA[16], rampB[16];
+    for (int i = 0; i < 16; i++)
+    {
+        rampA[i] = 64 - BC7_WEIGHTS4[i];
+        rampB[i] = BC7_WEIGHTS4[i];
+    }
+
+    const int refinements = quality == BC_QUALITY_HIGH ? BC_REFINE_HIGH :
+        quality == BC_QUALITY_NORMAL ? BC_REFINE_NORMAL : 0;
+    for (int i = 0; i < refinements && best.error > 0.0f; i++)
+    {
+        float e0[4], e1[4];
+        if (!refine_endpoints(planes, 4, best.indices, rampA, rampB, 64, e0, e1)) break;
+
+        const float error = best.error;
+        try_bc7(planes, quantize_bc7(e0), quantize_bc7(e1), best, level);
+        if (best.error >= error) break;
+    }
+
+    if (quality == BC_QUALITY_HIGH)
+    {
+        for (int pass = 0; pass < BC_SEARCH_PASSES && best.error > 0.0f; pass++)
+        {
+            const float error = best.error;
+            for (int endpoint = 0; endpoint < 2; endpoint++)
+            {
+                const bc7_candidate current = best;
+                const bc7_endpoint& base = endpoint == 0 ? current.e0 : current.e1;
+
+                bc7_endpoint flipped = base;
+                flipped.p ^= 1;
+                try_bc7(planes, endpoint == 0 ? flipped : current.e0, endpoint == 0 ? current.e1 : flipped, best, level);
+
+                for (int c = 0; c < 4; c++)
+                {
+                    for (int delta = -1; delta <= 1; delta += 2)
+                    {
+                        bc7_endpoint moved = base;
+                        moved.q[c] += delta;
+                        if (moved.q[c] < 0 || moved.q[c] > 127) continue;
+                        try_bc7(planes, endpoint == 0 ? moved : current.e0, endpoint == 0 ? current.e1 : moved, best, level);
+                    }
+                }
+            }
+            if (best.error >= error) break;
+        }
+    }
+
+    // Index 0 is stored without its top bit, the ramp is mirrored if it is set
+    if (best.indices[0] >= 8)
+    {
+        std::swap(best.e0, best.e1);
+        for (int p = 0; p < 16; p++) best.indices[p] = (uint8_t)(15 - best.indices[p]);
+    }
+
+    memset(out, 0, 16);
+    bc_bits bits;
+    bits.out = out;
+    bits.put(1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+        bits.put(best.e0.q[c], 7);
+        bits.put(best.e1.q[c], 7);
+    }
+    bits.put(best.e0.p, 1);
+    bits.put(best.e1.p, 1);
+    bits.put(best.indices[0], 3);
+    for (int p = 1; p < 16; p++) bits.put(best.indices[p], 4);
+}
+
+// Pixels of block (bx, by) counted from the top left
+static void load_block(const uint8_t* src, uint32_t width, uint32_t height, size_t row_pitch,
+    uint32_t channels, uint32_t bx, uint32_t by, bc_block& block)
+{
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        const uint32_t fromTop = (std::min)(by * 4 + y, height - 1);
+        const uint8_t* row = src + (size_t)(height - 1 - fromTop) * row_pitch;
+
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            const uint8_t* pixel = row + (size_t)(std::min)(bx * 4 + x, width - 1) * channels;
+            const uint32_t i = y * 4 + x;
+
+            switch (channels)
+            {
+            case 1:
+                block.ch[0][i] = block.ch[1][i] = block.ch[2][i] = pixel[0];
+                block.ch[3][i] = 255.0f;
+                break;
+            case 2:
+                block.ch[0][i] = pixel[0];
+                block.ch[1][i] = pixel[1];
+                block.ch[2][i] = 0.0f;
+                block.ch[3][i] = 255.0f;
+                break;
+            default:
+                block.ch[0][i] = pixel[2];
+                block.ch[1][i] = pixel[1];
+                block.ch[2][i] = pixel[0];
+                block.ch[3][i] = channels == 4 ? pixel[3] : 255.0f;
+                break;
+            }
+        }
+    }
+}
+
+uint32_t bc_dxgi_format(BC_FORMAT format)
+{
+    switch (format)
+    {
+    case BC_FORMAT_BC1:
+        return DDS_DXGI_FORMAT_BC1_UNORM;
+    case BC_FORMAT_BC4:
+        return DDS_DXGI_FORMAT_BC4_UNORM;
+    case BC_FORMAT_BC5:
+        return DDS_DXGI_FORMAT_BC5_UNORM;
+    case BC_FORMAT_BC7:
+        return DDS_DXGI_FORMAT_BC7_UNORM;
+    default:
+        return DDS_DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+/**
+ * Compresses pixels to blocks.
+ *
+ * \param src first row of the pixels, the bottom one
+ * \param width width of the image
+ * \param height height of the image
+ * \param row_pitch bytes between rows
+ * \param channels bytes of a pixel, 1 to 4
+ * \param format block format
+ * \param quality speed and quality of the endpoint search
+ * \param dst dds_level_size bytes of blocks
+ * \param pool workers to encode on, nullptr encodes on the calling thread
+ * \param level instruction set of the fits
+ */
+void bc_encode(const uint8_t* src, uint32_t width, uint32_t height, size_t row_pitch,
+    uint32_t channels, BC_FORMAT format, BC_QUALITY quality, uint8_t* dst,
+    WorkerPool* pool, SIMD_LEVEL level)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockBytes = dds_block_bytes(bc_dxgi_format(format));
+
+    auto encodeRows = [&](uint32_t begin, uint32_t end)
+    {
+        bc_block block;
+        for (uint32_t by = begin; by < end; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                load_block(src, width, height, row_pitch, channels, bx, by, block);
+                uint8_t* out = dst + ((size_t)by * blocksX + bx) * blockBytes;
+
+                switch (format)
+                {
+                case BC_FORMAT_BC1:
+                    encode_bc1(block, quality, out, level);
+                    break;
+                case BC_FORMAT_BC4:
+                    encode_bc4(block.ch[0], quality, out, level);
+                    break;
+                case BC_FORMAT_BC5:
+                    encode_bc4(block.ch[0], quality, out, level);
+                    encode_bc4(block.ch[1], quality, out + 8, level);
+                    break;
+                case BC_FORMAT_BC7:
+                    encode_bc7(block, quality, out, level);
+                    break;
+                }
+            }
+        }
+    };
+
+    if (pool)
+    {
+        pool->ParallelFor(blocksY, BC_BLOCK_ROW_GRAIN, encodeRows);
+    }
+    else
+    {
+        encodeRows(0, blocksY);
+    }
+}
+
+/**
+ * Compresses every level of a mip chain and writes them to a .dds file.
+ *
+ * \param path path and/or file name
+ * \param chain levels to compress, 8-bit channels
+ * \param format block format
+ * \param quality speed and quality of the endpoint search
+ * \param pool workers to encode on, nullptr encodes on the calling thread
+ * \return error code (0 - success, -1 - error)
+ */
+int write_bc_dds(const char* path, const mip_chain& chain, BC_FORMAT format,
+    BC_QUALITY quality, WorkerPool* pool)
+{
+    const uint32_t dxgiFormat = bc_dxgi_format(format);
+    if (chain.level_count() == 0 || chain.format() != MIP_FORMAT_UNORM8 || dxgiFormat == DDS_DXGI_FORMAT_UNKNOWN)
+    {
+        fprintf(stderr, "Only 8-bit mip chains can be compressed to %s\n", path);
+        return -1;
+    }
+
+    std::vector<std::vector<uint8_t>> blocks(chain.level_count());
+    std::vector<const uint8_t*> levels(chain.level_count());
+    for (uint32_t mip = 0; mip < chain.level_count(); mip++)
+    {
+        const mip_level& level = chain.level(mip);
+        blocks[mip].resize((size_t)dds_level_size(dxgiFormat, level.width, level.height));
+
+        bc_encode(level.data, level.width, level.height, level.row_pitch, chain.channels(),
+            format, quality, blocks[mip].data(), pool);
+        levels[mip] = blocks[mip].data();
+    }
+
+    return write_dds(path, dxgiFormat, chain.level(0).width, chain.level(0).height,
+        chain.level_count(), levels.data());
+}
@@ -0,0 +1,66 @@
+/*****************************************************************//**
+ * \file   image_bc.h
+ * \brief  Block compression of images to BC formats and decompression
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "image_mip.h"
+#include "simd_util.h"
+#include "thread_pool.h"
+
+enum BC_FORMAT
+{
+	BC_FORMAT_BC1 = 1,			// RGB, 8 bytes per block - albedo
+	BC_FORMAT_BC4 = 4,			// Red, 8 bytes per block - heightmaps and masks
+	BC_FORMAT_BC5 = 5,			// Red and green, 16 bytes per block - normal maps
+	BC_FORMAT_BC7 = 7			// RGBA, 16 bytes per block, mode 6 only
+};
+
+enum BC_QUALITY
+{
+	BC_QUALITY_FAST = 0,		// Bounding box endpoints
+	BC_QUALITY_NORMAL = 1,		// Principal axis endpoints refined by least squares
+	BC_QUALITY_HIGH = 2			// More refinement and a search of neighbouring endpoints
+};
+
+// DXGI_FORMAT of the blocks, see image_dds.h
+uint32_t bc_dxgi_format(BC_FORMAT format);
+
+/**
+ * Compresses width x height pixels laid out like image_base: rows from
+ * the bottom, channels B, G, R, A. Gray pixels are read as R = G = B,
+ * missing alpha as 255, two channels as R, G. Blocks are written row
+ * by row from the top, as stored in .dds files. Edge blocks repeat the
+ * last row and column.
+ *
+ * All SIMD levels and thread counts produce identical blocks.
+ */
+void bc_encode(const uint8_t* src, uint32_t width, uint32_t height, size_t row_pitch,
+	uint32_t channels, BC_FORMAT format, BC_QUALITY quality, uint8_t* dst,
+	WorkerPool* pool = nullptr, SIMD_LEVEL level = GetSimdLevel());
+
+// Compresses all levels of an 8-bit chain into a .dds file,
+// 0 - success, -1 - error
+int write_bc_dds(const char* path, const mip_chain& chain, BC_FORMAT format,
+	BC_QUALITY quality, WorkerPool* pool = nullptr);
+
+// Bytes of a pixel decoded from the DXGI format: 1 for BC4, 4 (BGRA)
+// for BC1, BC2, BC3, BC5 and BC7, 0 if the format cannot be decoded
+uint32_t bc_decoded_channels(uint32_t dxgi_format);
+
+/**
+ * Decompresses blocks, rows of them from the top as stored in .dds
+ * files, to pixels laid out like image_base: rows from the bottom,
+ * bc_decoded_channels bytes each. BC5 decodes to R, G, B = 0, A = 255.
+ *
+ * All SIMD levels and thread counts produce identical pixels.
+ * 0 - success, -1 - error
+ */
+int bc_decode(const uint8_t* blocks, uint32_t dxgi_format, uint32_t width, uint32_t height,
+	uint8_t* dst, size_t row_pitch, WorkerPool* pool = nullptr, SIMD_LEVEL level = GetSimdLevel());
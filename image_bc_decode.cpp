@@ -0,0 +1,741 @@
+/*****************************************************************//**
+ * \file   image_bc_decode.cpp
+ * \brief  Decoding of BC blocks to pixels
+ *
+ * A block is decoded in two steps: endpoints are turned into palettes
+ * with the integer formulas of the D3D specification, then every pixel
+ * picks a palette entry by its index. SIMD levels build BC7 palettes
+ * and look up BC1 to BC5 indices with byte shuffles, in integers, so
+ * all levels produce the same pixels.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "image_bc.h"
+#include "image_dds.h"
+
+// Block rows decoded by one work item
+#define BC_DECODE_ROW_GRAIN 8
+
+// Weights of BC7 indices in 64ths, padded to 16 for vector loads
+static const uint16_t BC7_WEIGHTS2[16] = { 0, 21, 43, 64 };
+static const uint16_t BC7_WEIGHTS3[16] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint16_t BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Subset of pixel i is bit i of a two-subset partition
+static const uint16_t BC7_PARTITIONS2[64] =
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+// Subset of pixel i is bits 2i and 2i + 1 of a three-subset partition
+static const uint32_t BC7_PARTITIONS3[64] =
+{
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+};
+
+// Pixels whose index drops its top bit: the first pixel of each subset
+static const uint8_t BC7_ANCHORS2[64] =
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+};
+
+static const uint8_t BC7_ANCHORS3_SECOND[64] =
+{
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+};
+
+static const uint8_t BC7_ANCHORS3_THIRD[64] =
+{
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+};
+
+// Bit counts of the fields of a BC7 mode
+struct bc7_mode
+{
+    uint8_t subsets;
+    uint8_t partition_bits;
+    uint8_t rotation_bits;
+    uint8_t selection_bits;		// Mode 4 picks which index set is for color
+    uint8_t color_bits;
+    uint8_t alpha_bits;			// 0 - opaque
+    uint8_t endpoint_pbits;		// Low bit per endpoint
+    uint8_t shared_pbits;		// Low bit per subset
+    uint8_t index_bits;
+    uint8_t index_bits2;		// Separate alpha indices, 0 - none
+};
+
+static constexpr bc7_mode BC7_MODES[8] =
+{
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+    { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+    { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+    { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+    { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+    { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+    { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+// 16-byte blocks are read from the lowest bit up. Every field is read
+// at its position from the block, so with constant widths the reads do
+// not depend on each other.
+struct bc_bit_reader
+{
+    uint64_t lo;
+    uint64_t hi;
+    uint32_t position = 0;
+
+    explicit bc_bit_reader(const uint8_t* block)
+    {
+        memcpy(&lo, block, 8);
+        memcpy(&hi, block + 8, 8);
+    }
+
+    // The 64 bits from the position up, zeros past the block
+    uint64_t rest() const
+    {
+        if (position == 0) return lo;
+        if (position >= 64) return hi >> (position - 64);
+        return lo >> position | hi << (64 - position);
+    }
+
+    uint32_t take(uint32_t count)
+    {
+        if (count == 0) return 0;
+        const uint32_t value = (uint32_t)(rest() & ((1ull << count) - 1));
+        position += count;
+        return value;
+    }
+};
+
+static inline uint32_t pack_bgra(int r, int g, int b, int a)
+{
+    return (uint32_t)b | (uint32_t)g << 8 | (uint32_t)r << 16 | (uint32_t)a << 24;
+}
+
+static inline int expand_bits(int value, int bits)
+{
+    return value << (8 - bits) | value >> (2 * bits - 8);
+}
+
+// Moves the bits from position up by one, leaving a zero at position
+static inline uint64_t insert_zero_bit(uint64_t bits, uint32_t position)
+{
+    const uint64_t low = bits & ((1ull << position) - 1);
+    return low | (bits >> position) << (position + 1);
+}
+
+// Palette of BGRA entries, three colors and transparent black when
+// c0 <= c1 unless four_color, which BC2 and BC3 always use
+static void bc1_palette(const uint8_t* block, bool four_color, uint32_t* palette)
+{
+    const uint32_t c0 = block[0] | block[1] << 8;
+    const uint32_t c1 = block[2] | block[3] << 8;
+
+    int p0[3], p1[3];
+    p0[0] = expand_bits(c0 >> 11, 5);
+    p0[1] = expand_bits(c0 >> 5 & 0x3F, 6);
+    p0[2] = expand_bits(c0 & 0x1F, 5);
+    p1[0] = expand_bits(c1 >> 11, 5);
+    p1[1] = expand_bits(c1 >> 5 & 0x3F, 6);
+    p1[2] = expand_bits(c1 & 0x1F, 5);
+
+    palette[0] = pack_bgra(p0[0], p0[1], p0[2], 255);
+    palette[1] = pack_bgra(p1[0], p1[1], p1[2], 255);
+
+    if (four_color || c0 > c1)
+    {
+        palette[2] = pack_bgra((2 * p0[0] + p1[0] + 1) / 3, (2 * p0[1] + p1[1] + 1) / 3,
+            (2 * p0[2] + p1[2] + 1) / 3, 255);
+        palette[3] = pack_bgra((p0[0] + 2 * p1[0] + 1) / 3, (p0[1] + 2 * p1[1] + 1) / 3,
+            (p0[2] + 2 * p1[2] + 1) / 3, 255);
+    }
+    else
+    {
+        palette[2] = pack_bgra((p0[0] + p1[0] + 1) / 2, (p0[1] + p1[1] + 1) / 2, (p0[2] + p1[2] + 1) / 2, 255);
+        palette[3] = 0;
+    }
+}
+
+// Eight-value mode for e0 > e1, else six values, 0 and 255
+static void bc4_palette(const uint8_t* block, uint8_t* palette)
+{
+    const int e0 = block[0];
+    const int e1 = block[1];
+    palette[0] = (uint8_t)e0;
+    palette[1] = (uint8_t)e1;
+    if (e0 > e1)
+    {
+        for (int k = 1; k < 7; k++) palette[k + 1] = (uint8_t)(((7 - k) * e0 + k * e1 + 3) / 7);
+    }
+    else
+    {
+        for (int k = 1; k < 5; k++) palette[k + 1] = (uint8_t)(((5 - k) * e0 + k * e1 + 2) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static inline uint64_t bc4_indices(const uint8_t* block)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, block, 8);
+    return bits >> 16;
+}
+
+static void lookup_bc1_scalar(const uint32_t* palette, uint32_t indices, uint32_t* out)
+{
+    for (int p = 0; p < 16; p++) out[p] = palette[indices >> (2 * p) & 3];
+}
+
+static void lookup_bc4_scalar(const uint8_t* palette, uint64_t indices, uint8_t* out)
+{
+    for (int p = 0; p < 16; p++) out[p] = palette[indices >> (3 * p) & 7];
+}
+
+static void bc7_palette_scalar(const int* e0, const int* e1, const uint16_t* weights, uint32_t entries,
+    uint32_t* palette)
+{
+    for (uint32_t i = 0; i < entries; i++)
+    {
+        int c[4];
+        for (int k = 0; k < 4; k++) c[k] = ((64 - weights[i]) * e0[k] + weights[i] * e1[k] + 32) >> 6;
+        palette[i] = pack_bgra(c[0], c[1], c[2], c[3]);
+    }
+}
+
+#if SIMD_X86
+
+// Shifting a 2-bit index to the top of a lane multiplies by 2^(30 - 2p),
+// which SSE4.1 can do per lane where it cannot shift per lane
+SIMD_TARGET_SSE41 static void lookup_bc1_sse41(const uint32_t* palette, uint32_t indices, uint32_t* out)
+{
+    const __m128i entries = _mm_loadu_si128((const __m128i*)palette);
+    const __m128i bits = _mm_set1_epi32((int)indices);
+    const __m128i bytes = _mm_set1_epi32(0x04040404);
+    const __m128i offsets = _mm_set1_epi32(0x03020100);
+
+    for (int p = 0; p < 16; p += 4)
+    {
+        const __m128i scale = _mm_setr_epi32(1 << (30 - 2 * p), 1 << (28 - 2 * p), 1 << (26 - 2 * p), 1 << (24 - 2 * p));
+        const __m128i index = _mm_srli_epi32(_mm_mullo_epi32(bits, scale), 30);
+        const __m128i shuffle = _mm_add_epi32(_mm_mullo_epi32(index, bytes), offsets);
+        _mm_storeu_si128((__m128i*)(out + p), _mm_shuffle_epi8(entries, shuffle));
+    }
+}
+
+// 3-bit indices of eight pixels are 24 bits, shifted to the top of
+// lanes as for BC1 and packed to bytes that select palette bytes
+SIMD_TARGET_SSE41 static void lookup_bc4_sse41(const uint8_t* palette, uint64_t indices, uint8_t* out)
+{
+    const __m128i entries = _mm_loadl_epi64((const __m128i*)palette);
+    const __m128i low = _mm_set1_epi32((int)(indices & 0xFFFFFF));
+    const __m128i high = _mm_set1_epi32((int)(indices >> 24 & 0xFFFFFF));
+    const __m128i scale0 = _mm_setr_epi32(1 << 29, 1 << 26, 1 << 23, 1 << 20);
+    const __m128i scale1 = _mm_setr_epi32(1 << 17, 1 << 14, 1 << 11, 1 << 8);
+
+    const __m128i index0 = _mm_srli_epi32(_mm_mullo_epi32(low, scale0), 29);
+    const __m128i index1 = _mm_srli_epi32(_mm_mullo_epi32(low, scale1), 29);
+    const __m128i index2 = _mm_srli_epi32(_mm_mullo_epi32(high, scale0), 29);
+    const __m128i index3 = _mm_srli_epi32(_mm_mullo_epi32(high, scale1), 29);
+
+    const __m128i index = _mm_packus_epi16(_mm_packus_epi32(index0, index1), _mm_packus_epi32(index2, index3));
+    _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(entries, index));
+}
+
+// Channels are interpolated as e0 + (w * (e1 - e0) + 32) >> 6, which
+// equals the specification's formula and fits 16-bit lanes
+SIMD_TARGET_SSE41 static void bc7_palette_sse41(const int* e0, const int* e1, const uint16_t* weights,
+    uint32_t entries, uint32_t* palette)
+{
+    const __m128i base = _mm_setr_epi16((short)e0[2], (short)e0[1], (short)e0[0], (short)e0[3],
+        (short)e0[2], (short)e0[1], (short)e0[0], (short)e0[3]);
+    const __m128i delta = _mm_sub_epi16(_mm_setr_epi16((short)e1[2], (short)e1[1], (short)e1[0], (short)e1[3],
+        (short)e1[2], (short)e1[1], (short)e1[0], (short)e1[3]), base);
+    const __m128i round = _mm_set1_epi16(32);
+    const __m128i spread = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3);
+
+    for (uint32_t i = 0; i < entries; i += 4)
+    {
+        uint32_t pair0, pair1;
+        memcpy(&pair0, weights + i, 4);
+        memcpy(&pair1, weights + i + 2, 4);
+
+        const __m128i w0 = _mm_shuffle_epi8(_mm_cvtsi32_si128((int)pair0), spread);
+        const __m128i w1 = _mm_shuffle_epi8(_mm_cvtsi32_si128((int)pair1), spread);
+        const __m128i c0 = _mm_add_epi16(base, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(delta, w0), round), 6));
+        const __m128i c1 = _mm_add_epi16(base, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(delta, w1), round), 6));
+        _mm_storeu_si128((__m128i*)(palette + i), _mm_packus_epi16(c0, c1));
+    }
+}
+
+// Mode 6 has one subset of 16 entries, so each channel of the palette
+// fits one register and pixels select from it with a byte shuffle
+// instead of going through a BGRA palette in memory
+SIMD_TARGET_SSE41 static void decode_bc7_mode6_sse41(const int* e0, const int* e1, uint64_t indices, uint32_t* out)
+{
+    const __m128i round = _mm_set1_epi16(32);
+    const __m128i w0 = _mm_loadu_si128((const __m128i*)BC7_WEIGHTS4);
+    const __m128i w1 = _mm_loadu_si128((const __m128i*)(BC7_WEIGHTS4 + 8));
+
+    // Indices of pixels 2k and 2k + 1 are the low and high nibbles of byte k
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i packed = _mm_cvtsi64_si128((long long)indices);
+    const __m128i index = _mm_unpacklo_epi8(_mm_and_si128(packed, nibble),
+        _mm_and_si128(_mm_srli_epi16(packed, 4), nibble));
+
+    // Planes of B, G, R and A
+    __m128i planes[4];
+    static const int CHANNELS[4] = { 2, 1, 0, 3 };
+    for (int k = 0; k < 4; k++)
+    {
+        const int c = CHANNELS[k];
+        const __m128i base = _mm_set1_epi16((short)e0[c]);
+        const __m128i delta = _mm_set1_epi16((short)(e1[c] - e0[c]));
+        const __m128i c0 = _mm_add_epi16(base, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(delta, w0), round), 6));
+        const __m128i c1 = _mm_add_epi16(base, _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(delta, w1), round), 6));
+        planes[k] = _mm_shuffle_epi8(_mm_packus_epi16(c0, c1), index);
+    }
+
+    const __m128i bgLow = _mm_unpacklo_epi8(planes[0], planes[1]);
+    const __m128i bgHigh = _mm_unpackhi_epi8(planes[0], planes[1]);
+    const __m128i raLow = _mm_unpacklo_epi8(planes[2], planes[3]);
+    const __m128i raHigh = _mm_unpackhi_epi8(planes[2], planes[3]);
+    _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(bgLow, raLow));
+    _mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi16(bgLow, raLow));
+    _mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi16(bgHigh, raHigh));
+    _mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(bgHigh, raHigh));
+}
+
+SIMD_TARGET_AVX2 static void bc7_palette_avx2(const int* e0, const int* e1, const uint16_t* weights,
+    uint32_t entries, uint32_t* palette)
+{
+    const __m256i base = _mm256_setr_epi16(
+        (short)e0[2], (short)e0[1], (short)e0[0], (short)e0[3], (short)e0[2], (short)e0[1], (short)e0[0], (short)e0[3],
+        (short)e0[2], (short)e0[1], (short)e0[0], (short)e0[3], (short)e0[2], (short)e0[1], (short)e0[0], (short)e0[3]);
+    const __m256i delta = _mm256_sub_epi16(_mm256_setr_epi16(
+        (short)e1[2], (short)e1[1], (short)e1[0], (short)e1[3], (short)e1[2], (short)e1[1], (short)e1[0], (short)e1[3],
+        (short)e1[2], (short)e1[1], (short)e1[0], (short)e1[3], (short)e1[2], (short)e1[1], (short)e1[0], (short)e1[3]), base);
+    const __m256i round = _mm256_set1_epi16(32);
+
+    // Weights 0 and 1 to the low lane, 2 and 3 to the high lane
+    const __m256i spread = _mm256_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3,
+        4, 5, 4, 5, 4, 5, 4, 5, 6, 7, 6, 7, 6, 7, 6, 7);
+
+    for (uint32_t i = 0; i < entries; i += 8)
+    {
+        long long quad0, quad1;
+        memcpy(&quad0, weights + i, 8);
+        memcpy(&quad1, weights + i + 4, 8);
+
+        const __m256i w0 = _mm256_shuffle_epi8(_mm256_set1_epi64x(quad0), spread);
+        const __m256i w1 = _mm256_shuffle_epi8(_mm256_set1_epi64x(quad1), spread);
+        const __m256i c0 = _mm256_add_epi16(base, _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(delta, w0), round), 6));
+        const __m256i c1 = _mm256_add_epi16(base, _mm256_srai_epi16(_mm256_add_epi16(_mm256_mullo_epi16(delta, w1), round), 6));
+
+        // Packing interleaves lanes: entries 0, 1, 4, 5 | 2, 3, 6, 7
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(c0, c1), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(palette + i), packed);
+    }
+}
+
+#endif
+
+// The lookups are a few instructions, SSE4.1 serves all SIMD levels
+static void lookup_bc1(const uint32_t* palette, uint32_t indices, uint32_t* out, SIMD_LEVEL level)
+{
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        lookup_bc1_sse41(palette, indices, out);
+        return;
+    }
+#endif
+    lookup_bc1_scalar(palette, indices, out);
+}
+
+static void lookup_bc4(const uint8_t* palette, uint64_t indices, uint8_t* out, SIMD_LEVEL level)
+{
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        lookup_bc4_sse41(palette, indices, out);
+        return;
+    }
+#endif
+    lookup_bc4_scalar(palette, indices, out);
+}
+
+/**
+ * Interpolates RGBA endpoints to BGRA palette entries.
+ *
+ * \param weights 16 weights in 64ths, entries of them are used
+ * \param entries 4, 8 or 16
+ */
+static void bc7_palette(const int* e0, const int* e1, const uint16_t* weights, uint32_t entries,
+    uint32_t* palette, SIMD_LEVEL level)
+{
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_AVX2 && entries >= 8)
+    {
+        bc7_palette_avx2(e0, e1, weights, entries, palette);
+        return;
+    }
+    if (level >= SIMD_LEVEL_SSE41)
+    {
+        bc7_palette_sse41(e0, e1, weights, entries, palette);
+        return;
+    }
+#endif
+    bc7_palette_scalar(e0, e1, weights, entries, palette);
+}
+
+static const uint16_t* bc7_weights(uint32_t bits)
+{
+    return bits == 2 ? BC7_WEIGHTS2 : bits == 3 ? BC7_WEIGHTS3 : BC7_WEIGHTS4;
+}
+
+/**
+ * Decodes a 16-byte block of one mode to 16 BGRA pixels, rows from the
+ * top. Instantiated for every mode, so the field widths and the loop
+ * counts are constants and fields are read at fixed shifts, without
+ * branches that depend on the mode.
+ */
+template<int Mode>
+static void decode_bc7_mode(const uint8_t* block, uint32_t* out, SIMD_LEVEL level)
+{
+    const bc7_mode& mode = BC7_MODES[Mode];
+
+    bc_bit_reader reader(block);
+    reader.take(Mode + 1);
+
+    const uint32_t partition = reader.take(mode.partition_bits);
+    const uint32_t rotation = reader.take(mode.rotation_bits);
+    const uint32_t selection = reader.take(mode.selection_bits);
+
+    // Endpoints 2s and 2s + 1 belong to subset s, channels R, G, B, A
+    const uint32_t endpointCount = 2u * mode.subsets;
+    int endpoints[6][4];
+    for (int c = 0; c < 3; c++)
+    {
+        for (uint32_t e = 0; e < endpointCount; e++) endpoints[e][c] = (int)reader.take(mode.color_bits);
+    }
+    for (uint32_t e = 0; e < endpointCount; e++) endpoints[e][3] = (int)reader.take(mode.alpha_bits);
+
+    int colorBits = mode.color_bits;
+    int alphaBits = mode.alpha_bits;
+    if (mode.endpoint_pbits || mode.shared_pbits)
+    {
+        for (uint32_t e = 0; e < endpointCount; e++)
+        {
+            if (mode.shared_pbits && (e & 1)) continue;
+            const int pbit = (int)reader.take(1);
+            const uint32_t last = mode.shared_pbits ? e + 1 : e;
+            for (uint32_t k = e; k <= last; k++)
+            {
+                for (int c = 0; c < 4; c++) endpoints[k][c] = endpoints[k][c] << 1 | pbit;
+            }
+        }
+        colorBits++;
+        if (alphaBits) alphaBits++;
+    }
+
+    for (uint32_t e = 0; e < endpointCount; e++)
+    {
+        for (int c = 0; c < 3; c++) endpoints[e][c] = expand_bits(endpoints[e][c], colorBits);
+        endpoints[e][3] = alphaBits ? expand_bits(endpoints[e][3], alphaBits) : 255;
+    }
+
+    // Subsets of the pixels and the anchors after pixel 0, in ascending order
+    uint32_t subsets = 0;
+    uint32_t anchor1 = 16;
+    uint32_t anchor2 = 16;
+    if (mode.subsets == 2)
+    {
+        const uint32_t mask = BC7_PARTITIONS2[partition];
+        for (int p = 0; p < 16; p++) subsets |= (mask >> p & 1) << (2 * p);
+        anchor1 = BC7_ANCHORS2[partition];
+    }
+    else if (mode.subsets == 3)
+    {
+        subsets = BC7_PARTITIONS3[partition];
+        anchor1 = (std::min)(BC7_ANCHORS3_SECOND[partition], BC7_ANCHORS3_THIRD[partition]);
+        anchor2 = (std::max)(BC7_ANCHORS3_SECOND[partition], BC7_ANCHORS3_THIRD[partition]);
+    }
+
+    // Past the endpoints at most 64 bits are left for the indices of a
+    // set, so they are read from one word. Anchor indices are a bit
+    // shorter, a zero inserted above each gives all indices the same
+    // width at fixed positions.
+    const uint32_t indexBits = mode.index_bits;
+    uint64_t bits = reader.rest();
+    bits = insert_zero_bit(bits, indexBits - 1);
+    if (anchor1 < 16) bits = insert_zero_bit(bits, anchor1 * indexBits + indexBits - 1);
+    if (anchor2 < 16) bits = insert_zero_bit(bits, anchor2 * indexBits + indexBits - 1);
+
+    const uint64_t indexMask = (1u << indexBits) - 1;
+    uint32_t palettes[3][16];
+
+    if (mode.index_bits2 == 0)
+    {
+#if SIMD_X86
+        if (Mode == 6 && level >= SIMD_LEVEL_SSE41)
+        {
+            decode_bc7_mode6_sse41(endpoints[0], endpoints[1], bits, out);
+            return;
+        }
+#endif
+
+        const uint32_t entries = 1u << indexBits;
+        for (uint32_t s = 0; s < mode.subsets; s++)
+        {
+            bc7_palette(endpoints[2 * s], endpoints[2 * s + 1], bc7_weights(indexBits), entries, palettes[s], level);
+        }
+
+        if (mode.subsets == 1)
+        {
+            for (int p = 0; p < 16; p++) out[p] = palettes[0][bits >> (p * indexBits) & indexMask];
+            return;
+        }
+
+        for (int p = 0; p < 16; p++) out[p] = palettes[subsets >> (2 * p) & 3][bits >> (p * indexBits) & indexMask];
+        return;
+    }
+
+    // One subset with a second set of indices, for alpha unless selection swaps them
+    const uint32_t indexBits2 = mode.index_bits2;
+    reader.take(16 * indexBits - 1);
+    const uint64_t bits2 = insert_zero_bit(reader.rest(), indexBits2 - 1);
+    const uint64_t indexMask2 = (1u << indexBits2) - 1;
+
+    const uint32_t colorIndexBits = selection ? indexBits2 : indexBits;
+    const uint32_t alphaIndexBits = selection ? indexBits : indexBits2;
+    bc7_palette(endpoints[0], endpoints[1], bc7_weights(colorIndexBits), 1u << colorIndexBits, palettes[0], level);
+    bc7_palette(endpoints[0], endpoints[1], bc7_weights(alphaIndexBits), 1u << alphaIndexBits, palettes[1], level);
+
+    // Rotation swaps alpha with R, G or B, at those bytes of BGRA
+    static const uint32_t ROTATED_SHIFT[4] = { 24, 16, 8, 0 };
+    const uint32_t shift = ROTATED_SHIFT[rotation];
+
+    for (int p = 0; p < 16; p++)
+    {
+        const uint32_t index = (uint32_t)(bits >> (p * indexBits) & indexMask);
+        const uint32_t index2 = (uint32_t)(bits2 >> (p * indexBits2) & indexMask2);
+        const uint32_t colorIndex = selection ? index2 : index;
+        const uint32_t alphaIndex = selection ? index : index2;
+
+        uint32_t pixel = (palettes[0][colorIndex] & 0x00FFFFFFu) | (palettes[1][alphaIndex] & 0xFF000000u);
+        if (rotation)
+        {
+            const uint32_t alpha = pixel >> 24;
+            const uint32_t swapped = pixel >> shift & 0xFF;
+            pixel = (pixel & 0x00FFFFFFu & ~(0xFFu << shift)) | alpha << shift | swapped << 24;
+        }
+        out[p] = pixel;
+    }
+}
+
+// Decodes a 16-byte block to 16 BGRA pixels, rows from the top.
+// Reserved modes decode to transparent black.
+static void decode_bc7(const uint8_t* block, uint32_t* out, SIMD_LEVEL level)
+{
+    switch (block[0] & -block[0])
+    {
+    case 0x01: decode_bc7_mode<0>(block, out, level); break;
+    case 0x02: decode_bc7_mode<1>(block, out, level); break;
+    case 0x04: decode_bc7_mode<2>(block, out, level); break;
+    case 0x08: decode_bc7_mode<3>(block, out, level); break;
+    case 0x10: decode_bc7_mode<4>(block, out, level); break;
+    case 0x20: decode_bc7_mode<5>(block, out, level); break;
+    case 0x40: decode_bc7_mode<6>(block, out, level); break;
+    case 0x80: decode_bc7_mode<7>(block, out, level); break;
+    default: memset(out, 0, 64); break;
+    }
+}
+
+uint32_t bc_decoded_channels(uint32_t dxgi_format)
+{
+    switch (dxgi_format)
+    {
+    case DDS_DXGI_FORMAT_BC4_UNORM:
+        return 1;
+    case DDS_DXGI_FORMAT_BC1_UNORM:
+    case DDS_DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_BC2_UNORM:
+    case DDS_DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_BC3_UNORM:
+    case DDS_DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_BC5_UNORM:
+    case DDS_DXGI_FORMAT_BC7_UNORM:
+    case DDS_DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// Decodes a block to 16 pixels of bc_decoded_channels bytes, rows from the top
+static void decode_block(const uint8_t* block, uint32_t dxgi_format, uint8_t* out, SIMD_LEVEL level)
+{
+    uint32_t* pixels = (uint32_t*)out;
+    uint32_t palette[4];
+    uint8_t values[8];
+    uint8_t alpha[16];
+    uint32_t indices;
+
+    switch (dxgi_format)
+    {
+    case DDS_DXGI_FORMAT_BC1_UNORM:
+    case DDS_DXGI_FORMAT_BC1_UNORM_SRGB:
+        bc1_palette(block, false, palette);
+        memcpy(&indices, block + 4, 4);
+        lookup_bc1(palette, indices, pixels, level);
+        break;
+
+    case DDS_DXGI_FORMAT_BC2_UNORM:
+    case DDS_DXGI_FORMAT_BC2_UNORM_SRGB:
+        bc1_palette(block + 8, true, palette);
+        memcpy(&indices, block + 12, 4);
+        lookup_bc1(palette, indices, pixels, level);
+
+        // Explicit 4-bit alpha
+        for (int p = 0; p < 16; p++)
+        {
+            const uint32_t a = block[p >> 1] >> (4 * (p & 1)) & 0xF;
+            pixels[p] = (pixels[p] & 0x00FFFFFFu) | (a << 4 | a) << 24;
+        }
+        break;
+
+    case DDS_DXGI_FORMAT_BC3_UNORM:
+    case DDS_DXGI_FORMAT_BC3_UNORM_SRGB:
+        bc1_palette(block + 8, true, palette);
+        memcpy(&indices, block + 12, 4);
+        lookup_bc1(palette, indices, pixels, level);
+
+        bc4_palette(block, values);
+        lookup_bc4(values, bc4_indices(block), alpha, level);
+        for (int p = 0; p < 16; p++) pixels[p] = (pixels[p] & 0x00FFFFFFu) | (uint32_t)alpha[p] << 24;
+        break;
+
+    case DDS_DXGI_FORMAT_BC4_UNORM:
+        bc4_palette(block, values);
+        lookup_bc4(values, bc4_indices(block), out, level);
+        break;
+
+    case DDS_DXGI_FORMAT_BC5_UNORM:
+    {
+        uint8_t green[16];
+        bc4_palette(block, values);
+        lookup_bc4(values, bc4_indices(block), alpha, level);
+        bc4_palette(block + 8, values);
+        lookup_bc4(values, bc4_indices(block + 8), green, level);
+        for (int p = 0; p < 16; p++) pixels[p] = pack_bgra(alpha[p], green[p], 0, 255);
+        break;
+    }
+
+    default:
+        decode_bc7(block, pixels, level);
+        break;
+    }
+}
+
+/**
+ * Decompresses blocks to pixels.
+ *
+ * \param blocks dds_level_size bytes of blocks, rows from the top
+ * \param dxgi_format block-compressed DXGI format of the blocks
+ * \param width width of the image
+ * \param height height of the image
+ * \param dst first row of the pixels, the bottom one
+ * \param row_pitch bytes between rows
+ * \param pool workers to decode on, nullptr decodes on the calling thread
+ * \param level instruction set of the palettes and lookups
+ * \return error code (0 - success, -1 - error)
+ */
+int bc_decode(const uint8_t* blocks, uint32_t dxgi_format, uint32_t width, uint32_t height,
+    uint8_t* dst, size_t row_pitch, WorkerPool* pool, SIMD_LEVEL level)
+{
+    const uint32_t channels = bc_decoded_channels(dxgi_format);
+    if (channels == 0)
+    {
+        fprintf(stderr, "DXGI format %u cannot be decoded\n", dxgi_format);
+        return -1;
+    }
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockBytes = dds_block_bytes(dxgi_format);
+
+    auto decodeRows = [&](uint32_t begin, uint32_t end)
+    {
+        uint32_t pixels[16];
+        for (uint32_t by = begin; by < end; by++)
+        {
+            const uint32_t rows = (std::min)(4u, height - by * 4);
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                decode_block(blocks + ((size_t)by * blocksX + bx) * blockBytes, dxgi_format,
+                    (uint8_t*)pixels, level);
+
+                uint8_t* out = dst + (size_t)(height - 1 - by * 4) * row_pitch + (size_t)bx * 4 * channels;
+                const uint8_t* in = (const uint8_t*)pixels;
+
+                // Whole rows of a block are copied in one move, edge blocks are cropped
+                if (rows == 4 && bx * 4 + 4 <= width)
+                {
+                    for (uint32_t y = 0; y < 4; y++, out -= row_pitch, in += 4 * channels)
+                    {
+                        if (channels == 4) memcpy(out, in, 16);
+                        else memcpy(out, in, 4);
+                    }
+                    continue;
+                }
+
+                const size_t rowBytes = (size_t)(std::min)(4u, width - bx * 4) * channels;
+                for (uint32_t y = 0; y < rows; y++, out -= row_pitch, in += 4 * channels)
+                {
+                    memcpy(out, in, rowBytes);
+                }
+            }
+        }
+    };
+
+    if (pool)
+    {
+        pool->ParallelFor(blocksY, BC_DECODE_ROW_GRAIN, decodeRows);
+    }
+    else
+    {
+        decodeRows(0, blocksY);
+    }
+
+    return 0;
+}
@@ -0,0 +1,560 @@
+/*****************************************************************//**
+ * \file   image_dds.cpp
+ * \brief  Layout of .dds files, reading and writing them
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "image_dds.h"
+
+// Legacy FourCCs of D3DFORMAT values without a character code
+#define DDS_D3DFMT_A16B16G16R16F 113u
+#define DDS_D3DFMT_R32F 114u
+
+uint32_t dds_block_bytes(uint32_t dxgi_format)
+{
+    switch (dxgi_format)
+    {
+    case DDS_DXGI_FORMAT_BC1_UNORM:
+    case DDS_DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_BC4_UNORM:
+    case DDS_DXGI_FORMAT_BC4_SNORM:
+        return 8;
+    case DDS_DXGI_FORMAT_BC2_UNORM:
+    case DDS_DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_BC3_UNORM:
+    case DDS_DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_BC5_UNORM:
+    case DDS_DXGI_FORMAT_BC5_SNORM:
+    case DDS_DXGI_FORMAT_BC6H_UF16:
+    case DDS_DXGI_FORMAT_BC6H_SF16:
+    case DDS_DXGI_FORMAT_BC7_UNORM:
+    case DDS_DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+uint32_t dds_bits_per_pixel(uint32_t dxgi_format)
+{
+    switch (dxgi_format)
+    {
+    case DDS_DXGI_FORMAT_R8_UNORM:
+        return 8;
+    case DDS_DXGI_FORMAT_R8G8_UNORM:
+    case DDS_DXGI_FORMAT_R16_UNORM:
+        return 16;
+    case DDS_DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DDS_DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DDS_DXGI_FORMAT_R32_FLOAT:
+    case DDS_DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DDS_DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DDS_DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        return 32;
+    case DDS_DXGI_FORMAT_R16G16B16A16_FLOAT:
+        return 64;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Layout of a mip level as stored in .dds files: rows of 4 x 4 blocks
+ * for block-compressed formats, else rows of pixels rounded up to bytes.
+ *
+ * \param dxgi_format format of the pixels
+ * \param width width of the level
+ * \param height height of the level
+ * \param row_pitch bytes of a row
+ * \param row_count rows of the level
+ * \return false if the format is unknown
+ */
+bool dds_surface_pitch(uint32_t dxgi_format, uint32_t width, uint32_t height,
+    uint32_t& row_pitch, uint32_t& row_count)
+{
+    const uint32_t blockBytes = dds_block_bytes(dxgi_format);
+    if (blockBytes)
+    {
+        row_pitch = (std::max)((width + 3u) / 4u, 1u) * blockBytes;
+        row_count = (std::max)((height + 3u) / 4u, 1u);
+        return true;
+    }
+
+    const uint32_t bits = dds_bits_per_pixel(dxgi_format);
+    row_pitch = (uint32_t)(((uint64_t)width * bits + 7) / 8);
+    row_count = height;
+    return bits != 0;
+}
+
+uint64_t dds_level_size(uint32_t dxgi_format, uint32_t width, uint32_t height)
+{
+    uint32_t rowPitch = 0;
+    uint32_t rowCount = 0;
+    if (!dds_surface_pitch(dxgi_format, width, height, rowPitch, rowCount)) return 0;
+    return (uint64_t)rowPitch * rowCount;
+}
+
+// DXGI format of a legacy FourCC, DDS_DXGI_FORMAT_UNKNOWN if unsupported
+static uint32_t four_cc_format(uint32_t four_cc)
+{
+    switch (four_cc)
+    {
+    case DDS_FOURCC_CODE('D', 'X', 'T', '1'):
+        return DDS_DXGI_FORMAT_BC1_UNORM;
+    case DDS_FOURCC_CODE('D', 'X', 'T', '2'):
+    case DDS_FOURCC_CODE('D', 'X', 'T', '3'):
+        return DDS_DXGI_FORMAT_BC2_UNORM;
+    case DDS_FOURCC_CODE('D', 'X', 'T', '4'):
+    case DDS_FOURCC_CODE('D', 'X', 'T', '5'):
+        return DDS_DXGI_FORMAT_BC3_UNORM;
+    case DDS_FOURCC_CODE('A', 'T', 'I', '1'):
+    case DDS_FOURCC_CODE('B', 'C', '4', 'U'):
+        return DDS_DXGI_FORMAT_BC4_UNORM;
+    case DDS_FOURCC_CODE('B', 'C', '4', 'S'):
+        return DDS_DXGI_FORMAT_BC4_SNORM;
+    case DDS_FOURCC_CODE('A', 'T', 'I', '2'):
+    case DDS_FOURCC_CODE('B', 'C', '5', 'U'):
+        return DDS_DXGI_FORMAT_BC5_UNORM;
+    case DDS_FOURCC_CODE('B', 'C', '5', 'S'):
+        return DDS_DXGI_FORMAT_BC5_SNORM;
+    case DDS_D3DFMT_A16B16G16R16F:
+        return DDS_DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case DDS_D3DFMT_R32F:
+        return DDS_DXGI_FORMAT_R32_FLOAT;
+    default:
+        return DDS_DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+static bool has_masks(const dds_pixel_format& format, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return format.r_bit_mask == r && format.g_bit_mask == g && format.b_bit_mask == b && format.a_bit_mask == a;
+}
+
+// DXGI format of a legacy pixel format, DDS_DXGI_FORMAT_UNKNOWN if unsupported
+static uint32_t legacy_format(const dds_pixel_format& format)
+{
+    if (format.flags & DDS_FOURCC) return four_cc_format(format.four_cc);
+
+    const bool alpha = (format.flags & DDS_ALPHAPIXELS) != 0;
+    if ((format.flags & DDS_RGB) && format.rgb_bit_count == 32)
+    {
+        if (has_masks(format, 0x000000FF, 0x0000FF00, 0x00FF0000, alpha ? 0xFF000000 : 0)) return DDS_DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (has_masks(format, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000) && alpha) return DDS_DXGI_FORMAT_B8G8R8A8_UNORM;
+        if (has_masks(format, 0x00FF0000, 0x0000FF00, 0x000000FF, 0)) return DDS_DXGI_FORMAT_B8G8R8X8_UNORM;
+    }
+    else if (format.flags & DDS_LUMINANCE)
+    {
+        if (format.rgb_bit_count == 8 && has_masks(format, 0xFF, 0, 0, 0)) return DDS_DXGI_FORMAT_R8_UNORM;
+        if (format.rgb_bit_count == 16 && has_masks(format, 0xFFFF, 0, 0, 0)) return DDS_DXGI_FORMAT_R16_UNORM;
+        if (format.rgb_bit_count == 16 && alpha && has_masks(format, 0xFF, 0, 0, 0xFF00)) return DDS_DXGI_FORMAT_R8G8_UNORM;
+    }
+
+    return DDS_DXGI_FORMAT_UNKNOWN;
+}
+
+// Legacy pixel format of a DXGI format, false if it needs the DX10 header
+static bool legacy_pixel_format(uint32_t dxgi_format, dds_pixel_format& format)
+{
+    format = dds_pixel_format();
+    switch (dxgi_format)
+    {
+    case DDS_DXGI_FORMAT_BC1_UNORM:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_FOURCC_CODE('D', 'X', 'T', '1');
+        return true;
+    case DDS_DXGI_FORMAT_BC2_UNORM:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_FOURCC_CODE('D', 'X', 'T', '3');
+        return true;
+    case DDS_DXGI_FORMAT_BC3_UNORM:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_FOURCC_CODE('D', 'X', 'T', '5');
+        return true;
+    case DDS_DXGI_FORMAT_BC4_UNORM:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_FOURCC_CODE('B', 'C', '4', 'U');
+        return true;
+    case DDS_DXGI_FORMAT_BC5_UNORM:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_FOURCC_CODE('B', 'C', '5', 'U');
+        return true;
+    case DDS_DXGI_FORMAT_R16G16B16A16_FLOAT:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_D3DFMT_A16B16G16R16F;
+        return true;
+    case DDS_DXGI_FORMAT_R32_FLOAT:
+        format.flags = DDS_FOURCC;
+        format.four_cc = DDS_D3DFMT_R32F;
+        return true;
+    case DDS_DXGI_FORMAT_R8G8B8A8_UNORM:
+        format.flags = DDS_RGB | DDS_ALPHAPIXELS;
+        format.rgb_bit_count = 32;
+        format.r_bit_mask = 0x000000FF;
+        format.g_bit_mask = 0x0000FF00;
+        format.b_bit_mask = 0x00FF0000;
+        format.a_bit_mask = 0xFF000000;
+        return true;
+    case DDS_DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DDS_DXGI_FORMAT_B8G8R8X8_UNORM:
+        format.flags = DDS_RGB;
+        format.rgb_bit_count = 32;
+        format.r_bit_mask = 0x00FF0000;
+        format.g_bit_mask = 0x0000FF00;
+        format.b_bit_mask = 0x000000FF;
+        if (dxgi_format == DDS_DXGI_FORMAT_B8G8R8A8_UNORM)
+        {
+            format.flags |= DDS_ALPHAPIXELS;
+            format.a_bit_mask = 0xFF000000;
+        }
+        return true;
+    case DDS_DXGI_FORMAT_R8_UNORM:
+        format.flags = DDS_LUMINANCE;
+        format.rgb_bit_count = 8;
+        format.r_bit_mask = 0xFF;
+        return true;
+    case DDS_DXGI_FORMAT_R16_UNORM:
+        format.flags = DDS_LUMINANCE;
+        format.rgb_bit_count = 16;
+        format.r_bit_mask = 0xFFFF;
+        return true;
+    case DDS_DXGI_FORMAT_R8G8_UNORM:
+        format.flags = DDS_LUMINANCE | DDS_ALPHAPIXELS;
+        format.rgb_bit_count = 16;
+        format.r_bit_mask = 0xFF;
+        format.a_bit_mask = 0xFF00;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Bytes of all levels of one slice
+static uint64_t slice_size(const dds_info& info)
+{
+    uint64_t size = 0;
+    for (uint32_t mip = 0; mip < info.mip_count; mip++)
+    {
+        size += dds_level_size(info.dxgi_format, (std::max)(info.width >> mip, 1u), (std::max)(info.height >> mip, 1u));
+    }
+    return size;
+}
+
+/**
+ * Validates the headers of a .dds file in memory and finds its slices.
+ * 2D textures, texture arrays and cube maps with legacy or DX10 headers
+ * are accepted, of the formats dds_level_size knows.
+ *
+ * \param src name of the file, for messages
+ * \param data contents of the file
+ * \param size bytes of data
+ * \param info texture found in the file
+ * \return error code (0 - success, -1 - error)
+ */
+int parse_dds_header(const char* src, const uint8_t* data, uint64_t size, dds_info& info)
+{
+    uint32_t magic = 0;
+    dds_header header;
+    if (size < sizeof(magic) + sizeof(header))
+    {
+        fprintf(stderr, "%s: file is too small for a DDS header\n", src);
+        return -1;
+    }
+
+    memcpy(&magic, data, sizeof(magic));
+    memcpy(&header, data + sizeof(magic), sizeof(header));
+
+    if (magic != DDS_MAGIC || header.size != sizeof(dds_header) || header.ddspf.size != sizeof(dds_pixel_format))
+    {
+        fprintf(stderr, "%s: not a DDS file\n", src);
+        return -1;
+    }
+
+    info = dds_info();
+    info.width = header.width;
+    info.height = header.height;
+    info.mip_count = header.mip_map_count ? header.mip_map_count : 1;
+    info.data_offset = sizeof(magic) + sizeof(header);
+
+    if (header.caps2 & DDS_VOLUME)
+    {
+        fprintf(stderr, "%s: volume textures are not supported\n", src);
+        return -1;
+    }
+
+    if ((header.ddspf.flags & DDS_FOURCC) && header.ddspf.four_cc == DDS_FOURCC_CODE('D', 'X', '1', '0'))
+    {
+        dds_header_dx10 dx10;
+        if (size < info.data_offset + sizeof(dx10))
+        {
+            fprintf(stderr, "%s: DX10 header is truncated\n", src);
+            return -1;
+        }
+
+        memcpy(&dx10, data + info.data_offset, sizeof(dx10));
+        info.data_offset += sizeof(dx10);
+        info.dxgi_format = dx10.dxgi_format;
+        info.cube = (dx10.misc_flag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+
+        if (dx10.resource_dimension != DDS_DIMENSION_TEXTURE2D)
+        {
+            fprintf(stderr, "%s: only 2D textures are supported\n", src);
+            return -1;
+        }
+
+        // Arrays of cube maps count cubes
+        const uint32_t slicesPerItem = info.cube ? 6 : 1;
+        if (dx10.array_size == 0 || dx10.array_size > DDS_MAX_ARRAY_SIZE / slicesPerItem)
+        {
+            fprintf(stderr, "%s: invalid array of %u textures\n", src, dx10.array_size);
+            return -1;
+        }
+        info.array_size = dx10.array_size * slicesPerItem;
+    }
+    else
+    {
+        info.dxgi_format = legacy_format(header.ddspf);
+
+        if (header.caps2 & DDS_CUBEMAP)
+        {
+            if ((header.caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
+            {
+                fprintf(stderr, "%s: cube maps without all faces are not supported\n", src);
+                return -1;
+            }
+            info.cube = true;
+            info.array_size = 6;
+        }
+    }
+
+    if (dds_level_size(info.dxgi_format, 1, 1) == 0)
+    {
+        fprintf(stderr, "%s: unsupported DDS pixel format\n", src);
+        return -1;
+    }
+
+    uint32_t maxMips = 1;
+    while (maxMips < 32 && (std::max)(info.width, info.height) >> maxMips) maxMips++;
+
+    if (info.width == 0 || info.height == 0 || info.width > DDS_MAX_DIMENSION ||
+        info.height > DDS_MAX_DIMENSION || info.mip_count > maxMips)
+    {
+        fprintf(stderr, "%s: invalid %u x %u texture of %u mips\n", src, info.width, info.height, info.mip_count);
+        return -1;
+    }
+
+    if (info.cube && info.width != info.height)
+    {
+        fprintf(stderr, "%s: cube map faces of %u x %u are not square\n", src, info.width, info.height);
+        return -1;
+    }
+
+    if (slice_size(info) > (size - info.data_offset) / info.array_size)
+    {
+        fprintf(stderr, "%s: DDS data is truncated\n", src);
+        return -1;
+    }
+
+    return 0;
+}
+
+dds_subresource dds_subresource_layout(const dds_info& info, uint32_t mip, uint32_t slice)
+{
+    dds_subresource subresource;
+    subresource.offset = info.data_offset + slice * slice_size(info);
+
+    for (uint32_t level = 0; level <= mip; level++)
+    {
+        subresource.offset += subresource.size;
+        subresource.width = (std::max)(info.width >> level, 1u);
+        subresource.height = (std::max)(info.height >> level, 1u);
+        dds_surface_pitch(info.dxgi_format, subresource.width, subresource.height,
+            subresource.row_pitch, subresource.row_count);
+        subresource.size = (uint64_t)subresource.row_pitch * subresource.row_count;
+    }
+
+    return subresource;
+}
+
+/**
+ * Writes the headers and levels of a texture. The file is written next
+ * to the path and renamed over it when complete.
+ *
+ * \param path path and/or file name
+ * \param info texture to write, data_offset is ignored
+ * \param subresources rows of every level of every slice, D3D12 order
+ * \return error code (0 - success, -1 - error)
+ */
+int write_dds(const char* path, const dds_info& info, const uint8_t* const* subresources)
+{
+    const bool validArray = info.array_size > 0 && info.array_size <= DDS_MAX_ARRAY_SIZE &&
+        (!info.cube || (info.array_size % 6 == 0 && info.width == info.height));
+
+    if (dds_level_size(info.dxgi_format, 1, 1) == 0 || info.width == 0 || info.height == 0 ||
+        info.width > DDS_MAX_DIMENSION || info.height > DDS_MAX_DIMENSION || info.mip_count == 0 || !validArray)
+    {
+        fprintf(stderr, "Invalid texture for %s\n", path);
+        return -1;
+    }
+
+    dds_header header;
+    header.flags = DDS_HEADER_FLAGS_TEXTURE;
+    header.width = info.width;
+    header.height = info.height;
+    header.mip_map_count = info.mip_count;
+    header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+    const dds_subresource top = dds_subresource_layout(info, 0, 0);
+    if (dds_block_bytes(info.dxgi_format))
+    {
+        header.flags |= DDS_HEADER_FLAGS_LINEARSIZE;
+        header.pitch_or_linear_size = (uint32_t)top.size;
+    }
+    else
+    {
+        header.flags |= DDS_HEADER_FLAGS_PITCH;
+        header.pitch_or_linear_size = top.row_pitch;
+    }
+
+    if (info.mip_count > 1)
+    {
+        header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+        header.caps |= DDS_SURFACE_FLAGS_MIPMAP;
+    }
+
+    if (info.cube)
+    {
+        header.caps |= DDS_SURFACE_FLAGS_CUBEMAP;
+        header.caps2 = DDS_CUBEMAP_ALLFACES;
+    }
+
+    // Legacy headers hold a single texture or cube
+    dds_header_dx10 dx10;
+    const bool single = info.array_size == (info.cube ? 6u : 1u);
+    const bool useDx10 = !single || !legacy_pixel_format(info.dxgi_format, header.ddspf);
+    if (useDx10)
+    {
+        header.ddspf = dds_pixel_format();
+        header.ddspf.flags = DDS_FOURCC;
+        header.ddspf.four_cc = DDS_FOURCC_CODE('D', 'X', '1', '0');
+        dx10.dxgi_format = info.dxgi_format;
+        dx10.misc_flag = info.cube ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+        dx10.array_size = info.cube ? info.array_size / 6 : info.array_size;
+    }
+
+    const std::string tempPath = std::string(path) + ".tmp";
+    FILE* pFile = fopen(tempPath.c_str(), "wb");
+    if (!pFile)
+    {
+        fprintf(stderr, "Failed to create %s\n", tempPath.c_str());
+        return -1;
+    }
+
+    const uint32_t magic = DDS_MAGIC;
+    bool ok = fwrite(&magic, sizeof(magic), 1, pFile) == 1 &&
+        fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+        (!useDx10 || fwrite(&dx10, sizeof(dx10), 1, pFile) == 1);
+
+    for (uint32_t i = 0; ok && i < info.mip_count * info.array_size; i++)
+    {
+        const dds_subresource layout = dds_subresource_layout(info, i % info.mip_count, 0);
+        ok = fwrite(subresources[i], 1, (size_t)layout.size, pFile) == layout.size;
+    }
+
+    if (fclose(pFile) != 0) ok = false;
+
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", tempPath.c_str());
+        remove(tempPath.c_str());
+        return -1;
+    }
+
+    // rename does not replace existing files on Windows
+    remove(path);
+    if (rename(tempPath.c_str(), path) != 0)
+    {
+        fprintf(stderr, "Failed to rename %s\n", tempPath.c_str());
+        remove(tempPath.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes a block-compressed 2D texture with its mip levels.
+ *
+ * \param path path and/or file name
+ * \param dxgi_format block-compressed DXGI format of the levels
+ * \param width width of mip 0
+ * \param height height of mip 0
+ * \param mip_count number of levels
+ * \param levels blocks of every level
+ * \return error code (0 - success, -1 - error)
+ */
+int write_dds(const char* path, uint32_t dxgi_format, uint32_t width, uint32_t height,
+    uint32_t mip_count, const uint8_t* const* levels)
+{
+    if (dds_block_bytes(dxgi_format) == 0)
+    {
+        fprintf(stderr, "Invalid texture for %s\n", path);
+        return -1;
+    }
+
+    dds_info info;
+    info.width = width;
+    info.height = height;
+    info.mip_count = mip_count;
+    info.dxgi_format = dxgi_format;
+    return write_dds(path, info, levels);
+}
+
+/**
+ * Maps a .dds file, validates its headers and finds its subresources.
+ *
+ * \param path path and/or file name
+ * \return error code (0 - success, -1 - error)
+ */
+int dds_file::open(const char* path)
+{
+    close();
+
+    if (m_file.open(path) != 0) return -1;
+
+    if (parse_dds_header(path, m_file.data(), m_file.size(), m_info) != 0)
+    {
+        close();
+        return -1;
+    }
+
+    // Every slice repeats the layout of the first
+    const uint64_t sliceSize = slice_size(m_info);
+    m_subresources.resize((size_t)m_info.mip_count * m_info.array_size);
+    for (uint32_t mip = 0; mip < m_info.mip_count; mip++)
+    {
+        const dds_subresource layout = dds_subresource_layout(m_info, mip, 0);
+        for (uint32_t slice = 0; slice < m_info.array_size; slice++)
+        {
+            dds_subresource& subresource = m_subresources[mip + slice * m_info.mip_count];
+            subresource = layout;
+            subresource.offset += slice * sliceSize;
+            subresource.data = m_file.data() + subresource.offset;
+        }
+    }
+
+    return 0;
+}
+
+void dds_file::close()
+{
+    m_file.close();
+    m_info = dds_info();
+    m_subresources.clear();
+}
@@ -0,0 +1,222 @@
+/*****************************************************************//**
+ * \file   image_dds.h
+ * \brief  Layout of .dds files, reading and writing them
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "memory_util.h"
+
+// "DDS ", first bytes of every .dds file
+#define DDS_MAGIC 0x20534444u
+
+// DXGI_FORMAT values of dxgiformat.h, which is Windows-only
+#define DDS_DXGI_FORMAT_UNKNOWN 0u
+#define DDS_DXGI_FORMAT_R16G16B16A16_FLOAT 10u
+#define DDS_DXGI_FORMAT_R8G8B8A8_UNORM 28u
+#define DDS_DXGI_FORMAT_R8G8B8A8_UNORM_SRGB 29u
+#define DDS_DXGI_FORMAT_R32_FLOAT 41u
+#define DDS_DXGI_FORMAT_R8G8_UNORM 49u
+#define DDS_DXGI_FORMAT_R16_UNORM 56u
+#define DDS_DXGI_FORMAT_R8_UNORM 61u
+#define DDS_DXGI_FORMAT_BC1_UNORM 71u
+#define DDS_DXGI_FORMAT_BC1_UNORM_SRGB 72u
+#define DDS_DXGI_FORMAT_BC2_UNORM 74u
+#define DDS_DXGI_FORMAT_BC2_UNORM_SRGB 75u
+#define DDS_DXGI_FORMAT_BC3_UNORM 77u
+#define DDS_DXGI_FORMAT_BC3_UNORM_SRGB 78u
+#define DDS_DXGI_FORMAT_BC4_UNORM 80u
+#define DDS_DXGI_FORMAT_BC4_SNORM 81u
+#define DDS_DXGI_FORMAT_BC5_UNORM 83u
+#define DDS_DXGI_FORMAT_BC5_SNORM 84u
+#define DDS_DXGI_FORMAT_B8G8R8A8_UNORM 87u
+#define DDS_DXGI_FORMAT_B8G8R8X8_UNORM 88u
+#define DDS_DXGI_FORMAT_B8G8R8A8_UNORM_SRGB 91u
+#define DDS_DXGI_FORMAT_BC6H_UF16 95u
+#define DDS_DXGI_FORMAT_BC6H_SF16 96u
+#define DDS_DXGI_FORMAT_BC7_UNORM 98u
+#define DDS_DXGI_FORMAT_BC7_UNORM_SRGB 99u
+
+// Largest width and height of a 2D texture in D3D12
+#define DDS_MAX_DIMENSION 16384u
+
+// Largest number of slices of a texture array in D3D12
+#define DDS_MAX_ARRAY_SIZE 2048u
+
+// dds_header::flags
+#define DDS_HEADER_FLAGS_TEXTURE 0x00001007u		// CAPS | HEIGHT | WIDTH | PIXELFORMAT
+#define DDS_HEADER_FLAGS_PITCH 0x00000008u
+#define DDS_HEADER_FLAGS_MIPMAP 0x00020000u
+#define DDS_HEADER_FLAGS_LINEARSIZE 0x00080000u
+
+// dds_pixel_format::flags
+#define DDS_ALPHAPIXELS 0x00000001u
+#define DDS_FOURCC 0x00000004u
+#define DDS_RGB 0x00000040u
+#define DDS_LUMINANCE 0x00020000u
+
+// dds_header::caps
+#define DDS_SURFACE_FLAGS_TEXTURE 0x00001000u
+#define DDS_SURFACE_FLAGS_MIPMAP 0x00400008u		// COMPLEX | MIPMAP
+#define DDS_SURFACE_FLAGS_CUBEMAP 0x00000008u		// COMPLEX
+
+// dds_header::caps2
+#define DDS_CUBEMAP 0x00000200u
+#define DDS_CUBEMAP_ALLFACES 0x0000FE00u			// CUBEMAP and the six faces
+#define DDS_VOLUME 0x00200000u
+
+// dds_header_dx10::resource_dimension
+#define DDS_DIMENSION_TEXTURE2D 3u
+
+// dds_header_dx10::misc_flag
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4u
+
+#define DDS_FOURCC_CODE(a, b, c, d) \
+	((uint32_t)(uint8_t)(a) | ((uint32_t)(uint8_t)(b) << 8) | \
+	((uint32_t)(uint8_t)(c) << 16) | ((uint32_t)(uint8_t)(d) << 24))
+
+struct dds_pixel_format
+{
+	uint32_t size = sizeof(dds_pixel_format);
+	uint32_t flags = 0;
+	uint32_t four_cc = 0;
+	uint32_t rgb_bit_count = 0;
+	uint32_t r_bit_mask = 0;
+	uint32_t g_bit_mask = 0;
+	uint32_t b_bit_mask = 0;
+	uint32_t a_bit_mask = 0;
+};
+
+// Follows DDS_MAGIC
+struct dds_header
+{
+	uint32_t size = sizeof(dds_header);
+	uint32_t flags = 0;
+	uint32_t height = 0;
+	uint32_t width = 0;
+	uint32_t pitch_or_linear_size = 0;
+	uint32_t depth = 0;
+	uint32_t mip_map_count = 0;
+	uint32_t reserved1[11] = { };
+	dds_pixel_format ddspf;
+	uint32_t caps = 0;
+	uint32_t caps2 = 0;
+	uint32_t caps3 = 0;
+	uint32_t caps4 = 0;
+	uint32_t reserved2 = 0;
+};
+
+// Follows dds_header when ddspf.four_cc is "DX10"
+struct dds_header_dx10
+{
+	uint32_t dxgi_format = DDS_DXGI_FORMAT_UNKNOWN;
+	uint32_t resource_dimension = DDS_DIMENSION_TEXTURE2D;
+	uint32_t misc_flag = 0;
+	uint32_t array_size = 1;
+	uint32_t misc_flags2 = 0;
+};
+
+/**
+ * 2D texture, texture array or cube map found in a .dds file. Slices
+ * follow each other from data_offset, all levels of a slice before the
+ * next one, mip 0 first. That is the order of D3D12 subresources.
+ */
+struct dds_info
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t mip_count = 0;
+	uint32_t array_size = 1;						// Slices, six per cube of a cube map
+	bool cube = false;								// Slices are faces +X, -X, +Y, -Y, +Z, -Z of cubes
+	uint32_t dxgi_format = DDS_DXGI_FORMAT_UNKNOWN;	// Legacy formats are translated
+	uint32_t data_offset = 0;						// Bytes from the start of the file to the first slice
+};
+
+/**
+ * Placement of one mip level of one slice. Rows are rows of pixels or
+ * of 4 x 4 blocks, from the top, as D3D12_SUBRESOURCE_DATA expects them.
+ */
+struct dds_subresource
+{
+	const uint8_t* data = nullptr;	// Into the mapping of a dds_file, nullptr otherwise
+	uint64_t offset = 0;			// Bytes from the start of the file
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t row_pitch = 0;			// Bytes of a row
+	uint32_t row_count = 0;
+	uint64_t size = 0;				// row_pitch * row_count
+};
+
+static_assert(sizeof(dds_pixel_format) == 32, "dds_pixel_format must match the file layout");
+static_assert(sizeof(dds_header) == 124, "dds_header must match the file layout");
+static_assert(sizeof(dds_header_dx10) == 20, "dds_header_dx10 must match the file layout");
+
+// Bytes of a 4 x 4 block of a block-compressed format, 0 for other formats
+uint32_t dds_block_bytes(uint32_t dxgi_format);
+
+// Bits of a pixel of an uncompressed format, 0 for other formats
+uint32_t dds_bits_per_pixel(uint32_t dxgi_format);
+
+// Bytes of a row and rows of a mip level, false if the format is unknown
+bool dds_surface_pitch(uint32_t dxgi_format, uint32_t width, uint32_t height,
+	uint32_t& row_pitch, uint32_t& row_count);
+
+// Bytes of a mip level, 0 if the format is unknown
+uint64_t dds_level_size(uint32_t dxgi_format, uint32_t width, uint32_t height);
+
+// Validates the headers of a .dds file in memory, src names it in
+// messages. 0 - success, -1 - error
+int parse_dds_header(const char* src, const uint8_t* data, uint64_t size, dds_info& info);
+
+// Placement of a level of a slice in a file of the texture, data is nullptr
+dds_subresource dds_subresource_layout(const dds_info& info, uint32_t mip, uint32_t slice);
+
+/**
+ * Writes a texture. subresources[mip + slice * mip_count] holds the rows
+ * of the level, row_pitch bytes apart as returned by dds_surface_pitch.
+ * Textures older readers know get a legacy header, others a DX10 header.
+ * 0 - success, -1 - error
+ */
+int write_dds(const char* path, const dds_info& info, const uint8_t* const* subresources);
+
+/**
+ * Writes a 2D texture of a block-compressed format. levels[i] holds
+ * dds_level_size bytes of mip i, blocks from the top of the image.
+ * 0 - success, -1 - error
+ */
+int write_dds(const char* path, uint32_t dxgi_format, uint32_t width, uint32_t height,
+	uint32_t mip_count, const uint8_t* const* levels);
+
+/**
+ * .dds file mapped read-only and validated. Subresources point into the
+ * mapping, so they can be uploaded without copies while the file is open.
+ */
+class dds_file
+{
+public:
+	int open(const char* path);		// 0 - success, -1 - error
+	void close();
+
+	const dds_info& info() const { return m_info; }
+	bool is_open() const { return m_file.is_open(); }
+
+	// All subresources in D3D12 order, mip + slice * mip_count
+	uint32_t subresource_count() const { return (uint32_t)m_subresources.size(); }
+	const dds_subresource* subresources() const { return m_subresources.data(); }
+
+	const dds_subresource& subresource(uint32_t mip, uint32_t slice = 0) const
+	{
+		return m_subresources[mip + slice * m_info.mip_count];
+	}
+
+private:
+	mapped_file m_file;
+	dds_info m_info;
+	std::vector<dds_subresource> m_subresources;
+};
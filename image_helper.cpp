@@ -10,9 +10,14 @@
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
 
 #include "image_helper.h"
+#include "image_dds.h"
 #include "memory_util.h"
+#include "image_kernel.h"
 
 static int padded_row_size_bits(uint32_t row_size_bits)
 {
@@ -22,14 +27,66 @@ static int padded_row_size_bits(uint32_t row_size_bits)
     return row_size_bits;
 }
 
+// Rows of .bmp files are padded to 4 bytes
 static int padded_row_size_bytes(uint32_t row_size_bytes)
 {
-    row_size_bytes += 0x7;
-    row_size_bytes &= ~0x7;
+    row_size_bytes += 0x3;
+    row_size_bytes &= ~0x3;
 
     return row_size_bytes;
 }
 
+// Compression methods of .bmp files
+#define BMP_COMPRESSION_RGB 0u
+#define BMP_COMPRESSION_BITFIELDS 3u
+
+// Rows converted by one work item of set_color_mode
+#define IMAGE_CONVERT_ROW_GRAIN 16
+
+// Reads a little-endian value of a file in memory
+template<typename TValue>
+static TValue read_le(const uint8_t* data, uint64_t offset)
+{
+    TValue value;
+    memcpy(&value, data + offset, sizeof(value));
+    return value;
+}
+
+// Bytes from the start of a tiled image to its tile
+static size_t tile_offset(uint32_t tile_row, uint32_t tile_col, uint32_t width, uint32_t bytes_per_pixel)
+{
+    const size_t tile_cols = (width + IMAGE_TILE_SIZE - 1) / IMAGE_TILE_SIZE;
+    return ((size_t)tile_row * tile_cols + tile_col) * IMAGE_TILE_SIZE * IMAGE_TILE_SIZE * bytes_per_pixel;
+}
+
+// Copies one row of pixels between a tiled image and a row-major row
+static void copy_tiled_row(char* tiled, char* row_major, uint32_t row, uint32_t width,
+    uint32_t bytes_per_pixel, bool to_tiles)
+{
+    const uint32_t tile_row_bytes = IMAGE_TILE_SIZE * bytes_per_pixel;
+    const uint32_t row_bytes = width * bytes_per_pixel;
+
+    char* tile = tiled + tile_offset(row / IMAGE_TILE_SIZE, 0, width, bytes_per_pixel) +
+        (row % IMAGE_TILE_SIZE) * tile_row_bytes;
+
+    for (uint32_t offset = 0; offset < row_bytes; offset += tile_row_bytes)
+    {
+        // Full tile rows are copied with a constant size
+        if (offset + tile_row_bytes <= row_bytes)
+        {
+            if (to_tiles) memcpy(tile, row_major + offset, tile_row_bytes);
+            else memcpy(row_major + offset, tile, tile_row_bytes);
+        }
+        else
+        {
+            if (to_tiles) memcpy(tile, row_major + offset, row_bytes - offset);
+            else memcpy(row_major + offset, tile, row_bytes - offset);
+        }
+
+        tile += IMAGE_TILE_SIZE * tile_row_bytes;
+    }
+}
+
 /**
  * image_base constuctor.
  * 
@@ -53,6 +110,7 @@ int image_base::read_raw_memory_from_file(const char* src, uint32_t width, uint3
     m_width = width;
     m_height = height;
     m_colorMode = mode;
+    m_layout = IMAGE_LAYOUT_ROW_MAJOR;
 
     // Calculate row size
     // m_colorMode contains the number of bytes per pixel
@@ -60,6 +118,7 @@ int image_base::read_raw_memory_from_file(const char* src, uint32_t width, uint3
     m_rawByteSize = m_rowByteSize * m_height;
 
     // Allocate memory for raw image_base
+    release_raw();
     m_pRaw = malloc(m_rawByteSize);
 
     // Create input file stream object
@@ -107,6 +166,7 @@ int image_base::read_raw_memory(void* memory, uint32_t width, uint32_t height, I
     m_width = width;
     m_height = height;
     m_colorMode = mode;
+    m_layout = IMAGE_LAYOUT_ROW_MAJOR;
 
     // Calculate row size
     // m_colorMode contains the number of bytes per pixel
@@ -114,6 +174,7 @@ int image_base::read_raw_memory(void* memory, uint32_t width, uint32_t height, I
     m_rawByteSize = m_rowByteSize * m_height;
 
     // Allocate memory for raw image_base
+    release_raw();
     m_pRaw = malloc(m_rawByteSize);
 
     if (!m_pRaw)
@@ -126,107 +187,320 @@ int image_base::read_raw_memory(void* memory, uint32_t width, uint32_t height, I
     return 0;
 }
 
+/**
+ * Allocates zero-filled image data, replacing the current one.
+ * 
+ * \param width width of the image
+ * \param height height of the image
+ * \param mode color mode of the image
+ * \return error code (0 - success, -1 - error)
+ */
+int image_base::allocate(uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode)
+{
+    release_raw();
+
+    m_width = width;
+    m_height = height;
+    m_colorMode = mode;
+    m_layout = IMAGE_LAYOUT_ROW_MAJOR;
+
+    m_rowByteSize = padded_row_size_bytes(m_width * m_colorMode);
+    m_rawByteSize = m_rowByteSize * m_height;
+
+    m_pRaw = calloc(m_rawByteSize, 1);
+
+    if (!m_pRaw)
+    {
+        fprintf(stderr, "Failed to allocate %u bytes\n", m_rawByteSize);
+        m_width = m_height = m_rowByteSize = m_rawByteSize = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Validates the headers of a .bmp file in memory and finds its pixel array.
+ * Uncompressed 8, 24 and 32-bit images are accepted, 32-bit ones also with
+ * BGRA bit fields. Rows may be stored in either order.
+ * 
+ * \param src name of the file, for messages
+ * \param data contents of the file
+ * \param size size of the file in bytes
+ * \param info pixel format of the file
+ * \return error code (0 - success, -1 - error)
+ */
+int parse_bmp_header(const char* src, const uint8_t* data, uint64_t size, bmp_info& info)
+{
+    if (size < 0x36 || data[0] != 'B' || data[1] != 'M')
+    {
+        fprintf(stderr, "%s is not a BMP file\n", src);
+        return -1;
+    }
+
+    // Info headers from BITMAPINFOHEADER to BITMAPV5HEADER share the first 40 bytes
+    const uint32_t headerByteSize = read_le<uint32_t>(data, 0xE);
+    if (headerByteSize != 40 && headerByteSize != 52 && headerByteSize != 56 &&
+        headerByteSize != 108 && headerByteSize != 124)
+    {
+        fprintf(stderr, "%s: unsupported BMP header of %u bytes\n", src, headerByteSize);
+        return -1;
+    }
+
+    const int32_t width = read_le<int32_t>(data, 0x12);
+    const int32_t height = read_le<int32_t>(data, 0x16);
+    const uint16_t planes = read_le<uint16_t>(data, 0x1A);
+    const uint16_t bitsPerPixel = read_le<uint16_t>(data, 0x1C);
+    const uint32_t compression = read_le<uint32_t>(data, 0x1E);
+    const uint32_t colorsUsed = read_le<uint32_t>(data, 0x2E);
+
+    if (planes != 1 || width <= 0 || height == 0 || height == INT32_MIN)
+    {
+        fprintf(stderr, "%s: invalid BMP dimensions %d x %d\n", src, width, height);
+        return -1;
+    }
+
+    if (bitsPerPixel != 8 && bitsPerPixel != 24 && bitsPerPixel != 32)
+    {
+        fprintf(stderr, "%s: %u-bit BMP files are not supported\n", src, bitsPerPixel);
+        return -1;
+    }
+
+    // Palette or bit masks follow the info header
+    uint64_t headerEnd = 0xE + (uint64_t)headerByteSize;
+
+    if (compression == BMP_COMPRESSION_BITFIELDS && bitsPerPixel == 32)
+    {
+        // Masks are part of longer headers, after a 40-byte one they follow it
+        if (headerByteSize == 40) headerEnd += 12;
+        if (headerEnd > size)
+        {
+            fprintf(stderr, "%s: BMP header is truncated\n", src);
+            return -1;
+        }
+
+        if (read_le<uint32_t>(data, 0x36) != 0x00FF0000u ||
+            read_le<uint32_t>(data, 0x3A) != 0x0000FF00u ||
+            read_le<uint32_t>(data, 0x3E) != 0x000000FFu)
+        {
+            fprintf(stderr, "%s: only BGRA bit fields are supported\n", src);
+            return -1;
+        }
+    }
+    else if (compression != BMP_COMPRESSION_RGB)
+    {
+        fprintf(stderr, "%s: compressed BMP files are not supported\n", src);
+        return -1;
+    }
+
+    info = bmp_info();
+    info.width = (uint32_t)width;
+    info.top_down = height < 0;
+    info.height = info.top_down ? (uint32_t)(-(int64_t)height) : (uint32_t)height;
+    info.bits_per_pixel = bitsPerPixel;
+    info.pixel_offset = read_le<uint32_t>(data, 0xA);
+    info.row_pitch = ((uint64_t)info.width * bitsPerPixel + 31) / 32 * 4;
+
+    if (headerEnd > info.pixel_offset || info.pixel_offset > size ||
+        info.row_pitch * info.height > size - info.pixel_offset)
+    {
+        fprintf(stderr, "%s: BMP pixel data is truncated\n", src);
+        return -1;
+    }
+
+    if (bitsPerPixel == 8)
+    {
+        // Zero means all 256 colors
+        info.palette_offset = (uint32_t)headerEnd;
+        info.palette_size = colorsUsed ? colorsUsed : 256;
+
+        if (info.palette_size > 256 || headerEnd + info.palette_size * 4ull > info.pixel_offset)
+        {
+            fprintf(stderr, "%s: invalid BMP palette of %u colors\n", src, info.palette_size);
+            return -1;
+        }
+
+        const uint8_t* palette = data + info.palette_offset;
+        for (uint32_t i = 0; i < info.palette_size; i++)
+        {
+            const uint8_t* entry = palette + 4 * i;
+            if (entry[0] != i || entry[1] != i || entry[2] != i) info.gray_palette = false;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * Reads image data from a .bmp file. All data (size, pixel format) is taken from BMP header.
+ * Bottom-up files of gray levels or colors are mapped and used in place,
+ * others are copied with rows from the bottom and palette entries resolved.
  * 
  * \param src name of the file
- * \return error code (0 - success, 1 - warning, -1 - error)
+ * \return error code (0 - success, -1 - error)
  */
 int image_base::read_bmp(const char* src)
 {
-    // Read the header
-    std::ifstream in;
-    in.open(src, std::ios::binary | std::ios::in);
-
-    uint32_t* ptr = new uint32_t();
+    std::unique_ptr<mapped_file> file(new mapped_file());
+    if (file->open(src, true) != 0) return -1;
 
-    // Read m_headerByteSize
-    in.seekg(0xA);
-    in.read((char*)ptr, 4);
-    uint32_t headerByteSize = *ptr;
+    bmp_info info;
+    if (parse_bmp_header(src, file->data(), file->size(), info) != 0) return -1;
 
-    // Read m_rawByteSize
-    /*in.seekg(0x22);
-    in.read((char*)ptr, 4);
-    m_rawByteSize = *ptr;*/
-
-    // Read width and height
-    in.seekg(0x12);
-    in.read((char*)ptr, 4);
-    m_width = *ptr;
+    if (info.row_pitch * info.height > UINT32_MAX)
+    {
+        fprintf(stderr, "%s: %u x %u image is too large\n", src, info.width, info.height);
+        return -1;
+    }
 
-    in.read((char*)ptr, 4);
-    m_height = *ptr;
+    release_raw();
 
-    // Read color mode
-    in.seekg(0x1C);
-    in.read((char*)ptr, 2);
-    m_colorMode = (IMAGE_COLOR_MODE)(*ptr / 8);
+    m_width = info.width;
+    m_height = info.height;
+    m_colorMode = (IMAGE_COLOR_MODE)(info.bits_per_pixel / 8);
+    m_layout = IMAGE_LAYOUT_ROW_MAJOR;
 
-    // Get row size
+    // Same as the file pitch
     m_rowByteSize = padded_row_size_bytes(m_width * m_colorMode);
+    m_rawByteSize = m_rowByteSize * m_height;
 
-    delete ptr;
+    const uint8_t* pixels = file->data() + info.pixel_offset;
+
+    // Pages are copied only when written to
+    if (!info.top_down && info.gray_palette)
+    {
+        m_pRaw = file->writable_data() + info.pixel_offset;
+        m_pMapping = file.release();
+        return 0;
+    }
 
-    // Allocate memory
     m_pRaw = malloc(m_rawByteSize);
 
-    in.seekg(headerByteSize);
-    in.read((char*)m_pRaw, m_rawByteSize);
+    if (!m_pRaw)
+    {
+        fprintf(stderr, "Failed to allocate %u bytes\n", m_rawByteSize);
+        m_width = m_height = m_rowByteSize = m_rawByteSize = 0;
+        return -1;
+    }
+
+    // Palette entries to gray levels, as in set_color_mode
+    uint8_t levels[256] = { };
+    for (uint32_t i = 0; i < info.palette_size; i++)
+    {
+        const uint8_t* entry = file->data() + info.palette_offset + 4 * i;
+        levels[i] = image_luma(entry[0], entry[1], entry[2]);
+    }
+
+    for (uint32_t row = 0; row < m_height; row++)
+    {
+        const uint32_t fileRow = info.top_down ? m_height - 1 - row : row;
+        const uint8_t* in = pixels + fileRow * info.row_pitch;
+        uint8_t* out = (uint8_t*)m_pRaw + (size_t)row * m_rowByteSize;
 
-    in.close();
+        if (info.gray_palette)
+        {
+            memcpy(out, in, m_rowByteSize);
+            continue;
+        }
+
+        for (uint32_t col = 0; col < m_width; col++)
+        {
+            out[col] = levels[in[col]];
+        }
+    }
 
     return 0;
 }
 
 /**
- * Convert raw color data to BMP and write to file.
+ * Decodes a mip level of a block-compressed .dds file. BC4 textures
+ * become gray images, other formats RGBA ones.
  * 
- * \param dst path and/or file name
+ * \param src name of the file
+ * \param mip level to decode, 0 - the largest
+ * \param pool workers to decode on, nullptr decodes on the calling thread
  * \return error code (0 - success, -1 - error)
  */
-int image_base::write_bmp(const char* dst) const
+int image_base::read_dds(const char* src, uint32_t mip, WorkerPool* pool)
+{
+    dds_file file;
+    if (file.open(src) != 0) return -1;
+
+    const dds_info& info = file.info();
+    const uint32_t channels = bc_decoded_channels(info.dxgi_format);
+    if (channels == 0 || mip >= info.mip_count)
+    {
+        fprintf(stderr, "%s: cannot decode mip %u of DXGI format %u\n", src, mip, info.dxgi_format);
+        return -1;
+    }
+
+    const dds_subresource& level = file.subresource(mip);
+    if (allocate(level.width, level.height, (IMAGE_COLOR_MODE)channels) != 0) return -1;
+
+    return bc_decode(level.data, info.dxgi_format, level.width, level.height,
+        (uint8_t*)m_pRaw, m_rowByteSize, pool);
+}
+
+/**
+ * Size of the headers and the palette of a .bmp file written for the mode.
+ * 
+ * \param mode color mode of the image
+ * \return offset of the pixel array
+ */
+uint32_t bmp_header_size(IMAGE_COLOR_MODE mode)
 {
     uint32_t headerByteSize = 0x36;
 
     // If using grayscale mode (8-bit colors), palette table is needed
-    if (m_colorMode == IMAGE_COLOR_MODE_GRAYSCALE) headerByteSize += 0x400;
+    if (mode == IMAGE_COLOR_MODE_GRAYSCALE) headerByteSize += 0x400;
 
-    void* pHeader = malloc(headerByteSize);
+    return headerByteSize;
+}
 
-    if (!pHeader)
-    {
-        fprintf(stderr, "Error allocating memory for header\n");
-        return -1;
-    }
+/**
+ * Writes the headers and the palette of a bottom-up .bmp file.
+ * 
+ * \param dst memory of bmp_header_size(mode) bytes
+ * \param width width of the image
+ * \param height height of the image
+ * \param mode color mode of the image
+ */
+void fill_bmp_header(void* dst, uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode)
+{
+    const uint32_t headerByteSize = bmp_header_size(mode);
 
-    generic_data header(pHeader, headerByteSize);
+    // Sizes that do not fit into the header are left zero
+    uint64_t pixelByteSize = (uint64_t)padded_row_size_bytes(width * (uint32_t)mode) * height;
+    if (headerByteSize + pixelByteSize > UINT32_MAX) pixelByteSize = 0;
+
+    generic_data header(dst, headerByteSize);
 
     // Start of BMP header
     header.write16(0x0, 0x4D42);                            // "BM"
-    header.write32(0x2, headerByteSize + m_rawByteSize);    // Size of BMP file
+    header.write32(0x2, pixelByteSize ?
+        headerByteSize + (uint32_t)pixelByteSize : 0u);     // Size of BMP file
     header.write32(0x6, 0u);                                // Reserved
     header.write32(0xA, headerByteSize);                    // Start of pixel array
 
     // Start of DIB header
     header.write32(0xE, 0x28u);                             // Number of bytes in the header
-    header.write32(0x12, m_width);                          // Width
-    header.write32(0x16, m_height);                         // Height
+    header.write32(0x12, width);                            // Width
+    header.write32(0x16, height);                           // Height
     header.write16(0x1A, 1u);                               // Number of color planes (ignored)
-    header.write16(0x1C, (uint16_t)m_colorMode * 8u);       // Bits per pixel
+    header.write16(0x1C, (uint16_t)mode * 8u);              // Bits per pixel
     header.write32(0x1E, 0u);                               // Compression method
-    header.write32(0x22, m_rawByteSize);                    // Size of raw image data
+    header.write32(0x22, (uint32_t)pixelByteSize);          // Size of raw image data
     header.write32(0x26, 0xB13u);                           // Horizontal px/m
     header.write32(0x2A, 0xB13u);                           // Vertical px/m
 
     uint32_t paletteCount = 0x0u;
-    if (m_colorMode == IMAGE_COLOR_MODE_GRAYSCALE) paletteCount = 0xffu;
+    if (mode == IMAGE_COLOR_MODE_GRAYSCALE) paletteCount = 0x100u;
 
     header.write32(0x2E, paletteCount);                     // Number of colors in the palette                
     header.write32(0x32, paletteCount);                     // Number of important colors
 
     // Set the palette for grayscale mode
-    if (m_colorMode == IMAGE_COLOR_MODE_GRAYSCALE)
+    if (mode == IMAGE_COLOR_MODE_GRAYSCALE)
     {
         uint64_t offset = 0x36u;
         for (int i = 0; i < 256; i++)
@@ -241,6 +515,27 @@ int image_base::write_bmp(const char* dst) const
             offset += 0x4;
         }
     }
+}
+
+/**
+ * Convert raw color data to BMP and write to file.
+ * 
+ * \param dst path and/or file name
+ * \return error code (0 - success, -1 - error)
+ */
+int image_base::write_bmp(const char* dst) const
+{
+    uint32_t headerByteSize = bmp_header_size(m_colorMode);
+
+    void* pHeader = malloc(headerByteSize);
+
+    if (!pHeader)
+    {
+        fprintf(stderr, "Error allocating memory for header\n");
+        return -1;
+    }
+
+    fill_bmp_header(pHeader, m_width, m_height, m_colorMode);
 
     // Open the file
     std::ofstream out;
@@ -250,7 +545,19 @@ int image_base::write_bmp(const char* dst) const
     out.write((const char*)pHeader, headerByteSize);
 
     // Write the contents
-    out.write((const char*)m_pRaw, m_rawByteSize);
+    if (m_layout == IMAGE_LAYOUT_ROW_MAJOR)
+    {
+        out.write((const char*)m_pRaw, m_rawByteSize);
+    }
+    else
+    {
+        std::unique_ptr<char[]> row(new char[m_rowByteSize]());
+        for (uint32_t r = 0; r < m_height; r++)
+        {
+            read_row(r, row.get());
+            out.write(row.get(), m_rowByteSize);
+        }
+    }
 
     out.close();
 
@@ -260,17 +567,28 @@ int image_base::write_bmp(const char* dst) const
 }
 
 /**
- * Change image color mode. Raw data is recreated
+ * Change image color mode. Raw data is recreated, rows are converted
+ * in bands on the pool.
  * 
  * \param mode image color mode to change
+ * \param pool workers to convert on, nullptr converts on the calling thread
+ * \return error code (0 - success, -1 - error)
  */
-void image_base::set_color_mode(IMAGE_COLOR_MODE mode)
+int image_base::set_color_mode(IMAGE_COLOR_MODE mode, WorkerPool* pool)
 {
     // If the mode is not changed, return
-    if (mode == m_colorMode) return;
+    if (mode == m_colorMode) return 0;
 
     // If there is nothing to change, return
-    if (m_pRaw == nullptr) return;
+    if (m_pRaw == nullptr)
+    {
+        m_colorMode = mode;
+        return 0;
+    }
+
+    // Conversion is done row-major, the layout is restored afterwards
+    IMAGE_LAYOUT layout = m_layout;
+    if (set_layout(IMAGE_LAYOUT_ROW_MAJOR) != 0) return -1;
 
     uint32_t newRowByteSize = padded_row_size_bytes(m_width * (uint32_t)mode);
     uint32_t newRawByteSize = newRowByteSize * m_height;
@@ -278,42 +596,144 @@ void image_base::set_color_mode(IMAGE_COLOR_MODE mode)
     // Allocate memory for new raw color data
     void* pNewRaw = malloc(newRawByteSize);
 
-    for (uint32_t row = 0; row < m_height; row++)
+    if (!pNewRaw)
     {
-        static void* currentRow = pNewRaw;
-        for (uint32_t col = 0; col < m_width; col++)
-        {
-            // Static variable declarations
-            static Color3 clr24;
-            static uint8_t clr8;
+        fprintf(stderr, "Failed to allocate %u bytes\n", newRawByteSize);
+        set_layout(layout);
+        return -1;
+    }
 
-            switch (mode)
-            {
-            case IMAGE_COLOR_MODE_GRAYSCALE:
-                // Calculate grayscale color as mean of other colors
-                clr24 = get_color24(row, col);
-                clr8 = (clr24.r + clr24.g + clr24.b) / 3;
-                *(uint8_t*)((uint64_t)currentRow + col) = clr8;
-                break;
-            case IMAGE_COLOR_MODE_RGB:
-                clr8 = get_color8(row, col);
-                clr24 = { clr8, clr8, clr8 };
-                *(Color3*)((uint64_t)currentRow + (uint64_t)col * 3ull) = clr24;
-                break;
-            }
+    const uint8_t* pSrc = (const uint8_t*)m_pRaw;
+    uint8_t* pDst = (uint8_t*)pNewRaw;
+    const uint32_t srcRowByteSize = m_rowByteSize;
+    const uint32_t rowBytes = m_width * (uint32_t)mode;
+    const IMAGE_COLOR_MODE srcMode = m_colorMode;
+    const SIMD_LEVEL level = GetSimdLevel();
 
+    // Every band writes only its own rows
+    auto convertRows = [=](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t row = begin; row < end; row++)
+        {
+            uint8_t* out = pDst + (size_t)row * newRowByteSize;
+            convert_pixels(pSrc + (size_t)row * srcRowByteSize, srcMode, out, mode, m_width, level);
+            memset(out + rowBytes, 0, newRowByteSize - rowBytes);
         }
-        currentRow = (void*)((uint64_t)currentRow + newRowByteSize);
+    };
+
+    if (pool)
+    {
+        pool->ParallelFor(m_height, IMAGE_CONVERT_ROW_GRAIN, convertRows);
+    }
+    else
+    {
+        convertRows(0, m_height);
     }
 
     // Release current raw memory
-    free(m_pRaw);
+    release_raw();
 
     // Set the class variables
     m_colorMode = mode;
     m_pRaw = pNewRaw;
     m_rawByteSize = newRawByteSize;
     m_rowByteSize = newRowByteSize;
+
+    return set_layout(layout);
+}
+
+/**
+ * Converts the pixels to another layout. Tiles at the right and bottom
+ * edges are padded with zeros.
+ * 
+ * \param layout layout to convert to
+ * \return error code (0 - success, -1 - error)
+ */
+int image_base::set_layout(IMAGE_LAYOUT layout)
+{
+    if (layout == m_layout) return 0;
+
+    if (m_pRaw == nullptr)
+    {
+        m_layout = layout;
+        return 0;
+    }
+
+    uint32_t newRawByteSize = m_rowByteSize * m_height;
+    if (layout == IMAGE_LAYOUT_TILED)
+    {
+        newRawByteSize = tile_rows() * tile_cols() * IMAGE_TILE_SIZE * IMAGE_TILE_SIZE * (uint32_t)m_colorMode;
+    }
+
+    void* pNewRaw = calloc(newRawByteSize, 1);
+
+    if (!pNewRaw)
+    {
+        fprintf(stderr, "Failed to allocate %u bytes\n", newRawByteSize);
+        return -1;
+    }
+
+    // Rows are moved one at a time, a row of tiles stays in the cache
+    // while its rows are written
+    const bool toTiles = layout == IMAGE_LAYOUT_TILED;
+    char* pRowMajor = (char*)(toTiles ? m_pRaw : pNewRaw);
+    char* pTiled = (char*)(toTiles ? pNewRaw : m_pRaw);
+
+    for (uint32_t row = 0; row < m_height; row++)
+    {
+        copy_tiled_row(pTiled, pRowMajor + (size_t)row * m_rowByteSize, row,
+            m_width, (uint32_t)m_colorMode, toTiles);
+    }
+
+    release_raw();
+
+    m_pRaw = pNewRaw;
+    m_layout = layout;
+    m_rawByteSize = newRawByteSize;
+
+    return 0;
+}
+
+/**
+ * Builds mip levels of the pixels. Level 0 of the chain points to the
+ * pixels, so they must not change or move while the chain is used.
+ *
+ * \param chain chain to build
+ * \param filter reduction filter
+ * \param max_levels most levels including the image, 0 for the full chain
+ * \param pool workers to filter on, nullptr filters on the calling thread
+ * \return error code (0 - success, -1 - error)
+ */
+int image_base::generate_mips(mip_chain& chain, MIP_FILTER filter, uint32_t max_levels,
+    WorkerPool* pool) const
+{
+    if (m_layout != IMAGE_LAYOUT_ROW_MAJOR)
+    {
+        fprintf(stderr, "Mip levels need the row-major layout\n");
+        return -1;
+    }
+
+    return chain.generate(m_pRaw, m_width, m_height, m_rowByteSize, (uint32_t)m_colorMode,
+        MIP_FORMAT_UNORM8, filter, max_levels, pool);
+}
+
+/**
+ * Compresses the pixels to a .dds file.
+ *
+ * \param dst path and/or file name
+ * \param format block format
+ * \param quality speed and quality of the endpoint search
+ * \param mips true to store the full mip chain, false for the image only
+ * \param pool workers to filter and encode on, nullptr for the calling thread
+ * \return error code (0 - success, -1 - error)
+ */
+int image_base::write_dds(const char* dst, BC_FORMAT format, BC_QUALITY quality, bool mips,
+    WorkerPool* pool) const
+{
+    mip_chain chain;
+    if (generate_mips(chain, MIP_FILTER_BOX, mips ? 0 : 1, pool) != 0) return -1;
+
+    return write_bc_dds(dst, chain, format, quality, pool);
 }
 
 void image_base::set_color8(int row, int col, uint8_t val)
@@ -354,14 +774,163 @@ Color3 const image_base::get_color24(int row, int col)
 
 const char* image_base::at(int row, int col)
 {
-    const char* result = (const char*)m_pRaw;
-    result += row * m_rowByteSize + col * (uint32_t)m_colorMode;
-    return result;
+    return (const char*)m_pRaw + offset_of(row, col);
+}
+
+size_t image_base::offset_of(uint32_t row, uint32_t col) const
+{
+    if (m_layout == IMAGE_LAYOUT_TILED)
+    {
+        uint32_t inner = (row % IMAGE_TILE_SIZE) * IMAGE_TILE_SIZE + col % IMAGE_TILE_SIZE;
+        return tile_offset(row / IMAGE_TILE_SIZE, col / IMAGE_TILE_SIZE, m_width, (uint32_t)m_colorMode) +
+            (size_t)inner * (uint32_t)m_colorMode;
+    }
+
+    return (size_t)row * m_rowByteSize + (size_t)col * (uint32_t)m_colorMode;
+}
+
+void image_base::read_row(uint32_t row, void* dst) const
+{
+    if (m_layout == IMAGE_LAYOUT_ROW_MAJOR)
+    {
+        memcpy(dst, (const char*)m_pRaw + (size_t)row * m_rowByteSize, m_rowByteSize);
+        return;
+    }
+
+    copy_tiled_row((char*)m_pRaw, (char*)dst, row, m_width, (uint32_t)m_colorMode, false);
+}
+
+/**
+ * Returns a tile of pixels as rows, pointing into the image. In the
+ * row-major layout rows of the tile are image rows.
+ * 
+ * \param tile_row tile index from the top
+ * \param tile_col tile index from the left
+ * \return tile, empty if out of bounds
+ */
+image_tile image_base::get_tile(uint32_t tile_row, uint32_t tile_col)
+{
+    image_tile tile;
+    if (tile_row >= tile_rows() || tile_col >= tile_cols()) return tile;
+
+    const uint32_t row = tile_row * IMAGE_TILE_SIZE;
+    const uint32_t col = tile_col * IMAGE_TILE_SIZE;
+
+    tile.data = (uint8_t*)at(row, col);
+    tile.row_pitch = m_layout == IMAGE_LAYOUT_TILED ? IMAGE_TILE_SIZE * (uint32_t)m_colorMode : m_rowByteSize;
+    tile.rows = (std::min)(m_height - row, (uint32_t)IMAGE_TILE_SIZE);
+    tile.cols = (std::min)(m_width - col, (uint32_t)IMAGE_TILE_SIZE);
+    return tile;
+}
+
+/**
+ * Copies a rectangle of pixels to row-major memory, in any layout.
+ * 
+ * \param row first row
+ * \param col first column
+ * \param rows number of rows
+ * \param cols number of columns
+ * \param dst destination, rows of dst_pitch bytes
+ * \param dst_pitch bytes between destination rows
+ * \return error code (0 - success, -1 - out of bounds)
+ */
+int image_base::read_region(uint32_t row, uint32_t col, uint32_t rows, uint32_t cols,
+    void* dst, size_t dst_pitch) const
+{
+    if (row > m_height || rows > m_height - row || col > m_width || cols > m_width - col) return -1;
+
+    const uint32_t bpp = (uint32_t)m_colorMode;
+
+    if (m_layout == IMAGE_LAYOUT_ROW_MAJOR)
+    {
+        for (uint32_t r = 0; r < rows; r++)
+        {
+            memcpy((char*)dst + r * dst_pitch, (const char*)m_pRaw + offset_of(row + r, col), (size_t)cols * bpp);
+        }
+        return 0;
+    }
+
+    // Part of the region inside each tile, rows of a tile are a fixed
+    // distance apart
+    const uint32_t tile_row_bytes = IMAGE_TILE_SIZE * bpp;
+
+    for (uint32_t r = row; r < row + rows; )
+    {
+        const uint32_t tile_rows_left = (std::min)(IMAGE_TILE_SIZE - r % IMAGE_TILE_SIZE, row + rows - r);
+
+        for (uint32_t c = col; c < col + cols; )
+        {
+            const uint32_t run = (std::min)(IMAGE_TILE_SIZE - c % IMAGE_TILE_SIZE, col + cols - c);
+
+            const char* in = (const char*)m_pRaw + offset_of(r, c);
+            char* out = (char*)dst + (r - row) * dst_pitch + (size_t)(c - col) * bpp;
+
+            for (uint32_t k = 0; k < tile_rows_left; k++)
+            {
+                memcpy(out, in, (size_t)run * bpp);
+                in += tile_row_bytes;
+                out += dst_pitch;
+            }
+
+            c += run;
+        }
+
+        r += tile_rows_left;
+    }
+
+    return 0;
+}
+
+/**
+ * Compares pixels with another image of the same size and color mode,
+ * in either layout. Used for golden-image checks.
+ * 
+ * \param other image to compare with
+ * \return largest difference of a channel, -1 if sizes or color modes differ
+ */
+int image_base::max_difference(const image_base& other) const
+{
+    if (m_width != other.m_width || m_height != other.m_height || m_colorMode != other.m_colorMode)
+    {
+        return -1;
+    }
+
+    std::vector<uint8_t> row(m_rowByteSize);
+    std::vector<uint8_t> otherRow(m_rowByteSize);
+    const uint32_t rowBytes = m_width * (uint32_t)m_colorMode;
+
+    int difference = 0;
+    for (uint32_t r = 0; r < m_height; r++)
+    {
+        read_row(r, row.data());
+        other.read_row(r, otherRow.data());
+        for (uint32_t i = 0; i < rowBytes; i++)
+        {
+            difference = (std::max)(difference, abs((int)row[i] - (int)otherRow[i]));
+        }
+    }
+
+    return difference;
 }
 
 image_base::~image_base()
 {
-    if (m_pRaw) free(m_pRaw);
+    release_raw();
+}
+
+void image_base::release_raw()
+{
+    if (m_pMapping)
+    {
+        delete m_pMapping;
+        m_pMapping = nullptr;
+    }
+    else if (m_pRaw)
+    {
+        free(m_pRaw);
+    }
+
+    m_pRaw = nullptr;
 }
 
 /**
@@ -7,14 +7,32 @@
  *********************************************************************/
 #pragma once
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <string>
+
+#include "image_bc.h"
+#include "image_mip.h"
+#include "thread_pool.h"
 
 enum IMAGE_COLOR_MODE
 {
+	IMAGE_COLOR_MODE_RGBA = 4,		// RGBA - 4 bytes
 	IMAGE_COLOR_MODE_RGB = 3,		// RGB - 3 bytes
 	IMAGE_COLOR_MODE_GRAYSCALE = 1	// A - 1 byte
 };
 
+enum IMAGE_LAYOUT
+{
+	IMAGE_LAYOUT_ROW_MAJOR = 0,		// Rows one after another, padded as in .bmp
+	IMAGE_LAYOUT_TILED = 1			// Square tiles row after row, pixels row-major inside a tile
+};
+
+// Side of a tile in pixels. A tile of 8-bit pixels is four cache lines,
+// a tile row fills a SIMD register.
+#define IMAGE_TILE_SIZE 16
+
 struct Color3
 {
 	uint8_t r;
@@ -22,8 +40,59 @@ struct Color3
 	uint8_t b;
 };
 
+/**
+ * Rectangle of pixels addressed as rows of row_pitch bytes in either layout.
+ */
+struct image_tile
+{
+	uint8_t* data = nullptr;		// First pixel
+	uint32_t row_pitch = 0;			// Bytes between rows
+	uint32_t rows = 0;				// Less than IMAGE_TILE_SIZE at the bottom and right edges
+	uint32_t cols = 0;
+};
+
+/**
+ * Pixel format and placement of the pixel array of a .bmp file.
+ */
+struct bmp_info
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t bits_per_pixel = 0;	// 8, 24 or 32
+	bool top_down = false;			// Rows stored from the top, negative height in the header
+
+	uint32_t pixel_offset = 0;		// Bytes from the start of the file to the first row
+	uint64_t row_pitch = 0;			// Bytes between rows, a multiple of 4
+
+	uint32_t palette_offset = 0;	// 8-bit only, BGRA entries
+	uint32_t palette_size = 0;
+	bool gray_palette = true;		// Pixel values are gray levels, palette entry i is (i, i, i)
+};
+
+// Validates the headers of a .bmp file in memory, src names it in
+// messages. 0 - success, -1 - error
+int parse_bmp_header(const char* src, const uint8_t* data, uint64_t size, bmp_info& info);
+
+// Size of the headers and the palette of .bmp files written for the mode
+uint32_t bmp_header_size(IMAGE_COLOR_MODE mode);
+
+// Headers of a bottom-up .bmp file, dst holds bmp_header_size(mode) bytes
+void fill_bmp_header(void* dst, uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode);
+
+class mapped_file;
+
 /**
  * Class used as a storage of image data and its interpretation to common image formats.
+ *
+ * Pixels are stored either row-major, as in .bmp files, or in tiles of
+ * IMAGE_TILE_SIZE x IMAGE_TILE_SIZE pixels. Neighbourhoods of a tiled
+ * image are a few cache lines, whatever direction it is walked in.
+ * Pixel accessors, tiles and regions work in both layouts, rows only
+ * in the row-major one.
+ *
+ * Rows are numbered from the bottom, as stored in bottom-up .bmp files.
+ * Such files are read in place: pixels point into a copy-on-write mapping,
+ * so loading costs only the page faults of the rows that are used.
  */
 class image_base
 {
@@ -36,9 +105,47 @@ protected:
 	int read_raw_memory_from_file(const char* src, uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode, int byte_offset = 0);
 	int read_raw_memory(void* memory, uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode, int byte_offset = 0);
 	int read_bmp(const char* src);
+
+	// Decodes a mip level of a block-compressed .dds file, on the pool
+	// if given. 0 - success, -1 - error
+	int read_dds(const char* src, uint32_t mip = 0, WorkerPool* pool = nullptr);
+
+	int allocate(uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode);
 	int write_bmp(const char* dst) const;
 
-	void set_color_mode(IMAGE_COLOR_MODE mode);
+	// Converts pixels to the mode, on the pool if given. 0 - success, -1 - error
+	int set_color_mode(IMAGE_COLOR_MODE mode, WorkerPool* pool = nullptr);
+
+	// Converts pixels to the layout, 0 - success, -1 - error
+	int set_layout(IMAGE_LAYOUT layout);
+
+	// Mip levels of the pixels, which must be row-major and stay valid
+	// while the chain is used. 0 - success, -1 - error
+	int generate_mips(mip_chain& chain, MIP_FILTER filter, uint32_t max_levels = 0,
+		WorkerPool* pool = nullptr) const;
+
+	// Block-compressed .dds file with box-filtered mips, row-major
+	// layout only. 0 - success, -1 - error
+	int write_dds(const char* dst, BC_FORMAT format, BC_QUALITY quality, bool mips = true,
+		WorkerPool* pool = nullptr) const;
+
+	// Tile of pixels (tile_row * IMAGE_TILE_SIZE, tile_col * IMAGE_TILE_SIZE)
+	image_tile get_tile(uint32_t tile_row, uint32_t tile_col);
+
+	// Copies a rectangle of pixels to rows of dst_pitch bytes,
+	// 0 - success, -1 - out of bounds
+	int read_region(uint32_t row, uint32_t col, uint32_t rows, uint32_t cols,
+		void* dst, size_t dst_pitch) const;
+
+	// Largest difference of a channel from the pixels of other,
+	// -1 if sizes or color modes differ
+	int max_difference(const image_base& other) const;
+
+	uint32_t tile_rows() const { return (m_height + IMAGE_TILE_SIZE - 1) / IMAGE_TILE_SIZE; }
+	uint32_t tile_cols() const { return (m_width + IMAGE_TILE_SIZE - 1) / IMAGE_TILE_SIZE; }
+
+	// Pixels point into a copy-on-write mapping of the .bmp file they were read from
+	bool is_mapped() const { return m_pMapping != nullptr; }
 
 protected:
 	// Raw image_base memory
@@ -46,6 +153,9 @@ protected:
 	void* m_pRaw = nullptr;
 	uint32_t m_rawByteSize = 0;
 
+	// Set if m_pRaw points into a copy-on-write mapping of a .bmp file
+	mapped_file* m_pMapping = nullptr;
+
 	// image_base dimensions - set in constructor
 	uint32_t m_width = 0;
 	uint32_t m_height = 0;
@@ -53,8 +163,11 @@ protected:
 	// image_base color mode - set in constructor
 	IMAGE_COLOR_MODE m_colorMode = IMAGE_COLOR_MODE_RGB;
 
+	// Row size of the row-major layout, also when tiled
 	uint32_t m_rowByteSize = 0;
 
+	IMAGE_LAYOUT m_layout = IMAGE_LAYOUT_ROW_MAJOR;
+
 	// Helper methods for subsclasses
 	void set_color8(int row, int col, uint8_t val);
 	void set_color24(int row, int col, Color3 val);
@@ -63,6 +176,15 @@ protected:
 
 protected:
 	const char* at(int row, int col);
+
+private:
+	size_t offset_of(uint32_t row, uint32_t col) const;
+
+	// Frees or unmaps m_pRaw
+	void release_raw();
+
+	// Copies one row of pixels to a row-major row
+	void read_row(uint32_t row, void* dst) const;
 };
 
 // 8-bit .bmp heightmap
@@ -71,8 +193,16 @@ class HeightmapImage : public image_base
 public:
 	HeightmapImage(std::string filename)
 	{
-		m_rawByteSize = 256 * 256;
 		read_bmp(filename.c_str());
+
+		// Heights are always read as 8-bit samples
+		set_color_mode(IMAGE_COLOR_MODE_GRAYSCALE, &WorkerPool::Default());
+	}
+
+	// Blank heightmap, all samples at zero
+	HeightmapImage(uint32_t width, uint32_t height)
+	{
+		allocate(width, height, IMAGE_COLOR_MODE_GRAYSCALE);
 	}
 
 	uint8_t GetPixel(int row, int col)
@@ -80,11 +210,110 @@ public:
 		return get_color8(row, col);
 	}
 
+	// Pointer to the first sample of the row, for bulk processing.
+	// Row-major layout only, tiled images are read through tiles or regions.
+	const uint8_t* GetRow(int row)
+	{
+		assert(m_layout == IMAGE_LAYOUT_ROW_MAJOR);
+		if (m_layout != IMAGE_LAYOUT_ROW_MAJOR) return nullptr;
+		return (const uint8_t*)at(row, 0);
+	}
+
+	uint8_t* GetWritableRow(int row)
+	{
+		assert(m_layout == IMAGE_LAYOUT_ROW_MAJOR);
+		if (m_layout != IMAGE_LAYOUT_ROW_MAJOR) return nullptr;
+		return (uint8_t*)at(row, 0);
+	}
+
+	// 0 - success, -1 - error
+	int SetLayout(IMAGE_LAYOUT layout) { return set_layout(layout); }
+	IMAGE_LAYOUT GetLayout() const { return m_layout; }
+
+	image_tile GetTile(uint32_t tileRow, uint32_t tileCol) { return get_tile(tileRow, tileCol); }
+	uint32_t GetTileRows() const { return tile_rows(); }
+	uint32_t GetTileColumns() const { return tile_cols(); }
+
+	// Samples [row, row + rows) x [col, col + cols) to dst, 0 - success, -1 - error
+	int ReadRegion(uint32_t row, uint32_t col, uint32_t rows, uint32_t cols,
+		uint8_t* dst, size_t dstPitch) const
+	{
+		return read_region(row, col, rows, cols, dst, dstPitch);
+	}
+
+	// Distance between rows in bytes
+	size_t GetRowPitch() const { return m_rowByteSize; }
+
+	// Box levels for LOD, min/max levels for conservative height queries.
+	// Row-major layout only. 0 - success, -1 - error
+	int GenerateMips(mip_chain& chain, MIP_FILTER filter, uint32_t maxLevels = 0) const
+	{
+		return generate_mips(chain, filter, maxLevels, &WorkerPool::Default());
+	}
+
 	uint32_t GetWidth() const { return m_width; }
 	uint32_t GetHeight() const { return m_height; }
 
-	void write()
+	// Read in place from a bottom-up file of gray levels
+	bool IsMapped() const { return is_mapped(); }
+
+	// 0 - success, -1 - error
+	int WriteBmp(std::string filename) const
 	{
-		write_bmp("test.bmp");
+		return write_bmp(filename.c_str());
 	}
-};
\ No newline at end of file
+
+	// BC4 .dds file with all mips, 0 - success, -1 - error
+	int WriteDds(std::string filename, BC_QUALITY quality = BC_QUALITY_NORMAL) const
+	{
+		return write_dds(filename.c_str(), BC_FORMAT_BC4, quality, true, &WorkerPool::Default());
+	}
+};
+
+// Texture decoded on the CPU, for checking .dds files against golden
+// images without a GPU and for software rendering
+class TextureImage : public image_base
+{
+public:
+	// Mip level of a block-compressed .dds file, BC4 decoded to gray and
+	// other formats to BGRA. Other files, such as golden images, are read as .bmp.
+	TextureImage(std::string filename, uint32_t mip = 0)
+	{
+		const bool dds = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".dds") == 0;
+		if (dds)
+		{
+			read_dds(filename.c_str(), mip, &WorkerPool::Default());
+		}
+		else
+		{
+			read_bmp(filename.c_str());
+		}
+	}
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	IMAGE_COLOR_MODE GetColorMode() const { return m_colorMode; }
+
+	// Pixels of the row from the bottom, channels B, G, R, A
+	const uint8_t* GetRow(int row)
+	{
+		assert(m_layout == IMAGE_LAYOUT_ROW_MAJOR);
+		if (m_layout != IMAGE_LAYOUT_ROW_MAJOR) return nullptr;
+		return (const uint8_t*)at(row, 0);
+	}
+
+	// Distance between rows in bytes
+	size_t GetRowPitch() const { return m_rowByteSize; }
+
+	// Largest difference of a channel, -1 if sizes or formats differ
+	int MaxDifference(const TextureImage& other) const
+	{
+		return max_difference(other);
+	}
+
+	// 0 - success, -1 - error
+	int WriteBmp(std::string filename) const
+	{
+		return write_bmp(filename.c_str());
+	}
+};
@@ -0,0 +1,251 @@
+/*****************************************************************//**
+ * \file   image_kernel.cpp
+ * \brief  Vectorised pixel format conversion of image rows
+ *
+ * Gray levels are computed in 16-bit integer lanes with the weights of
+ * image_luma, so every path rounds the same way. Conversions that only
+ * move bytes are bound by memory bandwidth and use 128-bit shuffles on
+ * all SIMD levels.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstring>
+
+#include "image_kernel.h"
+
+static void convert_scalar(const uint8_t* src, uint32_t src_bpp,
+    uint8_t* dst, uint32_t dst_bpp, uint32_t begin, uint32_t count)
+{
+    for (uint32_t i = begin; i < count; i++)
+    {
+        const uint8_t* in = src + (size_t)i * src_bpp;
+        uint8_t* out = dst + (size_t)i * dst_bpp;
+
+        const uint8_t b = in[0];
+        const uint8_t g = src_bpp == 1 ? in[0] : in[1];
+        const uint8_t r = src_bpp == 1 ? in[0] : in[2];
+
+        if (dst_bpp == 1)
+        {
+            out[0] = image_luma(b, g, r);
+            continue;
+        }
+
+        out[0] = b;
+        out[1] = g;
+        out[2] = r;
+        if (dst_bpp == 4) out[3] = src_bpp == 4 ? in[3] : 0xFF;
+    }
+}
+
+#if SIMD_X86
+
+// Spreads 4 pixels of 3 bytes to 32-bit lanes, the top byte is zero
+#define SHUFFLE_BGR_TO_BGRX 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+
+// Packs 4 pixels of 4 bytes to the low 12 bytes
+#define SHUFFLE_BGRX_TO_BGR 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+
+// Gray levels of 4 pixels in 32-bit lanes, from (b, g, r, x) lanes
+SIMD_TARGET_SSE41 static inline __m128i luma4(__m128i pixels)
+{
+    const __m128i lowBytes = _mm_set1_epi32(0x00FF00FF);
+    const __m128i weightsBR = _mm_set1_epi32((IMAGE_LUMA_R << 16) | IMAGE_LUMA_B);
+    const __m128i weightsG = _mm_set1_epi32(IMAGE_LUMA_G);
+
+    // (b, r) and (g, x) pairs of 16-bit lanes
+    const __m128i br = _mm_and_si128(pixels, lowBytes);
+    const __m128i gx = _mm_and_si128(_mm_srli_epi16(pixels, 8), lowBytes);
+
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(br, weightsBR), _mm_madd_epi16(gx, weightsG));
+    sum = _mm_add_epi32(sum, _mm_set1_epi32(128));
+    return _mm_srli_epi32(sum, 8);
+}
+
+// Colors of 3 or 4 bytes to gray levels, 16 pixels per step
+SIMD_TARGET_SSE41 static uint32_t to_gray_sse41(const uint8_t* src, uint32_t src_bpp,
+    uint8_t* dst, uint32_t count)
+{
+    const __m128i expand = _mm_setr_epi8(SHUFFLE_BGR_TO_BGRX);
+
+    // 16-byte loads of 3-byte pixels read 4 bytes past the last one
+    const uint32_t limit = src_bpp == 3 ? (count > 2 ? count - 2 : 0) : count;
+
+    uint32_t i = 0;
+    for (; i + 16 <= limit; i += 16)
+    {
+        __m128i y[4];
+        for (int k = 0; k < 4; k++)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(src + (size_t)(i + 4 * k) * src_bpp));
+            if (src_bpp == 3) pixels = _mm_shuffle_epi8(pixels, expand);
+            y[k] = luma4(pixels);
+        }
+
+        const __m128i packed = _mm_packus_epi16(_mm_packus_epi32(y[0], y[1]), _mm_packus_epi32(y[2], y[3]));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+    return i;
+}
+
+// Gray levels to colors of 3 or 4 bytes, 16 pixels per step
+SIMD_TARGET_SSE41 static uint32_t from_gray_sse41(const uint8_t* src,
+    uint8_t* dst, uint32_t dst_bpp, uint32_t count)
+{
+    const __m128i spread3[3] =
+    {
+        _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5),
+        _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10),
+        _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15)
+    };
+    const __m128i spread4[4] =
+    {
+        _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1),
+        _mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+        _mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+        _mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)
+    };
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i gray = _mm_loadu_si128((const __m128i*)(src + i));
+        uint8_t* out = dst + (size_t)i * dst_bpp;
+
+        if (dst_bpp == 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                _mm_storeu_si128((__m128i*)(out + 16 * k), _mm_shuffle_epi8(gray, spread3[k]));
+            }
+        }
+        else
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                _mm_storeu_si128((__m128i*)(out + 16 * k), _mm_or_si128(_mm_shuffle_epi8(gray, spread4[k]), alpha));
+            }
+        }
+    }
+    return i;
+}
+
+// Colors of 3 bytes to 4 and back, 16 pixels per step
+SIMD_TARGET_SSE41 static uint32_t repack_sse41(const uint8_t* src, uint32_t src_bpp,
+    uint8_t* dst, uint32_t dst_bpp, uint32_t count)
+{
+    const __m128i expand = _mm_setr_epi8(SHUFFLE_BGR_TO_BGRX);
+    const __m128i shrink = _mm_setr_epi8(SHUFFLE_BGRX_TO_BGR);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+    // 16-byte loads and stores of 3-byte pixels run 4 bytes past the last
+    // one, later stores overwrite the excess
+    const uint32_t limit = count > 2 ? count - 2 : 0;
+
+    uint32_t i = 0;
+    for (; i + 16 <= limit; i += 16)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            const uint32_t first = i + 4 * k;
+            const __m128i pixels = _mm_loadu_si128((const __m128i*)(src + (size_t)first * src_bpp));
+
+            const __m128i result = src_bpp == 3 ?
+                _mm_or_si128(_mm_shuffle_epi8(pixels, expand), alpha) :
+                _mm_shuffle_epi8(pixels, shrink);
+            _mm_storeu_si128((__m128i*)(dst + (size_t)first * dst_bpp), result);
+        }
+    }
+    return i;
+}
+
+// Colors of 3 or 4 bytes to gray levels, 32 pixels per step
+SIMD_TARGET_AVX2 static uint32_t to_gray_avx2(const uint8_t* src, uint32_t src_bpp,
+    uint8_t* dst, uint32_t count)
+{
+    const __m256i expand = _mm256_setr_epi8(SHUFFLE_BGR_TO_BGRX, SHUFFLE_BGR_TO_BGRX);
+    const __m256i lowBytes = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i weightsBR = _mm256_set1_epi32((IMAGE_LUMA_R << 16) | IMAGE_LUMA_B);
+    const __m256i weightsG = _mm256_set1_epi32(IMAGE_LUMA_G);
+    const __m256i round = _mm256_set1_epi32(128);
+
+    // Packing works inside 128-bit lanes, groups of 4 are put back in order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    const uint32_t limit = src_bpp == 3 ? (count > 2 ? count - 2 : 0) : count;
+
+    uint32_t i = 0;
+    for (; i + 32 <= limit; i += 32)
+    {
+        __m256i y[4];
+        for (int k = 0; k < 4; k++)
+        {
+            const uint8_t* in = src + (size_t)(i + 8 * k) * src_bpp;
+
+            __m256i pixels;
+            if (src_bpp == 3)
+            {
+                // 4 pixels per lane
+                pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)in)),
+                    _mm_loadu_si128((const __m128i*)(in + 12)), 1);
+                pixels = _mm256_shuffle_epi8(pixels, expand);
+            }
+            else
+            {
+                pixels = _mm256_loadu_si256((const __m256i*)in);
+            }
+
+            const __m256i br = _mm256_and_si256(pixels, lowBytes);
+            const __m256i gx = _mm256_and_si256(_mm256_srli_epi16(pixels, 8), lowBytes);
+
+            __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(br, weightsBR), _mm256_madd_epi16(gx, weightsG));
+            y[k] = _mm256_srli_epi32(_mm256_add_epi32(sum, round), 8);
+        }
+
+        __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(y[0], y[1]), _mm256_packus_epi32(y[2], y[3]));
+        packed = _mm256_permutevar8x32_epi32(packed, order);
+        _mm256_storeu_si256((__m256i*)(dst + i), packed);
+    }
+    return i;
+}
+
+#endif
+
+void convert_pixels(const uint8_t* src, IMAGE_COLOR_MODE src_mode,
+    uint8_t* dst, IMAGE_COLOR_MODE dst_mode, uint32_t count, SIMD_LEVEL level)
+{
+    const uint32_t srcBpp = (uint32_t)src_mode;
+    const uint32_t dstBpp = (uint32_t)dst_mode;
+
+    if (src_mode == dst_mode)
+    {
+        memcpy(dst, src, (size_t)count * srcBpp);
+        return;
+    }
+
+    uint32_t done = 0;
+
+#if SIMD_X86
+    if (dstBpp == 1 && level >= SIMD_LEVEL_AVX2)
+    {
+        done = to_gray_avx2(src, srcBpp, dst, count);
+    }
+    else if (dstBpp == 1 && level >= SIMD_LEVEL_SSE41)
+    {
+        done = to_gray_sse41(src, srcBpp, dst, count);
+    }
+    else if (srcBpp == 1 && level >= SIMD_LEVEL_SSE41)
+    {
+        done = from_gray_sse41(src, dst, dstBpp, count);
+    }
+    else if (level >= SIMD_LEVEL_SSE41)
+    {
+        done = repack_sse41(src, srcBpp, dst, dstBpp, count);
+    }
+#endif
+
+    // Remaining pixels
+    convert_scalar(src, srcBpp, dst, dstBpp, done, count);
+}
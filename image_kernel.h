@@ -0,0 +1,34 @@
+/*****************************************************************//**
+ * \file   image_kernel.h
+ * \brief  Vectorised pixel format conversion of image rows
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+
+#include "image_helper.h"
+#include "simd_util.h"
+
+// BT.601 luma weights in 8-bit fixed point, they add up to 256
+#define IMAGE_LUMA_B 29
+#define IMAGE_LUMA_G 150
+#define IMAGE_LUMA_R 77
+
+// Gray level of a color stored as in .bmp files, blue first
+inline uint8_t image_luma(uint8_t b, uint8_t g, uint8_t r)
+{
+	return (uint8_t)((b * IMAGE_LUMA_B + g * IMAGE_LUMA_G + r * IMAGE_LUMA_R + 128) >> 8);
+}
+
+/**
+ * Converts count pixels from src_mode to dst_mode. Colors become gray
+ * levels by image_luma, gray levels become colors with equal channels,
+ * added alpha is 255. src and dst must not overlap.
+ * All SIMD levels produce identical results.
+ */
+void convert_pixels(const uint8_t* src, IMAGE_COLOR_MODE src_mode,
+	uint8_t* dst, IMAGE_COLOR_MODE dst_mode, uint32_t count,
+	SIMD_LEVEL level = GetSimdLevel());
@@ -0,0 +1,800 @@
+/*****************************************************************//**
+ * \file   image_mip.cpp
+ * \brief  Definition of class mip_chain
+ *
+ * A level is filtered separably in floats. For a tile of the smaller
+ * level, every source row the tile reads is converted and filtered
+ * horizontally once, then the vertical taps combine those rows into
+ * the output rows. Both passes use the same tap order on every SIMD
+ * level, so results are bit-identical.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "image_mip.h"
+
+// Tiles claimed at once, scratch memory is allocated per claim
+#define MIP_TILE_GRAIN 4
+
+// How taps are combined
+#define MIP_REDUCE_SUM 0
+#define MIP_REDUCE_MIN 1
+#define MIP_REDUCE_MAX 2
+
+#define MIP_PI 3.14159265358979323846
+
+// Taps of one axis, every output pixel has the same number of taps
+struct mip_axis
+{
+    uint32_t taps = 0;
+    bool pairs = false;             // Output i reads inputs 2i and 2i + 1
+    std::vector<uint32_t> index;    // Input of tap k of output i at i * taps + k
+    std::vector<float> weight;
+
+    // Tap-major copies, tap k of output i at k * outputs + i, so the
+    // taps of neighbouring outputs load as a vector
+    uint32_t outputs = 0;
+    std::vector<uint32_t> tap_index;
+    std::vector<float> tap_weight;
+};
+
+// Modified Bessel function of the first kind, power series
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64 && term > sum * 1e-12; k++)
+    {
+        const double half = x / (2.0 * k);
+        term *= half * half;
+        sum += term;
+    }
+    return sum;
+}
+
+// Kaiser-windowed sinc, t in pixels of the smaller level
+static double kaiser(double t)
+{
+    const double u = t / MIP_KAISER_RADIUS;
+    if (u <= -1.0 || u >= 1.0) return 0.0;
+
+    const double window = bessel_i0(MIP_KAISER_ALPHA * sqrt(1.0 - u * u)) / bessel_i0(MIP_KAISER_ALPHA);
+    const double sinc = t == 0.0 ? 1.0 : sin(MIP_PI * t) / (MIP_PI * t);
+    return sinc * window;
+}
+
+static void build_taps(uint32_t src, uint32_t dst, MIP_FILTER filter, mip_axis& axis)
+{
+    axis.index.clear();
+    axis.weight.clear();
+    axis.pairs = false;
+
+    if (filter == MIP_FILTER_KAISER && src > 1)
+    {
+        const double scale = (double)src / dst;
+        const double support = MIP_KAISER_RADIUS * scale;
+        axis.taps = (uint32_t)ceil(2.0 * support) + 1;
+
+        std::vector<double> weights(axis.taps);
+        for (uint32_t i = 0; i < dst; i++)
+        {
+            const double center = (i + 0.5) * scale;
+            const int64_t first = (int64_t)floor(center - support);
+
+            double sum = 0.0;
+            for (uint32_t k = 0; k < axis.taps; k++)
+            {
+                weights[k] = kaiser((first + k + 0.5 - center) / scale);
+                sum += weights[k];
+            }
+
+            // Taps outside the image repeat the edge pixel
+            for (uint32_t k = 0; k < axis.taps; k++)
+            {
+                const int64_t x = (std::min)((std::max)(first + (int64_t)k, (int64_t)0), (int64_t)src - 1);
+                axis.index.push_back((uint32_t)x);
+                axis.weight.push_back((float)(weights[k] / sum));
+            }
+        }
+        return;
+    }
+
+    if (src == 1)
+    {
+        axis.taps = 1;
+        axis.index.push_back(0);
+        axis.weight.push_back(1.0f);
+    }
+    else if (src % 2 == 0)
+    {
+        axis.taps = 2;
+        axis.pairs = true;
+        for (uint32_t i = 0; i < dst; i++)
+        {
+            axis.index.push_back(2 * i);
+            axis.index.push_back(2 * i + 1);
+            axis.weight.push_back(0.5f);
+            axis.weight.push_back(0.5f);
+        }
+    }
+    else
+    {
+        // Output i covers src / dst inputs starting at i * src / dst,
+        // the outer two partially
+        axis.taps = 3;
+        for (uint32_t i = 0; i < dst; i++)
+        {
+            axis.index.push_back(2 * i);
+            axis.index.push_back(2 * i + 1);
+            axis.index.push_back(2 * i + 2);
+            axis.weight.push_back((float)(dst - i) / src);
+            axis.weight.push_back((float)dst / src);
+            axis.weight.push_back((float)(i + 1) / src);
+        }
+    }
+}
+
+static void build_axis(uint32_t src, uint32_t dst, MIP_FILTER filter, mip_axis& axis)
+{
+    build_taps(src, dst, filter, axis);
+
+    axis.outputs = dst;
+    axis.tap_index.resize(axis.index.size());
+    axis.tap_weight.resize(axis.weight.size());
+    for (uint32_t i = 0; i < dst; i++)
+    {
+        for (uint32_t k = 0; k < axis.taps; k++)
+        {
+            axis.tap_index[(size_t)k * dst + i] = axis.index[(size_t)i * axis.taps + k];
+            axis.tap_weight[(size_t)k * dst + i] = axis.weight[(size_t)i * axis.taps + k];
+        }
+    }
+}
+
+// Min and max match minps and maxps, also for equal values and NaNs
+template <int REDUCE>
+static inline float reduce_first(float w, float x)
+{
+    return REDUCE == MIP_REDUCE_SUM ? w * x : x;
+}
+
+template <int REDUCE>
+static inline float reduce_next(float acc, float w, float x)
+{
+    if (REDUCE == MIP_REDUCE_SUM) return acc + w * x;
+    if (REDUCE == MIP_REDUCE_MIN) return acc < x ? acc : x;
+    return acc > x ? acc : x;
+}
+
+template <int REDUCE>
+static void filter_row_scalar(const float* src, uint32_t base, const uint32_t* index, const float* weight,
+    uint32_t taps, uint32_t channels, uint32_t begin, uint32_t count, float* dst)
+{
+    for (uint32_t i = begin; i < count; i++)
+    {
+        const uint32_t* tapIndex = index + (size_t)i * taps;
+        const float* tapWeight = weight + (size_t)i * taps;
+
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            float acc = reduce_first<REDUCE>(tapWeight[0], src[(tapIndex[0] - base) * channels + c]);
+            for (uint32_t k = 1; k < taps; k++)
+            {
+                acc = reduce_next<REDUCE>(acc, tapWeight[k], src[(tapIndex[k] - base) * channels + c]);
+            }
+            dst[i * channels + c] = acc;
+        }
+    }
+}
+
+template <int REDUCE>
+static void combine_rows_scalar(const float* const* rows, const float* weight, uint32_t taps,
+    uint32_t begin, uint32_t count, float* dst)
+{
+    for (uint32_t x = begin; x < count; x++)
+    {
+        float acc = reduce_first<REDUCE>(weight[0], rows[0][x]);
+        for (uint32_t k = 1; k < taps; k++)
+        {
+            acc = reduce_next<REDUCE>(acc, weight[k], rows[k][x]);
+        }
+        dst[x] = acc;
+    }
+}
+
+static void to_float_scalar(const uint8_t* src, MIP_FORMAT format, uint32_t begin, uint32_t count, float* dst)
+{
+    for (uint32_t i = begin; i < count; i++)
+    {
+        if (format == MIP_FORMAT_UNORM8) dst[i] = (float)src[i];
+        else dst[i] = (float)((const uint16_t*)src)[i];
+    }
+}
+
+// Rounds to nearest even like cvtps2dq in the default rounding mode
+static void from_float_scalar(const float* src, MIP_FORMAT format, uint32_t begin, uint32_t count, uint8_t* dst)
+{
+    const float top = format == MIP_FORMAT_UNORM8 ? 255.0f : 65535.0f;
+
+    for (uint32_t i = begin; i < count; i++)
+    {
+        float v = src[i] > 0.0f ? src[i] : 0.0f;
+        v = v < top ? v : top;
+
+        const int rounded = (int)std::nearbyint(v);
+        if (format == MIP_FORMAT_UNORM8) dst[i] = (uint8_t)rounded;
+        else ((uint16_t*)dst)[i] = (uint16_t)rounded;
+    }
+}
+
+#if SIMD_X86
+
+template <int REDUCE>
+SIMD_TARGET_SSE41 static inline __m128 reduce_first_sse41(__m128 w, __m128 x)
+{
+    return REDUCE == MIP_REDUCE_SUM ? _mm_mul_ps(w, x) : x;
+}
+
+template <int REDUCE>
+SIMD_TARGET_SSE41 static inline __m128 reduce_next_sse41(__m128 acc, __m128 w, __m128 x)
+{
+    if (REDUCE == MIP_REDUCE_SUM) return _mm_add_ps(acc, _mm_mul_ps(w, x));
+    if (REDUCE == MIP_REDUCE_MIN) return _mm_min_ps(acc, x);
+    return _mm_max_ps(acc, x);
+}
+
+template <int REDUCE>
+SIMD_TARGET_AVX2 static inline __m256 reduce_first_avx2(__m256 w, __m256 x)
+{
+    return REDUCE == MIP_REDUCE_SUM ? _mm256_mul_ps(w, x) : x;
+}
+
+template <int REDUCE>
+SIMD_TARGET_AVX2 static inline __m256 reduce_next_avx2(__m256 acc, __m256 w, __m256 x)
+{
+    if (REDUCE == MIP_REDUCE_SUM) return _mm256_add_ps(acc, _mm256_mul_ps(w, x));
+    if (REDUCE == MIP_REDUCE_MIN) return _mm256_min_ps(acc, x);
+    return _mm256_max_ps(acc, x);
+}
+
+// Four channels, a pixel per register
+template <int REDUCE>
+SIMD_TARGET_SSE41 static uint32_t filter_row4_sse41(const float* src, uint32_t base, const uint32_t* index,
+    const float* weight, uint32_t taps, uint32_t count, float* dst)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t* tapIndex = index + (size_t)i * taps;
+        const float* tapWeight = weight + (size_t)i * taps;
+
+        __m128 acc = reduce_first_sse41<REDUCE>(_mm_set1_ps(tapWeight[0]), _mm_loadu_ps(src + (tapIndex[0] - base) * 4));
+        for (uint32_t k = 1; k < taps; k++)
+        {
+            acc = reduce_next_sse41<REDUCE>(acc, _mm_set1_ps(tapWeight[k]), _mm_loadu_ps(src + (tapIndex[k] - base) * 4));
+        }
+        _mm_storeu_ps(dst + i * 4, acc);
+    }
+    return count;
+}
+
+// One channel, output i from inputs 2i and 2i + 1, 4 outputs per step
+template <int REDUCE>
+SIMD_TARGET_SSE41 static uint32_t filter_pairs_sse41(const float* src, const float* weight,
+    uint32_t count, float* dst)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 a = _mm_loadu_ps(src + 2 * i);
+        const __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+        const __m128 wa = _mm_loadu_ps(weight + 2 * i);
+        const __m128 wb = _mm_loadu_ps(weight + 2 * i + 4);
+
+        const __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m128 wEven = _mm_shuffle_ps(wa, wb, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 wOdd = _mm_shuffle_ps(wa, wb, _MM_SHUFFLE(3, 1, 3, 1));
+
+        const __m128 acc = reduce_next_sse41<REDUCE>(reduce_first_sse41<REDUCE>(wEven, even), wOdd, odd);
+        _mm_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+
+// 8 outputs per step, shuffles work inside 128-bit lanes
+template <int REDUCE>
+SIMD_TARGET_AVX2 static uint32_t filter_pairs_avx2(const float* src, const float* weight,
+    uint32_t count, float* dst)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(src + 2 * i);
+        const __m256 b = _mm256_loadu_ps(src + 2 * i + 8);
+        const __m256 wa = _mm256_loadu_ps(weight + 2 * i);
+        const __m256 wb = _mm256_loadu_ps(weight + 2 * i + 8);
+
+        const __m256 even = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 odd = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 wEven = _mm256_shuffle_ps(wa, wb, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 wOdd = _mm256_shuffle_ps(wa, wb, _MM_SHUFFLE(3, 1, 3, 1));
+
+        // Outputs are in the order 0 1 4 5 2 3 6 7
+        const __m256 acc = reduce_next_avx2<REDUCE>(reduce_first_avx2<REDUCE>(wEven, even), wOdd, odd);
+        const __m256 ordered = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(acc), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(dst + i, ordered);
+    }
+    return i;
+}
+
+// One channel, any taps, 4 outputs per step from tap-major tables
+template <int REDUCE>
+SIMD_TARGET_SSE41 static uint32_t filter_gather_sse41(const float* src, uint32_t base, const uint32_t* index,
+    const float* weight, uint32_t stride, uint32_t taps, uint32_t count, float* dst)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 acc = _mm_setzero_ps();
+        for (uint32_t k = 0; k < taps; k++)
+        {
+            const uint32_t* tapIndex = index + (size_t)k * stride + i;
+            const __m128 x = _mm_setr_ps(src[tapIndex[0] - base], src[tapIndex[1] - base],
+                src[tapIndex[2] - base], src[tapIndex[3] - base]);
+            const __m128 w = _mm_loadu_ps(weight + (size_t)k * stride + i);
+
+            acc = k == 0 ? reduce_first_sse41<REDUCE>(w, x) : reduce_next_sse41<REDUCE>(acc, w, x);
+        }
+        _mm_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+
+template <int REDUCE>
+SIMD_TARGET_AVX2 static uint32_t filter_gather_avx2(const float* src, uint32_t base, const uint32_t* index,
+    const float* weight, uint32_t stride, uint32_t taps, uint32_t count, float* dst)
+{
+    const __m256i offset = _mm256_set1_epi32((int)base);
+
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        for (uint32_t k = 0; k < taps; k++)
+        {
+            const __m256i tapIndex = _mm256_loadu_si256((const __m256i*)(index + (size_t)k * stride + i));
+            const __m256 x = _mm256_i32gather_ps(src, _mm256_sub_epi32(tapIndex, offset), 4);
+            const __m256 w = _mm256_loadu_ps(weight + (size_t)k * stride + i);
+
+            acc = k == 0 ? reduce_first_avx2<REDUCE>(w, x) : reduce_next_avx2<REDUCE>(acc, w, x);
+        }
+        _mm256_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+
+template <int REDUCE>
+SIMD_TARGET_SSE41 static uint32_t combine_rows_sse41(const float* const* rows, const float* weight,
+    uint32_t taps, uint32_t count, float* dst)
+{
+    uint32_t x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+        __m128 acc = reduce_first_sse41<REDUCE>(_mm_set1_ps(weight[0]), _mm_loadu_ps(rows[0] + x));
+        for (uint32_t k = 1; k < taps; k++)
+        {
+            acc = reduce_next_sse41<REDUCE>(acc, _mm_set1_ps(weight[k]), _mm_loadu_ps(rows[k] + x));
+        }
+        _mm_storeu_ps(dst + x, acc);
+    }
+    return x;
+}
+
+template <int REDUCE>
+SIMD_TARGET_AVX2 static uint32_t combine_rows_avx2(const float* const* rows, const float* weight,
+    uint32_t taps, uint32_t count, float* dst)
+{
+    uint32_t x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        __m256 acc = reduce_first_avx2<REDUCE>(_mm256_set1_ps(weight[0]), _mm256_loadu_ps(rows[0] + x));
+        for (uint32_t k = 1; k < taps; k++)
+        {
+            acc = reduce_next_avx2<REDUCE>(acc, _mm256_set1_ps(weight[k]), _mm256_loadu_ps(rows[k] + x));
+        }
+        _mm256_storeu_ps(dst + x, acc);
+    }
+    return x;
+}
+
+// Conversions run once per row and are cheap next to the filters,
+// they use SSE4.1 on every SIMD level
+SIMD_TARGET_SSE41 static uint32_t to_float_sse41(const uint8_t* src, MIP_FORMAT format, uint32_t count, float* dst)
+{
+    uint32_t i = 0;
+    if (format == MIP_FORMAT_UNORM8)
+    {
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes)));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4))));
+            _mm_storeu_ps(dst + i + 8, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 8))));
+            _mm_storeu_ps(dst + i + 12, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(bytes, 12))));
+        }
+    }
+    else
+    {
+        const uint16_t* words = (const uint16_t*)src;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i values = _mm_loadu_si128((const __m128i*)(words + i));
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(values)));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(values, 8))));
+        }
+    }
+    return i;
+}
+
+SIMD_TARGET_SSE41 static uint32_t from_float_sse41(const float* src, MIP_FORMAT format, uint32_t count, uint8_t* dst)
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t i = 0;
+    if (format == MIP_FORMAT_UNORM8)
+    {
+        const __m128 top = _mm_set1_ps(255.0f);
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i v[4];
+            for (int k = 0; k < 4; k++)
+            {
+                const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4 * k), zero), top);
+                v[k] = _mm_cvtps_epi32(clamped);
+            }
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+            _mm_storeu_si128((__m128i*)(dst + i), packed);
+        }
+    }
+    else
+    {
+        const __m128 top = _mm_set1_ps(65535.0f);
+        uint16_t* words = (uint16_t*)dst;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m128i lo = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), zero), top));
+            const __m128i hi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), zero), top));
+            _mm_storeu_si128((__m128i*)(words + i), _mm_packus_epi32(lo, hi));
+        }
+    }
+    return i;
+}
+
+#endif
+
+template <int REDUCE>
+static void filter_row(const float* src, uint32_t base, const mip_axis& axis, uint32_t first, uint32_t count,
+    uint32_t channels, float* dst, SIMD_LEVEL level)
+{
+    const uint32_t* index = axis.index.data() + (size_t)first * axis.taps;
+    const float* weight = axis.weight.data() + (size_t)first * axis.taps;
+    uint32_t done = 0;
+
+#if SIMD_X86
+    if (channels == 4 && level >= SIMD_LEVEL_SSE41)
+    {
+        done = filter_row4_sse41<REDUCE>(src, base, index, weight, axis.taps, count, dst);
+    }
+    else if (channels == 1 && axis.pairs && level >= SIMD_LEVEL_AVX2)
+    {
+        done = filter_pairs_avx2<REDUCE>(src + (index[0] - base), weight, count, dst);
+    }
+    else if (channels == 1 && axis.pairs && level >= SIMD_LEVEL_SSE41)
+    {
+        done = filter_pairs_sse41<REDUCE>(src + (index[0] - base), weight, count, dst);
+    }
+    else if (channels == 1 && level >= SIMD_LEVEL_AVX2)
+    {
+        done = filter_gather_avx2<REDUCE>(src, base, axis.tap_index.data() + first,
+            axis.tap_weight.data() + first, axis.outputs, axis.taps, count, dst);
+    }
+    else if (channels == 1 && level >= SIMD_LEVEL_SSE41)
+    {
+        done = filter_gather_sse41<REDUCE>(src, base, axis.tap_index.data() + first,
+            axis.tap_weight.data() + first, axis.outputs, axis.taps, count, dst);
+    }
+#endif
+
+    filter_row_scalar<REDUCE>(src, base, index, weight, axis.taps, channels, done, count, dst);
+}
+
+template <int REDUCE>
+static void combine_rows(const float* const* rows, const float* weight, uint32_t taps,
+    uint32_t count, float* dst, SIMD_LEVEL level)
+{
+    uint32_t done = 0;
+
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_AVX2)
+    {
+        done = combine_rows_avx2<REDUCE>(rows, weight, taps, count, dst);
+    }
+    else if (level >= SIMD_LEVEL_SSE41)
+    {
+        done = combine_rows_sse41<REDUCE>(rows, weight, taps, count, dst);
+    }
+#endif
+
+    combine_rows_scalar<REDUCE>(rows, weight, taps, done, count, dst);
+}
+
+static void to_float(const uint8_t* src, MIP_FORMAT format, uint32_t count, float* dst, SIMD_LEVEL level)
+{
+    if (format == MIP_FORMAT_FLOAT)
+    {
+        memcpy(dst, src, (size_t)count * sizeof(float));
+        return;
+    }
+
+    uint32_t done = 0;
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_SSE41) done = to_float_sse41(src, format, count, dst);
+#endif
+    to_float_scalar(src, format, done, count, dst);
+}
+
+static void from_float(const float* src, MIP_FORMAT format, uint32_t count, uint8_t* dst, SIMD_LEVEL level)
+{
+    if (format == MIP_FORMAT_FLOAT)
+    {
+        memcpy(dst, src, (size_t)count * sizeof(float));
+        return;
+    }
+
+    uint32_t done = 0;
+#if SIMD_X86
+    if (level >= SIMD_LEVEL_SSE41) done = from_float_sse41(src, format, count, dst);
+#endif
+    from_float_scalar(src, format, done, count, dst);
+}
+
+// Filtering of one level, shared by its tiles
+struct mip_pass
+{
+    const mip_level* src = nullptr;
+    uint8_t* dst = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t dst_pitch = 0;
+    uint32_t channels = 0;
+    MIP_FORMAT format = MIP_FORMAT_UNORM8;
+    SIMD_LEVEL level = SIMD_LEVEL_SCALAR;
+
+    mip_axis cols;
+    mip_axis rows;
+};
+
+// Per-thread memory of filter_tile
+struct mip_scratch
+{
+    std::vector<float> line;            // Source pixels of a row
+    std::vector<float> band;            // Source rows filtered horizontally
+    std::vector<float> out;             // Output row
+    std::vector<const float*> taps;     // Band rows of the vertical taps
+};
+
+template <int REDUCE>
+static void filter_tile(const mip_pass& pass, uint32_t tile_row, uint32_t tile_col, mip_scratch& scratch)
+{
+    const uint32_t x0 = tile_col * MIP_TILE_COLS;
+    const uint32_t x1 = (std::min)(x0 + MIP_TILE_COLS, pass.width);
+    const uint32_t y0 = tile_row * MIP_TILE_ROWS;
+    const uint32_t y1 = (std::min)(y0 + MIP_TILE_ROWS, pass.height);
+
+    // Taps are in increasing order, the first and last bound the inputs
+    const uint32_t sx0 = pass.cols.index[(size_t)x0 * pass.cols.taps];
+    const uint32_t sx1 = pass.cols.index[(size_t)x1 * pass.cols.taps - 1] + 1;
+    const uint32_t sy0 = pass.rows.index[(size_t)y0 * pass.rows.taps];
+    const uint32_t sy1 = pass.rows.index[(size_t)y1 * pass.rows.taps - 1] + 1;
+
+    const uint32_t channels = pass.channels;
+    const uint32_t bytes = (uint32_t)pass.format;
+    const uint32_t outCount = (x1 - x0) * channels;
+
+    scratch.line.resize((size_t)(sx1 - sx0) * channels);
+    scratch.band.resize((size_t)(sy1 - sy0) * outCount);
+    scratch.out.resize(outCount);
+    scratch.taps.resize(pass.rows.taps);
+
+    for (uint32_t sy = sy0; sy < sy1; sy++)
+    {
+        const uint8_t* in = pass.src->data + sy * pass.src->row_pitch + (size_t)sx0 * channels * bytes;
+        to_float(in, pass.format, (sx1 - sx0) * channels, scratch.line.data(), pass.level);
+
+        filter_row<REDUCE>(scratch.line.data(), sx0, pass.cols, x0, x1 - x0, channels,
+            scratch.band.data() + (size_t)(sy - sy0) * outCount, pass.level);
+    }
+
+    for (uint32_t y = y0; y < y1; y++)
+    {
+        const uint32_t* index = pass.rows.index.data() + (size_t)y * pass.rows.taps;
+        for (uint32_t k = 0; k < pass.rows.taps; k++)
+        {
+            scratch.taps[k] = scratch.band.data() + (size_t)(index[k] - sy0) * outCount;
+        }
+
+        combine_rows<REDUCE>(scratch.taps.data(), pass.rows.weight.data() + (size_t)y * pass.rows.taps,
+            pass.rows.taps, outCount, scratch.out.data(), pass.level);
+
+        uint8_t* out = pass.dst + y * pass.dst_pitch + (size_t)x0 * channels * bytes;
+        from_float(scratch.out.data(), pass.format, outCount, out, pass.level);
+    }
+}
+
+template <int REDUCE>
+static void filter_tiles(const mip_pass& pass, uint32_t begin, uint32_t end)
+{
+    const uint32_t tileCols = (pass.width + MIP_TILE_COLS - 1) / MIP_TILE_COLS;
+
+    mip_scratch scratch;
+    for (uint32_t tile = begin; tile < end; tile++)
+    {
+        filter_tile<REDUCE>(pass, tile / tileCols, tile % tileCols, scratch);
+    }
+}
+
+/**
+ * Filters one mip level into the next.
+ *
+ * \param src larger level
+ * \param dst memory of the smaller level
+ * \param width width of the smaller level
+ * \param height height of the smaller level
+ * \param dst_pitch bytes between rows of dst
+ * \param channels channels of a pixel
+ * \param format format of a channel
+ * \param filter reduction filter
+ * \param pool workers to filter on, nullptr filters on the calling thread
+ * \param level instruction set of the inner loops
+ */
+void generate_mip_level(const mip_level& src, uint8_t* dst, uint32_t width, uint32_t height,
+    size_t dst_pitch, uint32_t channels, MIP_FORMAT format, MIP_FILTER filter,
+    WorkerPool* pool, SIMD_LEVEL level)
+{
+    mip_pass pass;
+    pass.src = &src;
+    pass.dst = dst;
+    pass.width = width;
+    pass.height = height;
+    pass.dst_pitch = dst_pitch;
+    pass.channels = channels;
+    pass.format = format;
+    pass.level = level;
+
+    build_axis(src.width, width, filter, pass.cols);
+    build_axis(src.height, height, filter, pass.rows);
+
+    const uint32_t tileCount = ((height + MIP_TILE_ROWS - 1) / MIP_TILE_ROWS) *
+        ((width + MIP_TILE_COLS - 1) / MIP_TILE_COLS);
+
+    auto filterTiles = [&](uint32_t begin, uint32_t end)
+    {
+        switch (filter)
+        {
+        case MIP_FILTER_MIN:
+            filter_tiles<MIP_REDUCE_MIN>(pass, begin, end);
+            break;
+        case MIP_FILTER_MAX:
+            filter_tiles<MIP_REDUCE_MAX>(pass, begin, end);
+            break;
+        default:
+            filter_tiles<MIP_REDUCE_SUM>(pass, begin, end);
+            break;
+        }
+    };
+
+    if (pool)
+    {
+        pool->ParallelFor(tileCount, MIP_TILE_GRAIN, filterTiles);
+    }
+    else
+    {
+        filterTiles(0, tileCount);
+    }
+}
+
+mip_chain::mip_chain()
+{
+}
+
+mip_chain::~mip_chain()
+{
+}
+
+/**
+ * Builds the mip levels of an image.
+ *
+ * \param src first row of the source
+ * \param width width of the source
+ * \param height height of the source
+ * \param row_pitch bytes between rows of the source
+ * \param channels channels of a pixel, 1 to 4
+ * \param format format of a channel
+ * \param filter reduction filter
+ * \param max_levels most levels including the source, 0 for the full chain
+ * \param pool workers to filter on, nullptr filters on the calling thread
+ * \return error code (0 - success, -1 - error)
+ */
+int mip_chain::generate(const void* src, uint32_t width, uint32_t height, size_t row_pitch,
+    uint32_t channels, MIP_FORMAT format, MIP_FILTER filter, uint32_t max_levels, WorkerPool* pool)
+{
+    clear();
+
+    const bool validFormat = format == MIP_FORMAT_UNORM8 || format == MIP_FORMAT_UNORM16 || format == MIP_FORMAT_FLOAT;
+    if (!src || width == 0 || height == 0 || channels == 0 || channels > 4 || !validFormat ||
+        row_pitch < (size_t)width * channels * (uint32_t)format)
+    {
+        fprintf(stderr, "Invalid source of mip levels\n");
+        return -1;
+    }
+
+    m_channels = channels;
+    m_format = format;
+
+    mip_level level0;
+    level0.data = (const uint8_t*)src;
+    level0.width = width;
+    level0.height = height;
+    level0.row_pitch = row_pitch;
+    m_levels.push_back(level0);
+
+    const SIMD_LEVEL simd = GetSimdLevel();
+
+    while ((max_levels == 0 || m_levels.size() < max_levels) &&
+        (m_levels.back().width > 1 || m_levels.back().height > 1))
+    {
+        const mip_level& prev = m_levels.back();
+
+        mip_level next;
+        next.width = (std::max)(prev.width / 2, 1u);
+        next.height = (std::max)(prev.height / 2, 1u);
+        next.row_pitch = ((size_t)next.width * channels * (uint32_t)format + 3) & ~(size_t)3;
+
+        const size_t size = next.row_pitch * next.height;
+        std::unique_ptr<uint8_t[]> memory(new (std::nothrow) uint8_t[size]);
+        if (!memory)
+        {
+            fprintf(stderr, "Failed to allocate %zu bytes\n", size);
+            clear();
+            return -1;
+        }
+
+        // Row padding is not written by the filter
+        for (uint32_t row = 0; row < next.height; row++)
+        {
+            const size_t rowBytes = (size_t)next.width * channels * (uint32_t)format;
+            memset(memory.get() + row * next.row_pitch + rowBytes, 0, next.row_pitch - rowBytes);
+        }
+
+        generate_mip_level(prev, memory.get(), next.width, next.height, next.row_pitch,
+            channels, format, filter, pool, simd);
+
+        next.data = memory.get();
+        m_memory.push_back(std::move(memory));
+        m_levels.push_back(next);
+    }
+
+    return 0;
+}
+
+void mip_chain::clear()
+{
+    m_levels.clear();
+    m_memory.clear();
+    m_channels = 0;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************//**
+ * \file   image_mip.h
+ * \brief  Declares class mip_chain
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "simd_util.h"
+#include "thread_pool.h"
+
+enum MIP_FILTER
+{
+	MIP_FILTER_BOX = 0,			// Average of the covered pixels
+	MIP_FILTER_KAISER = 1,		// Kaiser-windowed sinc, sharper than box
+	MIP_FILTER_MIN = 2,			// Smallest covered value, conservative lower bound
+	MIP_FILTER_MAX = 3			// Largest covered value, conservative upper bound
+};
+
+enum MIP_FORMAT
+{
+	MIP_FORMAT_UNORM8 = 1,		// uint8_t channels - 1 byte
+	MIP_FORMAT_UNORM16 = 2,		// uint16_t channels - 2 bytes
+	MIP_FORMAT_FLOAT = 4		// float channels - 4 bytes
+};
+
+// Kaiser filter radius in pixels of the smaller level and window shape
+#define MIP_KAISER_RADIUS 3.0f
+#define MIP_KAISER_ALPHA 4.0f
+
+// Pixels of the smaller level filtered by one work item
+#define MIP_TILE_ROWS 32
+#define MIP_TILE_COLS 128
+
+/**
+ * Pixels of one mip level, rows in the order of the source.
+ */
+struct mip_level
+{
+	const uint8_t* data = nullptr;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	size_t row_pitch = 0;			// Bytes between rows
+};
+
+/**
+ * Chain of mip levels, each half the size of the one before and at least
+ * a pixel. Odd sizes are reduced by three-pixel footprints weighted by
+ * coverage, so no source pixel is dropped and min/max levels stay
+ * conservative bounds of the pixels below them.
+ *
+ * Levels are filtered in tiles of MIP_TILE_ROWS x MIP_TILE_COLS pixels
+ * spread over the pool. All SIMD levels and thread counts produce
+ * identical results. Level 0 is the source, it must stay valid while
+ * the chain is used.
+ */
+class mip_chain
+{
+public:
+	mip_chain();
+	~mip_chain();
+
+	// Delete copy constructor
+	mip_chain(mip_chain& other) = delete;
+
+	/**
+	 * Builds levels below the source. max_levels limits the levels
+	 * including the source, 0 builds down to 1 x 1.
+	 * 0 - success, -1 - error
+	 */
+	int generate(const void* src, uint32_t width, uint32_t height, size_t row_pitch,
+		uint32_t channels, MIP_FORMAT format, MIP_FILTER filter,
+		uint32_t max_levels = 0, WorkerPool* pool = nullptr);
+
+	void clear();
+
+	uint32_t level_count() const { return (uint32_t)m_levels.size(); }
+	const mip_level& level(uint32_t mip) const { return m_levels[mip]; }
+
+	uint32_t channels() const { return m_channels; }
+	MIP_FORMAT format() const { return m_format; }
+
+private:
+	std::vector<mip_level> m_levels;
+	std::vector<std::unique_ptr<uint8_t[]>> m_memory;	// Levels below the source
+
+	uint32_t m_channels = 0;
+	MIP_FORMAT m_format = MIP_FORMAT_UNORM8;
+};
+
+/**
+ * Filters one level into the next, dst is width x height of the smaller
+ * level. Exposed to compare SIMD levels, mip_chain uses the best one.
+ */
+void generate_mip_level(const mip_level& src, uint8_t* dst, uint32_t width, uint32_t height,
+	size_t dst_pitch, uint32_t channels, MIP_FORMAT format, MIP_FILTER filter,
+	WorkerPool* pool = nullptr, SIMD_LEVEL level = GetSimdLevel());
@@ -0,0 +1,316 @@
+/*****************************************************************//**
+ * \file   image_stream.cpp
+ * \brief  Reading and writing .bmp files in bands of rows
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "image_stream.h"
+
+// Longest header parse_bmp_header reads before the palette: file header
+// and BITMAPV5HEADER
+#define BMP_MAX_HEADER_SIZE 0x8A
+
+// 64-bit file positions, long is 32-bit on Windows
+static int seek_file(FILE* file, uint64_t offset, int origin)
+{
+#ifdef _WIN32
+    return _fseeki64(file, (long long)offset, origin);
+#else
+    return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+static uint64_t tell_file(FILE* file)
+{
+#ifdef _WIN32
+    return (uint64_t)_ftelli64(file);
+#else
+    return (uint64_t)ftello(file);
+#endif
+}
+
+bmp_band_reader::bmp_band_reader()
+{
+}
+
+bmp_band_reader::~bmp_band_reader()
+{
+    close();
+}
+
+/**
+ * Opens a .bmp file and starts reading its first band.
+ *
+ * \param path path and/or file name
+ * \param band_rows rows read at once
+ * \return error code (0 - success, -1 - error)
+ */
+int bmp_band_reader::open(const char* path, uint32_t band_rows)
+{
+    close();
+
+    if (band_rows == 0)
+    {
+        fprintf(stderr, "Bands of %s must have rows\n", path);
+        return -1;
+    }
+
+    m_pFile = fopen(path, "rb");
+    if (!m_pFile)
+    {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return -1;
+    }
+
+    seek_file(m_pFile, 0, SEEK_END);
+    const uint64_t size = tell_file(m_pFile);
+    seek_file(m_pFile, 0, SEEK_SET);
+
+    // Headers and palette end where the pixel array starts
+    std::vector<uint8_t> header((size_t)(std::min)(size, (uint64_t)BMP_MAX_HEADER_SIZE));
+    uint32_t pixelOffset = 0;
+    if (header.size() >= 0xE && fread(header.data(), 1, header.size(), m_pFile) == header.size())
+    {
+        memcpy(&pixelOffset, header.data() + 0xA, 4);
+    }
+
+    if (pixelOffset > header.size() && pixelOffset <= size)
+    {
+        const size_t read = header.size();
+        header.resize(pixelOffset);
+        if (fread(header.data() + read, 1, pixelOffset - read, m_pFile) != pixelOffset - read) header.resize(read);
+    }
+
+    if (parse_bmp_header(path, header.data(), size, m_info) != 0 ||
+        seek_file(m_pFile, m_info.pixel_offset, SEEK_SET) != 0)
+    {
+        close();
+        return -1;
+    }
+
+    m_bandRows = (std::min)(band_rows, m_info.height);
+    m_bandCount = (m_info.height + m_bandRows - 1) / m_bandRows;
+    m_nextBand = 0;
+    m_failed = false;
+
+    const size_t bandBytes = (size_t)(m_info.row_pitch * m_bandRows);
+    for (std::unique_ptr<uint8_t[]>& buffer : m_buffers)
+    {
+        buffer.reset(new (std::nothrow) uint8_t[bandBytes]);
+        if (!buffer)
+        {
+            fprintf(stderr, "Failed to allocate %zu bytes\n", bandBytes);
+            close();
+            return -1;
+        }
+    }
+
+    start_read(0);
+    return 0;
+}
+
+void bmp_band_reader::close()
+{
+    if (m_pending.valid()) m_pending.wait();
+    m_pending = std::future<bool>();
+
+    if (m_pFile) fclose(m_pFile);
+    m_pFile = nullptr;
+
+    m_buffers[0].reset();
+    m_buffers[1].reset();
+    m_bandCount = m_nextBand = 0;
+}
+
+void bmp_band_reader::band_rows(uint32_t band, uint32_t& first_row, uint32_t& rows) const
+{
+    const uint32_t fileRow = band * m_bandRows;
+    rows = (std::min)(m_bandRows, m_info.height - fileRow);
+    first_row = m_info.top_down ? m_info.height - fileRow - rows : fileRow;
+}
+
+void bmp_band_reader::start_read(uint32_t band)
+{
+    uint32_t firstRow, rows;
+    band_rows(band, firstRow, rows);
+
+    FILE* file = m_pFile;
+    uint8_t* dst = m_buffers[1].get();
+    const size_t pitch = (size_t)m_info.row_pitch;
+    const bool flip = m_info.top_down;
+
+    // Bands are read one after another, so the file position is
+    // always at the start of the band
+    m_pending = std::async(std::launch::async, [=]()
+    {
+        if (fread(dst, pitch, rows, file) != rows) return false;
+
+        if (flip)
+        {
+            for (uint32_t r = 0; r < rows / 2; r++)
+            {
+                std::swap_ranges(dst + r * pitch, dst + (r + 1) * pitch, dst + (rows - 1 - r) * pitch);
+            }
+        }
+        return true;
+    });
+}
+
+const uint8_t* bmp_band_reader::next_band(uint32_t& first_row, uint32_t& rows)
+{
+    if (m_failed || m_nextBand >= m_bandCount) return nullptr;
+
+    if (!m_pending.get())
+    {
+        fprintf(stderr, "Failed to read rows of band %u\n", m_nextBand);
+        m_failed = true;
+        return nullptr;
+    }
+
+    band_rows(m_nextBand, first_row, rows);
+    std::swap(m_buffers[0], m_buffers[1]);
+
+    m_nextBand++;
+    if (m_nextBand < m_bandCount) start_read(m_nextBand);
+
+    return m_buffers[0].get();
+}
+
+bmp_band_writer::bmp_band_writer()
+{
+}
+
+bmp_band_writer::~bmp_band_writer()
+{
+    close();
+}
+
+/**
+ * Creates a .bmp file and writes its header.
+ *
+ * \param path path and/or file name
+ * \param width width of the image
+ * \param height height of the image
+ * \param mode color mode of the image
+ * \param band_rows rows written at once
+ * \return error code (0 - success, -1 - error)
+ */
+int bmp_band_writer::open(const char* path, uint32_t width, uint32_t height,
+    IMAGE_COLOR_MODE mode, uint32_t band_rows)
+{
+    close();
+
+    if (band_rows == 0 || width == 0 || height == 0)
+    {
+        fprintf(stderr, "Invalid size of %s\n", path);
+        return -1;
+    }
+
+    m_pFile = fopen(path, "wb");
+    if (!m_pFile)
+    {
+        fprintf(stderr, "Failed to create %s\n", path);
+        return -1;
+    }
+
+    std::vector<uint8_t> header(bmp_header_size(mode));
+    fill_bmp_header(header.data(), width, height, mode);
+
+    if (fwrite(header.data(), 1, header.size(), m_pFile) != header.size())
+    {
+        fprintf(stderr, "Failed to write %s\n", path);
+        close();
+        return -1;
+    }
+
+    m_height = height;
+    m_rowBytes = width * (uint32_t)mode;
+    m_rowPitch = ((uint64_t)m_rowBytes + 3) & ~3ull;
+    m_bandRows = (std::min)(band_rows, height);
+    m_nextRow = 0;
+    m_failed = false;
+
+    const size_t bandBytes = (size_t)(m_rowPitch * m_bandRows);
+    for (std::unique_ptr<uint8_t[]>& buffer : m_buffers)
+    {
+        buffer.reset(new (std::nothrow) uint8_t[bandBytes]());
+        if (!buffer)
+        {
+            fprintf(stderr, "Failed to allocate %zu bytes\n", bandBytes);
+            close();
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int bmp_band_writer::close()
+{
+    if (!m_pFile) return m_failed ? -1 : 0;
+
+    if (m_pending.valid() && !m_pending.get()) m_failed = true;
+
+    if (m_nextRow < m_height)
+    {
+        fprintf(stderr, "Only %u of %u rows were written\n", m_nextRow, m_height);
+        m_failed = true;
+    }
+
+    if (fclose(m_pFile) != 0) m_failed = true;
+    m_pFile = nullptr;
+
+    m_buffers[0].reset();
+    m_buffers[1].reset();
+    m_height = m_nextRow = 0;
+
+    return m_failed ? -1 : 0;
+}
+
+uint8_t* bmp_band_writer::band(uint32_t& first_row, uint32_t& rows)
+{
+    if (!m_pFile || m_nextRow >= m_height) return nullptr;
+
+    first_row = m_nextRow;
+    rows = (std::min)(m_bandRows, m_height - m_nextRow);
+    return m_buffers[0].get();
+}
+
+int bmp_band_writer::commit_band()
+{
+    if (!m_pFile || m_nextRow >= m_height) return -1;
+
+    // The other buffer is free once its write is done
+    if (m_pending.valid() && !m_pending.get())
+    {
+        fprintf(stderr, "Failed to write rows below %u\n", m_nextRow);
+        m_failed = true;
+    }
+    if (m_failed) return -1;
+
+    const uint32_t rows = (std::min)(m_bandRows, m_height - m_nextRow);
+    std::swap(m_buffers[0], m_buffers[1]);
+
+    FILE* file = m_pFile;
+    uint8_t* src = m_buffers[1].get();
+    const size_t pitch = (size_t)m_rowPitch;
+    const size_t rowBytes = m_rowBytes;
+
+    m_pending = std::async(std::launch::async, [=]()
+    {
+        // Rows may have been filled whole, padding must be zero
+        for (uint32_t r = 0; pitch > rowBytes && r < rows; r++)
+        {
+            memset(src + r * pitch + rowBytes, 0, pitch - rowBytes);
+        }
+        return fwrite(src, pitch, rows, file) == rows;
+    });
+
+    m_nextRow += rows;
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*****************************************************************//**
+ * \file   image_stream.h
+ * \brief  Reading and writing .bmp files in bands of rows
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <memory>
+
+#include "image_helper.h"
+
+/**
+ * Reads the pixel array of a .bmp file in bands of rows, so memory use is
+ * two bands whatever the image size. The next band is read on a background
+ * thread while the current one is processed.
+ *
+ * Bands come in file order. Rows inside a band are always bottom to top,
+ * like in image_base, so bands of top-down files start at the top of the
+ * image. Pixels are as stored in the file, palettes are not resolved.
+ */
+class bmp_band_reader
+{
+public:
+	bmp_band_reader();
+	~bmp_band_reader();
+
+	// Delete copy constructor
+	bmp_band_reader(bmp_band_reader& other) = delete;
+
+	int open(const char* path, uint32_t band_rows);	// 0 - success, -1 - error
+	void close();
+
+	// Waits for the next band and starts reading the one after it. Rows
+	// [first_row, first_row + rows) of row_pitch() bytes each, valid until
+	// the next call. nullptr after the last band or when a read failed.
+	const uint8_t* next_band(uint32_t& first_row, uint32_t& rows);
+
+	const bmp_info& info() const { return m_info; }
+	uint64_t row_pitch() const { return m_info.row_pitch; }
+	bool failed() const { return m_failed; }
+
+private:
+	// Rows of the band in image numbering
+	void band_rows(uint32_t band, uint32_t& first_row, uint32_t& rows) const;
+	void start_read(uint32_t band);
+
+	FILE* m_pFile = nullptr;
+	bmp_info m_info;
+
+	uint32_t m_bandRows = 0;
+	uint32_t m_bandCount = 0;
+	uint32_t m_nextBand = 0;						// Band returned by the next next_band
+
+	std::unique_ptr<uint8_t[]> m_buffers[2];		// Returned band, band being read
+	std::future<bool> m_pending;
+	bool m_failed = false;
+};
+
+/**
+ * Writes a bottom-up .bmp file in bands of rows, from the bottom. A filled
+ * band is written on a background thread while the next one is filled.
+ */
+class bmp_band_writer
+{
+public:
+	bmp_band_writer();
+	~bmp_band_writer();
+
+	// Delete copy constructor
+	bmp_band_writer(bmp_band_writer& other) = delete;
+
+	// Writes the header, 0 - success, -1 - error
+	int open(const char* path, uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode, uint32_t band_rows);
+
+	// Waits for pending writes, 0 - success, -1 - a write failed or rows are missing
+	int close();
+
+	// Memory of the next band to fill, rows [first_row, first_row + rows)
+	// of row_pitch() bytes each. nullptr when all rows are committed.
+	uint8_t* band(uint32_t& first_row, uint32_t& rows);
+
+	// Starts writing the band, waits for the write of the band before.
+	// 0 - success, -1 - error
+	int commit_band();
+
+	uint64_t row_pitch() const { return m_rowPitch; }
+
+private:
+	FILE* m_pFile = nullptr;
+
+	uint32_t m_height = 0;
+	uint32_t m_rowBytes = 0;						// Pixels without padding
+	uint64_t m_rowPitch = 0;
+
+	uint32_t m_bandRows = 0;
+	uint32_t m_nextRow = 0;							// First row of the band being filled
+
+	std::unique_ptr<uint8_t[]> m_buffers[2];		// Band being filled, band being written
+	std::future<bool> m_pending;
+	bool m_failed = false;
+};
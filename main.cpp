@@ -14,6 +14,61 @@
 #include "d3dUtil.h"
 #include "d3dapp.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Reads the terrain options, e.g. "-lod", "-rtin 0.05", "-stream big.bmp"
+// or "-generate 7 4096". Unknown arguments are ignored
+static TerrainOptions ParseTerrainOptions(const char* pCmdLine)
+{
+	TerrainOptions options;
+	if (pCmdLine == nullptr) return options;
+
+	std::vector<std::string> args;
+	std::istringstream stream(pCmdLine);
+	for (std::string arg; stream >> arg; )
+	{
+		args.push_back(arg);
+	}
+
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (args[i] == "-lod")
+		{
+			options.Mode = TERRAIN_RENDER_LOD;
+		}
+		else if (args[i] == "-rtin" && i + 1 < args.size())
+		{
+			options.Mode = TERRAIN_RENDER_RTIN;
+			options.RtinMaxError = strtof(args[++i].c_str(), nullptr);
+		}
+		else if (args[i] == "-stream" && i + 1 < args.size())
+		{
+			options.Mode = TERRAIN_RENDER_STREAM;
+			options.StreamFile = args[++i];
+		}
+		else if (args[i] == "-generate" && i + 1 < args.size())
+		{
+			options.GenerateSeed = strtoul(args[++i].c_str(), nullptr, 10);
+			options.GenerateSize = 1024;
+
+			// Size is optional
+			if (i + 1 < args.size() && args[i + 1][0] != '-')
+			{
+				options.GenerateSize = strtoul(args[++i].c_str(), nullptr, 10);
+			}
+
+			options.GenerateSize = (std::max)((UINT)TERRAIN_GENERATE_MIN_SIZE,
+				(std::min)(options.GenerateSize, (UINT)TERRAIN_GENERATE_MAX_SIZE));
+		}
+	}
+
+	return options;
+}
+
 // Entry point to the app
 int WINAPI WinMain(_In_ HINSTANCE hInstance,// Handle to app in Windows
 	_In_opt_ HINSTANCE hPrevInstance,		// Not used
@@ -23,7 +78,7 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance,// Handle to app in Windows
 	D3DWindow window = { hInstance };
 	window.Initialize();
 
-	D3DApplication app;
+	D3DApplication app(ParseTerrainOptions(pCmdLine));
 	app.Initialize(window.GetWindowHandle());
 
 	window.ShowD3DWindow(nCmdShow, &app);
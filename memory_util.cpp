@@ -5,8 +5,18 @@
  * \author Mikalai Varapai
  * \date   May 2024
  *********************************************************************/
+#include <cstdio>
 #include <memory>
 
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "memory_util.h"
 
 /**
@@ -45,3 +55,128 @@ void generic_data::write32(uint64_t offset, uint32_t val)
 	uint32_t* addr = (uint32_t*)((uint64_t)m_baseAddress + offset);
 	*addr = val;
 }
+
+mapped_file::mapped_file()
+{
+}
+
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+/**
+ * Map the file for reading. Previously mapped file is closed.
+ *
+ * \param path path and/or file name
+ * \param copy_on_write pages can be written, changes stay in memory
+ * \return error code (0 - success, -1 - error)
+ */
+int mapped_file::open(const char* path, bool copy_on_write)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		fprintf(stderr, "Failed to open %s\n", path);
+		return -1;
+	}
+	m_hFile = hFile;
+
+	LARGE_INTEGER fileSize = { };
+	GetFileSizeEx(hFile, &fileSize);
+	m_size = (uint64_t)fileSize.QuadPart;
+
+	if (m_size == 0)
+	{
+		fprintf(stderr, "File %s is empty\n", path);
+		close();
+		return -1;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr,
+		copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+	if (!hMapping)
+	{
+		fprintf(stderr, "Failed to create mapping of %s\n", path);
+		close();
+		return -1;
+	}
+	m_hMapping = hMapping;
+
+	m_pData = (uint8_t*)MapViewOfFile(hMapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+#else
+	m_fd = ::open(path, O_RDONLY);
+	if (m_fd < 0)
+	{
+		fprintf(stderr, "Failed to open %s\n", path);
+		return -1;
+	}
+
+	struct stat info = { };
+	fstat(m_fd, &info);
+	m_size = (uint64_t)info.st_size;
+
+	if (m_size == 0)
+	{
+		fprintf(stderr, "File %s is empty\n", path);
+		close();
+		return -1;
+	}
+
+	void* pData = copy_on_write ?
+		mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_fd, 0) :
+		mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+	m_pData = pData == MAP_FAILED ? nullptr : (uint8_t*)pData;
+#endif
+
+	if (!m_pData)
+	{
+		fprintf(stderr, "Failed to map %llu bytes of %s\n", (unsigned long long)m_size, path);
+		close();
+		return -1;
+	}
+
+	m_copyOnWrite = copy_on_write;
+	return 0;
+}
+
+void mapped_file::close()
+{
+#ifdef _WIN32
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile) CloseHandle(m_hFile);
+
+	m_hMapping = nullptr;
+	m_hFile = nullptr;
+#else
+	if (m_pData) munmap((void*)m_pData, m_size);
+	if (m_fd >= 0) ::close(m_fd);
+
+	m_fd = -1;
+#endif
+
+	m_pData = nullptr;
+	m_size = 0u;
+	m_copyOnWrite = false;
+}
+
+void mapped_file::release(uint64_t offset, uint64_t size)
+{
+	if (!m_pData || m_copyOnWrite || offset >= m_size) return;
+	if (size > m_size - offset) size = m_size - offset;
+
+#ifdef _WIN32
+	// Unlocking pages that are not locked removes them from the working set
+	VirtualUnlock((void*)(m_pData + offset), (SIZE_T)size);
+#else
+	// madvise needs a page aligned address
+	uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t begin = offset & ~(pageSize - 1);
+	madvise((void*)(m_pData + begin), (size_t)(offset + size - begin), MADV_DONTNEED);
+#endif
+}
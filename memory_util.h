@@ -34,3 +34,45 @@ private:
 	uint32_t m_size = 0u;							// Binary size
 	void* m_baseAddress = nullptr;					// Either allocated by class or user
 };
+
+/**
+ * Read-only mapping of a whole file. Pages are loaded by the OS on first access,
+ * so files larger than physical memory can be used.
+ *
+ * A copy-on-write mapping can also be written to. Written pages are copied
+ * privately and never reach the file.
+ */
+class mapped_file
+{
+public:
+	mapped_file();
+	~mapped_file();
+
+	// Delete copy constructor
+	mapped_file(mapped_file& other) = delete;
+
+	int open(const char* path, bool copy_on_write = false);	// 0 - success, -1 - error
+	void close();
+
+	// Removes pages of the range from the working set. The data stays
+	// in the OS file cache and is mapped again on next access. Does
+	// nothing for copy-on-write mappings, as written pages would be lost.
+	void release(uint64_t offset, uint64_t size);
+
+	const uint8_t* data() const { return m_pData; }
+	uint8_t* writable_data() const { return m_copyOnWrite ? m_pData : nullptr; }
+	uint64_t size() const { return m_size; }
+	bool is_open() const { return m_pData != nullptr; }
+
+private:
+	uint8_t* m_pData = nullptr;						// Start of the mapping
+	uint64_t m_size = 0u;							// File size
+	bool m_copyOnWrite = false;
+
+#ifdef _WIN32
+	void* m_hFile = nullptr;
+	void* m_hMapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
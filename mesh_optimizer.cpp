@@ -0,0 +1,254 @@
+/*****************************************************************//**
+ * \file   mesh_optimizer.cpp
+ * \brief  Index and vertex reordering for the post-transform vertex
+ *         cache and vertex fetch
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "mesh_optimizer.h"
+
+// Forsyth score parameters
+#define VERTEX_CACHE_DECAY_POWER 1.5f
+#define VERTEX_CACHE_LAST_TRIANGLE_SCORE 0.75f
+#define VERTEX_VALENCE_BOOST_SCALE 2.0f
+#define VERTEX_VALENCE_BOOST_POWER 0.5f
+
+// Valences above this share the last score
+#define VERTEX_VALENCE_TABLE_SIZE 32
+
+struct vertex_score_tables
+{
+	float Cache[VERTEX_CACHE_OPTIMIZER_SIZE];
+	float Valence[VERTEX_VALENCE_TABLE_SIZE];
+
+	vertex_score_tables()
+	{
+		for (int pos = 0; pos < VERTEX_CACHE_OPTIMIZER_SIZE; pos++)
+		{
+			// Vertices of the last triangle get a fixed score, so that
+			// the next triangle does not simply reuse its edge
+			if (pos < 3)
+			{
+				Cache[pos] = VERTEX_CACHE_LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scaler = 1.0f / (VERTEX_CACHE_OPTIMIZER_SIZE - 3);
+				Cache[pos] = std::pow(1.0f - (pos - 3) * scaler, VERTEX_CACHE_DECAY_POWER);
+			}
+		}
+
+		// Boost vertices with few triangles left, to finish them off
+		Valence[0] = 0.0f;
+		for (int valence = 1; valence < VERTEX_VALENCE_TABLE_SIZE; valence++)
+		{
+			Valence[valence] = VERTEX_VALENCE_BOOST_SCALE *
+				std::pow((float)valence, -VERTEX_VALENCE_BOOST_POWER);
+		}
+	}
+};
+
+static const vertex_score_tables& GetScoreTables()
+{
+	static vertex_score_tables tables;
+	return tables;
+}
+
+template<typename TIndex>
+VertexCacheStats AnalyzeVertexCache(const TIndex* pIndices, size_t indexCount,
+	size_t vertexCount, uint32_t cacheSize)
+{
+	VertexCacheStats stats;
+	stats.Triangles = indexCount / 3;
+
+	// A vertex is cached while fewer than cacheSize vertices entered after it
+	std::vector<size_t> entered(vertexCount, SIZE_MAX);
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		TIndex v = pIndices[i];
+
+		if (entered[v] == SIZE_MAX) stats.Vertices++;
+
+		// Transforms - entered[v] - 1 vertices entered after v
+		if (entered[v] == SIZE_MAX || stats.Transforms - entered[v] > cacheSize)
+		{
+			entered[v] = stats.Transforms++;
+		}
+	}
+
+	if (stats.Triangles) stats.ACMR = (float)stats.Transforms / stats.Triangles;
+	if (stats.Vertices) stats.ATVR = (float)stats.Transforms / stats.Vertices;
+
+	return stats;
+}
+
+template<typename TIndex>
+void OptimizeVertexCache(TIndex* pIndices, size_t indexCount, size_t vertexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) return;
+
+	const vertex_score_tables& tables = GetScoreTables();
+
+	// Triangles of every vertex. The first liveCount entries of each
+	// list are the triangles not emitted yet
+	std::vector<uint32_t> liveCount(vertexCount, 0);
+	std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+	std::vector<uint32_t> triangles(indexCount);
+
+	for (size_t i = 0; i < indexCount; i++) liveCount[pIndices[i]]++;
+	for (size_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] = firstTriangle[v] + liveCount[v];
+	{
+		std::vector<uint32_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			triangles[cursor[pIndices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+
+	auto vertexScore = [&](size_t v)
+	{
+		uint32_t live = liveCount[v];
+		if (live == 0) return -1.0f;
+
+		float score = cachePosition[v] >= 0 ? tables.Cache[cachePosition[v]] : 0.0f;
+		return score + tables.Valence[(std::min)(live, (uint32_t)VERTEX_VALENCE_TABLE_SIZE - 1)];
+	};
+
+	for (size_t v = 0; v < vertexCount; v++) vertexScores[v] = vertexScore(v);
+
+	size_t bestTriangle = 0;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		float score = vertexScores[pIndices[3 * t]] +
+			vertexScores[pIndices[3 * t + 1]] + vertexScores[pIndices[3 * t + 2]];
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestTriangle = t;
+		}
+	}
+
+	// Cache holds three more entries while the new triangle is inserted
+	uint32_t cache[VERTEX_CACHE_OPTIMIZER_SIZE + 3];
+	uint32_t newCache[VERTEX_CACHE_OPTIMIZER_SIZE + 3];
+	uint32_t cacheSize = 0;
+
+	std::vector<TIndex> output(triangleCount * 3);
+	size_t nextUnemitted = 0;
+
+	for (size_t out = 0; out < triangleCount; out++)
+	{
+		// No candidate in the cache, continue with the first triangle left
+		if (bestTriangle == SIZE_MAX)
+		{
+			while (emitted[nextUnemitted]) nextUnemitted++;
+			bestTriangle = nextUnemitted;
+		}
+
+		const TIndex* pTriangle = &pIndices[3 * bestTriangle];
+		memcpy(&output[3 * out], pTriangle, 3 * sizeof(TIndex));
+		emitted[bestTriangle] = 1;
+
+		// Remove the triangle from the live lists of its vertices
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = pTriangle[k];
+			uint32_t* pList = &triangles[firstTriangle[v]];
+			uint32_t live = liveCount[v];
+
+			for (uint32_t j = 0; j < live; j++)
+			{
+				if (pList[j] == bestTriangle)
+				{
+					pList[j] = pList[live - 1];
+					pList[live - 1] = static_cast<uint32_t>(bestTriangle);
+					break;
+				}
+			}
+			liveCount[v]--;
+		}
+
+		// Move the triangle to the front of the LRU cache
+		uint32_t newSize = 0;
+		for (int k = 0; k < 3; k++) newCache[newSize++] = pTriangle[k];
+		for (uint32_t j = 0; j < cacheSize; j++)
+		{
+			uint32_t v = cache[j];
+			if (v != pTriangle[0] && v != pTriangle[1] && v != pTriangle[2]) newCache[newSize++] = v;
+		}
+
+		// Rescore the cached vertices, evicted ones lose their cache score
+		for (uint32_t j = 0; j < newSize; j++)
+		{
+			uint32_t v = newCache[j];
+			cachePosition[v] = j < VERTEX_CACHE_OPTIMIZER_SIZE ? (int32_t)j : -1;
+			vertexScores[v] = vertexScore(v);
+		}
+
+		// Rescore live triangles around the cache and pick the best
+		bestTriangle = SIZE_MAX;
+		bestScore = -1.0f;
+
+		for (uint32_t j = 0; j < newSize; j++)
+		{
+			uint32_t v = newCache[j];
+			const uint32_t* pList = &triangles[firstTriangle[v]];
+
+			for (uint32_t k = 0; k < liveCount[v]; k++)
+			{
+				uint32_t t = pList[k];
+				float score = vertexScores[pIndices[3 * t]] +
+					vertexScores[pIndices[3 * t + 1]] + vertexScores[pIndices[3 * t + 2]];
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheSize = (std::min)(newSize, (uint32_t)VERTEX_CACHE_OPTIMIZER_SIZE);
+		memcpy(cache, newCache, cacheSize * sizeof(uint32_t));
+	}
+
+	memcpy(pIndices, output.data(), output.size() * sizeof(TIndex));
+}
+
+template<typename TIndex>
+void BuildVertexFetchRemap(const TIndex* pIndices, size_t indexCount,
+	size_t vertexCount, std::vector<uint32_t>& remap)
+{
+	remap.assign(vertexCount, UINT32_MAX);
+	uint32_t next = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		if (remap[pIndices[i]] == UINT32_MAX) remap[pIndices[i]] = next++;
+	}
+
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == UINT32_MAX) remap[v] = next++;
+	}
+}
+
+template VertexCacheStats AnalyzeVertexCache(const uint16_t*, size_t, size_t, uint32_t);
+template VertexCacheStats AnalyzeVertexCache(const uint32_t*, size_t, size_t, uint32_t);
+template void OptimizeVertexCache(uint16_t*, size_t, size_t);
+template void OptimizeVertexCache(uint32_t*, size_t, size_t);
+template void BuildVertexFetchRemap(const uint16_t*, size_t, size_t, std::vector<uint32_t>&);
+template void BuildVertexFetchRemap(const uint32_t*, size_t, size_t, std::vector<uint32_t>&);
@@ -0,0 +1,75 @@
+/*****************************************************************//**
+ * \file   mesh_optimizer.h
+ * \brief  Index and vertex reordering for the post-transform vertex
+ *         cache and vertex fetch
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Size of the LRU cache modelled by OptimizeVertexCache
+#define VERTEX_CACHE_OPTIMIZER_SIZE 32
+
+// Size of the FIFO cache simulated by AnalyzeVertexCache
+#define VERTEX_CACHE_ANALYZER_SIZE 16
+
+struct VertexCacheStats
+{
+	size_t Triangles = 0;
+	size_t Transforms = 0;		// Vertex shader invocations
+	size_t Vertices = 0;		// Referenced vertices
+	float ACMR = 0.0f;			// Transforms per triangle, 0.5 is the ideal for grids
+	float ATVR = 0.0f;			// Transforms per referenced vertex, 1.0 is the ideal
+};
+
+// Simulates a FIFO post-transform cache of cacheSize entries
+template<typename TIndex>
+VertexCacheStats AnalyzeVertexCache(const TIndex* pIndices, size_t indexCount,
+	size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_ANALYZER_SIZE);
+
+// Reorders triangles in place for the post-transform cache (Forsyth,
+// linear-speed vertex cache optimisation). Triangle winding is kept.
+template<typename TIndex>
+void OptimizeVertexCache(TIndex* pIndices, size_t indexCount, size_t vertexCount);
+
+// Computes new vertex positions in order of first use by the indices.
+// Unreferenced vertices keep their relative order after the used ones.
+template<typename TIndex>
+void BuildVertexFetchRemap(const TIndex* pIndices, size_t indexCount,
+	size_t vertexCount, std::vector<uint32_t>& remap);
+
+// Reorders vertices in order of first use and rewrites the indices,
+// so that vertex fetch walks memory forwards. remap receives the new
+// position of every vertex.
+template<typename T, typename TIndex>
+void OptimizeVertexFetch(T* pVertices, size_t vertexCount, TIndex* pIndices, size_t indexCount,
+	std::vector<uint32_t>& remap)
+{
+	BuildVertexFetchRemap(pIndices, indexCount, vertexCount, remap);
+
+	std::vector<T> reordered(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		reordered[remap[v]] = pVertices[v];
+	}
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		pVertices[v] = reordered[v];
+	}
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		pIndices[i] = static_cast<TIndex>(remap[pIndices[i]]);
+	}
+}
+
+template<typename T, typename TIndex>
+void OptimizeVertexFetch(T* pVertices, size_t vertexCount, TIndex* pIndices, size_t indexCount)
+{
+	std::vector<uint32_t> remap;
+	OptimizeVertexFetch(pVertices, vertexCount, pIndices, indexCount, remap);
+}
@@ -0,0 +1,55 @@
+/*****************************************************************//**
+ * \file   simd_util.cpp
+ * \brief  CPU feature detection
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include "simd_util.h"
+
+#if SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static SIMD_LEVEL detect_simd_level()
+{
+#if SIMD_X86 && defined(_MSC_VER)
+	int info[4] = { };
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse41 = (info[2] & (1 << 19)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx)
+	{
+		// OS has to save YMM registers on context switch
+		unsigned long long xcr0 = _xgetbv(0);
+		if ((xcr0 & 0x6) == 0x6)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	}
+
+	if (avx2) return SIMD_LEVEL_AVX2;
+	if (sse41) return SIMD_LEVEL_SSE41;
+	return SIMD_LEVEL_SCALAR;
+#elif SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SIMD_LEVEL_AVX2;
+	if (__builtin_cpu_supports("sse4.1")) return SIMD_LEVEL_SSE41;
+	return SIMD_LEVEL_SCALAR;
+#else
+	return SIMD_LEVEL_SCALAR;
+#endif
+}
+
+SIMD_LEVEL GetSimdLevel()
+{
+	static const SIMD_LEVEL level = detect_simd_level();
+	return level;
+}
@@ -0,0 +1,36 @@
+/*****************************************************************//**
+ * \file   simd_util.h
+ * \brief  CPU feature detection and helpers for SIMD code paths
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+// MSVC accepts any intrinsic in any function, GCC and Clang
+// need the instruction set enabled per function
+#if defined(_MSC_VER)
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Instruction sets that kernels can be dispatched to
+enum SIMD_LEVEL
+{
+	SIMD_LEVEL_SCALAR = 0,
+	SIMD_LEVEL_SSE41 = 1,
+	SIMD_LEVEL_AVX2 = 2
+};
+
+// Best instruction set supported by the CPU and the OS, detected once
+SIMD_LEVEL GetSimdLevel();
@@ -2,8 +2,10 @@
 
 #include <d3d12.h>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 
 #include "MathHelper.h"
+#include "frustum.h"
 
 // Structure describing vertex buffer element format
 struct Vertex
@@ -13,9 +15,43 @@ struct Vertex
 	DirectX::XMFLOAT2 TexC;		// Texture coordinates
 };
 
+// Half-size vertex for bandwidth-bound meshes, see vertex_packing.h
+struct PackedVertex
+{
+	DirectX::PackedVector::XMUSHORTN4 Pos;	// Position quantised to the mesh bounds, w unused
+	DirectX::PackedVector::XMSHORTN2 Normal;	// Octahedral-encoded unit normal
+	DirectX::PackedVector::XMHALF2 TexC;		// Texture coordinates
+};
+
 struct ObjectConstants
 {
 	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+
+	// Dequantisation of packed vertex positions, identity for Vertex
+	DirectX::XMFLOAT4 PosScale = { 1.0f, 1.0f, 1.0f, 0.0f };
+	DirectX::XMFLOAT4 PosOffset = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// Terrain maps: world (z, x) to texture coordinates, see
+	// TerrainLayout::MapTransform. Strength 0 ignores the maps.
+	DirectX::XMFLOAT4 TerrainMapTransform = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float OcclusionStrength = 0.0f;
+	float ShadowStrength = 0.0f;
+
+	// Terrain drawn from the height map: sample to world height (scale,
+	// offset) and TerrainLayout (ZeroX, ZeroZ, Dx, Dz)
+	DirectX::XMFLOAT2 TerrainHeightScale = { 0.0f, 0.0f };
+	DirectX::XMFLOAT4 TerrainGrid = { 0.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// Root constants of a terrain LOD draw, see TerrainLodDraw
+struct TerrainPatchConstants
+{
+	UINT FirstRow = 0;
+	UINT FirstCol = 0;
+	UINT Size = 0;
+	UINT PatchQuads = 0;
+	float MorphStart = 0.0f;
+	float MorphEnd = 0.0f;
 };
 
 struct Light
@@ -71,6 +107,9 @@ struct SubmeshGeometry
 	UINT IndexCount = 0;            // How many indices to draw
 	UINT StartIndexLocation = 0;    // From which to start
 	INT BaseVertexLocation = 0;     // Padding of the indices
+
+	BoundingBoxAA Bounds;           // Object space, tight around the vertices
+	BoundingSphere Sphere;
 };
 
 struct Shader
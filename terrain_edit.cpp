@@ -0,0 +1,272 @@
+/*****************************************************************//**
+ * \file   terrain_edit.cpp
+ * \brief  Runtime terrain editing with partial vertex buffer updates
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "terrain_edit.h"
+#include "terrain_kernel.h"
+
+TerrainEditor::TerrainEditor(HeightmapImage& heightmap, const SubmeshGeometry* pChunkSubmeshes,
+	std::vector<std::vector<uint32_t>> vertexRemaps) :
+	mHeightmap(heightmap),
+	mLayout(heightmap.GetWidth(), heightmap.GetHeight())
+{
+	// Chunks are in the order BuildTerrainMesh creates them
+	for (UINT chunkCol = 0; chunkCol < mLayout.ChunkColumns(); chunkCol++)
+	{
+		for (UINT chunkRow = 0; chunkRow < mLayout.ChunkRows(); chunkRow++)
+		{
+			size_t i = mChunks.size();
+
+			chunk_placement placement;
+			placement.Chunk = mLayout.GetChunk(chunkCol, chunkRow);
+			placement.BaseVertex = static_cast<UINT>(pChunkSubmeshes[i].BaseVertexLocation);
+			placement.Remap.swap(vertexRemaps[i]);
+
+			placement.Inverse.resize(placement.Remap.size());
+			for (size_t v = 0; v < placement.Remap.size(); v++)
+			{
+				placement.Inverse[placement.Remap[v]] = static_cast<uint32_t>(v);
+			}
+
+			mChunks.push_back(std::move(placement));
+		}
+	}
+}
+
+TerrainDirtyRect TerrainEditor::ApplyBrush(const TerrainBrush& brush, float x, float z)
+{
+	// Brush centre in sample coordinates
+	float centreRow = (x - mLayout.ZeroX) / mLayout.Dx;
+	float centreCol = (mLayout.ZeroZ - z) / mLayout.Dz;
+
+	// Clamped on both sides before the conversion, a brush off the map
+	// gives an empty rect
+	TerrainDirtyRect rect;
+	rect.FirstRow = (UINT)(std::min)((float)mLayout.Depth, (std::max)(0.0f, std::floor(centreRow - brush.Radius)));
+	rect.FirstCol = (UINT)(std::min)((float)mLayout.Width, (std::max)(0.0f, std::floor(centreCol - brush.Radius)));
+	rect.EndRow = (UINT)(std::max)(0.0f, (std::min)((float)mLayout.Depth, std::floor(centreRow + brush.Radius) + 1.0f));
+	rect.EndCol = (UINT)(std::max)(0.0f, (std::min)((float)mLayout.Width, std::floor(centreCol + brush.Radius) + 1.0f));
+
+	if (rect.Empty()) return TerrainDirtyRect();
+
+	const float hardRadius = brush.Radius * brush.Hardness;
+	const float softWidth = (std::max)(brush.Radius - hardRadius, 1e-3f);
+
+	for (UINT row = rect.FirstRow; row < rect.EndRow; row++)
+	{
+		uint8_t* pRow = mHeightmap.GetWritableRow(row);
+
+		for (UINT col = rect.FirstCol; col < rect.EndCol; col++)
+		{
+			float dr = (float)row - centreRow;
+			float dc = (float)col - centreCol;
+			float distance = std::sqrt(dr * dr + dc * dc);
+			if (distance >= brush.Radius) continue;
+
+			// Full strength inside the hard radius, smooth falloff outside
+			float t = (std::min)((std::max)((distance - hardRadius) / softWidth, 0.0f), 1.0f);
+			float weight = 1.0f - t * t * (3.0f - 2.0f * t);
+
+			float value = (float)pRow[col];
+			switch (brush.Mode)
+			{
+			case TERRAIN_BRUSH_RAISE:
+				value += brush.Strength * weight;
+				break;
+			case TERRAIN_BRUSH_LOWER:
+				value -= brush.Strength * weight;
+				break;
+			case TERRAIN_BRUSH_FLATTEN:
+				value += (brush.TargetHeight - value) * (std::min)(brush.FlattenRate * weight, 1.0f);
+				break;
+			}
+
+			pRow[col] = (uint8_t)((std::min)((std::max)(value, 0.0f), 255.0f) + 0.5f);
+		}
+	}
+
+	MarkDirty(rect);
+	return rect;
+}
+
+void TerrainEditor::MarkDirty(const TerrainDirtyRect& samples)
+{
+	// Grid vertex (g, h) samples heightmap (g + 1, h + 1) and its four
+	// neighbours for the normal, so it depends on samples g..g+2
+	UINT firstRow = samples.FirstRow > 2 ? samples.FirstRow - 2 : 0;
+	UINT firstCol = samples.FirstCol > 2 ? samples.FirstCol - 2 : 0;
+	UINT endRow = (std::min)(samples.EndRow, mLayout.GridRows());
+	UINT endCol = (std::min)(samples.EndCol, mLayout.GridColumns());
+
+	if (firstRow >= endRow || firstCol >= endCol) return;
+
+	for (UINT c = 0; c < mChunks.size(); c++)
+	{
+		const TerrainChunk& chunk = mChunks[c].Chunk;
+
+		dirty_region region;
+		region.Chunk = c;
+		region.FirstRow = (std::max)(firstRow, chunk.FirstRow);
+		region.FirstCol = (std::max)(firstCol, chunk.FirstCol);
+		region.EndRow = (std::min)(endRow, chunk.FirstRow + chunk.NumRows);
+		region.EndCol = (std::min)(endCol, chunk.FirstCol + chunk.NumCols);
+
+		if (region.FirstRow >= region.EndRow || region.FirstCol >= region.EndCol) continue;
+
+		// Strokes repeat over the same area, merge with overlapping regions
+		// of the chunk so that vertices are not uploaded twice
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (auto it = mPending.begin(); it != mPending.end(); ++it)
+			{
+				if (it->Chunk != c ||
+					it->FirstRow >= region.EndRow || region.FirstRow >= it->EndRow ||
+					it->FirstCol >= region.EndCol || region.FirstCol >= it->EndCol)
+				{
+					continue;
+				}
+
+				region.FirstRow = (std::min)(region.FirstRow, it->FirstRow);
+				region.FirstCol = (std::min)(region.FirstCol, it->FirstCol);
+				region.EndRow = (std::max)(region.EndRow, it->EndRow);
+				region.EndCol = (std::max)(region.EndCol, it->EndCol);
+
+				mPending.erase(it);
+				merged = true;
+				break;
+			}
+		}
+
+		mPending.push_back(region);
+	}
+}
+
+Vertex TerrainEditor::BuildVertex(UINT gridRow, UINT gridCol) const
+{
+	const uint8_t* pRow = mHeightmap.GetRow(gridRow + 1) + gridCol + 1;
+	const size_t pitch = mHeightmap.GetRowPitch();
+
+	// Same kernel as the mesher, so regenerated vertices match exactly
+	float height, normalX, normalY, normalZ;
+	ComputeTerrainRow(pRow - pitch, pRow, pRow + pitch, 1, mLayout.Dx, mLayout.Dz,
+		&height, &normalX, &normalY, &normalZ);
+
+	float x = mLayout.WorldX(gridRow + 1);
+	float z = mLayout.WorldZ(gridCol + 1);
+
+	return Vertex{
+		{ x, height, z },
+		{ normalX, normalY, normalZ },
+		{ 0.05f * x, 0.05f * z } };
+}
+
+bool TerrainEditor::StageRegion(const dirty_region& region, Vertex* pStaging, UINT capacity, UINT& staged,
+	std::vector<TerrainVertexCopy>& copies)
+{
+	const chunk_placement& placement = mChunks[region.Chunk];
+	const TerrainChunk& chunk = placement.Chunk;
+
+	// Buffer positions of the region's vertices, chunk vertices are
+	// stored column after column
+	mBufferVertices.clear();
+	for (UINT col = region.FirstCol; col < region.EndCol; col++)
+	{
+		const uint32_t* pColumn = &placement.Remap[static_cast<size_t>(col - chunk.FirstCol) * chunk.NumRows];
+		for (UINT row = region.FirstRow; row < region.EndRow; row++)
+		{
+			mBufferVertices.push_back(pColumn[row - chunk.FirstRow]);
+		}
+	}
+	std::sort(mBufferVertices.begin(), mBufferVertices.end());
+
+	// Join vertices into runs of (first, end), small gaps are
+	// uploaded unchanged
+	mRuns.clear();
+	UINT total = 0;
+	for (size_t i = 0; i < mBufferVertices.size(); )
+	{
+		size_t j = i + 1;
+		while (j < mBufferVertices.size() &&
+			mBufferVertices[j] - mBufferVertices[j - 1] <= TERRAIN_EDIT_COPY_GAP + 1)
+		{
+			j++;
+		}
+
+		uint32_t first = mBufferVertices[i];
+		uint32_t end = mBufferVertices[j - 1] + 1;
+		mRuns.push_back(first);
+		mRuns.push_back(end);
+		total += end - first;
+
+		i = j;
+	}
+
+	if (staged + total > capacity) return false;
+
+	for (size_t r = 0; r < mRuns.size(); r += 2)
+	{
+		uint32_t first = mRuns[r];
+		uint32_t end = mRuns[r + 1];
+
+		TerrainVertexCopy copy;
+		copy.StagingVertex = staged;
+		copy.BufferVertex = placement.BaseVertex + first;
+		copy.VertexCount = end - first;
+		copies.push_back(copy);
+
+		for (uint32_t v = first; v < end; v++)
+		{
+			uint32_t local = placement.Inverse[v];
+			pStaging[staged++] = BuildVertex(chunk.FirstRow + local % chunk.NumRows,
+				chunk.FirstCol + local / chunk.NumRows);
+		}
+	}
+
+	return true;
+}
+
+UINT TerrainEditor::PrepareUpload(Vertex* pStaging, UINT capacity, std::vector<TerrainVertexCopy>& copies)
+{
+	copies.clear();
+	UINT staged = 0;
+
+	while (!mPending.empty())
+	{
+		dirty_region region = mPending.front();
+
+		if (StageRegion(region, pStaging, capacity, staged, copies))
+		{
+			mPending.pop_front();
+			continue;
+		}
+
+		// The rest waits for the next frame's staging buffer
+		if (staged > 0) break;
+
+		// Region does not fit into an empty buffer, split the longer side
+		if (region.EndRow - region.FirstRow == 1 && region.EndCol - region.FirstCol == 1) break;
+
+		dirty_region second = region;
+		if (region.EndRow - region.FirstRow >= region.EndCol - region.FirstCol)
+		{
+			region.EndRow = second.FirstRow = (region.FirstRow + region.EndRow) / 2;
+		}
+		else
+		{
+			region.EndCol = second.FirstCol = (region.FirstCol + region.EndCol) / 2;
+		}
+
+		mPending.front() = second;
+		mPending.push_front(region);
+	}
+
+	return staged;
+}
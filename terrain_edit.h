@@ -0,0 +1,116 @@
+/*****************************************************************//**
+ * \file   terrain_edit.h
+ * \brief  Runtime terrain editing with partial vertex buffer updates
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "image_helper.h"
+#include "structures.h"
+#include "terrain_mesh.h"
+
+// Vertices of the per-frame staging buffer
+#define TERRAIN_EDIT_STAGING_VERTICES 65536
+
+// Unchanged vertices between two dirty ones that are uploaded as well,
+// so that both go in one copy
+#define TERRAIN_EDIT_COPY_GAP 8
+
+enum TERRAIN_BRUSH
+{
+	TERRAIN_BRUSH_RAISE = 0,
+	TERRAIN_BRUSH_LOWER = 1,
+	TERRAIN_BRUSH_FLATTEN = 2		// Moves samples towards TargetHeight
+};
+
+struct TerrainBrush
+{
+	TERRAIN_BRUSH Mode = TERRAIN_BRUSH_RAISE;
+	float Radius = 8.0f;			// In heightmap samples
+	float Strength = 4.0f;			// Levels added or removed at the centre
+	float Hardness = 0.5f;			// Part of the radius at full strength
+	float TargetHeight = 128.0f;	// Sample value flatten moves towards
+	float FlattenRate = 0.25f;		// Part of the way to TargetHeight per application
+};
+
+// Copy from the staging buffer to the vertex buffer, in vertices
+struct TerrainVertexCopy
+{
+	UINT StagingVertex = 0;
+	UINT BufferVertex = 0;
+	UINT VertexCount = 0;
+};
+
+/**
+ * Edits the heightmap and keeps the terrain vertex buffer in sync.
+ *
+ * Brushes change heightmap samples and mark the grid vertices that
+ * depend on them, including the neighbours whose normals change.
+ * Every frame the pending vertices are regenerated into the frame's
+ * staging buffer and copied to their places in the vertex buffer.
+ * Mesh optimization reorders vertices inside chunks, so dirty vertices
+ * are located through the remap recorded by CreateTerrain.
+ */
+class TerrainEditor
+{
+public:
+	// pChunkSubmeshes are the terrain submeshes, vertexRemaps the
+	// remaps CreateTerrain filled for them
+	TerrainEditor(HeightmapImage& heightmap, const SubmeshGeometry* pChunkSubmeshes,
+		std::vector<std::vector<uint32_t>> vertexRemaps);
+
+	TerrainEditor(TerrainEditor& other) = delete;
+
+	// Applies the brush at world position (x, z), returns the samples changed
+	TerrainDirtyRect ApplyBrush(const TerrainBrush& brush, float x, float z);
+
+	bool HasPendingUpload() const { return !mPending.empty(); }
+
+	// Regenerates pending vertices into pStaging, up to capacity, and
+	// lists the copies to make. Vertices that do not fit stay pending.
+	// Returns the number of staged vertices.
+	UINT PrepareUpload(Vertex* pStaging, UINT capacity, std::vector<TerrainVertexCopy>& copies);
+
+	const TerrainLayout& GetLayout() const { return mLayout; }
+
+private:
+	// Part of the vertex grid inside one chunk, in grid coordinates
+	struct dirty_region
+	{
+		UINT Chunk;
+		UINT FirstRow;
+		UINT FirstCol;
+		UINT EndRow;
+		UINT EndCol;
+	};
+
+	void MarkDirty(const TerrainDirtyRect& samples);
+	bool StageRegion(const dirty_region& region, Vertex* pStaging, UINT capacity, UINT& staged,
+		std::vector<TerrainVertexCopy>& copies);
+	Vertex BuildVertex(UINT gridRow, UINT gridCol) const;
+
+	struct chunk_placement
+	{
+		TerrainChunk Chunk;
+		UINT BaseVertex;					// In the vertex buffer
+		std::vector<uint32_t> Remap;		// Chunk vertex to submesh vertex
+		std::vector<uint32_t> Inverse;		// Submesh vertex to chunk vertex
+	};
+
+	HeightmapImage& mHeightmap;
+	TerrainLayout mLayout;
+
+	std::vector<chunk_placement> mChunks;
+	std::deque<dirty_region> mPending;
+
+	// Scratch for PrepareUpload
+	std::vector<uint32_t> mBufferVertices;
+	std::vector<uint32_t> mRuns;
+};
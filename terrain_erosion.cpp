@@ -0,0 +1,395 @@
+/*****************************************************************//**
+ * \file   terrain_erosion.cpp
+ * \brief  Hydraulic and thermal erosion of heightmaps
+ *
+ * Hydraulic erosion follows Mei et al., "Fast Hydraulic Erosion
+ * Simulation and Visualization on GPU". One iteration is three passes:
+ *  1. Flux: outflow to the neighbours from the water level differences
+ *  2. Water: in- and outflow, velocity, dissolving and deposition
+ *  3. Sediment: semi-Lagrangian transport and evaporation
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "terrain_erosion.h"
+
+// Water depth below which a cell is treated as dry
+#define EROSION_MIN_DEPTH 1e-4f
+
+TerrainErosion::TerrainErosion(HeightmapImage& heightmap) :
+	mWidth(heightmap.GetWidth()),
+	mHeight(heightmap.GetHeight())
+{
+	mHeights.resize(static_cast<size_t>(mWidth) * mHeight);
+	mScratch.resize(mHeights.size());
+
+	for (uint32_t row = 0; row < mHeight; row++)
+	{
+		const uint8_t* pRow = heightmap.GetRow(row);
+		float* pDst = &mHeights[static_cast<size_t>(row) * mWidth];
+
+		for (uint32_t col = 0; col < mWidth; col++)
+		{
+			pDst[col] = (float)pRow[col];
+		}
+	}
+}
+
+void TerrainErosion::AllocateFlux()
+{
+	if (!mFluxLeft.empty()) return;
+
+	mFluxLeft.resize(mHeights.size());
+	mFluxRight.resize(mHeights.size());
+	mFluxUp.resize(mHeights.size());
+	mFluxDown.resize(mHeights.size());
+}
+
+void TerrainErosion::AllocateWater()
+{
+	AllocateFlux();
+	if (!mWater.empty()) return;
+
+	mWater.resize(mHeights.size());
+	mSediment.resize(mHeights.size());
+	mVelocityX.resize(mHeights.size());
+	mVelocityY.resize(mHeights.size());
+}
+
+void TerrainErosion::RunRows(WorkerPool* pPool, const std::function<void(uint32_t, uint32_t)>& func)
+{
+	if (pPool)
+	{
+		pPool->ParallelFor(mHeight, TERRAIN_EROSION_ROW_GRAIN, func);
+	}
+	else
+	{
+		func(0, mHeight);
+	}
+}
+
+void TerrainErosion::ErodeHydraulic(const HydraulicErosionSettings& settings, uint32_t iterations,
+	WorkerPool* pPool)
+{
+	AllocateWater();
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		RunRows(pPool, [&](uint32_t begin, uint32_t end) { UpdateFlux(settings, begin, end); });
+
+		// New heights go to the scratch field, the slope of the
+		// neighbours is read from the old ones
+		RunRows(pPool, [&](uint32_t begin, uint32_t end) { UpdateWater(settings, begin, end); });
+		mHeights.swap(mScratch);
+
+		RunRows(pPool, [&](uint32_t begin, uint32_t end) { TransportSediment(settings, begin, end); });
+		mSediment.swap(mScratch);
+	}
+}
+
+void TerrainErosion::UpdateFlux(const HydraulicErosionSettings& settings, uint32_t firstRow, uint32_t endRow)
+{
+	const uint32_t w = mWidth;
+	const float rain = settings.Rain * settings.TimeStep;
+	const float k = settings.TimeStep * settings.PipeArea * settings.Gravity / settings.CellSize;
+	const float cellArea = settings.CellSize * settings.CellSize;
+
+	for (uint32_t row = firstRow; row < endRow; row++)
+	{
+		const size_t base = static_cast<size_t>(row) * w;
+		const float* b = &mHeights[base];
+		const float* d = &mWater[base];
+
+		for (uint32_t col = 0; col < w; col++)
+		{
+			const size_t i = base + col;
+
+			// Rain is uniform, so it is added on the fly and every
+			// cell sees the same levels
+			float depth = d[col] + rain;
+			float level = b[col] + depth;
+
+			// No flow out of the map
+			float left = 0.0f;
+			float right = 0.0f;
+			float up = 0.0f;
+			float down = 0.0f;
+
+			if (col > 0)
+				left = (std::max)(0.0f, mFluxLeft[i] + k * (level - (b[col - 1] + d[col - 1] + rain)));
+			if (col + 1 < w)
+				right = (std::max)(0.0f, mFluxRight[i] + k * (level - (b[col + 1] + d[col + 1] + rain)));
+			if (row > 0)
+				up = (std::max)(0.0f, mFluxUp[i] + k * (level - (mHeights[i - w] + mWater[i - w] + rain)));
+			if (row + 1 < mHeight)
+				down = (std::max)(0.0f, mFluxDown[i] + k * (level - (mHeights[i + w] + mWater[i + w] + rain)));
+
+			// A cell cannot give more water than it holds
+			float total = (left + right) + (up + down);
+			if (total > 0.0f)
+			{
+				float scale = (std::min)(1.0f, depth * cellArea / (total * settings.TimeStep));
+				left *= scale;
+				right *= scale;
+				up *= scale;
+				down *= scale;
+			}
+
+			mFluxLeft[i] = left;
+			mFluxRight[i] = right;
+			mFluxUp[i] = up;
+			mFluxDown[i] = down;
+		}
+	}
+}
+
+void TerrainErosion::UpdateWater(const HydraulicErosionSettings& settings, uint32_t firstRow, uint32_t endRow)
+{
+	const uint32_t w = mWidth;
+	const float rain = settings.Rain * settings.TimeStep;
+	const float cellArea = settings.CellSize * settings.CellSize;
+	const float invTwoCells = 0.5f / settings.CellSize;
+
+	for (uint32_t row = firstRow; row < endRow; row++)
+	{
+		const size_t base = static_cast<size_t>(row) * w;
+
+		for (uint32_t col = 0; col < w; col++)
+		{
+			const size_t i = base + col;
+
+			// Flux the neighbours send towards this cell
+			float fromLeft = col > 0 ? mFluxRight[i - 1] : 0.0f;
+			float fromRight = col + 1 < w ? mFluxLeft[i + 1] : 0.0f;
+			float fromUp = row > 0 ? mFluxDown[i - w] : 0.0f;
+			float fromDown = row + 1 < mHeight ? mFluxUp[i + w] : 0.0f;
+
+			float inflow = (fromLeft + fromRight) + (fromUp + fromDown);
+			float outflow = (mFluxLeft[i] + mFluxRight[i]) + (mFluxUp[i] + mFluxDown[i]);
+
+			float depth = mWater[i] + rain;
+			float newDepth = (std::max)(0.0f, depth + settings.TimeStep * (inflow - outflow) / cellArea);
+
+			// Velocity from the water passing through the cell
+			float passX = ((fromLeft - mFluxLeft[i]) + (mFluxRight[i] - fromRight)) * 0.5f;
+			float passY = ((fromUp - mFluxUp[i]) + (mFluxDown[i] - fromDown)) * 0.5f;
+			float meanDepth = (depth + newDepth) * 0.5f;
+
+			float u = 0.0f;
+			float v = 0.0f;
+			if (meanDepth > EROSION_MIN_DEPTH)
+			{
+				u = passX / (meanDepth * settings.CellSize);
+				v = passY / (meanDepth * settings.CellSize);
+			}
+
+			// Slope of the ground from central differences
+			float b = mHeights[i];
+			float gx = (mHeights[col + 1 < w ? i + 1 : i] - mHeights[col > 0 ? i - 1 : i]) * invTwoCells;
+			float gy = (mHeights[row + 1 < mHeight ? i + w : i] - mHeights[row > 0 ? i - w : i]) * invTwoCells;
+			float gradient = gx * gx + gy * gy;
+			float sine = std::sqrt(gradient / (1.0f + gradient));
+
+			// Shallow water carries less, fading out towards dry ground
+			float capacity = settings.SedimentCapacity * (std::max)(sine, settings.MinSlope) *
+				std::sqrt(u * u + v * v) * (std::min)(newDepth / settings.ErosionDepth, 1.0f);
+
+			float sediment = mSediment[i];
+			if (capacity > sediment)
+			{
+				float dissolved = settings.Dissolving * (capacity - sediment);
+				b -= dissolved;
+				sediment += dissolved;
+			}
+			else
+			{
+				float deposited = settings.Deposition * (sediment - capacity);
+				b += deposited;
+				sediment -= deposited;
+			}
+
+			mScratch[i] = b;
+			mWater[i] = newDepth;
+			mSediment[i] = sediment;
+			mVelocityX[i] = u;
+			mVelocityY[i] = v;
+		}
+	}
+}
+
+void TerrainErosion::TransportSediment(const HydraulicErosionSettings& settings, uint32_t firstRow, uint32_t endRow)
+{
+	const uint32_t w = mWidth;
+	const float step = settings.TimeStep / settings.CellSize;
+	const float maxCol = (float)(w - 1);
+	const float maxRow = (float)(mHeight - 1);
+	const float keep = (std::max)(0.0f, 1.0f - settings.Evaporation * settings.TimeStep);
+
+	for (uint32_t row = firstRow; row < endRow; row++)
+	{
+		const size_t base = static_cast<size_t>(row) * w;
+
+		for (uint32_t col = 0; col < w; col++)
+		{
+			const size_t i = base + col;
+
+			// Sediment arrives from where the water was one step ago
+			float x = (std::min)((std::max)((float)col - mVelocityX[i] * step, 0.0f), maxCol);
+			float y = (std::min)((std::max)((float)row - mVelocityY[i] * step, 0.0f), maxRow);
+
+			uint32_t x0 = (std::min)((uint32_t)x, w - 1);
+			uint32_t y0 = (std::min)((uint32_t)y, mHeight - 1);
+			uint32_t x1 = (std::min)(x0 + 1, w - 1);
+			uint32_t y1 = (std::min)(y0 + 1, mHeight - 1);
+			float fx = x - (float)x0;
+			float fy = y - (float)y0;
+
+			const float* s0 = &mSediment[static_cast<size_t>(y0) * w];
+			const float* s1 = &mSediment[static_cast<size_t>(y1) * w];
+			float a = s0[x0] + (s0[x1] - s0[x0]) * fx;
+			float c = s1[x0] + (s1[x1] - s1[x0]) * fx;
+
+			mScratch[i] = a + (c - a) * fy;
+			mWater[i] *= keep;
+		}
+	}
+}
+
+void TerrainErosion::ErodeThermal(const ThermalErosionSettings& settings, uint32_t iterations,
+	WorkerPool* pPool)
+{
+	AllocateFlux();
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		RunRows(pPool, [&](uint32_t begin, uint32_t end) { ComputeSlides(settings, begin, end); });
+		RunRows(pPool, [&](uint32_t begin, uint32_t end) { ApplySlides(begin, end); });
+		mHeights.swap(mScratch);
+	}
+}
+
+void TerrainErosion::ComputeSlides(const ThermalErosionSettings& settings, uint32_t firstRow, uint32_t endRow)
+{
+	const uint32_t w = mWidth;
+
+	for (uint32_t row = firstRow; row < endRow; row++)
+	{
+		const size_t base = static_cast<size_t>(row) * w;
+
+		for (uint32_t col = 0; col < w; col++)
+		{
+			const size_t i = base + col;
+			const float h = mHeights[i];
+
+			// Height differences to the neighbours, zero past the border
+			float dl = col > 0 ? h - mHeights[i - 1] : 0.0f;
+			float dr = col + 1 < w ? h - mHeights[i + 1] : 0.0f;
+			float du = row > 0 ? h - mHeights[i - w] : 0.0f;
+			float dd = row + 1 < mHeight ? h - mHeights[i + w] : 0.0f;
+
+			float maxDiff = (std::max)((std::max)(dl, dr), (std::max)(du, dd));
+
+			float el = (std::max)(0.0f, dl - settings.Talus);
+			float er = (std::max)(0.0f, dr - settings.Talus);
+			float eu = (std::max)(0.0f, du - settings.Talus);
+			float ed = (std::max)(0.0f, dd - settings.Talus);
+			float excess = (el + er) + (eu + ed);
+
+			if (excess > 0.0f)
+			{
+				// Half of the steepest excess levels the two cells, the
+				// amount is shared in proportion to every neighbour's excess
+				float moved = settings.Rate * (maxDiff - settings.Talus) * 0.5f / excess;
+				mFluxLeft[i] = el * moved;
+				mFluxRight[i] = er * moved;
+				mFluxUp[i] = eu * moved;
+				mFluxDown[i] = ed * moved;
+			}
+			else
+			{
+				mFluxLeft[i] = 0.0f;
+				mFluxRight[i] = 0.0f;
+				mFluxUp[i] = 0.0f;
+				mFluxDown[i] = 0.0f;
+			}
+		}
+	}
+}
+
+void TerrainErosion::ApplySlides(uint32_t firstRow, uint32_t endRow)
+{
+	const uint32_t w = mWidth;
+
+	for (uint32_t row = firstRow; row < endRow; row++)
+	{
+		const size_t base = static_cast<size_t>(row) * w;
+
+		for (uint32_t col = 0; col < w; col++)
+		{
+			const size_t i = base + col;
+
+			float fromLeft = col > 0 ? mFluxRight[i - 1] : 0.0f;
+			float fromRight = col + 1 < w ? mFluxLeft[i + 1] : 0.0f;
+			float fromUp = row > 0 ? mFluxDown[i - w] : 0.0f;
+			float fromDown = row + 1 < mHeight ? mFluxUp[i + w] : 0.0f;
+
+			float inflow = (fromLeft + fromRight) + (fromUp + fromDown);
+			float outflow = (mFluxLeft[i] + mFluxRight[i]) + (mFluxUp[i] + mFluxDown[i]);
+
+			mScratch[i] = mHeights[i] + (inflow - outflow);
+		}
+	}
+}
+
+void TerrainErosion::WriteHeightmap(HeightmapImage& heightmap) const
+{
+	for (uint32_t row = 0; row < mHeight; row++)
+	{
+		const float* pSrc = &mHeights[static_cast<size_t>(row) * mWidth];
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+
+		for (uint32_t col = 0; col < mWidth; col++)
+		{
+			float value = (std::min)((std::max)(pSrc[col], 0.0f), 255.0f);
+			pRow[col] = (uint8_t)(value + 0.5f);
+		}
+	}
+}
+
+int TerrainErosion::WriteRaw16(const char* filename) const
+{
+	std::ofstream out;
+	out.open(filename, std::ios::out | std::ios::binary);
+
+	if (!out)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", filename);
+		return -1;
+	}
+
+	std::vector<uint8_t> line(static_cast<size_t>(mWidth) * 2);
+
+	for (uint32_t row = 0; row < mHeight; row++)
+	{
+		const float* pSrc = &mHeights[static_cast<size_t>(row) * mWidth];
+
+		for (uint32_t col = 0; col < mWidth; col++)
+		{
+			float value = (std::min)((std::max)(pSrc[col], 0.0f), 255.0f);
+			uint16_t sample = (uint16_t)(value * 257.0f + 0.5f);
+
+			line[col * 2] = (uint8_t)(sample & 0xFF);
+			line[col * 2 + 1] = (uint8_t)(sample >> 8);
+		}
+
+		out.write((const char*)line.data(), line.size());
+	}
+
+	out.close();
+	return 0;
+}
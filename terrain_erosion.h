@@ -0,0 +1,118 @@
+/*****************************************************************//**
+ * \file   terrain_erosion.h
+ * \brief  Hydraulic and thermal erosion of heightmaps
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "image_helper.h"
+#include "thread_pool.h"
+
+// Rows processed as one parallel work item
+#define TERRAIN_EROSION_ROW_GRAIN 16
+
+/**
+ * Virtual pipe water model: cells exchange water through pipes to their
+ * four neighbours, flowing water dissolves the ground up to its sediment
+ * capacity and deposits the excess. Heights, water and CellSize are in
+ * heightmap levels (0 - 255).
+ */
+struct HydraulicErosionSettings
+{
+	float TimeStep = 0.05f;
+	float CellSize = 1.0f;				// Distance between samples
+	float Gravity = 9.81f;
+	float PipeArea = 1.0f;				// Cross section of the pipes
+	float Rain = 0.02f;					// Water added per cell and unit of time
+	float Evaporation = 0.05f;			// Part of the water removed per unit of time
+	float SedimentCapacity = 0.5f;		// Sediment carried per unit of slope and speed
+	float Dissolving = 0.02f;			// Part of the missing capacity dissolved per step
+	float Deposition = 0.05f;			// Part of the excess sediment deposited per step
+	float MinSlope = 0.05f;				// Flat water still carries some sediment
+	float ErosionDepth = 1.0f;			// Depth below which the capacity is scaled down
+};
+
+/**
+ * Material slides to lower neighbours until no slope exceeds the talus.
+ */
+struct ThermalErosionSettings
+{
+	float Talus = 2.0f;					// Stable height difference between neighbours
+	float Rate = 0.5f;					// Part of the excess moved per iteration
+};
+
+/**
+ * Float copy of a heightmap that erosion passes are run on.
+ *
+ * Every iteration is made of passes over the whole grid. A pass reads
+ * fields it does not write and every cell writes only its own values,
+ * so rows are processed in parallel without locks and the result is
+ * the same for any number of threads.
+ */
+class TerrainErosion
+{
+public:
+	TerrainErosion(HeightmapImage& heightmap);
+
+	TerrainErosion(TerrainErosion& other) = delete;
+
+	// Runs the passes over pPool, nullptr runs serially
+	void ErodeHydraulic(const HydraulicErosionSettings& settings, uint32_t iterations,
+		WorkerPool* pPool);
+	void ErodeThermal(const ThermalErosionSettings& settings, uint32_t iterations,
+		WorkerPool* pPool);
+
+	// Heights rounded and clamped to 8 bits
+	void WriteHeightmap(HeightmapImage& heightmap) const;
+
+	// Heights as 16-bit little endian samples, row after row, 0 - 255
+	// mapped to 0 - 65535. 0 - success, -1 - error
+	int WriteRaw16(const char* filename) const;
+
+	const float* GetHeights() const { return mHeights.data(); }
+	const float* GetWater() const { return mWater.data(); }
+
+	uint32_t GetWidth() const { return mWidth; }
+	uint32_t GetHeight() const { return mHeight; }
+
+private:
+	void RunRows(WorkerPool* pPool, const std::function<void(uint32_t, uint32_t)>& func);
+
+	// Hydraulic passes
+	void UpdateFlux(const HydraulicErosionSettings& settings, uint32_t firstRow, uint32_t endRow);
+	void UpdateWater(const HydraulicErosionSettings& settings, uint32_t firstRow, uint32_t endRow);
+	void TransportSediment(const HydraulicErosionSettings& settings, uint32_t firstRow, uint32_t endRow);
+
+	// Thermal passes
+	void ComputeSlides(const ThermalErosionSettings& settings, uint32_t firstRow, uint32_t endRow);
+	void ApplySlides(uint32_t firstRow, uint32_t endRow);
+
+	void AllocateFlux();
+	void AllocateWater();
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+
+	std::vector<float> mHeights;
+	std::vector<float> mScratch;		// Next values of a field read by its own pass
+
+	// Water state, allocated by the first hydraulic run
+	std::vector<float> mWater;
+	std::vector<float> mSediment;
+	std::vector<float> mVelocityX;		// Along columns
+	std::vector<float> mVelocityY;		// Along rows
+
+	// Outflow of every cell to its neighbours. Thermal erosion keeps
+	// the material sliding off in them.
+	std::vector<float> mFluxLeft;
+	std::vector<float> mFluxRight;
+	std::vector<float> mFluxUp;			// To the previous row
+	std::vector<float> mFluxDown;		// To the next row
+};
@@ -0,0 +1,342 @@
+/*****************************************************************//**
+ * \file   terrain_horizon.cpp
+ * \brief  Horizon angles and ambient occlusion of heightmaps
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#include "terrain_horizon.h"
+#include "terrain_kernel.h"
+
+// Side of the tiles transposed data is combined in
+#define TERRAIN_HORIZON_TILE 64
+
+TerrainHorizonBaker::TerrainHorizonBaker(HeightmapImage& heightmap) :
+	mLayout(heightmap.GetWidth(), heightmap.GetHeight())
+{
+	const size_t count = static_cast<size_t>(mLayout.Depth) * mLayout.Width;
+	mHeights.resize(count);
+	mHeightsT.resize(count);
+
+	// Heights are read through tiles, so the heightmap may be in either layout
+	for (uint32_t tileRow = 0; tileRow < heightmap.GetTileRows(); tileRow++)
+	{
+		for (uint32_t tileCol = 0; tileCol < heightmap.GetTileColumns(); tileCol++)
+		{
+			const image_tile tile = heightmap.GetTile(tileRow, tileCol);
+			const UINT firstRow = tileRow * IMAGE_TILE_SIZE;
+			const UINT firstCol = tileCol * IMAGE_TILE_SIZE;
+
+			for (UINT row = 0; row < tile.rows; row++)
+			{
+				const uint8_t* pRow = tile.data + static_cast<size_t>(row) * tile.row_pitch;
+				float* pDst = &mHeights[static_cast<size_t>(firstRow + row) * mLayout.Width + firstCol];
+
+				for (UINT col = 0; col < tile.cols; col++)
+				{
+					pDst[col] = TerrainLayout::SampleHeight((float)pRow[col]);
+				}
+			}
+		}
+	}
+
+	for (UINT tileRow = 0; tileRow < mLayout.Depth; tileRow += TERRAIN_HORIZON_TILE)
+	{
+		const UINT endRow = (std::min)(tileRow + TERRAIN_HORIZON_TILE, mLayout.Depth);
+
+		for (UINT col = 0; col < mLayout.Width; col++)
+		{
+			for (UINT row = tileRow; row < endRow; row++)
+			{
+				mHeightsT[static_cast<size_t>(col) * mLayout.Depth + row] =
+					mHeights[static_cast<size_t>(row) * mLayout.Width + col];
+			}
+		}
+	}
+}
+
+const uint8_t* TerrainHorizonBaker::GetHorizons(uint32_t direction) const
+{
+	if (mHorizons.empty() || direction >= mDirections) return nullptr;
+	return &mHorizons[static_cast<size_t>(direction) * mHeights.size()];
+}
+
+void TerrainHorizonBaker::SetupDirection(float angle, sweep_direction& sweep) const
+{
+	// Moving along the direction by one unit changes the row by
+	// cos / Dx and the column by sin / Dz
+	const float dirX = std::cos(angle);
+	const float dirZ = std::sin(angle);
+	const float rowRate = dirX / mLayout.Dx;
+	const float colRate = dirZ / mLayout.Dz;
+
+	sweep.RowMajor = std::fabs(rowRate) >= std::fabs(colRate);
+
+	float slope;
+	if (sweep.RowMajor)
+	{
+		sweep.MajorCount = mLayout.Depth;
+		sweep.MinorCount = mLayout.Width;
+		sweep.MajorDistance = mLayout.Dx * dirX;
+		sweep.MinorDistance = mLayout.Dz * dirZ;
+		slope = colRate / rowRate;
+	}
+	else
+	{
+		sweep.MajorCount = mLayout.Width;
+		sweep.MinorCount = mLayout.Depth;
+		sweep.MajorDistance = mLayout.Dz * dirZ;
+		sweep.MinorDistance = mLayout.Dx * dirX;
+		slope = rowRate / colRate;
+	}
+
+	// Walk from the far end, so samples ahead are passed first
+	sweep.Step = sweep.MajorDistance > 0.0f ? -1 : 1;
+
+	// Lines are the same digital line shifted along the minor axis, so
+	// every sample lies on exactly one of them
+	sweep.Offsets.resize(sweep.MajorCount);
+	for (uint32_t i = 0; i < sweep.MajorCount; i++)
+	{
+		sweep.Offsets[i] = (int)std::floor((float)i * slope + 0.5f);
+	}
+
+	int minOffset = (std::min)(sweep.Offsets.front(), sweep.Offsets.back());
+	int maxOffset = (std::max)(sweep.Offsets.front(), sweep.Offsets.back());
+	sweep.FirstLine = -maxOffset;
+	sweep.EndLine = (int)sweep.MinorCount - minOffset;
+}
+
+void TerrainHorizonBaker::SweepLines(const sweep_direction& sweep, const sweep_output& output,
+	int firstLine, int endLine, std::unique_ptr<float[]>& hull, std::vector<uint32_t>& hullSize)
+{
+	// Minor axis is contiguous in the layout read, so the lines of the
+	// group read one run of samples per step
+	const float* pHeights = sweep.RowMajor ? mHeights.data() : mHeightsT.data();
+	const size_t majorStride = sweep.MinorCount;
+
+	// Upper hull of the samples passed by every line, distance along the
+	// direction and height of each point. Points of the same depth are
+	// stored together, as the hulls of neighbouring lines grow alike.
+	const uint32_t lineCount = static_cast<uint32_t>(endLine - firstLine);
+	const size_t depthStride = static_cast<size_t>(lineCount) * 2;
+	if (!hull)
+	{
+		// Only the first few depths are ever touched
+		hull.reset(new float[depthStride * sweep.MajorCount]);
+	}
+	hullSize.assign(lineCount, 0);
+
+	float* pHull = hull.get();
+	uint32_t* pSize = hullSize.data();
+
+	for (uint32_t k = 0; k < sweep.MajorCount; k++)
+	{
+		const uint32_t i = sweep.Step > 0 ? k : sweep.MajorCount - 1 - k;
+		const int offset = sweep.Offsets[i];
+
+		// Lines of the group that cross the map at this step
+		const int first = (std::max)(firstLine + offset, 0) - (firstLine + offset);
+		const int last = (std::min)(endLine + offset, (int)sweep.MinorCount) - (firstLine + offset);
+
+		for (int l = first; l < last; l++)
+		{
+			const int j = firstLine + offset + l;
+			const size_t index = static_cast<size_t>(i) * majorStride + j;
+			const float u = (float)i * sweep.MajorDistance + (float)j * sweep.MinorDistance;
+			const float h = pHeights[index];
+
+			float* pLine = pHull + 2 * l;
+			uint32_t n = pSize[l];
+
+			// Drop hull points under the line to the one before them,
+			// slopes compared without dividing, all points are ahead
+			while (n >= 2)
+			{
+				const float* pTop = pLine + (n - 1) * depthStride;
+				const float* pBelow = pTop - depthStride;
+				if ((pBelow[1] - h) * (pTop[0] - u) < (pTop[1] - h) * (pBelow[0] - u)) break;
+				n--;
+			}
+
+			// Rise and run to the horizon point, below the horizontal
+			// plane only the plane occludes
+			float run = 1.0f;
+			float rise = 0.0f;
+			if (n > 0)
+			{
+				const float* pTop = pLine + (n - 1) * depthStride;
+				run = pTop[0] - u;
+				rise = (std::max)(pTop[1] - h, 0.0f);
+			}
+
+			pLine[n * depthStride] = u;
+			pLine[n * depthStride + 1] = h;
+			pSize[l] = n + 1;
+
+			// cos^2 of the elevation is the cosine-weighted open part
+			// of a slice of the hemisphere
+			const float length2 = run * run + rise * rise;
+			if (output.pOpenSky)
+			{
+				output.pOpenSky[index] += run * run / length2;
+			}
+
+			if (output.pTangents)
+			{
+				output.pTangents[index] = rise / run;
+			}
+
+			if (output.pHorizons)
+			{
+				const size_t row = sweep.RowMajor ? i : j;
+				const size_t col = sweep.RowMajor ? j : i;
+				const float sine = rise / std::sqrt(length2);
+				output.pHorizons[row * mLayout.Width + col] = (uint8_t)(sine * 255.0f + 0.5f);
+			}
+		}
+	}
+}
+
+void TerrainHorizonBaker::SweepDirection(const sweep_direction& sweep, const sweep_output& output,
+	WorkerPool* pPool)
+{
+	auto sweepGroups = [&](uint32_t begin, uint32_t end)
+	{
+		std::unique_ptr<float[]> hull;
+		std::vector<uint32_t> hullSize;
+
+		for (uint32_t g = begin; g < end; g++)
+		{
+			const int first = sweep.FirstLine + (int)g * TERRAIN_HORIZON_LINE_GROUP;
+			const int last = (std::min)(first + TERRAIN_HORIZON_LINE_GROUP, sweep.EndLine);
+			SweepLines(sweep, output, first, last, hull, hullSize);
+		}
+	};
+
+	const uint32_t groups = static_cast<uint32_t>(sweep.EndLine - sweep.FirstLine +
+		TERRAIN_HORIZON_LINE_GROUP - 1) / TERRAIN_HORIZON_LINE_GROUP;
+	if (pPool)
+	{
+		pPool->ParallelFor(groups, 1, sweepGroups);
+	}
+	else
+	{
+		sweepGroups(0, groups);
+	}
+}
+
+void TerrainHorizonBaker::BakeDirection(float angle, std::vector<float>& tangents, WorkerPool* pPool)
+{
+	sweep_direction sweep;
+	SetupDirection(angle, sweep);
+
+	tangents.resize(mHeights.size());
+
+	// Lines near the columns write the transposed layout, turned back
+	// in tiles afterwards
+	sweep_output output = { };
+	if (sweep.RowMajor)
+	{
+		output.pTangents = tangents.data();
+		SweepDirection(sweep, output, pPool);
+		return;
+	}
+
+	mScratch.resize(mHeights.size());
+	output.pTangents = mScratch.data();
+	SweepDirection(sweep, output, pPool);
+
+	for (UINT tileRow = 0; tileRow < mLayout.Depth; tileRow += TERRAIN_HORIZON_TILE)
+	{
+		const UINT endRow = (std::min)(tileRow + TERRAIN_HORIZON_TILE, mLayout.Depth);
+
+		for (UINT col = 0; col < mLayout.Width; col++)
+		{
+			for (UINT row = tileRow; row < endRow; row++)
+			{
+				tangents[static_cast<size_t>(row) * mLayout.Width + col] =
+					mScratch[static_cast<size_t>(col) * mLayout.Depth + row];
+			}
+		}
+	}
+}
+
+void TerrainHorizonBaker::Bake(const TerrainHorizonSettings& settings, WorkerPool* pPool)
+{
+	mDirections = (std::max)(settings.Directions, 1u);
+
+	mOpenSky.assign(mHeights.size(), 0.0f);
+	mOpenSkyT.assign(mHeights.size(), 0.0f);
+	mOcclusion.resize(mHeights.size());
+
+	if (settings.KeepHorizons)
+	{
+		mHorizons.resize(mHeights.size() * mDirections);
+	}
+	else
+	{
+		mHorizons.clear();
+		mHorizons.shrink_to_fit();
+	}
+
+	sweep_direction sweep;
+
+	// A sample lies on one line per direction and directions run one
+	// after another, so sums do not depend on the thread count
+	for (uint32_t d = 0; d < mDirections; d++)
+	{
+		const float angle = DirectX::XM_2PI * (float)d / (float)mDirections;
+		SetupDirection(angle, sweep);
+
+		sweep_output output = { };
+		output.pOpenSky = sweep.RowMajor ? mOpenSky.data() : mOpenSkyT.data();
+		if (settings.KeepHorizons)
+		{
+			output.pHorizons = &mHorizons[static_cast<size_t>(d) * mHeights.size()];
+		}
+
+		SweepDirection(sweep, output, pPool);
+	}
+
+	// Transposed sums are read in tiles, a whole column per row would
+	// miss the cache on every sample
+	const float scale = 255.0f / (float)mDirections;
+	for (UINT tileRow = 0; tileRow < mLayout.Depth; tileRow += TERRAIN_HORIZON_TILE)
+	{
+		const UINT endRow = (std::min)(tileRow + TERRAIN_HORIZON_TILE, mLayout.Depth);
+
+		for (UINT tileCol = 0; tileCol < mLayout.Width; tileCol += TERRAIN_HORIZON_TILE)
+		{
+			const UINT endCol = (std::min)(tileCol + TERRAIN_HORIZON_TILE, mLayout.Width);
+
+			for (UINT row = tileRow; row < endRow; row++)
+			{
+				for (UINT col = tileCol; col < endCol; col++)
+				{
+					const size_t index = static_cast<size_t>(row) * mLayout.Width + col;
+					const float openSky = mOpenSky[index] +
+						mOpenSkyT[static_cast<size_t>(col) * mLayout.Depth + row];
+
+					float value = (std::min)(openSky * scale, 255.0f);
+					mOcclusion[index] = (uint8_t)(value + 0.5f);
+				}
+			}
+		}
+	}
+}
+
+void TerrainHorizonBaker::WriteOcclusion(HeightmapImage& image) const
+{
+	for (UINT row = 0; row < mLayout.Depth; row++)
+	{
+		const uint8_t* pSrc = &mOcclusion[static_cast<size_t>(row) * mLayout.Width];
+		uint8_t* pRow = image.GetWritableRow(row);
+
+		std::copy(pSrc, pSrc + mLayout.Width, pRow);
+	}
+}
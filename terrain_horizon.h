@@ -0,0 +1,120 @@
+/*****************************************************************//**
+ * \file   terrain_horizon.h
+ * \brief  Horizon angles and ambient occlusion of heightmaps
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_mesh.h"
+#include "thread_pool.h"
+
+// Neighbouring sweep lines walked in step as one parallel work item,
+// so that every step reads a run of samples
+#define TERRAIN_HORIZON_LINE_GROUP 64
+
+struct TerrainHorizonSettings
+{
+	uint32_t Directions = 16;		// Azimuths sampled, evenly spaced
+	bool KeepHorizons = false;		// Store the horizon of every direction, not only the occlusion
+};
+
+/**
+ * Bakes the horizon of every heightmap sample in a number of directions
+ * and the ambient occlusion derived from them.
+ *
+ * Each direction is swept along parallel digital lines. A line is walked
+ * from its far end while keeping the upper convex hull of the samples
+ * already passed, the horizon of the next sample is its tangent to the
+ * hull. This costs amortized O(1) per sample and direction instead of
+ * a ray march. Lines are independent and spread over the pool, results
+ * are the same for any number of threads.
+ *
+ * Lines close to the columns would read samples a row apart in step,
+ * so those directions read a transposed copy of the heights.
+ *
+ * Occlusion is the cosine-weighted part of the sky above the horizon,
+ * averaged over the directions: 255 - open sky, 0 - fully occluded.
+ * Horizons are stored as sin of the elevation angle, 0 - 255.
+ */
+class TerrainHorizonBaker
+{
+public:
+	// The heightmap may be in either layout, only its heights are kept
+	TerrainHorizonBaker(HeightmapImage& heightmap);
+
+	TerrainHorizonBaker(TerrainHorizonBaker& other) = delete;
+
+	// Runs over pPool, nullptr runs serially
+	void Bake(const TerrainHorizonSettings& settings, WorkerPool* pPool);
+
+	// Width x Height occlusion, row after row
+	const uint8_t* GetOcclusion() const { return mOcclusion.data(); }
+
+	// Horizons towards direction (angle 2 pi * direction / Directions,
+	// measured from +X towards -Z), nullptr unless KeepHorizons was set
+	const uint8_t* GetHorizons(uint32_t direction) const;
+
+	// Horizon of every sample towards any angle, as the tangent of its
+	// elevation (0 and up), row after row
+	void BakeDirection(float angle, std::vector<float>& tangents, WorkerPool* pPool);
+
+	// Occlusion as an 8-bit image of the heightmap size
+	void WriteOcclusion(HeightmapImage& image) const;
+
+	uint32_t GetWidth() const { return mLayout.Width; }
+	uint32_t GetHeight() const { return mLayout.Depth; }
+	uint32_t GetDirections() const { return mDirections; }
+
+private:
+	// Lines advance one sample along the major axis per step and drift
+	// along the minor one. Fields are read in the layout where the minor
+	// axis is contiguous.
+	struct sweep_direction
+	{
+		bool RowMajor;				// Lines advance along rows, otherwise fields are transposed
+		int Step;					// +1 or -1, order along the major axis
+		uint32_t MajorCount;
+		uint32_t MinorCount;
+		float MajorDistance;		// Distance along the direction of one step along each axis
+		float MinorDistance;
+		std::vector<int> Offsets;	// Minor offset of the line at every major index
+		int FirstLine;				// Lines are [FirstLine, EndLine) in minor units
+		int EndLine;
+	};
+
+	// Results written by a sweep, nullptr ones are skipped
+	struct sweep_output
+	{
+		float* pOpenSky;			// Summed, layout of the sweep
+		float* pTangents;			// Layout of the sweep
+		uint8_t* pHorizons;			// Row after row
+	};
+
+	void SetupDirection(float angle, sweep_direction& sweep) const;
+	void SweepDirection(const sweep_direction& sweep, const sweep_output& output, WorkerPool* pPool);
+	void SweepLines(const sweep_direction& sweep, const sweep_output& output, int firstLine, int endLine,
+		std::unique_ptr<float[]>& hull, std::vector<uint32_t>& hullSize);
+
+	TerrainLayout mLayout;
+	uint32_t mDirections = 0;
+
+	// World heights row after row and column after column
+	std::vector<float> mHeights;
+	std::vector<float> mHeightsT;
+
+	// Occlusion summed over the directions swept in each layout
+	std::vector<float> mOpenSky;
+	std::vector<float> mOpenSkyT;
+	std::vector<float> mScratch;			// Transposed single direction results
+
+	std::vector<uint8_t> mOcclusion;
+	std::vector<uint8_t> mHorizons;			// Direction after direction, row after row
+};
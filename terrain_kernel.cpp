@@ -0,0 +1,167 @@
+/*****************************************************************//**
+ * \file   terrain_kernel.cpp
+ * \brief  Vectorised heightmap row kernel
+ *
+ * Every path evaluates the same expressions in the same order,
+ * without FMA or approximate reciprocals, so that the terrain mesh
+ * does not depend on the CPU it was generated on.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cmath>
+#include <cstring>
+
+#include "terrain_kernel.h"
+
+// Normal of the surface is (-2 dz dh/drow, 4 dx dz, -2 dx dh/dcol),
+// coefficients are evaluated once per row
+struct normal_coefficients
+{
+	float x;
+	float y;
+	float z;
+
+	normal_coefficients(float dx, float dz)
+	{
+		x = -2 * dz;
+		y = 4 * dx * dz;
+		z = -2 * dx;
+	}
+};
+
+static void compute_row_scalar(const uint8_t* pPrev, const uint8_t* pRow, const uint8_t* pNext,
+	uint32_t begin, uint32_t count, const normal_coefficients& c,
+	float* pHeight, float* pNormalX, float* pNormalY, float* pNormalZ)
+{
+	// Neighbours along the row
+	const uint8_t* pLeft = pRow - 1;
+	const uint8_t* pRight = pRow + 1;
+
+	for (uint32_t k = begin; k < count; k++)
+	{
+		float dhRow = ((float)pNext[k] - (float)pPrev[k]) * TERRAIN_HEIGHT_SCALE;
+		float dhCol = ((float)pRight[k] - (float)pLeft[k]) * TERRAIN_HEIGHT_SCALE;
+
+		float nx = c.x * dhRow;
+		float ny = c.y;
+		float nz = c.z * dhCol;
+
+		float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+		pHeight[k] = (float)pRow[k] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+		pNormalX[k] = nx / length;
+		pNormalY[k] = ny / length;
+		pNormalZ[k] = nz / length;
+	}
+}
+
+#if SIMD_X86
+
+// Converts 4 samples to floats
+SIMD_TARGET_SSE41 static inline __m128 load4_u8(const uint8_t* p)
+{
+	int packed;
+	memcpy(&packed, p, sizeof(packed));
+	return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+}
+
+SIMD_TARGET_SSE41 static uint32_t compute_row_sse41(const uint8_t* pPrev, const uint8_t* pRow, const uint8_t* pNext,
+	uint32_t count, const normal_coefficients& c,
+	float* pHeight, float* pNormalX, float* pNormalY, float* pNormalZ)
+{
+	const __m128 scale = _mm_set1_ps(TERRAIN_HEIGHT_SCALE);
+	const __m128 offset = _mm_set1_ps(TERRAIN_HEIGHT_OFFSET);
+	const __m128 cx = _mm_set1_ps(c.x);
+	const __m128 ny = _mm_set1_ps(c.y);
+	const __m128 cz = _mm_set1_ps(c.z);
+	const __m128 ny2 = _mm_mul_ps(ny, ny);
+
+	const uint8_t* pLeft = pRow - 1;
+	const uint8_t* pRight = pRow + 1;
+
+	uint32_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		__m128 h = load4_u8(pRow + k);
+		__m128 dhRow = _mm_mul_ps(_mm_sub_ps(load4_u8(pNext + k), load4_u8(pPrev + k)), scale);
+		__m128 dhCol = _mm_mul_ps(_mm_sub_ps(load4_u8(pRight + k), load4_u8(pLeft + k)), scale);
+
+		__m128 nx = _mm_mul_ps(cx, dhRow);
+		__m128 nz = _mm_mul_ps(cz, dhCol);
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), ny2), _mm_mul_ps(nz, nz)));
+
+		_mm_storeu_ps(pHeight + k, _mm_add_ps(_mm_mul_ps(h, scale), offset));
+		_mm_storeu_ps(pNormalX + k, _mm_div_ps(nx, length));
+		_mm_storeu_ps(pNormalY + k, _mm_div_ps(ny, length));
+		_mm_storeu_ps(pNormalZ + k, _mm_div_ps(nz, length));
+	}
+	return k;
+}
+
+// Converts 8 samples to floats
+SIMD_TARGET_AVX2 static inline __m256 load8_u8(const uint8_t* p)
+{
+	return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p)));
+}
+
+SIMD_TARGET_AVX2 static uint32_t compute_row_avx2(const uint8_t* pPrev, const uint8_t* pRow, const uint8_t* pNext,
+	uint32_t count, const normal_coefficients& c,
+	float* pHeight, float* pNormalX, float* pNormalY, float* pNormalZ)
+{
+	const __m256 scale = _mm256_set1_ps(TERRAIN_HEIGHT_SCALE);
+	const __m256 offset = _mm256_set1_ps(TERRAIN_HEIGHT_OFFSET);
+	const __m256 cx = _mm256_set1_ps(c.x);
+	const __m256 ny = _mm256_set1_ps(c.y);
+	const __m256 cz = _mm256_set1_ps(c.z);
+	const __m256 ny2 = _mm256_mul_ps(ny, ny);
+
+	const uint8_t* pLeft = pRow - 1;
+	const uint8_t* pRight = pRow + 1;
+
+	// 8 normals per iteration
+	uint32_t k = 0;
+	for (; k + 8 <= count; k += 8)
+	{
+		__m256 h = load8_u8(pRow + k);
+		__m256 dhRow = _mm256_mul_ps(_mm256_sub_ps(load8_u8(pNext + k), load8_u8(pPrev + k)), scale);
+		__m256 dhCol = _mm256_mul_ps(_mm256_sub_ps(load8_u8(pRight + k), load8_u8(pLeft + k)), scale);
+
+		__m256 nx = _mm256_mul_ps(cx, dhRow);
+		__m256 nz = _mm256_mul_ps(cz, dhCol);
+
+		__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), ny2), _mm256_mul_ps(nz, nz)));
+
+		_mm256_storeu_ps(pHeight + k, _mm256_add_ps(_mm256_mul_ps(h, scale), offset));
+		_mm256_storeu_ps(pNormalX + k, _mm256_div_ps(nx, length));
+		_mm256_storeu_ps(pNormalY + k, _mm256_div_ps(ny, length));
+		_mm256_storeu_ps(pNormalZ + k, _mm256_div_ps(nz, length));
+	}
+	return k;
+}
+
+#endif
+
+void ComputeTerrainRow(const uint8_t* pPrev, const uint8_t* pRow, const uint8_t* pNext,
+	uint32_t count, float dx, float dz,
+	float* pHeight, float* pNormalX, float* pNormalY, float* pNormalZ,
+	SIMD_LEVEL level)
+{
+	normal_coefficients c(dx, dz);
+	uint32_t done = 0;
+
+#if SIMD_X86
+	if (level >= SIMD_LEVEL_AVX2)
+	{
+		done = compute_row_avx2(pPrev, pRow, pNext, count, c, pHeight, pNormalX, pNormalY, pNormalZ);
+	}
+	else if (level >= SIMD_LEVEL_SSE41)
+	{
+		done = compute_row_sse41(pPrev, pRow, pNext, count, c, pHeight, pNormalX, pNormalY, pNormalZ);
+	}
+#endif
+
+	// Remaining samples
+	compute_row_scalar(pPrev, pRow, pNext, done, count, c, pHeight, pNormalX, pNormalY, pNormalZ);
+}
@@ -0,0 +1,30 @@
+/*****************************************************************//**
+ * \file   terrain_kernel.h
+ * \brief  Vectorised heightmap row kernel
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+
+#include "simd_util.h"
+
+// World height of a heightmap sample s is s * SCALE + OFFSET
+#define TERRAIN_HEIGHT_SCALE (1.0f / 128.0f)
+#define TERRAIN_HEIGHT_OFFSET (-5.5f)
+
+/**
+ * Computes heights and unit normals for count consecutive samples
+ * of a heightmap row. pRow points to the first sample, pPrev and pNext
+ * to the same column in the neighbouring rows. Samples pRow[-1] and
+ * pRow[count] are read for the gradient along the row.
+ *
+ * dx is the world distance between rows, dz between columns.
+ * All SIMD levels produce bit-identical results.
+ */
+void ComputeTerrainRow(const uint8_t* pPrev, const uint8_t* pRow, const uint8_t* pNext,
+	uint32_t count, float dx, float dz,
+	float* pHeight, float* pNormalX, float* pNormalY, float* pNormalZ,
+	SIMD_LEVEL level = GetSimdLevel());
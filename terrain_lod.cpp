@@ -0,0 +1,250 @@
+/*****************************************************************//**
+ * \file   terrain_lod.cpp
+ * \brief  CDLOD quadtree and per-frame LOD selection for terrain
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cfloat>
+
+#include "terrain_lod.h"
+
+using namespace DirectX;
+
+TerrainQuadtree::TerrainQuadtree(const float* pHeights, const TerrainLayout& layout,
+	const TerrainLodSettings& settings) :
+	mLayout(layout), mSettings(settings)
+{
+	const UINT gridCols = layout.GridColumns();
+	const UINT quadRows = layout.GridRows() - 1;
+	const UINT quadCols = layout.GridColumns() - 1;
+
+	mLevels.resize(settings.LodCount);
+
+	for (UINT lod = 0; lod < settings.LodCount; lod++)
+	{
+		lod_level& level = mLevels[lod];
+		level.NodeSize = settings.LeafQuads << lod;
+		level.NodeRows = (quadRows + level.NodeSize - 1) / level.NodeSize;
+		level.NodeCols = (quadCols + level.NodeSize - 1) / level.NodeSize;
+		level.MinHeight.resize(static_cast<size_t>(level.NodeRows) * level.NodeCols);
+		level.MaxHeight.resize(level.MinHeight.size());
+
+		for (UINT r = 0; r < level.NodeRows; r++)
+		{
+			for (UINT c = 0; c < level.NodeCols; c++)
+			{
+				float minHeight = FLT_MAX;
+				float maxHeight = -FLT_MAX;
+
+				if (lod == 0)
+				{
+					// Leaves take bounds from the vertices they cover
+					UINT lastRow = (std::min)((r + 1) * level.NodeSize, quadRows);
+					UINT lastCol = (std::min)((c + 1) * level.NodeSize, quadCols);
+
+					for (UINT gr = r * level.NodeSize; gr <= lastRow; gr++)
+					{
+						for (UINT gc = c * level.NodeSize; gc <= lastCol; gc++)
+						{
+							float h = pHeights[static_cast<size_t>(gr) * gridCols + gc];
+							minHeight = (std::min)(minHeight, h);
+							maxHeight = (std::max)(maxHeight, h);
+						}
+					}
+				}
+				else
+				{
+					// Parents merge their children
+					const lod_level& child = mLevels[lod - 1];
+					for (UINT cr = 2 * r; cr < (std::min)(2 * r + 2, child.NodeRows); cr++)
+					{
+						for (UINT cc = 2 * c; cc < (std::min)(2 * c + 2, child.NodeCols); cc++)
+						{
+							size_t index = static_cast<size_t>(cr) * child.NodeCols + cc;
+							minHeight = (std::min)(minHeight, child.MinHeight[index]);
+							maxHeight = (std::max)(maxHeight, child.MaxHeight[index]);
+						}
+					}
+				}
+
+				level.MinHeight[static_cast<size_t>(r) * level.NodeCols + c] = minHeight;
+				level.MaxHeight[static_cast<size_t>(r) * level.NodeCols + c] = maxHeight;
+			}
+		}
+	}
+
+	// Visibility and morph ranges
+	mRanges.resize(settings.LodCount);
+	mMorphStart.resize(settings.LodCount);
+
+	float range = settings.DetailDistance;
+	float previous = 0.0f;
+	for (UINT lod = 0; lod < settings.LodCount; lod++)
+	{
+		mRanges[lod] = range;
+		mMorphStart[lod] = previous + (range - previous) * settings.MorphStartRatio;
+
+		previous = range;
+		range *= settings.LodDistanceRatio;
+	}
+}
+
+BoundingBoxAA TerrainQuadtree::GetNodeBox(UINT lod, UINT nodeRow, UINT nodeCol) const
+{
+	const lod_level& level = mLevels[lod];
+
+	UINT firstRow = nodeRow * level.NodeSize;
+	UINT firstCol = nodeCol * level.NodeSize;
+	UINT lastRow = (std::min)(firstRow + level.NodeSize, mLayout.GridRows() - 1);
+	UINT lastCol = (std::min)(firstCol + level.NodeSize, mLayout.GridColumns() - 1);
+
+	size_t index = static_cast<size_t>(nodeRow) * level.NodeCols + nodeCol;
+
+	// Grid vertex (row, col) lies at heightmap sample (row + 1, col + 1),
+	// Z decreases with column
+	BoundingBoxAA box;
+	box.Min = XMFLOAT3(mLayout.WorldX(firstRow + 1), level.MinHeight[index], mLayout.WorldZ(lastCol + 1));
+	box.Max = XMFLOAT3(mLayout.WorldX(lastRow + 1), level.MaxHeight[index], mLayout.WorldZ(firstCol + 1));
+	return box;
+}
+
+void TerrainQuadtree::Select(const XMFLOAT3& eye, const Frustum& frustum,
+	std::vector<TerrainLodDraw>& draws) const
+{
+	draws.clear();
+
+	const UINT top = mSettings.LodCount - 1;
+	for (UINT r = 0; r < mLevels[top].NodeRows; r++)
+	{
+		for (UINT c = 0; c < mLevels[top].NodeCols; c++)
+		{
+			// Nodes beyond the coarsest range are not drawn
+			SelectNode(top, r, c, eye, frustum, draws);
+		}
+	}
+}
+
+// Returns false if the node is out of range of its LOD, in which case
+// the parent covers its area. Culled nodes count as handled.
+bool TerrainQuadtree::SelectNode(UINT lod, UINT nodeRow, UINT nodeCol,
+	const XMFLOAT3& eye, const Frustum& frustum,
+	std::vector<TerrainLodDraw>& draws) const
+{
+	BoundingBoxAA box = GetNodeBox(lod, nodeRow, nodeCol);
+	float distanceSq = DistanceSquared(box, eye);
+
+	if (distanceSq > mRanges[lod] * mRanges[lod]) return false;
+	if (!frustum.IntersectsBox(box)) return true;
+
+	// Finest level, or no part of the node needs more detail
+	if (lod == 0 || distanceSq > mRanges[lod - 1] * mRanges[lod - 1])
+	{
+		AddDraw(lod, nodeRow, nodeCol, -1, draws);
+		return true;
+	}
+
+	const lod_level& child = mLevels[lod - 1];
+	bool handled[4] = { };
+	for (int q = 0; q < 4; q++)
+	{
+		UINT childRow = 2 * nodeRow + (q >> 1);
+		UINT childCol = 2 * nodeCol + (q & 1);
+
+		// Children outside the grid have nothing to draw
+		if (childRow >= child.NodeRows || childCol >= child.NodeCols)
+		{
+			handled[q] = true;
+			continue;
+		}
+
+		handled[q] = SelectNode(lod - 1, childRow, childCol, eye, frustum, draws);
+	}
+
+	// Quadrants whose children are too far are drawn at this LOD
+	if (!handled[0] && !handled[1] && !handled[2] && !handled[3])
+	{
+		AddDraw(lod, nodeRow, nodeCol, -1, draws);
+		return true;
+	}
+
+	for (int q = 0; q < 4; q++)
+	{
+		if (!handled[q]) AddDraw(lod, nodeRow, nodeCol, q, draws);
+	}
+	return true;
+}
+
+void TerrainQuadtree::AddDraw(UINT lod, UINT nodeRow, UINT nodeCol, int quadrant,
+	std::vector<TerrainLodDraw>& draws) const
+{
+	const lod_level& level = mLevels[lod];
+
+	TerrainLodDraw draw;
+	draw.FirstRow = nodeRow * level.NodeSize;
+	draw.FirstCol = nodeCol * level.NodeSize;
+	draw.Size = level.NodeSize;
+	draw.Lod = lod;
+	draw.Quadrant = quadrant;
+	draw.MorphStart = mMorphStart[lod];
+	draw.MorphEnd = mRanges[lod];
+
+	draws.push_back(draw);
+}
+
+size_t TerrainQuadtree::CountTriangles(const std::vector<TerrainLodDraw>& draws) const
+{
+	const size_t patchTriangles = 2 * static_cast<size_t>(mSettings.LeafQuads) * mSettings.LeafQuads;
+
+	size_t triangles = 0;
+	for (const TerrainLodDraw& draw : draws)
+	{
+		triangles += draw.Quadrant < 0 ? patchTriangles : patchTriangles / 4;
+	}
+	return triangles;
+}
+
+void BuildTerrainLodPatch(UINT quads, std::vector<Vertex>& vertices, std::vector<uint16_t>& indices)
+{
+	const UINT n = quads + 1;
+	const UINT half = quads / 2;
+	const float step = 1.0f / quads;
+
+	vertices.clear();
+	indices.clear();
+	vertices.reserve(static_cast<size_t>(n) * n);
+	indices.reserve(static_cast<size_t>(quads) * quads * 6);
+
+	// Column after column, like terrain chunks
+	for (UINT c = 0; c < n; c++)
+	{
+		for (UINT r = 0; r < n; r++)
+		{
+			float u = r * step;
+			float v = c * step;
+			vertices.push_back(Vertex{ { u, 0.0f, v }, { 0.0f, 1.0f, 0.0f }, { u, v } });
+		}
+	}
+
+	// Quadrant q covers rows [(q >> 1) * half, ...) and columns [(q & 1) * half, ...)
+	for (UINT q = 0; q < 4; q++)
+	{
+		UINT firstRow = (q >> 1) * half;
+		UINT firstCol = (q & 1) * half;
+
+		for (UINT c = firstCol; c < firstCol + half; c++)
+		{
+			for (UINT r = firstRow; r < firstRow + half; r++)
+			{
+				indices.push_back(static_cast<uint16_t>(r + c * n));
+				indices.push_back(static_cast<uint16_t>((r + 1) + c * n));
+				indices.push_back(static_cast<uint16_t>(r + (c + 1) * n));
+
+				indices.push_back(static_cast<uint16_t>((r + 1) + c * n));
+				indices.push_back(static_cast<uint16_t>((r + 1) + (c + 1) * n));
+				indices.push_back(static_cast<uint16_t>(r + (c + 1) * n));
+			}
+		}
+	}
+}
@@ -0,0 +1,97 @@
+/*****************************************************************//**
+ * \file   terrain_lod.h
+ * \brief  CDLOD quadtree and per-frame LOD selection for terrain
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "frustum.h"
+#include "structures.h"
+#include "terrain_mesh.h"
+
+struct TerrainLodSettings
+{
+	UINT LeafQuads = 32;			// Quads along the side of a leaf node and of the patch
+	UINT LodCount = 6;				// Number of quadtree levels
+	float DetailDistance = 24.0f;	// Visibility range of LOD 0
+	float LodDistanceRatio = 2.0f;	// Ratio between ranges of neighbouring LODs
+	float MorphStartRatio = 0.66f;	// Part of the LOD range where morphing starts
+};
+
+/**
+ * One instance of the shared patch. The patch is scaled to Size grid
+ * quads and placed at (FirstRow, FirstCol) of the terrain vertex grid.
+ * Nodes on the far border may reach past the grid, the renderer clamps
+ * heightmap coordinates there.
+ */
+struct TerrainLodDraw
+{
+	UINT FirstRow = 0;
+	UINT FirstCol = 0;
+	UINT Size = 0;
+	UINT Lod = 0;
+	int Quadrant = -1;				// -1 whole patch, 0..3 one quadrant (row half * 2 + col half)
+	float MorphStart = 0.0f;		// Distance at which vertices start morphing to LOD + 1
+	float MorphEnd = 0.0f;			// Distance at which vertices are fully morphed
+};
+
+/**
+ * Quadtree over the terrain vertex grid, every node stores min/max height.
+ * Select walks the tree from the coarsest LOD and picks nodes whose
+ * resolution matches their distance to the camera (Strugar, CDLOD).
+ */
+class TerrainQuadtree
+{
+public:
+	// pHeights holds GridRows() x GridColumns() heights, row after row
+	TerrainQuadtree(const float* pHeights, const TerrainLayout& layout,
+		const TerrainLodSettings& settings = TerrainLodSettings());
+
+	// Fills draws with nodes visible from eye. The list is cleared first
+	void Select(const DirectX::XMFLOAT3& eye, const Frustum& frustum,
+		std::vector<TerrainLodDraw>& draws) const;
+
+	// World bounds of the node
+	BoundingBoxAA GetNodeBox(UINT lod, UINT nodeRow, UINT nodeCol) const;
+
+	// Number of triangles rendered for the draw list
+	size_t CountTriangles(const std::vector<TerrainLodDraw>& draws) const;
+
+	float GetVisibilityRange(UINT lod) const { return mRanges[lod]; }
+	const TerrainLodSettings& GetSettings() const { return mSettings; }
+
+private:
+	struct lod_level
+	{
+		UINT NodeSize = 0;			// Grid quads along the side of a node
+		UINT NodeRows = 0;
+		UINT NodeCols = 0;
+		std::vector<float> MinHeight;
+		std::vector<float> MaxHeight;
+	};
+
+	bool SelectNode(UINT lod, UINT nodeRow, UINT nodeCol,
+		const DirectX::XMFLOAT3& eye, const Frustum& frustum,
+		std::vector<TerrainLodDraw>& draws) const;
+	void AddDraw(UINT lod, UINT nodeRow, UINT nodeCol, int quadrant,
+		std::vector<TerrainLodDraw>& draws) const;
+
+	TerrainLayout mLayout;
+	TerrainLodSettings mSettings;
+
+	std::vector<lod_level> mLevels;
+	std::vector<float> mRanges;
+	std::vector<float> mMorphStart;
+};
+
+// Builds the shared (quads + 1)^2 patch over [0, 1]^2. Pos.x runs along
+// grid rows and Pos.z along grid columns, with the same winding as the
+// terrain chunks. Indices are grouped by quadrant, quadrant q occupies
+// indices [q * n / 4, (q + 1) * n / 4). quads must be even.
+void BuildTerrainLodPatch(UINT quads, std::vector<Vertex>& vertices, std::vector<uint16_t>& indices);
@@ -0,0 +1,215 @@
+/*****************************************************************//**
+ * \file   terrain_mesh.cpp
+ * \brief  Heightmap to terrain mesh conversion helpers
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <string>
+
+#include "terrain_mesh.h"
+#include "image_helper.h"
+#include "terrain_kernel.h"
+#include "thread_pool.h"
+
+TerrainLayout::TerrainLayout(UINT width, UINT depth)
+{
+	Width = width;
+	Depth = depth;
+
+	Dx = (float)width / static_cast<float>(width - 1);
+	Dz = (float)depth / static_cast<float>(depth - 1);
+
+	ZeroX = -(float)width / 2;
+	ZeroZ = (float)depth / 2;
+}
+
+DirectX::XMFLOAT4 TerrainLayout::MapTransform() const
+{
+	// Texel centres: u = (col + 0.5) / Width, v = (row + 0.5) / Depth
+	return DirectX::XMFLOAT4(
+		-1.0f / (Dz * Width),
+		1.0f / (Dx * Depth),
+		(ZeroZ / Dz + 0.5f) / Width,
+		(0.5f - ZeroX / Dx) / Depth);
+}
+
+TerrainChunk TerrainLayout::GetChunk(UINT chunkCol, UINT chunkRow) const
+{
+	TerrainChunk chunk = { };
+	chunk.FirstCol = chunkCol * TERRAIN_CHUNK_QUADS;
+	chunk.FirstRow = chunkRow * TERRAIN_CHUNK_QUADS;
+
+	// Last grid vertex covered by the chunk, inclusive
+	UINT lastCol = (std::min)(chunk.FirstCol + TERRAIN_CHUNK_QUADS, GridColumns() - 1);
+	UINT lastRow = (std::min)(chunk.FirstRow + TERRAIN_CHUNK_QUADS, GridRows() - 1);
+
+	chunk.NumCols = lastCol - chunk.FirstCol + 1;
+	chunk.NumRows = lastRow - chunk.FirstRow + 1;
+
+	return chunk;
+}
+
+void WriteTerrainVertices(HeightmapImage& heightmap, const TerrainLayout& layout,
+	const TerrainChunk& chunk, UINT colBegin, UINT colEnd, Vertex* pVertices)
+{
+	WriteTerrainVertices(heightmap.GetRow(chunk.FirstRow) + chunk.FirstCol, heightmap.GetRowPitch(),
+		layout, chunk, colBegin, colEnd, pVertices);
+}
+
+void WriteTerrainVertices(const uint8_t* pWindow, size_t rowPitch, const TerrainLayout& layout,
+	const TerrainChunk& chunk, UINT colBegin, UINT colEnd, Vertex* pVertices)
+{
+	// Heightmap column of the first vertex column.
+	// Grid vertex (g, h) samples heightmap at (g + 1, h + 1)
+	UINT firstCol = chunk.FirstCol + colBegin + 1;
+	UINT count = colEnd - colBegin;
+
+	// One heightmap row of the band at a time
+	float heights[TERRAIN_CHUNK_QUADS + 1];
+	float normalsX[TERRAIN_CHUNK_QUADS + 1];
+	float normalsY[TERRAIN_CHUNK_QUADS + 1];
+	float normalsZ[TERRAIN_CHUNK_QUADS + 1];
+
+	for (UINT r = 0; r < chunk.NumRows; r++)
+	{
+		const uint8_t* pRow = pWindow + static_cast<size_t>(r + 1) * rowPitch + colBegin + 1;
+
+		ComputeTerrainRow(pRow - rowPitch, pRow, pRow + rowPitch,
+			count, layout.Dx, layout.Dz,
+			heights, normalsX, normalsY, normalsZ);
+
+		float x = layout.WorldX(chunk.FirstRow + r + 1);
+
+		// Vertices are stored column after column
+		for (UINT k = 0; k < count; k++)
+		{
+			float z = layout.WorldZ(firstCol + k);
+
+			pVertices[static_cast<size_t>(k) * chunk.NumRows + r] = Vertex{
+				{ x, heights[k], z },
+				{ normalsX[k], normalsY[k], normalsZ[k] },
+				{ 0.05f * x, 0.05f * z } };
+		}
+	}
+}
+
+void WriteTerrainIndices(const TerrainChunk& chunk, UINT colBegin, UINT colEnd,
+	uint16_t* pIndices)
+{
+	UINT n = chunk.NumRows;
+
+	for (UINT i = colBegin; i < colEnd; i++)
+	{
+		for (UINT j = 0; j < chunk.NumRows - 1; j++)
+		{
+			// Generate indices for quad down and to the right
+			*pIndices++ = static_cast<uint16_t>(j + i * n);
+			*pIndices++ = static_cast<uint16_t>((j + 1) + i * n);
+			*pIndices++ = static_cast<uint16_t>(j + (i + 1) * n);
+
+			*pIndices++ = static_cast<uint16_t>((j + 1) + i * n);
+			*pIndices++ = static_cast<uint16_t>((j + 1) + (i + 1) * n);
+			*pIndices++ = static_cast<uint16_t>(j + (i + 1) * n);
+		}
+	}
+}
+
+void BuildTerrainChunk(HeightmapImage& heightmap, const TerrainLayout& layout,
+	UINT chunkCol, UINT chunkRow,
+	std::vector<Vertex>& vertices, std::vector<uint16_t>& indices)
+{
+	TerrainChunk chunk = layout.GetChunk(chunkCol, chunkRow);
+
+	vertices.resize(chunk.VertexCount());
+	indices.resize(chunk.IndexCount());
+
+	WriteTerrainVertices(heightmap, layout, chunk, 0, chunk.NumCols, vertices.data());
+	WriteTerrainIndices(chunk, 0, chunk.NumCols - 1, indices.data());
+}
+
+void BuildTerrainMesh(HeightmapImage& heightmap, const TerrainLayout& layout,
+	TerrainMeshData& mesh, WorkerPool* pPool)
+{
+	// Lay out chunks in the output buffers
+	mesh.Chunks.clear();
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+
+	for (UINT chunkCol = 0; chunkCol < layout.ChunkColumns(); chunkCol++)
+	{
+		for (UINT chunkRow = 0; chunkRow < layout.ChunkRows(); chunkRow++)
+		{
+			TerrainChunk chunk = layout.GetChunk(chunkCol, chunkRow);
+			chunk.BaseVertex = vertexCount;
+			chunk.StartIndex = indexCount;
+
+			vertexCount += chunk.VertexCount();
+			indexCount += chunk.IndexCount();
+
+			mesh.Chunks.push_back(chunk);
+		}
+	}
+
+	// Allocate once, bands write to disjoint ranges
+	mesh.Vertices.resize(vertexCount);
+	mesh.Indices.resize(indexCount);
+
+	// Work item k is band (k % bandsPerChunk) of chunk (k / bandsPerChunk)
+	const UINT bandsPerChunk = (TERRAIN_CHUNK_QUADS + TERRAIN_BAND_COLUMNS) / TERRAIN_BAND_COLUMNS;
+	const UINT itemCount = static_cast<UINT>(mesh.Chunks.size()) * bandsPerChunk;
+
+	auto buildBands = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t item = begin; item < end; item++)
+		{
+			const TerrainChunk& chunk = mesh.Chunks[item / bandsPerChunk];
+
+			UINT colBegin = (item % bandsPerChunk) * TERRAIN_BAND_COLUMNS;
+			if (colBegin >= chunk.NumCols) continue;
+			UINT colEnd = (std::min)(colBegin + TERRAIN_BAND_COLUMNS, chunk.NumCols);
+
+			WriteTerrainVertices(heightmap, layout, chunk, colBegin, colEnd,
+				&mesh.Vertices[chunk.BaseVertex + static_cast<size_t>(colBegin) * chunk.NumRows]);
+
+			// Last vertex column has no quads to the right
+			UINT quadEnd = (std::min)(colEnd, chunk.NumCols - 1);
+			if (colBegin < quadEnd)
+			{
+				WriteTerrainIndices(chunk, colBegin, quadEnd,
+					&mesh.Indices[chunk.StartIndex + static_cast<size_t>(colBegin) * (chunk.NumRows - 1) * 6]);
+			}
+		}
+	};
+
+	if (pPool)
+	{
+		pPool->ParallelFor(itemCount, 1, buildBands);
+	}
+	else
+	{
+		buildBands(0, itemCount);
+	}
+}
+
+void ExtractTerrainHeights(HeightmapImage& heightmap, const TerrainLayout& layout,
+	std::vector<float>& heights)
+{
+	const UINT gridRows = layout.GridRows();
+	const UINT gridCols = layout.GridColumns();
+
+	heights.resize(static_cast<size_t>(gridRows) * gridCols);
+
+	for (UINT g = 0; g < gridRows; g++)
+	{
+		const uint8_t* pRow = heightmap.GetRow(g + 1) + 1;
+		float* pOut = &heights[static_cast<size_t>(g) * gridCols];
+
+		for (UINT h = 0; h < gridCols; h++)
+		{
+			pOut[h] = TerrainLayout::SampleHeight(pRow[h]);
+		}
+	}
+}
@@ -0,0 +1,139 @@
+/*****************************************************************//**
+ * \file   terrain_mesh.h
+ * \brief  Heightmap to terrain mesh conversion helpers
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "structures.h"
+#include "terrain_kernel.h"
+
+class HeightmapImage;
+class WorkerPool;
+
+// Number of quads along one side of a terrain chunk.
+// (TERRAIN_CHUNK_QUADS + 1)^2 vertices must fit into 16-bit indices.
+#define TERRAIN_CHUNK_QUADS 128
+
+// Number of vertex columns processed as one parallel work item
+#define TERRAIN_BAND_COLUMNS 16
+
+/**
+ * Part of the vertex grid stored as one submesh.
+ */
+struct TerrainChunk
+{
+	UINT FirstCol = 0;			// First grid column covered by the chunk
+	UINT FirstRow = 0;			// First grid row covered by the chunk
+	UINT NumCols = 0;			// Number of vertex columns
+	UINT NumRows = 0;			// Number of vertex rows
+
+	size_t BaseVertex = 0;		// Offset in TerrainMeshData::Vertices
+	size_t StartIndex = 0;		// Offset in TerrainMeshData::Indices
+
+	size_t VertexCount() const { return static_cast<size_t>(NumCols) * NumRows; }
+	size_t IndexCount() const { return static_cast<size_t>(NumCols - 1) * (NumRows - 1) * 6; }
+};
+
+// Half-open rectangle of heightmap samples, e.g. the part changed by an edit
+struct TerrainDirtyRect
+{
+	UINT FirstRow = 0;
+	UINT FirstCol = 0;
+	UINT EndRow = 0;
+	UINT EndCol = 0;
+
+	bool Empty() const { return FirstRow >= EndRow || FirstCol >= EndCol; }
+};
+
+/**
+ * Describes how heightmap samples are placed in world space.
+ *
+ * Heightmap rows are laid along X axis, columns along Z axis.
+ * Border samples are only used for normals, so the vertex grid
+ * covers samples [1, n - 1) in both directions.
+ */
+struct TerrainLayout
+{
+	UINT Width = 0;			// Heightmap width (number of columns)
+	UINT Depth = 0;			// Heightmap height (number of rows)
+
+	float Dx = 0.0f;		// Distance between neighbouring rows
+	float Dz = 0.0f;		// Distance between neighbouring columns
+	float ZeroX = 0.0f;		// X coordinate of row 0
+	float ZeroZ = 0.0f;		// Z coordinate of column 0
+
+	TerrainLayout(UINT width, UINT depth);
+
+	// The vertex grid needs two vertices, four samples, along each side
+	bool HasQuads() const { return Width >= 4 && Depth >= 4; }
+
+	// Number of vertices along each side of the vertex grid
+	UINT GridColumns() const { return HasQuads() ? Width - 2 : 0; }
+	UINT GridRows() const { return HasQuads() ? Depth - 2 : 0; }
+
+	// Number of chunks the vertex grid is split into, 0 without quads
+	UINT ChunkColumns() const { return HasQuads() ? (GridColumns() - 2) / TERRAIN_CHUNK_QUADS + 1 : 0; }
+	UINT ChunkRows() const { return HasQuads() ? (GridRows() - 2) / TERRAIN_CHUNK_QUADS + 1 : 0; }
+
+	// Grid range of the chunk, buffer offsets are left at zero
+	TerrainChunk GetChunk(UINT chunkCol, UINT chunkRow) const;
+
+	float WorldX(UINT row) const { return ZeroX + row * Dx; }
+	float WorldZ(UINT col) const { return ZeroZ - col * Dz; }
+
+	// Scale (xy) and offset (zw) from world (z, x) to texture coordinates
+	// of a texture with one texel per heightmap sample
+	DirectX::XMFLOAT4 MapTransform() const;
+
+	// Converts heightmap sample to world height
+	static float SampleHeight(float sample) { return sample * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET; }
+};
+
+/**
+ * Vertices and indices of the whole terrain, stored chunk after chunk.
+ * Indices of each chunk are relative to its BaseVertex.
+ */
+struct TerrainMeshData
+{
+	std::vector<Vertex> Vertices;
+	std::vector<uint16_t> Indices;
+	std::vector<TerrainChunk> Chunks;
+};
+
+// Writes vertices of chunk columns [colBegin, colEnd) to pVertices,
+// which points to the first vertex of column colBegin
+void WriteTerrainVertices(HeightmapImage& heightmap, const TerrainLayout& layout,
+	const TerrainChunk& chunk, UINT colBegin, UINT colEnd, Vertex* pVertices);
+
+// Same, reading heights from a window of (NumRows + 2) x (NumCols + 2)
+// samples that starts at heightmap sample (chunk.FirstRow, chunk.FirstCol)
+void WriteTerrainVertices(const uint8_t* pWindow, size_t rowPitch, const TerrainLayout& layout,
+	const TerrainChunk& chunk, UINT colBegin, UINT colEnd, Vertex* pVertices);
+
+// Writes indices of quad columns [colBegin, colEnd) to pIndices,
+// which points to the first index of quad column colBegin
+void WriteTerrainIndices(const TerrainChunk& chunk, UINT colBegin, UINT colEnd,
+	uint16_t* pIndices);
+
+// Generates vertices and 16-bit indices for one terrain chunk.
+// Neighbouring chunks share their border vertices.
+void BuildTerrainChunk(HeightmapImage& heightmap, const TerrainLayout& layout,
+	UINT chunkCol, UINT chunkRow,
+	std::vector<Vertex>& vertices, std::vector<uint16_t>& indices);
+
+// Generates the whole terrain. Output is presized once and filled by
+// bands of TERRAIN_BAND_COLUMNS columns, which are spread over pPool.
+// Result is identical for any thread count, nullptr runs serially.
+void BuildTerrainMesh(HeightmapImage& heightmap, const TerrainLayout& layout,
+	TerrainMeshData& mesh, WorkerPool* pPool);
+
+// Copies world heights of the vertex grid, GridRows() x GridColumns(),
+// row after row
+void ExtractTerrainHeights(HeightmapImage& heightmap, const TerrainLayout& layout,
+	std::vector<float>& heights);
@@ -0,0 +1,636 @@
+/*****************************************************************//**
+ * \file   terrain_noise.cpp
+ * \brief  Procedural heightfield generator
+ *
+ * Rows are evaluated in spans: octave coordinates are prepared for the
+ * whole span, the basis kernel runs over it, then the octave is added
+ * to the layer sum. Only the basis kernels have SIMD paths, they use
+ * the same operations in the same order as the scalar one, without FMA,
+ * so every level returns the same bits.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "terrain_noise.h"
+
+// Samples processed at once, the span buffers live on the stack
+#define NOISE_SPAN 128
+
+// Simplex skew factors, (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6
+#define SIMPLEX_F2 0.36602540378f
+#define SIMPLEX_G2 0.21132486540f
+
+// Brings the simplex basis to about [-1, 1]
+#define SIMPLEX_SCALE 45.23f
+
+// Seeds of the two warp fields, relative to the settings seed
+#define NOISE_WARP_SEED_X 0x68E31DA4u
+#define NOISE_WARP_SEED_Y 0xB5297A4Du
+
+struct noise_octave
+{
+	float Frequency;
+	float Amplitude;
+	uint32_t Seed;
+};
+
+struct noise_layer
+{
+	NOISE_BASIS Basis;
+	NOISE_FRACTAL Fractal;
+	std::vector<noise_octave> Octaves;
+};
+
+// Settings with the per-octave values worked out once
+struct noise_plan
+{
+	std::vector<noise_layer> Layers;
+	float WarpAmplitude = 0.0f;
+	noise_layer WarpX;
+	noise_layer WarpY;
+};
+
+static uint32_t mix_seed(uint32_t a, uint32_t b)
+{
+	uint32_t h = a * 0x9E3779B9u + b;
+	h ^= h >> 16;
+	h *= 0x7FEB352Du;
+	h ^= h >> 15;
+	h *= 0x846CA68Bu;
+	h ^= h >> 16;
+	return h;
+}
+
+static noise_layer compile_layer(const TerrainNoiseLayer& desc, uint32_t seed)
+{
+	noise_layer layer;
+	layer.Basis = desc.Basis;
+	layer.Fractal = desc.Fractal;
+
+	float frequency = desc.Frequency;
+	float amplitude = desc.Amplitude;
+	for (uint32_t o = 0; o < desc.Octaves; o++)
+	{
+		layer.Octaves.push_back({ frequency, amplitude, mix_seed(seed, o) });
+		frequency *= desc.Lacunarity;
+		amplitude *= desc.Gain;
+	}
+	return layer;
+}
+
+static noise_plan compile_plan(const TerrainNoiseSettings& settings)
+{
+	noise_plan plan;
+	for (size_t i = 0; i < settings.Layers.size(); i++)
+	{
+		plan.Layers.push_back(compile_layer(settings.Layers[i],
+			mix_seed(settings.Seed, static_cast<uint32_t>(i) + 1)));
+	}
+
+	plan.WarpAmplitude = settings.WarpAmplitude;
+	if (plan.WarpAmplitude != 0.0f)
+	{
+		plan.WarpX = compile_layer(settings.Warp, mix_seed(settings.Seed, NOISE_WARP_SEED_X));
+		plan.WarpY = compile_layer(settings.Warp, mix_seed(settings.Seed, NOISE_WARP_SEED_Y));
+	}
+	return plan;
+}
+
+// Lattice coordinates are hashed premultiplied by these constants.
+// Multiplication wraps, so the neighbours of a lattice point are
+// reached with additions: (x + 1) * A == x * A + A.
+#define NOISE_HASH_X 0x27D4EB2Du
+#define NOISE_HASH_Y 0x165667B1u
+#define NOISE_HASH_MIX 0x7FEB352Du
+
+// Lattice hash of premultiplied coordinates. Only the high bits are
+// mixed well and used.
+static inline uint32_t hash2(uint32_t xa, uint32_t yb, uint32_t seed)
+{
+	uint32_t h = xa ^ yb ^ seed;
+	h ^= h >> 16;
+	h *= NOISE_HASH_MIX;
+	h ^= h >> 15;
+	return h;
+}
+
+// Top 24 bits of the hash mapped to [-1, 1)
+static inline float hash_to_float(uint32_t h)
+{
+	return (float)(int32_t)(h >> 8) * (1.0f / 8388608.0f) - 1.0f;
+}
+
+// One of eight gradients (+-1, +-2) and (+-2, +-1) dotted with (x, y),
+// picked by the top three bits of the hash
+static inline float grad2(uint32_t h, float x, float y)
+{
+	float u = (h & 0x80000000u) ? y : x;
+	float v = (h & 0x80000000u) ? x : y;
+	u = (h & 0x40000000u) ? -u : u;
+	v = (h & 0x20000000u) ? -v : v;
+	return u + (v + v);
+}
+
+static inline float simplex_corner(uint32_t h, float x, float y)
+{
+	float t = (0.5f - x * x) - y * y;
+	float t2 = t * t;
+	float n = (t2 * t2) * grad2(h, x, y);
+	return t < 0.0f ? 0.0f : n;
+}
+
+static void value_noise_scalar(const float* pX, const float* pY, uint32_t begin, uint32_t count,
+	uint32_t seed, float* pOut)
+{
+	for (uint32_t k = begin; k < count; k++)
+	{
+		float fx = std::floor(pX[k]);
+		float fy = std::floor(pY[k]);
+		uint32_t xa = (uint32_t)(int32_t)fx * NOISE_HASH_X;
+		uint32_t yb = (uint32_t)(int32_t)fy * NOISE_HASH_Y;
+		float tx = pX[k] - fx;
+		float ty = pY[k] - fy;
+
+		// Quintic fade, flat first and second derivatives at the lattice
+		float ux = tx * tx * tx * (tx * (tx * 6.0f - 15.0f) + 10.0f);
+		float uy = ty * ty * ty * (ty * (ty * 6.0f - 15.0f) + 10.0f);
+
+		float v00 = hash_to_float(hash2(xa, yb, seed));
+		float v10 = hash_to_float(hash2(xa + NOISE_HASH_X, yb, seed));
+		float v01 = hash_to_float(hash2(xa, yb + NOISE_HASH_Y, seed));
+		float v11 = hash_to_float(hash2(xa + NOISE_HASH_X, yb + NOISE_HASH_Y, seed));
+
+		float a = v00 + (v10 - v00) * ux;
+		float b = v01 + (v11 - v01) * ux;
+		pOut[k] = a + (b - a) * uy;
+	}
+}
+
+static void simplex_noise_scalar(const float* pX, const float* pY, uint32_t begin, uint32_t count,
+	uint32_t seed, float* pOut)
+{
+	for (uint32_t k = begin; k < count; k++)
+	{
+		float x = pX[k];
+		float y = pY[k];
+
+		// Skew to the simplex grid and find the containing triangle
+		float s = (x + y) * SIMPLEX_F2;
+		float fi = std::floor(x + s);
+		float fj = std::floor(y + s);
+		float t = (fi + fj) * SIMPLEX_G2;
+		float x0 = x - (fi - t);
+		float y0 = y - (fj - t);
+
+		uint32_t ia = (uint32_t)(int32_t)fi * NOISE_HASH_X;
+		uint32_t jb = (uint32_t)(int32_t)fj * NOISE_HASH_Y;
+
+		// Middle corner is one step along x or along y
+		bool stepX = x0 > y0;
+		float i1 = stepX ? 1.0f : 0.0f;
+		float j1 = stepX ? 0.0f : 1.0f;
+		uint32_t i1a = stepX ? NOISE_HASH_X : 0u;
+		uint32_t j1b = stepX ? 0u : NOISE_HASH_Y;
+
+		float x1 = (x0 - i1) + SIMPLEX_G2;
+		float y1 = (y0 - j1) + SIMPLEX_G2;
+		float x2 = (x0 - 1.0f) + 2.0f * SIMPLEX_G2;
+		float y2 = (y0 - 1.0f) + 2.0f * SIMPLEX_G2;
+
+		float n0 = simplex_corner(hash2(ia, jb, seed), x0, y0);
+		float n1 = simplex_corner(hash2(ia + i1a, jb + j1b, seed), x1, y1);
+		float n2 = simplex_corner(hash2(ia + NOISE_HASH_X, jb + NOISE_HASH_Y, seed), x2, y2);
+
+		pOut[k] = ((n0 + n1) + n2) * SIMPLEX_SCALE;
+	}
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_SSE41 static inline __m128i hash2_sse41(__m128i xa, __m128i yb, __m128i seed)
+{
+	__m128i h = _mm_xor_si128(_mm_xor_si128(xa, yb), seed);
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+	h = _mm_mullo_epi32(h, _mm_set1_epi32((int)NOISE_HASH_MIX));
+	h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+	return h;
+}
+
+SIMD_TARGET_SSE41 static inline __m128 hash_to_float_sse41(__m128i h)
+{
+	return _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)),
+		_mm_set1_ps(1.0f / 8388608.0f)), _mm_set1_ps(1.0f));
+}
+
+SIMD_TARGET_SSE41 static inline __m128 simplex_corner_sse41(__m128i h, __m128 x, __m128 y)
+{
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	// Swap, then flip the signs selected by the hash bits
+	__m128 swap = _mm_castsi128_ps(h);
+	__m128 u = _mm_blendv_ps(x, y, swap);
+	__m128 v = _mm_blendv_ps(y, x, swap);
+	__m128 flipU = _mm_castsi128_ps(_mm_slli_epi32(h, 1));
+	__m128 flipV = _mm_castsi128_ps(_mm_slli_epi32(h, 2));
+	u = _mm_xor_ps(u, _mm_and_ps(flipU, signBit));
+	v = _mm_xor_ps(v, _mm_and_ps(flipV, signBit));
+	__m128 g = _mm_add_ps(u, _mm_add_ps(v, v));
+
+	__m128 t = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y));
+	__m128 t2 = _mm_mul_ps(t, t);
+	__m128 n = _mm_mul_ps(_mm_mul_ps(t2, t2), g);
+	return _mm_andnot_ps(_mm_cmplt_ps(t, _mm_setzero_ps()), n);
+}
+
+SIMD_TARGET_SSE41 static uint32_t value_noise_sse41(const float* pX, const float* pY, uint32_t count,
+	uint32_t seed, float* pOut)
+{
+	const __m128i vseed = _mm_set1_epi32((int)seed);
+	const __m128i hashX = _mm_set1_epi32((int)NOISE_HASH_X);
+	const __m128i hashY = _mm_set1_epi32((int)NOISE_HASH_Y);
+	const __m128 c6 = _mm_set1_ps(6.0f);
+	const __m128 c15 = _mm_set1_ps(15.0f);
+	const __m128 c10 = _mm_set1_ps(10.0f);
+
+	uint32_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		__m128 x = _mm_loadu_ps(pX + k);
+		__m128 y = _mm_loadu_ps(pY + k);
+		__m128 fx = _mm_floor_ps(x);
+		__m128 fy = _mm_floor_ps(y);
+		__m128i xa = _mm_mullo_epi32(_mm_cvttps_epi32(fx), hashX);
+		__m128i yb = _mm_mullo_epi32(_mm_cvttps_epi32(fy), hashY);
+		__m128 tx = _mm_sub_ps(x, fx);
+		__m128 ty = _mm_sub_ps(y, fy);
+
+		__m128 ux = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(tx, tx), tx),
+			_mm_add_ps(_mm_mul_ps(tx, _mm_sub_ps(_mm_mul_ps(tx, c6), c15)), c10));
+		__m128 uy = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(ty, ty), ty),
+			_mm_add_ps(_mm_mul_ps(ty, _mm_sub_ps(_mm_mul_ps(ty, c6), c15)), c10));
+
+		__m128i xa1 = _mm_add_epi32(xa, hashX);
+		__m128i yb1 = _mm_add_epi32(yb, hashY);
+		__m128 v00 = hash_to_float_sse41(hash2_sse41(xa, yb, vseed));
+		__m128 v10 = hash_to_float_sse41(hash2_sse41(xa1, yb, vseed));
+		__m128 v01 = hash_to_float_sse41(hash2_sse41(xa, yb1, vseed));
+		__m128 v11 = hash_to_float_sse41(hash2_sse41(xa1, yb1, vseed));
+
+		__m128 a = _mm_add_ps(v00, _mm_mul_ps(_mm_sub_ps(v10, v00), ux));
+		__m128 b = _mm_add_ps(v01, _mm_mul_ps(_mm_sub_ps(v11, v01), ux));
+		_mm_storeu_ps(pOut + k, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), uy)));
+	}
+	return k;
+}
+
+SIMD_TARGET_SSE41 static uint32_t simplex_noise_sse41(const float* pX, const float* pY, uint32_t count,
+	uint32_t seed, float* pOut)
+{
+	const __m128i vseed = _mm_set1_epi32((int)seed);
+	const __m128i hashX = _mm_set1_epi32((int)NOISE_HASH_X);
+	const __m128i hashY = _mm_set1_epi32((int)NOISE_HASH_Y);
+	const __m128 f2 = _mm_set1_ps(SIMPLEX_F2);
+	const __m128 g2 = _mm_set1_ps(SIMPLEX_G2);
+	const __m128 g2x2 = _mm_set1_ps(2.0f * SIMPLEX_G2);
+	const __m128 onef = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(SIMPLEX_SCALE);
+
+	uint32_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		__m128 x = _mm_loadu_ps(pX + k);
+		__m128 y = _mm_loadu_ps(pY + k);
+
+		__m128 s = _mm_mul_ps(_mm_add_ps(x, y), f2);
+		__m128 fi = _mm_floor_ps(_mm_add_ps(x, s));
+		__m128 fj = _mm_floor_ps(_mm_add_ps(y, s));
+		__m128 t = _mm_mul_ps(_mm_add_ps(fi, fj), g2);
+		__m128 x0 = _mm_sub_ps(x, _mm_sub_ps(fi, t));
+		__m128 y0 = _mm_sub_ps(y, _mm_sub_ps(fj, t));
+
+		__m128i ia = _mm_mullo_epi32(_mm_cvttps_epi32(fi), hashX);
+		__m128i jb = _mm_mullo_epi32(_mm_cvttps_epi32(fj), hashY);
+
+		__m128 stepX = _mm_cmpgt_ps(x0, y0);
+		__m128 i1 = _mm_and_ps(stepX, onef);
+		__m128 j1 = _mm_andnot_ps(stepX, onef);
+		__m128i i1a = _mm_and_si128(_mm_castps_si128(stepX), hashX);
+		__m128i j1b = _mm_andnot_si128(_mm_castps_si128(stepX), hashY);
+
+		__m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2);
+		__m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g2);
+		__m128 x2 = _mm_add_ps(_mm_sub_ps(x0, onef), g2x2);
+		__m128 y2 = _mm_add_ps(_mm_sub_ps(y0, onef), g2x2);
+
+		__m128 n0 = simplex_corner_sse41(hash2_sse41(ia, jb, vseed), x0, y0);
+		__m128 n1 = simplex_corner_sse41(hash2_sse41(_mm_add_epi32(ia, i1a), _mm_add_epi32(jb, j1b), vseed), x1, y1);
+		__m128 n2 = simplex_corner_sse41(hash2_sse41(_mm_add_epi32(ia, hashX), _mm_add_epi32(jb, hashY), vseed), x2, y2);
+
+		_mm_storeu_ps(pOut + k, _mm_mul_ps(_mm_add_ps(_mm_add_ps(n0, n1), n2), scale));
+	}
+	return k;
+}
+
+SIMD_TARGET_AVX2 static inline __m256i hash2_avx2(__m256i xa, __m256i yb, __m256i seed)
+{
+	__m256i h = _mm256_xor_si256(_mm256_xor_si256(xa, yb), seed);
+	h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+	h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)NOISE_HASH_MIX));
+	h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+	return h;
+}
+
+SIMD_TARGET_AVX2 static inline __m256 hash_to_float_avx2(__m256i h)
+{
+	return _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)),
+		_mm256_set1_ps(1.0f / 8388608.0f)), _mm256_set1_ps(1.0f));
+}
+
+SIMD_TARGET_AVX2 static inline __m256 simplex_corner_avx2(__m256i h, __m256 x, __m256 y)
+{
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+	// Swap, then flip the signs selected by the hash bits
+	__m256 swap = _mm256_castsi256_ps(h);
+	__m256 u = _mm256_blendv_ps(x, y, swap);
+	__m256 v = _mm256_blendv_ps(y, x, swap);
+	__m256 flipU = _mm256_castsi256_ps(_mm256_slli_epi32(h, 1));
+	__m256 flipV = _mm256_castsi256_ps(_mm256_slli_epi32(h, 2));
+	u = _mm256_xor_ps(u, _mm256_and_ps(flipU, signBit));
+	v = _mm256_xor_ps(v, _mm256_and_ps(flipV, signBit));
+	__m256 g = _mm256_add_ps(u, _mm256_add_ps(v, v));
+
+	__m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y));
+	__m256 t2 = _mm256_mul_ps(t, t);
+	__m256 n = _mm256_mul_ps(_mm256_mul_ps(t2, t2), g);
+	return _mm256_andnot_ps(_mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_LT_OQ), n);
+}
+
+SIMD_TARGET_AVX2 static uint32_t value_noise_avx2(const float* pX, const float* pY, uint32_t count,
+	uint32_t seed, float* pOut)
+{
+	const __m256i vseed = _mm256_set1_epi32((int)seed);
+	const __m256i hashX = _mm256_set1_epi32((int)NOISE_HASH_X);
+	const __m256i hashY = _mm256_set1_epi32((int)NOISE_HASH_Y);
+	const __m256 c6 = _mm256_set1_ps(6.0f);
+	const __m256 c15 = _mm256_set1_ps(15.0f);
+	const __m256 c10 = _mm256_set1_ps(10.0f);
+
+	uint32_t k = 0;
+	for (; k + 8 <= count; k += 8)
+	{
+		__m256 x = _mm256_loadu_ps(pX + k);
+		__m256 y = _mm256_loadu_ps(pY + k);
+		__m256 fx = _mm256_floor_ps(x);
+		__m256 fy = _mm256_floor_ps(y);
+		__m256i xa = _mm256_mullo_epi32(_mm256_cvttps_epi32(fx), hashX);
+		__m256i yb = _mm256_mullo_epi32(_mm256_cvttps_epi32(fy), hashY);
+		__m256 tx = _mm256_sub_ps(x, fx);
+		__m256 ty = _mm256_sub_ps(y, fy);
+
+		__m256 ux = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(tx, tx), tx),
+			_mm256_add_ps(_mm256_mul_ps(tx, _mm256_sub_ps(_mm256_mul_ps(tx, c6), c15)), c10));
+		__m256 uy = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(ty, ty), ty),
+			_mm256_add_ps(_mm256_mul_ps(ty, _mm256_sub_ps(_mm256_mul_ps(ty, c6), c15)), c10));
+
+		__m256i xa1 = _mm256_add_epi32(xa, hashX);
+		__m256i yb1 = _mm256_add_epi32(yb, hashY);
+		__m256 v00 = hash_to_float_avx2(hash2_avx2(xa, yb, vseed));
+		__m256 v10 = hash_to_float_avx2(hash2_avx2(xa1, yb, vseed));
+		__m256 v01 = hash_to_float_avx2(hash2_avx2(xa, yb1, vseed));
+		__m256 v11 = hash_to_float_avx2(hash2_avx2(xa1, yb1, vseed));
+
+		__m256 a = _mm256_add_ps(v00, _mm256_mul_ps(_mm256_sub_ps(v10, v00), ux));
+		__m256 b = _mm256_add_ps(v01, _mm256_mul_ps(_mm256_sub_ps(v11, v01), ux));
+		_mm256_storeu_ps(pOut + k, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), uy)));
+	}
+	return k;
+}
+
+SIMD_TARGET_AVX2 static uint32_t simplex_noise_avx2(const float* pX, const float* pY, uint32_t count,
+	uint32_t seed, float* pOut)
+{
+	const __m256i vseed = _mm256_set1_epi32((int)seed);
+	const __m256i hashX = _mm256_set1_epi32((int)NOISE_HASH_X);
+	const __m256i hashY = _mm256_set1_epi32((int)NOISE_HASH_Y);
+	const __m256 f2 = _mm256_set1_ps(SIMPLEX_F2);
+	const __m256 g2 = _mm256_set1_ps(SIMPLEX_G2);
+	const __m256 g2x2 = _mm256_set1_ps(2.0f * SIMPLEX_G2);
+	const __m256 onef = _mm256_set1_ps(1.0f);
+	const __m256 scale = _mm256_set1_ps(SIMPLEX_SCALE);
+
+	uint32_t k = 0;
+	for (; k + 8 <= count; k += 8)
+	{
+		__m256 x = _mm256_loadu_ps(pX + k);
+		__m256 y = _mm256_loadu_ps(pY + k);
+
+		__m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), f2);
+		__m256 fi = _mm256_floor_ps(_mm256_add_ps(x, s));
+		__m256 fj = _mm256_floor_ps(_mm256_add_ps(y, s));
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(fi, fj), g2);
+		__m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(fi, t));
+		__m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(fj, t));
+
+		__m256i ia = _mm256_mullo_epi32(_mm256_cvttps_epi32(fi), hashX);
+		__m256i jb = _mm256_mullo_epi32(_mm256_cvttps_epi32(fj), hashY);
+
+		__m256 stepX = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+		__m256 i1 = _mm256_and_ps(stepX, onef);
+		__m256 j1 = _mm256_andnot_ps(stepX, onef);
+		__m256i i1a = _mm256_and_si256(_mm256_castps_si256(stepX), hashX);
+		__m256i j1b = _mm256_andnot_si256(_mm256_castps_si256(stepX), hashY);
+
+		__m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, i1), g2);
+		__m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, j1), g2);
+		__m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, onef), g2x2);
+		__m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, onef), g2x2);
+
+		__m256 n0 = simplex_corner_avx2(hash2_avx2(ia, jb, vseed), x0, y0);
+		__m256 n1 = simplex_corner_avx2(hash2_avx2(_mm256_add_epi32(ia, i1a), _mm256_add_epi32(jb, j1b), vseed), x1, y1);
+		__m256 n2 = simplex_corner_avx2(hash2_avx2(_mm256_add_epi32(ia, hashX), _mm256_add_epi32(jb, hashY), vseed), x2, y2);
+
+		_mm256_storeu_ps(pOut + k, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(n0, n1), n2), scale));
+	}
+	return k;
+}
+
+#endif
+
+static void evaluate_basis(NOISE_BASIS basis, const float* pX, const float* pY, uint32_t count,
+	uint32_t seed, float* pOut, SIMD_LEVEL level)
+{
+	uint32_t done = 0;
+
+	if (basis == NOISE_BASIS_SIMPLEX)
+	{
+#if SIMD_X86
+		if (level >= SIMD_LEVEL_AVX2)
+		{
+			done = simplex_noise_avx2(pX, pY, count, seed, pOut);
+		}
+		else if (level >= SIMD_LEVEL_SSE41)
+		{
+			done = simplex_noise_sse41(pX, pY, count, seed, pOut);
+		}
+#endif
+		simplex_noise_scalar(pX, pY, done, count, seed, pOut);
+	}
+	else
+	{
+#if SIMD_X86
+		if (level >= SIMD_LEVEL_AVX2)
+		{
+			done = value_noise_avx2(pX, pY, count, seed, pOut);
+		}
+		else if (level >= SIMD_LEVEL_SSE41)
+		{
+			done = value_noise_sse41(pX, pY, count, seed, pOut);
+		}
+#endif
+		value_noise_scalar(pX, pY, done, count, seed, pOut);
+	}
+}
+
+// Adds the layer at positions (pU, pV) to pSum, count <= NOISE_SPAN
+static void accumulate_layer(const noise_layer& layer, const float* pU, const float* pV,
+	uint32_t count, float* pSum, SIMD_LEVEL level)
+{
+	float x[NOISE_SPAN];
+	float y[NOISE_SPAN];
+	float n[NOISE_SPAN];
+	float weight[NOISE_SPAN];
+
+	for (uint32_t k = 0; k < count; k++) weight[k] = 1.0f;
+
+	for (const noise_octave& octave : layer.Octaves)
+	{
+		for (uint32_t k = 0; k < count; k++)
+		{
+			x[k] = pU[k] * octave.Frequency;
+			y[k] = pV[k] * octave.Frequency;
+		}
+
+		evaluate_basis(layer.Basis, x, y, count, octave.Seed, n, level);
+
+		if (layer.Fractal == NOISE_FRACTAL_RIDGED)
+		{
+			// Octaves are weighted by the previous one, which keeps
+			// the valleys smooth and the crests detailed
+			for (uint32_t k = 0; k < count; k++)
+			{
+				float r = 1.0f - std::fabs(n[k]);
+				r = r * r * weight[k];
+				weight[k] = (std::min)(r + r, 1.0f);
+				pSum[k] += r * octave.Amplitude;
+			}
+		}
+		else
+		{
+			for (uint32_t k = 0; k < count; k++)
+			{
+				pSum[k] += n[k] * octave.Amplitude;
+			}
+		}
+	}
+}
+
+static void evaluate_span(const noise_plan& plan, uint32_t row, uint32_t firstCol, uint32_t count,
+	float* pHeights, SIMD_LEVEL level)
+{
+	float u[NOISE_SPAN];
+	float v[NOISE_SPAN];
+	float warpU[NOISE_SPAN];
+	float warpV[NOISE_SPAN];
+
+	for (uint32_t begin = 0; begin < count; begin += NOISE_SPAN)
+	{
+		uint32_t n = (std::min)(count - begin, (uint32_t)NOISE_SPAN);
+		float* pSum = pHeights + begin;
+
+		for (uint32_t k = 0; k < n; k++)
+		{
+			u[k] = (float)row;
+			v[k] = (float)(firstCol + begin + k);
+			pSum[k] = 0.0f;
+		}
+
+		if (plan.WarpAmplitude != 0.0f)
+		{
+			for (uint32_t k = 0; k < n; k++) warpU[k] = warpV[k] = 0.0f;
+
+			accumulate_layer(plan.WarpX, u, v, n, warpU, level);
+			accumulate_layer(plan.WarpY, u, v, n, warpV, level);
+
+			for (uint32_t k = 0; k < n; k++)
+			{
+				u[k] += warpU[k] * plan.WarpAmplitude;
+				v[k] += warpV[k] * plan.WarpAmplitude;
+			}
+		}
+
+		for (const noise_layer& layer : plan.Layers)
+		{
+			accumulate_layer(layer, u, v, n, pSum, level);
+		}
+	}
+}
+
+void EvaluateTerrainNoise(const TerrainNoiseSettings& settings, uint32_t row,
+	uint32_t firstCol, uint32_t count, float* pHeights, SIMD_LEVEL level)
+{
+	evaluate_span(compile_plan(settings), row, firstCol, count, pHeights, level);
+}
+
+void GenerateTerrainHeightmap(const TerrainNoiseSettings& settings,
+	HeightmapImage& heightmap, WorkerPool* pPool)
+{
+	const noise_plan plan = compile_plan(settings);
+	const SIMD_LEVEL level = GetSimdLevel();
+
+	const uint32_t width = heightmap.GetWidth();
+	const uint32_t height = heightmap.GetHeight();
+	const uint32_t tilesX = (width + TERRAIN_NOISE_TILE_SIZE - 1) / TERRAIN_NOISE_TILE_SIZE;
+	const uint32_t tilesY = (height + TERRAIN_NOISE_TILE_SIZE - 1) / TERRAIN_NOISE_TILE_SIZE;
+
+	const float scale = 255.0f / (settings.OutputMax - settings.OutputMin);
+
+	// Every tile writes only its own samples
+	auto generateTiles = [&](uint32_t begin, uint32_t end)
+	{
+		float heights[TERRAIN_NOISE_TILE_SIZE];
+
+		for (uint32_t tile = begin; tile < end; tile++)
+		{
+			uint32_t firstRow = (tile / tilesX) * TERRAIN_NOISE_TILE_SIZE;
+			uint32_t firstCol = (tile % tilesX) * TERRAIN_NOISE_TILE_SIZE;
+			uint32_t rows = (std::min)(height - firstRow, (uint32_t)TERRAIN_NOISE_TILE_SIZE);
+			uint32_t cols = (std::min)(width - firstCol, (uint32_t)TERRAIN_NOISE_TILE_SIZE);
+
+			for (uint32_t row = firstRow; row < firstRow + rows; row++)
+			{
+				evaluate_span(plan, row, firstCol, cols, heights, level);
+
+				uint8_t* pRow = heightmap.GetWritableRow(row) + firstCol;
+				for (uint32_t k = 0; k < cols; k++)
+				{
+					float value = (heights[k] - settings.OutputMin) * scale;
+					value = (std::min)((std::max)(value, 0.0f), 255.0f);
+					pRow[k] = (uint8_t)(value + 0.5f);
+				}
+			}
+		}
+	};
+
+	if (pPool)
+	{
+		pPool->ParallelFor(tilesX * tilesY, 1, generateTiles);
+	}
+	else
+	{
+		generateTiles(0, tilesX * tilesY);
+	}
+}
@@ -0,0 +1,78 @@
+/*****************************************************************//**
+ * \file   terrain_noise.h
+ * \brief  Procedural heightfield generator
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image_helper.h"
+#include "simd_util.h"
+#include "thread_pool.h"
+
+// Side of the square tiles a heightmap is generated in
+#define TERRAIN_NOISE_TILE_SIZE 128
+
+enum NOISE_BASIS
+{
+	NOISE_BASIS_VALUE = 0,			// Lattice values with quintic interpolation
+	NOISE_BASIS_SIMPLEX = 1			// 2D simplex noise
+};
+
+enum NOISE_FRACTAL
+{
+	NOISE_FRACTAL_FBM = 0,			// Sum of octaves, in [-A, A]
+	NOISE_FRACTAL_RIDGED = 1		// Sharp crests where the basis crosses zero, in [0, A]
+};
+
+/**
+ * One fractal layer. Octave o samples the basis at Frequency * Lacunarity^o
+ * with weight Gain^o, and A is Amplitude times the sum of the weights.
+ */
+struct TerrainNoiseLayer
+{
+	NOISE_BASIS Basis = NOISE_BASIS_SIMPLEX;
+	NOISE_FRACTAL Fractal = NOISE_FRACTAL_FBM;
+	uint32_t Octaves = 6;
+	float Frequency = 1.0f / 256.0f;	// Cycles per heightmap sample
+	float Lacunarity = 2.0f;
+	float Gain = 0.5f;
+	float Amplitude = 1.0f;
+};
+
+struct TerrainNoiseSettings
+{
+	uint32_t Seed = 1;
+
+	// Summed to the height
+	std::vector<TerrainNoiseLayer> Layers = { TerrainNoiseLayer() };
+
+	// Domain warp: layers are sampled at the position displaced by two
+	// simplex fBm fields of this shape, scaled by WarpAmplitude samples.
+	// Zero disables warping.
+	float WarpAmplitude = 0.0f;
+	TerrainNoiseLayer Warp = { NOISE_BASIS_SIMPLEX, NOISE_FRACTAL_FBM, 3, 1.0f / 512.0f, 2.0f, 0.5f, 1.0f };
+
+	// Heights mapped to 0 and 255 in the heightmap, values past them clamp
+	float OutputMin = -1.0f;
+	float OutputMax = 1.0f;
+};
+
+/**
+ * Evaluates the noise height of count samples of a row, starting at
+ * column firstCol. The result depends only on the settings and the
+ * sample position, all SIMD levels are bit-identical.
+ */
+void EvaluateTerrainNoise(const TerrainNoiseSettings& settings, uint32_t row,
+	uint32_t firstCol, uint32_t count, float* pHeights,
+	SIMD_LEVEL level = GetSimdLevel());
+
+// Generates a width x height heightmap, tile by tile over pPool.
+// nullptr runs serially, the image is identical for any thread count.
+void GenerateTerrainHeightmap(const TerrainNoiseSettings& settings,
+	HeightmapImage& heightmap, WorkerPool* pPool);
@@ -0,0 +1,408 @@
+/*****************************************************************//**
+ * \file   terrain_raycast.cpp
+ * \brief  Min/max height pyramid and ray casts against terrain
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "terrain_raycast.h"
+
+using namespace DirectX;
+
+// Slack of the in-triangle test, so that rays through shared edges
+// are not lost between neighbouring triangles
+#define TERRAIN_RAY_EDGE_EPSILON 1e-5f
+
+// Relative slack of the cell height test, covers rounding of the ray
+// height at cell borders over flat ground
+#define TERRAIN_RAY_HEIGHT_EPSILON 1e-5f
+
+// Rays per work item of RaycastBatch
+#define TERRAIN_RAY_BATCH_GRAIN 64
+
+TerrainHeightPyramid::TerrainHeightPyramid(const float* pHeights, const TerrainLayout& layout,
+	WorkerPool* pPool) :
+	mLayout(layout)
+{
+	mGridRows = layout.GridRows();
+	mGridCols = layout.GridColumns();
+	mHeights.assign(pHeights, pHeights + static_cast<size_t>(mGridRows) * mGridCols);
+
+	// Level 0 holds one cell per quad
+	pyramid_level base;
+	base.Rows = mGridRows - 1;
+	base.Cols = mGridCols - 1;
+	base.Cells.resize(static_cast<size_t>(base.Rows) * base.Cols);
+	mLevels.push_back(std::move(base));
+
+	while (mLevels.back().Rows > 1 || mLevels.back().Cols > 1)
+	{
+		const pyramid_level& child = mLevels.back();
+
+		pyramid_level level;
+		level.Rows = (child.Rows + 1) / 2;
+		level.Cols = (child.Cols + 1) / 2;
+		level.Cells.resize(static_cast<size_t>(level.Rows) * level.Cols);
+		mLevels.push_back(std::move(level));
+	}
+
+	for (size_t l = 0; l < mLevels.size(); l++)
+	{
+		pyramid_level& level = mLevels[l];
+
+		auto buildRows = [&](uint32_t begin, uint32_t end)
+		{
+			for (UINT r = begin; r < end; r++)
+			{
+				for (UINT c = 0; c < level.Cols; c++)
+				{
+					height_range range = { FLT_MAX, -FLT_MAX };
+
+					if (l == 0)
+					{
+						// Quads take the range of their corners
+						for (UINT k = 0; k < 4; k++)
+						{
+							float h = Height(r + (k & 1), c + (k >> 1));
+							range.Min = (std::min)(range.Min, h);
+							range.Max = (std::max)(range.Max, h);
+						}
+					}
+					else
+					{
+						const pyramid_level& child = mLevels[l - 1];
+						for (UINT cr = 2 * r; cr < (std::min)(2 * r + 2, child.Rows); cr++)
+						{
+							for (UINT cc = 2 * c; cc < (std::min)(2 * c + 2, child.Cols); cc++)
+							{
+								const height_range& childRange = child.Cells[static_cast<size_t>(cr) * child.Cols + cc];
+								range.Min = (std::min)(range.Min, childRange.Min);
+								range.Max = (std::max)(range.Max, childRange.Max);
+							}
+						}
+					}
+
+					level.Cells[static_cast<size_t>(r) * level.Cols + c] = range;
+				}
+			}
+		};
+
+		if (pPool)
+		{
+			pPool->ParallelFor(level.Rows, 0, buildRows);
+		}
+		else
+		{
+			buildRows(0, level.Rows);
+		}
+	}
+}
+
+TerrainHeightPyramid::grid_ray TerrainHeightPyramid::ToGridRay(const TerrainRay& ray) const
+{
+	// Grid vertex (row, col) lies at heightmap sample (row + 1, col + 1),
+	// Z decreases with column
+	grid_ray gridRay;
+	gridRay.Origin[0] = (ray.Origin.x - mLayout.WorldX(1)) / mLayout.Dx;
+	gridRay.Origin[1] = ray.Origin.y;
+	gridRay.Origin[2] = (mLayout.WorldZ(1) - ray.Origin.z) / mLayout.Dz;
+
+	gridRay.Direction[0] = ray.Direction.x / mLayout.Dx;
+	gridRay.Direction[1] = ray.Direction.y;
+	gridRay.Direction[2] = -ray.Direction.z / mLayout.Dz;
+
+	// A huge finite inverse keeps 0 * inverse from turning into NaN
+	for (int k = 0; k < 3; k++)
+	{
+		gridRay.InvDirection[k] = gridRay.Direction[k] != 0.0f ? 1.0f / gridRay.Direction[k] : FLT_MAX;
+	}
+
+	gridRay.MaxT = ray.MaxT;
+	return gridRay;
+}
+
+bool TerrainHeightPyramid::ClipToBox(const grid_ray& ray, const float boxMin[3], const float boxMax[3],
+	float& tEnter, float& tExit) const
+{
+	for (int k = 0; k < 3; k++)
+	{
+		float t0 = (boxMin[k] - ray.Origin[k]) * ray.InvDirection[k];
+		float t1 = (boxMax[k] - ray.Origin[k]) * ray.InvDirection[k];
+
+		tEnter = (std::max)(tEnter, (std::min)(t0, t1));
+		tExit = (std::min)(tExit, (std::max)(t0, t1));
+	}
+
+	return tEnter <= tExit;
+}
+
+// Tests both triangles of the quad, with the split of WriteTerrainIndices:
+// the lower triangle has u + v <= 1, u along rows and v along columns
+bool TerrainHeightPyramid::IntersectQuad(const grid_ray& ray, UINT row, UINT col, float maxT,
+	float& t, bool& upperTriangle) const
+{
+	const float h00 = Height(row, col);
+	const float h10 = Height(row + 1, col);
+	const float h01 = Height(row, col + 1);
+	const float h11 = Height(row + 1, col + 1);
+
+	// Ray origin relative to the quad corner
+	const float ou = ray.Origin[0] - row;
+	const float ov = ray.Origin[2] - col;
+
+	bool found = false;
+
+	for (int k = 0; k < 2; k++)
+	{
+		// Triangle plane h = base + du * u + dv * v
+		float du, dv, base;
+		if (k == 0)
+		{
+			du = h10 - h00;
+			dv = h01 - h00;
+			base = h00;
+		}
+		else
+		{
+			du = h11 - h01;
+			dv = h11 - h10;
+			base = h11 - du - dv;
+		}
+
+		float denominator = ray.Direction[1] - du * ray.Direction[0] - dv * ray.Direction[2];
+		if (denominator == 0.0f) continue;
+
+		float tHit = (base + du * ou + dv * ov - ray.Origin[1]) / denominator;
+		if (tHit < 0.0f || tHit > maxT) continue;
+
+		float u = ou + tHit * ray.Direction[0];
+		float v = ov + tHit * ray.Direction[2];
+
+		const float eps = TERRAIN_RAY_EDGE_EPSILON;
+		bool inside = k == 0 ?
+			(u >= -eps && v >= -eps && u + v <= 1.0f + eps) :
+			(u <= 1.0f + eps && v <= 1.0f + eps && u + v >= 1.0f - eps);
+
+		if (inside)
+		{
+			maxT = tHit;
+			t = tHit;
+			upperTriangle = k == 1;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+void TerrainHeightPyramid::FillHit(const TerrainRay& ray, UINT row, UINT col, float t, bool upperTriangle,
+	TerrainRayHit& hit) const
+{
+	hit.Hit = true;
+	hit.T = t;
+	hit.Row = row;
+	hit.Col = col;
+
+	hit.Position.x = ray.Origin.x + t * ray.Direction.x;
+	hit.Position.y = ray.Origin.y + t * ray.Direction.y;
+	hit.Position.z = ray.Origin.z + t * ray.Direction.z;
+
+	const float h00 = Height(row, col);
+	const float h10 = Height(row + 1, col);
+	const float h01 = Height(row, col + 1);
+	const float h11 = Height(row + 1, col + 1);
+
+	float du = upperTriangle ? h11 - h01 : h10 - h00;
+	float dv = upperTriangle ? h11 - h10 : h01 - h00;
+
+	// Slopes along world X and Z, Z decreases with column
+	XMFLOAT3 normal(-du / mLayout.Dx, 1.0f, dv / mLayout.Dz);
+	XMStoreFloat3(&hit.Normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+}
+
+// Cell of the given size containing coordinate x, a point on a boundary
+// belongs to the cell the ray moves into
+static int CellIndex(float x, float direction, UINT size)
+{
+	float cell = x / size;
+	return direction >= 0.0f ? (int)std::floor(cell) : (int)std::ceil(cell) - 1;
+}
+
+bool TerrainHeightPyramid::Raycast(const TerrainRay& ray, TerrainRayHit& hit) const
+{
+	hit = TerrainRayHit();
+	const grid_ray gridRay = ToGridRay(ray);
+
+	const UINT quadRows = mLevels[0].Rows;
+	const UINT quadCols = mLevels[0].Cols;
+	const UINT topLevel = static_cast<UINT>(mLevels.size()) - 1;
+	const height_range& bounds = mLevels[topLevel].Cells[0];
+
+	float boxMin[3] = { 0.0f, bounds.Min, 0.0f };
+	float boxMax[3] = { (float)quadRows, bounds.Max, (float)quadCols };
+
+	float t = 0.0f;
+	float tExit = gridRay.MaxT;
+	if (!ClipToBox(gridRay, boxMin, boxMax, t, tExit)) return false;
+
+	const int stepRow = gridRay.Direction[0] >= 0.0f ? 1 : -1;
+	const int stepCol = gridRay.Direction[2] >= 0.0f ? 1 : -1;
+
+	// Walks the cells along the ray (maximum mipmap tracing). Cells the
+	// ray passes over or under are skipped whole, after which the walk
+	// climbs a level. Cells the ray may touch are entered a level down.
+	UINT level = topLevel;
+	int row = 0;
+	int col = 0;
+
+	for (;;)
+	{
+		const pyramid_level& current = mLevels[level];
+		const height_range& range = current.Cells[static_cast<size_t>(row) * current.Cols + col];
+		const UINT size = 1u << level;
+
+		// Ray parameter where it leaves the cell
+		float rowBorder = (float)(stepRow > 0 ? (std::min)((row + 1) * size, quadRows) : row * size);
+		float colBorder = (float)(stepCol > 0 ? (std::min)((col + 1) * size, quadCols) : col * size);
+		float rowExitT = (rowBorder - gridRay.Origin[0]) * gridRay.InvDirection[0];
+		float colExitT = (colBorder - gridRay.Origin[2]) * gridRay.InvDirection[2];
+		float cellExitT = (std::min)((std::min)(rowExitT, colExitT), tExit);
+
+		float yEnter = gridRay.Origin[1] + t * gridRay.Direction[1];
+		float yExit = gridRay.Origin[1] + cellExitT * gridRay.Direction[1];
+		float slack = TERRAIN_RAY_HEIGHT_EPSILON *
+			(1.0f + std::fabs(gridRay.Origin[1]) + std::fabs(cellExitT * gridRay.Direction[1]));
+		bool touches = (std::max)(yEnter, yExit) >= range.Min - slack &&
+			(std::min)(yEnter, yExit) <= range.Max + slack;
+
+		if (touches && level > 0)
+		{
+			// Descend to the child containing the current point
+			const pyramid_level& child = mLevels[level - 1];
+			int childRow = CellIndex(gridRay.Origin[0] + t * gridRay.Direction[0], gridRay.Direction[0], size / 2);
+			int childCol = CellIndex(gridRay.Origin[2] + t * gridRay.Direction[2], gridRay.Direction[2], size / 2);
+
+			row = (std::min)((std::max)(childRow, 2 * row), (std::min)(2 * row + 1, (int)child.Rows - 1));
+			col = (std::min)((std::max)(childCol, 2 * col), (std::min)(2 * col + 1, (int)child.Cols - 1));
+			level--;
+			continue;
+		}
+
+		if (touches)
+		{
+			float tHit;
+			bool upperTriangle;
+			// tExit may end right at the hit on the lowest ground, so
+			// only the ray length limits the quad test
+			if (IntersectQuad(gridRay, row, col, gridRay.MaxT, tHit, upperTriangle))
+			{
+				FillHit(ray, row, col, tHit, upperTriangle, hit);
+				return true;
+			}
+		}
+
+		// Step to the next cell of this level
+		if (cellExitT >= tExit) return false;
+
+		int parentRow = row >> 1;
+		int parentCol = col >> 1;
+
+		if (rowExitT <= colExitT) row += stepRow;
+		if (colExitT <= rowExitT) col += stepCol;
+		t = cellExitT;
+
+		if (row < 0 || row >= (int)current.Rows || col < 0 || col >= (int)current.Cols) return false;
+
+		// Climb once the step leaves the parent
+		if (level < topLevel && ((row >> 1) != parentRow || (col >> 1) != parentCol))
+		{
+			row >>= 1;
+			col >>= 1;
+			level++;
+		}
+	}
+}
+
+void TerrainHeightPyramid::RaycastBatch(const TerrainRay* pRays, size_t count, TerrainRayHit* pHits,
+	WorkerPool* pPool) const
+{
+	auto castRays = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Raycast(pRays[i], pHits[i]);
+		}
+	};
+
+	if (pPool)
+	{
+		pPool->ParallelFor(static_cast<uint32_t>(count), TERRAIN_RAY_BATCH_GRAIN, castRays);
+	}
+	else
+	{
+		castRays(0, static_cast<uint32_t>(count));
+	}
+}
+
+bool TerrainHeightPyramid::RaycastDDA(const TerrainRay& ray, TerrainRayHit& hit) const
+{
+	hit = TerrainRayHit();
+	const grid_ray gridRay = ToGridRay(ray);
+
+	const UINT quadRows = mLevels[0].Rows;
+	const UINT quadCols = mLevels[0].Cols;
+	const height_range& bounds = mLevels.back().Cells[0];
+
+	float boxMin[3] = { 0.0f, bounds.Min, 0.0f };
+	float boxMax[3] = { (float)quadRows, bounds.Max, (float)quadCols };
+
+	float tEnter = 0.0f;
+	float tExit = gridRay.MaxT;
+	if (!ClipToBox(gridRay, boxMin, boxMax, tEnter, tExit)) return false;
+
+	// Quad containing the entry point
+	float entryRow = gridRay.Origin[0] + tEnter * gridRay.Direction[0];
+	float entryCol = gridRay.Origin[2] + tEnter * gridRay.Direction[2];
+	int row = (std::min)((std::max)((int)std::floor(entryRow), 0), (int)quadRows - 1);
+	int col = (std::min)((std::max)((int)std::floor(entryCol), 0), (int)quadCols - 1);
+
+	const int stepRow = gridRay.Direction[0] >= 0.0f ? 1 : -1;
+	const int stepCol = gridRay.Direction[2] >= 0.0f ? 1 : -1;
+
+	// Ray parameter of the next row and column boundaries
+	float nextRowT = ((row + (stepRow > 0 ? 1 : 0)) - gridRay.Origin[0]) * gridRay.InvDirection[0];
+	float nextColT = ((col + (stepCol > 0 ? 1 : 0)) - gridRay.Origin[2]) * gridRay.InvDirection[2];
+	const float deltaRowT = std::fabs(gridRay.InvDirection[0]);
+	const float deltaColT = std::fabs(gridRay.InvDirection[2]);
+
+	for (;;)
+	{
+		float t;
+		bool upperTriangle;
+		if (IntersectQuad(gridRay, row, col, gridRay.MaxT, t, upperTriangle))
+		{
+			FillHit(ray, row, col, t, upperTriangle, hit);
+			return true;
+		}
+
+		if (nextRowT < nextColT)
+		{
+			if (nextRowT > tExit) break;
+			row += stepRow;
+			nextRowT += deltaRowT;
+		}
+		else
+		{
+			if (nextColT > tExit) break;
+			col += stepCol;
+			nextColT += deltaColT;
+		}
+
+		if (row < 0 || row >= (int)quadRows || col < 0 || col >= (int)quadCols) break;
+	}
+
+	return false;
+}
@@ -0,0 +1,108 @@
+/*****************************************************************//**
+ * \file   terrain_raycast.h
+ * \brief  Min/max height pyramid and ray casts against terrain
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cfloat>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "terrain_mesh.h"
+#include "thread_pool.h"
+
+// World space ray, hits are searched for in [0, MaxT]
+struct TerrainRay
+{
+	DirectX::XMFLOAT3 Origin = { };
+	DirectX::XMFLOAT3 Direction = { 0.0f, -1.0f, 0.0f };	// Need not be normalised
+	float MaxT = FLT_MAX;
+};
+
+struct TerrainRayHit
+{
+	bool Hit = false;
+	float T = FLT_MAX;					// Hit point is Origin + T * Direction
+	DirectX::XMFLOAT3 Position = { };
+	DirectX::XMFLOAT3 Normal = { };		// Normal of the hit triangle
+	UINT Row = 0;						// Grid quad that was hit
+	UINT Col = 0;
+};
+
+/**
+ * Pyramid of min/max heights over the terrain quads. Level 0 has one
+ * cell per grid quad, every next level merges 2x2 cells of the previous
+ * one until a single cell remains.
+ *
+ * Rays descend the pyramid front to back and skip every cell whose
+ * height range they pass over or under, so only quads close to the
+ * surface are tested. Hits are exact against the rendered triangles.
+ */
+class TerrainHeightPyramid
+{
+public:
+	// pHeights holds GridRows() x GridColumns() heights, row after row,
+	// as filled by ExtractTerrainHeights. Levels are built over pPool,
+	// nullptr builds serially.
+	TerrainHeightPyramid(const float* pHeights, const TerrainLayout& layout,
+		WorkerPool* pPool = nullptr);
+
+	// Returns true and fills hit for the closest intersection
+	bool Raycast(const TerrainRay& ray, TerrainRayHit& hit) const;
+
+	// Casts count rays, spread over pPool. nullptr runs serially.
+	void RaycastBatch(const TerrainRay* pRays, size_t count, TerrainRayHit* pHits,
+		WorkerPool* pPool) const;
+
+	// Reference cast stepping through every quad under the ray
+	// (Amanatides-Woo grid traversal), returns the same hits as Raycast
+	bool RaycastDDA(const TerrainRay& ray, TerrainRayHit& hit) const;
+
+	UINT GetLevelCount() const { return static_cast<UINT>(mLevels.size()); }
+
+private:
+	struct height_range
+	{
+		float Min;
+		float Max;
+	};
+
+	struct pyramid_level
+	{
+		UINT Rows = 0;
+		UINT Cols = 0;
+		std::vector<height_range> Cells;
+	};
+
+	// Ray converted to grid space: x runs along grid rows, z along grid
+	// columns, one unit per quad. T stays the same as in world space.
+	struct grid_ray
+	{
+		float Origin[3];
+		float Direction[3];
+		float InvDirection[3];
+		float MaxT;
+	};
+
+	grid_ray ToGridRay(const TerrainRay& ray) const;
+	bool ClipToBox(const grid_ray& ray, const float boxMin[3], const float boxMax[3],
+		float& tEnter, float& tExit) const;
+	bool IntersectQuad(const grid_ray& ray, UINT row, UINT col, float maxT,
+		float& t, bool& upperTriangle) const;
+	void FillHit(const TerrainRay& ray, UINT row, UINT col, float t, bool upperTriangle,
+		TerrainRayHit& hit) const;
+
+	float Height(UINT row, UINT col) const
+	{
+		return mHeights[static_cast<size_t>(row) * mGridCols + col];
+	}
+
+	TerrainLayout mLayout;
+	UINT mGridRows = 0;
+	UINT mGridCols = 0;
+	std::vector<float> mHeights;
+	std::vector<pyramid_level> mLevels;
+};
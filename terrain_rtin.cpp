@@ -0,0 +1,324 @@
+/*****************************************************************//**
+ * \file   terrain_rtin.cpp
+ * \brief  Error-bounded terrain meshing with a right-triangulated
+ *         irregular network (RTIN)
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "terrain_rtin.h"
+#include "image_helper.h"
+#include "terrain_kernel.h"
+
+TerrainRtin::TerrainRtin(HeightmapImage& heightmap, const TerrainLayout& layout) :
+	mLayout(layout)
+{
+	mLastX = layout.GridColumns() - 1;
+	mLastY = layout.GridRows() - 1;
+
+	// Smallest power of two covering the grid
+	UINT tileSize = 1;
+	while (tileSize < (std::max)(mLastX, mLastY)) tileSize <<= 1;
+	mSize = tileSize + 1;
+
+	mSamples.resize(static_cast<size_t>(layout.Width) * layout.Depth);
+	for (UINT row = 0; row < layout.Depth; row++)
+	{
+		memcpy(&mSamples[static_cast<size_t>(row) * layout.Width], heightmap.GetRow(row), layout.Width);
+	}
+
+	ExtractTerrainHeights(heightmap, layout, mHeights);
+	mErrors.assign(static_cast<size_t>(mSize) * mSize, 0.0f);
+
+	const UINT gridCols = layout.GridColumns();
+	auto height = [&](UINT x, UINT y) { return mHeights[static_cast<size_t>(y) * gridCols + x]; };
+
+	// Triangles are numbered as a binary heap, two roots split the square
+	// along its diagonal. Going from the last id visits children before
+	// their parents, so parent errors include the errors of children.
+	const size_t numTriangles = static_cast<size_t>(tileSize) * tileSize * 2 - 2;
+	const size_t numParentTriangles = numTriangles - static_cast<size_t>(tileSize) * tileSize;
+
+	for (size_t i = numTriangles; i-- > 0; )
+	{
+		size_t id = i + 2;
+		UINT ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+
+		if (id & 1)
+		{
+			bx = by = cx = tileSize;
+		}
+		else
+		{
+			ax = ay = cy = tileSize;
+		}
+
+		// Descend from the root to triangle id
+		while ((id >>= 1) > 1)
+		{
+			UINT mx = (ax + bx) >> 1;
+			UINT my = (ay + by) >> 1;
+
+			if (id & 1)
+			{
+				bx = ax; by = ay;
+				ax = cx; ay = cy;
+			}
+			else
+			{
+				ax = bx; ay = by;
+				bx = cx; by = cy;
+			}
+			cx = mx; cy = my;
+		}
+
+		if (IsOutside(ax, ay, bx, by, cx, cy)) continue;
+
+		UINT mx = (ax + bx) >> 1;
+		UINT my = (ay + by) >> 1;
+		float& error = mErrors[static_cast<size_t>(my) * mSize + mx];
+
+		// Triangles crossing the border are always split
+		if (!IsInside(ax, ay, bx, by, cx, cy))
+		{
+			error = FLT_MAX;
+			continue;
+		}
+
+		// Planes of the children differ from the plane of the triangle
+		// by at most the midpoint error, so their bounds add up
+		float interpolated = 0.5f * (height(ax, ay) + height(bx, by));
+		float triangleError = std::fabs(interpolated - height(mx, my));
+
+		if (i < numParentTriangles)
+		{
+			float leftError = mErrors[static_cast<size_t>((ay + cy) >> 1) * mSize + ((ax + cx) >> 1)];
+			float rightError = mErrors[static_cast<size_t>((by + cy) >> 1) * mSize + ((bx + cx) >> 1)];
+			triangleError += (std::max)(leftError, rightError);
+		}
+
+		error = (std::max)(error, triangleError);
+	}
+}
+
+bool TerrainRtin::IsOutside(UINT ax, UINT ay, UINT bx, UINT by, UINT cx, UINT cy) const
+{
+	// Triangles touching the border from outside are outside too
+	return (ax >= mLastX && bx >= mLastX && cx >= mLastX) ||
+		(ay >= mLastY && by >= mLastY && cy >= mLastY);
+}
+
+bool TerrainRtin::IsInside(UINT ax, UINT ay, UINT bx, UINT by, UINT cx, UINT cy) const
+{
+	return ax <= mLastX && bx <= mLastX && cx <= mLastX &&
+		ay <= mLastY && by <= mLastY && cy <= mLastY;
+}
+
+void TerrainRtin::CollectTriangles(UINT ax, UINT ay, UINT bx, UINT by, UINT cx, UINT cy,
+	float maxError, std::vector<uint32_t>& triangles) const
+{
+	if (IsOutside(ax, ay, bx, by, cx, cy)) return;
+
+	UINT mx = (ax + bx) >> 1;
+	UINT my = (ay + by) >> 1;
+
+	// Split along the hypotenuse until the error is small enough
+	// or the triangle covers half of a grid quad. Triangles crossing
+	// the border are split whatever the error bound, their vertices
+	// past the grid have no heights.
+	const bool inside = IsInside(ax, ay, bx, by, cx, cy);
+	int legLength = std::abs((int)ax - (int)cx) + std::abs((int)ay - (int)cy);
+	if (legLength > 1 && (!inside || mErrors[static_cast<size_t>(my) * mSize + mx] > maxError))
+	{
+		CollectTriangles(cx, cy, ax, ay, mx, my, maxError, triangles);
+		CollectTriangles(bx, by, cx, cy, mx, my, maxError, triangles);
+		return;
+	}
+
+	// Half-quad triangles are either inside or outside, this only guards
+	// against reading past the samples
+	if (!inside) return;
+
+	// Same winding as the full grid: clockwise in (column, row)
+	int cross = ((int)bx - (int)ax) * ((int)cy - (int)ay) - ((int)by - (int)ay) * ((int)cx - (int)ax);
+	if (cross > 0)
+	{
+		std::swap(bx, cx);
+		std::swap(by, cy);
+	}
+
+	triangles.push_back(ay * mSize + ax);
+	triangles.push_back(by * mSize + bx);
+	triangles.push_back(cy * mSize + cx);
+}
+
+Vertex TerrainRtin::MakeVertex(UINT gridRow, UINT gridCol) const
+{
+	// Grid vertex (g, h) samples heightmap at (g + 1, h + 1)
+	const uint8_t* pRow = &mSamples[static_cast<size_t>(gridRow + 1) * mLayout.Width + gridCol + 1];
+
+	float height, normalX, normalY, normalZ;
+	ComputeTerrainRow(pRow - mLayout.Width, pRow, pRow + mLayout.Width, 1,
+		mLayout.Dx, mLayout.Dz, &height, &normalX, &normalY, &normalZ);
+
+	float x = mLayout.WorldX(gridRow + 1);
+	float z = mLayout.WorldZ(gridCol + 1);
+
+	return Vertex{ { x, height, z }, { normalX, normalY, normalZ }, { 0.05f * x, 0.05f * z } };
+}
+
+int TerrainRtin::Extract(float maxError, TerrainRtinMesh& mesh) const
+{
+	mesh.Vertices.clear();
+	mesh.Indices.clear();
+	mesh.Submeshes.clear();
+
+	// Infinite bound would keep the two root triangles, NaN is meaningless
+	if (!std::isfinite(maxError))
+	{
+		fprintf(stderr, "RTIN error bound %f is not finite\n", maxError);
+		return -1;
+	}
+
+	const UINT tileSize = mSize - 1;
+
+	std::vector<uint32_t> triangles;
+	CollectTriangles(0, 0, tileSize, tileSize, tileSize, 0, maxError, triangles);
+	CollectTriangles(tileSize, tileSize, 0, 0, 0, tileSize, maxError, triangles);
+
+	const size_t triangleCount = triangles.size() / 3;
+
+	// Sort triangles into chunks by centroid, in the order of BuildTerrainMesh
+	const UINT chunkCols = mLayout.ChunkColumns();
+	const UINT chunkRows = mLayout.ChunkRows();
+	const size_t chunkCount = static_cast<size_t>(chunkCols) * chunkRows;
+
+	std::vector<uint32_t> chunkOf(triangleCount);
+	std::vector<size_t> chunkStart(chunkCount + 1, 0);
+
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		UINT sumX = 0, sumY = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			sumX += triangles[3 * t + k] % mSize;
+			sumY += triangles[3 * t + k] / mSize;
+		}
+
+		UINT chunkCol = (std::min)(sumX / 3 / TERRAIN_CHUNK_QUADS, chunkCols - 1);
+		UINT chunkRow = (std::min)(sumY / 3 / TERRAIN_CHUNK_QUADS, chunkRows - 1);
+
+		chunkOf[t] = chunkCol * chunkRows + chunkRow;
+		chunkStart[chunkOf[t] + 1]++;
+	}
+
+	for (size_t c = 0; c < chunkCount; c++) chunkStart[c + 1] += chunkStart[c];
+
+	std::vector<uint32_t> sorted(triangles.size());
+	{
+		std::vector<size_t> cursor(chunkStart.begin(), chunkStart.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			size_t dst = cursor[chunkOf[t]]++;
+			memcpy(&sorted[3 * dst], &triangles[3 * t], 3 * sizeof(uint32_t));
+		}
+	}
+
+	mesh.Indices.resize(sorted.size());
+
+	// Every chunk gets its own vertices, shared ones are duplicated
+	std::vector<uint32_t> chunkVertices;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		size_t first = 3 * chunkStart[c];
+		size_t last = 3 * chunkStart[c + 1];
+		if (first == last) continue;
+
+		chunkVertices.assign(sorted.begin() + first, sorted.begin() + last);
+		std::sort(chunkVertices.begin(), chunkVertices.end());
+		chunkVertices.erase(std::unique(chunkVertices.begin(), chunkVertices.end()), chunkVertices.end());
+
+		TerrainRtinSubmesh submesh;
+		submesh.ChunkCol = static_cast<UINT>(c / chunkRows);
+		submesh.ChunkRow = static_cast<UINT>(c % chunkRows);
+		submesh.BaseVertex = mesh.Vertices.size();
+		submesh.VertexCount = chunkVertices.size();
+		submesh.StartIndex = first;
+		submesh.IndexCount = last - first;
+
+		for (uint32_t v : chunkVertices)
+		{
+			mesh.Vertices.push_back(MakeVertex(v / mSize, v % mSize));
+		}
+
+		for (size_t i = first; i < last; i++)
+		{
+			size_t local = std::lower_bound(chunkVertices.begin(), chunkVertices.end(), sorted[i]) - chunkVertices.begin();
+			mesh.Indices[i] = static_cast<uint16_t>(local);
+		}
+
+		mesh.Submeshes.push_back(submesh);
+	}
+
+	return 0;
+}
+
+float TerrainRtin::MeasureError(const TerrainRtinMesh& mesh) const
+{
+	const UINT gridCols = mLayout.GridColumns();
+	float maxError = 0.0f;
+
+	for (const TerrainRtinSubmesh& submesh : mesh.Submeshes)
+	{
+		const Vertex* pVertices = &mesh.Vertices[submesh.BaseVertex];
+
+		for (size_t i = submesh.StartIndex; i < submesh.StartIndex + submesh.IndexCount; i += 3)
+		{
+			// Back to grid coordinates, grid vertex (g, h) lies at sample (g + 1, h + 1)
+			int rows[3], cols[3];
+			float heights[3];
+			for (int k = 0; k < 3; k++)
+			{
+				const Vertex& v = pVertices[mesh.Indices[i + k]];
+				rows[k] = (int)std::lround((v.Pos.x - mLayout.ZeroX) / mLayout.Dx) - 1;
+				cols[k] = (int)std::lround((mLayout.ZeroZ - v.Pos.z) / mLayout.Dz) - 1;
+				heights[k] = v.Pos.y;
+			}
+
+			const int area = (rows[1] - rows[0]) * (cols[2] - cols[0]) - (cols[1] - cols[0]) * (rows[2] - rows[0]);
+			if (area == 0) continue;
+
+			const int firstRow = (std::min)({ rows[0], rows[1], rows[2] });
+			const int lastRow = (std::max)({ rows[0], rows[1], rows[2] });
+			const int firstCol = (std::min)({ cols[0], cols[1], cols[2] });
+			const int lastCol = (std::max)({ cols[0], cols[1], cols[2] });
+
+			for (int r = firstRow; r <= lastRow; r++)
+			{
+				for (int c = firstCol; c <= lastCol; c++)
+				{
+					// Barycentric weights, all of the sign of area inside
+					int w0 = (rows[2] - rows[1]) * (c - cols[1]) - (cols[2] - cols[1]) * (r - rows[1]);
+					int w1 = (rows[0] - rows[2]) * (c - cols[2]) - (cols[0] - cols[2]) * (r - rows[2]);
+					int w2 = (rows[1] - rows[0]) * (c - cols[0]) - (cols[1] - cols[0]) * (r - rows[0]);
+					if (area < 0) { w0 = -w0; w1 = -w1; w2 = -w2; }
+					if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+
+					float surface = (w0 * heights[0] + w1 * heights[1] + w2 * heights[2]) / std::abs(area);
+					float height = mHeights[static_cast<size_t>(r) * gridCols + c];
+					maxError = (std::max)(maxError, std::fabs(surface - height));
+				}
+			}
+		}
+	}
+
+	return maxError;
+}
@@ -0,0 +1,88 @@
+/*****************************************************************//**
+ * \file   terrain_rtin.h
+ * \brief  Error-bounded terrain meshing with a right-triangulated
+ *         irregular network (RTIN)
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "structures.h"
+#include "terrain_mesh.h"
+
+class HeightmapImage;
+
+/**
+ * One submesh of the simplified terrain. Triangles are assigned to the
+ * chunk of TerrainLayout that contains their centroid, so every submesh
+ * fits into 16-bit indices.
+ */
+struct TerrainRtinSubmesh
+{
+	UINT ChunkCol = 0;
+	UINT ChunkRow = 0;
+
+	size_t BaseVertex = 0;		// Offset in TerrainRtinMesh::Vertices
+	size_t VertexCount = 0;
+	size_t StartIndex = 0;		// Offset in TerrainRtinMesh::Indices
+	size_t IndexCount = 0;
+};
+
+struct TerrainRtinMesh
+{
+	std::vector<Vertex> Vertices;
+	std::vector<uint16_t> Indices;
+	std::vector<TerrainRtinSubmesh> Submeshes;
+};
+
+/**
+ * Martini-style RTIN mesher. The vertex grid is padded to 2^k + 1
+ * vertices per side and split into right triangles along the longest
+ * edge. The constructor stores, for every vertex, the largest height
+ * error of the triangles that need it, so a mesh for any error bound
+ * is extracted with a single top-down pass.
+ *
+ * Triangles crossing the grid border are always split, triangles
+ * outside of the grid are dropped.
+ */
+class TerrainRtin
+{
+public:
+	TerrainRtin(HeightmapImage& heightmap, const TerrainLayout& layout);
+
+	// Extracts the smallest RTIN mesh whose heights differ from the
+	// full grid by at most maxError world units. Negative maxError
+	// gives the full grid. 0 - success, -1 - maxError is not finite
+	int Extract(float maxError, TerrainRtinMesh& mesh) const;
+
+	// Largest difference between the surface of the mesh and the full
+	// grid heights over all grid vertices the mesh covers
+	float MeasureError(const TerrainRtinMesh& mesh) const;
+
+	// Number of vertices along a side of the padded grid
+	UINT GetSize() const { return mSize; }
+
+private:
+	void CollectTriangles(UINT ax, UINT ay, UINT bx, UINT by, UINT cx, UINT cy,
+		float maxError, std::vector<uint32_t>& triangles) const;
+
+	bool IsOutside(UINT ax, UINT ay, UINT bx, UINT by, UINT cx, UINT cy) const;
+	bool IsInside(UINT ax, UINT ay, UINT bx, UINT by, UINT cx, UINT cy) const;
+
+	Vertex MakeVertex(UINT gridRow, UINT gridCol) const;
+
+	TerrainLayout mLayout;
+	UINT mSize = 0;
+
+	// Grid coordinates: x is the grid column, y is the grid row
+	UINT mLastX = 0;
+	UINT mLastY = 0;
+
+	std::vector<uint8_t> mSamples;		// Heightmap copy, for normals
+	std::vector<float> mHeights;		// GridRows() x GridColumns() world heights
+	std::vector<float> mErrors;			// mSize x mSize vertex errors
+};
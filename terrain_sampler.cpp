@@ -0,0 +1,368 @@
+/*****************************************************************//**
+ * \file   terrain_sampler.cpp
+ * \brief  Terrain height and normal queries at arbitrary positions
+ *
+ * The batch paths evaluate the same expressions in the same order as
+ * the scalar one, without FMA or approximate reciprocals.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "terrain_kernel.h"
+#include "terrain_sampler.h"
+
+using namespace DirectX;
+
+// Constants shared by the batch kernels
+struct sampler_constants
+{
+	const float* pHeights;
+	int Width;
+	float ZeroX;
+	float ZeroZ;
+	float InvDx;
+	float InvDz;
+	float NegInvDx;
+	float MaxU;			// Last row
+	float MaxV;			// Last column
+	float MaxRow;		// Last row a bilinear cell can start at
+	float MaxCol;
+};
+
+static void sample_bilinear_scalar(const sampler_constants& c, const float* pX, const float* pZ,
+	uint32_t begin, uint32_t count, float* pHeights,
+	float* pNormalX, float* pNormalY, float* pNormalZ)
+{
+	for (uint32_t k = begin; k < count; k++)
+	{
+		float u = (pX[k] - c.ZeroX) * c.InvDx;
+		float v = (c.ZeroZ - pZ[k]) * c.InvDz;
+		u = (std::min)((std::max)(u, 0.0f), c.MaxU);
+		v = (std::min)((std::max)(v, 0.0f), c.MaxV);
+
+		float row = (std::min)(std::floor(u), c.MaxRow);
+		float col = (std::min)(std::floor(v), c.MaxCol);
+		float fu = u - row;
+		float fv = v - col;
+
+		const float* p = c.pHeights + (int)row * c.Width + (int)col;
+		float h00 = p[0];
+		float h01 = p[1];
+		float h10 = p[c.Width];
+		float h11 = p[c.Width + 1];
+
+		float a = h00 + (h01 - h00) * fv;
+		float b = h10 + (h11 - h10) * fv;
+		pHeights[k] = a + (b - a) * fu;
+
+		if (pNormalX)
+		{
+			// Gradient of the bilinear patch, Z decreases with column
+			float dhdv = (h01 - h00) + ((h11 - h10) - (h01 - h00)) * fu;
+			float nx = (b - a) * c.NegInvDx;
+			float nz = dhdv * c.InvDz;
+			float length = std::sqrt((nx * nx + 1.0f) + nz * nz);
+
+			pNormalX[k] = nx / length;
+			pNormalY[k] = 1.0f / length;
+			pNormalZ[k] = nz / length;
+		}
+	}
+}
+
+#if SIMD_X86
+
+SIMD_TARGET_SSE41 static uint32_t sample_bilinear_sse41(const sampler_constants& c, const float* pX, const float* pZ,
+	uint32_t count, float* pHeights,
+	float* pNormalX, float* pNormalY, float* pNormalZ)
+{
+	const __m128 zeroX = _mm_set1_ps(c.ZeroX);
+	const __m128 zeroZ = _mm_set1_ps(c.ZeroZ);
+	const __m128 invDx = _mm_set1_ps(c.InvDx);
+	const __m128 invDz = _mm_set1_ps(c.InvDz);
+	const __m128 negInvDx = _mm_set1_ps(c.NegInvDx);
+	const __m128 maxU = _mm_set1_ps(c.MaxU);
+	const __m128 maxV = _mm_set1_ps(c.MaxV);
+	const __m128 maxRow = _mm_set1_ps(c.MaxRow);
+	const __m128 maxCol = _mm_set1_ps(c.MaxCol);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i width = _mm_set1_epi32(c.Width);
+
+	uint32_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		__m128 u = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pX + k), zeroX), invDx);
+		__m128 v = _mm_mul_ps(_mm_sub_ps(zeroZ, _mm_loadu_ps(pZ + k)), invDz);
+		u = _mm_min_ps(_mm_max_ps(u, _mm_setzero_ps()), maxU);
+		v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), maxV);
+
+		__m128 row = _mm_min_ps(_mm_floor_ps(u), maxRow);
+		__m128 col = _mm_min_ps(_mm_floor_ps(v), maxCol);
+		__m128 fu = _mm_sub_ps(u, row);
+		__m128 fv = _mm_sub_ps(v, col);
+
+		// No gather before AVX2, corners are loaded one by one
+		alignas(16) int index[4];
+		_mm_store_si128((__m128i*)index, _mm_add_epi32(
+			_mm_mullo_epi32(_mm_cvttps_epi32(row), width), _mm_cvttps_epi32(col)));
+
+		const float* p0 = c.pHeights + index[0];
+		const float* p1 = c.pHeights + index[1];
+		const float* p2 = c.pHeights + index[2];
+		const float* p3 = c.pHeights + index[3];
+		const int w = c.Width;
+
+		__m128 h00 = _mm_setr_ps(p0[0], p1[0], p2[0], p3[0]);
+		__m128 h01 = _mm_setr_ps(p0[1], p1[1], p2[1], p3[1]);
+		__m128 h10 = _mm_setr_ps(p0[w], p1[w], p2[w], p3[w]);
+		__m128 h11 = _mm_setr_ps(p0[w + 1], p1[w + 1], p2[w + 1], p3[w + 1]);
+
+		__m128 d0 = _mm_sub_ps(h01, h00);
+		__m128 d1 = _mm_sub_ps(h11, h10);
+		__m128 a = _mm_add_ps(h00, _mm_mul_ps(d0, fv));
+		__m128 b = _mm_add_ps(h10, _mm_mul_ps(d1, fv));
+		_mm_storeu_ps(pHeights + k, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fu)));
+
+		if (pNormalX)
+		{
+			__m128 dhdv = _mm_add_ps(d0, _mm_mul_ps(_mm_sub_ps(d1, d0), fu));
+			__m128 nx = _mm_mul_ps(_mm_sub_ps(b, a), negInvDx);
+			__m128 nz = _mm_mul_ps(dhdv, invDz);
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), one), _mm_mul_ps(nz, nz)));
+
+			_mm_storeu_ps(pNormalX + k, _mm_div_ps(nx, length));
+			_mm_storeu_ps(pNormalY + k, _mm_div_ps(one, length));
+			_mm_storeu_ps(pNormalZ + k, _mm_div_ps(nz, length));
+		}
+	}
+	return k;
+}
+
+SIMD_TARGET_AVX2 static uint32_t sample_bilinear_avx2(const sampler_constants& c, const float* pX, const float* pZ,
+	uint32_t count, float* pHeights,
+	float* pNormalX, float* pNormalY, float* pNormalZ)
+{
+	const __m256 zeroX = _mm256_set1_ps(c.ZeroX);
+	const __m256 zeroZ = _mm256_set1_ps(c.ZeroZ);
+	const __m256 invDx = _mm256_set1_ps(c.InvDx);
+	const __m256 invDz = _mm256_set1_ps(c.InvDz);
+	const __m256 negInvDx = _mm256_set1_ps(c.NegInvDx);
+	const __m256 maxU = _mm256_set1_ps(c.MaxU);
+	const __m256 maxV = _mm256_set1_ps(c.MaxV);
+	const __m256 maxRow = _mm256_set1_ps(c.MaxRow);
+	const __m256 maxCol = _mm256_set1_ps(c.MaxCol);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256i width = _mm256_set1_epi32(c.Width);
+	const __m256i next = _mm256_set1_epi32(1);
+
+	// 8 positions per iteration
+	uint32_t k = 0;
+	for (; k + 8 <= count; k += 8)
+	{
+		__m256 u = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(pX + k), zeroX), invDx);
+		__m256 v = _mm256_mul_ps(_mm256_sub_ps(zeroZ, _mm256_loadu_ps(pZ + k)), invDz);
+		u = _mm256_min_ps(_mm256_max_ps(u, _mm256_setzero_ps()), maxU);
+		v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), maxV);
+
+		__m256 row = _mm256_min_ps(_mm256_floor_ps(u), maxRow);
+		__m256 col = _mm256_min_ps(_mm256_floor_ps(v), maxCol);
+		__m256 fu = _mm256_sub_ps(u, row);
+		__m256 fv = _mm256_sub_ps(v, col);
+
+		__m256i i00 = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(row), width), _mm256_cvttps_epi32(col));
+		__m256i i10 = _mm256_add_epi32(i00, width);
+
+		__m256 h00 = _mm256_i32gather_ps(c.pHeights, i00, 4);
+		__m256 h01 = _mm256_i32gather_ps(c.pHeights, _mm256_add_epi32(i00, next), 4);
+		__m256 h10 = _mm256_i32gather_ps(c.pHeights, i10, 4);
+		__m256 h11 = _mm256_i32gather_ps(c.pHeights, _mm256_add_epi32(i10, next), 4);
+
+		__m256 d0 = _mm256_sub_ps(h01, h00);
+		__m256 d1 = _mm256_sub_ps(h11, h10);
+		__m256 a = _mm256_add_ps(h00, _mm256_mul_ps(d0, fv));
+		__m256 b = _mm256_add_ps(h10, _mm256_mul_ps(d1, fv));
+		_mm256_storeu_ps(pHeights + k, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), fu)));
+
+		if (pNormalX)
+		{
+			__m256 dhdv = _mm256_add_ps(d0, _mm256_mul_ps(_mm256_sub_ps(d1, d0), fu));
+			__m256 nx = _mm256_mul_ps(_mm256_sub_ps(b, a), negInvDx);
+			__m256 nz = _mm256_mul_ps(dhdv, invDz);
+			__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), one), _mm256_mul_ps(nz, nz)));
+
+			_mm256_storeu_ps(pNormalX + k, _mm256_div_ps(nx, length));
+			_mm256_storeu_ps(pNormalY + k, _mm256_div_ps(one, length));
+			_mm256_storeu_ps(pNormalZ + k, _mm256_div_ps(nz, length));
+		}
+	}
+	return k;
+}
+
+#endif
+
+TerrainHeightSampler::TerrainHeightSampler(HeightmapImage& heightmap) :
+	mLayout(heightmap.GetWidth(), heightmap.GetHeight())
+{
+	mInvDx = 1.0f / mLayout.Dx;
+	mInvDz = 1.0f / mLayout.Dz;
+
+	mHeights.resize(static_cast<size_t>(mLayout.Depth) * mLayout.Width);
+
+	for (UINT r = 0; r < mLayout.Depth; r++)
+	{
+		const uint8_t* pRow = heightmap.GetRow(r);
+		float* pOut = &mHeights[static_cast<size_t>(r) * mLayout.Width];
+
+		for (UINT c = 0; c < mLayout.Width; c++)
+		{
+			pOut[c] = (float)pRow[c] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+		}
+	}
+}
+
+void TerrainHeightSampler::Refresh(HeightmapImage& heightmap, const TerrainDirtyRect& rect)
+{
+	UINT endRow = (std::min)(rect.EndRow, mLayout.Depth);
+	UINT endCol = (std::min)(rect.EndCol, mLayout.Width);
+
+	for (UINT r = rect.FirstRow; r < endRow; r++)
+	{
+		const uint8_t* pRow = heightmap.GetRow(r);
+		float* pOut = &mHeights[static_cast<size_t>(r) * mLayout.Width];
+
+		for (UINT c = rect.FirstCol; c < endCol; c++)
+		{
+			pOut[c] = (float)pRow[c] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+		}
+	}
+}
+
+void TerrainHeightSampler::ToSampleSpace(float x, float z, float& u, float& v) const
+{
+	u = (x - mLayout.ZeroX) * mInvDx;
+	v = (mLayout.ZeroZ - z) * mInvDz;
+	u = (std::min)((std::max)(u, 0.0f), (float)(mLayout.Depth - 1));
+	v = (std::min)((std::max)(v, 0.0f), (float)(mLayout.Width - 1));
+}
+
+bool TerrainHeightSampler::Contains(float x, float z) const
+{
+	float u = (x - mLayout.ZeroX) * mInvDx;
+	float v = (mLayout.ZeroZ - z) * mInvDz;
+	return u >= 0.0f && u <= (float)(mLayout.Depth - 1) &&
+		v >= 0.0f && v <= (float)(mLayout.Width - 1);
+}
+
+float TerrainHeightSampler::GetHeight(float x, float z) const
+{
+	float height;
+	SampleBatch(&x, &z, 1, &height, nullptr, nullptr, nullptr, SIMD_LEVEL_SCALAR);
+	return height;
+}
+
+// Catmull-Rom weights of the four samples around t and their derivatives
+static void CatmullRomWeights(float t, float weights[4], float derivatives[4])
+{
+	weights[0] = 0.5f * (((-t + 2.0f) * t - 1.0f) * t);
+	weights[1] = 0.5f * (((3.0f * t - 5.0f) * t) * t + 2.0f);
+	weights[2] = 0.5f * (((-3.0f * t + 4.0f) * t + 1.0f) * t);
+	weights[3] = 0.5f * ((t - 1.0f) * t * t);
+
+	derivatives[0] = 0.5f * ((-3.0f * t + 4.0f) * t - 1.0f);
+	derivatives[1] = 0.5f * ((9.0f * t - 10.0f) * t);
+	derivatives[2] = 0.5f * ((-9.0f * t + 8.0f) * t + 1.0f);
+	derivatives[3] = 0.5f * ((3.0f * t - 2.0f) * t);
+}
+
+TerrainSample TerrainHeightSampler::Sample(float x, float z, TERRAIN_FILTER filter) const
+{
+	TerrainSample sample;
+
+	if (filter == TERRAIN_FILTER_BILINEAR)
+	{
+		SampleBatch(&x, &z, 1, &sample.Height,
+			&sample.Normal.x, &sample.Normal.y, &sample.Normal.z, SIMD_LEVEL_SCALAR);
+		return sample;
+	}
+
+	float u, v;
+	ToSampleSpace(x, z, u, v);
+
+	int row = (std::min)((int)u, (int)mLayout.Depth - 2);
+	int col = (std::min)((int)v, (int)mLayout.Width - 2);
+
+	float wu[4], dwu[4], wv[4], dwv[4];
+	CatmullRomWeights(u - row, wu, dwu);
+	CatmullRomWeights(v - col, wv, dwv);
+
+	// Samples past the border repeat the border
+	float height = 0.0f;
+	float dhdu = 0.0f;
+	float dhdv = 0.0f;
+
+	for (int i = 0; i < 4; i++)
+	{
+		int r = (std::min)((std::max)(row + i - 1, 0), (int)mLayout.Depth - 1);
+
+		float line = 0.0f;
+		float lineDerivative = 0.0f;
+		for (int j = 0; j < 4; j++)
+		{
+			int c = (std::min)((std::max)(col + j - 1, 0), (int)mLayout.Width - 1);
+			float h = At(r, c);
+			line += wv[j] * h;
+			lineDerivative += dwv[j] * h;
+		}
+
+		height += wu[i] * line;
+		dhdu += dwu[i] * line;
+		dhdv += wu[i] * lineDerivative;
+	}
+
+	sample.Height = height;
+
+	// Z decreases with column
+	XMFLOAT3 normal(-dhdu * mInvDx, 1.0f, dhdv * mInvDz);
+	XMStoreFloat3(&sample.Normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+
+	return sample;
+}
+
+void TerrainHeightSampler::SampleBatch(const float* pX, const float* pZ, uint32_t count, float* pHeights,
+	float* pNormalX, float* pNormalY, float* pNormalZ, SIMD_LEVEL level) const
+{
+	sampler_constants c;
+	c.pHeights = mHeights.data();
+	c.Width = static_cast<int>(mLayout.Width);
+	c.ZeroX = mLayout.ZeroX;
+	c.ZeroZ = mLayout.ZeroZ;
+	c.InvDx = mInvDx;
+	c.InvDz = mInvDz;
+	c.NegInvDx = -mInvDx;
+	c.MaxU = (float)(mLayout.Depth - 1);
+	c.MaxV = (float)(mLayout.Width - 1);
+	c.MaxRow = (float)(mLayout.Depth - 2);
+	c.MaxCol = (float)(mLayout.Width - 2);
+
+	// Normals are written all together or not at all
+	if (!pNormalY || !pNormalZ) pNormalX = nullptr;
+
+	uint32_t done = 0;
+
+#if SIMD_X86
+	if (level >= SIMD_LEVEL_AVX2)
+	{
+		done = sample_bilinear_avx2(c, pX, pZ, count, pHeights, pNormalX, pNormalY, pNormalZ);
+	}
+	else if (level >= SIMD_LEVEL_SSE41)
+	{
+		done = sample_bilinear_sse41(c, pX, pZ, count, pHeights, pNormalX, pNormalY, pNormalZ);
+	}
+#endif
+
+	// Remaining positions
+	sample_bilinear_scalar(c, pX, pZ, done, count, pHeights, pNormalX, pNormalY, pNormalZ);
+}
@@ -0,0 +1,92 @@
+/*****************************************************************//**
+ * \file   terrain_sampler.h
+ * \brief  Terrain height and normal queries at arbitrary positions
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "image_helper.h"
+#include "simd_util.h"
+#include "terrain_mesh.h"
+
+enum TERRAIN_FILTER
+{
+	TERRAIN_FILTER_BILINEAR = 0,
+	TERRAIN_FILTER_BICUBIC = 1		// Catmull-Rom, passes through the samples
+};
+
+struct TerrainSample
+{
+	float Height = 0.0f;
+	DirectX::XMFLOAT3 Normal = { 0.0f, 1.0f, 0.0f };
+};
+
+/**
+ * World heights over the terrain, all the camera needs to stay above
+ * it. Implemented by TerrainHeightSampler over a heightmap in memory
+ * and by TerrainStreamGround over the tiles of a streamed one.
+ */
+class TerrainGround
+{
+public:
+	virtual ~TerrainGround() { }
+
+	// Bilinear height, positions outside take the nearest border
+	virtual float GetHeight(float x, float z) const = 0;
+
+	virtual const TerrainLayout& GetLayout() const = 0;
+};
+
+/**
+ * Samples the heightmap in world space, with the placement of
+ * TerrainLayout and the heights of ComputeTerrainRow. Positions outside
+ * the heightmap take the height of the nearest border.
+ *
+ * Normals are the gradient of the filtered surface. Queries read four
+ * (bilinear) or sixteen (bicubic) samples and do not allocate.
+ */
+class TerrainHeightSampler : public TerrainGround
+{
+public:
+	TerrainHeightSampler(HeightmapImage& heightmap);
+
+	float GetHeight(float x, float z) const override;
+	TerrainSample Sample(float x, float z, TERRAIN_FILTER filter = TERRAIN_FILTER_BILINEAR) const;
+
+	// Bilinear heights for count positions. Normal outputs may be nullptr,
+	// otherwise they receive the same normals as Sample. All SIMD levels
+	// produce bit-identical results.
+	void SampleBatch(const float* pX, const float* pZ, uint32_t count, float* pHeights,
+		float* pNormalX = nullptr, float* pNormalY = nullptr, float* pNormalZ = nullptr,
+		SIMD_LEVEL level = GetSimdLevel()) const;
+
+	// Reloads the samples of rect after the heightmap was edited
+	void Refresh(HeightmapImage& heightmap, const TerrainDirtyRect& rect);
+
+	// True if the position lies over the heightmap
+	bool Contains(float x, float z) const;
+
+	const TerrainLayout& GetLayout() const override { return mLayout; }
+
+private:
+	// Continuous sample coordinates of a world position, clamped to the map
+	void ToSampleSpace(float x, float z, float& u, float& v) const;
+
+	float At(int row, int col) const
+	{
+		return mHeights[static_cast<size_t>(row) * mLayout.Width + col];
+	}
+
+	TerrainLayout mLayout;
+	float mInvDx = 0.0f;
+	float mInvDz = 0.0f;
+
+	std::vector<float> mHeights;		// Depth x Width world heights, row after row
+};
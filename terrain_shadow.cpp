@@ -0,0 +1,157 @@
+/*****************************************************************//**
+ * \file   terrain_shadow.cpp
+ * \brief  Sun shadow mask of heightmaps with incremental updates
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+
+#include "terrain_shadow.h"
+
+TerrainShadowBaker::TerrainShadowBaker(HeightmapImage& heightmap, const TerrainShadowSettings& settings) :
+	mSettings(settings),
+	mHorizons(heightmap),
+	mWidth(heightmap.GetWidth()),
+	mHeight(heightmap.GetHeight())
+{
+	const size_t count = static_cast<size_t>(mWidth) * mHeight;
+	mElevations.resize(count);
+	mRowBins.resize(static_cast<size_t>(mHeight) * (TERRAIN_SHADOW_ELEVATION_BINS + 1));
+	mRowState.resize(mHeight);
+	mMask.assign(count, 255);
+}
+
+uint32_t TerrainShadowBaker::ElevationBin(float elevation)
+{
+	// Horizons are between 0 and pi / 2
+	float bin = elevation * (TERRAIN_SHADOW_ELEVATION_BINS / DirectX::XM_PIDIV2);
+	bin = (std::min)((std::max)(bin, 0.0f), (float)(TERRAIN_SHADOW_ELEVATION_BINS - 1));
+	return (uint32_t)bin;
+}
+
+void TerrainShadowBaker::RunRows(WorkerPool* pPool, const std::function<void(uint32_t, uint32_t)>& func)
+{
+	if (pPool)
+	{
+		pPool->ParallelFor(mHeight, TERRAIN_SHADOW_ROW_GRAIN, func);
+	}
+	else
+	{
+		func(0, mHeight);
+	}
+}
+
+void TerrainShadowBaker::Sweep(float azimuth, WorkerPool* pPool)
+{
+	mHorizons.BakeDirection(azimuth, mTangents, pPool);
+
+	RunRows(pPool, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t row = begin; row < end; row++)
+		{
+			const size_t base = static_cast<size_t>(row) * mWidth;
+			uint32_t* pBins = &mRowBins[static_cast<size_t>(row) * (TERRAIN_SHADOW_ELEVATION_BINS + 1)];
+			std::fill(pBins, pBins + TERRAIN_SHADOW_ELEVATION_BINS + 1, 0u);
+
+			for (uint32_t col = 0; col < mWidth; col++)
+			{
+				const float elevation = std::atan(mTangents[base + col]);
+				mElevations[base + col] = elevation;
+				pBins[ElevationBin(elevation) + 1]++;
+			}
+
+			for (uint32_t b = 0; b < TERRAIN_SHADOW_ELEVATION_BINS; b++)
+			{
+				pBins[b + 1] += pBins[b];
+			}
+		}
+	});
+
+	mAzimuth = azimuth;
+	mSwept = true;
+}
+
+bool TerrainShadowBaker::UpdateRow(uint32_t row)
+{
+	const size_t base = static_cast<size_t>(row) * mWidth;
+	const float* pElevations = &mElevations[base];
+	uint8_t* pMask = &mMask[base];
+
+	// Visible part of the sun disk, linear over its diameter
+	const float scale = 255.0f / (2.0f * mSettings.SunRadius);
+	const float offset = 127.5f + mElevation * scale;
+
+	bool changed = false;
+	for (uint32_t col = 0; col < mWidth; col++)
+	{
+		float value = offset - pElevations[col] * scale;
+		value = (std::min)((std::max)(value, 0.0f), 255.0f);
+
+		const uint8_t lit = (uint8_t)(value + 0.5f);
+		changed |= lit != pMask[col];
+		pMask[col] = lit;
+	}
+
+	return changed;
+}
+
+TerrainDirtyRect TerrainShadowBaker::SetSun(float azimuth, float elevation, WorkerPool* pPool)
+{
+	mUpdatedRows = 0;
+
+	float turn = std::fabs(azimuth - mAzimuth);
+	turn = std::fmod(turn, DirectX::XM_2PI);
+	turn = (std::min)(turn, DirectX::XM_2PI - turn);
+
+	const bool sweep = !mSwept || turn > mSettings.AzimuthStep;
+	if (!sweep && elevation == mElevation) return TerrainDirtyRect();
+
+	// Rows with a horizon the penumbra passes over between the two
+	// elevations, any row after a sweep
+	const float low = (std::min)(elevation, mElevation) - mSettings.SunRadius;
+	const float high = (std::max)(elevation, mElevation) + mSettings.SunRadius;
+	const uint32_t firstBin = ElevationBin(low);
+	const uint32_t lastBin = ElevationBin(high);
+
+	if (sweep)
+	{
+		Sweep(azimuth, pPool);
+	}
+	mElevation = elevation;
+
+	RunRows(pPool, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t row = begin; row < end; row++)
+		{
+			const uint32_t* pBins = &mRowBins[static_cast<size_t>(row) * (TERRAIN_SHADOW_ELEVATION_BINS + 1)];
+
+			mRowState[row] = 0;
+			if (sweep || pBins[lastBin + 1] > pBins[firstBin])
+			{
+				mRowState[row] = UpdateRow(row) ? 2 : 1;
+			}
+		}
+	});
+
+	TerrainDirtyRect rect;
+	rect.FirstRow = mHeight;
+	for (uint32_t row = 0; row < mHeight; row++)
+	{
+		if (mRowState[row] == 0) continue;
+		mUpdatedRows++;
+
+		if (mRowState[row] == 2)
+		{
+			rect.FirstRow = (std::min)(rect.FirstRow, row);
+			rect.EndRow = row + 1;
+		}
+	}
+
+	if (rect.EndRow == 0) return TerrainDirtyRect();
+
+	rect.FirstCol = 0;
+	rect.EndCol = mWidth;
+	return rect;
+}
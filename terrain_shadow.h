@@ -0,0 +1,94 @@
+/*****************************************************************//**
+ * \file   terrain_shadow.h
+ * \brief  Sun shadow mask of heightmaps with incremental updates
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_horizon.h"
+#include "terrain_mesh.h"
+#include "thread_pool.h"
+
+// Horizon elevations of every row are counted in this many bins, to
+// find the rows a change of the sun elevation affects
+#define TERRAIN_SHADOW_ELEVATION_BINS 256
+
+// Rows processed as one parallel work item
+#define TERRAIN_SHADOW_ROW_GRAIN 16
+
+struct TerrainShadowSettings
+{
+	float SunRadius = 0.01f;		// Angular radius of the sun, in radians, sets the penumbra
+	float AzimuthStep = 0.005f;		// Horizons are swept again when the azimuth moves further
+};
+
+/**
+ * Shadow mask of the terrain lit by the sun: 255 - lit, 0 - shadowed.
+ *
+ * The horizon of every sample towards the sun azimuth is found with one
+ * sweep along the light direction, O(N) per line (see
+ * TerrainHorizonBaker). A sample is lit by the part of the sun disk
+ * above its horizon, so the mask for any sun elevation is a threshold
+ * of the stored horizons.
+ *
+ * When the sun moves, only the rows that hold a horizon between the old
+ * and the new elevation are thresholded again. Horizons are swept again
+ * only when the azimuth moves further than AzimuthStep. SetSun returns
+ * the rows whose mask changed, so only those have to be uploaded.
+ */
+class TerrainShadowBaker
+{
+public:
+	TerrainShadowBaker(HeightmapImage& heightmap,
+		const TerrainShadowSettings& settings = TerrainShadowSettings());
+
+	TerrainShadowBaker(TerrainShadowBaker& other) = delete;
+
+	// Direction to the sun: azimuth as in TerrainHorizonBaker, elevation
+	// above the horizontal plane, both in radians. Runs over pPool,
+	// nullptr runs serially. Returns the rows whose mask changed, all columns.
+	TerrainDirtyRect SetSun(float azimuth, float elevation, WorkerPool* pPool);
+
+	// Width x Height mask, row after row, all lit before the first SetSun
+	const uint8_t* GetMask() const { return mMask.data(); }
+
+	// Rows thresholded by the last SetSun, to measure the update
+	uint32_t GetUpdatedRows() const { return mUpdatedRows; }
+
+	uint32_t GetWidth() const { return mWidth; }
+	uint32_t GetHeight() const { return mHeight; }
+
+private:
+	void Sweep(float azimuth, WorkerPool* pPool);
+	void RunRows(WorkerPool* pPool, const std::function<void(uint32_t, uint32_t)>& func);
+
+	// Thresholds the row for mElevation, returns true if the mask changed
+	bool UpdateRow(uint32_t row);
+
+	static uint32_t ElevationBin(float elevation);
+
+	TerrainShadowSettings mSettings;
+	TerrainHorizonBaker mHorizons;
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+
+	bool mSwept = false;
+	float mAzimuth = 0.0f;				// Azimuth of the stored horizons
+	float mElevation = 0.0f;
+	uint32_t mUpdatedRows = 0;
+
+	std::vector<float> mTangents;
+	std::vector<float> mElevations;		// Horizon elevation of every sample
+	std::vector<uint32_t> mRowBins;		// Cumulative bin counts, BINS + 1 per row
+	std::vector<uint8_t> mRowState;		// Per row: 1 - to update, 2 - mask changed
+	std::vector<uint8_t> mMask;
+};
@@ -0,0 +1,513 @@
+/*****************************************************************//**
+ * \file   terrain_stream.cpp
+ * \brief  Streaming of terrain chunks from heightmaps that do not
+ *         fit into memory
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "image_helper.h"
+#include "image_kernel.h"
+#include "terrain_stream.h"
+
+using namespace DirectX;
+
+HeightmapTileCache::HeightmapTileCache(size_t tileCapacity)
+{
+	// All slots are allocated up front, so memory use does not grow
+	mSlots.resize(tileCapacity);
+	for (size_t i = 0; i < tileCapacity; i++)
+	{
+		mSlots[i].Samples.resize(TERRAIN_TILE_SIZE * TERRAIN_TILE_SIZE);
+		mSlots[i].LruPosition = mLru.insert(mLru.end(), i);
+	}
+}
+
+int HeightmapTileCache::Open(const char* filename)
+{
+	if (mFile.open(filename) != 0) return -1;
+
+	bmp_info info;
+	if (parse_bmp_header(filename, mFile.data(), mFile.size(), info) != 0)
+	{
+		mFile.close();
+		return -1;
+	}
+
+	if (info.bits_per_pixel != 8 || info.width < 3 || info.height < 3)
+	{
+		fprintf(stderr, "%s: only 8-bit heightmaps can be streamed\n", filename);
+		mFile.close();
+		return -1;
+	}
+
+	// Palette entries to gray levels, as read_bmp does
+	memset(mLevels, 0, sizeof(mLevels));
+	for (uint32_t i = 0; i < info.palette_size; i++)
+	{
+		const uint8_t* entry = mFile.data() + info.palette_offset + 4 * i;
+		mLevels[i] = image_luma(entry[0], entry[1], entry[2]);
+	}
+
+	mGrayPalette = info.gray_palette;
+	mTopDown = info.top_down;
+	mWidth = info.width;
+	mHeight = info.height;
+	mPixelOffset = info.pixel_offset;
+	mFilePitch = info.row_pitch;
+
+	// Forget tiles of the previous file
+	std::lock_guard<std::mutex> lock(mMutex);
+	mSlotOfTile.clear();
+	for (tile_slot& slot : mSlots) slot.Key = UINT64_MAX;
+
+	return 0;
+}
+
+void HeightmapTileCache::LoadTile(tile_slot& slot, UINT tileRow, UINT tileCol)
+{
+	UINT firstRow = tileRow * TERRAIN_TILE_SIZE;
+	UINT firstCol = tileCol * TERRAIN_TILE_SIZE;
+	UINT rows = (std::min)((UINT)TERRAIN_TILE_SIZE, mHeight - firstRow);
+	UINT cols = (std::min)((UINT)TERRAIN_TILE_SIZE, mWidth - firstCol);
+
+	// Rows are numbered bottom to top, like in HeightmapImage
+	uint64_t firstFileRow = mTopDown ? mHeight - firstRow - rows : firstRow;
+
+	for (UINT r = 0; r < rows; r++)
+	{
+		uint64_t fileRow = mTopDown ? mHeight - 1 - (firstRow + r) : firstRow + r;
+		const uint8_t* in = mFile.data() + mPixelOffset + fileRow * mFilePitch + firstCol;
+		uint8_t* out = &slot.Samples[(size_t)r * TERRAIN_TILE_SIZE];
+
+		if (mGrayPalette)
+		{
+			memcpy(out, in, cols);
+			continue;
+		}
+
+		for (UINT c = 0; c < cols; c++) out[c] = mLevels[in[c]];
+	}
+
+	mFile.release(mPixelOffset + firstFileRow * mFilePitch, rows * mFilePitch);
+}
+
+HeightmapTileCache::tile_slot& HeightmapTileCache::AcquireTile(UINT tileRow, UINT tileCol,
+	std::unique_lock<std::mutex>& lock)
+{
+	const uint64_t key = ((uint64_t)tileRow << 32) | tileCol;
+
+	for (;;)
+	{
+		auto found = mSlotOfTile.find(key);
+		if (found != mSlotOfTile.end())
+		{
+			tile_slot& slot = mSlots[found->second];
+
+			// Another thread is reading the tile from the file
+			if (slot.Loading)
+			{
+				mSlotCV.wait(lock);
+				continue;
+			}
+
+			slot.Pins++;
+			mLru.splice(mLru.begin(), mLru, slot.LruPosition);
+			return slot;
+		}
+
+		// Replace the least recently used slot nobody copies from
+		auto victim = std::find_if(mLru.rbegin(), mLru.rend(),
+			[&](size_t index) { return mSlots[index].Pins == 0; });
+
+		if (victim == mLru.rend())
+		{
+			mSlotCV.wait(lock);
+			continue;
+		}
+
+		size_t index = *victim;
+		tile_slot& slot = mSlots[index];
+
+		if (slot.Key != UINT64_MAX) mSlotOfTile.erase(slot.Key);
+		slot.Key = key;
+		slot.Pins = 1;
+		slot.Loading = true;
+		mSlotOfTile[key] = index;
+		mLru.splice(mLru.begin(), mLru, slot.LruPosition);
+
+		// Read outside of the lock, other tiles stay available
+		lock.unlock();
+		LoadTile(slot, tileRow, tileCol);
+		lock.lock();
+
+		slot.Loading = false;
+		mTileLoads++;
+		mSlotCV.notify_all();
+		return slot;
+	}
+}
+
+void HeightmapTileCache::ReadWindow(UINT firstRow, UINT firstCol, UINT rows, UINT cols,
+	uint8_t* pDst, size_t dstPitch)
+{
+	const UINT endRow = firstRow + rows;
+	const UINT endCol = firstCol + cols;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (UINT tileRow = firstRow / TERRAIN_TILE_SIZE; tileRow * TERRAIN_TILE_SIZE < endRow; tileRow++)
+	{
+		for (UINT tileCol = firstCol / TERRAIN_TILE_SIZE; tileCol * TERRAIN_TILE_SIZE < endCol; tileCol++)
+		{
+			// Part of the window covered by the tile
+			UINT tileFirstRow = tileRow * TERRAIN_TILE_SIZE;
+			UINT tileFirstCol = tileCol * TERRAIN_TILE_SIZE;
+			UINT r0 = (std::max)(firstRow, tileFirstRow);
+			UINT r1 = (std::min)(endRow, tileFirstRow + TERRAIN_TILE_SIZE);
+			UINT c0 = (std::max)(firstCol, tileFirstCol);
+			UINT c1 = (std::min)(endCol, tileFirstCol + TERRAIN_TILE_SIZE);
+
+			tile_slot& slot = AcquireTile(tileRow, tileCol, lock);
+
+			// Pinned slot is not replaced, copy without the lock
+			lock.unlock();
+			for (UINT r = r0; r < r1; r++)
+			{
+				memcpy(pDst + (size_t)(r - firstRow) * dstPitch + (c0 - firstCol),
+					&slot.Samples[(size_t)(r - tileFirstRow) * TERRAIN_TILE_SIZE + (c0 - tileFirstCol)],
+					c1 - c0);
+			}
+			lock.lock();
+
+			if (--slot.Pins == 0) mSlotCV.notify_all();
+		}
+	}
+}
+
+TerrainStreamGround::TerrainStreamGround(HeightmapTileCache& cache) :
+	mCache(cache), mLayout(cache.GetWidth(), cache.GetHeight())
+{
+	mInvDx = 1.0f / mLayout.Dx;
+	mInvDz = 1.0f / mLayout.Dz;
+}
+
+float TerrainStreamGround::GetHeight(float x, float z) const
+{
+	// The expressions of the scalar TerrainHeightSampler::SampleBatch
+	float u = (x - mLayout.ZeroX) * mInvDx;
+	float v = (mLayout.ZeroZ - z) * mInvDz;
+	u = (std::min)((std::max)(u, 0.0f), (float)(mLayout.Depth - 1));
+	v = (std::min)((std::max)(v, 0.0f), (float)(mLayout.Width - 1));
+
+	float row = (std::min)(std::floor(u), (float)(mLayout.Depth - 2));
+	float col = (std::min)(std::floor(v), (float)(mLayout.Width - 2));
+	float fu = u - row;
+	float fv = v - col;
+
+	uint8_t samples[4];
+	mCache.ReadWindow((UINT)row, (UINT)col, 2, 2, samples, 2);
+
+	float h00 = (float)samples[0] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+	float h01 = (float)samples[1] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+	float h10 = (float)samples[2] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+	float h11 = (float)samples[3] * TERRAIN_HEIGHT_SCALE + TERRAIN_HEIGHT_OFFSET;
+
+	float a = h00 + (h01 - h00) * fv;
+	float b = h10 + (h11 - h10) * fv;
+	return a + (b - a) * fu;
+}
+
+TerrainStreamer::TerrainStreamer(HeightmapTileCache& cache, const TerrainStreamSettings& settings) :
+	mCache(cache), mSettings(settings), mLayout(cache.GetWidth(), cache.GetHeight())
+{
+	for (UINT i = 0; i < (std::max)(settings.ThreadCount, 1u); i++)
+	{
+		mWorkers.emplace_back(&TerrainStreamer::WorkerMain, this);
+	}
+}
+
+TerrainStreamer::~TerrainStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mWakeCV.notify_all();
+
+	for (std::thread& worker : mWorkers) worker.join();
+}
+
+float TerrainStreamer::ChunkDistance(uint32_t id, const XMFLOAT3& eye) const
+{
+	TerrainChunk chunk = mLayout.GetChunk(id / mLayout.ChunkRows(), id % mLayout.ChunkRows());
+
+	// Grid rows run along X, columns along Z towards negative values
+	float minX = mLayout.WorldX(chunk.FirstRow + 1);
+	float maxX = mLayout.WorldX(chunk.FirstRow + chunk.NumRows);
+	float minZ = mLayout.WorldZ(chunk.FirstCol + chunk.NumCols);
+	float maxZ = mLayout.WorldZ(chunk.FirstCol + 1);
+
+	float dx = (std::max)((std::max)(minX - eye.x, eye.x - maxX), 0.0f);
+	float dz = (std::max)((std::max)(minZ - eye.z, eye.z - maxZ), 0.0f);
+	return std::sqrt(dx * dx + dz * dz);
+}
+
+void TerrainStreamer::Update(const XMFLOAT3& eye, std::vector<uint32_t>* pEvicted)
+{
+	const UINT chunkRows = mLayout.ChunkRows();
+	const UINT chunkCols = mLayout.ChunkColumns();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	// Drop chunks out of range. Queued and building ones are skipped
+	// by the workers, ready ones are dropped by TakeReadyChunks
+	for (auto it = mResident.begin(); it != mResident.end(); )
+	{
+		if (ChunkDistance(it->first, eye) > mSettings.EvictRadius)
+		{
+			if (pEvicted && it->second == CHUNK_STATE_TAKEN) pEvicted->push_back(it->first);
+			it = mResident.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// Grid row g lies at x = ZeroX + (g + 1) * Dx, column h at z = ZeroZ - (h + 1) * Dz.
+	// The square around the eye is widened by a chunk, ChunkDistance does the exact test
+	auto chunkIndex = [](float grid, UINT count)
+	{
+		float index = grid / TERRAIN_CHUNK_QUADS;
+		return (UINT)(std::min)((std::max)(index, 0.0f), (float)(count - 1));
+	};
+
+	const float radius = mSettings.LoadRadius;
+	const float margin = 1.0f + TERRAIN_CHUNK_QUADS;
+
+	UINT firstRow = chunkIndex((eye.x - radius - mLayout.ZeroX) / mLayout.Dx - margin, chunkRows);
+	UINT lastRow = chunkIndex((eye.x + radius - mLayout.ZeroX) / mLayout.Dx, chunkRows);
+	UINT firstCol = chunkIndex((mLayout.ZeroZ - eye.z - radius) / mLayout.Dz - margin, chunkCols);
+	UINT lastCol = chunkIndex((mLayout.ZeroZ - eye.z + radius) / mLayout.Dz, chunkCols);
+
+	bool added = false;
+	for (UINT chunkCol = firstCol; chunkCol <= lastCol; chunkCol++)
+	{
+		for (UINT chunkRow = firstRow; chunkRow <= lastRow; chunkRow++)
+		{
+			uint32_t id = chunkCol * chunkRows + chunkRow;
+			if (mResident.count(id) || ChunkDistance(id, eye) > radius) continue;
+
+			mResident[id] = CHUNK_STATE_QUEUED;
+			mQueue.push_back(id);
+			added = true;
+		}
+	}
+
+	if (!added) return;
+
+	// Nearest chunks first, stale entries are removed
+	std::vector<std::pair<float, uint32_t>> order;
+	for (uint32_t id : mQueue)
+	{
+		auto found = mResident.find(id);
+		if (found != mResident.end() && found->second == CHUNK_STATE_QUEUED)
+		{
+			order.push_back(std::make_pair(ChunkDistance(id, eye), id));
+		}
+	}
+	std::sort(order.begin(), order.end());
+	order.erase(std::unique(order.begin(), order.end()), order.end());
+
+	mQueue.clear();
+	for (const auto& entry : order) mQueue.push_back(entry.second);
+
+	lock.unlock();
+	mWakeCV.notify_all();
+}
+
+void TerrainStreamer::TakeReadyChunks(std::vector<std::unique_ptr<TerrainStreamChunk>>& chunks)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (std::unique_ptr<TerrainStreamChunk>& chunk : mReady)
+	{
+		uint32_t id = chunk->ChunkCol * mLayout.ChunkRows() + chunk->ChunkRow;
+
+		// Chunk may have been evicted while waiting
+		auto found = mResident.find(id);
+		if (found == mResident.end() || found->second != CHUNK_STATE_READY) continue;
+
+		found->second = CHUNK_STATE_TAKEN;
+		chunks.push_back(std::move(chunk));
+	}
+	mReady.clear();
+}
+
+void TerrainStreamer::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdleCV.wait(lock, [this] { return mQueue.empty() && mBusyWorkers == 0; });
+}
+
+void TerrainStreamer::BuildChunk(uint32_t id, std::vector<uint8_t>& window, TerrainStreamChunk& chunk)
+{
+	TerrainChunk terrainChunk = mLayout.GetChunk(id / mLayout.ChunkRows(), id % mLayout.ChunkRows());
+
+	// Vertices need one more sample on every side for normals
+	UINT windowRows = terrainChunk.NumRows + 2;
+	UINT windowCols = terrainChunk.NumCols + 2;
+	window.resize((size_t)windowRows * windowCols);
+
+	mCache.ReadWindow(terrainChunk.FirstRow, terrainChunk.FirstCol, windowRows, windowCols,
+		window.data(), windowCols);
+
+	chunk.ChunkCol = id / mLayout.ChunkRows();
+	chunk.ChunkRow = id % mLayout.ChunkRows();
+	chunk.Vertices.resize(terrainChunk.VertexCount());
+	chunk.Indices.resize(terrainChunk.IndexCount());
+
+	WriteTerrainVertices(window.data(), windowCols, mLayout, terrainChunk,
+		0, terrainChunk.NumCols, chunk.Vertices.data());
+	WriteTerrainIndices(terrainChunk, 0, terrainChunk.NumCols - 1, chunk.Indices.data());
+}
+
+void TerrainStreamer::WorkerMain()
+{
+	std::vector<uint8_t> window;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (;;)
+	{
+		mWakeCV.wait(lock, [this] { return mExit || !mQueue.empty(); });
+		if (mExit) return;
+
+		uint32_t id = mQueue.front();
+		mQueue.pop_front();
+
+		// Skip chunks evicted or already taken by another worker
+		auto found = mResident.find(id);
+		if (found == mResident.end() || found->second != CHUNK_STATE_QUEUED)
+		{
+			if (mQueue.empty() && mBusyWorkers == 0) mIdleCV.notify_all();
+			continue;
+		}
+
+		found->second = CHUNK_STATE_BUILDING;
+		mBusyWorkers++;
+		lock.unlock();
+
+		std::unique_ptr<TerrainStreamChunk> chunk(new TerrainStreamChunk());
+		BuildChunk(id, window, *chunk);
+
+		lock.lock();
+		mBusyWorkers--;
+
+		found = mResident.find(id);
+		if (found != mResident.end() && found->second == CHUNK_STATE_BUILDING)
+		{
+			found->second = CHUNK_STATE_READY;
+			mReady.push_back(std::move(chunk));
+		}
+
+		if (mQueue.empty() && mBusyWorkers == 0) mIdleCV.notify_all();
+	}
+}
+
+TerrainStreamSlots::TerrainStreamSlots(HeightmapTileCache& cache, UINT slotCount,
+	const TerrainStreamSettings& settings) :
+	mStreamer(cache, settings), mSlots(slotCount)
+{
+	// Lowest slots are taken first
+	for (UINT i = slotCount; i > 0; i--) mFreeSlots.push_back(i - 1);
+}
+
+void TerrainStreamSlots::Update(const XMFLOAT3& eye)
+{
+	mEvicted.clear();
+	mStreamer.Update(eye, &mEvicted);
+
+	const UINT chunkRows = mStreamer.GetLayout().ChunkRows();
+
+	for (uint32_t id : mEvicted)
+	{
+		auto found = mSlotOfChunk.find(id);
+		if (found != mSlotOfChunk.end())
+		{
+			mSlots[found->second].Used = false;
+			mFreeSlots.push_back(found->second);
+			mSlotOfChunk.erase(found);
+			continue;
+		}
+
+		// Evicted before it was uploaded
+		auto waiting = std::find_if(mWaiting.begin(), mWaiting.end(),
+			[&](const std::unique_ptr<TerrainStreamChunk>& chunk)
+			{
+				return chunk->ChunkCol * chunkRows + chunk->ChunkRow == id;
+			});
+		if (waiting != mWaiting.end()) mWaiting.erase(waiting);
+	}
+
+	mTaken.clear();
+	mStreamer.TakeReadyChunks(mTaken);
+	for (std::unique_ptr<TerrainStreamChunk>& chunk : mTaken)
+	{
+		mWaiting.push_back(std::move(chunk));
+	}
+}
+
+UINT TerrainStreamSlots::PrepareUpload(uint8_t* pStaging, UINT maxChunks,
+	std::vector<TerrainStreamCopy>& copies)
+{
+	copies.clear();
+
+	const UINT chunkRows = mStreamer.GetLayout().ChunkRows();
+
+	while (copies.size() < maxChunks && !mWaiting.empty() && !mFreeSlots.empty())
+	{
+		std::unique_ptr<TerrainStreamChunk> chunk = std::move(mWaiting.front());
+		mWaiting.pop_front();
+
+		TerrainStreamCopy copy;
+		copy.Slot = mFreeSlots.back();
+		copy.StagingOffset = (UINT64)copies.size() * TERRAIN_STREAM_SLOT_BYTES;
+		copy.VertexCount = (UINT)chunk->Vertices.size();
+		copy.IndexCount = (UINT)chunk->Indices.size();
+		mFreeSlots.pop_back();
+
+		uint8_t* pDst = pStaging + copy.StagingOffset;
+		memcpy(pDst, chunk->Vertices.data(), chunk->Vertices.size() * sizeof(Vertex));
+		memcpy(pDst + chunk->Vertices.size() * sizeof(Vertex), chunk->Indices.data(),
+			chunk->Indices.size() * sizeof(uint16_t));
+
+		stream_slot& slot = mSlots[copy.Slot];
+		slot.Used = true;
+		slot.Submesh.IndexCount = copy.IndexCount;
+		slot.Submesh.StartIndexLocation = copy.Slot * TERRAIN_STREAM_SLOT_INDICES;
+		slot.Submesh.BaseVertexLocation = (INT)(copy.Slot * TERRAIN_STREAM_SLOT_VERTICES);
+		ComputeBounds(&chunk->Vertices[0].Pos, chunk->Vertices.size(), sizeof(Vertex),
+			slot.Submesh.Bounds, slot.Submesh.Sphere);
+
+		mSlotOfChunk[chunk->ChunkCol * chunkRows + chunk->ChunkRow] = copy.Slot;
+		copies.push_back(copy);
+	}
+
+	return (UINT)copies.size();
+}
+
+void TerrainStreamSlots::GetVisible(const Frustum& frustum, std::vector<SubmeshGeometry>& submeshes) const
+{
+	submeshes.clear();
+
+	for (const stream_slot& slot : mSlots)
+	{
+		if (slot.Used && frustum.IntersectsBox(slot.Submesh.Bounds)) submeshes.push_back(slot.Submesh);
+	}
+}
@@ -0,0 +1,265 @@
+/*****************************************************************//**
+ * \file   terrain_stream.h
+ * \brief  Streaming of terrain chunks from heightmaps that do not
+ *         fit into memory
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "frustum.h"
+#include "memory_util.h"
+#include "structures.h"
+#include "terrain_mesh.h"
+#include "terrain_sampler.h"
+
+// Heightmap samples along the side of a cached tile
+#define TERRAIN_TILE_SIZE 256
+
+// Heightmap tiles cached while streaming, 64 KiB each
+#define TERRAIN_STREAM_TILE_CAPACITY 64
+
+// Chunk meshes the GPU buffers hold at once
+#define TERRAIN_STREAM_SLOTS 64
+
+// Every slot has room for the largest chunk
+#define TERRAIN_STREAM_SLOT_VERTICES ((TERRAIN_CHUNK_QUADS + 1) * (TERRAIN_CHUNK_QUADS + 1))
+#define TERRAIN_STREAM_SLOT_INDICES (TERRAIN_CHUNK_QUADS * TERRAIN_CHUNK_QUADS * 6)
+
+// Staging bytes of one chunk, vertices followed by indices
+#define TERRAIN_STREAM_SLOT_BYTES \
+	(TERRAIN_STREAM_SLOT_VERTICES * sizeof(Vertex) + TERRAIN_STREAM_SLOT_INDICES * sizeof(uint16_t))
+
+// Chunks copied to the GPU in one frame, bounds the staging buffer
+#define TERRAIN_STREAM_UPLOADS_PER_FRAME 4
+
+/**
+ * Heightmap tiles cached in a fixed number of slots. The 8-bit BMP is
+ * mapped, tiles are copied out on demand and the least recently used
+ * tile is replaced. Mapped pages are released after every copy, so
+ * resident memory is bounded by the slot count, whatever the file size.
+ */
+class HeightmapTileCache
+{
+public:
+	explicit HeightmapTileCache(size_t tileCapacity);
+
+	HeightmapTileCache(HeightmapTileCache& other) = delete;
+
+	// Maps an uncompressed 8-bit BMP, palette entries are read as gray
+	// levels like in HeightmapImage. 0 - success, -1 - error
+	int Open(const char* filename);
+
+	// Copies samples [firstRow, firstRow + rows) x [firstCol, firstCol + cols)
+	// to pDst. May be called from several threads, every caller pins
+	// one tile at a time, so capacity must exceed the number of callers.
+	void ReadWindow(UINT firstRow, UINT firstCol, UINT rows, UINT cols,
+		uint8_t* pDst, size_t dstPitch);
+
+	UINT GetWidth() const { return mWidth; }
+	UINT GetHeight() const { return mHeight; }
+
+	size_t GetTileCapacity() const { return mSlots.size(); }
+	uint64_t GetTileLoads() const { return mTileLoads; }
+
+private:
+	struct tile_slot
+	{
+		uint64_t Key = UINT64_MAX;					// TileRow << 32 | TileCol
+		UINT Pins = 0;								// Readers copying from the slot
+		bool Loading = false;
+		std::vector<uint8_t> Samples;				// TERRAIN_TILE_SIZE^2, row after row
+		std::list<size_t>::iterator LruPosition;
+	};
+
+	// Returns a pinned slot holding the tile, loads it if needed
+	tile_slot& AcquireTile(UINT tileRow, UINT tileCol, std::unique_lock<std::mutex>& lock);
+	void LoadTile(tile_slot& slot, UINT tileRow, UINT tileCol);
+
+	mapped_file mFile;
+
+	UINT mWidth = 0;
+	UINT mHeight = 0;
+	uint64_t mPixelOffset = 0;
+	uint64_t mFilePitch = 0;
+	bool mTopDown = false;
+	bool mGrayPalette = true;						// Entry i is (i, i, i), samples are copied as they are
+	uint8_t mLevels[256] = { };						// Gray level of every palette entry
+
+	std::mutex mMutex;
+	std::condition_variable mSlotCV;				// Signals finished loads and unpinned slots
+	std::vector<tile_slot> mSlots;
+	std::list<size_t> mLru;							// Most recently used first
+	std::unordered_map<uint64_t, size_t> mSlotOfTile;
+	std::atomic<uint64_t> mTileLoads{ 0 };
+};
+
+/**
+ * Heights of a streamed heightmap, read from the tile cache. Every query
+ * copies the 2 x 2 samples around the position, so the whole heightmap
+ * is never held in memory. Heights are bit-identical to GetHeight of a
+ * TerrainHeightSampler over the same heightmap.
+ */
+class TerrainStreamGround : public TerrainGround
+{
+public:
+	// The cache must be open and is read by every query
+	explicit TerrainStreamGround(HeightmapTileCache& cache);
+
+	float GetHeight(float x, float z) const override;
+
+	const TerrainLayout& GetLayout() const override { return mLayout; }
+
+private:
+	HeightmapTileCache& mCache;
+	TerrainLayout mLayout;
+	float mInvDx = 0.0f;
+	float mInvDz = 0.0f;
+};
+
+struct TerrainStreamSettings
+{
+	float LoadRadius = 256.0f;		// Chunks closer than this are meshed
+	float EvictRadius = 320.0f;		// Chunks farther than this are dropped
+	UINT ThreadCount = 2;			// Background meshing threads
+};
+
+// Finished chunk mesh, 16-bit indices relative to the first vertex
+struct TerrainStreamChunk
+{
+	UINT ChunkCol = 0;
+	UINT ChunkRow = 0;
+	std::vector<Vertex> Vertices;
+	std::vector<uint16_t> Indices;
+};
+
+/**
+ * Keeps terrain chunks around the camera meshed. Update queues chunks
+ * entering LoadRadius, nearest first, and evicts chunks leaving
+ * EvictRadius. Background threads mesh queued chunks from the tile
+ * cache. Finished meshes are handed over by TakeReadyChunks.
+ */
+class TerrainStreamer
+{
+public:
+	// The cache must be open, its size defines the terrain layout
+	TerrainStreamer(HeightmapTileCache& cache,
+		const TerrainStreamSettings& settings = TerrainStreamSettings());
+	~TerrainStreamer();
+
+	TerrainStreamer(TerrainStreamer& other) = delete;
+
+	// Call once per frame. Taken chunks that left EvictRadius are
+	// appended to pEvicted as ChunkCol * ChunkRows() + ChunkRow
+	void Update(const DirectX::XMFLOAT3& eye, std::vector<uint32_t>* pEvicted = nullptr);
+
+	// Moves finished meshes of resident chunks to chunks
+	void TakeReadyChunks(std::vector<std::unique_ptr<TerrainStreamChunk>>& chunks);
+
+	// Blocks until the queue is empty and no chunk is being meshed
+	void WaitIdle();
+
+	const TerrainLayout& GetLayout() const { return mLayout; }
+	size_t GetResidentChunkCount() const { return mResident.size(); }
+
+private:
+	enum CHUNK_STATE
+	{
+		CHUNK_STATE_QUEUED,
+		CHUNK_STATE_BUILDING,
+		CHUNK_STATE_READY,			// Mesh is waiting in mReady
+		CHUNK_STATE_TAKEN			// Mesh is owned by the caller
+	};
+
+	void WorkerMain();
+	void BuildChunk(uint32_t id, std::vector<uint8_t>& window, TerrainStreamChunk& chunk);
+	float ChunkDistance(uint32_t id, const DirectX::XMFLOAT3& eye) const;
+
+	HeightmapTileCache& mCache;
+	TerrainStreamSettings mSettings;
+	TerrainLayout mLayout;
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mMutex;
+	std::condition_variable mWakeCV;
+	std::condition_variable mIdleCV;
+	std::unordered_map<uint32_t, CHUNK_STATE> mResident;
+	std::deque<uint32_t> mQueue;
+	std::vector<std::unique_ptr<TerrainStreamChunk>> mReady;
+	UINT mBusyWorkers = 0;
+	bool mExit = false;
+};
+
+// Copy of a chunk from the staging buffer to its slot of the GPU buffers
+struct TerrainStreamCopy
+{
+	UINT Slot = 0;
+	UINT64 StagingOffset = 0;		// Bytes, indices follow the vertices
+	UINT VertexCount = 0;
+	UINT IndexCount = 0;
+};
+
+/**
+ * Places streamed chunks in a fixed number of slots of the GPU vertex
+ * and index buffers, so their size does not depend on the heightmap.
+ * Slot i starts at vertex i * TERRAIN_STREAM_SLOT_VERTICES and index
+ * i * TERRAIN_STREAM_SLOT_INDICES. Slots of evicted chunks are reused,
+ * finished meshes wait while every slot is taken.
+ */
+class TerrainStreamSlots
+{
+public:
+	TerrainStreamSlots(HeightmapTileCache& cache, UINT slotCount = TERRAIN_STREAM_SLOTS,
+		const TerrainStreamSettings& settings = TerrainStreamSettings());
+
+	TerrainStreamSlots(TerrainStreamSlots& other) = delete;
+
+	// Call once per frame. Frees slots of evicted chunks and collects
+	// finished meshes
+	void Update(const DirectX::XMFLOAT3& eye);
+
+	// Writes up to maxChunks waiting meshes to pStaging,
+	// TERRAIN_STREAM_SLOT_BYTES apart, and lists their copies.
+	// Returns the number of chunks staged.
+	UINT PrepareUpload(uint8_t* pStaging, UINT maxChunks, std::vector<TerrainStreamCopy>& copies);
+
+	// Submeshes of the uploaded chunks inside the frustum, offsets are
+	// into the slot buffers
+	void GetVisible(const Frustum& frustum, std::vector<SubmeshGeometry>& submeshes) const;
+
+	TerrainStreamer& GetStreamer() { return mStreamer; }
+	UINT GetSlotCount() const { return (UINT)mSlots.size(); }
+	UINT GetUsedSlotCount() const { return (UINT)mSlotOfChunk.size(); }
+	size_t GetWaitingChunkCount() const { return mWaiting.size(); }
+
+private:
+	struct stream_slot
+	{
+		bool Used = false;
+		SubmeshGeometry Submesh;
+	};
+
+	TerrainStreamer mStreamer;
+
+	std::vector<stream_slot> mSlots;
+	std::vector<UINT> mFreeSlots;
+	std::unordered_map<uint32_t, UINT> mSlotOfChunk;
+	std::deque<std::unique_ptr<TerrainStreamChunk>> mWaiting;	// Taken, not uploaded yet
+
+	std::vector<uint32_t> mEvicted;
+	std::vector<std::unique_ptr<TerrainStreamChunk>> mTaken;
+};
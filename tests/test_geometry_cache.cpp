@@ -0,0 +1,326 @@
+/*****************************************************************//**
+ * \file   test_geometry_cache.cpp
+ * \brief  Terrain mesh cache files: hits, stale keys, truncated and
+ *         corrupted files
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "geometry_cache.h"
+#include "image_helper.h"
+#include "memory_util.h"
+#include "terrain_mesh.h"
+#include "test_util.h"
+#include "tests.h"
+
+#define TEST_CACHE_FILE "test_geometry_cache.geocache"
+#define TEST_CACHE_DAMAGED "test_geometry_cache_damaged.geocache"
+
+// Two chunks in each direction, the last ones narrower
+#define TEST_CACHE_WIDTH 200
+#define TEST_CACHE_HEIGHT 150
+
+// Samples of the test terrain
+static void FillHeightmap(HeightmapImage& heightmap)
+{
+	for (uint32_t row = 0; row < heightmap.GetHeight(); row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < heightmap.GetWidth(); col++)
+		{
+			pRow[col] = (uint8_t)((row * 3 + col * 5) ^ (row / 7));
+		}
+	}
+}
+
+static uint64_t Key(const HeightmapImage& heightmap)
+{
+	return TerrainCacheKey(heightmap, sizeof(Vertex), sizeof(uint16_t), false);
+}
+
+// Generated mesh and its records, as CreateTerrainCached stores them
+struct cached_mesh
+{
+	TerrainMeshData Mesh;
+	std::vector<geometry_cache_submesh> Submeshes;
+	std::vector<std::vector<uint32_t>> Remaps;
+};
+
+static int WriteCache(HeightmapImage& heightmap, cached_mesh& cached)
+{
+	TerrainLayout layout(heightmap.GetWidth(), heightmap.GetHeight());
+	BuildTerrainMesh(heightmap, layout, cached.Mesh, nullptr);
+
+	// Remaps reversed, so they are not confused with positions
+	for (const TerrainChunk& chunk : cached.Mesh.Chunks)
+	{
+		geometry_cache_submesh record;
+		record.IndexCount = (uint32_t)chunk.IndexCount();
+		record.StartIndex = (uint32_t)chunk.StartIndex;
+		record.BaseVertex = (int32_t)chunk.BaseVertex;
+		record.VertexCount = (uint32_t)chunk.VertexCount();
+		cached.Submeshes.push_back(record);
+
+		std::vector<uint32_t> remap(chunk.VertexCount());
+		for (size_t i = 0; i < remap.size(); i++) remap[i] = (uint32_t)(remap.size() - 1 - i);
+		cached.Remaps.push_back(remap);
+	}
+
+	geometry_cache_header header;
+	header.Key = Key(heightmap);
+	header.VertexStride = sizeof(Vertex);
+	header.IndexStride = sizeof(uint16_t);
+	header.VertexCount = cached.Mesh.Vertices.size();
+	header.IndexCount = cached.Mesh.Indices.size();
+
+	return WriteGeometryCache(TEST_CACHE_FILE, header, cached.Submeshes, cached.Remaps,
+		cached.Mesh.Vertices.data(), cached.Mesh.Indices.data());
+}
+
+static std::vector<uint8_t> ReadFile(const char* path)
+{
+	std::vector<uint8_t> bytes;
+	FILE* pFile = fopen(path, "rb");
+	if (!pFile) return bytes;
+
+	uint8_t chunk[4096];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), pFile)) > 0) bytes.insert(bytes.end(), chunk, chunk + read);
+	fclose(pFile);
+	return bytes;
+}
+
+static bool WriteFile(const char* path, const std::vector<uint8_t>& bytes)
+{
+	FILE* pFile = fopen(path, "wb");
+	if (!pFile) return false;
+	const bool written = fwrite(bytes.data(), 1, bytes.size(), pFile) == bytes.size();
+	return fclose(pFile) == 0 && written;
+}
+
+template<typename TValue>
+static void Poke(std::vector<uint8_t>& bytes, uint64_t offset, TValue value)
+{
+	memcpy(&bytes[(size_t)offset], &value, sizeof(value));
+}
+
+template<typename TValue>
+static TValue Peek(const std::vector<uint8_t>& bytes, uint64_t offset)
+{
+	TValue value;
+	memcpy(&value, &bytes[(size_t)offset], sizeof(value));
+	return value;
+}
+
+// Opens the damaged copy with the key of the intact file, true on a hit
+static bool Hits(const std::vector<uint8_t>& bytes, uint64_t key)
+{
+	if (!WriteFile(TEST_CACHE_DAMAGED, bytes)) return true;
+
+	mapped_file file;
+	geometry_cache_view view;
+	return OpenGeometryCache(file, TEST_CACHE_DAMAGED, key, sizeof(Vertex), sizeof(uint16_t), view) == 0;
+}
+
+// A cache opened for the heightmap it was written for holds the mesh byte for byte
+static int TestHit(HeightmapImage& heightmap, const cached_mesh& cached)
+{
+	int failures = 0;
+
+	mapped_file file;
+	geometry_cache_view view;
+	CHECK(OpenGeometryCache(file, TEST_CACHE_FILE, Key(heightmap), sizeof(Vertex), sizeof(uint16_t), view) == 0);
+	if (failures) return failures;
+
+	const geometry_cache_header& header = *view.pHeader;
+	const TerrainMeshData& mesh = cached.Mesh;
+	CHECK(header.SubmeshCount == mesh.Chunks.size());
+	CHECK(header.VertexCount == mesh.Vertices.size());
+	CHECK(header.IndexCount == mesh.Indices.size());
+	if (failures) return failures;
+
+	CHECK(memcmp(view.pVertices, mesh.Vertices.data(), mesh.Vertices.size() * sizeof(Vertex)) == 0);
+	CHECK(memcmp(view.pIndices, mesh.Indices.data(), mesh.Indices.size() * sizeof(uint16_t)) == 0);
+
+	// Sections can be read in place
+	CHECK(header.SubmeshOffset % GEOMETRY_CACHE_ALIGNMENT == 0);
+	CHECK(header.RemapOffset % GEOMETRY_CACHE_ALIGNMENT == 0);
+	CHECK(header.VertexOffset % GEOMETRY_CACHE_ALIGNMENT == 0);
+	CHECK(header.IndexOffset % GEOMETRY_CACHE_ALIGNMENT == 0);
+
+	const uint32_t* pRemap = view.pRemaps;
+	for (uint32_t i = 0; i < header.SubmeshCount; i++)
+	{
+		const geometry_cache_submesh& record = view.pSubmeshes[i];
+		CHECK(record.IndexCount == cached.Submeshes[i].IndexCount);
+		CHECK(record.StartIndex == cached.Submeshes[i].StartIndex);
+		CHECK(record.BaseVertex == cached.Submeshes[i].BaseVertex);
+		CHECK(record.VertexCount == cached.Submeshes[i].VertexCount);
+		CHECK(memcmp(pRemap, cached.Remaps[i].data(), cached.Remaps[i].size() * sizeof(uint32_t)) == 0);
+		pRemap += record.VertexCount;
+	}
+
+	return failures;
+}
+
+// Another heightmap or generator misses, the same samples read again hit
+static int TestStale(HeightmapImage& heightmap)
+{
+	int failures = 0;
+	const uint64_t key = Key(heightmap);
+
+	HeightmapImage same(TEST_CACHE_WIDTH, TEST_CACHE_HEIGHT);
+	FillHeightmap(same);
+	CHECK(Key(same) == key);
+
+	HeightmapImage edited(TEST_CACHE_WIDTH, TEST_CACHE_HEIGHT);
+	FillHeightmap(edited);
+	edited.GetWritableRow(TEST_CACHE_HEIGHT / 2)[TEST_CACHE_WIDTH / 3]++;
+	CHECK(Key(edited) != key);
+
+	HeightmapImage wider(TEST_CACHE_WIDTH + 1, TEST_CACHE_HEIGHT);
+	FillHeightmap(wider);
+	CHECK(Key(wider) != key);
+
+	CHECK(TerrainCacheKey(heightmap, sizeof(Vertex), sizeof(uint32_t), false) != key);
+	CHECK(TerrainCacheKey(heightmap, sizeof(Vertex), sizeof(uint16_t), true) != key);
+
+	mapped_file file;
+	geometry_cache_view view;
+	CHECK(OpenGeometryCache(file, TEST_CACHE_FILE, Key(edited), sizeof(Vertex), sizeof(uint16_t), view) != 0);
+	CHECK(OpenGeometryCache(file, TEST_CACHE_FILE, key, sizeof(Vertex), sizeof(uint32_t), view) != 0);
+
+	// Files of another format version miss even with the right key
+	std::vector<uint8_t> bytes = ReadFile(TEST_CACHE_FILE);
+	Poke<uint32_t>(bytes, offsetof(geometry_cache_header, Version), GEOMETRY_CACHE_VERSION + 1);
+	CHECK(!Hits(bytes, key));
+
+	return failures;
+}
+
+// Files cut short, and headers whose sections do not fit the file
+static int TestTruncated(const HeightmapImage& heightmap)
+{
+	int failures = 0;
+	const uint64_t key = Key(heightmap);
+	const std::vector<uint8_t> intact = ReadFile(TEST_CACHE_FILE);
+	CHECK(Hits(intact, key));
+
+	const size_t lengths[] = { 0, sizeof(geometry_cache_header) - 1, sizeof(geometry_cache_header),
+		intact.size() / 2, intact.size() - 1 };
+	for (size_t length : lengths)
+	{
+		CHECK(!Hits(std::vector<uint8_t>(intact.begin(), intact.begin() + length), key));
+	}
+
+	// A longer file is not the one the header describes
+	std::vector<uint8_t> longer = intact;
+	longer.push_back(0);
+	CHECK(!Hits(longer, key));
+
+	// Sections past the end or off their alignment
+	const size_t sections[] = { offsetof(geometry_cache_header, SubmeshOffset),
+		offsetof(geometry_cache_header, RemapOffset), offsetof(geometry_cache_header, VertexOffset),
+		offsetof(geometry_cache_header, IndexOffset) };
+	for (size_t field : sections)
+	{
+		std::vector<uint8_t> bytes = intact;
+		Poke<uint64_t>(bytes, field, Peek<uint64_t>(bytes, field) + 8);
+		CHECK(!Hits(bytes, key));
+
+		Poke<uint64_t>(bytes, field, intact.size() + GEOMETRY_CACHE_ALIGNMENT);
+		CHECK(!Hits(bytes, key));
+	}
+
+	// More elements than the file holds
+	std::vector<uint8_t> bytes = intact;
+	Poke<uint64_t>(bytes, offsetof(geometry_cache_header, IndexCount),
+		Peek<uint64_t>(bytes, offsetof(geometry_cache_header, IndexCount)) + 1);
+	CHECK(!Hits(bytes, key));
+
+	bytes = intact;
+	Poke<uint32_t>(bytes, offsetof(geometry_cache_header, Magic), 0);
+	CHECK(!Hits(bytes, key));
+
+	return failures;
+}
+
+// Records, indices and remaps that would reach past their submesh
+static int TestCorrupted(const HeightmapImage& heightmap, const cached_mesh& cached)
+{
+	int failures = 0;
+	const uint64_t key = Key(heightmap);
+	const std::vector<uint8_t> intact = ReadFile(TEST_CACHE_FILE);
+	const geometry_cache_header header = Peek<geometry_cache_header>(intact, 0);
+
+	// Second submesh, so offsets of the first are not all zero
+	const uint32_t submesh = 1;
+	const geometry_cache_submesh& record = cached.Submeshes[submesh];
+	const uint64_t recordOffset = header.SubmeshOffset + submesh * sizeof(geometry_cache_submesh);
+
+	std::vector<uint8_t> bytes = intact;
+	Poke<int32_t>(bytes, recordOffset + offsetof(geometry_cache_submesh, BaseVertex), -1);
+	CHECK(!Hits(bytes, key));
+
+	bytes = intact;
+	Poke<int32_t>(bytes, recordOffset + offsetof(geometry_cache_submesh, BaseVertex),
+		(int32_t)(header.VertexCount - record.VertexCount + 1));
+	CHECK(!Hits(bytes, key));
+
+	bytes = intact;
+	Poke<uint32_t>(bytes, recordOffset + offsetof(geometry_cache_submesh, StartIndex),
+		(uint32_t)(header.IndexCount - record.IndexCount + 1));
+	CHECK(!Hits(bytes, key));
+
+	// Remaps no longer cover every vertex once
+	bytes = intact;
+	Poke<uint32_t>(bytes, recordOffset + offsetof(geometry_cache_submesh, VertexCount), record.VertexCount - 1);
+	CHECK(!Hits(bytes, key));
+
+	// Last index of the submesh and its first remap, one past its vertices
+	const uint64_t lastIndex = header.IndexOffset + (record.StartIndex + record.IndexCount - 1) * sizeof(uint16_t);
+	bytes = intact;
+	Poke<uint16_t>(bytes, lastIndex, (uint16_t)record.VertexCount);
+	CHECK(!Hits(bytes, key));
+
+	bytes = intact;
+	Poke<uint16_t>(bytes, lastIndex, (uint16_t)(record.VertexCount - 1));
+	CHECK(Hits(bytes, key));
+
+	uint64_t firstRemap = header.RemapOffset;
+	for (uint32_t i = 0; i < submesh; i++) firstRemap += cached.Submeshes[i].VertexCount * sizeof(uint32_t);
+	bytes = intact;
+	Poke<uint32_t>(bytes, firstRemap, record.VertexCount);
+	CHECK(!Hits(bytes, key));
+
+	return failures;
+}
+
+int TestGeometryCache()
+{
+	int failures = 0;
+
+	HeightmapImage heightmap(TEST_CACHE_WIDTH, TEST_CACHE_HEIGHT);
+	FillHeightmap(heightmap);
+
+	cached_mesh cached;
+	CHECK(WriteCache(heightmap, cached) == 0);
+	CHECK(cached.Mesh.Chunks.size() == 4);
+
+	if (failures == 0)
+	{
+		failures += TestHit(heightmap, cached);
+		failures += TestStale(heightmap);
+		failures += TestTruncated(heightmap);
+		failures += TestCorrupted(heightmap, cached);
+	}
+
+	remove(TEST_CACHE_FILE);
+	remove(TEST_CACHE_DAMAGED);
+	return failures != 0;
+}
@@ -0,0 +1,448 @@
+/*****************************************************************//**
+ * \file   test_image_bc.cpp
+ * \brief  Block decompression against hand-built blocks and golden
+ *         images, and compression error at every quality, at every
+ *         SIMD level and on the worker pool
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_bc.h"
+#include "image_dds.h"
+#include "image_helper.h"
+#include "test_util.h"
+#include "tests.h"
+#include "thread_pool.h"
+
+// Side of the random textures, 32 rows of blocks split between workers
+#define TEST_BC_SIZE 128
+
+#define TEST_BC_THREADS 4
+
+// Encoded image with partial blocks at the right and top edges
+#define TEST_BC_ENCODE_WIDTH 70
+#define TEST_BC_ENCODE_HEIGHT 54
+
+#define TEST_BC_DDS_FILE "test_image_bc.dds"
+
+// Appends the low bits of the value to a zeroed block, lowest bit first
+static void PutBits(uint8_t* pBlock, uint32_t& position, uint32_t value, uint32_t bits)
+{
+	for (uint32_t i = 0; i < bits; i++, position++)
+	{
+		if (value >> i & 1) pBlock[position / 8] |= (uint8_t)(1u << (position % 8));
+	}
+}
+
+// The specification's interpolation of 8-bit endpoints, weights in 64ths
+static int Interpolate(int e0, int e1, int weight)
+{
+	return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+// BGRA pixel p of a 4 x 4 block decoded with rows from the bottom
+static const uint8_t* BlockPixel(const uint8_t* pDecoded, int p)
+{
+	return pDecoded + (3 - p / 4) * 16 + (p % 4) * 4;
+}
+
+// Decodes one BC7 block at every level and compares with the expected
+// BGRA pixels, rows from the top
+static int CheckBc7Block(const uint8_t* pBlock, const uint8_t (*expected)[4])
+{
+	int failures = 0;
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		uint8_t decoded[64];
+		CHECK(bc_decode(pBlock, DDS_DXGI_FORMAT_BC7_UNORM, 4, 4, decoded, 16, nullptr, (SIMD_LEVEL)level) == 0);
+
+		int mismatches = 0;
+		for (int p = 0; p < 16; p++) mismatches += memcmp(BlockPixel(decoded, p), expected[p], 4) != 0;
+		CHECK(mismatches == 0);
+	}
+	return failures;
+}
+
+// Mode 6: one subset, RGBA endpoints of 7 bits and a p-bit each, 4-bit
+// indices with a 3-bit anchor at pixel 0
+static int TestBc7Mode6()
+{
+	const int endpoints[2][4] = { { 12, 100, 31, 127 }, { 120, 3, 64, 40 } };
+	const int pbits[2] = { 1, 0 };
+	const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	uint8_t block[16] = { };
+	uint32_t position = 0;
+	PutBits(block, position, 1u << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		for (int e = 0; e < 2; e++) PutBits(block, position, endpoints[e][c], 7);
+	}
+	for (int e = 0; e < 2; e++) PutBits(block, position, pbits[e], 1);
+
+	// Every index once, the anchor below 8
+	uint32_t indices[16];
+	uint8_t expected[16][4];
+	for (int p = 0; p < 16; p++)
+	{
+		indices[p] = (uint32_t)(p * 7 + 5) % 16;
+		if (p == 0) indices[p] = 5;
+		PutBits(block, position, indices[p], p == 0 ? 3 : 4);
+
+		static const int BGRA[4] = { 2, 1, 0, 3 };
+		for (int k = 0; k < 4; k++)
+		{
+			const int c = BGRA[k];
+			expected[p][k] = (uint8_t)Interpolate(endpoints[0][c] << 1 | pbits[0], endpoints[1][c] << 1 | pbits[1],
+				weights[indices[p]]);
+		}
+	}
+
+	int failures = 0;
+	CHECK(position == 128);
+	failures += CheckBc7Block(block, expected);
+	return failures;
+}
+
+// Mode 3: two subsets of partition 0, where the right half of every row
+// is subset 1 with its anchor at pixel 15. RGB endpoints of 7 bits and a
+// p-bit each, 2-bit indices, alpha 255.
+static int TestBc7Mode3()
+{
+	const int endpoints[4][3] = { { 0, 64, 127 }, { 127, 10, 0 }, { 33, 90, 5 }, { 70, 70, 120 } };
+	const int pbits[4] = { 0, 1, 1, 0 };
+	const int weights[4] = { 0, 21, 43, 64 };
+
+	uint8_t block[16] = { };
+	uint32_t position = 0;
+	PutBits(block, position, 1u << 3, 4);
+	PutBits(block, position, 0, 6);
+	for (int c = 0; c < 3; c++)
+	{
+		for (int e = 0; e < 4; e++) PutBits(block, position, endpoints[e][c], 7);
+	}
+	for (int e = 0; e < 4; e++) PutBits(block, position, pbits[e], 1);
+
+	uint8_t expected[16][4];
+	for (int p = 0; p < 16; p++)
+	{
+		const bool anchor = p == 0 || p == 15;
+		const uint32_t index = anchor ? p / 15 : (uint32_t)(p * 3 + 1) % 4;
+		PutBits(block, position, index, anchor ? 1 : 2);
+
+		const int subset = (0xCCCC >> p) & 1;
+		const int e0 = 2 * subset;
+		for (int c = 0; c < 3; c++)
+		{
+			expected[p][2 - c] = (uint8_t)Interpolate(endpoints[e0][c] << 1 | pbits[e0],
+				endpoints[e0 + 1][c] << 1 | pbits[e0 + 1], weights[index]);
+		}
+		expected[p][3] = 255;
+	}
+
+	int failures = 0;
+	CHECK(position == 128);
+	failures += CheckBc7Block(block, expected);
+	return failures;
+}
+
+// FNV-1a of decoded pixels
+static uint64_t Hash(const std::vector<uint8_t>& pixels)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (uint8_t byte : pixels) hash = (hash ^ byte) * 1099511628211ull;
+	return hash;
+}
+
+// Decodes the blocks at every level, on one thread and on the pool, and
+// compares every result with the golden hash
+static int CheckGolden(const uint8_t* pBlocks, uint32_t dxgiFormat, uint32_t width, uint32_t height,
+	uint64_t golden)
+{
+	int failures = 0;
+	const size_t pitch = (size_t)width * bc_decoded_channels(dxgiFormat);
+	std::vector<uint8_t> pixels(pitch * height);
+	WorkerPool pool(TEST_BC_THREADS);
+
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		for (WorkerPool* pPool : { (WorkerPool*)nullptr, &pool })
+		{
+			memset(pixels.data(), 0xCD, pixels.size());
+			CHECK(bc_decode(pBlocks, dxgiFormat, width, height, pixels.data(), pitch, pPool, (SIMD_LEVEL)level) == 0);
+			CHECK(Hash(pixels) == golden);
+		}
+	}
+	return failures;
+}
+
+// Random blocks of every decoded format. BC7 blocks take every mode and
+// the reserved one equally often. Golden hashes are of the decoder
+// before BC7 was specialised per mode.
+static int TestGoldenRandom()
+{
+	struct golden_format
+	{
+		uint32_t DxgiFormat;
+		uint64_t Hash;
+	};
+	const golden_format formats[] =
+	{
+		{ DDS_DXGI_FORMAT_BC1_UNORM, 0xCD748E86FAC1858Full },
+		{ DDS_DXGI_FORMAT_BC2_UNORM, 0x0966364E8957281Cull },
+		{ DDS_DXGI_FORMAT_BC3_UNORM, 0x66A15130074FBD54ull },
+		{ DDS_DXGI_FORMAT_BC4_UNORM, 0xC402DBFD5D9F2A1Cull },
+		{ DDS_DXGI_FORMAT_BC5_UNORM, 0x37ECB2546E347BE9ull },
+		{ DDS_DXGI_FORMAT_BC7_UNORM, 0xC9CF0BB3291559B9ull },
+	};
+
+	int failures = 0;
+	for (const golden_format& format : formats)
+	{
+		std::vector<uint8_t> blocks((size_t)dds_level_size(format.DxgiFormat, TEST_BC_SIZE, TEST_BC_SIZE));
+		uint32_t state = 2024;
+		for (uint8_t& byte : blocks)
+		{
+			state = state * 1664525u + 1013904223u;
+			byte = (uint8_t)(state >> 24);
+		}
+
+		if (format.DxgiFormat == DDS_DXGI_FORMAT_BC7_UNORM)
+		{
+			for (size_t i = 0; i < blocks.size(); i += 16)
+			{
+				const uint32_t mode = blocks[i + 1] % 9;
+				blocks[i] = mode == 8 ? 0 : (uint8_t)((blocks[i] << (mode + 1) | 1u << mode) & 0xFF);
+			}
+		}
+
+		failures += CheckGolden(blocks.data(), format.DxgiFormat, TEST_BC_SIZE, TEST_BC_SIZE, format.Hash);
+	}
+	return failures;
+}
+
+// Top mips of the shipped textures
+static int TestGoldenTextures()
+{
+	struct golden_texture
+	{
+		const char* Path;
+		uint64_t Hash;
+	};
+	const golden_texture textures[] =
+	{
+		{ "Textures/grass.dds", 0x065178A919E8E587ull },
+		{ "Textures/water1.dds", 0x370D0BEB43951613ull },
+		{ "Textures/WireFence.dds", 0x2059F05701047D6Eull },
+	};
+
+	int failures = 0;
+	for (const golden_texture& texture : textures)
+	{
+		dds_file file;
+		CHECK(file.open(texture.Path) == 0);
+		if (!file.is_open()) continue;
+
+		const dds_subresource& top = file.subresource(0);
+		failures += CheckGolden(top.data, file.info().dxgi_format, top.width, top.height, texture.Hash);
+	}
+	return failures;
+}
+
+// Smooth gradients with detail and a little noise, channels
+// decorrelated and alpha varying, so every format has work to do
+static std::vector<uint8_t> EncodeSource(uint32_t channels)
+{
+	std::vector<uint8_t> pixels((size_t)TEST_BC_ENCODE_WIDTH * TEST_BC_ENCODE_HEIGHT * channels);
+	uint32_t state = 99;
+	for (uint32_t row = 0; row < TEST_BC_ENCODE_HEIGHT; row++)
+	{
+		for (uint32_t col = 0; col < TEST_BC_ENCODE_WIDTH; col++)
+		{
+			for (uint32_t c = 0; c < channels; c++)
+			{
+				state = state * 1664525u + 1013904223u;
+				const float wave = 60.0f * std::sin(col * (0.09f + 0.05f * c) + row * (0.13f - 0.03f * c));
+				const float ramp = (float)(row * (2 + c) + col * (3 - c % 2)) * 0.8f;
+				const float value = 70.0f + 20.0f * c + wave + std::fmod(ramp, 90.0f) + (float)(state >> 29);
+				pixels[((size_t)row * TEST_BC_ENCODE_WIDTH + col) * channels + c] =
+					(uint8_t)(std::min)((std::max)(value, 0.0f), 255.0f);
+			}
+		}
+	}
+	return pixels;
+}
+
+// Format with the channels it is encoded from, and the decoded channel
+// each source channel comes back in
+struct encode_format
+{
+	BC_FORMAT Format;
+	uint32_t Channels;
+	uint32_t Decoded[4];
+	float MaxError[3];			// Root mean square error per quality, about 15% above measured
+};
+
+static const encode_format gEncodeFormats[] =
+{
+	{ BC_FORMAT_BC1, 3, { 0, 1, 2 }, { 13.0f, 7.5f, 7.3f } },
+	{ BC_FORMAT_BC4, 1, { 0 }, { 2.2f, 2.0f, 1.8f } },
+	{ BC_FORMAT_BC5, 2, { 2, 1 }, { 2.2f, 2.0f, 1.8f } },
+	{ BC_FORMAT_BC7, 4, { 0, 1, 2, 3 }, { 14.0f, 8.0f, 7.9f } },
+};
+
+// Root mean square error of the source channels after a round trip
+static float RoundTripError(const encode_format& format, const std::vector<uint8_t>& pixels,
+	const std::vector<uint8_t>& blocks)
+{
+	const uint32_t dxgiFormat = bc_dxgi_format(format.Format);
+	const uint32_t decodedChannels = bc_decoded_channels(dxgiFormat);
+	std::vector<uint8_t> decoded((size_t)TEST_BC_ENCODE_WIDTH * TEST_BC_ENCODE_HEIGHT * decodedChannels);
+	if (bc_decode(blocks.data(), dxgiFormat, TEST_BC_ENCODE_WIDTH, TEST_BC_ENCODE_HEIGHT, decoded.data(),
+		(size_t)TEST_BC_ENCODE_WIDTH * decodedChannels) != 0)
+	{
+		return 1e30f;
+	}
+
+	double sum = 0.0;
+	const size_t count = (size_t)TEST_BC_ENCODE_WIDTH * TEST_BC_ENCODE_HEIGHT;
+	for (size_t i = 0; i < count; i++)
+	{
+		for (uint32_t c = 0; c < format.Channels; c++)
+		{
+			const double difference = (double)pixels[i * format.Channels + c] - decoded[i * decodedChannels + format.Decoded[c]];
+			sum += difference * difference;
+		}
+	}
+	return (float)std::sqrt(sum / (count * format.Channels));
+}
+
+// Every format at every quality: the round trip error is within the
+// bound of the quality and falls as the quality rises. Every SIMD level
+// and the pool write the same blocks.
+static int TestEncodeQuality()
+{
+	int failures = 0;
+	WorkerPool pool(TEST_BC_THREADS);
+	const BC_QUALITY qualities[] = { BC_QUALITY_FAST, BC_QUALITY_NORMAL, BC_QUALITY_HIGH };
+
+	for (const encode_format& format : gEncodeFormats)
+	{
+		const std::vector<uint8_t> pixels = EncodeSource(format.Channels);
+		const size_t pitch = (size_t)TEST_BC_ENCODE_WIDTH * format.Channels;
+		const size_t bytes = (size_t)dds_level_size(bc_dxgi_format(format.Format), TEST_BC_ENCODE_WIDTH,
+			TEST_BC_ENCODE_HEIGHT);
+
+		float previous = 1e30f;
+		for (BC_QUALITY quality : qualities)
+		{
+			std::vector<uint8_t> reference(bytes), blocks(bytes);
+			bc_encode(pixels.data(), TEST_BC_ENCODE_WIDTH, TEST_BC_ENCODE_HEIGHT, pitch, format.Channels,
+				format.Format, quality, reference.data(), nullptr, SIMD_LEVEL_SCALAR);
+
+			for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+			{
+				for (WorkerPool* pPool : { (WorkerPool*)nullptr, &pool })
+				{
+					memset(blocks.data(), 0xCD, blocks.size());
+					bc_encode(pixels.data(), TEST_BC_ENCODE_WIDTH, TEST_BC_ENCODE_HEIGHT, pitch, format.Channels,
+						format.Format, quality, blocks.data(), pPool, (SIMD_LEVEL)level);
+					CHECK(blocks == reference);
+				}
+			}
+
+			const float error = RoundTripError(format, pixels, reference);
+			if (error > format.MaxError[quality] || error >= previous)
+			{
+				fprintf(stderr, "BC%d at quality %d: error %.3f, bound %.3f, lower quality %.3f\n",
+					format.Format, quality, error, format.MaxError[quality], previous);
+				failures++;
+			}
+			previous = error;
+		}
+	}
+	return failures;
+}
+
+// A heightmap written as BC4 with all mips: every level of the file is
+// the encoded box mip, and the top one decodes close to the samples
+static int TestWriteDds()
+{
+	int failures = 0;
+	const uint32_t width = 64, height = 48;
+	const std::vector<uint8_t> pixels = EncodeSource(1);
+
+	HeightmapImage heightmap(width, height);
+	for (uint32_t row = 0; row < height; row++)
+	{
+		memcpy(heightmap.GetWritableRow(row), &pixels[(size_t)row * TEST_BC_ENCODE_WIDTH], width);
+	}
+
+	CHECK(heightmap.WriteDds(TEST_BC_DDS_FILE, BC_QUALITY_NORMAL) == 0);
+
+	mip_chain chain;
+	CHECK(heightmap.GenerateMips(chain, MIP_FILTER_BOX) == 0);
+	CHECK(chain.level_count() == 7);
+
+	dds_file file;
+	CHECK(file.open(TEST_BC_DDS_FILE) == 0);
+	if (failures) return failures;
+
+	CHECK(file.info().dxgi_format == DDS_DXGI_FORMAT_BC4_UNORM);
+	CHECK(file.info().width == width && file.info().height == height);
+	CHECK(file.info().mip_count == chain.level_count());
+	if (failures) return failures;
+
+	for (uint32_t mip = 0; mip < chain.level_count(); mip++)
+	{
+		const mip_level& level = chain.level(mip);
+		const dds_subresource& stored = file.subresource(mip);
+		CHECK(stored.width == level.width && stored.height == level.height);
+
+		std::vector<uint8_t> blocks((size_t)dds_level_size(DDS_DXGI_FORMAT_BC4_UNORM, level.width, level.height));
+		bc_encode(level.data, level.width, level.height, level.row_pitch, 1, BC_FORMAT_BC4, BC_QUALITY_NORMAL,
+			blocks.data());
+		CHECK(stored.size == blocks.size());
+		CHECK(stored.size == blocks.size() && memcmp(stored.data, blocks.data(), blocks.size()) == 0);
+	}
+	file.close();
+
+	TextureImage texture(TEST_BC_DDS_FILE);
+	CHECK(texture.GetWidth() == width && texture.GetHeight() == height);
+	CHECK(texture.GetColorMode() == IMAGE_COLOR_MODE_GRAYSCALE);
+	if (failures) return failures;
+
+	int difference = 0;
+	for (uint32_t row = 0; row < height; row++)
+	{
+		const uint8_t* pDecoded = texture.GetRow(row);
+		const uint8_t* pSamples = heightmap.GetRow(row);
+		for (uint32_t col = 0; col < width; col++)
+		{
+			difference = (std::max)(difference, std::abs(pDecoded[col] - pSamples[col]));
+		}
+	}
+	CHECK(difference <= 8);
+
+	remove(TEST_BC_DDS_FILE);
+	return failures;
+}
+
+int TestImageBc()
+{
+	int failures = 0;
+	failures += TestBc7Mode6();
+	failures += TestBc7Mode3();
+	failures += TestGoldenRandom();
+	failures += TestGoldenTextures();
+	failures += TestEncodeQuality();
+	failures += TestWriteDds();
+	return failures != 0;
+}
@@ -0,0 +1,318 @@
+/*****************************************************************//**
+ * \file   test_image_bmp.cpp
+ * \brief  .bmp headers, valid and malformed, and the two ways
+ *         read_bmp loads pixels
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "image_kernel.h"
+#include "test_util.h"
+#include "tests.h"
+
+#define TEST_BMP_FILE "test_image_bmp.bmp"
+
+// Rows of 5 gray pixels are padded to 8 bytes
+#define TEST_BMP_WIDTH 5
+#define TEST_BMP_HEIGHT 3
+
+// Fields of a generated .bmp file, a valid bottom-up 8-bit gray image
+// unless a test changes them
+struct bmp_spec
+{
+	char Magic[2] = { 'B', 'M' };
+	uint32_t HeaderSize = 40;
+	int32_t Width = TEST_BMP_WIDTH;
+	int32_t Height = TEST_BMP_HEIGHT;
+	uint16_t Planes = 1;
+	uint16_t Bits = 8;
+	uint32_t Compression = 0;
+	uint32_t ColorsUsed = 0;
+	uint32_t Masks[3] = { 0x00FF0000u, 0x0000FF00u, 0x000000FFu };
+	uint32_t PaletteColors = 256;		// Entries written, 8-bit only
+	bool GrayPalette = true;			// Entry i is (i, i, i), otherwise tinted
+	uint32_t PixelOffset = 0;			// 0 places pixels after the palette
+	uint64_t Size = 0;					// 0 ends the file after the pixels
+};
+
+static void WriteLe(std::vector<uint8_t>& bytes, size_t offset, uint32_t value, uint32_t size)
+{
+	for (uint32_t i = 0; i < size; i++) bytes[offset + i] = (uint8_t)(value >> (8 * i));
+}
+
+// Byte of a stored row, rows numbered in file order
+static uint8_t Pattern(uint32_t fileRow, uint32_t byte)
+{
+	return (uint8_t)(fileRow * 31 + byte * 7 + 3);
+}
+
+// BGR of a palette entry, not gray unless the palette is
+static void PaletteEntry(const bmp_spec& spec, uint32_t i, uint8_t* bgr)
+{
+	bgr[0] = (uint8_t)i;
+	bgr[1] = (uint8_t)(spec.GrayPalette ? i : 255 - i);
+	bgr[2] = (uint8_t)(spec.GrayPalette ? i : i / 2);
+}
+
+static uint32_t PixelOffset(const bmp_spec& spec)
+{
+	if (spec.PixelOffset) return spec.PixelOffset;
+
+	uint32_t headerEnd = 14 + spec.HeaderSize;
+	if (spec.Bits == 32 && spec.Compression == 3 && spec.HeaderSize == 40) headerEnd += 12;
+	return headerEnd + (spec.Bits == 8 ? spec.PaletteColors * 4 : 0);
+}
+
+// Rows of invalid widths are empty
+static uint64_t RowPitch(const bmp_spec& spec)
+{
+	return ((uint64_t)(std::max)(spec.Width, 0) * spec.Bits + 31) / 32 * 4;
+}
+
+static std::vector<uint8_t> BuildBmp(const bmp_spec& spec)
+{
+	const uint32_t pixelOffset = PixelOffset(spec);
+	const uint32_t rows = (uint32_t)std::abs(spec.Height);
+	const uint64_t end = pixelOffset + RowPitch(spec) * rows;
+
+	// Every field is written, a short file is cut afterwards
+	std::vector<uint8_t> bytes((size_t)(std::max)(end, (uint64_t)0x42 + 256 * 4));
+	bytes[0] = (uint8_t)spec.Magic[0];
+	bytes[1] = (uint8_t)spec.Magic[1];
+	WriteLe(bytes, 0x2, (uint32_t)end, 4);
+	WriteLe(bytes, 0xA, pixelOffset, 4);
+	WriteLe(bytes, 0xE, spec.HeaderSize, 4);
+	WriteLe(bytes, 0x12, (uint32_t)spec.Width, 4);
+	WriteLe(bytes, 0x16, (uint32_t)spec.Height, 4);
+	WriteLe(bytes, 0x1A, spec.Planes, 2);
+	WriteLe(bytes, 0x1C, spec.Bits, 2);
+	WriteLe(bytes, 0x1E, spec.Compression, 4);
+	WriteLe(bytes, 0x2E, spec.ColorsUsed, 4);
+
+	// After a 40-byte header or inside a longer one, at the same offset
+	if (spec.Compression == 3)
+	{
+		for (int i = 0; i < 3; i++) WriteLe(bytes, 0x36 + 4 * i, spec.Masks[i], 4);
+	}
+
+	if (spec.Bits == 8)
+	{
+		const uint32_t paletteOffset = 14 + spec.HeaderSize;
+		for (uint32_t i = 0; i < spec.PaletteColors && paletteOffset + 4 * i + 4 <= pixelOffset; i++)
+		{
+			PaletteEntry(spec, i, &bytes[paletteOffset + 4 * i]);
+		}
+	}
+
+	if (end <= bytes.size())
+	{
+		for (uint32_t row = 0; row < rows; row++)
+		{
+			for (uint32_t byte = 0; byte < RowPitch(spec); byte++)
+			{
+				bytes[(size_t)(pixelOffset + row * RowPitch(spec) + byte)] = Pattern(row, byte);
+			}
+		}
+	}
+
+	bytes.resize((size_t)(spec.Size ? spec.Size : end));
+	return bytes;
+}
+
+struct header_case
+{
+	const char* Name;
+	void (*Change)(bmp_spec& spec);
+	bool Valid;
+};
+
+static const header_case gHeaderCases[] =
+{
+	{ "8-bit, 40-byte header", [](bmp_spec&) {}, true },
+	{ "52-byte header", [](bmp_spec& s) { s.HeaderSize = 52; }, true },
+	{ "56-byte header", [](bmp_spec& s) { s.HeaderSize = 56; }, true },
+	{ "108-byte header", [](bmp_spec& s) { s.HeaderSize = 108; }, true },
+	{ "124-byte header", [](bmp_spec& s) { s.HeaderSize = 124; }, true },
+	{ "12-byte core header", [](bmp_spec& s) { s.HeaderSize = 12; }, false },
+	{ "64-byte header", [](bmp_spec& s) { s.HeaderSize = 64; }, false },
+	{ "magic BA", [](bmp_spec& s) { s.Magic[1] = 'A'; }, false },
+	{ "shorter than the headers", [](bmp_spec& s) { s.Size = 0x30; }, false },
+	{ "no planes", [](bmp_spec& s) { s.Planes = 0; }, false },
+	{ "two planes", [](bmp_spec& s) { s.Planes = 2; }, false },
+	{ "zero width", [](bmp_spec& s) { s.Width = 0; }, false },
+	{ "negative width", [](bmp_spec& s) { s.Width = -5; }, false },
+	{ "zero height", [](bmp_spec& s) { s.Height = 0; }, false },
+	{ "top-down", [](bmp_spec& s) { s.Height = -TEST_BMP_HEIGHT; }, true },
+	{ "1-bit", [](bmp_spec& s) { s.Bits = 1; }, false },
+	{ "4-bit", [](bmp_spec& s) { s.Bits = 4; }, false },
+	{ "16-bit", [](bmp_spec& s) { s.Bits = 16; }, false },
+	{ "24-bit", [](bmp_spec& s) { s.Bits = 24; }, true },
+	{ "32-bit", [](bmp_spec& s) { s.Bits = 32; }, true },
+	{ "bit fields after a 40-byte header", [](bmp_spec& s) { s.Bits = 32; s.Compression = 3; }, true },
+	{ "bit fields in a 108-byte header", [](bmp_spec& s) { s.Bits = 32; s.Compression = 3; s.HeaderSize = 108; }, true },
+	{ "RGBA bit fields", [](bmp_spec& s) { s.Bits = 32; s.Compression = 3; s.Masks[0] = 0x000000FFu; s.Masks[2] = 0x00FF0000u; }, false },
+	{ "bit fields of 24-bit pixels", [](bmp_spec& s) { s.Bits = 24; s.Compression = 3; }, false },
+	{ "RLE8", [](bmp_spec& s) { s.Compression = 1; }, false },
+	{ "bit fields past the end", [](bmp_spec& s) { s.Bits = 32; s.Compression = 3; s.Size = 0x3C; }, false },
+	{ "pixels a byte short", [](bmp_spec& s) { s.Size = PixelOffset(s) + RowPitch(s) * TEST_BMP_HEIGHT - 1; }, false },
+	{ "pixel offset past the end", [](bmp_spec& s) { s.PixelOffset = 0x1000; s.Size = 0x800; }, false },
+	{ "pixel offset inside the headers", [](bmp_spec& s) { s.PixelOffset = 0x30; }, false },
+	{ "16 colors used", [](bmp_spec& s) { s.ColorsUsed = 16; s.PaletteColors = 16; }, true },
+	{ "257 colors used", [](bmp_spec& s) { s.ColorsUsed = 257; s.PaletteColors = 257; }, false },
+	{ "palette over the pixels", [](bmp_spec& s) { s.PaletteColors = 16; }, false },
+	{ "tinted palette", [](bmp_spec& s) { s.GrayPalette = false; }, true },
+};
+
+// Every case parsed from memory, accepted ones against the fields they were built with
+static int TestHeaders()
+{
+	int failures = 0;
+	for (const header_case& test : gHeaderCases)
+	{
+		bmp_spec spec;
+		test.Change(spec);
+		const std::vector<uint8_t> bytes = BuildBmp(spec);
+
+		bmp_info info;
+		const int result = parse_bmp_header(test.Name, bytes.data(), bytes.size(), info);
+		if ((result == 0) != test.Valid)
+		{
+			fprintf(stderr, "%s: parse_bmp_header returned %d\n", test.Name, result);
+			failures++;
+			continue;
+		}
+		if (!test.Valid) continue;
+
+		CHECK(info.width == (uint32_t)spec.Width);
+		CHECK(info.height == (uint32_t)std::abs(spec.Height));
+		CHECK(info.top_down == (spec.Height < 0));
+		CHECK(info.bits_per_pixel == spec.Bits);
+		CHECK(info.pixel_offset == PixelOffset(spec));
+		CHECK(info.row_pitch == RowPitch(spec));
+		if (spec.Bits == 8)
+		{
+			CHECK(info.palette_offset == 14 + spec.HeaderSize);
+			CHECK(info.palette_size == (spec.ColorsUsed ? spec.ColorsUsed : 256));
+		}
+		CHECK(info.gray_palette == (spec.Bits != 8 || spec.GrayPalette));
+	}
+	return failures;
+}
+
+static bool WriteFile(const std::vector<uint8_t>& bytes)
+{
+	FILE* pFile = fopen(TEST_BMP_FILE, "wb");
+	if (!pFile) return false;
+	const bool written = fwrite(bytes.data(), 1, bytes.size(), pFile) == bytes.size();
+	return fclose(pFile) == 0 && written;
+}
+
+// Gray levels a file of the spec should load as, rows from the bottom
+static std::vector<uint8_t> ExpectedPixels(const bmp_spec& spec)
+{
+	std::vector<uint8_t> pixels(TEST_BMP_WIDTH * TEST_BMP_HEIGHT);
+	for (uint32_t row = 0; row < TEST_BMP_HEIGHT; row++)
+	{
+		const uint32_t fileRow = spec.Height < 0 ? TEST_BMP_HEIGHT - 1 - row : row;
+		for (uint32_t col = 0; col < TEST_BMP_WIDTH; col++)
+		{
+			uint8_t bgr[3];
+			PaletteEntry(spec, Pattern(fileRow, col), bgr);
+			pixels[row * TEST_BMP_WIDTH + col] = spec.GrayPalette ? bgr[0] : image_luma(bgr[0], bgr[1], bgr[2]);
+		}
+	}
+	return pixels;
+}
+
+static int CheckPixels(HeightmapImage& image, const bmp_spec& spec)
+{
+	int failures = 0;
+	CHECK(image.GetWidth() == TEST_BMP_WIDTH);
+	CHECK(image.GetHeight() == TEST_BMP_HEIGHT);
+	if (failures) return failures;
+
+	const std::vector<uint8_t> expected = ExpectedPixels(spec);
+	int mismatches = 0;
+	for (uint32_t row = 0; row < TEST_BMP_HEIGHT; row++)
+	{
+		mismatches += memcmp(image.GetRow(row), &expected[row * TEST_BMP_WIDTH], TEST_BMP_WIDTH) != 0;
+	}
+	CHECK(mismatches == 0);
+	return failures;
+}
+
+// Bottom-up gray levels are used in place, writes go to private pages
+static int TestReadInPlace()
+{
+	int failures = 0;
+	bmp_spec spec;
+	CHECK(WriteFile(BuildBmp(spec)));
+
+	{
+		HeightmapImage image(TEST_BMP_FILE);
+		CHECK(image.IsMapped());
+		failures += CheckPixels(image, spec);
+
+		uint8_t* pRow = image.GetWritableRow(0);
+		CHECK(pRow != nullptr);
+		if (pRow) memset(pRow, 0, TEST_BMP_WIDTH);
+
+		HeightmapImage reread(TEST_BMP_FILE);
+		failures += CheckPixels(reread, spec);
+	}
+
+	remove(TEST_BMP_FILE);
+	return failures;
+}
+
+// Top-down rows and tinted palettes are copied, entries resolved to gray levels
+static int TestReadCopied()
+{
+	int failures = 0;
+
+	bmp_spec topDown;
+	topDown.Height = -TEST_BMP_HEIGHT;
+	bmp_spec tinted;
+	tinted.GrayPalette = false;
+	bmp_spec tintedTopDown = tinted;
+	tintedTopDown.Height = -TEST_BMP_HEIGHT;
+
+	for (const bmp_spec* pSpec : { &topDown, &tinted, &tintedTopDown })
+	{
+		CHECK(WriteFile(BuildBmp(*pSpec)));
+
+		HeightmapImage image(TEST_BMP_FILE);
+		CHECK(!image.IsMapped());
+		failures += CheckPixels(image, *pSpec);
+	}
+
+	// The resolved levels are not the palette indices
+	const std::vector<uint8_t> indices = ExpectedPixels(bmp_spec());
+	CHECK(ExpectedPixels(tinted) != indices);
+
+	// A malformed file loads nothing
+	bmp_spec truncated;
+	truncated.Size = 0x30;
+	CHECK(WriteFile(BuildBmp(truncated)));
+	HeightmapImage empty(TEST_BMP_FILE);
+	CHECK(empty.GetWidth() == 0);
+	CHECK(!empty.IsMapped());
+
+	remove(TEST_BMP_FILE);
+	return failures;
+}
+
+int TestImageBmp()
+{
+	int failures = 0;
+	failures += TestHeaders();
+	failures += TestReadInPlace();
+	failures += TestReadCopied();
+	return failures != 0;
+}
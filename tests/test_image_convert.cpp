@@ -0,0 +1,193 @@
+/*****************************************************************//**
+ * \file   test_image_convert.cpp
+ * \brief  Color mode conversion at every SIMD level against the scalar
+ *         path, and set_color_mode on the worker pool
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_kernel.h"
+#include "test_util.h"
+#include "tests.h"
+#include "thread_pool.h"
+
+// Pixel counts up to a few SIMD steps of every level, and past the 3-byte tails
+#define TEST_CONVERT_MAX_COUNT 100
+
+// Bytes after the converted pixels that must stay untouched
+#define TEST_CONVERT_GUARD 64
+
+#define TEST_CONVERT_THREADS 4
+
+// Odd sizes, so that rows of every mode but RGBA are padded
+#define TEST_CONVERT_WIDTH 37
+#define TEST_CONVERT_HEIGHT 45
+
+static const IMAGE_COLOR_MODE gModes[] =
+{
+	IMAGE_COLOR_MODE_GRAYSCALE,
+	IMAGE_COLOR_MODE_RGB,
+	IMAGE_COLOR_MODE_RGBA,
+};
+
+static void FillRandom(std::vector<uint8_t>& bytes, uint32_t seed)
+{
+	for (uint8_t& byte : bytes)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		byte = (uint8_t)(seed >> 24);
+	}
+}
+
+// One pixel converted by the definition in image_kernel.h
+static void ExpectedPixel(const uint8_t* pSrc, uint32_t srcBpp, uint32_t dstBpp, uint8_t* pOut)
+{
+	const uint8_t b = pSrc[0];
+	const uint8_t g = srcBpp == 1 ? pSrc[0] : pSrc[1];
+	const uint8_t r = srcBpp == 1 ? pSrc[0] : pSrc[2];
+
+	if (dstBpp == 1 && srcBpp != 1)
+	{
+		pOut[0] = image_luma(b, g, r);
+		return;
+	}
+
+	pOut[0] = b;
+	if (dstBpp == 1) return;
+	pOut[1] = g;
+	pOut[2] = r;
+	if (dstBpp == 4) pOut[3] = srcBpp == 4 ? pSrc[3] : 0xFF;
+}
+
+// Every pair of modes and every count, from sources at several byte
+// offsets, at every level. Results must match the definition and leave
+// the bytes after the last pixel alone.
+static int TestLevels()
+{
+	int failures = 0;
+
+	std::vector<uint8_t> src(TEST_CONVERT_MAX_COUNT * 4 + 32);
+	FillRandom(src, 7);
+
+	// Every byte value at least once
+	for (uint32_t i = 0; i < 256; i++) src[i] = (uint8_t)i;
+
+	std::vector<uint8_t> expected(TEST_CONVERT_MAX_COUNT * 4);
+	std::vector<uint8_t> dst(TEST_CONVERT_MAX_COUNT * 4 + TEST_CONVERT_GUARD);
+
+	for (IMAGE_COLOR_MODE srcMode : gModes)
+	{
+		for (IMAGE_COLOR_MODE dstMode : gModes)
+		{
+			const uint32_t srcBpp = (uint32_t)srcMode;
+			const uint32_t dstBpp = (uint32_t)dstMode;
+
+			for (uint32_t offset = 0; offset < 16; offset += 5)
+			{
+				const uint8_t* pSrc = src.data() + offset;
+				for (uint32_t count = 0; count <= TEST_CONVERT_MAX_COUNT; count++)
+				{
+					for (uint32_t i = 0; i < count; i++)
+					{
+						ExpectedPixel(pSrc + (size_t)i * srcBpp, srcBpp, dstBpp, &expected[(size_t)i * dstBpp]);
+					}
+
+					for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+					{
+						memset(dst.data(), 0xA5, dst.size());
+						convert_pixels(pSrc, srcMode, dst.data(), dstMode, count, (SIMD_LEVEL)level);
+
+						const size_t bytes = (size_t)count * dstBpp;
+						size_t guard = 0;
+						for (size_t i = bytes; i < bytes + TEST_CONVERT_GUARD; i++) guard += dst[i] != 0xA5;
+
+						if (memcmp(dst.data(), expected.data(), bytes) != 0 || guard != 0)
+						{
+							fprintf(stderr, "convert %u to %u bytes, %u pixels at offset %u, level %d\n",
+								srcBpp, dstBpp, count, offset, level);
+							failures++;
+						}
+					}
+				}
+			}
+		}
+	}
+	return failures;
+}
+
+// Image with its conversion exposed
+class convert_image : public image_base
+{
+public:
+	convert_image(uint32_t width, uint32_t height, IMAGE_COLOR_MODE mode, uint32_t seed)
+	{
+		allocate(width, height, mode);
+
+		// Pixels only, padding stays zero
+		std::vector<uint8_t> row((size_t)width * mode);
+		for (uint32_t r = 0; r < height; r++)
+		{
+			FillRandom(row, seed + r);
+			memcpy((uint8_t*)m_pRaw + (size_t)r * m_rowByteSize, row.data(), row.size());
+		}
+	}
+
+	int SetColorMode(IMAGE_COLOR_MODE mode, WorkerPool* pool) { return set_color_mode(mode, pool); }
+
+	IMAGE_COLOR_MODE GetColorMode() const { return m_colorMode; }
+	uint32_t GetRowPitch() const { return m_rowByteSize; }
+	const uint8_t* GetRaw() const { return (const uint8_t*)m_pRaw; }
+	uint32_t GetRawSize() const { return m_rawByteSize; }
+};
+
+// Every pair of modes on one thread and on the pool, against the scalar
+// path row by row, with zero padding after every row
+static int TestSetColorMode()
+{
+	int failures = 0;
+	WorkerPool pool(TEST_CONVERT_THREADS);
+
+	for (IMAGE_COLOR_MODE srcMode : gModes)
+	{
+		for (IMAGE_COLOR_MODE dstMode : gModes)
+		{
+			const convert_image source(TEST_CONVERT_WIDTH, TEST_CONVERT_HEIGHT, srcMode, 11);
+
+			for (WorkerPool* pPool : { (WorkerPool*)nullptr, &pool })
+			{
+				convert_image image(TEST_CONVERT_WIDTH, TEST_CONVERT_HEIGHT, srcMode, 11);
+				CHECK(image.SetColorMode(dstMode, pPool) == 0);
+				CHECK(image.GetColorMode() == dstMode);
+
+				const uint32_t rowBytes = TEST_CONVERT_WIDTH * (uint32_t)dstMode;
+				const uint32_t pitch = (rowBytes + 3) & ~3u;
+				CHECK(image.GetRowPitch() == pitch);
+				CHECK(image.GetRawSize() == pitch * TEST_CONVERT_HEIGHT);
+				if (failures) return failures;
+
+				std::vector<uint8_t> expected(pitch, 0);
+				size_t mismatches = 0;
+				for (uint32_t row = 0; row < TEST_CONVERT_HEIGHT; row++)
+				{
+					convert_pixels(source.GetRaw() + (size_t)row * source.GetRowPitch(), srcMode,
+						expected.data(), dstMode, TEST_CONVERT_WIDTH, SIMD_LEVEL_SCALAR);
+					mismatches += memcmp(image.GetRaw() + (size_t)row * pitch, expected.data(), pitch) != 0;
+				}
+				CHECK(mismatches == 0);
+			}
+		}
+	}
+	return failures;
+}
+
+int TestImageConvert()
+{
+	int failures = 0;
+	failures += TestLevels();
+	failures += TestSetColorMode();
+	return failures != 0;
+}
@@ -0,0 +1,99 @@
+/*****************************************************************//**
+ * \file   test_image_dds.cpp
+ * \brief  The shipped .dds textures opened through dds_file
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdio>
+
+#include "image_dds.h"
+#include "test_util.h"
+#include "tests.h"
+
+// Legacy headers, the first level follows the magic and the header
+#define TEST_DDS_DATA_OFFSET 128
+
+struct test_texture
+{
+	const char* Path;
+	uint32_t DxgiFormat;
+	uint32_t Size;			// Width and height
+	uint32_t MipCount;		// Down to 1 x 1
+	uint32_t BlockBytes;
+	uint64_t FileSize;
+};
+
+static const test_texture gTextures[] =
+{
+	{ "Textures/grass.dds", DDS_DXGI_FORMAT_BC3_UNORM, 512, 10, 16, 349680 },
+	{ "Textures/water1.dds", DDS_DXGI_FORMAT_BC1_UNORM, 256, 9, 8, 43832 },
+	{ "Textures/WireFence.dds", DDS_DXGI_FORMAT_BC3_UNORM, 512, 10, 16, 349680 },
+};
+
+// Header fields and every level packed after the one before it, rows of
+// blocks at least one block wide down to the 1 x 1 level
+static int TestTexture(const test_texture& texture)
+{
+	int failures = 0;
+
+	dds_file file;
+	CHECK(file.open(texture.Path) == 0);
+	if (!file.is_open()) return failures;
+
+	const dds_info& info = file.info();
+	CHECK(info.dxgi_format == texture.DxgiFormat);
+	CHECK(info.width == texture.Size);
+	CHECK(info.height == texture.Size);
+	CHECK(info.mip_count == texture.MipCount);
+	CHECK(info.array_size == 1);
+	CHECK(!info.cube);
+	CHECK(info.data_offset == TEST_DDS_DATA_OFFSET);
+	CHECK(file.subresource_count() == texture.MipCount);
+	if (failures) return failures;
+
+	const uint8_t* pFirst = file.subresource(0).data;
+	uint64_t offset = TEST_DDS_DATA_OFFSET;
+	for (uint32_t mip = 0; mip < texture.MipCount; mip++)
+	{
+		const dds_subresource& level = file.subresource(mip);
+		const uint32_t size = (std::max)(texture.Size >> mip, 1u);
+		const uint32_t blocks = (size + 3) / 4;
+
+		CHECK(&level == file.subresources() + mip);
+		CHECK(level.width == size);
+		CHECK(level.height == size);
+		CHECK(level.offset == offset);
+		CHECK(level.data == pFirst + (offset - TEST_DDS_DATA_OFFSET));
+		CHECK(level.row_pitch == blocks * texture.BlockBytes);
+		CHECK(level.row_count == blocks);
+		CHECK(level.size == (uint64_t)level.row_pitch * level.row_count);
+		CHECK(level.size == dds_level_size(texture.DxgiFormat, size, size));
+		offset += level.size;
+	}
+
+	// The last level ends the file
+	CHECK(offset == texture.FileSize);
+
+	file.close();
+	CHECK(!file.is_open());
+	CHECK(file.subresource_count() == 0);
+	return failures;
+}
+
+int TestImageDds()
+{
+	int failures = 0;
+	for (const test_texture& texture : gTextures)
+	{
+		failures += TestTexture(texture);
+	}
+
+	// A missing file leaves the reader closed
+	dds_file missing;
+	CHECK(missing.open("Textures/missing.dds") != 0);
+	CHECK(!missing.is_open());
+
+	return failures != 0;
+}
@@ -0,0 +1,245 @@
+/*****************************************************************//**
+ * \file   test_image_stream.cpp
+ * \brief  Band reader and writer against whole-image .bmp files
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "image_stream.h"
+#include "test_util.h"
+#include "tests.h"
+
+#define TEST_STREAM_BMP "test_image_stream.bmp"
+
+// Rows are padded to 4 bytes, and bands of either size leave a short one
+#define TEST_STREAM_WIDTH 37
+#define TEST_STREAM_HEIGHT 29
+#define TEST_STREAM_WRITE_BAND 8
+#define TEST_STREAM_READ_BAND 6
+
+// Channel c of the pixel, rows numbered from the bottom
+static uint8_t Pattern(uint32_t row, uint32_t col, uint32_t c)
+{
+	return (uint8_t)(row * 7 + col * 3 + c * 101);
+}
+
+// Pixels of a band against the pattern, rows bottom to top
+static int CountMismatches(const uint8_t* pBand, uint64_t pitch, uint32_t firstRow, uint32_t rows)
+{
+	int mismatches = 0;
+	for (uint32_t r = 0; r < rows; r++)
+	{
+		const uint8_t* pRow = pBand + r * pitch;
+		for (uint32_t col = 0; col < TEST_STREAM_WIDTH; col++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				mismatches += pRow[col * 3 + c] != Pattern(firstRow + r, col, c);
+			}
+		}
+	}
+	return mismatches;
+}
+
+// Bands written from the bottom, the file read back whole
+static int TestWrite()
+{
+	int failures = 0;
+
+	bmp_band_writer writer;
+	CHECK(writer.open(TEST_STREAM_BMP, TEST_STREAM_WIDTH, TEST_STREAM_HEIGHT, IMAGE_COLOR_MODE_RGB,
+		TEST_STREAM_WRITE_BAND) == 0);
+	CHECK(writer.row_pitch() == (TEST_STREAM_WIDTH * 3 + 3) / 4 * 4);
+	if (failures) return failures;
+
+	uint32_t expectedRow = 0;
+	uint32_t firstRow, rows;
+	while (uint8_t* pBand = writer.band(firstRow, rows))
+	{
+		CHECK(firstRow == expectedRow);
+		CHECK(rows == (std::min)((uint32_t)TEST_STREAM_WRITE_BAND, TEST_STREAM_HEIGHT - firstRow));
+
+		// Whole pitch filled, padding left nonzero for the writer to clear
+		memset(pBand, 0xCD, (size_t)(writer.row_pitch() * rows));
+		for (uint32_t r = 0; r < rows; r++)
+		{
+			for (uint32_t col = 0; col < TEST_STREAM_WIDTH; col++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					pBand[r * writer.row_pitch() + col * 3 + c] = Pattern(firstRow + r, col, c);
+				}
+			}
+		}
+
+		CHECK(writer.commit_band() == 0);
+		expectedRow += rows;
+	}
+	CHECK(expectedRow == TEST_STREAM_HEIGHT);
+	CHECK(writer.commit_band() == -1);
+	CHECK(writer.close() == 0);
+	if (failures) return failures;
+
+	TextureImage image(TEST_STREAM_BMP);
+	CHECK(image.GetWidth() == TEST_STREAM_WIDTH && image.GetHeight() == TEST_STREAM_HEIGHT);
+	CHECK(image.GetColorMode() == IMAGE_COLOR_MODE_RGB);
+	if (failures) return failures;
+
+	int mismatches = 0;
+	for (uint32_t row = 0; row < TEST_STREAM_HEIGHT; row++)
+	{
+		mismatches += CountMismatches(image.GetRow(row), image.GetRowPitch(), row, 1);
+	}
+	CHECK(mismatches == 0);
+
+	// Padding of every row is zero
+	std::vector<uint8_t> file;
+	FILE* pFile = fopen(TEST_STREAM_BMP, "rb");
+	CHECK(pFile != nullptr);
+	if (pFile)
+	{
+		file.resize(1 << 16);
+		file.resize(fread(file.data(), 1, file.size(), pFile));
+		fclose(pFile);
+	}
+
+	bmp_info info;
+	CHECK(parse_bmp_header(TEST_STREAM_BMP, file.data(), file.size(), info) == 0);
+	if (failures) return failures;
+
+	int padding = 0;
+	for (uint32_t row = 0; row < TEST_STREAM_HEIGHT; row++)
+	{
+		const uint8_t* pRow = &file[info.pixel_offset + row * info.row_pitch];
+		for (uint64_t i = TEST_STREAM_WIDTH * 3; i < info.row_pitch; i++) padding += pRow[i] != 0;
+	}
+	CHECK(padding == 0);
+
+	return failures;
+}
+
+// Bands of the file written by TestWrite come bottom first
+static int TestReadBottomUp()
+{
+	int failures = 0;
+
+	bmp_band_reader reader;
+	CHECK(reader.open(TEST_STREAM_BMP, TEST_STREAM_READ_BAND) == 0);
+	if (failures) return failures;
+
+	CHECK(reader.info().width == TEST_STREAM_WIDTH && reader.info().height == TEST_STREAM_HEIGHT);
+	CHECK(reader.info().bits_per_pixel == 24 && !reader.info().top_down);
+
+	uint32_t expectedRow = 0;
+	int mismatches = 0;
+	uint32_t firstRow, rows;
+	while (const uint8_t* pBand = reader.next_band(firstRow, rows))
+	{
+		CHECK(firstRow == expectedRow);
+		CHECK(rows == (std::min)((uint32_t)TEST_STREAM_READ_BAND, TEST_STREAM_HEIGHT - firstRow));
+		mismatches += CountMismatches(pBand, reader.row_pitch(), firstRow, rows);
+		expectedRow += rows;
+	}
+	CHECK(expectedRow == TEST_STREAM_HEIGHT);
+	CHECK(mismatches == 0);
+	CHECK(!reader.failed());
+
+	return failures;
+}
+
+// A top-down copy of the file, bands come top first with rows bottom to top
+static int TestReadTopDown()
+{
+	int failures = 0;
+
+	std::vector<uint8_t> file(bmp_header_size(IMAGE_COLOR_MODE_RGB));
+	fill_bmp_header(file.data(), TEST_STREAM_WIDTH, TEST_STREAM_HEIGHT, IMAGE_COLOR_MODE_RGB);
+
+	const int32_t negativeHeight = -TEST_STREAM_HEIGHT;
+	memcpy(&file[0x16], &negativeHeight, 4);
+
+	const size_t pitch = (TEST_STREAM_WIDTH * 3 + 3) / 4 * 4;
+	for (uint32_t fileRow = 0; fileRow < TEST_STREAM_HEIGHT; fileRow++)
+	{
+		std::vector<uint8_t> row(pitch, 0);
+		for (uint32_t col = 0; col < TEST_STREAM_WIDTH; col++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				row[col * 3 + c] = Pattern(TEST_STREAM_HEIGHT - 1 - fileRow, col, c);
+			}
+		}
+		file.insert(file.end(), row.begin(), row.end());
+	}
+
+	FILE* pFile = fopen(TEST_STREAM_BMP, "wb");
+	CHECK(pFile != nullptr);
+	if (pFile)
+	{
+		CHECK(fwrite(file.data(), 1, file.size(), pFile) == file.size());
+		fclose(pFile);
+	}
+	if (failures) return failures;
+
+	bmp_band_reader reader;
+	CHECK(reader.open(TEST_STREAM_BMP, TEST_STREAM_READ_BAND) == 0);
+	if (failures) return failures;
+	CHECK(reader.info().top_down);
+
+	uint32_t expectedEnd = TEST_STREAM_HEIGHT;
+	int mismatches = 0;
+	uint32_t firstRow, rows;
+	while (const uint8_t* pBand = reader.next_band(firstRow, rows))
+	{
+		CHECK(firstRow + rows == expectedEnd);
+		CHECK(rows == (std::min)((uint32_t)TEST_STREAM_READ_BAND, expectedEnd));
+		mismatches += CountMismatches(pBand, reader.row_pitch(), firstRow, rows);
+		expectedEnd -= rows;
+	}
+	CHECK(expectedEnd == 0);
+	CHECK(mismatches == 0);
+	CHECK(!reader.failed());
+
+	return failures;
+}
+
+static int TestErrors()
+{
+	int failures = 0;
+
+	bmp_band_reader reader;
+	CHECK(reader.open(TEST_STREAM_BMP, 0) == -1);
+	CHECK(reader.open("test_image_stream_missing.bmp", TEST_STREAM_READ_BAND) == -1);
+
+	// Closing before the last band reports the missing rows
+	bmp_band_writer writer;
+	CHECK(writer.open(TEST_STREAM_BMP, TEST_STREAM_WIDTH, 0, IMAGE_COLOR_MODE_RGB, 1) == -1);
+	CHECK(writer.open(TEST_STREAM_BMP, TEST_STREAM_WIDTH, TEST_STREAM_HEIGHT, IMAGE_COLOR_MODE_RGB,
+		TEST_STREAM_WRITE_BAND) == 0);
+
+	uint32_t firstRow, rows;
+	CHECK(writer.band(firstRow, rows) != nullptr);
+	CHECK(writer.commit_band() == 0);
+	CHECK(writer.close() == -1);
+
+	return failures;
+}
+
+int TestImageStream()
+{
+	int failures = 0;
+
+	failures += TestWrite();
+	failures += TestReadBottomUp();
+	failures += TestReadTopDown();
+	failures += TestErrors();
+
+	remove(TEST_STREAM_BMP);
+	return failures != 0;
+}
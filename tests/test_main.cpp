@@ -0,0 +1,70 @@
+/*****************************************************************//**
+ * \file   test_main.cpp
+ * \brief  Console runner of the headless tests
+ *
+ * Usage: tests [name]. Without a name every test runs. Tests need no
+ * GPU, they check the CPU side of what the renderer draws.
+ * Run from the repository root, some tests read the shipped Textures.
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cstdio>
+#include <cstring>
+
+#include "tests.h"
+
+struct test_entry
+{
+	const char* Name;
+	int (*Run)();
+};
+
+static const test_entry gTests[] =
+{
+	{ "geometry_cache", TestGeometryCache },
+	{ "image_bc", TestImageBc },
+	{ "image_bmp", TestImageBmp },
+	{ "image_convert", TestImageConvert },
+	{ "image_dds", TestImageDds },
+	{ "image_stream", TestImageStream },
+	{ "mesh_optimizer", TestMeshOptimizer },
+	{ "terrain_edit", TestTerrainEdit },
+	{ "terrain_erosion", TestTerrainErosion },
+	{ "terrain_lod", TestTerrainLod },
+	{ "terrain_rtin", TestTerrainRtin },
+	{ "terrain_sampler", TestTerrainSampler },
+	{ "terrain_shadow", TestTerrainShadow },
+	{ "terrain_stream", TestTerrainStream },
+	{ "vertex_packing", TestVertexPacking },
+};
+
+int main(int argc, char** argv)
+{
+	int failed = 0;
+	int run = 0;
+
+	for (const test_entry& test : gTests)
+	{
+		if (argc >= 2 && strcmp(argv[1], test.Name) != 0) continue;
+
+		int result = test.Run();
+		printf("%s %s\n", result == 0 ? "pass" : "FAIL", test.Name);
+
+		failed += result != 0;
+		run++;
+	}
+
+	if (run == 0)
+	{
+		fprintf(stderr, "Unknown test %s, available:\n", argv[1]);
+		for (const test_entry& test : gTests)
+		{
+			fprintf(stderr, "  %s\n", test.Name);
+		}
+		return 1;
+	}
+
+	printf("%d of %d tests failed\n", failed, run);
+	return failed != 0;
+}
@@ -0,0 +1,215 @@
+/*****************************************************************//**
+ * \file   test_mesh_optimizer.cpp
+ * \brief  Vertex cache analyser on known index orders, and both reorder
+ *         passes on terrain chunks and RTIN submeshes
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "mesh_optimizer.h"
+#include "terrain_mesh.h"
+#include "terrain_rtin.h"
+#include "test_util.h"
+#include "tests.h"
+
+// Several chunks, the last ones narrower than TERRAIN_CHUNK_QUADS
+#define TEST_OPTIMIZER_WIDTH 200
+#define TEST_OPTIMIZER_HEIGHT 150
+
+// Upper bound of ACMR after reordering a grid, 0.5 is the ideal and
+// row-major order gives about 1
+#define TEST_OPTIMIZER_GRID_ACMR 0.75f
+
+// RTIN error bound of the simplified submeshes
+#define TEST_OPTIMIZER_RTIN_ERROR 0.05f
+
+// ACMR when no vertex is ever reused
+#define TEST_OPTIMIZER_WORST_ACMR 3.0f
+
+typedef std::array<uint32_t, 3> test_triangle;
+
+// Triangle rotated to start at its smallest index, winding kept
+static test_triangle Canonical(uint32_t a, uint32_t b, uint32_t c)
+{
+	if (b < a && b < c) return { b, c, a };
+	if (c < a && c < b) return { c, a, b };
+	return { a, b, c };
+}
+
+// Sequences with known FIFO behaviour
+static int TestAnalyzer()
+{
+	int failures = 0;
+
+	// Two triangles sharing an edge
+	const uint16_t quad[] = { 0, 1, 2, 2, 1, 3 };
+	VertexCacheStats stats = AnalyzeVertexCache(quad, 6, 4);
+	CHECK(stats.Triangles == 2 && stats.Transforms == 4 && stats.Vertices == 4);
+	CHECK(stats.ACMR == 2.0f && stats.ATVR == 1.0f);
+
+	// A cache of 3 holds a whole triangle
+	const uint16_t repeated[] = { 0, 1, 2, 0, 1, 2 };
+	stats = AnalyzeVertexCache(repeated, 6, 3, 3);
+	CHECK(stats.Transforms == 3 && stats.ACMR == 1.5f && stats.ATVR == 1.0f);
+
+	// The first triangle leaves a cache of 3 before it is drawn again
+	const uint32_t evicted[] = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+	stats = AnalyzeVertexCache(evicted, 9, 6, 3);
+	CHECK(stats.Transforms == 9 && stats.Vertices == 6);
+	CHECK(stats.ACMR == 3.0f && stats.ATVR == 1.5f);
+
+	// A hit does not refresh the entry, so 3 evicts 0 and 4 evicts 2.
+	// An LRU cache would transform 5 vertices.
+	const uint32_t fifo[] = { 0, 1, 2, 0, 3, 0, 2, 4, 2 };
+	stats = AnalyzeVertexCache(fifo, 9, 5, 3);
+	CHECK(stats.Transforms == 7 && stats.Vertices == 5);
+
+	// Nothing to draw
+	stats = AnalyzeVertexCache(quad, 0, 4);
+	CHECK(stats.Triangles == 0 && stats.Transforms == 0 && stats.ACMR == 0.0f && stats.ATVR == 0.0f);
+
+	// Unused vertices go after the used ones, in their own order
+	const uint16_t sparse[] = { 4, 2, 5, 5, 2, 0 };
+	std::vector<uint32_t> remap;
+	BuildVertexFetchRemap(sparse, 6, 7, remap);
+	const uint32_t expected[] = { 3, 4, 1, 5, 0, 2, 6 };
+	CHECK(remap.size() == 7 && std::equal(remap.begin(), remap.end(), expected));
+
+	return failures;
+}
+
+// Runs both passes on one submesh as StaticGeometryUploader does. ACMR
+// and ATVR must fall, every vertex must keep its contents, and the
+// triangles must be the same with the same winding.
+static int CheckSubmesh(const Vertex* pVertices, size_t vertexCount, const uint16_t* pIndices, size_t indexCount,
+	float maxAcmr)
+{
+	int failures = 0;
+
+	std::vector<Vertex> vertices(pVertices, pVertices + vertexCount);
+	std::vector<uint16_t> indices(pIndices, pIndices + indexCount);
+	const VertexCacheStats before = AnalyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+	std::vector<uint32_t> remap;
+	OptimizeVertexCache(indices.data(), indexCount, vertexCount);
+	OptimizeVertexFetch(vertices.data(), vertexCount, indices.data(), indexCount, remap);
+	const VertexCacheStats after = AnalyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+	CHECK(after.Triangles == before.Triangles && after.Vertices == before.Vertices);
+	CHECK(after.ACMR < before.ACMR);
+	CHECK(after.ATVR < before.ATVR);
+	CHECK(after.ACMR <= maxAcmr);
+
+	// The remap is a permutation that moved every vertex with its contents
+	std::vector<uint32_t> original(vertexCount, UINT32_MAX);
+	size_t moved = 0;
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] >= vertexCount || original[remap[v]] != UINT32_MAX)
+		{
+			CHECK(!"remap is not a permutation");
+			return failures;
+		}
+		original[remap[v]] = (uint32_t)v;
+		moved += memcmp(&vertices[remap[v]], &pVertices[v], sizeof(Vertex)) != 0;
+	}
+	CHECK(moved == 0);
+
+	// Fetch follows first use
+	uint32_t next = 0;
+	size_t backwards = 0;
+	for (uint16_t index : indices)
+	{
+		if (index > next) backwards++;
+		if (index == next) next++;
+	}
+	CHECK(backwards == 0);
+
+	// Triangles in terms of the original vertices
+	std::vector<test_triangle> expected, triangles;
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		expected.push_back(Canonical(pIndices[i], pIndices[i + 1], pIndices[i + 2]));
+		triangles.push_back(Canonical(original[indices[i]], original[indices[i + 1]], original[indices[i + 2]]));
+	}
+	std::sort(expected.begin(), expected.end());
+	std::sort(triangles.begin(), triangles.end());
+	CHECK(triangles == expected);
+
+	if (failures)
+	{
+		fprintf(stderr, "%zu vertices, %zu triangles: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", vertexCount,
+			before.Triangles, before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+	}
+	return failures;
+}
+
+static void FillHills(HeightmapImage& heightmap)
+{
+	for (uint32_t row = 0; row < heightmap.GetHeight(); row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < heightmap.GetWidth(); col++)
+		{
+			pRow[col] = (uint8_t)(128.0f + 60.0f * sinf(row * 0.11f) * cosf(col * 0.07f));
+		}
+	}
+}
+
+// Row-major grid chunks reach near the ideal of a grid
+static int TestTerrainChunks()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_OPTIMIZER_WIDTH, TEST_OPTIMIZER_HEIGHT);
+	FillHills(heightmap);
+
+	const TerrainLayout layout(TEST_OPTIMIZER_WIDTH, TEST_OPTIMIZER_HEIGHT);
+	TerrainMeshData mesh;
+	BuildTerrainMesh(heightmap, layout, mesh, nullptr);
+	CHECK(mesh.Chunks.size() == 4);
+
+	for (const TerrainChunk& chunk : mesh.Chunks)
+	{
+		failures += CheckSubmesh(&mesh.Vertices[chunk.BaseVertex], chunk.VertexCount(),
+			&mesh.Indices[chunk.StartIndex], chunk.IndexCount(), TEST_OPTIMIZER_GRID_ACMR);
+	}
+	return failures;
+}
+
+// Simplified meshes have irregular fans, their orders only improve
+static int TestRtinSubmeshes()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_OPTIMIZER_WIDTH, TEST_OPTIMIZER_HEIGHT);
+	FillHills(heightmap);
+
+	const TerrainLayout layout(TEST_OPTIMIZER_WIDTH, TEST_OPTIMIZER_HEIGHT);
+	TerrainRtin rtin(heightmap, layout);
+	TerrainRtinMesh mesh;
+	CHECK(rtin.Extract(TEST_OPTIMIZER_RTIN_ERROR, mesh) == 0);
+	CHECK(!mesh.Submeshes.empty());
+
+	for (const TerrainRtinSubmesh& submesh : mesh.Submeshes)
+	{
+		failures += CheckSubmesh(&mesh.Vertices[submesh.BaseVertex], submesh.VertexCount,
+			&mesh.Indices[submesh.StartIndex], submesh.IndexCount, TEST_OPTIMIZER_WORST_ACMR);
+	}
+	return failures;
+}
+
+int TestMeshOptimizer()
+{
+	int failures = 0;
+	failures += TestAnalyzer();
+	failures += TestTerrainChunks();
+	failures += TestRtinSubmeshes();
+	return failures != 0;
+}
@@ -0,0 +1,307 @@
+/*****************************************************************//**
+ * \file   test_terrain_edit.cpp
+ * \brief  Terrain brushes and patched vertices against the mesh
+ *         regenerated from the edited heightmap
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_edit.h"
+#include "terrain_mesh.h"
+#include "test_util.h"
+#include "tests.h"
+
+// Two chunks in each direction, the last ones narrower
+#define TEST_EDIT_WIDTH 200
+#define TEST_EDIT_HEIGHT 150
+
+// Staging smaller than one stroke, so uploads split and span frames
+#define TEST_EDIT_SMALL_STAGING 256
+
+// Samples between 80 and 176, so that brushes do not clamp
+static void FillHeightmap(HeightmapImage& heightmap)
+{
+	for (uint32_t row = 0; row < heightmap.GetHeight(); row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < heightmap.GetWidth(); col++)
+		{
+			pRow[col] = (uint8_t)(128 + 48 * std::sin(row * 0.11f) * std::cos(col * 0.07f));
+		}
+	}
+}
+
+// Vertex buffer as the renderer holds it: every chunk's vertices
+// reordered by its remap. Remaps are reversed, so that a missed remap
+// lands on the wrong vertex.
+struct edited_terrain
+{
+	std::vector<Vertex> Buffer;
+	std::vector<SubmeshGeometry> Submeshes;
+	std::vector<std::vector<uint32_t>> Remaps;
+};
+
+static void Reorder(const TerrainMeshData& mesh, const std::vector<std::vector<uint32_t>>& remaps,
+	std::vector<Vertex>& buffer)
+{
+	buffer.resize(mesh.Vertices.size());
+	for (size_t c = 0; c < mesh.Chunks.size(); c++)
+	{
+		const size_t base = mesh.Chunks[c].BaseVertex;
+		for (size_t v = 0; v < remaps[c].size(); v++)
+		{
+			buffer[base + remaps[c][v]] = mesh.Vertices[base + v];
+		}
+	}
+}
+
+static void BuildTerrain(HeightmapImage& heightmap, edited_terrain& terrain)
+{
+	TerrainLayout layout(heightmap.GetWidth(), heightmap.GetHeight());
+	TerrainMeshData mesh;
+	BuildTerrainMesh(heightmap, layout, mesh, nullptr);
+
+	for (const TerrainChunk& chunk : mesh.Chunks)
+	{
+		SubmeshGeometry submesh;
+		submesh.IndexCount = (UINT)chunk.IndexCount();
+		submesh.StartIndexLocation = (UINT)chunk.StartIndex;
+		submesh.BaseVertexLocation = (INT)chunk.BaseVertex;
+		terrain.Submeshes.push_back(submesh);
+
+		std::vector<uint32_t> remap(chunk.VertexCount());
+		for (size_t i = 0; i < remap.size(); i++) remap[i] = (uint32_t)(remap.size() - 1 - i);
+		terrain.Remaps.push_back(remap);
+	}
+
+	Reorder(mesh, terrain.Remaps, terrain.Buffer);
+}
+
+// Uploads everything pending, as frames with a staging buffer of the
+// given capacity would, and compares the patched buffer with the mesh
+// of the edited heightmap
+static int CheckUpload(HeightmapImage& heightmap, TerrainEditor& editor, edited_terrain& terrain,
+	UINT capacity)
+{
+	int failures = 0;
+	std::vector<Vertex> staging(capacity);
+	std::vector<TerrainVertexCopy> copies;
+
+	while (editor.HasPendingUpload())
+	{
+		const UINT staged = editor.PrepareUpload(staging.data(), capacity, copies);
+		CHECK(staged > 0);
+		if (staged == 0) return failures;
+
+		UINT copied = 0;
+		for (const TerrainVertexCopy& copy : copies)
+		{
+			CHECK(copy.StagingVertex == copied);
+			CHECK(copy.BufferVertex + copy.VertexCount <= terrain.Buffer.size());
+			if (copy.BufferVertex + copy.VertexCount > terrain.Buffer.size()) return failures;
+
+			memcpy(&terrain.Buffer[copy.BufferVertex], &staging[copy.StagingVertex],
+				copy.VertexCount * sizeof(Vertex));
+			copied += copy.VertexCount;
+		}
+		CHECK(copied == staged);
+	}
+
+	TerrainLayout layout(heightmap.GetWidth(), heightmap.GetHeight());
+	TerrainMeshData mesh;
+	BuildTerrainMesh(heightmap, layout, mesh, nullptr);
+
+	std::vector<Vertex> expected;
+	Reorder(mesh, terrain.Remaps, expected);
+	CHECK(expected.size() == terrain.Buffer.size());
+
+	size_t mismatches = 0;
+	for (size_t v = 0; v < expected.size() && v < terrain.Buffer.size(); v++)
+	{
+		mismatches += memcmp(&expected[v], &terrain.Buffer[v], sizeof(Vertex)) != 0;
+	}
+	CHECK(mismatches == 0);
+	return failures;
+}
+
+// Samples outside the rect are unchanged
+static int CheckOutside(HeightmapImage& before, HeightmapImage& after, const TerrainDirtyRect& rect)
+{
+	int failures = 0;
+	size_t changed = 0;
+	for (uint32_t row = 0; row < after.GetHeight(); row++)
+	{
+		for (uint32_t col = 0; col < after.GetWidth(); col++)
+		{
+			const bool inside = row >= rect.FirstRow && row < rect.EndRow && col >= rect.FirstCol && col < rect.EndCol;
+			if (!inside) changed += before.GetRow(row)[col] != after.GetRow(row)[col];
+		}
+	}
+	CHECK(changed == 0);
+	return failures;
+}
+
+static void CopyHeightmap(HeightmapImage& src, HeightmapImage& dst)
+{
+	for (uint32_t row = 0; row < src.GetHeight(); row++)
+	{
+		memcpy(dst.GetWritableRow(row), src.GetRow(row), src.GetWidth());
+	}
+}
+
+// Raise, lower and flatten across chunk borders, each uploaded through
+// the full staging buffer and through one smaller than a stroke
+static int TestBrushes()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_EDIT_WIDTH, TEST_EDIT_HEIGHT);
+	FillHeightmap(heightmap);
+
+	edited_terrain terrain;
+	BuildTerrain(heightmap, terrain);
+	TerrainEditor editor(heightmap, terrain.Submeshes.data(), terrain.Remaps);
+	const TerrainLayout& layout = editor.GetLayout();
+	CHECK(terrain.Submeshes.size() == 4);
+
+	HeightmapImage before(TEST_EDIT_WIDTH, TEST_EDIT_HEIGHT);
+
+	// Centres on the chunk border, rows along X and columns along Z
+	const UINT centreRow = TERRAIN_CHUNK_QUADS + 1;
+	const UINT centreCol = TERRAIN_CHUNK_QUADS + 1;
+	const float x = layout.WorldX(centreRow);
+	const float z = layout.WorldZ(centreCol);
+
+	TerrainBrush brush;
+	brush.Radius = 10.0f;
+	brush.Strength = 20.0f;
+	brush.TargetHeight = 40.0f;			// Below every sample
+
+	const TERRAIN_BRUSH modes[] = { TERRAIN_BRUSH_RAISE, TERRAIN_BRUSH_LOWER, TERRAIN_BRUSH_FLATTEN };
+	for (TERRAIN_BRUSH mode : modes)
+	{
+		for (UINT capacity : { (UINT)TERRAIN_EDIT_STAGING_VERTICES, (UINT)TEST_EDIT_SMALL_STAGING })
+		{
+			CopyHeightmap(heightmap, before);
+			brush.Mode = mode;
+
+			const TerrainDirtyRect rect = editor.ApplyBrush(brush, x, z);
+			CHECK(!rect.Empty());
+			CHECK(rect.FirstRow == centreRow - 10 && rect.EndRow == centreRow + 11);
+			CHECK(rect.FirstCol == centreCol - 10 && rect.EndCol == centreCol + 11);
+			CHECK(editor.HasPendingUpload());
+			failures += CheckOutside(before, heightmap, rect);
+
+			// Samples only move in the brush's direction, the centre by the
+			// full strength
+			const int centre = before.GetRow(centreRow)[centreCol];
+			const int edited = heightmap.GetRow(centreRow)[centreCol];
+			size_t wrongWay = 0;
+			for (UINT row = rect.FirstRow; row < rect.EndRow; row++)
+			{
+				for (UINT col = rect.FirstCol; col < rect.EndCol; col++)
+				{
+					const int old = before.GetRow(row)[col];
+					const int now = heightmap.GetRow(row)[col];
+					switch (mode)
+					{
+					case TERRAIN_BRUSH_RAISE: wrongWay += now < old; break;
+					case TERRAIN_BRUSH_LOWER: wrongWay += now > old; break;
+					case TERRAIN_BRUSH_FLATTEN:
+						wrongWay += std::abs(now - (int)brush.TargetHeight) > std::abs(old - (int)brush.TargetHeight);
+						break;
+					}
+				}
+			}
+			CHECK(wrongWay == 0);
+
+			switch (mode)
+			{
+			case TERRAIN_BRUSH_RAISE: CHECK(edited == centre + 20); break;
+			case TERRAIN_BRUSH_LOWER: CHECK(edited == centre - 20); break;
+			case TERRAIN_BRUSH_FLATTEN:
+				CHECK(std::abs(edited - (int)brush.TargetHeight) < std::abs(centre - (int)brush.TargetHeight));
+				break;
+			}
+
+			failures += CheckUpload(heightmap, editor, terrain, capacity);
+		}
+	}
+	return failures;
+}
+
+// Brushes over the corners clip to the map, border samples included,
+// and a brush off the map changes nothing
+static int TestEdges()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_EDIT_WIDTH, TEST_EDIT_HEIGHT);
+	FillHeightmap(heightmap);
+
+	edited_terrain terrain;
+	BuildTerrain(heightmap, terrain);
+	TerrainEditor editor(heightmap, terrain.Submeshes.data(), terrain.Remaps);
+	const TerrainLayout& layout = editor.GetLayout();
+
+	HeightmapImage before(TEST_EDIT_WIDTH, TEST_EDIT_HEIGHT);
+	TerrainBrush brush;
+	brush.Radius = 6.0f;
+
+	// First sample
+	CopyHeightmap(heightmap, before);
+	TerrainDirtyRect rect = editor.ApplyBrush(brush, layout.WorldX(0), layout.WorldZ(0));
+	CHECK(rect.FirstRow == 0 && rect.FirstCol == 0);
+	CHECK(rect.EndRow == 7 && rect.EndCol == 7);
+	CHECK(heightmap.GetRow(0)[0] > before.GetRow(0)[0]);
+	failures += CheckOutside(before, heightmap, rect);
+	failures += CheckUpload(heightmap, editor, terrain, TERRAIN_EDIT_STAGING_VERTICES);
+
+	// Last sample, the centre half a sample past the map
+	CopyHeightmap(heightmap, before);
+	brush.Mode = TERRAIN_BRUSH_LOWER;
+	rect = editor.ApplyBrush(brush, layout.WorldX(TEST_EDIT_HEIGHT - 1) + 0.5f * layout.Dx,
+		layout.WorldZ(TEST_EDIT_WIDTH - 1) - 0.5f * layout.Dz);
+	CHECK(rect.EndRow == TEST_EDIT_HEIGHT && rect.EndCol == TEST_EDIT_WIDTH);
+	CHECK(rect.FirstRow == TEST_EDIT_HEIGHT - 7 && rect.FirstCol == TEST_EDIT_WIDTH - 7);
+	CHECK(heightmap.GetRow(TEST_EDIT_HEIGHT - 1)[TEST_EDIT_WIDTH - 1] <
+		before.GetRow(TEST_EDIT_HEIGHT - 1)[TEST_EDIT_WIDTH - 1]);
+	failures += CheckOutside(before, heightmap, rect);
+	failures += CheckUpload(heightmap, editor, terrain, TERRAIN_EDIT_STAGING_VERTICES);
+
+	// Off the map on either side
+	CopyHeightmap(heightmap, before);
+	const float outside[][2] =
+	{
+		{ layout.WorldX(0) - 3.0f * brush.Radius * layout.Dx, layout.WorldZ(TEST_EDIT_WIDTH / 2) },
+		{ layout.WorldX(TEST_EDIT_HEIGHT / 2), layout.WorldZ(TEST_EDIT_WIDTH - 1) - 3.0f * brush.Radius * layout.Dz },
+	};
+	for (const float* position : outside)
+	{
+		rect = editor.ApplyBrush(brush, position[0], position[1]);
+		CHECK(rect.Empty());
+		CHECK(!editor.HasPendingUpload());
+		failures += CheckOutside(before, heightmap, rect);
+	}
+
+	// Nothing pending stages nothing
+	std::vector<Vertex> staging(TEST_EDIT_SMALL_STAGING);
+	std::vector<TerrainVertexCopy> copies(1);
+	CHECK(editor.PrepareUpload(staging.data(), TEST_EDIT_SMALL_STAGING, copies) == 0);
+	CHECK(copies.empty());
+
+	return failures;
+}
+
+int TestTerrainEdit()
+{
+	int failures = 0;
+	failures += TestBrushes();
+	failures += TestEdges();
+	return failures != 0;
+}
@@ -0,0 +1,202 @@
+/*****************************************************************//**
+ * \file   test_terrain_erosion.cpp
+ * \brief  Hydraulic and thermal erosion from a heightmap back to files
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_erosion.h"
+#include "test_util.h"
+#include "tests.h"
+#include "thread_pool.h"
+
+#define TEST_EROSION_BMP "test_terrain_erosion.bmp"
+#define TEST_EROSION_RAW "test_terrain_erosion.r16"
+
+// Not a multiple of TERRAIN_EROSION_ROW_GRAIN, so the last work item is short
+#define TEST_EROSION_WIDTH 150
+#define TEST_EROSION_HEIGHT 117
+
+// Steep cone with ridges, far above the talus
+static void FillHeightmap(HeightmapImage& heightmap)
+{
+	const float centerRow = TEST_EROSION_HEIGHT * 0.5f;
+	const float centerCol = TEST_EROSION_WIDTH * 0.4f;
+
+	for (uint32_t row = 0; row < heightmap.GetHeight(); row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < heightmap.GetWidth(); col++)
+		{
+			const float dr = row - centerRow;
+			const float dc = col - centerCol;
+			const float cone = 250.0f - 5.0f * std::sqrt(dr * dr + dc * dc);
+			const float ridges = 20.0f * sinf(col * 0.7f) * cosf(row * 0.3f);
+			pRow[col] = (uint8_t)(std::min)((std::max)(cone + ridges, 0.0f), 255.0f);
+		}
+	}
+}
+
+static bool SameField(const float* a, const float* b, size_t count)
+{
+	return memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+static double SumField(const float* pField, size_t count)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < count; i++) sum += pField[i];
+	return sum;
+}
+
+// Largest height difference between neighbouring samples
+static float MaxStep(const TerrainErosion& erosion)
+{
+	const float* h = erosion.GetHeights();
+	const uint32_t w = erosion.GetWidth();
+
+	float step = 0.0f;
+	for (uint32_t row = 0; row < erosion.GetHeight(); row++)
+	{
+		for (uint32_t col = 0; col < w; col++)
+		{
+			const size_t i = static_cast<size_t>(row) * w + col;
+			if (col + 1 < w) step = (std::max)(step, std::fabs(h[i] - h[i + 1]));
+			if (row + 1 < erosion.GetHeight()) step = (std::max)(step, std::fabs(h[i] - h[i + w]));
+		}
+	}
+	return step;
+}
+
+static int TestThermal(HeightmapImage& heightmap, WorkerPool& pool)
+{
+	int failures = 0;
+
+	TerrainErosion serial(heightmap);
+	TerrainErosion parallel(heightmap);
+	const size_t cells = static_cast<size_t>(serial.GetWidth()) * serial.GetHeight();
+
+	const double before = SumField(serial.GetHeights(), cells);
+	const float stepBefore = MaxStep(serial);
+
+	ThermalErosionSettings settings;
+	serial.ErodeThermal(settings, 200, nullptr);
+	parallel.ErodeThermal(settings, 200, &pool);
+
+	// Rows are independent, the thread count does not change the result
+	CHECK(SameField(serial.GetHeights(), parallel.GetHeights(), cells));
+
+	// Material only moves between cells, and steep slopes flatten
+	const double after = SumField(serial.GetHeights(), cells);
+	CHECK(std::fabs(after - before) <= 1e-4 * before);
+	CHECK(MaxStep(serial) < 0.5f * stepBefore);
+
+	return failures;
+}
+
+static int TestHydraulic(HeightmapImage& heightmap, WorkerPool& pool)
+{
+	int failures = 0;
+
+	TerrainErosion serial(heightmap);
+	TerrainErosion parallel(heightmap);
+	const size_t cells = static_cast<size_t>(serial.GetWidth()) * serial.GetHeight();
+	const std::vector<float> original(serial.GetHeights(), serial.GetHeights() + cells);
+
+	HydraulicErosionSettings settings;
+	serial.ErodeHydraulic(settings, 100, nullptr);
+	parallel.ErodeHydraulic(settings, 100, &pool);
+
+	CHECK(SameField(serial.GetHeights(), parallel.GetHeights(), cells));
+	CHECK(SameField(serial.GetWater(), parallel.GetWater(), cells));
+
+	// Water flowed and moved ground, everything stayed finite
+	int invalid = 0;
+	float changed = 0.0f;
+	for (size_t i = 0; i < cells; i++)
+	{
+		const float h = serial.GetHeights()[i];
+		const float d = serial.GetWater()[i];
+		invalid += !std::isfinite(h) || !std::isfinite(d) || d < 0.0f;
+		changed = (std::max)(changed, std::fabs(h - original[i]));
+	}
+	CHECK(invalid == 0);
+	CHECK(changed > 0.01f);
+
+	return failures;
+}
+
+// Heights written to an 8-bit BMP and to 16-bit raw samples read back as
+// the rounded heights
+static int TestWriteBack(HeightmapImage& heightmap, WorkerPool& pool)
+{
+	int failures = 0;
+
+	TerrainErosion erosion(heightmap);
+	erosion.ErodeThermal(ThermalErosionSettings(), 20, &pool);
+	erosion.ErodeHydraulic(HydraulicErosionSettings(), 20, &pool);
+
+	const uint32_t width = erosion.GetWidth();
+	const uint32_t height = erosion.GetHeight();
+	const float* pHeights = erosion.GetHeights();
+
+	HeightmapImage eroded(width, height);
+	erosion.WriteHeightmap(eroded);
+	CHECK(eroded.WriteBmp(TEST_EROSION_BMP) == 0);
+	CHECK(erosion.WriteRaw16(TEST_EROSION_RAW) == 0);
+	if (failures) return failures;
+
+	HeightmapImage bmp(TEST_EROSION_BMP);
+	CHECK(bmp.GetWidth() == width && bmp.GetHeight() == height);
+
+	std::vector<uint8_t> raw(static_cast<size_t>(width) * height * 2 + 1);
+	FILE* file = fopen(TEST_EROSION_RAW, "rb");
+	CHECK(file != nullptr);
+	if (file)
+	{
+		CHECK(fread(raw.data(), 1, raw.size(), file) == raw.size() - 1);
+		fclose(file);
+	}
+	if (failures) return failures;
+
+	int mismatches = 0;
+	for (uint32_t row = 0; row < height; row++)
+	{
+		for (uint32_t col = 0; col < width; col++)
+		{
+			const size_t i = static_cast<size_t>(row) * width + col;
+			const float value = (std::min)((std::max)(pHeights[i], 0.0f), 255.0f);
+
+			const uint16_t sample = (uint16_t)(raw[i * 2] | (raw[i * 2 + 1] << 8));
+			mismatches += bmp.GetPixel(row, col) != (uint8_t)(value + 0.5f);
+			mismatches += sample != (uint16_t)(value * 257.0f + 0.5f);
+		}
+	}
+	CHECK(mismatches == 0);
+
+	return failures;
+}
+
+int TestTerrainErosion()
+{
+	int failures = 0;
+
+	HeightmapImage heightmap(TEST_EROSION_WIDTH, TEST_EROSION_HEIGHT);
+	FillHeightmap(heightmap);
+
+	WorkerPool pool(3);
+	failures += TestThermal(heightmap, pool);
+	failures += TestHydraulic(heightmap, pool);
+	failures += TestWriteBack(heightmap, pool);
+
+	remove(TEST_EROSION_BMP);
+	remove(TEST_EROSION_RAW);
+	return failures != 0;
+}
@@ -0,0 +1,226 @@
+/*****************************************************************//**
+ * \file   test_terrain_lod.cpp
+ * \brief  CDLOD patch layout and quadtree selection
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "terrain_lod.h"
+#include "test_util.h"
+#include "tests.h"
+
+using namespace DirectX;
+
+// Heightmap samples of the test terrain, the vertex grid is 2 smaller
+#define TEST_LOD_SAMPLES 1026
+
+static int TestPatch()
+{
+	int failures = 0;
+
+	const UINT quads = 32;
+	const UINT n = quads + 1;
+	const UINT half = quads / 2;
+
+	std::vector<Vertex> vertices;
+	std::vector<uint16_t> indices;
+	BuildTerrainLodPatch(quads, vertices, indices);
+
+	CHECK(vertices.size() == static_cast<size_t>(n) * n);
+	CHECK(indices.size() == static_cast<size_t>(quads) * quads * 6);
+	if (failures) return failures;
+
+	const size_t quarter = indices.size() / 4;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		// Every triangle of quadrant q lies inside it
+		const UINT q = static_cast<UINT>(i / quarter);
+		const UINT firstRow = (q >> 1) * half;
+		const UINT firstCol = (q & 1) * half;
+
+		for (size_t k = i; k < i + 3; k++)
+		{
+			const UINT row = indices[k] % n;
+			const UINT col = indices[k] / n;
+			CHECK(row >= firstRow && row <= firstRow + half);
+			CHECK(col >= firstCol && col <= firstCol + half);
+		}
+
+		// Patch columns run towards -Z in the world, as chunk columns do,
+		// and triangles face up like the chunks
+		const XMFLOAT3& a = vertices[indices[i]].Pos;
+		const XMFLOAT3& b = vertices[indices[i + 1]].Pos;
+		const XMFLOAT3& c = vertices[indices[i + 2]].Pos;
+		const float e1x = b.x - a.x, e1z = a.z - b.z;
+		const float e2x = c.x - a.x, e2z = a.z - c.z;
+		CHECK(e1z * e2x - e1x * e2z > 0.0f);
+	}
+
+	// Vertices span [0, 1]^2, column after column
+	CHECK(vertices.front().Pos.x == 0.0f && vertices.front().Pos.z == 0.0f);
+	CHECK(vertices[1].Pos.x > 0.0f && vertices[1].Pos.z == 0.0f);
+	CHECK(vertices.back().Pos.x == 1.0f && vertices.back().Pos.z == 1.0f);
+
+	return failures;
+}
+
+// Grid quads [firstRow, firstRow + size) x [firstCol, firstCol + size)
+// the draw covers
+static void GetDrawArea(const TerrainLodDraw& draw, UINT& firstRow, UINT& firstCol, UINT& size)
+{
+	firstRow = draw.FirstRow;
+	firstCol = draw.FirstCol;
+	size = draw.Size;
+	if (draw.Quadrant >= 0)
+	{
+		size /= 2;
+		firstRow += (draw.Quadrant >> 1) * size;
+		firstCol += (draw.Quadrant & 1) * size;
+	}
+}
+
+// Grid quads covered by each draw, counted per quad
+static std::vector<int> CountCoverage(const TerrainLayout& layout,
+	const std::vector<TerrainLodDraw>& draws)
+{
+	const UINT quadRows = layout.GridRows() - 1;
+	const UINT quadCols = layout.GridColumns() - 1;
+	std::vector<int> coverage(static_cast<size_t>(quadRows) * quadCols, 0);
+
+	for (const TerrainLodDraw& draw : draws)
+	{
+		UINT firstRow, firstCol, size;
+		GetDrawArea(draw, firstRow, firstCol, size);
+
+		for (UINT r = firstRow; r < (std::min)(firstRow + size, quadRows); r++)
+		{
+			for (UINT c = firstCol; c < (std::min)(firstCol + size, quadCols); c++)
+			{
+				coverage[static_cast<size_t>(r) * quadCols + c]++;
+			}
+		}
+	}
+
+	return coverage;
+}
+
+static int TestSelection()
+{
+	int failures = 0;
+
+	const TerrainLayout layout(TEST_LOD_SAMPLES, TEST_LOD_SAMPLES);
+	const UINT gridRows = layout.GridRows();
+	const UINT gridCols = layout.GridColumns();
+
+	// Rolling hills, row after row
+	std::vector<float> heights(static_cast<size_t>(gridRows) * gridCols);
+	for (UINT r = 0; r < gridRows; r++)
+	{
+		for (UINT c = 0; c < gridCols; c++)
+		{
+			heights[static_cast<size_t>(r) * gridCols + c] =
+				4.0f * sinf(r * 0.02f) * cosf(c * 0.015f);
+		}
+	}
+
+	TerrainQuadtree tree(heights.data(), layout);
+	const TerrainLodSettings& settings = tree.GetSettings();
+
+	const UINT eyeRow = 300;
+	const UINT eyeCol = 400;
+	const XMFLOAT3 eye(layout.WorldX(eyeRow + 1),
+		heights[static_cast<size_t>(eyeRow) * gridCols + eyeCol] + 2.0f,
+		layout.WorldZ(eyeCol + 1));
+
+	// Planes (0, 0, 0, 1) keep everything
+	Frustum all;
+	for (XMFLOAT4& plane : all.Planes) plane = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	std::vector<TerrainLodDraw> draws;
+	tree.Select(eye, all, draws);
+	CHECK(!draws.empty());
+
+	for (const TerrainLodDraw& draw : draws)
+	{
+		// Nodes are aligned to their size and drawn within their range
+		CHECK(draw.Lod < settings.LodCount);
+		CHECK(draw.Size == settings.LeafQuads << draw.Lod);
+		CHECK(draw.FirstRow % draw.Size == 0 && draw.FirstCol % draw.Size == 0);
+		CHECK(draw.MorphStart < draw.MorphEnd);
+		CHECK(draw.MorphEnd == tree.GetVisibilityRange(draw.Lod));
+
+		BoundingBoxAA box = tree.GetNodeBox(draw.Lod, draw.FirstRow / draw.Size, draw.FirstCol / draw.Size);
+		CHECK(DistanceSquared(box, eye) <= draw.MorphEnd * draw.MorphEnd);
+	}
+
+	// No quad is drawn twice, and everything in the coarsest range is drawn
+	const UINT quadRows = gridRows - 1;
+	const UINT quadCols = gridCols - 1;
+	const float farRange = tree.GetVisibilityRange(settings.LodCount - 1);
+	std::vector<int> coverage = CountCoverage(layout, draws);
+
+	int overlaps = 0;
+	int holes = 0;
+	for (UINT r = 0; r < quadRows; r++)
+	{
+		for (UINT c = 0; c < quadCols; c++)
+		{
+			const int count = coverage[static_cast<size_t>(r) * quadCols + c];
+			overlaps += count > 1;
+
+			const float dx = layout.WorldX(r + 1) - eye.x;
+			const float dy = heights[static_cast<size_t>(r) * gridCols + c] - eye.y;
+			const float dz = layout.WorldZ(c + 1) - eye.z;
+			holes += count == 0 && dx * dx + dy * dy + dz * dz < farRange * farRange;
+		}
+	}
+	CHECK(overlaps == 0);
+	CHECK(holes == 0);
+
+	// The finest LOD is drawn under the eye
+	for (const TerrainLodDraw& draw : draws)
+	{
+		UINT firstRow, firstCol, size;
+		GetDrawArea(draw, firstRow, firstCol, size);
+
+		if (eyeRow >= firstRow && eyeRow < firstRow + size &&
+			eyeCol >= firstCol && eyeCol < firstCol + size)
+		{
+			CHECK(draw.Lod == 0);
+		}
+	}
+
+	// LOD draws far fewer triangles than the full grid
+	const size_t fullTriangles = 2 * static_cast<size_t>(quadRows) * quadCols;
+	const size_t triangles = tree.CountTriangles(draws);
+	CHECK(triangles > 0 && triangles < fullTriangles / 4);
+
+	// Half-space x >= eye.x culls the nodes behind it
+	Frustum half = all;
+	half.Planes[0] = XMFLOAT4(1.0f, 0.0f, 0.0f, -eye.x);
+
+	std::vector<TerrainLodDraw> halfDraws;
+	tree.Select(eye, half, halfDraws);
+	CHECK(!halfDraws.empty());
+	CHECK(halfDraws.size() < draws.size());
+
+	for (const TerrainLodDraw& draw : halfDraws)
+	{
+		BoundingBoxAA box = tree.GetNodeBox(draw.Lod, draw.FirstRow / draw.Size, draw.FirstCol / draw.Size);
+		CHECK(box.Max.x >= eye.x);
+	}
+
+	return failures;
+}
+
+int TestTerrainLod()
+{
+	int failures = 0;
+	failures += TestPatch();
+	failures += TestSelection();
+	return failures != 0;
+}
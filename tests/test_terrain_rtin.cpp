@@ -0,0 +1,90 @@
+/*****************************************************************//**
+ * \file   test_terrain_rtin.cpp
+ * \brief  RTIN extraction on grids that do not fill the padded square
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+#include "image_helper.h"
+#include "terrain_rtin.h"
+#include "test_util.h"
+#include "tests.h"
+
+int TestTerrainRtin()
+{
+	int failures = 0;
+
+	// 98 x 68 vertex grid, padded to 129 x 129
+	const uint32_t width = 100;
+	const uint32_t height = 70;
+	HeightmapImage heightmap(width, height);
+	for (uint32_t row = 0; row < height; row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < width; col++)
+		{
+			pRow[col] = static_cast<uint8_t>(128.0f + 60.0f * sinf(row * 0.2f) * cosf(col * 0.13f));
+		}
+	}
+
+	const TerrainLayout layout(width, height);
+	TerrainRtin rtin(heightmap, layout);
+	CHECK(rtin.GetSize() == 129);
+
+	TerrainRtinMesh mesh;
+	const size_t fullTriangles = 2 * static_cast<size_t>(layout.GridRows() - 1) * (layout.GridColumns() - 1);
+
+	// Negative bound keeps every grid triangle
+	CHECK(rtin.Extract(-1.0f, mesh) == 0);
+	CHECK(mesh.Indices.size() / 3 == fullTriangles);
+	CHECK(rtin.MeasureError(mesh) == 0.0f);
+
+	// Huge bounds used to keep triangles crossing the grid border, whose
+	// vertices lie past the samples
+	const float bounds[] = { 0.0f, 0.05f, 0.25f, 1.0f, 1e6f, FLT_MAX };
+	size_t previous = fullTriangles + 1;
+
+	for (float bound : bounds)
+	{
+		CHECK(rtin.Extract(bound, mesh) == 0);
+		CHECK(!mesh.Submeshes.empty());
+		CHECK(rtin.MeasureError(mesh) <= (std::min)(bound, 1e6f));
+
+		const size_t triangles = mesh.Indices.size() / 3;
+		CHECK(triangles > 0 && triangles < previous);
+		previous = triangles;
+
+		// Every vertex lies on the grid
+		const float minX = layout.WorldX(1) - 1e-3f;
+		const float maxX = layout.WorldX(layout.GridRows()) + 1e-3f;
+		const float minZ = layout.WorldZ(layout.GridColumns()) - 1e-3f;
+		const float maxZ = layout.WorldZ(1) + 1e-3f;
+		for (const Vertex& v : mesh.Vertices)
+		{
+			CHECK(v.Pos.x >= minX && v.Pos.x <= maxX);
+			CHECK(v.Pos.z >= minZ && v.Pos.z <= maxZ);
+			if (failures) return 1;
+		}
+
+		for (const TerrainRtinSubmesh& submesh : mesh.Submeshes)
+		{
+			CHECK(submesh.VertexCount <= 65536);
+			for (size_t i = submesh.StartIndex; i < submesh.StartIndex + submesh.IndexCount; i++)
+			{
+				CHECK(mesh.Indices[i] < submesh.VertexCount);
+			}
+		}
+	}
+
+	// Bounds that are not finite are rejected
+	CHECK(rtin.Extract(std::numeric_limits<float>::infinity(), mesh) == -1);
+	CHECK(rtin.Extract(std::numeric_limits<float>::quiet_NaN(), mesh) == -1);
+	CHECK(mesh.Submeshes.empty());
+
+	return failures != 0;
+}
@@ -0,0 +1,272 @@
+/*****************************************************************//**
+ * \file   test_terrain_sampler.cpp
+ * \brief  Height queries against known samples, clamping at the map
+ *         edges and reloading edited samples
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_mesh.h"
+#include "terrain_sampler.h"
+#include "test_util.h"
+#include "tests.h"
+
+// Not square, so that rows and columns cannot be swapped unnoticed
+#define TEST_SAMPLER_WIDTH 20
+#define TEST_SAMPLER_HEIGHT 13
+
+// Heights are exact in floats, positions go through a reciprocal
+#define TEST_SAMPLER_EPSILON 1e-4f
+
+// Positions of the batch test, not a multiple of any SIMD width
+#define TEST_SAMPLER_BATCH 203
+
+static uint8_t Pattern(uint32_t row, uint32_t col)
+{
+	return (uint8_t)((row * 37 + col * 11 + row * col) % 251);
+}
+
+static void FillPattern(HeightmapImage& heightmap)
+{
+	for (uint32_t row = 0; row < heightmap.GetHeight(); row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < heightmap.GetWidth(); col++) pRow[col] = Pattern(row, col);
+	}
+}
+
+// World height of a sample
+static float Height(uint32_t row, uint32_t col)
+{
+	return TerrainLayout::SampleHeight((float)Pattern(row, col));
+}
+
+static bool Near(float a, float b)
+{
+	return std::fabs(a - b) <= TEST_SAMPLER_EPSILON;
+}
+
+// Samples at their own positions, and bilinear blends of known samples
+// between them, rows along X and columns along Z
+static int TestBilinear()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_SAMPLER_WIDTH, TEST_SAMPLER_HEIGHT);
+	FillPattern(heightmap);
+
+	const TerrainHeightSampler sampler(heightmap);
+	const TerrainLayout& layout = sampler.GetLayout();
+
+	size_t wrong = 0;
+	for (uint32_t row = 0; row < TEST_SAMPLER_HEIGHT; row++)
+	{
+		for (uint32_t col = 0; col < TEST_SAMPLER_WIDTH; col++)
+		{
+			const float x = layout.WorldX(row);
+			const float z = layout.WorldZ(col);
+			wrong += !Near(sampler.GetHeight(x, z), Height(row, col));
+			wrong += !Near(sampler.Sample(x, z, TERRAIN_FILTER_BICUBIC).Height, Height(row, col));
+		}
+	}
+	CHECK(wrong == 0);
+
+	// A quarter of the way to the next row, half way to the next column
+	const uint32_t row = 5, col = 8;
+	const float x = layout.WorldX(row) + 0.25f * layout.Dx;
+	const float z = layout.WorldZ(col) - 0.5f * layout.Dz;
+	const float top = 0.5f * (Height(row, col) + Height(row, col + 1));
+	const float bottom = 0.5f * (Height(row + 1, col) + Height(row + 1, col + 1));
+	CHECK(Near(sampler.GetHeight(x, z), 0.75f * top + 0.25f * bottom));
+
+	// Heights of Sample and GetHeight agree
+	CHECK(sampler.Sample(x, z).Height == sampler.GetHeight(x, z));
+
+	return failures;
+}
+
+// A plane of samples: bilinear and bicubic heights and normals are the
+// plane's inside the map
+static int TestPlane()
+{
+	int failures = 0;
+	const float rowSlope = 3.0f, colSlope = -2.0f;
+
+	HeightmapImage heightmap(TEST_SAMPLER_WIDTH, TEST_SAMPLER_HEIGHT);
+	for (uint32_t row = 0; row < TEST_SAMPLER_HEIGHT; row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (uint32_t col = 0; col < TEST_SAMPLER_WIDTH; col++)
+		{
+			pRow[col] = (uint8_t)(100 + rowSlope * row + colSlope * col);
+		}
+	}
+
+	const TerrainHeightSampler sampler(heightmap);
+	const TerrainLayout& layout = sampler.GetLayout();
+
+	// Height rises along X with rows and falls along Z with columns
+	const float dhdx = rowSlope * TERRAIN_HEIGHT_SCALE / layout.Dx;
+	const float dhdz = -colSlope * TERRAIN_HEIGHT_SCALE / layout.Dz;
+	const float length = std::sqrt(dhdx * dhdx + 1.0f + dhdz * dhdz);
+	const float normal[3] = { -dhdx / length, 1.0f / length, -dhdz / length };
+
+	size_t wrong = 0;
+	for (float u = 1.0f; u < TEST_SAMPLER_HEIGHT - 2; u += 0.37f)
+	{
+		for (float v = 1.0f; v < TEST_SAMPLER_WIDTH - 2; v += 0.41f)
+		{
+			const float x = layout.ZeroX + u * layout.Dx;
+			const float z = layout.ZeroZ - v * layout.Dz;
+			const float height = TerrainLayout::SampleHeight(100.0f + rowSlope * u + colSlope * v);
+
+			for (TERRAIN_FILTER filter : { TERRAIN_FILTER_BILINEAR, TERRAIN_FILTER_BICUBIC })
+			{
+				const TerrainSample sample = sampler.Sample(x, z, filter);
+				wrong += !Near(sample.Height, height);
+				wrong += !Near(sample.Normal.x, normal[0]);
+				wrong += !Near(sample.Normal.y, normal[1]);
+				wrong += !Near(sample.Normal.z, normal[2]);
+			}
+		}
+	}
+	CHECK(wrong == 0);
+
+	return failures;
+}
+
+// Positions outside take the height of the nearest border sample, on
+// every side and past the corners. The batch matches the scalar query
+// at every level, inside and outside.
+static int TestClamping()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_SAMPLER_WIDTH, TEST_SAMPLER_HEIGHT);
+	FillPattern(heightmap);
+
+	const TerrainHeightSampler sampler(heightmap);
+	const TerrainLayout& layout = sampler.GetLayout();
+	const uint32_t lastRow = TEST_SAMPLER_HEIGHT - 1;
+	const uint32_t lastCol = TEST_SAMPLER_WIDTH - 1;
+	const float far = 100.0f;
+
+	// Along the sides
+	CHECK(Near(sampler.GetHeight(layout.WorldX(0) - far, layout.WorldZ(7)), Height(0, 7)));
+	CHECK(Near(sampler.GetHeight(layout.WorldX(lastRow) + far, layout.WorldZ(7)), Height(lastRow, 7)));
+	CHECK(Near(sampler.GetHeight(layout.WorldX(4), layout.WorldZ(0) + far), Height(4, 0)));
+	CHECK(Near(sampler.GetHeight(layout.WorldX(4), layout.WorldZ(lastCol) - far), Height(4, lastCol)));
+
+	// Past the corners
+	CHECK(Near(sampler.GetHeight(layout.WorldX(0) - far, layout.WorldZ(0) + far), Height(0, 0)));
+	CHECK(Near(sampler.GetHeight(layout.WorldX(lastRow) + far, layout.WorldZ(lastCol) - far), Height(lastRow, lastCol)));
+	CHECK(Near(sampler.Sample(layout.WorldX(lastRow) + far, layout.WorldZ(0) + far, TERRAIN_FILTER_BICUBIC).Height,
+		Height(lastRow, 0)));
+
+	// Outside, the surface continues the border sample's
+	const TerrainSample outside = sampler.Sample(layout.WorldX(0) - far, layout.WorldZ(0) + far);
+	const TerrainSample corner = sampler.Sample(layout.ZeroX, layout.ZeroZ);
+	CHECK(outside.Height == corner.Height);
+	CHECK(outside.Normal.x == corner.Normal.x && outside.Normal.y == corner.Normal.y &&
+		outside.Normal.z == corner.Normal.z);
+
+	CHECK(sampler.Contains(layout.WorldX(0), layout.WorldZ(0)));
+	CHECK(sampler.Contains(layout.WorldX(lastRow) - 0.01f, layout.WorldZ(lastCol) + 0.01f));
+	CHECK(!sampler.Contains(layout.WorldX(0) - 0.01f, layout.WorldZ(3)));
+	CHECK(!sampler.Contains(layout.WorldX(3), layout.WorldZ(lastCol) - 0.01f));
+
+	// Positions spread over the map and a band around it
+	std::vector<float> x(TEST_SAMPLER_BATCH), z(TEST_SAMPLER_BATCH);
+	uint32_t state = 5;
+	for (uint32_t i = 0; i < TEST_SAMPLER_BATCH; i++)
+	{
+		state = state * 1664525u + 1013904223u;
+		x[i] = layout.ZeroX + ((state >> 8) / 16777216.0f * 1.4f - 0.2f) * lastRow * layout.Dx;
+		state = state * 1664525u + 1013904223u;
+		z[i] = layout.ZeroZ - ((state >> 8) / 16777216.0f * 1.4f - 0.2f) * lastCol * layout.Dz;
+	}
+
+	std::vector<float> heights(TEST_SAMPLER_BATCH), nx(TEST_SAMPLER_BATCH), ny(TEST_SAMPLER_BATCH), nz(TEST_SAMPLER_BATCH);
+	for (int level = SIMD_LEVEL_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		sampler.SampleBatch(x.data(), z.data(), TEST_SAMPLER_BATCH, heights.data(), nx.data(), ny.data(), nz.data(),
+			(SIMD_LEVEL)level);
+
+		size_t mismatches = 0;
+		for (uint32_t i = 0; i < TEST_SAMPLER_BATCH; i++)
+		{
+			const TerrainSample sample = sampler.Sample(x[i], z[i]);
+			mismatches += heights[i] != sample.Height || nx[i] != sample.Normal.x ||
+				ny[i] != sample.Normal.y || nz[i] != sample.Normal.z;
+		}
+		CHECK(mismatches == 0);
+	}
+
+	return failures;
+}
+
+// Edited samples are seen only after Refresh, and only inside its rect
+static int TestRefresh()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_SAMPLER_WIDTH, TEST_SAMPLER_HEIGHT);
+	FillPattern(heightmap);
+
+	TerrainHeightSampler sampler(heightmap);
+	const TerrainLayout& layout = sampler.GetLayout();
+
+	TerrainDirtyRect rect;
+	rect.FirstRow = 3;
+	rect.EndRow = 6;
+	rect.FirstCol = 10;
+	rect.EndCol = 14;
+
+	// The rect and one sample outside it
+	for (uint32_t row = rect.FirstRow; row < rect.EndRow; row++)
+	{
+		memset(heightmap.GetWritableRow(row) + rect.FirstCol, 250, rect.EndCol - rect.FirstCol);
+	}
+	heightmap.GetWritableRow(8)[2] = 250;
+
+	const float edited = TerrainLayout::SampleHeight(250.0f);
+	CHECK(Near(sampler.GetHeight(layout.WorldX(4), layout.WorldZ(12)), Height(4, 12)));
+
+	sampler.Refresh(heightmap, rect);
+	size_t wrong = 0;
+	for (uint32_t row = 0; row < TEST_SAMPLER_HEIGHT; row++)
+	{
+		for (uint32_t col = 0; col < TEST_SAMPLER_WIDTH; col++)
+		{
+			const bool inside = row >= rect.FirstRow && row < rect.EndRow && col >= rect.FirstCol && col < rect.EndCol;
+			wrong += !Near(sampler.GetHeight(layout.WorldX(row), layout.WorldZ(col)), inside ? edited : Height(row, col));
+		}
+	}
+	CHECK(wrong == 0);
+
+	// Between edited and unchanged samples the blend uses both
+	const float x = layout.WorldX(5) + 0.5f * layout.Dx;
+	CHECK(Near(sampler.GetHeight(x, layout.WorldZ(12)), 0.5f * (edited + Height(6, 12))));
+
+	// A rect past the map is clipped, the sample outside is read now
+	TerrainDirtyRect all;
+	all.EndRow = TEST_SAMPLER_HEIGHT + 10;
+	all.EndCol = TEST_SAMPLER_WIDTH + 10;
+	sampler.Refresh(heightmap, all);
+	CHECK(Near(sampler.GetHeight(layout.WorldX(8), layout.WorldZ(2)), edited));
+
+	return failures;
+}
+
+int TestTerrainSampler()
+{
+	int failures = 0;
+	failures += TestBilinear();
+	failures += TestPlane();
+	failures += TestClamping();
+	failures += TestRefresh();
+	return failures != 0;
+}
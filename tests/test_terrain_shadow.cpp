@@ -0,0 +1,208 @@
+/*****************************************************************//**
+ * \file   test_terrain_shadow.cpp
+ * \brief  Sun shadow mask of a ridge against its known horizons, and
+ *         incremental updates against fresh bakes
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_mesh.h"
+#include "terrain_shadow.h"
+#include "test_util.h"
+#include "tests.h"
+#include "thread_pool.h"
+
+#define TEST_SHADOW_WIDTH 48
+#define TEST_SHADOW_HEIGHT 64
+
+// Rows [FIRST, END) hold a wall across the whole map, the rest is flat
+#define TEST_SHADOW_RIDGE_FIRST 40
+#define TEST_SHADOW_RIDGE_END 43
+
+// Samples in front of the ridge towards +X, and behind it
+#define TEST_SHADOW_FRONT_ROW 30
+#define TEST_SHADOW_BEHIND_ROW 50
+
+#define TEST_SHADOW_THREADS 4
+
+static void FillRidge(HeightmapImage& heightmap)
+{
+	for (uint32_t row = 0; row < heightmap.GetHeight(); row++)
+	{
+		const bool ridge = row >= TEST_SHADOW_RIDGE_FIRST && row < TEST_SHADOW_RIDGE_END;
+		memset(heightmap.GetWritableRow(row), ridge ? 255 : 0, heightmap.GetWidth());
+	}
+}
+
+// Elevation of the ridge top seen from a flat sample rows away from its
+// nearest ridge row
+static float RidgeElevation(uint32_t rows)
+{
+	const TerrainLayout layout(TEST_SHADOW_WIDTH, TEST_SHADOW_HEIGHT);
+	const float rise = TerrainLayout::SampleHeight(255.0f) - TerrainLayout::SampleHeight(0.0f);
+	return std::atan(rise / (rows * layout.Dx));
+}
+
+static uint8_t MaskAt(const TerrainShadowBaker& shadows, uint32_t row, uint32_t col)
+{
+	return shadows.GetMask()[(size_t)row * shadows.GetWidth() + col];
+}
+
+// Number of samples of the row with the given mask value
+static uint32_t CountInRow(const TerrainShadowBaker& shadows, uint32_t row, uint8_t value)
+{
+	uint32_t count = 0;
+	for (uint32_t col = 0; col < shadows.GetWidth(); col++) count += MaskAt(shadows, row, col) == value;
+	return count;
+}
+
+// A sample facing the ridge is shadowed below its elevation, half lit at
+// it and lit above it. A sample with the ridge behind it is lit.
+// Sunlight along the ridge meets no horizon.
+static int TestRidge()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_SHADOW_WIDTH, TEST_SHADOW_HEIGHT);
+	FillRidge(heightmap);
+
+	TerrainShadowBaker shadows(heightmap);
+	const TerrainShadowSettings settings;
+	const uint32_t col = TEST_SHADOW_WIDTH / 2;
+
+	// Sun towards +X, the front sample faces the ridge
+	const float front = RidgeElevation(TEST_SHADOW_RIDGE_FIRST - TEST_SHADOW_FRONT_ROW);
+	shadows.SetSun(0.0f, 0.5f * front, nullptr);
+	CHECK(CountInRow(shadows, TEST_SHADOW_FRONT_ROW, 0) == TEST_SHADOW_WIDTH);
+	CHECK(CountInRow(shadows, TEST_SHADOW_BEHIND_ROW, 255) == TEST_SHADOW_WIDTH);
+
+	shadows.SetSun(0.0f, front, nullptr);
+	CHECK(std::abs(MaskAt(shadows, TEST_SHADOW_FRONT_ROW, col) - 128) <= 2);
+
+	shadows.SetSun(0.0f, front - 2.0f * settings.SunRadius, nullptr);
+	CHECK(MaskAt(shadows, TEST_SHADOW_FRONT_ROW, col) == 0);
+
+	shadows.SetSun(0.0f, front + 2.0f * settings.SunRadius, nullptr);
+	CHECK(MaskAt(shadows, TEST_SHADOW_FRONT_ROW, col) == 255);
+
+	// Sun towards -X, now the sample behind faces the ridge
+	const float behind = RidgeElevation(TEST_SHADOW_BEHIND_ROW - (TEST_SHADOW_RIDGE_END - 1));
+	shadows.SetSun(DirectX::XM_PI, 0.5f * behind, nullptr);
+	CHECK(CountInRow(shadows, TEST_SHADOW_BEHIND_ROW, 0) == TEST_SHADOW_WIDTH);
+	CHECK(CountInRow(shadows, TEST_SHADOW_FRONT_ROW, 255) == TEST_SHADOW_WIDTH);
+
+	shadows.SetSun(DirectX::XM_PI, behind, nullptr);
+	CHECK(std::abs(MaskAt(shadows, TEST_SHADOW_BEHIND_ROW, col) - 128) <= 2);
+
+	// Sun along the ridge, towards -Z
+	shadows.SetSun(DirectX::XM_PIDIV2, 0.5f * front, nullptr);
+	size_t shadowed = 0;
+	for (uint32_t row = 0; row < TEST_SHADOW_HEIGHT; row++) shadowed += TEST_SHADOW_WIDTH - CountInRow(shadows, row, 255);
+	CHECK(shadowed == 0);
+
+	return failures;
+}
+
+// At elevation 0 the sun is cut in half by a flat horizon and hidden by
+// any higher one. Straight overhead every sample is lit.
+static int TestExtremeElevations()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_SHADOW_WIDTH, TEST_SHADOW_HEIGHT);
+	FillRidge(heightmap);
+
+	TerrainShadowBaker shadows(heightmap);
+	const uint32_t col = TEST_SHADOW_WIDTH / 2;
+
+	shadows.SetSun(0.0f, 0.0f, nullptr);
+	CHECK(MaskAt(shadows, TEST_SHADOW_FRONT_ROW, col) == 0);
+	CHECK(MaskAt(shadows, TEST_SHADOW_BEHIND_ROW, col) == 128);
+	CHECK(MaskAt(shadows, TEST_SHADOW_HEIGHT - 1, col) == 128);
+
+	size_t aboveHalf = 0;
+	for (uint32_t row = 0; row < TEST_SHADOW_HEIGHT; row++)
+	{
+		for (uint32_t c = 0; c < TEST_SHADOW_WIDTH; c++) aboveHalf += MaskAt(shadows, row, c) > 128;
+	}
+	CHECK(aboveHalf == 0);
+
+	const TerrainDirtyRect rect = shadows.SetSun(0.0f, DirectX::XM_PIDIV2, nullptr);
+	size_t lit = 0;
+	for (uint32_t row = 0; row < TEST_SHADOW_HEIGHT; row++) lit += CountInRow(shadows, row, 255);
+	CHECK(lit == (size_t)TEST_SHADOW_WIDTH * TEST_SHADOW_HEIGHT);
+
+	// Every row changed from at most half lit
+	CHECK(rect.FirstRow == 0 && rect.EndRow == TEST_SHADOW_HEIGHT);
+	CHECK(rect.FirstCol == 0 && rect.EndCol == TEST_SHADOW_WIDTH);
+
+	return failures;
+}
+
+// A sun moving in small steps is thresholded again only on some rows.
+// The mask after every step, and its dirty rows, match a fresh bake of
+// the same sun, serially and on the pool.
+static int TestIncremental()
+{
+	int failures = 0;
+	HeightmapImage heightmap(TEST_SHADOW_WIDTH, TEST_SHADOW_HEIGHT);
+	FillRidge(heightmap);
+
+	WorkerPool pool(TEST_SHADOW_THREADS);
+	TerrainShadowBaker moving(heightmap);
+	TerrainShadowBaker pooled(heightmap);
+
+	const float front = RidgeElevation(TEST_SHADOW_RIDGE_FIRST - TEST_SHADOW_FRONT_ROW);
+	std::vector<uint8_t> previous(moving.GetMask(), moving.GetMask() + TEST_SHADOW_WIDTH * TEST_SHADOW_HEIGHT);
+
+	for (int step = 0; step <= 8; step++)
+	{
+		const float elevation = front * (0.75f + 0.0625f * step);
+		const TerrainDirtyRect rect = moving.SetSun(0.0f, elevation, nullptr);
+		pooled.SetSun(0.0f, elevation, &pool);
+		if (step > 0)
+		{
+			CHECK(moving.GetUpdatedRows() > 0);
+			CHECK(moving.GetUpdatedRows() < TEST_SHADOW_HEIGHT);
+		}
+
+		TerrainShadowBaker fresh(heightmap);
+		fresh.SetSun(0.0f, elevation, nullptr);
+
+		const size_t count = (size_t)TEST_SHADOW_WIDTH * TEST_SHADOW_HEIGHT;
+		CHECK(memcmp(moving.GetMask(), fresh.GetMask(), count) == 0);
+		CHECK(memcmp(pooled.GetMask(), fresh.GetMask(), count) == 0);
+
+		// Changed rows are inside the rect
+		size_t outside = 0;
+		for (uint32_t row = 0; row < TEST_SHADOW_HEIGHT; row++)
+		{
+			if (row >= rect.FirstRow && row < rect.EndRow) continue;
+			outside += memcmp(&previous[(size_t)row * TEST_SHADOW_WIDTH], moving.GetMask() + (size_t)row * TEST_SHADOW_WIDTH,
+				TEST_SHADOW_WIDTH) != 0;
+		}
+		CHECK(outside == 0);
+		previous.assign(moving.GetMask(), moving.GetMask() + count);
+	}
+
+	// The same sun again changes nothing
+	const TerrainDirtyRect same = moving.SetSun(0.0f, front * 1.25f, nullptr);
+	CHECK(same.Empty());
+	CHECK(moving.GetUpdatedRows() == 0);
+
+	return failures;
+}
+
+int TestTerrainShadow()
+{
+	int failures = 0;
+	failures += TestRidge();
+	failures += TestExtremeElevations();
+	failures += TestIncremental();
+	return failures != 0;
+}
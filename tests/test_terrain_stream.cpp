@@ -0,0 +1,361 @@
+/*****************************************************************//**
+ * \file   test_terrain_stream.cpp
+ * \brief  Tile cache, chunk streaming and GPU slots of streamed chunks
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_mesh.h"
+#include "terrain_sampler.h"
+#include "terrain_stream.h"
+#include "test_util.h"
+#include "tests.h"
+
+using namespace DirectX;
+
+#define TEST_STREAM_FILE "test_terrain_stream.bmp"
+
+static void PutLE(std::vector<uint8_t>& data, size_t offset, uint32_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++) data[offset + i] = (uint8_t)(value >> (8 * i));
+}
+
+/**
+ * Writes a top-down 8-bit BMP whose palette is not the identity: entry i
+ * is a color, so samples only make sense through the palette. Rows are
+ * given bottom to top, like HeightmapImage stores them.
+ */
+static int WritePaletteBmp(const char* filename, UINT width, UINT height,
+	const std::vector<uint8_t>& samples)
+{
+	const uint32_t pitch = (width + 3) / 4 * 4;
+	const uint32_t pixelOffset = 14 + 40 + 256 * 4;
+	std::vector<uint8_t> data(pixelOffset + (size_t)pitch * height, 0);
+
+	data[0] = 'B';
+	data[1] = 'M';
+	PutLE(data, 2, (uint32_t)data.size(), 4);
+	PutLE(data, 10, pixelOffset, 4);
+	PutLE(data, 14, 40, 4);
+	PutLE(data, 18, width, 4);
+	PutLE(data, 22, (uint32_t)-(int32_t)height, 4);
+	PutLE(data, 26, 1, 2);
+	PutLE(data, 28, 8, 2);
+
+	// Reversed levels with a color tint, BGRA
+	for (uint32_t i = 0; i < 256; i++)
+	{
+		data[54 + 4 * i + 0] = (uint8_t)(255 - i);
+		data[54 + 4 * i + 1] = (uint8_t)((255 - i) / 2);
+		data[54 + 4 * i + 2] = (uint8_t)i;
+	}
+
+	for (UINT row = 0; row < height; row++)
+	{
+		memcpy(&data[pixelOffset + (size_t)(height - 1 - row) * pitch],
+			&samples[(size_t)row * width], width);
+	}
+
+	FILE* file = fopen(filename, "wb");
+	if (!file) return -1;
+	size_t written = fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+	return written == data.size() ? 0 : -1;
+}
+
+// Every sample of the cache matches the heightmap read by read_bmp
+static int CompareSamples(HeightmapTileCache& cache, HeightmapImage& heightmap)
+{
+	int failures = 0;
+
+	const UINT width = cache.GetWidth();
+	const UINT height = cache.GetHeight();
+	CHECK(width == heightmap.GetWidth() && height == heightmap.GetHeight());
+	if (failures) return failures;
+
+	std::vector<uint8_t> window((size_t)width * height);
+	cache.ReadWindow(0, 0, height, width, window.data(), width);
+
+	int mismatches = 0;
+	for (UINT row = 0; row < height; row++)
+	{
+		for (UINT col = 0; col < width; col++)
+		{
+			mismatches += window[(size_t)row * width + col] != heightmap.GetPixel(row, col);
+		}
+	}
+	CHECK(mismatches == 0);
+
+	return failures;
+}
+
+// Test heightmap, spans several tiles and chunks in both directions
+#define TEST_STREAM_WIDTH 301
+#define TEST_STREAM_HEIGHT 275
+
+static int WriteTestHeightmap()
+{
+	std::vector<uint8_t> samples((size_t)TEST_STREAM_WIDTH * TEST_STREAM_HEIGHT);
+	for (UINT row = 0; row < TEST_STREAM_HEIGHT; row++)
+	{
+		for (UINT col = 0; col < TEST_STREAM_WIDTH; col++)
+		{
+			samples[(size_t)row * TEST_STREAM_WIDTH + col] =
+				(uint8_t)(128.0f + 100.0f * sinf(row * 0.05f) * cosf(col * 0.03f));
+		}
+	}
+
+	return WritePaletteBmp(TEST_STREAM_FILE, TEST_STREAM_WIDTH, TEST_STREAM_HEIGHT, samples);
+}
+
+static int TestPaletteStream()
+{
+	int failures = 0;
+
+	HeightmapImage heightmap(TEST_STREAM_FILE);
+	HeightmapTileCache cache(8);
+	CHECK(cache.Open(TEST_STREAM_FILE) == 0);
+	if (failures) return failures;
+
+	failures += CompareSamples(cache, heightmap);
+
+	// Streamed chunks match the chunks built from memory
+	TerrainStreamSettings settings;
+	settings.LoadRadius = 1e6f;
+	settings.EvictRadius = 2e6f;
+	TerrainStreamer streamer(cache, settings);
+	const TerrainLayout& layout = streamer.GetLayout();
+
+	streamer.Update(XMFLOAT3(0.0f, 0.0f, 0.0f));
+	streamer.WaitIdle();
+
+	std::vector<std::unique_ptr<TerrainStreamChunk>> chunks;
+	streamer.TakeReadyChunks(chunks);
+	CHECK(chunks.size() == (size_t)layout.ChunkRows() * layout.ChunkColumns());
+
+	int mismatches = 0;
+	for (const std::unique_ptr<TerrainStreamChunk>& chunk : chunks)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint16_t> indices;
+		BuildTerrainChunk(heightmap, layout, chunk->ChunkCol, chunk->ChunkRow, vertices, indices);
+
+		CHECK(chunk->Vertices.size() == vertices.size());
+		CHECK(chunk->Indices == indices);
+		if (chunk->Vertices.size() != vertices.size()) continue;
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const Vertex& a = chunk->Vertices[i];
+			const Vertex& b = vertices[i];
+			mismatches += a.Pos.x != b.Pos.x || a.Pos.y != b.Pos.y || a.Pos.z != b.Pos.z ||
+				a.Normal.x != b.Normal.x || a.Normal.y != b.Normal.y || a.Normal.z != b.Normal.z;
+		}
+	}
+	CHECK(mismatches == 0);
+
+	return failures;
+}
+
+// Heights read from the tiles are the heights of the sampler over the
+// whole heightmap, inside the map, across tile borders and outside it
+static int TestStreamGround()
+{
+	int failures = 0;
+
+	HeightmapImage heightmap(TEST_STREAM_FILE);
+	HeightmapTileCache cache(2);
+	CHECK(cache.Open(TEST_STREAM_FILE) == 0);
+	if (failures) return failures;
+
+	TerrainHeightSampler sampler(heightmap);
+	TerrainStreamGround ground(cache);
+	const TerrainLayout& layout = ground.GetLayout();
+	CHECK(layout.Width == sampler.GetLayout().Width && layout.Depth == sampler.GetLayout().Depth);
+	CHECK(layout.ZeroX == sampler.GetLayout().ZeroX && layout.ZeroZ == sampler.GetLayout().ZeroZ);
+
+	// A step that is not a multiple of the sample spacing, from beyond
+	// one border to beyond the other
+	const float minX = layout.WorldX(0) - 20.0f;
+	const float maxX = layout.WorldX(layout.Depth - 1) + 20.0f;
+	const float minZ = layout.WorldZ(layout.Width - 1) - 20.0f;
+	const float maxZ = layout.WorldZ(0) + 20.0f;
+
+	int mismatches = 0;
+	int positions = 0;
+	for (float x = minX; x <= maxX; x += 1.37f)
+	{
+		for (float z = minZ; z <= maxZ; z += 2.11f)
+		{
+			mismatches += ground.GetHeight(x, z) != sampler.GetHeight(x, z);
+			positions++;
+		}
+	}
+	CHECK(positions > 10000);
+	CHECK(mismatches == 0);
+
+	// Exactly at samples, including the last row and column
+	for (UINT row = 0; row < layout.Depth; row += layout.Depth - 1)
+	{
+		for (UINT col = 0; col < layout.Width; col += 7)
+		{
+			const float x = layout.WorldX(row);
+			const float z = layout.WorldZ(col);
+			CHECK(ground.GetHeight(x, z) == sampler.GetHeight(x, z));
+		}
+	}
+
+	// The map has four tiles, queries replace the two held as they go
+	CHECK(cache.GetTileLoads() > cache.GetTileCapacity());
+
+	return failures;
+}
+
+// Slots are shared by the chunks in range and freed by evictions
+static int TestStreamSlots()
+{
+	int failures = 0;
+
+	HeightmapTileCache cache(8);
+	CHECK(cache.Open(TEST_STREAM_FILE) == 0);
+	if (failures) return failures;
+
+	TerrainStreamSettings settings;
+	settings.LoadRadius = 1e6f;
+	settings.EvictRadius = 2e6f;
+
+	const UINT slotCount = 4;
+	TerrainStreamSlots slots(cache, slotCount, settings);
+	const TerrainLayout& layout = slots.GetStreamer().GetLayout();
+	const size_t chunkCount = (size_t)layout.ChunkRows() * layout.ChunkColumns();
+	CHECK(chunkCount > slotCount);
+
+	const XMFLOAT3 eye(0.0f, 0.0f, 0.0f);
+	slots.Update(eye);
+	slots.GetStreamer().WaitIdle();
+	slots.Update(eye);
+	CHECK(slots.GetWaitingChunkCount() == chunkCount);
+
+	// Only as many chunks as there are slots are uploaded
+	std::vector<uint8_t> staging((size_t)TERRAIN_STREAM_UPLOADS_PER_FRAME * TERRAIN_STREAM_SLOT_BYTES);
+	std::vector<TerrainStreamCopy> copies;
+	UINT uploaded = 0;
+	std::vector<int> slotUses(slotCount, 0);
+
+	for (int frame = 0; frame < 4; frame++)
+	{
+		UINT staged = slots.PrepareUpload(staging.data(), TERRAIN_STREAM_UPLOADS_PER_FRAME, copies);
+		CHECK(staged == copies.size());
+		CHECK(staged <= TERRAIN_STREAM_UPLOADS_PER_FRAME);
+
+		for (size_t i = 0; i < copies.size(); i++)
+		{
+			const TerrainStreamCopy& copy = copies[i];
+			CHECK(copy.Slot < slotCount);
+			CHECK(copy.StagingOffset == i * TERRAIN_STREAM_SLOT_BYTES);
+			CHECK(copy.VertexCount > 0 && copy.VertexCount <= TERRAIN_STREAM_SLOT_VERTICES);
+			CHECK(copy.IndexCount > 0 && copy.IndexCount <= TERRAIN_STREAM_SLOT_INDICES);
+
+			// Indices are relative to the first vertex of the chunk
+			const uint16_t* pIndices = reinterpret_cast<const uint16_t*>(
+				staging.data() + copy.StagingOffset + (size_t)copy.VertexCount * sizeof(Vertex));
+			uint16_t maxIndex = *std::max_element(pIndices, pIndices + copy.IndexCount);
+			CHECK(maxIndex < copy.VertexCount);
+
+			if (copy.Slot < slotCount) slotUses[copy.Slot]++;
+		}
+		uploaded += staged;
+	}
+
+	CHECK(uploaded == slotCount);
+	CHECK(slots.GetUsedSlotCount() == slotCount);
+	CHECK(slots.GetWaitingChunkCount() == chunkCount - slotCount);
+	for (int uses : slotUses) CHECK(uses == 1);
+
+	// Planes (0, 0, 0, 1) keep everything, a plane behind the terrain culls it
+	Frustum all;
+	for (XMFLOAT4& plane : all.Planes) plane = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	std::vector<SubmeshGeometry> visible;
+	slots.GetVisible(all, visible);
+	CHECK(visible.size() == slotCount);
+	for (const SubmeshGeometry& submesh : visible)
+	{
+		const UINT slot = submesh.StartIndexLocation / TERRAIN_STREAM_SLOT_INDICES;
+		CHECK(submesh.StartIndexLocation == slot * TERRAIN_STREAM_SLOT_INDICES);
+		CHECK(submesh.BaseVertexLocation == (INT)(slot * TERRAIN_STREAM_SLOT_VERTICES));
+		CHECK(submesh.Bounds.Min.x <= submesh.Bounds.Max.x);
+	}
+
+	Frustum none = all;
+	none.Planes[0] = XMFLOAT4(1.0f, 0.0f, 0.0f, -1e5f);
+	slots.GetVisible(none, visible);
+	CHECK(visible.empty());
+
+	// Far from the terrain everything is evicted, slots and waiting
+	// meshes alike
+	slots.Update(XMFLOAT3(1e7f, 0.0f, 1e7f));
+	CHECK(slots.GetUsedSlotCount() == 0);
+	CHECK(slots.GetWaitingChunkCount() == 0);
+	slots.GetVisible(all, visible);
+	CHECK(visible.empty());
+
+	// Freed slots are taken again
+	slots.Update(eye);
+	slots.GetStreamer().WaitIdle();
+	slots.Update(eye);
+	CHECK(slots.PrepareUpload(staging.data(), TERRAIN_STREAM_UPLOADS_PER_FRAME, copies) ==
+		(std::min)((UINT)TERRAIN_STREAM_UPLOADS_PER_FRAME, slotCount));
+
+	return failures;
+}
+
+// The shipped heightmap has a palette of 253 gray entries that are not
+// the identity, so it used to be rejected
+static int TestShippedHeightmap()
+{
+	int failures = 0;
+
+	const char* candidates[] = { "Textures/heightmap.bmp", "../Textures/heightmap.bmp" };
+	for (const char* filename : candidates)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (!file) continue;
+		fclose(file);
+
+		HeightmapTileCache cache(4);
+		CHECK(cache.Open(filename) == 0);
+		if (failures) return failures;
+
+		HeightmapImage heightmap(filename);
+		return CompareSamples(cache, heightmap);
+	}
+
+	printf("Textures/heightmap.bmp not found, run from the repository or tests directory\n");
+	return 0;
+}
+
+int TestTerrainStream()
+{
+	int failures = 0;
+
+	CHECK(WriteTestHeightmap() == 0);
+	if (failures == 0)
+	{
+		failures += TestPaletteStream();
+		failures += TestStreamGround();
+		failures += TestStreamSlots();
+	}
+	remove(TEST_STREAM_FILE);
+
+	failures += TestShippedHeightmap();
+	return failures != 0;
+}
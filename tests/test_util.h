@@ -0,0 +1,20 @@
+/*****************************************************************//**
+ * \file   test_util.h
+ * \brief  Checks shared by the headless tests
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <cstdio>
+
+// Reports a failed condition and counts it in the int named failures
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) \
+		{ \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
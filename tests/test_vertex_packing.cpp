@@ -0,0 +1,189 @@
+/*****************************************************************//**
+ * \file   test_vertex_packing.cpp
+ * \brief  Error bounds of the PackedVertex encoding
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "image_helper.h"
+#include "terrain_mesh.h"
+#include "test_util.h"
+#include "tests.h"
+#include "vertex_packing.h"
+
+using namespace DirectX;
+
+#define TEST_PACKING_VERTICES 20000
+
+// Bounds documented at PackVertex
+#define PACKING_NORMAL_DEGREES 0.0025f
+#define PACKING_POSITION_STEPS 131070.0f
+#define PACKING_TEXC_STEPS 2048.0f
+
+// Position bound of one axis, with room for the float rounding of
+// Offset + Scale * unorm at the magnitude of the decoded value
+static float PositionBound(float scale, float offset)
+{
+	return scale / PACKING_POSITION_STEPS + 4.0f * FLT_EPSILON * (std::fabs(offset) + scale);
+}
+
+static float NormalBound()
+{
+	return PACKING_NORMAL_DEGREES * 3.14159265f / 180.0f;
+}
+
+// Every vertex is within the bounds, measured one by one
+static int CheckBounds(const std::vector<Vertex>& vertices, const VertexQuantization& quantization)
+{
+	int failures = 0;
+
+	std::vector<PackedVertex> packed(vertices.size());
+	PackVertices(vertices.data(), vertices.size(), quantization, packed.data());
+
+	const XMFLOAT3& scale = quantization.Scale;
+	const XMFLOAT3& offset = quantization.Offset;
+
+	int outside = 0;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		VertexPackingError error = MeasurePackingError(&vertices[i], &packed[i], 1, quantization);
+
+		const XMFLOAT2& texC = vertices[i].TexC;
+		const float texBound = (std::max)(std::fabs(texC.x), std::fabs(texC.y)) / PACKING_TEXC_STEPS +
+			FLT_MIN;
+
+		outside += error.Position.x > PositionBound(scale.x, offset.x) ||
+			error.Position.y > PositionBound(scale.y, offset.y) ||
+			error.Position.z > PositionBound(scale.z, offset.z) ||
+			error.NormalAngle > NormalBound() ||
+			error.TexC > texBound;
+	}
+	CHECK(outside == 0);
+
+	return failures;
+}
+
+// Random vertices within a box away from the origin
+static int TestRandomVertices()
+{
+	int failures = 0;
+
+	std::mt19937 rng(8);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<Vertex> vertices(TEST_PACKING_VERTICES);
+	for (Vertex& vertex : vertices)
+	{
+		vertex.Pos = XMFLOAT3(300.0f + 250.0f * unit(rng), -20.0f + 8.0f * unit(rng), 40.0f * unit(rng));
+		vertex.Normal = XMFLOAT3(unit(rng), unit(rng), unit(rng));
+		vertex.TexC = XMFLOAT2(6.0f * unit(rng), 6.0f * unit(rng));
+	}
+
+	const VertexQuantization quantization = ComputeVertexQuantization(vertices.data(), vertices.size());
+	CHECK(quantization.Scale.x > 0.0f && quantization.Scale.y > 0.0f && quantization.Scale.z > 0.0f);
+
+	failures += CheckBounds(vertices, quantization);
+	return failures;
+}
+
+// Poles, axes and the fold edges of the octahedron, where rounding of
+// the two components interacts the most
+static int TestEdgeNormals()
+{
+	int failures = 0;
+
+	const XMFLOAT3 normals[] =
+	{
+		{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+		{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+		{ 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f },
+		{ 1.0f, 1.0f, -1e-4f }, { -1.0f, -1.0f, -1e-4f },
+		{ 1e-4f, 0.0f, -1.0f }, { -1e-4f, 1e-4f, -1.0f },
+		{ 0.3f, 0.7f, -0.01f }, { 0.577f, 0.577f, 0.577f }
+	};
+
+	std::vector<Vertex> vertices;
+	for (const XMFLOAT3& normal : normals)
+	{
+		Vertex vertex = { };
+		vertex.Normal = normal;
+		vertices.push_back(vertex);
+	}
+
+	// Flat in every axis, so the quantisation keeps unit scales
+	const VertexQuantization quantization = ComputeVertexQuantization(vertices.data(), vertices.size());
+	CHECK(quantization.Scale.x == 1.0f && quantization.Scale.y == 1.0f && quantization.Scale.z == 1.0f);
+
+	failures += CheckBounds(vertices, quantization);
+
+	// The decoded normals are unit length
+	for (const Vertex& vertex : vertices)
+	{
+		Vertex decoded = UnpackVertex(PackVertex(vertex, quantization), quantization);
+		const XMFLOAT3& n = decoded.Normal;
+		CHECK(std::fabs(n.x * n.x + n.y * n.y + n.z * n.z - 1.0f) < 1e-5f);
+	}
+
+	return failures;
+}
+
+/**
+ * Terrain chunks are packed with one quantisation whose Y range spans all
+ * sample heights, as StaticResources does so that edits stay in range.
+ * Vertices of an edited terrain are still within the bounds.
+ */
+static int TestTerrainMesh()
+{
+	int failures = 0;
+
+	const UINT width = 97;
+	const UINT depth = 83;
+	HeightmapImage heightmap(width, depth);
+	for (UINT row = 0; row < depth; row++)
+	{
+		uint8_t* pRow = heightmap.GetWritableRow(row);
+		for (UINT col = 0; col < width; col++)
+		{
+			pRow[col] = (uint8_t)(100.0f + 60.0f * sinf(row * 0.2f) * cosf(col * 0.15f));
+		}
+	}
+
+	const TerrainLayout layout(width, depth);
+	TerrainMeshData mesh;
+	BuildTerrainMesh(heightmap, layout, mesh, nullptr);
+	CHECK(!mesh.Vertices.empty());
+	if (failures) return failures;
+
+	VertexQuantization quantization = ComputeVertexQuantization(mesh.Vertices.data(), mesh.Vertices.size());
+	quantization.Offset.y = TerrainLayout::SampleHeight(0.0f);
+	quantization.Scale.y = TerrainLayout::SampleHeight(255.0f) - quantization.Offset.y;
+
+	failures += CheckBounds(mesh.Vertices, quantization);
+
+	// Lowest and highest samples after an edit
+	heightmap.GetWritableRow(10)[10] = 0;
+	heightmap.GetWritableRow(20)[20] = 255;
+	BuildTerrainMesh(heightmap, layout, mesh, nullptr);
+	failures += CheckBounds(mesh.Vertices, quantization);
+
+	// Packing halves the vertex buffer
+	CHECK(sizeof(PackedVertex) * 2 == sizeof(Vertex));
+
+	return failures;
+}
+
+int TestVertexPacking()
+{
+	int failures = 0;
+	failures += TestRandomVertices();
+	failures += TestEdgeNormals();
+	failures += TestTerrainMesh();
+	return failures != 0;
+}
@@ -0,0 +1,53 @@
+/*****************************************************************//**
+ * \file   tests.h
+ * \brief  Entry points of the headless tests, 0 - success, 1 - failure
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+// Terrain mesh cache files: hits, stale keys, truncated and corrupted files
+int TestGeometryCache();
+
+// Block decompression against hand-built blocks and golden images
+int TestImageBc();
+
+// Valid and malformed .bmp headers, pixels read in place and copied
+int TestImageBmp();
+
+// Color mode conversion at every SIMD level and on the pool
+int TestImageConvert();
+
+// Shipped .dds textures: formats, sizes, mips and subresource offsets
+int TestImageDds();
+
+// Band reader and writer, written and read back against whole .bmp files
+int TestImageStream();
+
+// Vertex cache analyser, and reordered terrain chunks against the originals
+int TestMeshOptimizer();
+
+// Hydraulic and thermal erosion, written back to BMP and raw files
+int TestTerrainErosion();
+
+// CDLOD patch layout and quadtree selection
+int TestTerrainLod();
+
+// RTIN error bounds and border handling
+int TestTerrainRtin();
+
+// Brushes and patched vertices against the regenerated terrain mesh
+int TestTerrainEdit();
+
+// Bilinear and bicubic heights, clamping at the edges and Refresh
+int TestTerrainSampler();
+
+// Sun shadow mask of a ridge and its incremental updates
+int TestTerrainShadow();
+
+// Tile cache and streamed chunks against the in-memory heightmap
+int TestTerrainStream();
+
+// Error bounds of packed vertices
+int TestVertexPacking();
@@ -0,0 +1,124 @@
+/*****************************************************************//**
+ * \file   thread_pool.cpp
+ * \brief  Definition of class WorkerPool
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include "thread_pool.h"
+
+/**
+ * Starts worker threads.
+ *
+ * \param threadCount total number of threads including the caller of
+ *        ParallelFor, 0 to use all hardware threads
+ */
+WorkerPool::WorkerPool(uint32_t threadCount)
+{
+	if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0) threadCount = 1;
+
+	for (uint32_t i = 1; i < threadCount; i++)
+	{
+		mWorkers.emplace_back(&WorkerPool::WorkerMain, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mExit = true;
+	}
+	mWakeCV.notify_all();
+
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+WorkerPool& WorkerPool::Default()
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+void WorkerPool::ParallelFor(uint32_t count, uint32_t grain,
+	const std::function<void(uint32_t, uint32_t)>& func)
+{
+	if (count == 0) return;
+
+	if (grain == 0)
+	{
+		grain = (count + GetThreadCount() - 1) / GetThreadCount();
+	}
+
+	// Nothing to share, run on the calling thread
+	if (mWorkers.empty() || grain >= count)
+	{
+		func(0, count);
+		return;
+	}
+
+	std::lock_guard<std::mutex> jobLock(mJobMutex);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mpFunc = &func;
+		mCount = count;
+		mGrain = grain;
+		mNextItem = 0;
+		mBusyWorkers = static_cast<uint32_t>(mWorkers.size());
+		mGeneration++;
+	}
+	mWakeCV.notify_all();
+
+	// Calling thread takes part in the job
+	RunItems();
+
+	// Wait until every worker is done with the job
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDoneCV.wait(lock, [this] { return mBusyWorkers == 0; });
+	mpFunc = nullptr;
+}
+
+void WorkerPool::WorkerMain()
+{
+	uint64_t lastGeneration = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWakeCV.wait(lock, [&] { return mExit || mGeneration != lastGeneration; });
+
+			if (mExit) return;
+			lastGeneration = mGeneration;
+		}
+
+		RunItems();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBusyWorkers--;
+		}
+		mDoneCV.notify_one();
+	}
+}
+
+// Claims and processes items of the current job until none are left
+void WorkerPool::RunItems()
+{
+	for (;;)
+	{
+		uint32_t item = mNextItem.fetch_add(1);
+		uint64_t begin = static_cast<uint64_t>(item) * mGrain;
+		if (begin >= mCount) return;
+
+		uint64_t end = begin + mGrain;
+		if (end > mCount) end = mCount;
+
+		(*mpFunc)(static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+	}
+}
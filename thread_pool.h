@@ -0,0 +1,69 @@
+/*****************************************************************//**
+ * \file   thread_pool.h
+ * \brief  Declares class WorkerPool
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads used for data-parallel loops.
+ *
+ * ParallelFor splits the range into work items of equal size which
+ * the workers and the calling thread claim in order. As long as the
+ * callback writes only to memory owned by its item, the result does
+ * not depend on the number of threads.
+ *
+ * ParallelFor blocks until the range is processed. Calls from different
+ * threads are serialized, calls from inside a callback are not allowed.
+ */
+class WorkerPool
+{
+public:
+	// threadCount includes the calling thread, 0 picks hardware concurrency
+	explicit WorkerPool(uint32_t threadCount = 0);
+	~WorkerPool();
+
+	WorkerPool(WorkerPool& other) = delete;
+	WorkerPool& operator=(WorkerPool& rhs) = delete;
+
+	// Calls func(begin, end) for consecutive items of [0, count).
+	// grain is the item size, 0 splits the range evenly between threads.
+	void ParallelFor(uint32_t count, uint32_t grain,
+		const std::function<void(uint32_t, uint32_t)>& func);
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(mWorkers.size()) + 1; }
+
+	// Pool shared by the application, created on first use
+	static WorkerPool& Default();
+
+private:
+	void WorkerMain();
+	void RunItems();
+
+	std::vector<std::thread> mWorkers;
+
+	std::mutex mJobMutex;					// Serializes ParallelFor calls
+	std::mutex mMutex;
+	std::condition_variable mWakeCV;		// Signals workers about a new job
+	std::condition_variable mDoneCV;		// Signals caller about finished workers
+
+	// Current job
+	const std::function<void(uint32_t, uint32_t)>* mpFunc = nullptr;
+	uint32_t mCount = 0;
+	uint32_t mGrain = 0;
+	std::atomic<uint32_t> mNextItem{ 0 };
+
+	uint64_t mGeneration = 0;				// Incremented for every job
+	uint32_t mBusyWorkers = 0;
+	bool mExit = false;
+};
@@ -0,0 +1,219 @@
+/*****************************************************************//**
+ * \file   vertex_packing.cpp
+ * \brief  Encoding of Vertex into the 16-byte PackedVertex format
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "vertex_packing.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+// Largest magnitude of a 16-bit snorm component
+#define SNORM16_MAX 32767
+
+static float SignNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+VertexQuantization ComputeVertexQuantization(const Vertex* pVertices, size_t count)
+{
+	VertexQuantization quantization;
+	if (count == 0) return quantization;
+
+	XMFLOAT3 lo = pVertices[0].Pos;
+	XMFLOAT3 hi = pVertices[0].Pos;
+
+	for (size_t i = 1; i < count; i++)
+	{
+		const XMFLOAT3& p = pVertices[i].Pos;
+		lo.x = (std::min)(lo.x, p.x); hi.x = (std::max)(hi.x, p.x);
+		lo.y = (std::min)(lo.y, p.y); hi.y = (std::max)(hi.y, p.y);
+		lo.z = (std::min)(lo.z, p.z); hi.z = (std::max)(hi.z, p.z);
+	}
+
+	// Flat axes keep a unit scale so that encoding never divides by zero
+	quantization.Offset = lo;
+	quantization.Scale.x = hi.x > lo.x ? hi.x - lo.x : 1.0f;
+	quantization.Scale.y = hi.y > lo.y ? hi.y - lo.y : 1.0f;
+	quantization.Scale.z = hi.z > lo.z ? hi.z - lo.z : 1.0f;
+
+	return quantization;
+}
+
+XMFLOAT2 EncodeOctahedral(const XMFLOAT3& normal)
+{
+	float norm = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (norm == 0.0f) return XMFLOAT2(0.0f, 0.0f);
+
+	// Project onto the octahedron, then fold the lower half over the diagonals
+	float x = normal.x / norm;
+	float y = normal.y / norm;
+
+	if (normal.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+		float foldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 DecodeOctahedral(const XMFLOAT2& encoded)
+{
+	XMFLOAT3 n(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+
+	// Unfold the lower half, matches OctDecode in main.hlsl
+	float t = (std::max)(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+	return n;
+}
+
+static XMSHORTN2 QuantizeNormal(const XMFLOAT3& vertexNormal)
+{
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&vertexNormal)));
+
+	XMFLOAT2 encoded = EncodeOctahedral(normal);
+
+	float baseX = std::floor(encoded.x * SNORM16_MAX);
+	float baseY = std::floor(encoded.y * SNORM16_MAX);
+
+	// Rounding each component separately is up to twice as far off as the
+	// best code, so try all four neighbours
+	XMSHORTN2 best(0, 0);
+	float bestDistance = FLT_MAX;
+
+	for (int i = 0; i < 4; i++)
+	{
+		float qx = (std::max)(-(float)SNORM16_MAX, (std::min)((float)SNORM16_MAX, baseX + (i & 1)));
+		float qy = (std::max)(-(float)SNORM16_MAX, (std::min)((float)SNORM16_MAX, baseY + (i >> 1)));
+
+		// Distance rather than dot product, which is too close to one to compare
+		XMFLOAT3 decoded = DecodeOctahedral(XMFLOAT2(qx / SNORM16_MAX, qy / SNORM16_MAX));
+		float dx = decoded.x - normal.x;
+		float dy = decoded.y - normal.y;
+		float dz = decoded.z - normal.z;
+		float distance = dx * dx + dy * dy + dz * dz;
+
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			best.x = (int16_t)qx;
+			best.y = (int16_t)qy;
+		}
+	}
+
+	return best;
+}
+
+PackedVertex PackVertex(const Vertex& vertex, const VertexQuantization& quantization)
+{
+	PackedVertex packed;
+
+	XMStoreUShortN4(&packed.Pos, XMVectorSet(
+		(vertex.Pos.x - quantization.Offset.x) / quantization.Scale.x,
+		(vertex.Pos.y - quantization.Offset.y) / quantization.Scale.y,
+		(vertex.Pos.z - quantization.Offset.z) / quantization.Scale.z,
+		0.0f));
+
+	packed.Normal = QuantizeNormal(vertex.Normal);
+	XMStoreHalf2(&packed.TexC, XMLoadFloat2(&vertex.TexC));
+
+	return packed;
+}
+
+Vertex UnpackVertex(const PackedVertex& packed, const VertexQuantization& quantization)
+{
+	Vertex vertex;
+
+	XMFLOAT4 unorm;
+	XMStoreFloat4(&unorm, XMLoadUShortN4(&packed.Pos));
+	vertex.Pos.x = quantization.Offset.x + quantization.Scale.x * unorm.x;
+	vertex.Pos.y = quantization.Offset.y + quantization.Scale.y * unorm.y;
+	vertex.Pos.z = quantization.Offset.z + quantization.Scale.z * unorm.z;
+
+	XMFLOAT2 encoded;
+	XMStoreFloat2(&encoded, XMLoadShortN2(&packed.Normal));
+	vertex.Normal = DecodeOctahedral(encoded);
+
+	XMStoreFloat2(&vertex.TexC, XMLoadHalf2(&packed.TexC));
+
+	return vertex;
+}
+
+void PackVertices(const Vertex* pVertices, size_t count,
+	const VertexQuantization& quantization, PackedVertex* pPacked)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		pPacked[i] = PackVertex(pVertices[i], quantization);
+	}
+}
+
+void UnpackVertices(const PackedVertex* pPacked, size_t count,
+	const VertexQuantization& quantization, Vertex* pVertices)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		pVertices[i] = UnpackVertex(pPacked[i], quantization);
+	}
+}
+
+VertexPackingError MeasurePackingError(const Vertex* pVertices, const PackedVertex* pPacked,
+	size_t count, const VertexQuantization& quantization)
+{
+	VertexPackingError error;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const Vertex& original = pVertices[i];
+		Vertex decoded = UnpackVertex(pPacked[i], quantization);
+
+		error.Position.x = (std::max)(error.Position.x, std::fabs(decoded.Pos.x - original.Pos.x));
+		error.Position.y = (std::max)(error.Position.y, std::fabs(decoded.Pos.y - original.Pos.y));
+		error.Position.z = (std::max)(error.Position.z, std::fabs(decoded.Pos.z - original.Pos.z));
+
+		// Measured against the normalised original, as the shader renormalises
+		XMFLOAT3 normal;
+		XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&original.Normal)));
+		const XMFLOAT3& d = decoded.Normal;
+
+		// acos of the dot product cannot resolve angles this small in float
+		float crossX = normal.y * d.z - normal.z * d.y;
+		float crossY = normal.z * d.x - normal.x * d.z;
+		float crossZ = normal.x * d.y - normal.y * d.x;
+		float sine = std::sqrt(crossX * crossX + crossY * crossY + crossZ * crossZ);
+		float angle = std::atan2(sine, normal.x * d.x + normal.y * d.y + normal.z * d.z);
+		error.NormalAngle = (std::max)(error.NormalAngle, angle);
+
+		error.TexC = (std::max)(error.TexC, std::fabs(decoded.TexC.x - original.TexC.x));
+		error.TexC = (std::max)(error.TexC, std::fabs(decoded.TexC.y - original.TexC.y));
+	}
+
+	return error;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetPackedVertexInputLayout()
+{
+	return
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0,
+		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8,
+		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12,
+		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
+	};
+}
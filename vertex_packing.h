@@ -0,0 +1,59 @@
+/*****************************************************************//**
+ * \file   vertex_packing.h
+ * \brief  Encoding of Vertex into the 16-byte PackedVertex format
+ *
+ * \author Mikalai Varapai
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+
+#include <vector>
+
+#include "structures.h"
+
+// Maps unorm positions back to the mesh space: Pos = Offset + Scale * unorm.
+// Uploaded in ObjectConstants::PosOffset and PosScale.
+struct VertexQuantization
+{
+	DirectX::XMFLOAT3 Offset = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
+};
+
+// Largest decode errors over a vertex array
+struct VertexPackingError
+{
+	DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };	// Absolute, per axis
+	float NormalAngle = 0.0f;							// Radians
+	float TexC = 0.0f;									// Absolute, per component
+};
+
+// Quantisation spanning the bounding box of the vertices
+VertexQuantization ComputeVertexQuantization(const Vertex* pVertices, size_t count);
+
+// Octahedral mapping of a unit vector to [-1, 1]^2 and back
+DirectX::XMFLOAT2 EncodeOctahedral(const DirectX::XMFLOAT3& normal);
+DirectX::XMFLOAT3 DecodeOctahedral(const DirectX::XMFLOAT2& encoded);
+
+/**
+ * Error bounds of a packed vertex:
+ *   position  Scale / 131070 per axis, half a 16-bit step of the bounds,
+ *             plus float rounding
+ *   normal    under 0.0025 degrees, the encoder picks the closest of the
+ *             four neighbouring 16-bit octahedral codes
+ *   texcoord  |TexC| / 2048, half precision. Large terrains should keep
+ *             texture coordinates small to stay within a texel.
+ */
+PackedVertex PackVertex(const Vertex& vertex, const VertexQuantization& quantization);
+Vertex UnpackVertex(const PackedVertex& packed, const VertexQuantization& quantization);
+
+void PackVertices(const Vertex* pVertices, size_t count,
+	const VertexQuantization& quantization, PackedVertex* pPacked);
+void UnpackVertices(const PackedVertex* pPacked, size_t count,
+	const VertexQuantization& quantization, Vertex* pVertices);
+
+// Compares the decoded packed vertices against the originals
+VertexPackingError MeasurePackingError(const Vertex* pVertices, const PackedVertex* pPacked,
+	size_t count, const VertexQuantization& quantization);
+
+// Input layout matching PackedVertex, for main.hlsl compiled with PACKED_VERTEX
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetPackedVertexInputLayout();